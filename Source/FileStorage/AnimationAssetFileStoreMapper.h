@@ -11,6 +11,7 @@
 #include "Animators/AnimationAssetStoreMapper.h"
 #include "Animators/AnimationAssetId.h"
 #include "Gateways/DtoGateway.h"
+#include "JournaledMapperIndex.h"
 #include <mutex>
 
 namespace Enigma::FileStorage
@@ -30,8 +31,11 @@ namespace Enigma::FileStorage
         virtual std::error_code putAnimationAsset(const Animators::AnimationAssetId& id, const Engine::GenericDto& dto) override;
 
     protected:
-        std::error_code serializeMapperFile();
-        void deserializeMapperFile(const std::string& mapper_file_content);
+        std::string serializeMapperFile();
+        std::string serializeMapperRecord(const Animators::AnimationAssetId& id, const std::string& filename);
+        void deserializeMapperRecord(const std::string& record, bool is_removed);
+        /** journal 太長時在 background 重寫 mapper file */
+        void compactMapperFileIfNeeded();
         std::string extractFilename(const Animators::AnimationAssetId& id, const Engine::FactoryDesc& factory_desc);
 
         std::error_code serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto);
@@ -40,7 +44,7 @@ namespace Enigma::FileStorage
     protected:
         bool m_has_connected;
         std::shared_ptr<Gateways::IDtoGateway> m_gateway;
-        std::string m_mapper_filename;
+        JournaledMapperIndex m_mapperIndex;
         std::unordered_map<Animators::AnimationAssetId, std::string, Animators::AnimationAssetId::hash> m_filename_map;
         mutable std::recursive_mutex m_file_map_lock;
     };
@@ -4,15 +4,16 @@
 #include "Animators/AnimatorErrors.h"
 #include "Frameworks/TokenVector.h"
 #include <cassert>
+#include <algorithm>
 
 using namespace Enigma::FileStorage;
 
-AnimatorFileStoreMapper::AnimatorFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
+AnimatorFileStoreMapper::AnimatorFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : m_mapperIndex(mapper_filename)
 {
-    m_mapper_filename = mapper_filename;
     m_gateway = gateway;
     m_has_connected = false;
     m_sequence_number = 0;
+    m_journaled_sequence_number = 0;
 }
 
 AnimatorFileStoreMapper::~AnimatorFileStoreMapper()
@@ -26,17 +27,10 @@ std::error_code AnimatorFileStoreMapper::connect()
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_file_map_lock };
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    m_sequence_number = 0;
+    auto er = m_mapperIndex.load([this](const std::string& record, bool is_removed) { deserializeMapperRecord(record, is_removed); });
+    if (er) return er;
+    m_journaled_sequence_number = m_sequence_number;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -44,9 +38,13 @@ std::error_code AnimatorFileStoreMapper::connect()
 std::error_code AnimatorFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_file_map_lock };
+    std::error_code er = FileSystem::ErrorCode::ok;
+    // 離線後 mapper file 本身就是完整的, 可以直接給其他工具讀
+    if (m_mapperIndex.journalRecordCount() > 0) er = m_mapperIndex.compact(serializeMapperFile());
+    m_mapperIndex.close();
     m_filename_map.clear();
     m_has_connected = false;
-    return FileSystem::ErrorCode::ok;
+    return er;
 }
 
 bool AnimatorFileStoreMapper::hasAnimator(const Animators::AnimatorId& id)
@@ -67,9 +65,15 @@ std::optional<Enigma::Engine::GenericDto> AnimatorFileStoreMapper::queryAnimator
 std::error_code AnimatorFileStoreMapper::removeAnimator(const Animators::AnimatorId& id)
 {
     std::lock_guard locker{ m_file_map_lock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Animators::ErrorCode::ok;
+    const auto record = serializeMapperRecord(id, it->second);
+    m_filename_map.erase(it);
+    auto er = journalSequenceNumber();
     if (er) return er;
+    er = m_mapperIndex.appendRemove(record);
+    if (er) return er;
+    compactMapperFileIfNeeded();
     return Animators::ErrorCode::ok;
 }
 
@@ -78,8 +82,11 @@ std::error_code AnimatorFileStoreMapper::putAnimator(const Animators::AnimatorId
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_file_map_lock };
     m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = journalSequenceNumber();
+    if (er) return er;
+    er = m_mapperIndex.appendPut(serializeMapperRecord(id, filename));
     if (er) return er;
+    compactMapperFileIfNeeded();
     er = serializeDataTransferObject(filename, dto);
     if (er) return er;
     return Animators::ErrorCode::ok;
@@ -91,37 +98,59 @@ std::uint64_t AnimatorFileStoreMapper::nextSequenceNumber()
     return ++m_sequence_number;
 }
 
-void AnimatorFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
+void AnimatorFileStoreMapper::deserializeMapperRecord(const std::string& record, bool is_removed)
 {
-    if (mapper_file_content.empty()) return;
     std::lock_guard locker{ m_file_map_lock };
-    auto lines = split_token(mapper_file_content, "\n\r");
-    m_sequence_number = std::stoul(lines[0]);
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() == 1)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 4) continue; // then, skip first line
-        Animators::AnimatorId id{ tokens[0], std::stoull(tokens[1]), Frameworks::Rtti::fromName(tokens[2]) };
-        m_filename_map.insert_or_assign(id, tokens[3]);
+        m_sequence_number = std::max(m_sequence_number, static_cast<std::uint64_t>(std::stoull(tokens[0])));
+        return;
     }
+    if (tokens.size() != 4) return;
+    Animators::AnimatorId id{ tokens[0], std::stoull(tokens[1]), Frameworks::Rtti::fromName(tokens[2]) };
+    if (is_removed)
+    {
+        m_filename_map.erase(id);
+        return;
+    }
+    m_filename_map.insert_or_assign(id, tokens.back());
 }
 
-std::error_code AnimatorFileStoreMapper::serializeMapperFile()
+std::string AnimatorFileStoreMapper::serializeMapperFile()
 {
     std::lock_guard locker{ m_file_map_lock };
     std::string mapper_file_content = std::to_string(m_sequence_number) + "\n";
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + std::to_string(rec.first.sequence()) + "," + rec.first.rtti().getName() + "," + rec.second + "\n";
+        mapper_file_content += serializeMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
+    return mapper_file_content;
+}
+
+std::string AnimatorFileStoreMapper::serializeMapperRecord(const Animators::AnimatorId& id, const std::string& filename)
+{
+    return id.name() + "," + std::to_string(id.sequence()) + "," + id.rtti().getName() + "," + filename;
+}
+
+std::error_code AnimatorFileStoreMapper::journalSequenceNumber()
+{
+    std::lock_guard locker{ m_file_map_lock };
+    if (m_sequence_number == m_journaled_sequence_number) return FileSystem::ErrorCode::ok;
+    // 只有一個欄位的 record 是 sequence number, 跟 mapper file 第一行相同
+    auto er = m_mapperIndex.appendPut(std::to_string(m_sequence_number));
+    if (er) return er;
+    m_journaled_sequence_number = m_sequence_number;
     return FileSystem::ErrorCode::ok;
 }
 
+void AnimatorFileStoreMapper::compactMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_file_map_lock };
+    if (!m_mapperIndex.isCompactionNeeded(m_filename_map.size())) return;
+    m_mapperIndex.compactAsync(serializeMapperFile());
+}
+
 std::string AnimatorFileStoreMapper::extractFilename(const Animators::AnimatorId& id, const Engine::FactoryDesc& factory_desc)
 {
     if (!factory_desc.GetDeferredFilename().empty()) return factory_desc.GetDeferredFilename();
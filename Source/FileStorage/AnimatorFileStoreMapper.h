@@ -10,6 +10,7 @@
 
 #include "GameEngine/GenericDto.h"
 #include "Gateways/DtoGateway.h"
+#include "JournaledMapperIndex.h"
 #include "Animators/AnimatorStoreMapper.h"
 #include "Animators/AnimatorId.h"
 #include <mutex>
@@ -36,8 +37,13 @@ namespace Enigma::FileStorage
         virtual std::uint64_t nextSequenceNumber() override;
 
     protected:
-        std::error_code serializeMapperFile();
-        void deserializeMapperFile(const std::string& mapper_file_content);
+        std::string serializeMapperFile();
+        std::string serializeMapperRecord(const Animators::AnimatorId& id, const std::string& filename);
+        void deserializeMapperRecord(const std::string& record, bool is_removed);
+        /** journal 太長時在 background 重寫 mapper file */
+        void compactMapperFileIfNeeded();
+        /** 發出去的 sequence number 比 journal 中記錄的新時, 先記一筆 */
+        std::error_code journalSequenceNumber();
         std::string extractFilename(const Animators::AnimatorId& id, const Engine::FactoryDesc& factory_desc);
 
         std::error_code serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto);
@@ -46,10 +52,11 @@ namespace Enigma::FileStorage
     protected:
         bool m_has_connected;
         std::shared_ptr<Gateways::IDtoGateway> m_gateway;
-        std::string m_mapper_filename;
+        JournaledMapperIndex m_mapperIndex;
         std::unordered_map<Animators::AnimatorId, std::string, Animators::AnimatorId::hash> m_filename_map;
         mutable std::recursive_mutex m_file_map_lock;
         std::uint64_t m_sequence_number;
+        std::uint64_t m_journaled_sequence_number;  ///< journal 中最後記錄的 sequence number
     };
 }
 
@@ -6,9 +6,8 @@
 
 using namespace Enigma::FileStorage;
 
-GeometryDataFileStoreMapper::GeometryDataFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Geometries::GeometryDataStoreMapper()
+GeometryDataFileStoreMapper::GeometryDataFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Geometries::GeometryDataStoreMapper(), m_mapperIndex(mapper_filename)
 {
-    m_mapper_filename = mapper_filename;
     m_gateway = gateway;
     m_has_connected = false;
 }
@@ -24,17 +23,8 @@ std::error_code GeometryDataFileStoreMapper::connect()
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    auto er = m_mapperIndex.load([this](const std::string& record, bool is_removed) { deserializeMapperRecord(record, is_removed); });
+    if (er) return er;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -42,9 +32,13 @@ std::error_code GeometryDataFileStoreMapper::connect()
 std::error_code GeometryDataFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_fileMapLock };
+    std::error_code er = FileSystem::ErrorCode::ok;
+    // 離線後 mapper file 本身就是完整的, 可以直接給其他工具讀
+    if (m_mapperIndex.journalRecordCount() > 0) er = m_mapperIndex.compact(serializeMapperFile());
+    m_mapperIndex.close();
     m_filename_map.clear();
     m_has_connected = false;
-    return FileSystem::ErrorCode::ok;
+    return er;
 }
 
 bool GeometryDataFileStoreMapper::hasGeometry(const Geometries::GeometryId& id)
@@ -65,9 +59,13 @@ std::optional<Enigma::Engine::GenericDto> GeometryDataFileStoreMapper::queryGeom
 std::error_code GeometryDataFileStoreMapper::removeGeometry(const Geometries::GeometryId& id)
 {
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Engine::ErrorCode::ok;
+    const auto record = serializeMapperRecord(id, it->second);
+    m_filename_map.erase(it);
+    auto er = m_mapperIndex.appendRemove(record);
     if (er) return er;
+    compactMapperFileIfNeeded();
     return Engine::ErrorCode::ok;
 }
 
@@ -76,41 +74,49 @@ std::error_code GeometryDataFileStoreMapper::putGeometry(const Geometries::Geome
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_fileMapLock };
     m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = m_mapperIndex.appendPut(serializeMapperRecord(id, filename));
     if (er) return er;
+    compactMapperFileIfNeeded();
     er = serializeDataTransferObject(filename, dto);
     if (er) return er;
     return Engine::ErrorCode::ok;
 }
 
-std::error_code GeometryDataFileStoreMapper::serializeMapperFile()
+std::string GeometryDataFileStoreMapper::serializeMapperFile()
 {
     std::lock_guard locker{ m_fileMapLock };
     std::string mapper_file_content;
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.second + "\n";
+        mapper_file_content += serializeMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
+}
+
+std::string GeometryDataFileStoreMapper::serializeMapperRecord(const Geometries::GeometryId& id, const std::string& filename)
+{
+    return id.name() + "," + filename;
+}
+
+void GeometryDataFileStoreMapper::compactMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_fileMapLock };
+    if (!m_mapperIndex.isCompactionNeeded(m_filename_map.size())) return;
+    m_mapperIndex.compactAsync(serializeMapperFile());
 }
 
-void GeometryDataFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
+void GeometryDataFileStoreMapper::deserializeMapperRecord(const std::string& record, bool is_removed)
 {
-    if (mapper_file_content.empty()) return;
     std::lock_guard locker{ m_fileMapLock };
-    auto lines = split_token(mapper_file_content, "\n\r");
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() != 2) return;
+    Geometries::GeometryId id{ tokens[0] };
+    if (is_removed)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        Geometries::GeometryId id{ tokens[0] };
-        m_filename_map.insert_or_assign(id, tokens[1]);
+        m_filename_map.erase(id);
+        return;
     }
+    m_filename_map.insert_or_assign(id, tokens.back());
 }
 
 std::string GeometryDataFileStoreMapper::extractFilename(const Geometries::GeometryId& id, const Engine::FactoryDesc& factory_desc)
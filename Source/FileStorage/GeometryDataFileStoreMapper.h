@@ -10,6 +10,7 @@
 
 #include "GameEngine/FactoryDesc.h"
 #include "Gateways/DtoGateway.h"
+#include "JournaledMapperIndex.h"
 #include "Geometries/GeometryDataStoreMapper.h"
 #include "Geometries/GeometryId.h"
 #include <mutex>
@@ -35,8 +36,11 @@ namespace Enigma::FileStorage
         virtual std::error_code putGeometry(const Geometries::GeometryId& id, const Engine::GenericDto& dto) override;
 
     protected:
-        std::error_code serializeMapperFile();
-        void deserializeMapperFile(const std::string& mapper_file_content);
+        std::string serializeMapperFile();
+        std::string serializeMapperRecord(const Geometries::GeometryId& id, const std::string& filename);
+        void deserializeMapperRecord(const std::string& record, bool is_removed);
+        /** journal 太長時在 background 重寫 mapper file */
+        void compactMapperFileIfNeeded();
         std::string extractFilename(const Geometries::GeometryId& id, const Engine::FactoryDesc& factory_desc);
 
         std::error_code serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto);
@@ -45,7 +49,7 @@ namespace Enigma::FileStorage
     protected:
         bool m_has_connected;
         std::shared_ptr<Gateways::IDtoGateway> m_gateway;
-        std::string m_mapper_filename;
+        JournaledMapperIndex m_mapperIndex;
         std::unordered_map<Geometries::GeometryId, std::string, Geometries::GeometryId::hash> m_filename_map;
         mutable std::recursive_mutex m_fileMapLock;
     };
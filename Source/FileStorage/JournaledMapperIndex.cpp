@@ -0,0 +1,293 @@
+﻿#include "JournaledMapperIndex.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/FileSystemErrors.h"
+#include "FileSystem/Filename.h"
+#include "Platforms/PlatformLayer.h"
+#include <filesystem>
+#include <chrono>
+
+using namespace Enigma::FileStorage;
+
+static const std::string JOURNAL_SUFFIX = ".journal";
+static const std::string COMPACTING_SUFFIX = ".compact";
+constexpr char PUT_RECORD_OP = '+';
+constexpr char REMOVE_RECORD_OP = '-';
+
+namespace
+{
+    /** "name.ext@path_id" -> "name.ext<suffix>@path_id" */
+    std::string siblingFilename(const std::string& filename, const std::string& suffix)
+    {
+        const auto at = filename.find('@');
+        if (at == std::string::npos) return filename + suffix;
+        return filename.substr(0, at) + suffix + filename.substr(at);
+    }
+
+    /** 沒有檔案時 content 為空, 不算錯誤 */
+    std::error_code readTextFile(const std::string& filename, std::string& content)
+    {
+        content.clear();
+        auto file = Enigma::FileSystem::FileSystem::instance()->openFile(filename, Enigma::FileSystem::read | Enigma::FileSystem::binary);
+        if (!file) return Enigma::FileSystem::ErrorCode::ok;
+        const auto file_size = file->size();
+        if (file_size == 0)
+        {
+            Enigma::FileSystem::FileSystem::instance()->closeFile(file);
+            return Enigma::FileSystem::ErrorCode::ok;
+        }
+        auto buff = file->read(0, file_size);
+        Enigma::FileSystem::FileSystem::instance()->closeFile(file);
+        if (!buff) return Enigma::FileSystem::ErrorCode::readFail;
+        content.assign(buff->begin(), buff->end());
+        return Enigma::FileSystem::ErrorCode::ok;
+    }
+
+    std::error_code writeTextFile(const std::string& filename, const std::string& content)
+    {
+        auto file = Enigma::FileSystem::FileSystem::instance()->openFile(filename, Enigma::FileSystem::write | Enigma::FileSystem::openAlways | Enigma::FileSystem::binary);
+        if (!file) return Enigma::FileSystem::ErrorCode::fileOpenError;
+        size_t write_size = 0;
+        if (!content.empty()) write_size = file->write(0, { content.begin(), content.end() });
+        Enigma::FileSystem::FileSystem::instance()->closeFile(file);
+        if (write_size != content.size()) return Enigma::FileSystem::ErrorCode::writeFail;
+        return Enigma::FileSystem::ErrorCode::ok;
+    }
+
+    /** 只有 stdio mount path 上的檔案可以 rename, 其他的回傳 false, 由呼叫端改成直接覆寫 */
+    bool replaceByRenaming(const std::string& compacting_filename, const std::string& suffix)
+    {
+        Enigma::FileSystem::Filename filename(compacting_filename);
+        const std::string from_path = Enigma::FileSystem::FileSystem::instance()->getStdioFullPath(filename.getSubPathFileName(), filename.getMountPathId());
+        if ((from_path.size() <= suffix.size()) || (from_path.compare(from_path.size() - suffix.size(), suffix.size(), suffix) != 0)) return false;
+        std::error_code er;
+        if (!std::filesystem::is_regular_file(from_path, er)) return false;
+        std::filesystem::rename(from_path, from_path.substr(0, from_path.size() - suffix.size()), er);
+        return !er;
+    }
+
+    /** 對每一個完整的行 (以 '\n' 結尾) 呼叫 fn, 回傳完整行的總長度 */
+    template <class Fn> size_t forEachLine(const std::string& content, Fn&& fn)
+    {
+        size_t start = 0;
+        while (start < content.size())
+        {
+            const size_t end = content.find('\n', start);
+            if (end == std::string::npos) break;
+            size_t length = end - start;
+            if ((length > 0) && (content[start + length - 1] == '\r')) length--;
+            if (length > 0) fn(content.substr(start, length));
+            start = end + 1;
+        }
+        return start;
+    }
+}
+
+JournaledMapperIndex::JournaledMapperIndex(const std::string& mapper_filename) : m_snapshotFilename(mapper_filename)
+{
+    m_journalFilename = siblingFilename(mapper_filename, JOURNAL_SUFFIX);
+    m_compactingFilename = siblingFilename(mapper_filename, COMPACTING_SUFFIX);
+    m_journalSize = 0;
+    m_journalRecordCount = 0;
+    m_compactionRecordCount = DefaultCompactionRecordCount;
+    m_isCompacting = false;
+    m_compactingTailRecordCount = 0;
+}
+
+JournaledMapperIndex::~JournaledMapperIndex()
+{
+    close();
+}
+
+std::error_code JournaledMapperIndex::load(const ReplayRecord& replay)
+{
+    waitForCompaction();
+    std::lock_guard locker{ m_journalLock };
+    if (m_journalFile)
+    {
+        FileSystem::FileSystem::instance()->closeFile(m_journalFile);
+        m_journalFile = nullptr;
+    }
+    m_journalSize = 0;
+    m_journalRecordCount = 0;
+
+    std::string content;
+    auto er = readTextFile(m_snapshotFilename, content);
+    if (er) return er;
+    // snapshot 的最後一行可能沒有換行 (手寫或舊工具產生的檔案)
+    if ((!content.empty()) && (content.back() != '\n')) content.push_back('\n');
+    forEachLine(content, [&](const std::string& record) { replay(record, false); });
+
+    er = readTextFile(m_journalFilename, content);
+    if (er) return er;
+    const size_t complete_size = forEachLine(content, [&](const std::string& line)
+        {
+            if (line[0] == PUT_RECORD_OP)
+            {
+                replay(line.substr(1), false);
+            }
+            else if (line[0] == REMOVE_RECORD_OP)
+            {
+                replay(line.substr(1), true);
+            }
+            else
+            {
+                return;
+            }
+            m_journalRecordCount++;
+        });
+    m_journalSize = complete_size;
+    if (complete_size != content.size())
+    {
+        // 上次寫到一半的記錄, 截掉, 不然之後 append 的記錄會接在殘留的 bytes 後面
+        Platforms::Debug::ErrorPrintf("mapper journal %s has incomplete record, truncated\n", m_journalFilename.c_str());
+        content.resize(complete_size);
+        return rewriteJournal(content);
+    }
+    return FileSystem::ErrorCode::ok;
+}
+
+void JournaledMapperIndex::close()
+{
+    waitForCompaction();
+    std::lock_guard locker{ m_journalLock };
+    if (!m_journalFile) return;
+    FileSystem::FileSystem::instance()->closeFile(m_journalFile);
+    m_journalFile = nullptr;
+}
+
+std::error_code JournaledMapperIndex::appendPut(const std::string& record)
+{
+    return appendRecord(PUT_RECORD_OP, record);
+}
+
+std::error_code JournaledMapperIndex::appendRemove(const std::string& record)
+{
+    return appendRecord(REMOVE_RECORD_OP, record);
+}
+
+unsigned JournaledMapperIndex::journalRecordCount()
+{
+    std::lock_guard locker{ m_journalLock };
+    return m_journalRecordCount;
+}
+
+bool JournaledMapperIndex::isCompactionNeeded(size_t live_record_count)
+{
+    std::lock_guard locker{ m_journalLock };
+    if (m_isCompacting) return false;
+    return (m_journalRecordCount >= m_compactionRecordCount) && (m_journalRecordCount >= live_record_count);
+}
+
+void JournaledMapperIndex::compactAsync(std::string snapshot_content)
+{
+    std::lock_guard locker{ m_journalLock };
+    if (m_isCompacting) return;
+    if (m_compaction.valid())
+    {
+        const auto er = m_compaction.get();  // 已經結束了, 只是取回結果
+        if (er) Platforms::Debug::ErrorPrintf("compact mapper file %s failed : %s\n", m_snapshotFilename.c_str(), er.message().c_str());
+    }
+    m_isCompacting = true;
+    m_compactingTail.clear();
+    m_compactingTailRecordCount = 0;
+    m_compaction = std::async(std::launch::async, [this, content = std::move(snapshot_content)]() { return writeSnapshot(content); });
+}
+
+std::error_code JournaledMapperIndex::compact(const std::string& snapshot_content)
+{
+    waitForCompaction();
+    {
+        std::lock_guard locker{ m_journalLock };
+        m_isCompacting = true;
+        m_compactingTail.clear();
+        m_compactingTailRecordCount = 0;
+    }
+    return writeSnapshot(snapshot_content);
+}
+
+void JournaledMapperIndex::waitForCompaction()
+{
+    std::future<std::error_code> compaction;
+    {
+        std::lock_guard locker{ m_journalLock };
+        compaction = std::move(m_compaction);
+    }
+    if (!compaction.valid()) return;
+    const auto er = compaction.get();
+    if (er) Platforms::Debug::ErrorPrintf("compact mapper file %s failed : %s\n", m_snapshotFilename.c_str(), er.message().c_str());
+}
+
+std::error_code JournaledMapperIndex::appendRecord(char op, const std::string& record)
+{
+    std::lock_guard locker{ m_journalLock };
+    auto er = openJournalForAppend();
+    if (er) return er;
+    std::string line;
+    line.reserve(record.size() + 2);
+    line += op;
+    line += record;
+    line += '\n';
+    const size_t write_size = m_journalFile->write(m_journalSize, { line.begin(), line.end() });
+    if (write_size != line.size()) return FileSystem::ErrorCode::writeFail;
+    m_journalSize += write_size;
+    m_journalRecordCount++;
+    if (m_isCompacting)
+    {
+        m_compactingTail += line;
+        m_compactingTailRecordCount++;
+    }
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code JournaledMapperIndex::openJournalForAppend()
+{
+    if (m_journalFile) return FileSystem::ErrorCode::ok;
+    if (m_journalSize > 0)
+    {
+        m_journalFile = FileSystem::FileSystem::instance()->openFile(m_journalFilename, FileSystem::read | FileSystem::write | FileSystem::binary);
+    }
+    else
+    {
+        m_journalFile = FileSystem::FileSystem::instance()->openFile(m_journalFilename, FileSystem::write | FileSystem::openAlways | FileSystem::binary);
+    }
+    if (!m_journalFile) return FileSystem::ErrorCode::fileOpenError;
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code JournaledMapperIndex::rewriteJournal(const std::string& content)
+{
+    if (m_journalFile)
+    {
+        FileSystem::FileSystem::instance()->closeFile(m_journalFile);
+        m_journalFile = nullptr;
+    }
+    m_journalSize = 0;
+    auto er = openJournalForAppend();
+    if (er) return er;
+    if (content.empty()) return FileSystem::ErrorCode::ok;
+    const size_t write_size = m_journalFile->write(0, { content.begin(), content.end() });
+    m_journalSize = write_size;
+    if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code JournaledMapperIndex::writeSnapshot(const std::string& snapshot_content)
+{
+    // 先寫到另一個檔, 再換掉 snapshot; 中途失敗的話, 原本的 snapshot + journal 還是完整的
+    auto er = writeTextFile(m_compactingFilename, snapshot_content);
+    std::lock_guard locker{ m_journalLock };
+    if (!er)
+    {
+        if (!replaceByRenaming(m_compactingFilename, COMPACTING_SUFFIX)) er = writeTextFile(m_snapshotFilename, snapshot_content);
+    }
+    if (!er)
+    {
+        // snapshot 已經包含 compaction 開始前的所有記錄, journal 只需要留下之後 append 的
+        er = rewriteJournal(m_compactingTail);
+        m_journalRecordCount = m_compactingTailRecordCount;
+    }
+    m_isCompacting = false;
+    m_compactingTail.clear();
+    m_compactingTailRecordCount = 0;
+    return er;
+}
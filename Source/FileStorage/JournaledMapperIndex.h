@@ -0,0 +1,88 @@
+﻿/*********************************************************************
+ * \file   JournaledMapperIndex.h
+ * \brief  file store mapper 的 index 檔 (id -> dto filename),
+ *         put / remove 只 append 一筆記錄到 journal, 不重寫整個 mapper file,
+ *         journal 長到一定程度再由 background compaction 重寫 snapshot
+ *
+ *         snapshot 就是原本的 mapper 文字檔 (一行一筆 record), 舊檔可以直接讀;
+ *         journal 檔名是 snapshot 加上 ".journal", 一行一筆, "+record" 為 put, "-record" 為 remove
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef JOURNALED_MAPPER_INDEX_H
+#define JOURNALED_MAPPER_INDEX_H
+
+#include "FileSystem/IFile.h"
+#include <string>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <system_error>
+
+namespace Enigma::FileStorage
+{
+    class JournaledMapperIndex
+    {
+    public:
+        /** record : 一行 mapper record (不含換行), is_removed : 是 remove 記錄 */
+        using ReplayRecord = std::function<void(const std::string& record, bool is_removed)>;
+
+        /** journal 至少要累積這麼多筆才 compaction */
+        static constexpr unsigned DefaultCompactionRecordCount = 4096;
+
+    public:
+        JournaledMapperIndex(const std::string& mapper_filename);
+        JournaledMapperIndex(const JournaledMapperIndex&) = delete;
+        JournaledMapperIndex(JournaledMapperIndex&&) = delete;
+        ~JournaledMapperIndex();
+        JournaledMapperIndex& operator=(const JournaledMapperIndex&) = delete;
+        JournaledMapperIndex& operator=(JournaledMapperIndex&&) = delete;
+
+        const std::string& snapshotFilename() const { return m_snapshotFilename; }
+        const std::string& journalFilename() const { return m_journalFilename; }
+
+        /** 讀 snapshot, 再依序 replay journal; 沒寫完的最後一行 (crash 留下的) 會被丟掉 */
+        std::error_code load(const ReplayRecord& replay);
+        /** 等 background compaction 結束, 關掉 journal 檔 */
+        void close();
+
+        std::error_code appendPut(const std::string& record);
+        std::error_code appendRemove(const std::string& record);
+
+        unsigned journalRecordCount();
+        unsigned compactionRecordCount() const { return m_compactionRecordCount; }
+        void compactionRecordCount(unsigned count) { m_compactionRecordCount = count; }
+        /** journal 筆數超過 compaction 門檻, 也超過目前的 record 數時, 重寫 snapshot 比較划算 */
+        bool isCompactionNeeded(size_t live_record_count);
+
+        /** snapshot_content 要在 mapper 自己的 lock 裡產生, 跟 journal 目前的位置一致;
+            寫檔在 background 做, 已經在 compaction 中就略過這次 */
+        void compactAsync(std::string snapshot_content);
+        std::error_code compact(const std::string& snapshot_content);
+        void waitForCompaction();
+
+    protected:
+        std::error_code appendRecord(char op, const std::string& record);
+        std::error_code openJournalForAppend();
+        std::error_code rewriteJournal(const std::string& content);
+        std::error_code writeSnapshot(const std::string& snapshot_content);
+
+    protected:
+        std::string m_snapshotFilename;
+        std::string m_journalFilename;
+        std::string m_compactingFilename;
+
+        FileSystem::IFilePtr m_journalFile;
+        size_t m_journalSize;
+        unsigned m_journalRecordCount;
+        unsigned m_compactionRecordCount;
+        std::recursive_mutex m_journalLock;
+
+        bool m_isCompacting;
+        std::string m_compactingTail;  ///< compaction 中 append 的 journal 內容, 完成後留在新的 journal
+        unsigned m_compactingTailRecordCount;
+        std::future<std::error_code> m_compaction;
+    };
+}
+
+#endif // JOURNALED_MAPPER_INDEX_H
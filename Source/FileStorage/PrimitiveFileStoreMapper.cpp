@@ -3,15 +3,16 @@
 #include "FileSystem/FileSystemErrors.h"
 #include "Primitives/PrimitiveErrors.h"
 #include "Frameworks/TokenVector.h"
+#include <algorithm>
 
 using namespace Enigma::FileStorage;
 
-PrimitiveFileStoreMapper::PrimitiveFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
+PrimitiveFileStoreMapper::PrimitiveFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : m_mapperIndex(mapper_filename)
 {
-    m_mapper_filename = mapper_filename;
     m_gateway = gateway;
     m_has_connected = false;
     m_sequence_number = 0;
+    m_journaled_sequence_number = 0;
 }
 
 PrimitiveFileStoreMapper::~PrimitiveFileStoreMapper()
@@ -25,17 +26,10 @@ std::error_code PrimitiveFileStoreMapper::connect()
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    m_sequence_number = 0;
+    auto er = m_mapperIndex.load([this](const std::string& record, bool is_removed) { deserializeMapperRecord(record, is_removed); });
+    if (er) return er;
+    m_journaled_sequence_number = m_sequence_number;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -43,9 +37,13 @@ std::error_code PrimitiveFileStoreMapper::connect()
 std::error_code PrimitiveFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_fileMapLock };
+    std::error_code er = FileSystem::ErrorCode::ok;
+    // 離線後 mapper file 本身就是完整的, 可以直接給其他工具讀
+    if (m_mapperIndex.journalRecordCount() > 0) er = m_mapperIndex.compact(serializeMapperFile());
+    m_mapperIndex.close();
     m_filename_map.clear();
     m_has_connected = false;
-    return FileSystem::ErrorCode::ok;
+    return er;
 }
 
 bool PrimitiveFileStoreMapper::hasPrimitive(const Primitives::PrimitiveId& id)
@@ -66,9 +64,15 @@ std::optional<Enigma::Engine::GenericDto> PrimitiveFileStoreMapper::queryPrimiti
 std::error_code PrimitiveFileStoreMapper::removePrimitive(const Primitives::PrimitiveId& id)
 {
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Primitives::ErrorCode::ok;
+    const auto record = serializeMapperRecord(id, it->second);
+    m_filename_map.erase(it);
+    auto er = journalSequenceNumber();
     if (er) return er;
+    er = m_mapperIndex.appendRemove(record);
+    if (er) return er;
+    compactMapperFileIfNeeded();
     return Primitives::ErrorCode::ok;
 }
 
@@ -77,8 +81,11 @@ std::error_code PrimitiveFileStoreMapper::putPrimitive(const Primitives::Primiti
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_fileMapLock };
     m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = journalSequenceNumber();
+    if (er) return er;
+    er = m_mapperIndex.appendPut(serializeMapperRecord(id, filename));
     if (er) return er;
+    compactMapperFileIfNeeded();
     er = serializeDataTransferObject(filename, dto);
     if (er) return er;
     return Primitives::ErrorCode::ok;
@@ -90,37 +97,59 @@ std::uint64_t PrimitiveFileStoreMapper::nextSequenceNumber()
     return ++m_sequence_number;
 }
 
-void PrimitiveFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
+void PrimitiveFileStoreMapper::deserializeMapperRecord(const std::string& record, bool is_removed)
 {
-    if (mapper_file_content.empty()) return;
     std::lock_guard locker{ m_fileMapLock };
-    auto lines = split_token(mapper_file_content, "\n\r");
-    m_sequence_number = std::stoul(lines[0]);
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() == 1)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 4) continue; // then, skip first line
-        Primitives::PrimitiveId id{ tokens[0], std::stoull(tokens[1]), Frameworks::Rtti::fromName(tokens[2]) };
-        m_filename_map.insert_or_assign(id, tokens[3]);
+        m_sequence_number = std::max(m_sequence_number, static_cast<std::uint64_t>(std::stoull(tokens[0])));
+        return;
     }
+    if (tokens.size() != 4) return;
+    Primitives::PrimitiveId id{ tokens[0], std::stoull(tokens[1]), Frameworks::Rtti::fromName(tokens[2]) };
+    if (is_removed)
+    {
+        m_filename_map.erase(id);
+        return;
+    }
+    m_filename_map.insert_or_assign(id, tokens.back());
 }
 
-std::error_code PrimitiveFileStoreMapper::serializeMapperFile()
+std::string PrimitiveFileStoreMapper::serializeMapperFile()
 {
     std::lock_guard locker{ m_fileMapLock };
     std::string mapper_file_content = std::to_string(m_sequence_number) + "\n";
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + std::to_string(rec.first.sequence()) + "," + rec.first.rtti().getName() + "," + rec.second + "\n";
+        mapper_file_content += serializeMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
+    return mapper_file_content;
+}
+
+std::string PrimitiveFileStoreMapper::serializeMapperRecord(const Primitives::PrimitiveId& id, const std::string& filename)
+{
+    return id.name() + "," + std::to_string(id.sequence()) + "," + id.rtti().getName() + "," + filename;
+}
+
+std::error_code PrimitiveFileStoreMapper::journalSequenceNumber()
+{
+    std::lock_guard locker{ m_fileMapLock };
+    if (m_sequence_number == m_journaled_sequence_number) return FileSystem::ErrorCode::ok;
+    // 只有一個欄位的 record 是 sequence number, 跟 mapper file 第一行相同
+    auto er = m_mapperIndex.appendPut(std::to_string(m_sequence_number));
+    if (er) return er;
+    m_journaled_sequence_number = m_sequence_number;
     return FileSystem::ErrorCode::ok;
 }
 
+void PrimitiveFileStoreMapper::compactMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_fileMapLock };
+    if (!m_mapperIndex.isCompactionNeeded(m_filename_map.size())) return;
+    m_mapperIndex.compactAsync(serializeMapperFile());
+}
+
 std::string PrimitiveFileStoreMapper::extractFilename(const Primitives::PrimitiveId& id, const Engine::FactoryDesc& factory_desc)
 {
     if (!factory_desc.GetDeferredFilename().empty()) return factory_desc.GetDeferredFilename();
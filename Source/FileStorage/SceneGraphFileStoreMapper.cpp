@@ -9,10 +9,9 @@
 
 using namespace Enigma::FileStorage;
 
-SceneGraphFileStoreMapper::SpatialFileMap::SpatialFileMap(const std::string& filename, const std::string& asset_prefix, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
+SceneGraphFileStoreMapper::SpatialFileMap::SpatialFileMap(const std::string& filename, const std::string& asset_prefix, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : m_mapperIndex(filename)
 {
     m_gateway = gateway;
-    m_filename = filename;
     m_assetPrefix = asset_prefix;
 }
 
@@ -25,22 +24,18 @@ std::error_code SceneGraphFileStoreMapper::SpatialFileMap::connect()
 {
     std::lock_guard locker{ m_lock };
     m_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::ok;
-    auto file_size = mapper_file->size();
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    const std::string mapper_content{ content->begin(), content->end() };
-    deserializeMapperFile(mapper_content);
-    return FileSystem::ErrorCode::ok;
+    return m_mapperIndex.load([this](const std::string& record, bool is_removed) { deserializeMapperRecord(record, is_removed); });
 }
 
 std::error_code SceneGraphFileStoreMapper::SpatialFileMap::disconnect()
 {
     std::lock_guard locker{ m_lock };
+    std::error_code er = FileSystem::ErrorCode::ok;
+    // 離線後 mapper file 本身就是完整的, 可以直接給其他工具讀
+    if (m_mapperIndex.journalRecordCount() > 0) er = m_mapperIndex.compact(serializeMapperFile());
+    m_mapperIndex.close();
     m_map.clear();
-    return FileSystem::ErrorCode::ok;
+    return er;
 }
 
 bool SceneGraphFileStoreMapper::SpatialFileMap::has(const SceneGraph::SpatialId& id)
@@ -60,9 +55,13 @@ std::optional<Enigma::Engine::GenericDto> SceneGraphFileStoreMapper::SpatialFile
 std::error_code SceneGraphFileStoreMapper::SpatialFileMap::remove(const SceneGraph::SpatialId& id)
 {
     std::lock_guard locker{ m_lock };
-    m_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_map.find(id);
+    if (it == m_map.end()) return SceneGraph::ErrorCode::ok;
+    const auto record = serializeMapperRecord(id, it->second);
+    m_map.erase(it);
+    auto er = m_mapperIndex.appendRemove(record);
     if (er) return er;
+    compactMapperFileIfNeeded();
     return SceneGraph::ErrorCode::ok;
 }
 
@@ -71,24 +70,25 @@ std::error_code SceneGraphFileStoreMapper::SpatialFileMap::put(const SceneGraph:
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_lock };
     m_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = m_mapperIndex.appendPut(serializeMapperRecord(id, filename));
     if (er) return er;
+    compactMapperFileIfNeeded();
     er = serializeDataTransferObjects(filename, dto);
     if (er) return er;
     return SceneGraph::ErrorCode::ok;
 }
 
-void SceneGraphFileStoreMapper::SpatialFileMap::deserializeMapperFile(const std::string& content)
+void SceneGraphFileStoreMapper::SpatialFileMap::deserializeMapperRecord(const std::string& record, bool is_removed)
 {
-    if (content.empty()) return;
-    auto lines = split_token(content, "\n\r");
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() != 3) return;
+    SceneGraph::SpatialId id{ tokens[0], Frameworks::Rtti::fromName(tokens[1]) };
+    if (is_removed)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 3) continue;
-        SceneGraph::SpatialId id{ tokens[0], Frameworks::Rtti::fromName(tokens[1]) };
-        m_map.insert_or_assign(id, tokens[2]);
+        m_map.erase(id);
+        return;
     }
+    m_map.insert_or_assign(id, tokens[2]);
 }
 
 Enigma::Engine::GenericDto SceneGraphFileStoreMapper::SpatialFileMap::deserializeDataTransferObjects(const std::string& filename)
@@ -104,20 +104,27 @@ Enigma::Engine::GenericDto SceneGraphFileStoreMapper::SpatialFileMap::deserializ
     return dtos[0];
 }
 
-std::error_code SceneGraphFileStoreMapper::SpatialFileMap::serializeMapperFile()
+std::string SceneGraphFileStoreMapper::SpatialFileMap::serializeMapperFile()
 {
     std::lock_guard locker{ m_lock };
     std::string mapper_file_content;
     for (auto& rec : m_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.first.rtti().getName() + "," + rec.second + "\n";
+        mapper_file_content += serializeMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
+}
+
+std::string SceneGraphFileStoreMapper::SpatialFileMap::serializeMapperRecord(const SceneGraph::SpatialId& id, const std::string& filename)
+{
+    return id.name() + "," + id.rtti().getName() + "," + filename;
+}
+
+void SceneGraphFileStoreMapper::SpatialFileMap::compactMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_lock };
+    if (!m_mapperIndex.isCompactionNeeded(m_map.size())) return;
+    m_mapperIndex.compactAsync(serializeMapperFile());
 }
 
 std::string SceneGraphFileStoreMapper::SpatialFileMap::extractFilename(const SceneGraph::SpatialId& id, const Engine::FactoryDesc& factory_desc)
@@ -10,6 +10,7 @@
 
 #include "GameEngine/FactoryDesc.h"
 #include "Gateways/DtoGateway.h"
+#include "JournaledMapperIndex.h"
 #include "SceneGraph/SceneGraphStoreMapper.h"
 #include "SceneGraph/Camera.h"
 #include <mutex>
@@ -40,17 +41,20 @@ namespace Enigma::FileStorage
             const auto& map() const { return m_map; };
 
         protected:
-            void deserializeMapperFile(const std::string& content);
+            void deserializeMapperRecord(const std::string& record, bool is_removed);
             Engine::GenericDto deserializeDataTransferObjects(const std::string& filename);
 
-            std::error_code serializeMapperFile();
+            std::string serializeMapperFile();
+            std::string serializeMapperRecord(const SceneGraph::SpatialId& id, const std::string& filename);
+            /** journal 太長時在 background 重寫 mapper file */
+            void compactMapperFileIfNeeded();
             std::string extractFilename(const SceneGraph::SpatialId& id, const Engine::FactoryDesc& factory_desc);
 
             std::error_code serializeDataTransferObjects(const std::string& filename, const Engine::GenericDto& dto);
 
         protected:
             std::shared_ptr<Gateways::IDtoGateway> m_gateway;
-            std::string m_filename;
+            JournaledMapperIndex m_mapperIndex;
             std::unordered_map<SceneGraph::SpatialId, std::string, SceneGraph::SpatialId::hash> m_map;
             mutable std::recursive_mutex m_lock;
             std::string m_assetPrefix;
@@ -7,9 +7,8 @@
 
 using namespace Enigma::FileStorage;
 
-TextureFileStoreMapper::TextureFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Engine::TextureStoreMapper()
+TextureFileStoreMapper::TextureFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Engine::TextureStoreMapper(), m_mapperIndex(mapper_filename)
 {
-    m_mapper_filename = mapper_filename;
     m_gateway = gateway;
     m_has_connected = false;
 }
@@ -25,17 +24,8 @@ std::error_code TextureFileStoreMapper::connect()
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    auto er = m_mapperIndex.load([this](const std::string& record, bool is_removed) { deserializeMapperRecord(record, is_removed); });
+    if (er) return er;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -43,9 +33,13 @@ std::error_code TextureFileStoreMapper::connect()
 std::error_code TextureFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_fileMapLock };
+    std::error_code er = FileSystem::ErrorCode::ok;
+    // 離線後 mapper file 本身就是完整的, 可以直接給其他工具讀
+    if (m_mapperIndex.journalRecordCount() > 0) er = m_mapperIndex.compact(serializeMapperFile());
+    m_mapperIndex.close();
     m_filename_map.clear();
     m_has_connected = false;
-    return FileSystem::ErrorCode::ok;
+    return er;
 }
 
 bool TextureFileStoreMapper::hasTexture(const Engine::TextureId& id)
@@ -68,8 +62,9 @@ std::error_code TextureFileStoreMapper::putTexture(const Engine::TextureId& id,
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_fileMapLock };
     m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = m_mapperIndex.appendPut(serializeMapperRecord(id, filename));
     if (er) return er;
+    compactMapperFileIfNeeded();
     er = serializeDataTransferObject(filename, dto);
     if (er) return er;
     return Engine::ErrorCode::ok;
@@ -78,40 +73,51 @@ std::error_code TextureFileStoreMapper::putTexture(const Engine::TextureId& id,
 std::error_code TextureFileStoreMapper::removeTexture(const Engine::TextureId& id)
 {
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Engine::ErrorCode::ok;
+    const auto record = serializeMapperRecord(id, it->second);
+    m_filename_map.erase(it);
+    auto er = m_mapperIndex.appendRemove(record);
     if (er) return er;
+    compactMapperFileIfNeeded();
     return Engine::ErrorCode::ok;
 }
 
-std::error_code TextureFileStoreMapper::serializeMapperFile()
+std::string TextureFileStoreMapper::serializeMapperFile()
 {
     std::lock_guard locker{ m_fileMapLock };
-    std::string mapper_file_content = "";
+    std::string mapper_file_content;
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.second + "\n";
+        mapper_file_content += serializeMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
+}
+
+std::string TextureFileStoreMapper::serializeMapperRecord(const Engine::TextureId& id, const std::string& filename)
+{
+    return id.name() + "," + filename;
+}
+
+void TextureFileStoreMapper::compactMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_fileMapLock };
+    if (!m_mapperIndex.isCompactionNeeded(m_filename_map.size())) return;
+    m_mapperIndex.compactAsync(serializeMapperFile());
 }
 
-void TextureFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
+void TextureFileStoreMapper::deserializeMapperRecord(const std::string& record, bool is_removed)
 {
-    if (mapper_file_content.empty()) return;
     std::lock_guard locker{ m_fileMapLock };
-    auto lines = split_token(mapper_file_content, "\n\r");
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() != 2) return;
+    Engine::TextureId id{ tokens[0] };
+    if (is_removed)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        Engine::TextureId id{ tokens[0] };
-        m_filename_map.insert_or_assign(id, tokens[1]);
+        m_filename_map.erase(id);
+        return;
     }
+    m_filename_map.insert_or_assign(id, tokens.back());
 }
 
 std::error_code TextureFileStoreMapper::serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto)
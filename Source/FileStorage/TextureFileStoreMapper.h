@@ -10,6 +10,7 @@
 
 #include "GameEngine/TextureId.h"
 #include "Gateways/DtoGateway.h"
+#include "JournaledMapperIndex.h"
 #include "GameEngine/TextureStoreMapper.h"
 #include <mutex>
 
@@ -34,8 +35,11 @@ namespace Enigma::FileStorage
         virtual std::error_code putTexture(const Engine::TextureId& id, const Engine::GenericDto& dto) override;
 
     protected:
-        std::error_code serializeMapperFile();
-        void deserializeMapperFile(const std::string& mapper_file_content);
+        std::string serializeMapperFile();
+        std::string serializeMapperRecord(const Engine::TextureId& id, const std::string& filename);
+        void deserializeMapperRecord(const std::string& record, bool is_removed);
+        /** journal 太長時在 background 重寫 mapper file */
+        void compactMapperFileIfNeeded();
         std::error_code serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto);
         Engine::GenericDto deserializeDataTransferObject(const std::string& filename);
         std::string extractFilename(const Engine::TextureId& id, const Engine::FactoryDesc& factory_desc);
@@ -43,7 +47,7 @@ namespace Enigma::FileStorage
     protected:
         bool m_has_connected;
         std::shared_ptr<Gateways::IDtoGateway> m_gateway;
-        std::string m_mapper_filename;
+        JournaledMapperIndex m_mapperIndex;
         std::unordered_map<Engine::TextureId, std::string, Engine::TextureId::hash> m_filename_map;
         mutable std::recursive_mutex m_fileMapLock;
     };
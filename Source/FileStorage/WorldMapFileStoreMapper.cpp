@@ -8,7 +8,7 @@ using namespace Enigma::FileStorage;
 using namespace Enigma::WorldMap;
 
 WorldMapFileStoreMapper::WorldMapFileStoreMapper(const std::string& world_mapper_filename, const std::string& quad_root_mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
-    : m_gateway(gateway), m_worldMapperFilename(world_mapper_filename), m_quadRootMapperFilename(quad_root_mapper_filename)
+    : m_gateway(gateway), m_worldMapperIndex(world_mapper_filename), m_quadRootMapperIndex(quad_root_mapper_filename)
 {
     m_hasConnected = false;
 }
@@ -24,21 +24,31 @@ std::error_code WorldMapFileStoreMapper::connect()
 {
     if (m_hasConnected) return FileSystem::ErrorCode::ok;
     auto er = connectWorldMapperFile();
-    if (!er) return er;
+    if (er) return er;
     er = connectQuadRootMapperFile();
-    if (!er) return er;
+    if (er) return er;
     m_hasConnected = true;
     return FileSystem::ErrorCode::ok;
 }
 
 std::error_code WorldMapFileStoreMapper::disconnect()
 {
+    std::error_code er = FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_worldMapLock };
+    // 離線後 mapper file 本身就是完整的, 可以直接給其他工具讀
+    if (m_worldMapperIndex.journalRecordCount() > 0) er = m_worldMapperIndex.compact(serializeWorldMapperFile());
+    m_worldMapperIndex.close();
     m_worldFilenameMap.clear();
     std::lock_guard locker2{ m_quadTreeRootLock };
+    if (m_quadRootMapperIndex.journalRecordCount() > 0)
+    {
+        auto quad_er = m_quadRootMapperIndex.compact(serializeQuadRootMapperFile());
+        if (!er) er = quad_er;
+    }
+    m_quadRootMapperIndex.close();
     m_quadRootFilenameMap.clear();
     m_hasConnected = false;
-    return FileSystem::ErrorCode::ok;
+    return er;
 }
 
 bool WorldMapFileStoreMapper::hasQuadTreeRoot(const QuadTreeRootId& id)
@@ -63,9 +73,11 @@ std::error_code WorldMapFileStoreMapper::removeQuadTreeRoot(const WorldMap::Quad
     std::lock_guard locker{ m_quadTreeRootLock };
     auto it = m_quadRootFilenameMap.find(id);
     if (it == m_quadRootFilenameMap.end()) return FileSystem::ErrorCode::ok;
+    const auto record = it->first.name() + "," + it->second;
     m_quadRootFilenameMap.erase(it);
-    auto er = serializeQuadRootMapperFile();
+    auto er = m_quadRootMapperIndex.appendRemove(record);
     if (er) return er;
+    compactQuadRootMapperFileIfNeeded();
     return FileSystem::ErrorCode::ok;
 }
 
@@ -74,8 +86,9 @@ std::error_code WorldMapFileStoreMapper::putQuadTreeRoot(const WorldMap::QuadTre
     auto filename = extractQuadRootFilename(id, dto.getRtti());
     std::lock_guard locker{ m_quadTreeRootLock };
     m_quadRootFilenameMap.insert_or_assign(id, filename);
-    auto er = serializeQuadRootMapperFile();
+    auto er = m_quadRootMapperIndex.appendPut(id.name() + "," + filename);
     if (er) return er;
+    compactQuadRootMapperFileIfNeeded();
     er = serializeDataTransferObjects(filename, dto);
     if (er) return er;
     return FileSystem::ErrorCode::ok;
@@ -103,9 +116,11 @@ std::error_code WorldMapFileStoreMapper::removeWorldMap(const WorldMap::WorldMap
     std::lock_guard locker{ m_worldMapLock };
     auto it = m_worldFilenameMap.find(id);
     if (it == m_worldFilenameMap.end()) return FileSystem::ErrorCode::ok;
+    const auto record = it->first.name() + "," + it->second;
     m_worldFilenameMap.erase(it);
-    auto er = serializeWorldMapperFile();
+    auto er = m_worldMapperIndex.appendRemove(record);
     if (er) return er;
+    compactWorldMapperFileIfNeeded();
     return FileSystem::ErrorCode::ok;
 }
 
@@ -114,8 +129,9 @@ std::error_code WorldMapFileStoreMapper::putWorldMap(const WorldMap::WorldMapId&
     auto filename = extractWorldFilename(id, dto.getRtti());
     std::lock_guard locker{ m_worldMapLock };
     m_worldFilenameMap.insert_or_assign(id, filename);
-    auto er = serializeWorldMapperFile();
+    auto er = m_worldMapperIndex.appendPut(id.name() + "," + filename);
     if (er) return er;
+    compactWorldMapperFileIfNeeded();
     er = serializeDataTransferObjects(filename, dto);
     if (er) return er;
     return FileSystem::ErrorCode::ok;
@@ -125,61 +141,45 @@ std::error_code WorldMapFileStoreMapper::connectWorldMapperFile()
 {
     std::lock_guard locker{ m_worldMapLock };
     m_worldFilenameMap.clear();
-    FileSystem::IFilePtr world_mapper_file = FileSystem::FileSystem::instance()->openFile(m_worldMapperFilename, FileSystem::read | FileSystem::binary);
-    if (!world_mapper_file) return FileSystem::ErrorCode::ok;
-    auto file_size = world_mapper_file->size();
-    auto content = world_mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(world_mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    auto er = deserializeWorldMapperFile(std::string(content->begin(), content->end()));
-    return er;
+    return m_worldMapperIndex.load([this](const std::string& record, bool is_removed) { deserializeWorldMapperRecord(record, is_removed); });
 }
 
 std::error_code WorldMapFileStoreMapper::connectQuadRootMapperFile()
 {
     std::lock_guard locker{ m_quadTreeRootLock };
     m_quadRootFilenameMap.clear();
-    FileSystem::IFilePtr quad_root_mapper_file = FileSystem::FileSystem::instance()->openFile(m_quadRootMapperFilename, FileSystem::read | FileSystem::binary);
-    if (!quad_root_mapper_file) return FileSystem::ErrorCode::ok;
-    auto file_size = quad_root_mapper_file->size();
-    auto content = quad_root_mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(quad_root_mapper_file);
-    if (!content) return FileSystem::ErrorCode::readFail;
-    auto er = deserializeQuadRootMapperFile(std::string(content->begin(), content->end()));
-    return er;
+    return m_quadRootMapperIndex.load([this](const std::string& record, bool is_removed) { deserializeQuadRootMapperRecord(record, is_removed); });
 }
 
-std::error_code WorldMapFileStoreMapper::deserializeWorldMapperFile(const std::string& content)
+void WorldMapFileStoreMapper::deserializeWorldMapperRecord(const std::string& record, bool is_removed)
 {
-    if (content.empty()) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_worldMapLock };
-    auto lines = split_token(content, "\n\r");
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() != 2) return;
+    WorldMapId id{ tokens[0] };
+    if (is_removed)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        WorldMapId id{ tokens[0] };
-        m_worldFilenameMap.insert_or_assign(id, tokens[1]);
+        m_worldFilenameMap.erase(id);
+        return;
     }
-    return FileSystem::ErrorCode::ok;
+    m_worldFilenameMap.insert_or_assign(id, tokens[1]);
 }
 
-std::error_code WorldMapFileStoreMapper::deserializeQuadRootMapperFile(const std::string& content)
+void WorldMapFileStoreMapper::deserializeQuadRootMapperRecord(const std::string& record, bool is_removed)
 {
-    if (content.empty()) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_quadTreeRootLock };
-    auto lines = split_token(content, "\n\r");
-    for (auto& line : lines)
+    auto tokens = split_token(record, ",");
+    if (tokens.size() != 2) return;
+    QuadTreeRootId id{ tokens[0] };
+    if (is_removed)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        QuadTreeRootId id{ tokens[0] };
-        m_quadRootFilenameMap.insert_or_assign(id, tokens[1]);
+        m_quadRootFilenameMap.erase(id);
+        return;
     }
-    return FileSystem::ErrorCode::ok;
+    m_quadRootFilenameMap.insert_or_assign(id, tokens[1]);
 }
 
-std::error_code WorldMapFileStoreMapper::serializeWorldMapperFile()
+std::string WorldMapFileStoreMapper::serializeWorldMapperFile()
 {
     std::lock_guard locker{ m_worldMapLock };
     std::string mapper_file_content;
@@ -187,15 +187,17 @@ std::error_code WorldMapFileStoreMapper::serializeWorldMapperFile()
     {
         mapper_file_content += rec.first.name() + "," + rec.second + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_worldMapperFilename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
+}
+
+void WorldMapFileStoreMapper::compactWorldMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_worldMapLock };
+    if (!m_worldMapperIndex.isCompactionNeeded(m_worldFilenameMap.size())) return;
+    m_worldMapperIndex.compactAsync(serializeWorldMapperFile());
 }
 
-std::error_code WorldMapFileStoreMapper::serializeQuadRootMapperFile()
+std::string WorldMapFileStoreMapper::serializeQuadRootMapperFile()
 {
     std::lock_guard locker{ m_quadTreeRootLock };
     std::string mapper_file_content;
@@ -203,12 +205,14 @@ std::error_code WorldMapFileStoreMapper::serializeQuadRootMapperFile()
     {
         mapper_file_content += rec.first.name() + "," + rec.second + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_quadRootMapperFilename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
+}
+
+void WorldMapFileStoreMapper::compactQuadRootMapperFileIfNeeded()
+{
+    std::lock_guard locker{ m_quadTreeRootLock };
+    if (!m_quadRootMapperIndex.isCompactionNeeded(m_quadRootFilenameMap.size())) return;
+    m_quadRootMapperIndex.compactAsync(serializeQuadRootMapperFile());
 }
 
 Enigma::Engine::GenericDto WorldMapFileStoreMapper::deserializeDataTransferObjects(const std::string& filename)
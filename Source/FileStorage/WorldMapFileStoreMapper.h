@@ -12,6 +12,7 @@
 #include "WorldMap/WorldMapId.h"
 #include "WorldMap/QuadTreeRootId.h"
 #include "Gateways/DtoGateway.h"
+#include "JournaledMapperIndex.h"
 
 namespace Enigma::FileStorage
 {
@@ -38,10 +39,13 @@ namespace Enigma::FileStorage
         std::error_code connectWorldMapperFile();
         std::error_code connectQuadRootMapperFile();
 
-        std::error_code deserializeWorldMapperFile(const std::string& content);
-        std::error_code deserializeQuadRootMapperFile(const std::string& content);
-        std::error_code serializeWorldMapperFile();
-        std::error_code serializeQuadRootMapperFile();
+        void deserializeWorldMapperRecord(const std::string& record, bool is_removed);
+        void deserializeQuadRootMapperRecord(const std::string& record, bool is_removed);
+        std::string serializeWorldMapperFile();
+        std::string serializeQuadRootMapperFile();
+        /** journal 太長時在 background 重寫 mapper file */
+        void compactWorldMapperFileIfNeeded();
+        void compactQuadRootMapperFileIfNeeded();
 
         Engine::GenericDto deserializeDataTransferObjects(const std::string& filename);
         std::error_code serializeDataTransferObjects(const std::string& filename, const Engine::GenericDto& dto);
@@ -53,11 +57,11 @@ namespace Enigma::FileStorage
         bool m_hasConnected;
         std::shared_ptr<Gateways::IDtoGateway> m_gateway;
 
-        std::string m_worldMapperFilename;
+        JournaledMapperIndex m_worldMapperIndex;
         std::unordered_map<WorldMap::WorldMapId, std::string, WorldMap::WorldMapId::hash> m_worldFilenameMap;
         std::recursive_mutex m_worldMapLock;
 
-        std::string m_quadRootMapperFilename;
+        JournaledMapperIndex m_quadRootMapperIndex;
         std::unordered_map<WorldMap::QuadTreeRootId, std::string, WorldMap::QuadTreeRootId::hash> m_quadRootFilenameMap;
         std::recursive_mutex m_quadTreeRootLock;
     };
@@ -8,6 +8,7 @@
 #include <cassert>
 #include <iostream>
 #include <future>
+#include <algorithm>
 
 #undef CreateFile
 
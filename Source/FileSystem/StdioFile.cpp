@@ -4,6 +4,7 @@
 #include "FileSystemErrors.h"
 #include <cassert>
 #include <iostream>
+#include <cstring>
 #include "sys/stat.h"
 #include <filesystem>
 
@@ -1,4 +1,5 @@
 ﻿#include "CommandBus.h"
+#include "Platforms/Profiler.h"
 #include <cassert>
 
 using namespace Enigma::Frameworks;
@@ -11,6 +12,7 @@ CommandBus::CommandBus(ServiceManager* manager) : ISystemService(manager)
 {
     assert(m_thisBus == nullptr);
     m_needTick = false;
+    m_hasPostHook = false;
     m_thisBus = this;
 }
 
@@ -75,11 +77,33 @@ void CommandBus::unsubscribe(const std::type_info& cmd_type, const CommandSubscr
     assert(res == 1);
 }
 
+void CommandBus::setPostHook(const std::shared_ptr<const CommandHandler>& hook)
+{
+    if (!m_thisBus) return;
+    const bool has_hook = (hook) && (*hook);
+    // 先關掉 flag 再清 hook; 設定時相反, 讀到 flag 的 post 一定拿得到 hook (或 nullptr)
+    if (!has_hook) m_thisBus->m_hasPostHook.store(false, std::memory_order_release);
+    {
+        std::lock_guard locker{ m_thisBus->m_postHookLock };
+        m_thisBus->m_postHook = has_hook ? hook : nullptr;
+    }
+    if (has_hook) m_thisBus->m_hasPostHook.store(true, std::memory_order_release);
+}
+
 void CommandBus::post(const ICommandPtr& c)
 {
     assert(m_thisBus);
     if (!c) return;
     if (m_thisBus->m_isSuspended) return;
+    if (m_thisBus->m_hasPostHook.load(std::memory_order_acquire))
+    {
+        std::shared_ptr<const CommandHandler> hook;
+        {
+            std::lock_guard locker{ m_thisBus->m_postHookLock };
+            hook = m_thisBus->m_postHook;
+        }
+        if (hook) (*hook)(c);
+    }
 
     m_thisBus->m_commandListLock.lock();
     m_thisBus->m_commands.emplace_back(c);
@@ -104,5 +128,7 @@ void CommandBus::cleanupAllCommands()
 
 void CommandBus::invokeHandler(const ICommandPtr& c, const CommandSubscriberPtr& subscriber)
 {
-    if (subscriber) subscriber->handleCommand(c);
+    if (!subscriber) return;
+    PROFILE_ZONE(c->typeInfo());
+    subscriber->handleCommand(c);
 }
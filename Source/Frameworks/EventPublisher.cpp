@@ -1,4 +1,5 @@
 ﻿#include "EventPublisher.h"
+#include "Platforms/Profiler.h"
 #include <cassert>
 
 using namespace Enigma::Frameworks;
@@ -11,6 +12,7 @@ EventPublisher::EventPublisher(ServiceManager* manager) : ISystemService(manager
 {
     assert(m_thisPublisher == nullptr);
     m_needTick = false;
+    m_hasPostHook = false;
     m_thisPublisher = this;
 }
 
@@ -71,11 +73,33 @@ void EventPublisher::unsubscribe(const std::type_info& ev_type, const EventSubsc
     subscribers->second.remove(sub);
 }
 
+void EventPublisher::setPostHook(const std::shared_ptr<const EventHandler>& hook)
+{
+    if (!m_thisPublisher) return;
+    const bool has_hook = (hook) && (*hook);
+    // 先關掉 flag 再清 hook; 設定時相反, 讀到 flag 的 post 一定拿得到 hook (或 nullptr)
+    if (!has_hook) m_thisPublisher->m_hasPostHook.store(false, std::memory_order_release);
+    {
+        std::lock_guard locker{ m_thisPublisher->m_postHookLock };
+        m_thisPublisher->m_postHook = has_hook ? hook : nullptr;
+    }
+    if (has_hook) m_thisPublisher->m_hasPostHook.store(true, std::memory_order_release);
+}
+
 void EventPublisher::post(const IEventPtr& e)
 {
     assert(m_thisPublisher);
     if (!e) return;
     if (m_thisPublisher->m_isSuspended) return;
+    if (m_thisPublisher->m_hasPostHook.load(std::memory_order_acquire))
+    {
+        std::shared_ptr<const EventHandler> hook;
+        {
+            std::lock_guard locker{ m_thisPublisher->m_postHookLock };
+            hook = m_thisPublisher->m_postHook;
+        }
+        if (hook) (*hook)(e);
+    }
 
     m_thisPublisher->m_eventListLock.lock();
     m_thisPublisher->m_events.emplace_back(e);
@@ -101,6 +125,7 @@ void EventPublisher::cleanupAllEvents()
 void EventPublisher::invokeHandlers(const IEventPtr& e, const SubscriberList& subscribers)
 {
     if (subscribers.empty()) return;
+    PROFILE_ZONE(e->typeInfo());
     for (auto subscriber : subscribers)
     {
         if (subscriber) subscriber->handleEvent(e);
@@ -14,6 +14,7 @@
 #include <list>
 #include <unordered_map>
 #include <typeindex>
+#include <atomic>
 #include <mutex>
 
 namespace Enigma::Frameworks
@@ -46,6 +47,11 @@ namespace Enigma::Frameworks
         static void subscribe(const std::type_info& ev_type, const EventSubscriberPtr& sub);
         static void unsubscribe(const std::type_info& ev_type, const EventSubscriberPtr& sub);
 
+        /** post 進 queue 的每個 message 都會呼叫 hook (在 post 的執行緒上), 要 thread safe,
+            給 message recorder 用; service 不存在時不做事.
+            post 會先複製一份 hook 再呼叫, 清掉之後還在執行的呼叫會持有那份 copy,
+            設定的一方要等自己手上的 hook 沒有其他 owner 才能釋放 hook 用到的資源 */
+        static void setPostHook(const std::shared_ptr<const EventHandler>& hook);
         static void post(const IEventPtr& e);
         static void send(const IEventPtr& e);
 
@@ -61,6 +67,10 @@ namespace Enigma::Frameworks
         EventList m_events;
 
         std::mutex m_eventListLock; ///< 需要執行緒鎖來鎖住event list的存取
+
+        std::atomic<bool> m_hasPostHook;  ///< 沒有 hook 時 post 不用 lock
+        std::mutex m_postHookLock;
+        std::shared_ptr<const EventHandler> m_postHook;
     };
 }
 
@@ -13,6 +13,7 @@
 #include <type_traits>
 #include <array>
 #include <system_error>
+#include <cstring>
 
 using byte_buffer = std::vector<unsigned char>;
 using uint_buffer = std::vector<unsigned int>;
@@ -0,0 +1,200 @@
+﻿#include "FrameArena.h"
+#include "Platforms/PlatformLayer.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace Enigma::Frameworks;
+
+std::atomic<FrameArena*> FrameArena::m_currentArena{ nullptr };
+std::atomic<std::uint64_t> FrameArena::m_nextGeneration{ 1 };
+thread_local FrameArena::ThreadBinding FrameArena::m_threadBinding;
+
+FrameArena::FrameArena(size_t chunk_size) : m_chunkSize(std::max(chunk_size, ThreadBlockSize)), m_currentChunkIndex(0),
+    m_remoteCount(0), m_generation(m_nextGeneration.fetch_add(1, std::memory_order_relaxed))
+{
+    auto chunk = std::make_unique<Chunk>();
+    chunk->m_memory = std::make_unique<unsigned char[]>(m_chunkSize);
+    chunk->m_size = m_chunkSize;
+    chunk->m_offset.store(0, std::memory_order_relaxed);
+    m_currentChunk.store(chunk.get(), std::memory_order_release);
+    m_chunks.emplace_back(std::move(chunk));
+}
+
+FrameArena::~FrameArena()
+{
+    assert(liveAllocationCount() == 0);
+    FrameArena* self = this;
+    m_currentArena.compare_exchange_strong(self, nullptr);
+}
+
+FrameArena* FrameArena::current()
+{
+    return m_currentArena.load(std::memory_order_acquire);
+}
+
+void* FrameArena::allocateSlow(size_t size)
+{
+    if (!isBoundToThisThread())
+    {
+        // 綁定這個 arena, 手上別的 arena 的 block 與計數就不用了
+        auto counter = std::make_unique<ThreadCounter>();
+        {
+            std::lock_guard locker{ m_chunkLock };
+            m_threadCounters.emplace_back(std::move(counter));
+            m_threadBinding = { this, m_generation.load(std::memory_order_relaxed), m_threadCounters.back().get(), nullptr, nullptr };
+        }
+    }
+    m_threadBinding.m_counter->add(1);
+    if (size > ThreadBlockSize / 4)
+    {
+        // 大的直接從 chunk 拿, 不要浪費掉手上 block 剩下的部分
+        return allocateBlock(size);
+    }
+    // 手上 block 剩下的丟掉, 換一塊新的
+    unsigned char* block = static_cast<unsigned char*>(allocateBlock(ThreadBlockSize));
+    m_threadBinding.m_cursor = block + size;
+    m_threadBinding.m_end = block + ThreadBlockSize;
+    return block;
+}
+
+void* FrameArena::allocateBlock(size_t block_size)
+{
+    while (true)
+    {
+        Chunk* chunk = m_currentChunk.load(std::memory_order_acquire);
+        const size_t offset = chunk->m_offset.fetch_add(block_size, std::memory_order_relaxed);
+        if (offset + block_size <= chunk->m_size)
+        {
+            return chunk->m_memory.get() + offset;
+        }
+        std::lock_guard locker{ m_chunkLock };
+        // 別的執行緒可能已經換好了
+        if (m_currentChunk.load(std::memory_order_relaxed) == chunk) advanceChunk(block_size);
+    }
+}
+
+void FrameArena::deallocateRemote(void* p, size_t size)
+{
+#if !defined(NDEBUG)
+    memset(p, FreedPoison, alignedSize(size));
+#else
+    (void)p;
+    (void)size;
+#endif
+    // 減完之後就不能再碰 arena, 可能馬上被 reset 或刪掉
+    m_remoteCount.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void FrameArena::reset()
+{
+    assert(liveAllocationCount() == 0);
+    std::lock_guard locker{ m_chunkLock };
+    // generation 換掉後, 執行緒手上的 counter 指標就不會再用
+    m_threadCounters.clear();
+    m_remoteCount.store(0, std::memory_order_relaxed);
+    for (auto& chunk : m_chunks)
+    {
+#if !defined(NDEBUG)
+        memset(chunk->m_memory.get(), ResetPoison, std::min(chunk->m_offset.load(std::memory_order_relaxed), chunk->m_size));
+#endif
+        chunk->m_offset.store(0, std::memory_order_relaxed);
+    }
+    m_currentChunkIndex = 0;
+    m_currentChunk.store(m_chunks[0].get(), std::memory_order_release);
+    m_generation.store(m_nextGeneration.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+unsigned FrameArena::liveAllocationCount() const
+{
+    std::lock_guard locker{ m_chunkLock };
+    std::int64_t count = m_remoteCount.load(std::memory_order_acquire);
+    for (auto& counter : m_threadCounters)
+    {
+        count += counter->m_count.load(std::memory_order_acquire);
+    }
+    assert(count >= 0);
+    return static_cast<unsigned>(std::max<std::int64_t>(count, 0));
+}
+
+size_t FrameArena::reservedBytes() const
+{
+    size_t bytes = 0;
+    for (auto& chunk : m_chunks)
+    {
+        bytes += chunk->m_size;
+    }
+    return bytes;
+}
+
+void FrameArena::advanceChunk(size_t min_size)
+{
+    const unsigned next_index = m_currentChunkIndex + 1;
+    if ((next_index >= m_chunks.size()) || (m_chunks[next_index]->m_size < min_size))
+    {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->m_size = std::max(m_chunkSize, min_size);
+        chunk->m_memory = std::make_unique<unsigned char[]>(chunk->m_size);
+        chunk->m_offset.store(0, std::memory_order_relaxed);
+        m_chunks.insert(m_chunks.begin() + next_index, std::move(chunk));
+    }
+    m_currentChunkIndex = next_index;
+    m_currentChunk.store(m_chunks[next_index].get(), std::memory_order_release);
+}
+
+FrameArenaRing::FrameArenaRing(size_t chunk_size) : m_chunkSize(chunk_size), m_currentIndex(0), m_escapedArenaCount(0)
+{
+    m_arenas[0] = std::make_unique<FrameArena>(m_chunkSize);
+    m_arenas[1] = std::make_unique<FrameArena>(m_chunkSize);
+}
+
+FrameArenaRing::~FrameArenaRing()
+{
+    deactivate();
+    releaseRetiredArenas();
+    // 還有 message 活著 (例如 event queue 還沒清), 記憶體就不還了, 避免它們釋放時碰到已刪掉的 arena
+    for (auto& arena : m_arenas)
+    {
+        if (arena->liveAllocationCount() > 0) arena.release();
+    }
+    for (auto& arena : m_retiredArenas)
+    {
+        arena.release();
+    }
+}
+
+void FrameArenaRing::advanceFrame()
+{
+    releaseRetiredArenas();
+    const unsigned next_index = 1 - m_currentIndex;
+    if (const unsigned live_count = m_arenas[next_index]->liveAllocationCount(); live_count > 0)
+    {
+        // release build 也要看得到, 否則 arena 一直被換掉而沒人知道
+        LOG(Error, Platforms::Logger::Printf("frame arena : %u messages are kept beyond their frame", live_count));
+        assert(!"frame arena : message is kept beyond its frame");
+        m_escapedArenaCount++;
+        m_retiredArenas.emplace_back(std::move(m_arenas[next_index]));
+        m_arenas[next_index] = std::make_unique<FrameArena>(m_chunkSize);
+    }
+    else
+    {
+        m_arenas[next_index]->reset();
+    }
+    m_currentIndex = next_index;
+    FrameArena::m_currentArena.store(m_arenas[m_currentIndex].get(), std::memory_order_release);
+}
+
+void FrameArenaRing::deactivate()
+{
+    for (auto& arena : m_arenas)
+    {
+        FrameArena* expected = arena.get();
+        FrameArena::m_currentArena.compare_exchange_strong(expected, nullptr);
+    }
+}
+
+void FrameArenaRing::releaseRetiredArenas()
+{
+    m_retiredArenas.erase(std::remove_if(m_retiredArenas.begin(), m_retiredArenas.end(),
+        [](const std::unique_ptr<FrameArena>& arena) { return arena->liveAllocationCount() == 0; }), m_retiredArenas.end());
+}
@@ -0,0 +1,211 @@
+﻿/*********************************************************************
+ * \file   FrameArena.h
+ * \brief  frame scoped linear allocator, 給 post 後只活一兩個 frame 的
+ *         events, commands 用, 整批 reset, 不走 global heap
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _FRAME_ARENA_H
+#define _FRAME_ARENA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Enigma::Frameworks
+{
+    class FrameArena
+    {
+    public:
+        static constexpr size_t Alignment = alignof(std::max_align_t);
+        static constexpr size_t DefaultChunkSize = 256 * 1024;
+        /// 每個執行緒一次從 chunk 拿一塊, 塊內 bump 不需要 atomic
+        static constexpr size_t ThreadBlockSize = 4 * 1024;
+
+    public:
+        FrameArena(size_t chunk_size = DefaultChunkSize);
+        FrameArena(const FrameArena&) = delete;
+        FrameArena(FrameArena&&) = delete;
+        ~FrameArena();
+        FrameArena& operator=(const FrameArena&) = delete;
+        FrameArena& operator=(FrameArena&&) = delete;
+
+        /** 目前 frame 的 arena, 沒有 service manager 在跑 frame 時是 nullptr */
+        static FrameArena* current();
+
+        /** thread safe, 在執行緒自己的 block 裡 bump, 計數也是執行緒自己的, 都不需要 atomic 指令;
+            block 用完才碰 chunk 的 atomic offset, chunk 用完才拿鎖 */
+        void* allocate(size_t size);
+        /** 只減 live count (debug 時把內容 poison 掉); 剛好是這個執行緒最後配置的那塊就退回去重複使用,
+            執行緒目前綁在別的 arena (例如釋放上個 frame 的 message) 時才用 atomic 減 */
+        void deallocate(void* p, size_t size);
+        /** 所有 allocation 都 deallocate 之後才可以 reset, chunks 保留重複使用 */
+        void reset();
+
+        /** 所有執行緒計數的總和, frame 之間 (沒有人在配置) 才準 */
+        unsigned liveAllocationCount() const;
+        size_t reservedBytes() const;
+
+    protected:
+        friend class FrameArenaRing;
+
+        struct Chunk
+        {
+            std::unique_ptr<unsigned char[]> m_memory;
+            size_t m_size;
+            std::atomic<size_t> m_offset;
+        };
+        /** 只有擁有的執行緒會寫 (load + store, 不是 read-modify-write), 其他執行緒只在 frame 之間加總 */
+        struct ThreadCounter
+        {
+            std::atomic<std::int64_t> m_count{ 0 };
+            void add(std::int64_t n) { m_count.store(m_count.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+        };
+        /** 執行緒目前綁定的 arena (與 generation), 綁定中的 block 與計數 */
+        struct ThreadBinding
+        {
+            const FrameArena* m_arena = nullptr;
+            std::uint64_t m_generation = 0;
+            ThreadCounter* m_counter = nullptr;
+            unsigned char* m_cursor = nullptr;
+            unsigned char* m_end = nullptr;
+        };
+
+        static size_t alignedSize(size_t size) { return (std::max(size, static_cast<size_t>(1)) + Alignment - 1) & ~(Alignment - 1); }
+        bool isBoundToThisThread() const
+        {
+            return (m_threadBinding.m_arena == this) && (m_threadBinding.m_generation == m_generation.load(std::memory_order_relaxed));
+        }
+        /** 執行緒還沒綁定這個 arena, 或 block 不夠用 */
+        void* allocateSlow(size_t size);
+        void deallocateRemote(void* p, size_t size);
+        /** 從 chunk 拿一塊給目前執行緒 */
+        void* allocateBlock(size_t block_size);
+        /** chunk 用完, 換下一個 (已經有的就重複用), 在 m_chunkLock 中呼叫 */
+        void advanceChunk(size_t min_size);
+
+    protected:
+        /// 釋放 / reset 後的記憶體在 debug 時填上固定值, 還在用的人比較快出事
+        static constexpr unsigned char FreedPoison = 0xdd;
+        static constexpr unsigned char ResetPoison = 0xcd;
+
+        static std::atomic<FrameArena*> m_currentArena;
+        static std::atomic<std::uint64_t> m_nextGeneration;
+        static thread_local ThreadBinding m_threadBinding;
+
+        size_t m_chunkSize;
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+        unsigned m_currentChunkIndex;
+        std::atomic<Chunk*> m_currentChunk;
+        mutable std::mutex m_chunkLock;
+        /// 綁定過這個 arena 的執行緒各一個, reset 時清掉
+        std::vector<std::unique_ptr<ThreadCounter>> m_threadCounters;
+        /// 沒有綁定這個 arena 的執行緒釋放時減這個
+        std::atomic<std::int64_t> m_remoteCount;
+        /// 每次 reset 換一個 (所有 arena 不重複), 執行緒手上舊的 block 與計數就作廢
+        std::atomic<std::uint64_t> m_generation;
+    };
+
+    inline void* FrameArena::allocate(size_t size)
+    {
+        // 大小對齊 Alignment, chunk 起點也對齊, 每個 allocation 都對齊
+        size = alignedSize(size);
+        if ((isBoundToThisThread()) && (static_cast<size_t>(m_threadBinding.m_end - m_threadBinding.m_cursor) >= size))
+        {
+            unsigned char* p = m_threadBinding.m_cursor;
+            m_threadBinding.m_cursor += size;
+            m_threadBinding.m_counter->add(1);
+            return p;
+        }
+        return allocateSlow(size);
+    }
+
+    inline void FrameArena::deallocate(void* p, size_t size)
+    {
+        if (!p) return;
+        if (!isBoundToThisThread())
+        {
+            deallocateRemote(p, size);
+            return;
+        }
+        size = alignedSize(size);
+#if !defined(NDEBUG)
+        std::memset(p, FreedPoison, size);
+#endif
+        // 最後配置的那塊馬上就還回來 (dispatch 完就丟的 message), cursor 退回去, 下一個 message 用同一塊 (還在 cache 裡)
+        if (static_cast<unsigned char*>(p) + size == m_threadBinding.m_cursor) m_threadBinding.m_cursor = static_cast<unsigned char*>(p);
+        m_threadBinding.m_counter->add(-1);
+    }
+
+    /** std allocator, 給 std::allocate_shared 用, control block 與 message 配在同一塊 */
+    template <class T>
+    class FrameArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit FrameArenaAllocator(FrameArena* arena) noexcept : m_arena(arena) {}
+        template <class U>
+        FrameArenaAllocator(const FrameArenaAllocator<U>& other) noexcept : m_arena(other.arena()) {}
+
+        T* allocate(std::size_t n)
+        {
+            static_assert(alignof(T) <= FrameArena::Alignment, "over aligned type can't use frame arena");
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T)));
+        }
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            m_arena->deallocate(p, n * sizeof(T));
+        }
+
+        FrameArena* arena() const noexcept { return m_arena; }
+
+        template <class U>
+        bool operator==(const FrameArenaAllocator<U>& other) const noexcept { return m_arena == other.arena(); }
+        template <class U>
+        bool operator!=(const FrameArenaAllocator<U>& other) const noexcept { return m_arena != other.arena(); }
+
+    protected:
+        FrameArena* m_arena;
+    };
+
+    /** service manager 持有, 每個 frame 開始時輪替,
+        frame N post 的 message 在 frame N+1 才被處理, 所以 arena 要留兩個 frame 才 reset */
+    class FrameArenaRing
+    {
+    public:
+        FrameArenaRing(size_t chunk_size = FrameArena::DefaultChunkSize);
+        FrameArenaRing(const FrameArenaRing&) = delete;
+        FrameArenaRing(FrameArenaRing&&) = delete;
+        ~FrameArenaRing();
+        FrameArenaRing& operator=(const FrameArenaRing&) = delete;
+        FrameArenaRing& operator=(FrameArenaRing&&) = delete;
+
+        /** 兩個 frame 前的 arena reset 後變成 current;
+            還有 message 活著 (被留下來了) 就 log error (debug 還會 assert), 那個 arena 改成等全部釋放後再丟 */
+        void advanceFrame();
+        /** 不是在跑 frame (初始化中, message 可能放很多個 frame), current 設成 nullptr, message 改走 heap */
+        void deactivate();
+
+        const FrameArena* currentArena() const { return m_arenas[m_currentIndex].get(); }
+        /// message 活超過兩個 frame 而無法 reset 的次數
+        std::uint64_t escapedArenaCount() const { return m_escapedArenaCount; }
+
+    protected:
+        void releaseRetiredArenas();
+
+    protected:
+        size_t m_chunkSize;
+        std::unique_ptr<FrameArena> m_arenas[2];
+        unsigned m_currentIndex;
+        std::vector<std::unique_ptr<FrameArena>> m_retiredArenas;
+        std::uint64_t m_escapedArenaCount;
+    };
+}
+
+#endif // _FRAME_ARENA_H
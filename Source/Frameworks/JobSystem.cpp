@@ -0,0 +1,352 @@
+﻿#include "JobSystem.h"
+#include "Platforms/Profiler.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::Frameworks;
+
+/// 自動切 batch 時, 每個執行緒分到的 batch 數, 多切幾份讓先做完的執行緒可以偷
+constexpr unsigned BATCHES_PER_PARTICIPANT = 4;
+
+struct JobSystem::PendingJob
+{
+    Job m_job;
+    std::atomic<unsigned> m_remainingDependencies;
+};
+
+namespace
+{
+    struct WorkerThreadRecord
+    {
+        const JobSystem* m_jobSystem = nullptr;
+        unsigned m_queueIndex = 0;
+    };
+    thread_local WorkerThreadRecord t_workerRecord;
+}
+
+JobSystem* JobSystem::m_thisJobSystem = nullptr;
+
+JobSystem::JobSystem(unsigned worker_count, ExecutionMode mode) : m_mode(mode), m_mainThreadId(std::this_thread::get_id()),
+    m_queuedJobCount(0), m_sleepingWorkerCount(0), m_isStopping(false), m_hasTimingHook(false), m_executedJobCount(0), m_stolenJobCount(0)
+{
+    assert(m_thisJobSystem == nullptr);
+    m_thisJobSystem = this;
+    if (m_mode == ExecutionMode::Deterministic)
+    {
+        worker_count = 0;
+    }
+    else if (worker_count == 0)
+    {
+        const unsigned hardware_count = std::thread::hardware_concurrency();
+        worker_count = hardware_count > 1 ? hardware_count - 1 : 1;
+    }
+    // queues 要在 worker 開始前準備好
+    m_queues.reserve(worker_count + 1);
+    for (unsigned i = 0; i < worker_count + 1; i++)
+    {
+        m_queues.emplace_back(std::make_unique<JobQueue>());
+    }
+    m_workers.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; i++)
+    {
+        m_workers.emplace_back([this, i]() { workerProcedure(i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard locker{ m_wakeLock };
+        m_isStopping = true;
+    }
+    m_wakeSignal.notify_all();
+    for (auto& worker : m_workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+    m_thisJobSystem = nullptr;
+}
+
+JobSystem* JobSystem::instance()
+{
+    return m_thisJobSystem;
+}
+
+JobCounterPtr JobSystem::schedule(const char* name, const JobFunction& fn, const std::vector<JobCounterPtr>& depends_on, JobAffinity affinity)
+{
+    auto counter = std::make_shared<JobCounter>();
+    schedule(counter, name, fn, depends_on, affinity);
+    return counter;
+}
+
+void JobSystem::schedule(const JobCounterPtr& counter, const char* name, const JobFunction& fn, const std::vector<JobCounterPtr>& depends_on, JobAffinity affinity)
+{
+    assert(counter);
+    // 先加 counter, 等待的人才不會在 job 還沒排進去前就看到歸零
+    counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    if (depends_on.empty())
+    {
+        enqueueReadyJob({ name, fn, counter, affinity });
+        return;
+    }
+    auto pending = std::make_shared<PendingJob>();
+    pending->m_job = { name, fn, counter, affinity };
+    // 多加一, 所有 dependency 都掛好之後才放掉, 避免掛到一半就被執行
+    pending->m_remainingDependencies.store(static_cast<unsigned>(depends_on.size()) + 1, std::memory_order_relaxed);
+    for (auto& dependency : depends_on)
+    {
+        bool is_done = true;
+        if (dependency)
+        {
+            std::lock_guard locker{ dependency->m_continuationLock };
+            if (!dependency->isDone())
+            {
+                dependency->m_continuations.emplace_back(pending);
+                is_done = false;
+            }
+        }
+        if (is_done) releaseContinuation(pending);
+    }
+    releaseContinuation(pending);
+}
+
+JobCounterPtr JobSystem::scheduleParallelFor(const char* name, unsigned count, const RangeFunction& fn, unsigned min_batch_size, const std::vector<JobCounterPtr>& depends_on)
+{
+    auto counter = std::make_shared<JobCounter>();
+    if (count == 0) return counter;
+    const unsigned batch_size = batchSizeFor(count, min_batch_size);
+    // 所有 batch 共用一份 function, 不要每個 job 都複製 capture
+    auto shared_fn = std::make_shared<RangeFunction>(fn);
+    for (unsigned begin = 0; begin < count; begin += batch_size)
+    {
+        const unsigned end = std::min(count, begin + batch_size);
+        schedule(counter, name, [shared_fn, begin, end]() { (*shared_fn)(begin, end); }, depends_on);
+    }
+    return counter;
+}
+
+void JobSystem::parallelFor(const char* name, unsigned count, const RangeFunction& fn, unsigned min_batch_size)
+{
+    if (count == 0) return;
+    if (batchSizeFor(count, min_batch_size) >= count)
+    {
+        // 只有一個 batch, 不用排程
+        fn(0, count);
+        return;
+    }
+    wait(scheduleParallelFor(name, count, fn, min_batch_size));
+}
+
+unsigned JobSystem::batchSizeFor(unsigned count, unsigned min_batch_size) const
+{
+    const unsigned target_batch_count = participantCount() * BATCHES_PER_PARTICIPANT;
+    const unsigned batch_size = (count + target_batch_count - 1) / target_batch_count;
+    return std::max({ batch_size, min_batch_size, 1u });
+}
+
+void JobSystem::wait(const JobCounterPtr& counter)
+{
+    if (!counter) return;
+    const unsigned queue_index = currentQueueIndex();
+    while (!counter->isDone())
+    {
+        if (tryRunOneJob(queue_index)) continue;
+        if (m_mode == ExecutionMode::Deterministic)
+        {
+            // 沒有別的執行緒會來完成它, 一定是 dependency 沒有排進來
+            assert(!"deterministic job system : waiting counter can never be done");
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+unsigned JobSystem::runPendingJobs()
+{
+    assert(isMainThread());
+    unsigned executed_count = 0;
+    const unsigned queue_index = currentQueueIndex();
+    Job job;
+    if (m_mode == ExecutionMode::Deterministic)
+    {
+        while (popOwnJob(queue_index, job))
+        {
+            executeJob(job, queue_index);
+            executed_count++;
+        }
+    }
+    else
+    {
+        while (popMainThreadJob(job))
+        {
+            executeJob(job, queue_index);
+            executed_count++;
+        }
+    }
+    return executed_count;
+}
+
+void JobSystem::setJobTimingHook(const JobTimingHook& hook)
+{
+    m_timingHook = hook;
+    m_hasTimingHook.store(static_cast<bool>(hook), std::memory_order_release);
+}
+
+void JobSystem::workerProcedure(unsigned worker_index)
+{
+    t_workerRecord = { this, worker_index };
+    PROFILE_THREAD_NAME("JobWorker");
+    while (true)
+    {
+        if (tryRunOneJob(worker_index)) continue;
+        std::unique_lock locker{ m_wakeLock };
+        m_sleepingWorkerCount.fetch_add(1);
+        m_wakeSignal.wait(locker, [this]() { return m_isStopping || m_queuedJobCount.load() > 0; });
+        m_sleepingWorkerCount.fetch_sub(1);
+        if (m_isStopping && m_queuedJobCount.load() == 0) return;
+    }
+}
+
+unsigned JobSystem::currentQueueIndex() const
+{
+    if (t_workerRecord.m_jobSystem == this) return t_workerRecord.m_queueIndex;
+    return static_cast<unsigned>(m_queues.size()) - 1;
+}
+
+void JobSystem::enqueueReadyJob(Job&& job)
+{
+    // deterministic mode 全部都在同一條 queue, 才能照排入順序執行
+    if ((job.m_affinity == JobAffinity::MainThread) && (m_mode == ExecutionMode::Parallel))
+    {
+        std::lock_guard locker{ m_mainThreadJobs.m_lock };
+        m_mainThreadJobs.m_jobs.emplace_back(std::move(job));
+        return;
+    }
+    auto& queue = *m_queues[currentQueueIndex()];
+    {
+        std::lock_guard locker{ queue.m_lock };
+        queue.m_jobs.emplace_back(std::move(job));
+        m_queuedJobCount.fetch_add(1);
+    }
+    wakeWorker();
+}
+
+bool JobSystem::tryRunOneJob(unsigned queue_index)
+{
+    Job job;
+    if ((m_mode == ExecutionMode::Parallel) && (isMainThread()) && (popMainThreadJob(job)))
+    {
+        executeJob(job, queue_index);
+        return true;
+    }
+    if (popOwnJob(queue_index, job))
+    {
+        executeJob(job, queue_index);
+        return true;
+    }
+    if (stealJob(queue_index, job))
+    {
+        m_stolenJobCount.fetch_add(1, std::memory_order_relaxed);
+        executeJob(job, queue_index);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::popOwnJob(unsigned queue_index, Job& job)
+{
+    auto& queue = *m_queues[queue_index];
+    std::lock_guard locker{ queue.m_lock };
+    if (queue.m_jobs.empty()) return false;
+    if (m_mode == ExecutionMode::Deterministic)
+    {
+        job = std::move(queue.m_jobs.front());
+        queue.m_jobs.pop_front();
+    }
+    else
+    {
+        // 自己最後排的 job, data 還在 cache 裡
+        job = std::move(queue.m_jobs.back());
+        queue.m_jobs.pop_back();
+    }
+    m_queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::stealJob(unsigned queue_index, Job& job)
+{
+    const unsigned queue_count = static_cast<unsigned>(m_queues.size());
+    for (unsigned i = 1; i < queue_count; i++)
+    {
+        auto& queue = *m_queues[(queue_index + i) % queue_count];
+        std::lock_guard locker{ queue.m_lock };
+        if (queue.m_jobs.empty()) continue;
+        // 偷最早排的, 通常是比較大塊的工作
+        job = std::move(queue.m_jobs.front());
+        queue.m_jobs.pop_front();
+        m_queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::popMainThreadJob(Job& job)
+{
+    std::lock_guard locker{ m_mainThreadJobs.m_lock };
+    if (m_mainThreadJobs.m_jobs.empty()) return false;
+    job = std::move(m_mainThreadJobs.m_jobs.front());
+    m_mainThreadJobs.m_jobs.pop_front();
+    return true;
+}
+
+void JobSystem::executeJob(Job& job, unsigned queue_index)
+{
+    PROFILE_ZONE(job.m_name);
+    if (m_hasTimingHook.load(std::memory_order_acquire))
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+        job.m_function();
+        m_timingHook({ job.m_name, queue_index, start_time, std::chrono::steady_clock::now() - start_time });
+    }
+    else
+    {
+        job.m_function();
+    }
+    m_executedJobCount.fetch_add(1, std::memory_order_relaxed);
+    completeCounter(job.m_counter);
+    job.m_counter = nullptr;
+}
+
+void JobSystem::completeCounter(const JobCounterPtr& counter)
+{
+    if (counter->m_count.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    std::vector<std::shared_ptr<PendingJob>> continuations;
+    {
+        std::lock_guard locker{ counter->m_continuationLock };
+        // 歸零之後又有 job 加進同一個 group, 就等那些 job 做完再放
+        if (!counter->isDone()) return;
+        continuations.swap(counter->m_continuations);
+    }
+    for (auto& pending : continuations)
+    {
+        releaseContinuation(pending);
+    }
+}
+
+void JobSystem::releaseContinuation(const std::shared_ptr<PendingJob>& pending)
+{
+    if (pending->m_remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    enqueueReadyJob(std::move(pending->m_job));
+}
+
+void JobSystem::wakeWorker()
+{
+    // 沒有 worker 在睡就不用碰鎖, sleeping count 與 queued count 都是 seq_cst, 兩邊至少有一邊看得到對方
+    if (m_sleepingWorkerCount.load() == 0) return;
+    // 拿一下鎖, worker 檢查完 predicate 到睡著之間不會漏掉通知
+    {
+        std::lock_guard locker{ m_wakeLock };
+    }
+    m_wakeSignal.notify_one();
+}
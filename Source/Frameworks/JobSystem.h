@@ -0,0 +1,176 @@
+﻿/*********************************************************************
+ * \file   JobSystem.h
+ * \brief  work stealing job system, 每個 worker 一條 deque,
+ *         自己的 job 從尾端拿 (LIFO), 閒著的 worker 從別人的頭端偷 (FIFO)
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Enigma::Frameworks
+{
+    class JobCounter;
+    using JobCounterPtr = std::shared_ptr<JobCounter>;
+
+    class JobSystem
+    {
+    public:
+        using JobFunction = std::function<void()>;
+        /// batch range [begin, end)
+        using RangeFunction = std::function<void(unsigned begin, unsigned end)>;
+
+        enum class ExecutionMode
+        {
+            Parallel,
+            Deterministic,  ///< 不開 worker thread, 所有 job 都在 wait / runPendingJobs 的執行緒上依排入順序執行, 測試用
+        };
+        enum class JobAffinity
+        {
+            AnyThread,
+            MainThread,  ///< 只在 main thread (建立 job system 的執行緒) 上執行
+        };
+        struct JobTiming
+        {
+            const char* m_name;
+            unsigned m_threadIndex;  ///< worker index, main thread 是 workerCount()
+            std::chrono::steady_clock::time_point m_startTime;
+            std::chrono::steady_clock::duration m_duration;
+        };
+        using JobTimingHook = std::function<void(const JobTiming&)>;
+
+    public:
+        /** worker_count == 0 : hardware concurrency - 1, deterministic mode 不開 worker */
+        JobSystem(unsigned worker_count, ExecutionMode mode = ExecutionMode::Parallel);
+        JobSystem(const JobSystem&) = delete;
+        JobSystem(JobSystem&&) = delete;
+        ~JobSystem();
+        JobSystem& operator=(const JobSystem&) = delete;
+        JobSystem& operator=(JobSystem&&) = delete;
+
+        static JobSystem* instance();
+
+        ExecutionMode executionMode() const { return m_mode; }
+        unsigned workerCount() const { return static_cast<unsigned>(m_workers.size()); }
+        /// workers + main thread
+        unsigned participantCount() const { return workerCount() + 1; }
+        bool isMainThread() const { return std::this_thread::get_id() == m_mainThreadId; }
+
+        /** 新的 job, depends_on 中的 counter 都歸零後才開始執行, 完成時回傳的 counter 歸零
+            @param name : 字串常數, timing hook 用, 不會被複製 */
+        JobCounterPtr schedule(const char* name, const JobFunction& fn,
+            const std::vector<JobCounterPtr>& depends_on = {}, JobAffinity affinity = JobAffinity::AnyThread);
+        /** 加到已有的 counter (job group) */
+        void schedule(const JobCounterPtr& counter, const char* name, const JobFunction& fn,
+            const std::vector<JobCounterPtr>& depends_on = {}, JobAffinity affinity = JobAffinity::AnyThread);
+
+        /** [0, count) 切成 batches 分給各執行緒, batch 大小依執行緒數自動決定
+            @param min_batch_size : batch 最少的 item 數, 每個 item 工作很少時用來壓低排程成本 */
+        JobCounterPtr scheduleParallelFor(const char* name, unsigned count, const RangeFunction& fn,
+            unsigned min_batch_size = 0, const std::vector<JobCounterPtr>& depends_on = {});
+        /** blocking parallel for, 呼叫的執行緒也會一起做 */
+        void parallelFor(const char* name, unsigned count, const RangeFunction& fn, unsigned min_batch_size = 0);
+        /** 自動決定的 batch size */
+        unsigned batchSizeFor(unsigned count, unsigned min_batch_size) const;
+
+        /** 等 counter 歸零, 等的時候呼叫的執行緒也會拿 job 來做 (main thread 也會做 main thread jobs) */
+        void wait(const JobCounterPtr& counter);
+        /** main thread 每個 frame 呼叫, 把 main thread jobs 做完 (deterministic mode 是把所有 ready jobs 做完)
+            @return 執行的 job 數 */
+        unsigned runPendingJobs();
+
+        /** 每個 job 執行完呼叫 hook, 會在各個執行緒上被呼叫, 要 thread safe,
+            在沒有 job 執行的時候設定, nullptr 關掉 */
+        void setJobTimingHook(const JobTimingHook& hook);
+
+        std::uint64_t executedJobCount() const { return m_executedJobCount; }
+        std::uint64_t stolenJobCount() const { return m_stolenJobCount; }
+
+    protected:
+        struct Job
+        {
+            const char* m_name;
+            JobFunction m_function;
+            JobCounterPtr m_counter;
+            JobAffinity m_affinity;
+        };
+        struct JobQueue
+        {
+            std::mutex m_lock;
+            std::deque<Job> m_jobs;
+        };
+        struct PendingJob;
+        friend class JobCounter;
+
+        void workerProcedure(unsigned worker_index);
+        /** 自己的 queue index, 非 worker 執行緒都用 main queue */
+        unsigned currentQueueIndex() const;
+
+        void enqueueReadyJob(Job&& job);
+        bool tryRunOneJob(unsigned queue_index);
+        bool popOwnJob(unsigned queue_index, Job& job);
+        bool stealJob(unsigned queue_index, Job& job);
+        bool popMainThreadJob(Job& job);
+        void executeJob(Job& job, unsigned queue_index);
+        void completeCounter(const JobCounterPtr& counter);
+        void releaseContinuation(const std::shared_ptr<PendingJob>& pending);
+        void wakeWorker();
+
+    protected:
+        static JobSystem* m_thisJobSystem;
+
+        ExecutionMode m_mode;
+        std::thread::id m_mainThreadId;
+        std::vector<std::thread> m_workers;
+        std::vector<std::unique_ptr<JobQueue>> m_queues;  ///< 每個 worker 一條, 最後一條是 main thread (和其他外部執行緒) 的
+        JobQueue m_mainThreadJobs;  ///< main thread affinity jobs, 不讓 worker 偷
+
+        std::atomic<unsigned> m_queuedJobCount;  ///< m_queues 中的 job 數, worker 睡覺的依據
+        std::atomic<unsigned> m_sleepingWorkerCount;
+        std::mutex m_wakeLock;
+        std::condition_variable m_wakeSignal;
+        bool m_isStopping;
+
+        std::atomic<bool> m_hasTimingHook;
+        JobTimingHook m_timingHook;
+
+        std::atomic<std::uint64_t> m_executedJobCount;
+        std::atomic<std::uint64_t> m_stolenJobCount;
+    };
+
+    /** job 完成計數, schedule 時加一, job 做完減一, 歸零就是這批 job 都完成了,
+        同一個 counter 可以掛多個 job 當作一個 group */
+    class JobCounter
+    {
+    public:
+        JobCounter() : m_count(0) {};
+        JobCounter(const JobCounter&) = delete;
+        JobCounter(JobCounter&&) = delete;
+        ~JobCounter() = default;
+        JobCounter& operator=(const JobCounter&) = delete;
+        JobCounter& operator=(JobCounter&&) = delete;
+
+        bool isDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+        unsigned remainingJobCount() const { return m_count.load(std::memory_order_acquire); }
+
+    protected:
+        friend class JobSystem;
+
+        std::atomic<unsigned> m_count;
+        std::mutex m_continuationLock;
+        std::vector<std::shared_ptr<JobSystem::PendingJob>> m_continuations;  ///< 等這個 counter 歸零的 jobs
+    };
+}
+
+#endif // _JOB_SYSTEM_H
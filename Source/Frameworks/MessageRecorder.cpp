@@ -0,0 +1,274 @@
+﻿#include "MessageRecorder.h"
+#include "ServiceManager.h"
+#include "EventPublisher.h"
+#include "CommandBus.h"
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+
+using namespace Enigma::Frameworks;
+
+/// 檔頭, 後面接版本
+constexpr const char* RECORDING_SIGNATURE = "EnigmaMessageRecording";
+constexpr unsigned RECORDING_VERSION = 1;
+/// toString 顯示的 payload 長度
+constexpr size_t PAYLOAD_PREVIEW_LENGTH = 32;
+
+namespace
+{
+    /** 字串存成 "長度:內容", type name 與 payload 裡可以有空白或換行 */
+    void writeSizedString(std::ostream& os, const std::string& str)
+    {
+        os << str.size() << ':';
+        os.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+
+    bool readSizedString(std::istream& is, std::string& str)
+    {
+        size_t size = 0;
+        char separator = 0;
+        if (!(is >> size) || !is.get(separator) || (separator != ':')) return false;
+        str.resize(size);
+        if (size > 0) is.read(str.data(), static_cast<std::streamsize>(size));
+        return static_cast<bool>(is);
+    }
+
+    const char* channelName(MessageChannel channel)
+    {
+        return channel == MessageChannel::Event ? "event" : "command";
+    }
+}
+
+bool RecordedMessage::operator==(const RecordedMessage& other) const
+{
+    return (m_frame == other.m_frame) && (m_channel == other.m_channel) && (m_typeName == other.m_typeName)
+        && (m_hasPayload == other.m_hasPayload) && (m_payload == other.m_payload);
+}
+
+std::string RecordedMessage::toString() const
+{
+    std::string str = std::string{ "frame " } + std::to_string(m_frame) + " " + channelName(m_channel) + " " + m_typeName;
+    if (!m_hasPayload) return str;
+    str += " [";
+    for (size_t i = 0; i < std::min(m_payload.size(), PAYLOAD_PREVIEW_LENGTH); i++)
+    {
+        const unsigned char c = static_cast<unsigned char>(m_payload[i]);
+        str += ((c >= 0x20) && (c < 0x7f)) ? static_cast<char>(c) : '.';
+    }
+    if (m_payload.size() > PAYLOAD_PREVIEW_LENGTH) str += "...";
+    str += "]";
+    return str;
+}
+
+MessageRecording::MessageRecording() : m_frameCount(0)
+{
+}
+
+void MessageRecording::clear()
+{
+    m_messages.clear();
+    m_frameCount = 0;
+}
+
+void MessageRecording::save(std::ostream& os) const
+{
+    os << RECORDING_SIGNATURE << ' ' << RECORDING_VERSION << ' ' << m_frameCount << ' ' << m_messages.size() << '\n';
+    for (auto& message : m_messages)
+    {
+        os << message.m_frame << ' ' << (message.m_channel == MessageChannel::Event ? 'E' : 'C') << ' ';
+        writeSizedString(os, message.m_typeName);
+        os << ' ' << (message.m_hasPayload ? 'P' : '-') << ' ';
+        writeSizedString(os, message.m_payload);
+        os << '\n';
+    }
+}
+
+bool MessageRecording::save(const std::string& filepath) const
+{
+    std::ofstream file(filepath.c_str(), std::fstream::out | std::fstream::binary | std::fstream::trunc);
+    if (!file.is_open()) return false;
+    save(file);
+    return file.good();
+}
+
+bool MessageRecording::load(std::istream& is)
+{
+    clear();
+    std::string signature;
+    unsigned version = 0;
+    size_t message_count = 0;
+    if (!(is >> signature >> version >> m_frameCount >> message_count)) return false;
+    if ((signature != RECORDING_SIGNATURE) || (version != RECORDING_VERSION)) return false;
+    m_messages.reserve(message_count);
+    for (size_t i = 0; i < message_count; i++)
+    {
+        RecordedMessage message;
+        char channel = 0;
+        char payload_flag = 0;
+        if (!(is >> message.m_frame >> channel)) return false;
+        if (!readSizedString(is, message.m_typeName)) return false;
+        if (!(is >> payload_flag)) return false;
+        if (!readSizedString(is, message.m_payload)) return false;
+        if (((channel != 'E') && (channel != 'C')) || ((payload_flag != 'P') && (payload_flag != '-'))) return false;
+        message.m_channel = channel == 'E' ? MessageChannel::Event : MessageChannel::Command;
+        message.m_hasPayload = payload_flag == 'P';
+        m_messages.emplace_back(std::move(message));
+    }
+    return true;
+}
+
+bool MessageRecording::load(const std::string& filepath)
+{
+    std::ifstream file(filepath.c_str(), std::fstream::in | std::fstream::binary);
+    if (!file.is_open()) return false;
+    return load(file);
+}
+
+std::unordered_map<std::type_index, MessageCodecs::EventCodec> MessageCodecs::m_eventCodecs;
+std::unordered_map<std::string, std::type_index> MessageCodecs::m_eventCodecNames;
+std::unordered_map<std::type_index, MessageCodecs::CommandCodec> MessageCodecs::m_commandCodecs;
+std::unordered_map<std::string, std::type_index> MessageCodecs::m_commandCodecNames;
+
+void MessageCodecs::registerEvent(const std::type_info& ev_type, const std::string& name,
+    const EventSerializer& serializer, const EventDeserializer& deserializer)
+{
+    assert(serializer);
+    m_eventCodecs.insert_or_assign(std::type_index{ ev_type }, EventCodec{ name, serializer, deserializer });
+    m_eventCodecNames.insert_or_assign(name, std::type_index{ ev_type });
+}
+
+void MessageCodecs::registerCommand(const std::type_info& cmd_type, const std::string& name,
+    const CommandSerializer& serializer, const CommandDeserializer& deserializer)
+{
+    assert(serializer);
+    m_commandCodecs.insert_or_assign(std::type_index{ cmd_type }, CommandCodec{ name, serializer, deserializer });
+    m_commandCodecNames.insert_or_assign(name, std::type_index{ cmd_type });
+}
+
+void MessageCodecs::unregisterAll()
+{
+    m_eventCodecs.clear();
+    m_eventCodecNames.clear();
+    m_commandCodecs.clear();
+    m_commandCodecNames.clear();
+}
+
+RecordedMessage MessageCodecs::recordEvent(std::uint64_t frame, const IEventPtr& e)
+{
+    assert(e);
+    auto codec = m_eventCodecs.find(std::type_index{ e->typeInfo() });
+    if (codec == m_eventCodecs.end()) return { frame, MessageChannel::Event, e->typeInfo().name(), false, {} };
+    return { frame, MessageChannel::Event, codec->second.m_name, true, codec->second.m_serializer(e) };
+}
+
+RecordedMessage MessageCodecs::recordCommand(std::uint64_t frame, const ICommandPtr& c)
+{
+    assert(c);
+    auto codec = m_commandCodecs.find(std::type_index{ c->typeInfo() });
+    if (codec == m_commandCodecs.end()) return { frame, MessageChannel::Command, c->typeInfo().name(), false, {} };
+    return { frame, MessageChannel::Command, codec->second.m_name, true, codec->second.m_serializer(c) };
+}
+
+IEventPtr MessageCodecs::restoreEvent(const RecordedMessage& message)
+{
+    if ((message.m_channel != MessageChannel::Event) || (!message.m_hasPayload)) return nullptr;
+    auto name = m_eventCodecNames.find(message.m_typeName);
+    if (name == m_eventCodecNames.end()) return nullptr;
+    auto& codec = m_eventCodecs.at(name->second);
+    if (!codec.m_deserializer) return nullptr;
+    return codec.m_deserializer(message.m_payload);
+}
+
+ICommandPtr MessageCodecs::restoreCommand(const RecordedMessage& message)
+{
+    if ((message.m_channel != MessageChannel::Command) || (!message.m_hasPayload)) return nullptr;
+    auto name = m_commandCodecNames.find(message.m_typeName);
+    if (name == m_commandCodecNames.end()) return nullptr;
+    auto& codec = m_commandCodecs.at(name->second);
+    if (!codec.m_deserializer) return nullptr;
+    return codec.m_deserializer(message.m_payload);
+}
+
+MessageRecorder::HookGate::HookGate(MessageRecorder* recorder) : m_recorder(recorder), m_inFlightCount(0)
+{
+}
+
+MessageRecorder* MessageRecorder::HookGate::enter()
+{
+    std::lock_guard locker{ m_gateLock };
+    if (!m_recorder) return nullptr;
+    m_inFlightCount++;
+    return m_recorder;
+}
+
+void MessageRecorder::HookGate::leave()
+{
+    std::lock_guard locker{ m_gateLock };
+    assert(m_inFlightCount > 0);
+    if (--m_inFlightCount == 0) m_idleSignal.notify_all();
+}
+
+void MessageRecorder::HookGate::close()
+{
+    std::unique_lock locker{ m_gateLock };
+    m_recorder = nullptr;
+    m_idleSignal.wait(locker, [this]() { return m_inFlightCount == 0; });
+}
+
+MessageRecorder::MessageRecorder(ServiceManager* manager) : m_manager(manager), m_isRecording(false), m_startFrame(0)
+{
+    assert(m_manager);
+}
+
+MessageRecorder::~MessageRecorder()
+{
+    stop();
+}
+
+void MessageRecorder::start()
+{
+    stop();
+    m_recording.clear();
+    m_startFrame = m_manager->frameNumber();
+    m_isRecording = true;
+    // hook 只拿著 gate, recorder stop (或 destruct) 之後才被呼叫的 hook 不會碰到 recorder
+    m_hookGate = std::make_shared<HookGate>(this);
+    EventPublisher::setPostHook(std::make_shared<const EventHandler>([gate = m_hookGate](const IEventPtr& e)
+        {
+            auto recorder = gate->enter();
+            if (!recorder) return;
+            recorder->append(MessageCodecs::recordEvent(recorder->currentFrame(), e));
+            gate->leave();
+        }));
+    CommandBus::setPostHook(std::make_shared<const CommandHandler>([gate = m_hookGate](const ICommandPtr& c)
+        {
+            auto recorder = gate->enter();
+            if (!recorder) return;
+            recorder->append(MessageCodecs::recordCommand(recorder->currentFrame(), c));
+            gate->leave();
+        }));
+}
+
+void MessageRecorder::stop()
+{
+    if (!m_isRecording) return;
+    EventPublisher::setPostHook(nullptr);
+    CommandBus::setPostHook(nullptr);
+    // 其他執行緒的 post 可能還拿著 hook 在呼叫, 等進行中的 hook 結束才可以動 recording (或 destruct)
+    m_hookGate->close();
+    m_hookGate = nullptr;
+    std::lock_guard locker{ m_recordingLock };
+    m_recording.setFrameCount(currentFrame());
+    m_isRecording = false;
+}
+
+std::uint64_t MessageRecorder::currentFrame() const
+{
+    return m_manager->frameNumber() - m_startFrame;
+}
+
+void MessageRecorder::append(RecordedMessage&& message)
+{
+    std::lock_guard locker{ m_recordingLock };
+    m_recording.append(std::move(message));
+}
@@ -0,0 +1,186 @@
+﻿/*********************************************************************
+ * \file   MessageRecorder.h
+ * \brief  記錄 event publisher, command bus 收到的每個 post (frame, type, payload),
+ *         存成檔案給 MessageReplayer 重播, 有註冊 codec 的 type 才存 payload
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _MESSAGE_RECORDER_H
+#define _MESSAGE_RECORDER_H
+
+#include "Event.h"
+#include "Command.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace Enigma::Frameworks
+{
+    class ServiceManager;
+
+    enum class MessageChannel : std::uint8_t
+    {
+        Event,
+        Command,
+    };
+
+    struct RecordedMessage
+    {
+        std::uint64_t m_frame;  ///< 從開始記錄算起的 frame
+        MessageChannel m_channel;
+        std::string m_typeName;  ///< codec 註冊的名稱, 沒有 codec 就是 type_info::name (只在同一種 compiler 間可比)
+        bool m_hasPayload;
+        std::string m_payload;
+
+        bool operator==(const RecordedMessage& other) const;
+        bool operator!=(const RecordedMessage& other) const { return !(*this == other); }
+        std::string toString() const;
+    };
+
+    class MessageRecording
+    {
+    public:
+        MessageRecording();
+
+        const std::vector<RecordedMessage>& messages() const { return m_messages; }
+        /// 記錄期間經過的 frame 數, 重播要跑一樣多的 frame
+        std::uint64_t frameCount() const { return m_frameCount; }
+        void setFrameCount(std::uint64_t frame_count) { m_frameCount = frame_count; }
+
+        void append(RecordedMessage&& message) { m_messages.emplace_back(std::move(message)); }
+        void clear();
+
+        void save(std::ostream& os) const;
+        bool save(const std::string& filepath) const;
+        bool load(std::istream& is);
+        bool load(const std::string& filepath);
+
+    protected:
+        std::vector<RecordedMessage> m_messages;
+        std::uint64_t m_frameCount;
+    };
+
+    /** 要存 payload 的 event / command 在這裡註冊, payload 也會拿來比對;
+        有 deserializer 的 type 視為外部輸入: 重播時由 replayer 依記錄 post, 不可以再由 service 自己 post,
+        只有 serializer 的 type 只用來比對 (service 產生的結果) */
+    class MessageCodecs
+    {
+    public:
+        using EventSerializer = std::function<std::string(const IEventPtr&)>;
+        using EventDeserializer = std::function<IEventPtr(const std::string&)>;
+        using CommandSerializer = std::function<std::string(const ICommandPtr&)>;
+        using CommandDeserializer = std::function<ICommandPtr(const std::string&)>;
+
+        /** @param name : 跨 build 不變的名稱, 通常用 rtti name 的寫法
+            @param deserializer : 可以是空的, 不是外部輸入 */
+        static void registerEvent(const std::type_info& ev_type, const std::string& name,
+            const EventSerializer& serializer, const EventDeserializer& deserializer);
+        static void registerCommand(const std::type_info& cmd_type, const std::string& name,
+            const CommandSerializer& serializer, const CommandDeserializer& deserializer);
+        static void unregisterAll();
+
+        template <class T>
+        static void registerEvent(const std::string& name, const std::function<std::string(const T&)>& serializer,
+            const std::function<std::shared_ptr<T>(const std::string&)>& deserializer)
+        {
+            registerEvent(typeid(T), name,
+                [serializer](const IEventPtr& e) { return serializer(*std::static_pointer_cast<T, IEvent>(e)); },
+                deserializer ? EventDeserializer{ [deserializer](const std::string& payload) { return std::static_pointer_cast<IEvent, T>(deserializer(payload)); } } : nullptr);
+        }
+        template <class T>
+        static void registerCommand(const std::string& name, const std::function<std::string(const T&)>& serializer,
+            const std::function<std::shared_ptr<T>(const std::string&)>& deserializer)
+        {
+            registerCommand(typeid(T), name,
+                [serializer](const ICommandPtr& c) { return serializer(*std::static_pointer_cast<T, ICommand>(c)); },
+                deserializer ? CommandDeserializer{ [deserializer](const std::string& payload) { return std::static_pointer_cast<ICommand, T>(deserializer(payload)); } } : nullptr);
+        }
+
+        static RecordedMessage recordEvent(std::uint64_t frame, const IEventPtr& e);
+        static RecordedMessage recordCommand(std::uint64_t frame, const ICommandPtr& c);
+        /// 沒有註冊 deserializer 或 payload 無法還原時回傳 nullptr
+        static IEventPtr restoreEvent(const RecordedMessage& message);
+        static ICommandPtr restoreCommand(const RecordedMessage& message);
+
+    protected:
+        struct EventCodec
+        {
+            std::string m_name;
+            EventSerializer m_serializer;
+            EventDeserializer m_deserializer;
+        };
+        struct CommandCodec
+        {
+            std::string m_name;
+            CommandSerializer m_serializer;
+            CommandDeserializer m_deserializer;
+        };
+
+        static std::unordered_map<std::type_index, EventCodec> m_eventCodecs;
+        static std::unordered_map<std::string, std::type_index> m_eventCodecNames;
+        static std::unordered_map<std::type_index, CommandCodec> m_commandCodecs;
+        static std::unordered_map<std::string, std::type_index> m_commandCodecNames;
+    };
+
+    /** 掛在 event publisher 與 command bus 的 post hook 上, 同時只能有一個 recorder 在記錄,
+        start / stop 要在 frame 之間呼叫, 才會剛好記錄完整的 frame;
+        stop 會等其他執行緒上還在跑的 hook 結束 */
+    class MessageRecorder
+    {
+    public:
+        MessageRecorder(ServiceManager* manager);
+        MessageRecorder(const MessageRecorder&) = delete;
+        MessageRecorder(MessageRecorder&&) = delete;
+        ~MessageRecorder();
+        MessageRecorder& operator=(const MessageRecorder&) = delete;
+        MessageRecorder& operator=(MessageRecorder&&) = delete;
+
+        /** 清掉之前的記錄, 從目前的 frame 開始記錄 */
+        void start();
+        void stop();
+        bool isRecording() const { return m_isRecording; }
+
+        /** stop 之後再讀 */
+        const MessageRecording& recording() const { return m_recording; }
+
+    protected:
+        /** hook 與 recorder 共用; close 之後才進來的 hook 直接略過, close 會等進行中的 hook 結束 */
+        class HookGate
+        {
+        public:
+            HookGate(MessageRecorder* recorder);
+
+            /** @return nullptr : 已經 close */
+            MessageRecorder* enter();
+            void leave();
+            void close();
+
+        protected:
+            std::mutex m_gateLock;
+            std::condition_variable m_idleSignal;
+            MessageRecorder* m_recorder;
+            unsigned m_inFlightCount;
+        };
+
+        std::uint64_t currentFrame() const;
+        void append(RecordedMessage&& message);
+
+    protected:
+        ServiceManager* m_manager;
+        bool m_isRecording;
+        std::uint64_t m_startFrame;
+        std::mutex m_recordingLock;  ///< 任何執行緒都可能 post
+        std::shared_ptr<HookGate> m_hookGate;
+        MessageRecording m_recording;
+    };
+}
+
+#endif // _MESSAGE_RECORDER_H
@@ -0,0 +1,107 @@
+﻿#include "MessageReplayer.h"
+#include "ServiceManager.h"
+#include "EventPublisher.h"
+#include "CommandBus.h"
+#include "Timer.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+using namespace Enigma::Frameworks;
+
+std::string MessageReplayer::Divergence::toString() const
+{
+    std::string str = "message " + std::to_string(m_index) + " : expected ";
+    str += m_expected ? m_expected->toString() : std::string{ "nothing" };
+    str += ", replayed ";
+    str += m_actual ? m_actual->toString() : std::string{ "nothing" };
+    return str;
+}
+
+MessageReplayer::MessageReplayer(ServiceManager* manager, const MessageRecording& recording) : m_manager(manager), m_recording(recording),
+    m_recorder(manager), m_timer(nullptr), m_frameStep(0.0f), m_replayTime(0.0)
+{
+    assert(m_manager);
+}
+
+MessageReplayer::~MessageReplayer()
+{
+}
+
+void MessageReplayer::setFixedStepTimer(Timer* timer, float frame_step)
+{
+    m_timer = timer;
+    m_frameStep = frame_step;
+}
+
+bool MessageReplayer::run()
+{
+    m_divergence.reset();
+    m_frameTimes.clear();
+    m_frameTimes.reserve(static_cast<size_t>(m_recording.frameCount()));
+    bool was_stepped = false;
+    float last_frame_step = 0.0f;
+    if (m_timer)
+    {
+        was_stepped = m_timer->isStepped();
+        last_frame_step = m_timer->getFrameStep();
+        m_timer->setFrameStep(true, m_frameStep);
+    }
+
+    m_recorder.start();
+    const auto start_time = std::chrono::steady_clock::now();
+    // 開始記錄前 (frame 0) post 的輸入, 在第一個 runOnce 之前送
+    size_t index = postInputs(0, 0);
+    for (std::uint64_t frame = 1; frame <= m_recording.frameCount(); frame++)
+    {
+        const auto frame_start_time = std::chrono::steady_clock::now();
+        m_manager->runOnce();
+        index = postInputs(frame, index);
+        m_frameTimes.emplace_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start_time).count());
+    }
+    m_replayTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    m_recorder.stop();
+
+    if (m_timer) m_timer->setFrameStep(was_stepped, last_frame_step);
+    findDivergence();
+    return !m_divergence.has_value();
+}
+
+size_t MessageReplayer::postInputs(std::uint64_t frame, size_t index)
+{
+    auto& messages = m_recording.messages();
+    for (; (index < messages.size()) && (messages[index].m_frame <= frame); index++)
+    {
+        if (!messages[index].m_hasPayload) continue;
+        if (messages[index].m_channel == MessageChannel::Event)
+        {
+            if (auto e = MessageCodecs::restoreEvent(messages[index])) EventPublisher::post(e);
+        }
+        else
+        {
+            if (auto c = MessageCodecs::restoreCommand(messages[index])) CommandBus::post(c);
+        }
+    }
+    return index;
+}
+
+void MessageReplayer::findDivergence()
+{
+    auto& expected = m_recording.messages();
+    auto& actual = m_recorder.recording().messages();
+    const size_t common_count = std::min(expected.size(), actual.size());
+    for (size_t i = 0; i < common_count; i++)
+    {
+        if (expected[i] == actual[i]) continue;
+        m_divergence = Divergence{ i, expected[i], actual[i] };
+        return;
+    }
+    if (expected.size() > common_count)
+    {
+        m_divergence = Divergence{ common_count, expected[common_count], std::nullopt };
+    }
+    else if (actual.size() > common_count)
+    {
+        m_divergence = Divergence{ common_count, std::nullopt, actual[common_count] };
+    }
+}
@@ -0,0 +1,76 @@
+﻿/*********************************************************************
+ * \file   MessageReplayer.h
+ * \brief  把 MessageRecorder 的記錄餵回 headless service manager,
+ *         固定 frame step, 跑完後與記錄比對, 回報第一個不一樣的 message
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _MESSAGE_REPLAYER_H
+#define _MESSAGE_REPLAYER_H
+
+#include "MessageRecorder.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Enigma::Frameworks
+{
+    class ServiceManager;
+    class Timer;
+
+    /** 有註冊 deserializer 的 message 當作外部輸入, 在記錄時的 frame 結束後 post 回去 (跟原本 app 在 frame 之間 post 的時機一樣),
+        其他 message 由 service 自己產生, 只拿來比對 (有 serializer 的連 payload 一起比);
+        記錄時 service manager 要是循序 tick (沒有 job system 或 deterministic mode), 順序才比得起來 */
+    class MessageReplayer
+    {
+    public:
+        struct Divergence
+        {
+            size_t m_index;  ///< 第一個不一樣的 message 在記錄中的位置
+            std::optional<RecordedMessage> m_expected;  ///< 沒有值: 重播多出 message
+            std::optional<RecordedMessage> m_actual;  ///< 沒有值: 重播少了 message
+            std::string toString() const;
+        };
+
+    public:
+        /** @param manager : 已經註冊好與記錄時相同的 service, 並跑到 running */
+        MessageReplayer(ServiceManager* manager, const MessageRecording& recording);
+        MessageReplayer(const MessageReplayer&) = delete;
+        MessageReplayer(MessageReplayer&&) = delete;
+        ~MessageReplayer();
+        MessageReplayer& operator=(const MessageReplayer&) = delete;
+        MessageReplayer& operator=(MessageReplayer&&) = delete;
+
+        /** 重播時 timer 改成固定 step, 每個 frame 的 elapse time 都一樣; 結束後還原 */
+        void setFixedStepTimer(Timer* timer, float frame_step);
+
+        /** 跑完記錄的所有 frame, @return 沒有 divergence */
+        bool run();
+
+        const std::optional<Divergence>& divergence() const { return m_divergence; }
+        /// 重播時記錄到的 message, 可以存檔給下一個 build 比對
+        const MessageRecording& replayedRecording() const { return m_recorder.recording(); }
+        /// 重播的 wall time (秒), 只含 runOnce 與 post, 給不同 build 之間比較效能
+        double replayTime() const { return m_replayTime; }
+        const std::vector<double>& frameTimes() const { return m_frameTimes; }
+
+    protected:
+        /** post 記錄中這個 frame 的外部輸入, @return 下一個要看的 index */
+        size_t postInputs(std::uint64_t frame, size_t index);
+        void findDivergence();
+
+    protected:
+        ServiceManager* m_manager;
+        const MessageRecording& m_recording;
+        MessageRecorder m_recorder;
+
+        Timer* m_timer;
+        float m_frameStep;
+
+        std::optional<Divergence> m_divergence;
+        double m_replayTime;
+        std::vector<double> m_frameTimes;
+    };
+}
+
+#endif // _MESSAGE_REPLAYER_H
@@ -0,0 +1,130 @@
+﻿/*********************************************************************
+ * \file   RepositoryCachePolicy.h
+ * \brief  repository 的 LRU cache 記錄, 只管 key 的使用順序跟估計大小,
+ *         哪些 entry 可以 evict, 怎麼 evict, 由 repository 決定
+ *         (沒有 lock, 由 repository 的 lock 保護)
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef REPOSITORY_CACHE_POLICY_H
+#define REPOSITORY_CACHE_POLICY_H
+
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+namespace Enigma::Frameworks
+{
+    struct RepositoryCacheStatistics
+    {
+        std::uint64_t m_hitCount = 0;
+        std::uint64_t m_missCount = 0;  ///< 從 store mapper 載入的次數
+        std::uint64_t m_evictionCount = 0;
+        std::size_t m_cachedBytes = 0;
+        std::size_t m_budgetBytes = 0;
+        unsigned m_entryCount = 0;
+    };
+
+    template <class Key, class Hash> class RepositoryCachePolicy
+    {
+    public:
+        RepositoryCachePolicy() : m_budgetBytes(0), m_cachedBytes(0) {}
+        RepositoryCachePolicy(const RepositoryCachePolicy&) = delete;
+        RepositoryCachePolicy(RepositoryCachePolicy&&) = delete;
+        ~RepositoryCachePolicy() = default;
+        RepositoryCachePolicy& operator=(const RepositoryCachePolicy&) = delete;
+        RepositoryCachePolicy& operator=(RepositoryCachePolicy&&) = delete;
+
+        /** 0 : no budget, never evict */
+        std::size_t budgetBytes() const { return m_budgetBytes; }
+        void budgetBytes(std::size_t bytes) { m_budgetBytes = bytes; }
+        bool isOverBudget() const { return (m_budgetBytes > 0) && (m_cachedBytes > m_budgetBytes); }
+
+        /** entry 在 repository 中找到, 移到最近使用 */
+        void hit(const Key& key)
+        {
+            m_statistics.m_hitCount++;
+            auto it = m_entries.find(key);
+            if (it == m_entries.end()) return;
+            m_lruKeys.splice(m_lruKeys.begin(), m_lruKeys, it->second.m_lruIterator);
+        }
+        void miss() { m_statistics.m_missCount++; }
+
+        /** 新加入 (或大小改變) 的 entry, 視為最近使用 */
+        void track(const Key& key, std::size_t byte_size)
+        {
+            auto it = m_entries.find(key);
+            if (it != m_entries.end())
+            {
+                m_cachedBytes = m_cachedBytes - it->second.m_byteSize + byte_size;
+                it->second.m_byteSize = byte_size;
+                m_lruKeys.splice(m_lruKeys.begin(), m_lruKeys, it->second.m_lruIterator);
+                return;
+            }
+            m_lruKeys.push_front(key);
+            m_entries.emplace(key, Entry{ m_lruKeys.begin(), byte_size });
+            m_cachedBytes += byte_size;
+        }
+        void untrack(const Key& key)
+        {
+            auto it = m_entries.find(key);
+            if (it == m_entries.end()) return;
+            m_cachedBytes -= it->second.m_byteSize;
+            m_lruKeys.erase(it->second.m_lruIterator);
+            m_entries.erase(it);
+        }
+
+        /** 從最久沒用的 entry 開始, can_evict(key) 為 true 的交給 evict(key) 移除, 直到回到預算內
+            @return evicted entry count */
+        template <class CanEvict, class Evict> unsigned evictOverBudget(CanEvict&& can_evict, Evict&& evict)
+        {
+            unsigned evicted_count = 0;
+            auto it = m_lruKeys.end();
+            while ((isOverBudget()) && (it != m_lruKeys.begin()))
+            {
+                --it;
+                if (!can_evict(*it)) continue;
+                const Key key = *it;
+                it = std::next(it);  // untrack 會刪掉目前這個 node
+                untrack(key);
+                evict(key);
+                evicted_count++;
+                m_statistics.m_evictionCount++;
+            }
+            return evicted_count;
+        }
+
+        RepositoryCacheStatistics statistics() const
+        {
+            RepositoryCacheStatistics statistics = m_statistics;
+            statistics.m_cachedBytes = m_cachedBytes;
+            statistics.m_budgetBytes = m_budgetBytes;
+            statistics.m_entryCount = static_cast<unsigned>(m_entries.size());
+            return statistics;
+        }
+        void resetStatistics() { m_statistics = RepositoryCacheStatistics{}; }
+        void clear()
+        {
+            m_lruKeys.clear();
+            m_entries.clear();
+            m_cachedBytes = 0;
+        }
+
+    private:
+        struct Entry
+        {
+            typename std::list<Key>::iterator m_lruIterator;
+            std::size_t m_byteSize;
+        };
+
+        std::size_t m_budgetBytes;
+        std::size_t m_cachedBytes;
+        std::list<Key> m_lruKeys;  ///< front : most recently used
+        std::unordered_map<Key, Entry, Hash> m_entries;
+        RepositoryCacheStatistics m_statistics;
+    };
+}
+
+#endif // REPOSITORY_CACHE_POLICY_H
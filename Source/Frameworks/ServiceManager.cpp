@@ -2,16 +2,53 @@
 #include "SystemService.h"
 #include "SystemServiceEvents.h"
 #include "EventPublisher.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "Platforms/PlatformLayer.h"
+#include "Platforms/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
 
 using namespace Enigma::Frameworks;
 
+namespace
+{
+    bool hasCommonResource(const std::vector<std::string>& a, const std::vector<std::string>& b)
+    {
+        for (auto& resource : a)
+        {
+            if (std::find(b.begin(), b.end(), resource) != b.end()) return true;
+        }
+        return false;
+    }
+
+    /** 兩個 service 的 tick 能不能並行, 沒宣告過的 service 和誰都衝突 */
+    bool isTickConflicted(const ISystemService& a, const ISystemService& b)
+    {
+        if ((!a.hasDeclaredTickDependency()) || (!b.hasDeclaredTickDependency())) return true;
+        return hasCommonResource(a.tickWriteResources(), b.tickWriteResources())
+            || hasCommonResource(a.tickWriteResources(), b.tickReadResources())
+            || hasCommonResource(a.tickReadResources(), b.tickWriteResources());
+    }
+}
+
 ServiceManager::ServiceManager()
 {
     m_minServiceState = ServiceState::Invalid;
+    m_frameNumber = 0;
+    m_jobSystem = nullptr;
+    m_hasConcurrentTick = false;
+    m_criticalPathLength = 0;
+    m_lastCriticalPathTime = 0.0f;
+    m_lastTotalTickTime = 0.0f;
+    m_frameArenas = std::make_unique<FrameArenaRing>();
 }
 
 ServiceManager::~ServiceManager()
 {
+    m_frameArenas->deactivate();
 }
 
 void ServiceManager::registerSystemService(const std::shared_ptr<ISystemService>& service)
@@ -24,6 +61,7 @@ void ServiceManager::registerSystemService(const std::shared_ptr<ISystemService>
     m_services.emplace_back(rec);
     m_mapServices[service->typeIndex()] = service;
     m_minServiceState = ServiceState::PreInit;
+    rebuildTickSchedule();
 }
 
 void ServiceManager::unregisterSystemService(const Rtti& service_type)
@@ -77,7 +115,25 @@ void ServiceManager::shutdownSystemService(const Rtti& service_type)
 
 void ServiceManager::runOnce()
 {
+    PROFILE_FRAME_MARK();
+    PROFILE_ZONE("ServiceManager::runOnce");
+    m_frameNumber.fetch_add(1, std::memory_order_acq_rel);
     if (m_services.empty()) return;
+    // 初始化中 event publisher 還沒在 tick, message 會放好幾個 frame, 先不用 frame arena
+    if (m_minServiceState == ServiceState::Running)
+    {
+        m_frameArenas->advanceFrame();
+    }
+    else
+    {
+        m_frameArenas->deactivate();
+    }
+    // 全部都在 running, 才照 tick schedule 跑; init, shutdown 還是照註冊順序一個一個來
+    if ((m_minServiceState == ServiceState::Running) && (!m_tickSchedule.empty()))
+    {
+        tickBySchedule();
+        return;
+    }
 
     ServiceState tempMinState = ServiceState::Deleted;
 
@@ -87,63 +143,60 @@ void ServiceManager::runOnce()
         if (!((*iterService).m_service)) continue;
         if (((*iterService).m_service)->isSuspended()) continue;
 
-        ServiceResult result = ServiceResult::Complete;
-        switch ((*iterService).m_state)
-        {
-        case ServiceState::Running:
-        {
-            if ((*iterService).m_service->isNeedTick())
-            {
-                result = (*iterService).m_service->onTick();
-            }
-            else
-            {
-                result = ServiceResult::Pendding;
-            }
-        }
-        break;
-        case ServiceState::PreInit:
-        {
-            result = (*iterService).m_service->onPreInit();
-        }
-        break;
-        case ServiceState::Initializing:
+        runServiceState(*iterService);
+        if (tempMinState > (*iterService).m_state) tempMinState = (*iterService).m_state;
+    }
+    updateMinServiceState(tempMinState);
+}
+
+void ServiceManager::runServiceState(ServiceStateRecord& record)
+{
+    ServiceResult result = ServiceResult::Complete;
+    switch (record.m_state)
+    {
+    case ServiceState::Running:
+    {
+        if (record.m_service->isNeedTick())
         {
-            result = (*iterService).m_service->onInit();
+            PROFILE_ZONE(record.m_service->typeInfo().getName().c_str());
+            result = record.m_service->onTick();
         }
-        break;
-        case ServiceState::ShuttingDown:
+        else
         {
-            result = (*iterService).m_service->onTerm();
-        }
-        break;
-        case ServiceState::Complete:
-        {  // 完成，砍掉service
-            m_mapServices[(*iterService).m_service->typeIndex()] = nullptr;
-            (*iterService).m_service = nullptr;
+            result = ServiceResult::Pendding;
         }
+    }
+    break;
+    case ServiceState::PreInit:
+    {
+        result = record.m_service->onPreInit();
+    }
+    break;
+    case ServiceState::Initializing:
+    {
+        result = record.m_service->onInit();
+    }
+    break;
+    case ServiceState::ShuttingDown:
+    {
+        result = record.m_service->onTerm();
+    }
+    break;
+    case ServiceState::Complete:
+    {  // 完成，砍掉service
+        m_mapServices[record.m_service->typeIndex()] = nullptr;
+        record.m_service = nullptr;
+    }
+    break;
+    default:
         break;
-        default:
-            break;
-        }
-
-        if (result == ServiceResult::Complete)
-        {
-            unsigned int state = static_cast<unsigned int>((*iterService).m_state);
-            state++;
-            (*iterService).m_state = static_cast<ServiceState>(state);
-        }
-        if (tempMinState > (*iterService).m_state) tempMinState = (*iterService).m_state;
     }
 
-    if (tempMinState != m_minServiceState)
+    if (result == ServiceResult::Complete)
     {
-        if ((m_minServiceState <= ServiceState::Initializing)
-            && (tempMinState > ServiceState::Initializing))
-        {
-            EventPublisher::post(std::make_shared<AllServiceInitialized>());
-        }
-        m_minServiceState = tempMinState;
+        unsigned int state = static_cast<unsigned int>(record.m_state);
+        state++;
+        record.m_state = static_cast<ServiceState>(state);
     }
 }
 
@@ -208,16 +261,7 @@ void ServiceManager::runForState(ServiceState st)
         }
         if (tempMinState > (*iterService).m_state) tempMinState = (*iterService).m_state;
     }
-
-    if (tempMinState != m_minServiceState)
-    {
-        if ((m_minServiceState <= ServiceState::Initializing)
-            && (tempMinState > ServiceState::Initializing))
-        {
-            EventPublisher::post(std::make_shared<AllServiceInitialized>());
-        }
-        m_minServiceState = tempMinState;
-    }
+    updateMinServiceState(tempMinState);
 }
 
 void ServiceManager::runToState(ServiceState st)
@@ -271,3 +315,244 @@ std::optional<std::shared_ptr<ISystemService>> ServiceManager::tryGetSystemServi
     }
     return std::nullopt;
 }
+
+void ServiceManager::rebuildTickSchedule()
+{
+    std::vector<ServiceStateRecord*> records;
+    for (auto& rec : m_services)
+    {
+        if (rec.m_service) records.emplace_back(&rec);
+    }
+    const unsigned count = static_cast<unsigned>(records.size());
+    std::vector<std::vector<unsigned>> successors(count);
+    std::vector<std::vector<unsigned>> predecessors(count);
+    auto has_edge = [&successors](unsigned from, unsigned to)
+    {
+        return std::find(successors[from].begin(), successors[from].end(), to) != successors[from].end();
+    };
+    auto add_edge = [&](unsigned from, unsigned to)
+    {
+        if ((from == to) || (has_edge(from, to))) return;
+        successors[from].emplace_back(to);
+        predecessors[to].emplace_back(from);
+    };
+    // 明確指定的先後順序
+    for (unsigned i = 0; i < count; i++)
+    {
+        for (unsigned j = 0; j < count; j++)
+        {
+            const ISystemService& service = *records[i]->m_service;
+            const Rtti& other_type = records[j]->m_service->typeInfo();
+            for (auto type : service.tickAfterServices())
+            {
+                if (other_type.isDerived(*type)) add_edge(j, i);
+            }
+            for (auto type : service.tickBeforeServices())
+            {
+                if (other_type.isDerived(*type)) add_edge(i, j);
+            }
+        }
+    }
+    // 資料衝突的照註冊順序, 已經明確指定反向順序的就以明確指定的為準
+    for (unsigned i = 0; i < count; i++)
+    {
+        for (unsigned j = i + 1; j < count; j++)
+        {
+            if (has_edge(j, i)) continue;
+            if (isTickConflicted(*records[i]->m_service, *records[j]->m_service)) add_edge(i, j);
+        }
+    }
+
+    // topological sort, 可以同時排的照註冊順序
+    std::vector<unsigned> in_degree(count);
+    std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>> ready;
+    for (unsigned i = 0; i < count; i++)
+    {
+        in_degree[i] = static_cast<unsigned>(predecessors[i].size());
+        if (in_degree[i] == 0) ready.push(i);
+    }
+    std::vector<unsigned> order;
+    order.reserve(count);
+    while (!ready.empty())
+    {
+        const unsigned i = ready.top();
+        ready.pop();
+        order.emplace_back(i);
+        for (auto j : successors[i])
+        {
+            if (--in_degree[j] == 0) ready.push(j);
+        }
+    }
+
+    m_tickScheduleDiagnostic.clear();
+    bool is_sequential_fallback = false;
+    if (order.size() < count)
+    {
+        // 剩下的每個 node 都還有沒排到的 predecessor, 一路往回走一定會繞回來
+        unsigned walker = 0;
+        while (in_degree[walker] == 0) walker++;
+        std::vector<unsigned> walked;
+        while (std::find(walked.begin(), walked.end(), walker) == walked.end())
+        {
+            walked.emplace_back(walker);
+            for (auto p : predecessors[walker])
+            {
+                if (in_degree[p] > 0)
+                {
+                    walker = p;
+                    break;
+                }
+            }
+        }
+        // 往回走的順序是 "後 <- 前", 反過來印
+        std::vector<unsigned> cycle(std::find(walked.begin(), walked.end(), walker), walked.end());
+        std::reverse(cycle.begin(), cycle.end());
+        m_tickScheduleDiagnostic = "service tick schedule cycle : ";
+        for (auto i : cycle)
+        {
+            m_tickScheduleDiagnostic += records[i]->m_service->typeInfo().getName() + " -> ";
+        }
+        m_tickScheduleDiagnostic += records[cycle.front()]->m_service->typeInfo().getName()
+            + ", fall back to registration order on main thread";
+        LOG(Error, m_tickScheduleDiagnostic);
+
+        is_sequential_fallback = true;
+        order.clear();
+        for (unsigned i = 0; i < count; i++)
+        {
+            order.emplace_back(i);
+            predecessors[i].clear();
+            if (i > 0) predecessors[i].emplace_back(i - 1);
+        }
+    }
+
+    std::vector<unsigned> schedule_index(count);
+    for (unsigned k = 0; k < count; k++)
+    {
+        schedule_index[order[k]] = k;
+    }
+    m_tickSchedule.clear();
+    m_tickSchedule.reserve(count);
+    m_hasConcurrentTick = false;
+    m_criticalPathLength = 0;
+    std::vector<unsigned> depths(count, 0);
+    for (unsigned k = 0; k < count; k++)
+    {
+        TickScheduleNode node;
+        node.m_record = records[order[k]];
+        node.m_isMainThreadTick = is_sequential_fallback || node.m_record->m_service->isMainThreadTick();
+        node.m_isActive = false;
+        node.m_result = ServiceResult::Pendding;
+        node.m_tickTime = 0.0f;
+        unsigned depth = 0;
+        for (auto p : predecessors[order[k]])
+        {
+            node.m_predecessors.emplace_back(schedule_index[p]);
+            depth = std::max(depth, depths[schedule_index[p]]);
+        }
+        depths[k] = depth + 1;
+        m_criticalPathLength = std::max(m_criticalPathLength, depths[k]);
+        if (!node.m_isMainThreadTick) m_hasConcurrentTick = true;
+        m_tickSchedule.emplace_back(std::move(node));
+    }
+}
+
+void ServiceManager::tickBySchedule()
+{
+    // 已經 unregister (或 tick 完成) 的 service 不在 running, 照註冊順序走原本的 state 流程 (shutdown, onTerm, 刪除),
+    // 先記下來, 這個 frame 才從 running 離開的等下一個 frame 再往下走
+    std::vector<ServiceStateRecord*> state_changing_records;
+    for (auto& record : m_services)
+    {
+        if ((!record.m_service) || (record.m_service->isSuspended())) continue;
+        if (record.m_state != ServiceState::Running) state_changing_records.emplace_back(&record);
+    }
+
+    const unsigned count = static_cast<unsigned>(m_tickSchedule.size());
+    // 只有 main thread services 時, 排成 jobs 也只是一個接一個做
+    if ((m_jobSystem) && (m_hasConcurrentTick) && (m_jobSystem->isMainThread()))
+    {
+        std::vector<JobCounterPtr> counters(count);
+        std::vector<JobCounterPtr> dependencies;
+        for (unsigned k = 0; k < count; k++)
+        {
+            const TickScheduleNode& node = m_tickSchedule[k];
+            dependencies.clear();
+            for (auto p : node.m_predecessors)
+            {
+                dependencies.emplace_back(counters[p]);
+            }
+            counters[k] = m_jobSystem->schedule("ServiceManager::tickService", [this, k]() { tickScheduleNode(m_tickSchedule[k]); }, dependencies,
+                node.m_isMainThreadTick ? JobSystem::JobAffinity::MainThread : JobSystem::JobAffinity::AnyThread);
+        }
+        for (auto& counter : counters)
+        {
+            m_jobSystem->wait(counter);
+        }
+    }
+    else
+    {
+        for (auto& node : m_tickSchedule)
+        {
+            tickScheduleNode(node);
+        }
+    }
+
+    std::vector<float> finish_times(count, 0.0f);
+    m_lastCriticalPathTime = 0.0f;
+    m_lastTotalTickTime = 0.0f;
+    ServiceState tempMinState = ServiceState::Deleted;
+    for (unsigned k = 0; k < count; k++)
+    {
+        TickScheduleNode& node = m_tickSchedule[k];
+        float start_time = 0.0f;
+        for (auto p : node.m_predecessors)
+        {
+            start_time = std::max(start_time, finish_times[p]);
+        }
+        finish_times[k] = start_time + node.m_tickTime;
+        m_lastCriticalPathTime = std::max(m_lastCriticalPathTime, finish_times[k]);
+        m_lastTotalTickTime += node.m_tickTime;
+
+        if (!node.m_isActive) continue;
+        if (node.m_result == ServiceResult::Complete)
+        {
+            unsigned int state = static_cast<unsigned int>(node.m_record->m_state);
+            state++;
+            node.m_record->m_state = static_cast<ServiceState>(state);
+        }
+        if (tempMinState > node.m_record->m_state) tempMinState = node.m_record->m_state;
+    }
+    for (auto record : state_changing_records)
+    {
+        runServiceState(*record);
+        // Complete 狀態的 record 這裡會把 service 刪掉, 不算進 min state
+        if ((record->m_service) && (tempMinState > record->m_state)) tempMinState = record->m_state;
+    }
+    updateMinServiceState(tempMinState);
+}
+
+void ServiceManager::tickScheduleNode(TickScheduleNode& node)
+{
+    const auto& service = node.m_record->m_service;
+    // 只 tick running 的 service, 其他狀態由 tickBySchedule 照原本的 state 流程處理
+    node.m_isActive = (service) && (!service->isSuspended()) && (node.m_record->m_state == ServiceState::Running);
+    node.m_result = ServiceResult::Pendding;
+    node.m_tickTime = 0.0f;
+    if ((!node.m_isActive) || (!service->isNeedTick())) return;
+    PROFILE_ZONE(service->typeInfo().getName().c_str());
+    const auto start_time = std::chrono::steady_clock::now();
+    node.m_result = service->onTick();
+    node.m_tickTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void ServiceManager::updateMinServiceState(ServiceState min_state)
+{
+    if (min_state == m_minServiceState) return;
+    if ((m_minServiceState <= ServiceState::Initializing)
+        && (min_state > ServiceState::Initializing))
+    {
+        EventPublisher::post(std::make_shared<AllServiceInitialized>());
+    }
+    m_minServiceState = min_state;
+}
@@ -10,13 +10,20 @@
 
 #include "SystemService.h"
 #include "Rtti.h"
+#include <atomic>
+#include <cstdint>
 #include <list>
 #include <optional>
 #include <unordered_map>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace Enigma::Frameworks
 {
+    class JobSystem;
+    class FrameArenaRing;
+
     /** service manager */
     class ServiceManager
     {
@@ -57,6 +64,27 @@ namespace Enigma::Frameworks
 
         ServiceState checkServiceState(const Rtti& service_type);
 
+        /// runOnce 被呼叫的次數, 任何執行緒都可以讀
+        std::uint64_t frameNumber() const { return m_frameNumber.load(std::memory_order_acquire); }
+
+        /** running 狀態下的 tick 依 schedule 分給 job system 並行,
+            nullptr (預設) 就在呼叫的執行緒上照 schedule 順序 tick, runOnce 要在 job system 的 main thread 呼叫 */
+        void setJobSystem(JobSystem* job_system) { m_jobSystem = job_system; }
+        JobSystem* getJobSystem() const { return m_jobSystem; }
+
+        /// tick schedule 中最長的相依鏈, 以 service 數計
+        unsigned criticalPathLength() const { return m_criticalPathLength; }
+        /// 上一個 schedule tick 沿著 critical path 的 tick 時間 (秒)
+        float lastCriticalPathTime() const { return m_lastCriticalPathTime; }
+        /// 上一個 schedule tick 所有 service tick 時間的總和 (秒)
+        float lastTotalTickTime() const { return m_lastTotalTickTime; }
+        /// 註冊時發現相依有 cycle, schedule 退回照註冊順序在 main thread tick
+        bool hasTickScheduleCycle() const { return !m_tickScheduleDiagnostic.empty(); }
+        const std::string& tickScheduleDiagnostic() const { return m_tickScheduleDiagnostic; }
+
+        /// 每個 running frame 開始時輪替的 message arena
+        const FrameArenaRing* frameArenas() const { return m_frameArenas.get(); }
+
         std::shared_ptr<ISystemService> getSystemService(const Rtti& service_type);
         std::optional<std::shared_ptr<ISystemService>> tryGetSystemService(const Rtti& service_type);
 
@@ -77,6 +105,24 @@ namespace Enigma::Frameworks
 
         typedef std::list<ServiceStateRecord> SystemServiceList;
 
+        struct TickScheduleNode
+        {
+            ServiceStateRecord* m_record;  ///< list 中的 record 位址不會變
+            std::vector<unsigned> m_predecessors;  ///< index in schedule
+            bool m_isMainThreadTick;
+            bool m_isActive;  ///< service 還在, running 且沒有 suspended
+            ServiceResult m_result;
+            float m_tickTime;
+        };
+
+        /** 依 record 的狀態呼叫 onPreInit / onInit / onTick / onTerm, 完成就往下一個狀態 */
+        void runServiceState(ServiceStateRecord& record);
+
+        void rebuildTickSchedule();
+        void tickBySchedule();
+        void tickScheduleNode(TickScheduleNode& node);
+        void updateMinServiceState(ServiceState min_state);
+
     protected:
         typedef std::unordered_map<const Rtti*, std::shared_ptr<ISystemService>> SystemServiceMap;  ///< mapping by rtti type_index
 
@@ -84,6 +130,17 @@ namespace Enigma::Frameworks
         SystemServiceMap m_mapServices;
 
         ServiceState m_minServiceState;  ///< minimun service state
+        std::atomic<std::uint64_t> m_frameNumber;
+
+        JobSystem* m_jobSystem;
+        std::vector<TickScheduleNode> m_tickSchedule;  ///< topological order
+        bool m_hasConcurrentTick;  ///< schedule 中有可以在 worker 上 tick 的 service
+        unsigned m_criticalPathLength;
+        float m_lastCriticalPathTime;
+        float m_lastTotalTickTime;
+        std::string m_tickScheduleDiagnostic;
+
+        std::unique_ptr<FrameArenaRing> m_frameArenas;
     };
 };
 
@@ -10,6 +10,8 @@ ISystemService::ISystemService(ServiceManager* manager)
     m_serviceManager = manager;
     m_needTick = true;
     m_isSuspended = false;
+    m_hasDeclaredTickDependency = false;
+    m_isMainThreadTick = true;
 }
 
 ISystemService::~ISystemService()
@@ -37,3 +39,33 @@ ServiceResult ISystemService::onTick()
     return ServiceResult::Pendding;
 }
 
+
+void ISystemService::declareTickRead(const std::string& resource)
+{
+    m_hasDeclaredTickDependency = true;
+    m_tickReadResources.emplace_back(resource);
+}
+
+void ISystemService::declareTickWrite(const std::string& resource)
+{
+    m_hasDeclaredTickDependency = true;
+    m_tickWriteResources.emplace_back(resource);
+}
+
+void ISystemService::declareTickAfter(const Rtti& service_type)
+{
+    m_hasDeclaredTickDependency = true;
+    m_tickAfterServices.emplace_back(&service_type);
+}
+
+void ISystemService::declareTickBefore(const Rtti& service_type)
+{
+    m_hasDeclaredTickDependency = true;
+    m_tickBeforeServices.emplace_back(&service_type);
+}
+
+void ISystemService::declareTickOnAnyThread()
+{
+    m_hasDeclaredTickDependency = true;
+    m_isMainThreadTick = false;
+}
@@ -9,6 +9,8 @@
 #define _SYSTEM_SERVICE_H
 
 #include "Rtti.h"
+#include <string>
+#include <vector>
 
 namespace Enigma::Frameworks
 {
@@ -55,11 +57,39 @@ namespace Enigma::Frameworks
         /// is suspended?
         inline bool isSuspended() const { return m_isSuspended; };
 
+        /** tick 相依宣告, service manager 據此排出可以並行的 tick schedule,
+            沒宣告過的 service 視為會存取所有資料, 照註冊順序單獨在 main thread tick */
+        inline bool hasDeclaredTickDependency() const { return m_hasDeclaredTickDependency; };
+        inline const std::vector<std::string>& tickReadResources() const { return m_tickReadResources; };
+        inline const std::vector<std::string>& tickWriteResources() const { return m_tickWriteResources; };
+        inline const std::vector<const Rtti*>& tickAfterServices() const { return m_tickAfterServices; };
+        inline const std::vector<const Rtti*>& tickBeforeServices() const { return m_tickBeforeServices; };
+        inline bool isMainThreadTick() const { return m_isMainThreadTick; };
+
+    protected:
+        /** 以下在 constructor 中宣告, 註冊之後再改不會影響 schedule
+            resource 是自訂的資料名稱, 讀同一個 resource 的 services 可以並行, 有寫的就照註冊順序 */
+        void declareTickRead(const std::string& resource);
+        void declareTickWrite(const std::string& resource);
+        /// 在 service_type 之後 tick
+        void declareTickAfter(const Rtti& service_type);
+        /// 在 service_type 之前 tick
+        void declareTickBefore(const Rtti& service_type);
+        /// onTick 可以在 worker thread 上執行 (預設只在 main thread)
+        void declareTickOnAnyThread();
+
 
     protected:
         ServiceManager* m_serviceManager;
         bool m_needTick;
         bool m_isSuspended;
+
+        bool m_hasDeclaredTickDependency;
+        bool m_isMainThreadTick;
+        std::vector<std::string> m_tickReadResources;
+        std::vector<std::string> m_tickWriteResources;
+        std::vector<const Rtti*> m_tickAfterServices;
+        std::vector<const Rtti*> m_tickBeforeServices;
     };
 };
 
@@ -9,6 +9,7 @@
 #define MENEW_MAKE_SHARED_HPP
 
 #include "Platforms/MemoryMacro.h"
+#include "FrameArena.h"
 #include <memory>
 #include <utility>
 
@@ -19,6 +20,19 @@ namespace stdext
     {
         return std::shared_ptr<T>(menew T(std::forward<Args>(args)...));
     }
+
+    /** 給 post 之後只活到下一個 frame 的 message (event, command) 用,
+        有 frame arena 時 control block 與物件配在 arena 上, 沒有就走 std::make_shared,
+        不可以被 subscriber 或其他物件留下來; dispatch 完馬上就丟的 query 直接用 std::make_shared 比較快 */
+    template<typename T, typename... Args>
+    std::shared_ptr<T> make_frame_shared(Args&&... args)
+    {
+        if (auto arena = Enigma::Frameworks::FrameArena::current())
+        {
+            return std::allocate_shared<T>(Enigma::Frameworks::FrameArenaAllocator<T>(arena), std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
 }
 
 #endif // MENEW_MAKE_SHARED_HPP
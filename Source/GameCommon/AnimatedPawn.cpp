@@ -1,6 +1,8 @@
 ﻿#include "AnimatedPawn.h"
 #include "Frameworks/CommandBus.h"
 #include "Renderables/ModelPrimitiveAnimator.h"
+#include "Renderables/ModelPrimitive.h"
+#include "Renderables/SkinMeshPrimitive.h"
 #include "AvatarRecipes.h"
 #include "AnimatedPawnDto.h"
 #include "Animators/AnimatorCommands.h"
@@ -15,13 +17,13 @@ using namespace Enigma::Animators;
 
 DEFINE_RTTI(GameCommon, AnimatedPawn, Pawn);
 
-AnimatedPawn::AnimatedPawn(const SpatialId& id) : Pawn(id)
+AnimatedPawn::AnimatedPawn(const SpatialId& id) : Pawn(id), m_isSkinnedBoundEnabled(false)
 {
     m_factoryDesc = FactoryDesc(AnimatedPawn::TYPE_RTTI.getName());
     registerHandlers();
 }
 
-AnimatedPawn::AnimatedPawn(const SpatialId& id, const Engine::GenericDto& o) : Pawn(id, o)
+AnimatedPawn::AnimatedPawn(const SpatialId& id, const Engine::GenericDto& o) : Pawn(id, o), m_isSkinnedBoundEnabled(false)
 {
     AnimatedPawnDto dto(o);
     if (auto clip = dto.animationClipMapDto()) m_animationClipMap = AnimationClipMap(clip.value());
@@ -64,12 +66,16 @@ void AnimatedPawn::registerHandlers()
 {
     m_onRenderablePrimitiveHydrated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onRenderablePrimitiveHydrated(e); });
     Frameworks::EventPublisher::subscribe(typeid(RenderablePrimitiveHydrated), m_onRenderablePrimitiveHydrated);
+    m_onRenderablePrimitiveSkinPoseUpdated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onRenderablePrimitiveSkinPoseUpdated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(RenderablePrimitiveSkinPoseUpdated), m_onRenderablePrimitiveSkinPoseUpdated);
 }
 
 void AnimatedPawn::unregisterHandlers()
 {
     Frameworks::EventPublisher::unsubscribe(typeid(RenderablePrimitiveHydrated), m_onRenderablePrimitiveHydrated);
     m_onRenderablePrimitiveHydrated = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(RenderablePrimitiveSkinPoseUpdated), m_onRenderablePrimitiveSkinPoseUpdated);
+    m_onRenderablePrimitiveSkinPoseUpdated = nullptr;
 }
 
 void AnimatedPawn::playAnimation(const std::string& name)
@@ -129,6 +135,14 @@ void AnimatedPawn::bakeAvatarRecipes()
     }
 }
 
+void AnimatedPawn::enableSkinnedBound(bool enable)
+{
+    if (m_isSkinnedBoundEnabled == enable) return;
+    m_isSkinnedBoundEnabled = enable;
+    applyCpuSkinning();
+    if (m_primitive) CalculateModelBound(true);
+}
+
 void AnimatedPawn::onRenderablePrimitiveHydrated(const Frameworks::IEventPtr& e)
 {
     if (!e) return;
@@ -136,5 +150,28 @@ void AnimatedPawn::onRenderablePrimitiveHydrated(const Frameworks::IEventPtr& e)
     {
         if (ev->id() != m_primitive->id()) return;
         bakeAvatarRecipes();
+        if (m_isSkinnedBoundEnabled) applyCpuSkinning();
+    }
+}
+
+void AnimatedPawn::onRenderablePrimitiveSkinPoseUpdated(const Frameworks::IEventPtr& e)
+{
+    if ((!e) || (!m_isSkinnedBoundEnabled) || (!m_primitive)) return;
+    const auto ev = std::dynamic_pointer_cast<RenderablePrimitiveSkinPoseUpdated, Frameworks::IEvent>(e);
+    if ((!ev) || (ev->id() != m_primitive->id())) return;
+    CalculateModelBound(true);
+}
+
+void AnimatedPawn::applyCpuSkinning()
+{
+    const auto model = std::dynamic_pointer_cast<ModelPrimitive>(m_primitive);
+    if (!model) return;
+    const unsigned mesh_count = model->getMeshPrimitiveCount();
+    for (unsigned i = 0; i < mesh_count; i++)
+    {
+        if (auto skin_mesh = std::dynamic_pointer_cast<SkinMeshPrimitive>(model->getMeshPrimitive(i)))
+        {
+            skin_mesh->enableCpuSkinning(m_isSkinnedBoundEnabled);
+        }
     }
 }
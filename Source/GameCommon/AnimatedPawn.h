@@ -45,15 +45,25 @@ namespace Enigma::GameCommon
         virtual void addAvatarRecipe(const std::shared_ptr<AvatarRecipe>& recipe);
         virtual void bakeAvatarRecipes();
 
+        /** skin mesh 改用 cpu skinning 算 tight bound, ray intersection 也對變形後的 mesh 做;
+            動畫播放時每個 frame 都會重算 bound, 預設關閉 */
+        void enableSkinnedBound(bool enable);
+        bool isSkinnedBoundEnabled() const { return m_isSkinnedBoundEnabled; }
+
     protected:
         void onRenderablePrimitiveHydrated(const Frameworks::IEventPtr& e);
+        void onRenderablePrimitiveSkinPoseUpdated(const Frameworks::IEventPtr& e);
+        void applyCpuSkinning();
 
     protected:
         AnimationClipMap m_animationClipMap;
         using AvatarRecipeList = std::list<std::shared_ptr<AvatarRecipe>>;
         AvatarRecipeList m_avatarRecipeList;
 
+        bool m_isSkinnedBoundEnabled;
+
         Frameworks::EventSubscriberPtr m_onRenderablePrimitiveHydrated;
+        Frameworks::EventSubscriberPtr m_onRenderablePrimitiveSkinPoseUpdated;
     };
 }
 
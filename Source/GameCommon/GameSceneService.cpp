@@ -143,6 +143,12 @@ void GameSceneService::destroyRootScene()
     if (m_sceneGraph) m_sceneGraph->destroyRoot();
 }
 
+std::shared_ptr<Node> GameSceneService::getSceneRoot() const
+{
+    if (!m_sceneGraph) return nullptr;
+    return m_sceneGraph->root();
+}
+
 void GameSceneService::createSceneCuller(const std::shared_ptr<Camera>& camera)
 {
     SAFE_DELETE(m_culler);
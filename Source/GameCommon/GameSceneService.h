@@ -45,6 +45,7 @@ namespace Enigma::GameCommon
         void createNodalSceneRoot(const SceneGraph::SpatialId& scene_root_id);
         void createPortalSceneRoot(const SceneGraph::SpatialId& scene_root_id);
         void destroyRootScene();
+        std::shared_ptr<SceneGraph::Node> getSceneRoot() const;
         //@}
 
         /** create culler */
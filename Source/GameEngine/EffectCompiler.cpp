@@ -13,10 +13,25 @@ using namespace Enigma::Engine;
 using namespace Enigma::Frameworks;
 using namespace Enigma::Graphics;
 
-EffectCompiler::EffectCompiler()
+EffectCompiler::EffectCompiler() : m_requester(nullptr)
 {
     m_hasMaterialProduced = false;
+    subscribeDeviceEvents();
+}
+
+EffectCompiler::EffectCompiler(DeviceObjectRequester* requester) : m_requester(requester)
+{
+    assert(m_requester);
+    m_hasMaterialProduced = false;
+}
 
+EffectCompiler::~EffectCompiler()
+{
+    if (!m_requester) unsubscribeDeviceEvents();
+}
+
+void EffectCompiler::subscribeDeviceEvents()
+{
     m_onShaderProgramBuilt = std::make_shared<EventSubscriber>([=](auto e) { this->onShaderProgramBuilt(e); });
     EventPublisher::subscribe(typeid(ShaderProgramBuilt), m_onShaderProgramBuilt);
     m_onBuildProgramFailed = std::make_shared<EventSubscriber>([=](auto e) { this->onBuildProgramFailed(e); });
@@ -32,7 +47,7 @@ EffectCompiler::EffectCompiler()
     EventPublisher::subscribe(typeid(DeviceRasterizerStateCreated), m_onRasterizerStateCreated);
 }
 
-EffectCompiler::~EffectCompiler()
+void EffectCompiler::unsubscribeDeviceEvents()
 {
     EventPublisher::unsubscribe(typeid(ShaderProgramBuilt), m_onShaderProgramBuilt);
     m_onShaderProgramBuilt = nullptr;
@@ -49,16 +64,25 @@ EffectCompiler::~EffectCompiler()
     m_onRasterizerStateCreated = nullptr;
 }
 
-void EffectCompiler::compileEffect(const std::shared_ptr<EffectMaterial>& effect, const EffectCompilingProfile& profile)
+void EffectCompiler::reset()
 {
-    m_compilingEffect = effect;
-    m_profile = profile;
+    m_compilingEffect = nullptr;
     m_builtPrograms.clear();
     m_builtPassStates.clear();
     m_builtEffectTechniques.clear();
+    m_postedRequests.clear();
+    m_hasMaterialProduced = false;
+}
+
+void EffectCompiler::compileEffect(const std::shared_ptr<EffectMaterial>& effect, const EffectCompilingProfile& profile)
+{
+    reset();
+    m_compilingEffect = effect;
+    m_profile = profile;
 
     if (m_profile.m_techniques.empty())
     {
+        m_hasMaterialProduced = true;
         EventPublisher::post(std::make_shared<CompileEffectMaterialFailed>(m_profile.m_name, ErrorCode::compilingEmptyEffectTech));
         return;
     }
@@ -73,10 +97,9 @@ void EffectCompiler::compileEffect(const std::shared_ptr<EffectMaterial>& effect
             built_effect_technique.m_passes.emplace_back(built_effect_pass);
             if (m_builtPrograms.find(pass.m_program.m_programName) == m_builtPrograms.end())
             {
-                m_builtPrograms.emplace(pass.m_program.m_programName, nullptr);
+                m_builtPrograms.emplace(pass.m_program.m_programName, requestShaderProgram(pass.m_program));
             }
             EffectPassStates built_pass_states;
-            CommandBus::post(std::make_shared<BuildShaderProgram>(pass.m_program));
             if (!pass.m_samplers.empty())
             {
                 built_pass_states.m_samplers = std::vector<Graphics::IDeviceSamplerStatePtr>{};
@@ -84,18 +107,101 @@ void EffectCompiler::compileEffect(const std::shared_ptr<EffectMaterial>& effect
             }
             for (auto& samp : pass.m_samplers)
             {
-                CommandBus::post(std::make_shared<CreateSamplerState>(samp.m_name, samp.m_data));
-                if (built_pass_states.m_samplers) built_pass_states.m_samplers->emplace_back(nullptr);
+                auto state = requestSamplerState(samp);
+                if (built_pass_states.m_samplers) built_pass_states.m_samplers->emplace_back(state);
                 if (built_pass_states.m_samplerNames) built_pass_states.m_samplerNames->emplace_back(samp.m_variableName);
             }
-            CommandBus::post(std::make_shared<CreateDepthStencilState>(pass.m_depth.m_name, pass.m_depth.m_data));
-            CommandBus::post(std::make_shared<CreateBlendState>(pass.m_blend.m_name, pass.m_blend.m_data));
-            CommandBus::post(std::make_shared<CreateRasterizerState>(pass.m_rasterizer.m_name, pass.m_rasterizer.m_data));
+            if (auto depth = requestDepthState(pass.m_depth)) built_pass_states.m_depth = depth;
+            if (auto blend = requestBlendState(pass.m_blend)) built_pass_states.m_blend = blend;
+            if (auto rasterizer = requestRasterizerState(pass.m_rasterizer)) built_pass_states.m_rasterizer = rasterizer;
             m_builtPassStates.emplace(pass.m_name, built_pass_states);
         }
         m_builtEffectTechniques.emplace_back(built_effect_technique);
     }
-    m_hasMaterialProduced = false;
+    // requester 已經建好的 object 不會再有通知, 先試著組一次
+    for (auto& tech : m_profile.m_techniques)
+    {
+        for (auto& pass : tech.m_passes)
+        {
+            tryBuildEffectPass(pass.m_name);
+        }
+    }
+}
+
+void EffectCompiler::shaderProgramBuilt(const std::string& name, const Graphics::IShaderProgramPtr& program)
+{
+    if (!isCompiling()) return;
+    const auto it = m_builtPrograms.find(name);
+    if (it == m_builtPrograms.end()) return;
+    it->second = program;
+    for (auto& pass_profile : m_profile.findPassesWithProgram(name))
+    {
+        tryBuildEffectPass(pass_profile.get().m_name);
+    }
+}
+
+void EffectCompiler::buildShaderProgramFailed(const std::string& name, std::error_code er)
+{
+    if (!isCompiling()) return;
+    if (m_builtPrograms.find(name) == m_builtPrograms.end()) return;
+    m_hasMaterialProduced = true;  // 失敗也算結束, 之後的通知都不理
+    EventPublisher::post(std::make_shared<CompileEffectMaterialFailed>(m_profile.m_name, er));
+}
+
+void EffectCompiler::samplerStateCreated(const std::string& name, const Graphics::IDeviceSamplerStatePtr& state)
+{
+    if (!isCompiling()) return;
+    for (auto& pass_profile : m_profile.findPassesWithSamplerState(name))
+    {
+        std::string pass_name = pass_profile.get().m_name;
+        auto it = m_builtPassStates.find(pass_name);
+        if (it == m_builtPassStates.end()) continue;
+        if (!it->second.m_samplers) continue;
+        for (unsigned i = 0; i < pass_profile.get().m_samplers.size(); i++)
+        {
+            if (pass_profile.get().m_samplers[i].m_name == name) it->second.m_samplers.value()[i] = state;
+        }
+        tryBuildEffectPass(pass_name);
+    }
+}
+
+void EffectCompiler::blendStateCreated(const std::string& name, const Graphics::IDeviceAlphaBlendStatePtr& state)
+{
+    if (!isCompiling()) return;
+    for (auto& pass_profile : m_profile.findPassesWithBlendState(name))
+    {
+        std::string pass_name = pass_profile.get().m_name;
+        auto it = m_builtPassStates.find(pass_name);
+        if (it == m_builtPassStates.end()) continue;
+        it->second.m_blend = state;
+        tryBuildEffectPass(pass_name);
+    }
+}
+
+void EffectCompiler::depthStateCreated(const std::string& name, const Graphics::IDeviceDepthStencilStatePtr& state)
+{
+    if (!isCompiling()) return;
+    for (auto& pass_profile : m_profile.findPassesWithDepthState(name))
+    {
+        std::string pass_name = pass_profile.get().m_name;
+        auto it = m_builtPassStates.find(pass_name);
+        if (it == m_builtPassStates.end()) continue;
+        it->second.m_depth = state;
+        tryBuildEffectPass(pass_name);
+    }
+}
+
+void EffectCompiler::rasterizerStateCreated(const std::string& name, const Graphics::IDeviceRasterizerStatePtr& state)
+{
+    if (!isCompiling()) return;
+    for (auto& pass_profile : m_profile.findPassesWithRasterizerState(name))
+    {
+        std::string pass_name = pass_profile.get().m_name;
+        auto it = m_builtPassStates.find(pass_name);
+        if (it == m_builtPassStates.end()) continue;
+        it->second.m_rasterizer = state;
+        tryBuildEffectPass(pass_name);
+    }
 }
 
 void EffectCompiler::onShaderProgramBuilt(const Frameworks::IEventPtr& e)
@@ -103,9 +209,7 @@ void EffectCompiler::onShaderProgramBuilt(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev_built = std::dynamic_pointer_cast<ShaderProgramBuilt, IEvent>(e);
     if (!ev_built) return;
-    if (m_builtPrograms.find(ev_built->GetShaderName()) == m_builtPrograms.end()) return;
-    m_builtPrograms[ev_built->GetShaderName()] = ev_built->GetProgram();
-    tryBuildEffectPass(ev_built->GetShaderName());
+    shaderProgramBuilt(ev_built->GetShaderName(), ev_built->GetProgram());
 }
 
 void EffectCompiler::onBuildProgramFailed(const Frameworks::IEventPtr& e)
@@ -113,7 +217,7 @@ void EffectCompiler::onBuildProgramFailed(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev_fail = std::dynamic_pointer_cast<BuildShaderProgramFailed, IEvent>(e);
     if (!ev_fail) return;
-    EventPublisher::post(std::make_shared<CompileEffectMaterialFailed>(m_profile.m_name, ev_fail->GetErrorCode()));
+    buildShaderProgramFailed(ev_fail->GetShaderName(), ev_fail->GetErrorCode());
 }
 
 void EffectCompiler::onSamplerStateCreated(const Frameworks::IEventPtr& e)
@@ -121,19 +225,7 @@ void EffectCompiler::onSamplerStateCreated(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<DeviceSamplerStateCreated, IEvent>(e);
     if (!ev) return;
-    const auto pass_profiles = m_profile.findPassesWithSamplerState(ev->GetStateName());
-    if (pass_profiles.empty()) return;
-
-    for (auto& pass_profile : pass_profiles)
-    {
-        std::string pass_name = pass_profile.get().m_name;
-        auto index = m_profile.findSamplerIndexInPass(pass_name, ev->GetStateName());
-        if (!index) return;
-        auto it = m_builtPassStates.find(pass_name);
-        if (it == m_builtPassStates.end()) return;
-        if (auto& s = it->second.m_samplers) s.value()[*index] = ev->GetState();
-        tryBuildEffectPass(pass_name);
-    }
+    samplerStateCreated(ev->GetStateName(), ev->GetState());
 }
 
 void EffectCompiler::onBlendStateCreated(const Frameworks::IEventPtr& e)
@@ -141,16 +233,7 @@ void EffectCompiler::onBlendStateCreated(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<DeviceAlphaBlendStateCreated, IEvent>(e);
     if (!ev) return;
-    const auto pass_profiles = m_profile.findPassesWithBlendState(ev->GetStateName());
-    if (pass_profiles.empty()) return;
-
-    for (auto& pass_profile : pass_profiles)
-    {
-        std::string pass_name = pass_profile.get().m_name;
-        if (m_builtPassStates.find(pass_name) == m_builtPassStates.end()) return;
-        m_builtPassStates[pass_name].m_blend = ev->GetState();
-        tryBuildEffectPass(pass_name);
-    }
+    blendStateCreated(ev->GetStateName(), ev->GetState());
 }
 
 void EffectCompiler::onDepthStateCreated(const Frameworks::IEventPtr& e)
@@ -158,16 +241,7 @@ void EffectCompiler::onDepthStateCreated(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<DeviceDepthStencilStateCreated, IEvent>(e);
     if (!ev) return;
-    const auto pass_profiles = m_profile.findPassesWithDepthState(ev->GetStateName());
-    if (pass_profiles.empty()) return;
-
-    for (auto& pass_profile : pass_profiles)
-    {
-        std::string pass_name = pass_profile.get().m_name;
-        if (m_builtPassStates.find(pass_name) == m_builtPassStates.end()) return;
-        m_builtPassStates[pass_name].m_depth = ev->GetState();
-        tryBuildEffectPass(pass_name);
-    }
+    depthStateCreated(ev->GetStateName(), ev->GetState());
 }
 
 void EffectCompiler::onRasterizerStateCreated(const Frameworks::IEventPtr& e)
@@ -175,55 +249,83 @@ void EffectCompiler::onRasterizerStateCreated(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<DeviceRasterizerStateCreated, IEvent>(e);
     if (!ev) return;
-    const auto pass_profiles = m_profile.findPassesWithRasterizerState(ev->GetStateName());
-    if (pass_profiles.empty()) return;
+    rasterizerStateCreated(ev->GetStateName(), ev->GetState());
+}
 
-    for (auto& pass_profile : pass_profiles)
-    {
-        std::string pass_name = pass_profile.get().m_name;
-        if (m_builtPassStates.find(pass_name) == m_builtPassStates.end()) return;
-        m_builtPassStates[pass_name].m_rasterizer = ev->GetState();
-        tryBuildEffectPass(pass_name);
-    }
+Enigma::Graphics::IShaderProgramPtr EffectCompiler::requestShaderProgram(const ShaderProgramPolicy& policy)
+{
+    if (m_requester) return m_requester->requestShaderProgram(policy);
+    if (m_postedRequests.insert("program:" + policy.m_programName).second) CommandBus::post(std::make_shared<BuildShaderProgram>(policy));
+    return nullptr;
+}
+
+Enigma::Graphics::IDeviceSamplerStatePtr EffectCompiler::requestSamplerState(const EffectSamplerProfile& sampler)
+{
+    if (m_requester) return m_requester->requestSamplerState(sampler);
+    if (m_postedRequests.insert("sampler:" + sampler.m_name).second) CommandBus::post(std::make_shared<CreateSamplerState>(sampler.m_name, sampler.m_data));
+    return nullptr;
+}
+
+Enigma::Graphics::IDeviceAlphaBlendStatePtr EffectCompiler::requestBlendState(const EffectAlphaBlendProfile& blend)
+{
+    if (m_requester) return m_requester->requestBlendState(blend);
+    if (m_postedRequests.insert("blend:" + blend.m_name).second) CommandBus::post(std::make_shared<CreateBlendState>(blend.m_name, blend.m_data));
+    return nullptr;
 }
 
-void EffectCompiler::tryBuildEffectPass(const std::string& program_name)
+Enigma::Graphics::IDeviceDepthStencilStatePtr EffectCompiler::requestDepthState(const EffectDepthStencilProfile& depth)
 {
-    if (m_builtPrograms.find(program_name) == m_builtPrograms.end()) return;
-    if (!m_builtPrograms[program_name]) return;
-    const auto pass_profiles = m_profile.findPassesWithProgram(program_name);
-    if (pass_profiles.empty()) return;
-    for (auto& pass_profile : pass_profiles)
+    if (m_requester) return m_requester->requestDepthState(depth);
+    if (m_postedRequests.insert("depth:" + depth.m_name).second) CommandBus::post(std::make_shared<CreateDepthStencilState>(depth.m_name, depth.m_data));
+    return nullptr;
+}
+
+Enigma::Graphics::IDeviceRasterizerStatePtr EffectCompiler::requestRasterizerState(const EffectRasterizerProfile& rasterizer)
+{
+    if (m_requester) return m_requester->requestRasterizerState(rasterizer);
+    if (m_postedRequests.insert("rasterizer:" + rasterizer.m_name).second) CommandBus::post(std::make_shared<CreateRasterizerState>(rasterizer.m_name, rasterizer.m_data));
+    return nullptr;
+}
+
+void EffectCompiler::tryBuildEffectPass(const std::string& pass_name)
+{
+    if (!isCompiling()) return;
+    auto it = m_builtPassStates.find(pass_name);
+    if (it == m_builtPassStates.end()) return;
+    if (auto& samp = it->second.m_samplers)
     {
-        std::string pass_name = pass_profile.get().m_name;
-        auto it = m_builtPassStates.find(pass_name);
-        if (it == m_builtPassStates.end()) continue;
-        if (auto samp = it->second.m_samplers)
+        for (auto& state : samp.value())
         {
-            for (unsigned int i = 0; i < samp.value().size(); i++)
-            {
-                if (samp.value()[i] == nullptr) continue;
-            }
+            if (state == nullptr) return;
         }
-        if (!it->second.m_blend) continue;
-        if (!it->second.m_depth) continue;
-        if (!it->second.m_rasterizer) continue;
+    }
+    if (!it->second.m_blend) return;
+    if (!it->second.m_depth) return;
+    if (!it->second.m_rasterizer) return;
 
-        std::string tech_name;
-        for (auto& tech : m_builtEffectTechniques)
+    std::string tech_name;
+    for (auto& tech : m_profile.m_techniques)
+    {
+        for (auto& pass_profile : tech.m_passes)
         {
-            if (tech.m_passes.empty()) continue;
-            for (auto& pass : tech.m_passes)
+            if (pass_profile.m_name != pass_name) continue;
+            const auto program = m_builtPrograms.find(pass_profile.m_program.m_programName);
+            if ((program == m_builtPrograms.end()) || (!program->second)) return;
+            for (auto& built_tech : m_builtEffectTechniques)
             {
-                if (pass.m_name == pass_name)
+                if (built_tech.m_name != tech.m_name) continue;
+                for (auto& pass : built_tech.m_passes)
                 {
-                    pass.m_pass = EffectPass(pass.m_name, m_builtPrograms[program_name], m_builtPassStates[pass_name]);
-                    tech_name = tech.m_name;
+                    if ((pass.m_name == pass_name) && (!pass.m_pass))
+                    {
+                        pass.m_pass = EffectPass(pass.m_name, program->second, it->second);
+                        tech_name = tech.m_name;
+                    }
                 }
             }
         }
-        tryBuildEffectTechniques(tech_name);
     }
+    if (!tech_name.empty()) tryBuildEffectTechniques(tech_name);
 }
 
 void EffectCompiler::tryBuildEffectTechniques(const std::string& name)
@@ -14,6 +14,7 @@
 #include "EffectMaterialId.h"
 #include "Frameworks/EventSubscriber.h"
 #include <unordered_map>
+#include <unordered_set>
 
 namespace Enigma::Engine
 {
@@ -46,8 +47,24 @@ namespace Enigma::Engine
             std::error_code m_error;
         };
 
+        /** 同時編譯多個 effect 時共用的 device object 請求,
+            同名的 program / state 只送一次 command, 已建好的直接回傳, 否則回傳 nullptr 等完成通知 */
+        class DeviceObjectRequester
+        {
+        public:
+            virtual ~DeviceObjectRequester() = default;
+            virtual Graphics::IShaderProgramPtr requestShaderProgram(const ShaderProgramPolicy& policy) = 0;
+            virtual Graphics::IDeviceSamplerStatePtr requestSamplerState(const EffectSamplerProfile& sampler) = 0;
+            virtual Graphics::IDeviceAlphaBlendStatePtr requestBlendState(const EffectAlphaBlendProfile& blend) = 0;
+            virtual Graphics::IDeviceDepthStencilStatePtr requestDepthState(const EffectDepthStencilProfile& depth) = 0;
+            virtual Graphics::IDeviceRasterizerStatePtr requestRasterizerState(const EffectRasterizerProfile& rasterizer) = 0;
+        };
+
     public:
+        /** 獨立使用, 自己訂閱 device events, 直接送出 command */
         EffectCompiler();
+        /** compiling context, device object 透過 requester 請求, 完成通知也由 requester 轉送 */
+        EffectCompiler(DeviceObjectRequester* requester);
         EffectCompiler(const EffectCompiler&) = delete;
         EffectCompiler(EffectCompiler&&) = delete;
         ~EffectCompiler();
@@ -55,8 +72,24 @@ namespace Enigma::Engine
         EffectCompiler& operator=(EffectCompiler&&) = delete;
 
         void compileEffect(const std::shared_ptr<EffectMaterial>& effect, const EffectCompilingProfile& profile);
+        /** 編譯完成或失敗後, context 可以再拿來編譯下一個 effect */
+        bool isCompiling() const { return (m_compilingEffect != nullptr) && (!m_hasMaterialProduced); }
+        const std::shared_ptr<EffectMaterial>& compilingEffect() const { return m_compilingEffect; }
+        void reset();
+
+        /** @name device object 完成通知 */
+        //@{
+        void shaderProgramBuilt(const std::string& name, const Graphics::IShaderProgramPtr& program);
+        void buildShaderProgramFailed(const std::string& name, std::error_code er);
+        void samplerStateCreated(const std::string& name, const Graphics::IDeviceSamplerStatePtr& state);
+        void blendStateCreated(const std::string& name, const Graphics::IDeviceAlphaBlendStatePtr& state);
+        void depthStateCreated(const std::string& name, const Graphics::IDeviceDepthStencilStatePtr& state);
+        void rasterizerStateCreated(const std::string& name, const Graphics::IDeviceRasterizerStatePtr& state);
+        //@}
 
     private:
+        void subscribeDeviceEvents();
+        void unsubscribeDeviceEvents();
         void onShaderProgramBuilt(const Frameworks::IEventPtr& e);
         void onBuildProgramFailed(const Frameworks::IEventPtr& e);
         void onSamplerStateCreated(const Frameworks::IEventPtr& e);
@@ -64,7 +97,16 @@ namespace Enigma::Engine
         void onDepthStateCreated(const Frameworks::IEventPtr& e);
         void onRasterizerStateCreated(const Frameworks::IEventPtr& e);
 
-        void tryBuildEffectPass(const std::string& program_name);
+        /** @name 沒有 requester 時, 同一個 effect 中同名的 object 也只送一次 command */
+        //@{
+        Graphics::IShaderProgramPtr requestShaderProgram(const ShaderProgramPolicy& policy);
+        Graphics::IDeviceSamplerStatePtr requestSamplerState(const EffectSamplerProfile& sampler);
+        Graphics::IDeviceAlphaBlendStatePtr requestBlendState(const EffectAlphaBlendProfile& blend);
+        Graphics::IDeviceDepthStencilStatePtr requestDepthState(const EffectDepthStencilProfile& depth);
+        Graphics::IDeviceRasterizerStatePtr requestRasterizerState(const EffectRasterizerProfile& rasterizer);
+        //@}
+
+        void tryBuildEffectPass(const std::string& pass_name);
         void tryBuildEffectTechniques(const std::string& name);
         void tryBuildEffectMaterial();
 
@@ -83,8 +125,10 @@ namespace Enigma::Engine
             std::vector<EffectPass> retrieveEffectPasses();
         };
     private:
+        DeviceObjectRequester* m_requester;
         EffectCompilingProfile m_profile;
         std::shared_ptr<EffectMaterial> m_compilingEffect;
+        std::unordered_set<std::string> m_postedRequests;
 
         Frameworks::EventSubscriberPtr m_onShaderProgramBuilt;
         Frameworks::EventSubscriberPtr m_onBuildProgramFailed;
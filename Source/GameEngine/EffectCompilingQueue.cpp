@@ -4,24 +4,31 @@
 #include "EffectCompiler.h"
 #include "EffectEvents.h"
 #include "EffectMaterialSource.h"
+#include "ShaderEvents.h"
+#include "ShaderCommands.h"
 #include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include "GraphicKernel/GraphicCommands.h"
+#include "GraphicKernel/GraphicEvents.h"
 #include "Platforms/MemoryMacro.h"
 #include "Platforms/PlatformLayer.h"
+#include <algorithm>
 #include <cassert>
 
 
 using namespace Enigma::Engine;
+using namespace Enigma::Graphics;
 
-EffectCompilingQueue::EffectCompilingQueue()
+EffectCompilingQueue::EffectCompilingQueue(unsigned max_compiling_effects) : m_maxCompilingEffects(std::max(1u, max_compiling_effects))
 {
-    m_compiler = menew EffectCompiler();
     registerHandlers();
 }
 
 EffectCompilingQueue::~EffectCompilingQueue()
 {
-    SAFE_DELETE(m_compiler);
     unregisterHandlers();
+    m_compilingCompilers.clear();
+    m_idleCompilers.clear();
 }
 
 std::error_code EffectCompilingQueue::enqueue(const std::shared_ptr<EffectMaterial>& effect, const EffectCompilingProfile& profile)
@@ -36,28 +43,167 @@ std::error_code EffectCompilingQueue::enqueue(const std::shared_ptr<EffectMateri
 
 std::error_code EffectCompilingQueue::compileNextEffect()
 {
-    if (m_currentCompilingEffect) return ErrorCode::ok;
-    assert(m_compiler);
     std::lock_guard locker{ m_queueLock };
-    if (m_queue.empty())
+    while ((!m_queue.empty()) && (m_compilingCompilers.size() < m_maxCompilingEffects))
     {
-        m_currentCompilingEffect = nullptr;
-        return ErrorCode::ok;
+        auto [effect, profile] = std::move(m_queue.front());
+        m_queue.pop();
+        std::unique_ptr<EffectCompiler> compiler;
+        if (!m_idleCompilers.empty())
+        {
+            compiler = std::move(m_idleCompilers.back());
+            m_idleCompilers.pop_back();
+        }
+        else
+        {
+            compiler = std::make_unique<EffectCompiler>(this);
+        }
+        effect->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
+        // 先放進編譯中的 list, compileEffect 中已建好的 object 會直接完成
+        m_compilingCompilers.emplace_back(std::move(compiler));
+        m_statistics.m_peakCompilingCount = std::max(m_statistics.m_peakCompilingCount, static_cast<unsigned>(m_compilingCompilers.size()));
+        m_compilingCompilers.back()->compileEffect(effect, profile);
     }
-    auto& [effect, profile] = m_queue.front();
-    m_currentCompilingEffect = effect;
-    m_compiler->compileEffect(effect, profile);
-    effect->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
-    m_queue.pop();
     return ErrorCode::ok;
 }
 
+void EffectCompilingQueue::maxCompilingEffects(unsigned max_count)
+{
+    {
+        std::lock_guard locker{ m_queueLock };
+        m_maxCompilingEffects = std::max(1u, max_count);
+    }
+    compileNextEffect();
+}
+
+unsigned EffectCompilingQueue::compilingEffectCount()
+{
+    std::lock_guard locker{ m_queueLock };
+    return static_cast<unsigned>(m_compilingCompilers.size());
+}
+
+unsigned EffectCompilingQueue::pendingEffectCount()
+{
+    std::lock_guard locker{ m_queueLock };
+    return static_cast<unsigned>(m_queue.size());
+}
+
+EffectCompilingStatistics EffectCompilingQueue::statistics()
+{
+    std::lock_guard locker{ m_queueLock };
+    return m_statistics;
+}
+
+void EffectCompilingQueue::resetStatistics()
+{
+    std::lock_guard locker{ m_queueLock };
+    m_statistics = EffectCompilingStatistics{};
+}
+
+IShaderProgramPtr EffectCompilingQueue::requestShaderProgram(const ShaderProgramPolicy& policy)
+{
+    bool is_issuing = false;
+    auto program = requestDeviceObject(m_programRequests, policy.m_programName, m_statistics.m_issuedProgramCount, is_issuing);
+    if (is_issuing)
+    {
+        Frameworks::CommandBus::post(std::make_shared<BuildShaderProgram>(policy));
+    }
+    return program;
+}
+
+IDeviceSamplerStatePtr EffectCompilingQueue::requestSamplerState(const EffectSamplerProfile& sampler)
+{
+    bool is_issuing = false;
+    auto state = requestDeviceObject(m_samplerRequests, sampler.m_name, m_statistics.m_issuedStateCount, is_issuing);
+    if (is_issuing)
+    {
+        Frameworks::CommandBus::post(std::make_shared<CreateSamplerState>(sampler.m_name, sampler.m_data));
+    }
+    return state;
+}
+
+IDeviceAlphaBlendStatePtr EffectCompilingQueue::requestBlendState(const EffectAlphaBlendProfile& blend)
+{
+    bool is_issuing = false;
+    auto state = requestDeviceObject(m_blendRequests, blend.m_name, m_statistics.m_issuedStateCount, is_issuing);
+    if (is_issuing)
+    {
+        Frameworks::CommandBus::post(std::make_shared<CreateBlendState>(blend.m_name, blend.m_data));
+    }
+    return state;
+}
+
+IDeviceDepthStencilStatePtr EffectCompilingQueue::requestDepthState(const EffectDepthStencilProfile& depth)
+{
+    bool is_issuing = false;
+    auto state = requestDeviceObject(m_depthRequests, depth.m_name, m_statistics.m_issuedStateCount, is_issuing);
+    if (is_issuing)
+    {
+        Frameworks::CommandBus::post(std::make_shared<CreateDepthStencilState>(depth.m_name, depth.m_data));
+    }
+    return state;
+}
+
+IDeviceRasterizerStatePtr EffectCompilingQueue::requestRasterizerState(const EffectRasterizerProfile& rasterizer)
+{
+    bool is_issuing = false;
+    auto state = requestDeviceObject(m_rasterizerRequests, rasterizer.m_name, m_statistics.m_issuedStateCount, is_issuing);
+    if (is_issuing)
+    {
+        Frameworks::CommandBus::post(std::make_shared<CreateRasterizerState>(rasterizer.m_name, rasterizer.m_data));
+    }
+    return state;
+}
+
+template <class T> std::shared_ptr<T> EffectCompilingQueue::requestDeviceObject(DeviceObjectRequestMap<T>& requests, const std::string& name,
+    std::uint64_t& issued_count, bool& is_issuing)
+{
+    std::lock_guard locker{ m_queueLock };
+    auto& request = requests[name];
+    if (auto object = request.m_object.lock())
+    {
+        m_statistics.m_sharedRequestCount++;
+        is_issuing = false;
+        return object;
+    }
+    if (request.m_isPending)
+    {
+        m_statistics.m_sharedRequestCount++;
+        is_issuing = false;
+        return nullptr;
+    }
+    request.m_isPending = true;
+    issued_count++;
+    is_issuing = true;
+    return nullptr;
+}
+
+template <class T> void EffectCompilingQueue::deviceObjectBuilt(DeviceObjectRequestMap<T>& requests, const std::string& name, const std::shared_ptr<T>& object)
+{
+    auto& request = requests[name];
+    request.m_object = object;
+    request.m_isPending = false;
+}
+
 void EffectCompilingQueue::registerHandlers()
 {
     m_onCompilerEffectMaterialCompiled = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onCompilerEffectMaterialCompiled(e); });
     Frameworks::EventPublisher::subscribe(typeid(EffectCompiler::EffectMaterialCompiled), m_onCompilerEffectMaterialCompiled);
     m_onCompilerCompileEffectMaterialFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onCompilerCompileEffectMaterialFailed(e); });
     Frameworks::EventPublisher::subscribe(typeid(EffectCompiler::CompileEffectMaterialFailed), m_onCompilerCompileEffectMaterialFailed);
+
+    m_onShaderProgramBuilt = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onShaderProgramBuilt(e); });
+    Frameworks::EventPublisher::subscribe(typeid(ShaderProgramBuilt), m_onShaderProgramBuilt);
+    m_onBuildProgramFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onBuildProgramFailed(e); });
+    Frameworks::EventPublisher::subscribe(typeid(BuildShaderProgramFailed), m_onBuildProgramFailed);
+    m_onSamplerStateCreated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onSamplerStateCreated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(DeviceSamplerStateCreated), m_onSamplerStateCreated);
+    m_onBlendStateCreated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onBlendStateCreated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(DeviceAlphaBlendStateCreated), m_onBlendStateCreated);
+    m_onDepthStateCreated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onDepthStateCreated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(DeviceDepthStencilStateCreated), m_onDepthStateCreated);
+    m_onRasterizerStateCreated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onRasterizerStateCreated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(DeviceRasterizerStateCreated), m_onRasterizerStateCreated);
 }
 
 void EffectCompilingQueue::unregisterHandlers()
@@ -66,35 +212,144 @@ void EffectCompilingQueue::unregisterHandlers()
     m_onCompilerEffectMaterialCompiled = nullptr;
     Frameworks::EventPublisher::unsubscribe(typeid(EffectCompiler::CompileEffectMaterialFailed), m_onCompilerCompileEffectMaterialFailed);
     m_onCompilerCompileEffectMaterialFailed = nullptr;
+
+    Frameworks::EventPublisher::unsubscribe(typeid(ShaderProgramBuilt), m_onShaderProgramBuilt);
+    m_onShaderProgramBuilt = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(BuildShaderProgramFailed), m_onBuildProgramFailed);
+    m_onBuildProgramFailed = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(DeviceSamplerStateCreated), m_onSamplerStateCreated);
+    m_onSamplerStateCreated = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(DeviceAlphaBlendStateCreated), m_onBlendStateCreated);
+    m_onBlendStateCreated = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(DeviceDepthStencilStateCreated), m_onDepthStateCreated);
+    m_onDepthStateCreated = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(DeviceRasterizerStateCreated), m_onRasterizerStateCreated);
+    m_onRasterizerStateCreated = nullptr;
+}
+
+std::shared_ptr<EffectMaterial> EffectCompilingQueue::releaseCompiler(const EffectMaterialId& id)
+{
+    std::lock_guard locker{ m_queueLock };
+    const auto it = std::find_if(m_compilingCompilers.begin(), m_compilingCompilers.end(),
+        [&](const std::unique_ptr<EffectCompiler>& c) { return (c->compilingEffect()) && (c->compilingEffect()->id() == id); });
+    if (it == m_compilingCompilers.end()) return nullptr;
+    auto effect = (*it)->compilingEffect();
+    (*it)->reset();
+    m_idleCompilers.emplace_back(std::move(*it));
+    m_compilingCompilers.erase(it);
+    return effect;
 }
 
 void EffectCompilingQueue::onCompilerEffectMaterialCompiled(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCompilingEffect) return;
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<EffectCompiler::EffectMaterialCompiled, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->id() != m_currentCompilingEffect->id()) return;
+    auto effect = releaseCompiler(ev->id());
+    if (!effect) return;
 
-    if (m_currentCompilingEffect->getEffectMaterialSource())
+    if (effect->getEffectMaterialSource())
+    {
+        effect->getEffectMaterialSource()->hydrateDuplicatedEffects();
+    }
     {
-        m_currentCompilingEffect->getEffectMaterialSource()->hydrateDuplicatedEffects();
+        std::lock_guard locker{ m_queueLock };
+        m_statistics.m_compiledEffectCount++;
     }
-    Frameworks::EventPublisher::post(std::make_shared<EffectMaterialSourceCompiled>(m_currentCompilingEffect->id()));
-    m_currentCompilingEffect = nullptr;
+    Frameworks::EventPublisher::post(std::make_shared<EffectMaterialSourceCompiled>(effect->id()));
     auto er = compileNextEffect();
 }
 
 void EffectCompilingQueue::onCompilerCompileEffectMaterialFailed(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCompilingEffect) return;
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<EffectCompiler::CompileEffectMaterialFailed, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->id() != m_currentCompilingEffect->id()) return;
+    if (!releaseCompiler(ev->id())) return;
 
     Platforms::Debug::ErrorPrintf("effect material %s compile failed : %s\n", ev->id().name().c_str(), ev->error().message().c_str());
+    {
+        std::lock_guard locker{ m_queueLock };
+        m_statistics.m_failedEffectCount++;
+    }
     Frameworks::EventPublisher::post(std::make_shared<CompileEffectMaterialSourceFailed>(ev->id(), ev->error()));
-    m_currentCompilingEffect = nullptr;
     auto er = compileNextEffect();
 }
+
+void EffectCompilingQueue::onShaderProgramBuilt(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<ShaderProgramBuilt, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_queueLock };
+    deviceObjectBuilt(m_programRequests, ev->GetShaderName(), ev->GetProgram());
+    for (auto& compiler : m_compilingCompilers)
+    {
+        compiler->shaderProgramBuilt(ev->GetShaderName(), ev->GetProgram());
+    }
+}
+
+void EffectCompilingQueue::onBuildProgramFailed(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<BuildShaderProgramFailed, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_queueLock };
+    m_programRequests.erase(ev->GetShaderName());  // 之後的 effect 再請求時重建
+    for (auto& compiler : m_compilingCompilers)
+    {
+        compiler->buildShaderProgramFailed(ev->GetShaderName(), ev->GetErrorCode());
+    }
+}
+
+void EffectCompilingQueue::onSamplerStateCreated(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<DeviceSamplerStateCreated, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_queueLock };
+    deviceObjectBuilt(m_samplerRequests, ev->GetStateName(), ev->GetState());
+    for (auto& compiler : m_compilingCompilers)
+    {
+        compiler->samplerStateCreated(ev->GetStateName(), ev->GetState());
+    }
+}
+
+void EffectCompilingQueue::onBlendStateCreated(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<DeviceAlphaBlendStateCreated, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_queueLock };
+    deviceObjectBuilt(m_blendRequests, ev->GetStateName(), ev->GetState());
+    for (auto& compiler : m_compilingCompilers)
+    {
+        compiler->blendStateCreated(ev->GetStateName(), ev->GetState());
+    }
+}
+
+void EffectCompilingQueue::onDepthStateCreated(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<DeviceDepthStencilStateCreated, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_queueLock };
+    deviceObjectBuilt(m_depthRequests, ev->GetStateName(), ev->GetState());
+    for (auto& compiler : m_compilingCompilers)
+    {
+        compiler->depthStateCreated(ev->GetStateName(), ev->GetState());
+    }
+}
+
+void EffectCompilingQueue::onRasterizerStateCreated(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<DeviceRasterizerStateCreated, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_queueLock };
+    deviceObjectBuilt(m_rasterizerRequests, ev->GetStateName(), ev->GetState());
+    for (auto& compiler : m_compilingCompilers)
+    {
+        compiler->rasterizerStateCreated(ev->GetStateName(), ev->GetState());
+    }
+}
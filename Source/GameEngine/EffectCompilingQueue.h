@@ -1,7 +1,7 @@
 ﻿/*********************************************************************
  * \file   EffectCompilingQueue.h
- * \brief
- *
+ * \brief  同時編譯多個 effect, 每個 effect 有自己的 compiler context,
+ *         編譯中的 effect 共用 program / device state 的請求, 同名的只建一次
  * \author Lancelot 'Robin' Chen
  * \date   December 2023
  *********************************************************************/
@@ -9,24 +9,63 @@
 #define EFFECT_COMPILING_QUEUE_H
 
 #include "EffectCompilingProfile.h"
+#include "EffectCompiler.h"
 #include "Frameworks/EventSubscriber.h"
 #include <system_error>
 #include <queue>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
 
 namespace Enigma::Engine
 {
     class EffectMaterial;
-    class EffectCompiler;
 
-    class EffectCompilingQueue
+    struct EffectCompilingStatistics
+    {
+        std::uint64_t m_compiledEffectCount = 0;
+        std::uint64_t m_failedEffectCount = 0;
+        unsigned m_peakCompilingCount = 0;  ///< 同時編譯中的 effect 數最大值
+        std::uint64_t m_issuedProgramCount = 0;  ///< 實際送出的 BuildShaderProgram
+        std::uint64_t m_issuedStateCount = 0;  ///< 實際送出的 Create*State
+        std::uint64_t m_sharedRequestCount = 0;  ///< 已建好或已送出, 不用再送 command 的請求
+    };
+
+    class EffectCompilingQueue : public EffectCompiler::DeviceObjectRequester
     {
     public:
-        EffectCompilingQueue();
-        ~EffectCompilingQueue();
+        static constexpr unsigned DefaultMaxCompilingEffects = 16;
+
+    public:
+        EffectCompilingQueue(unsigned max_compiling_effects = DefaultMaxCompilingEffects);
+        EffectCompilingQueue(const EffectCompilingQueue&) = delete;
+        EffectCompilingQueue(EffectCompilingQueue&&) = delete;
+        virtual ~EffectCompilingQueue() override;
+        EffectCompilingQueue& operator=(const EffectCompilingQueue&) = delete;
+        EffectCompilingQueue& operator=(EffectCompilingQueue&&) = delete;
 
         std::error_code enqueue(const std::shared_ptr<EffectMaterial>& effect, const EffectCompilingProfile& profile);
+        /** 在同時編譯數上限內, 把 queue 中的 effect 都開始編譯 */
         std::error_code compileNextEffect();
 
+        unsigned maxCompilingEffects() const { return m_maxCompilingEffects; }
+        void maxCompilingEffects(unsigned max_count);
+        unsigned compilingEffectCount();
+        unsigned pendingEffectCount();
+        EffectCompilingStatistics statistics();
+        void resetStatistics();
+
+        /** @name DeviceObjectRequester */
+        //@{
+        virtual Graphics::IShaderProgramPtr requestShaderProgram(const ShaderProgramPolicy& policy) override;
+        virtual Graphics::IDeviceSamplerStatePtr requestSamplerState(const EffectSamplerProfile& sampler) override;
+        virtual Graphics::IDeviceAlphaBlendStatePtr requestBlendState(const EffectAlphaBlendProfile& blend) override;
+        virtual Graphics::IDeviceDepthStencilStatePtr requestDepthState(const EffectDepthStencilProfile& depth) override;
+        virtual Graphics::IDeviceRasterizerStatePtr requestRasterizerState(const EffectRasterizerProfile& rasterizer) override;
+        //@}
+
     protected:
         void registerHandlers();
         void unregisterHandlers();
@@ -34,14 +73,50 @@ namespace Enigma::Engine
         void onCompilerEffectMaterialCompiled(const Frameworks::IEventPtr& e);
         void onCompilerCompileEffectMaterialFailed(const Frameworks::IEventPtr& e);
 
+        void onShaderProgramBuilt(const Frameworks::IEventPtr& e);
+        void onBuildProgramFailed(const Frameworks::IEventPtr& e);
+        void onSamplerStateCreated(const Frameworks::IEventPtr& e);
+        void onBlendStateCreated(const Frameworks::IEventPtr& e);
+        void onDepthStateCreated(const Frameworks::IEventPtr& e);
+        void onRasterizerStateCreated(const Frameworks::IEventPtr& e);
+
+        /** 找出編譯這個 effect 的 context, 放回 idle pool */
+        std::shared_ptr<EffectMaterial> releaseCompiler(const EffectMaterialId& id);
+
+        /** 已建好的 object 以 weak_ptr 保存, 沒人用了就會再請求一次 */
+        template <class T> struct DeviceObjectRequest
+        {
+            std::weak_ptr<T> m_object;
+            bool m_isPending = false;
+        };
+        template <class T> using DeviceObjectRequestMap = std::unordered_map<std::string, DeviceObjectRequest<T>>;
+        /** @return 已建好的 object; nullptr 時, is_issuing 表示需要送出 command, issued_count 在 lock 內累加 */
+        template <class T> std::shared_ptr<T> requestDeviceObject(DeviceObjectRequestMap<T>& requests, const std::string& name,
+            std::uint64_t& issued_count, bool& is_issuing);
+        template <class T> void deviceObjectBuilt(DeviceObjectRequestMap<T>& requests, const std::string& name, const std::shared_ptr<T>& object);
+
     protected:
-        EffectCompiler* m_compiler;
+        unsigned m_maxCompilingEffects;
         std::queue<std::pair<std::shared_ptr<EffectMaterial>, EffectCompilingProfile>> m_queue;
         std::recursive_mutex m_queueLock;
-        std::shared_ptr<EffectMaterial> m_currentCompilingEffect;
+        std::vector<std::unique_ptr<EffectCompiler>> m_compilingCompilers;
+        std::vector<std::unique_ptr<EffectCompiler>> m_idleCompilers;
+
+        DeviceObjectRequestMap<Graphics::IShaderProgram> m_programRequests;
+        DeviceObjectRequestMap<Graphics::IDeviceSamplerState> m_samplerRequests;
+        DeviceObjectRequestMap<Graphics::IDeviceAlphaBlendState> m_blendRequests;
+        DeviceObjectRequestMap<Graphics::IDeviceDepthStencilState> m_depthRequests;
+        DeviceObjectRequestMap<Graphics::IDeviceRasterizerState> m_rasterizerRequests;
+        EffectCompilingStatistics m_statistics;
 
         Frameworks::EventSubscriberPtr m_onCompilerEffectMaterialCompiled;
         Frameworks::EventSubscriberPtr m_onCompilerCompileEffectMaterialFailed;
+        Frameworks::EventSubscriberPtr m_onShaderProgramBuilt;
+        Frameworks::EventSubscriberPtr m_onBuildProgramFailed;
+        Frameworks::EventSubscriberPtr m_onSamplerStateCreated;
+        Frameworks::EventSubscriberPtr m_onBlendStateCreated;
+        Frameworks::EventSubscriberPtr m_onDepthStateCreated;
+        Frameworks::EventSubscriberPtr m_onRasterizerStateCreated;
     };
 }
 
@@ -44,7 +44,7 @@ namespace Enigma::Engine
         std::shared_ptr<Texture> getTexture(unsigned index);
         std::shared_ptr<Texture> getTexture(unsigned index) const;
         const EffectSemanticTextureTuple& getEffectSemanticTextureTuple(unsigned index);
-        const unsigned int getCount() { return static_cast<unsigned int>(m_effectTextures.size()); };
+        unsigned int getCount() const { return static_cast<unsigned int>(m_effectTextures.size()); };
         std::optional<EffectSemanticTextureTuple> findSemanticTexture(const std::string& semantic) const;
 
         bool isAllResourceTexture() const;
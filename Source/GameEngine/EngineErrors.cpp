@@ -25,6 +25,8 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::textureAlreadyExists: return "Texture already exists";
     case ErrorCode::textureAlreadyLoaded: return "Texture already loaded";
     case ErrorCode::textureNotReady: return "Texture not ready";
+    case ErrorCode::textureImageUnsupported: return "Texture image format unsupported";
+    case ErrorCode::decodeTextureImageFail: return "Decode texture image fail";
     }
     return "Unknown";
 }
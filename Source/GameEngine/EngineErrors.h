@@ -35,6 +35,8 @@ namespace Enigma::Engine
         textureAlreadyExists,
         textureAlreadyLoaded,
         textureNotReady,
+        textureImageUnsupported,
+        decodeTextureImageFail,
     };
     class ErrorCategory : public std::error_category
     {
@@ -53,6 +53,16 @@ error RenderBuffer::RangedUpdateVertex(const Graphics::IVertexBuffer::ranged_buf
     return ErrorCode::ok;
 }
 
+error RenderBuffer::RangedUpdateIndex(const Graphics::IIndexBuffer::ranged_buffer& idxBuffer)
+{
+    if (FATAL_LOG_EXPR(!m_indexBuffer)) return Graphics::ErrorCode::nullIndexBuffer;
+    if (idxBuffer.data.empty()) return ErrorCode::ok;
+    unsigned int idxEnd = idxBuffer.idx_offset + static_cast<unsigned int>(idxBuffer.data.size());
+    if (FATAL_LOG_EXPR(idxEnd > m_indexBuffer->IndexCount())) return Graphics::ErrorCode::bufferSize;
+    m_indexBuffer->RangedUpdate(idxBuffer);
+    return ErrorCode::ok;
+}
+
 error RenderBuffer::draw(const std::shared_ptr<EffectMaterial>& effectMaterial,
     const GeometrySegment& segment)
 {
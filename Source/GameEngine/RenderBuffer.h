@@ -36,6 +36,8 @@ namespace Enigma::Engine
         /** ranged update vertex */
         error RangedUpdateVertex(const Graphics::IVertexBuffer::ranged_buffer& vtxBuffer,
             const std::optional<const Graphics::IIndexBuffer::ranged_buffer>& idxBuffer);
+        /** ranged update index only */
+        error RangedUpdateIndex(const Graphics::IIndexBuffer::ranged_buffer& idxBuffer);
 
         Graphics::IVertexBufferPtr GetVertexBuffer() { return m_vertexBuffer; };
         Graphics::IIndexBufferPtr GetIndexBuffer() { return m_indexBuffer; };
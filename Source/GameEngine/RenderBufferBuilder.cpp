@@ -77,8 +77,9 @@ void RenderBufferBuilder::BuildRenderBuffer(const RenderBufferPolicy& policy)
     {
         Frameworks::CommandBus::post(std::make_shared<Graphics::CreateVertexBuffer>(
             m_policy.m_vtxBufferName, m_policy.m_sizeofVertex, m_policy.m_vtxBufferSize));
+        const unsigned vertex_count = m_policy.m_sizeofVertex > 0 ? m_policy.m_vtxBufferSize / m_policy.m_sizeofVertex : 0;
         Frameworks::CommandBus::post(std::make_shared<Graphics::CreateIndexBuffer>(
-            m_policy.m_idxBufferName, m_policy.m_idxBufferSize));
+            m_policy.m_idxBufferName, m_policy.m_idxBufferSize, vertex_count));
     }
 }
 
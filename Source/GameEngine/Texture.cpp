@@ -7,6 +7,7 @@
 #include "TextureQueries.h"
 #include "Frameworks/QueryDispatcher.h"
 #include <cassert>
+#include <algorithm>
 
 using namespace Enigma::Engine;
 using namespace Enigma::Frameworks;
@@ -14,9 +15,48 @@ using namespace Enigma::Graphics;
 
 DEFINE_RTTI_OF_BASE(Engine, Texture);
 
+namespace
+{
+    size_t bytesPerPixel(GraphicFormat fmt)
+    {
+        switch (fmt.fmt)
+        {
+        case GraphicFormat::FMT_A8:
+        case GraphicFormat::FMT_L8:
+        case GraphicFormat::FMT_P8:
+        case GraphicFormat::FMT_R3G3B2:
+        case GraphicFormat::FMT_A4L4:
+            return 1;
+        case GraphicFormat::FMT_R5G6B5:
+        case GraphicFormat::FMT_X1R5G5B5:
+        case GraphicFormat::FMT_A1R5G5B5:
+        case GraphicFormat::FMT_A4R4G4B4:
+        case GraphicFormat::FMT_X4R4G4B4:
+        case GraphicFormat::FMT_A8R3G3B2:
+        case GraphicFormat::FMT_A8L8:
+        case GraphicFormat::FMT_A8P8:
+        case GraphicFormat::FMT_V8U8:
+            return 2;
+        case GraphicFormat::FMT_R8G8B8:
+            return 3;
+        case GraphicFormat::FMT_A16B16G16R16:
+            return 8;
+        default:
+            return 4;  // 其他 (和 unknown) 都當 RGBA8 估
+        }
+    }
+}
+
 Texture::Texture(const TextureId& id) : m_factoryDesc(TYPE_RTTI.getName())
 {
     m_id = id;
+    m_isCubeTexture = false;
+    m_surfaceCount = 1;
+    m_lastUsedFrame = 0;
+    m_residentMipBias = 0;
+    m_deviceTextureEpoch = 0;
+    m_isEvicted = false;
+    m_isContentDirty = false;
     m_lazyStatus.changeStatus(LazyStatus::Status::Ready);
 }
 
@@ -30,6 +70,11 @@ Texture::Texture(const TextureId& id, const GenericDto& dto) : m_factoryDesc(TYP
     m_isCubeTexture = textureDto.isCubeTexture();
     m_surfaceCount = textureDto.surfaceCount();
     m_filePaths = textureDto.filePaths();
+    m_lastUsedFrame = 0;
+    m_residentMipBias = 0;
+    m_deviceTextureEpoch = 0;
+    m_isEvicted = false;
+    m_isContentDirty = false;
     m_lazyStatus.changeStatus(LazyStatus::Status::Ghost);
 }
 
@@ -41,6 +86,11 @@ Texture::Texture(const TextureId& id, const ITexturePtr& tex) : m_factoryDesc(TY
     m_isCubeTexture = tex->isCubeTexture();
     m_surfaceCount = tex->isMultiTexture() ? std::dynamic_pointer_cast<IMultiTexture>(tex)->surfaceCount() : 1;
     m_texture = tex;
+    m_lastUsedFrame = 0;
+    m_residentMipBias = 0;
+    m_deviceTextureEpoch = 0;
+    m_isEvicted = false;
+    m_isContentDirty = false;
     m_lazyStatus.changeStatus(LazyStatus::Status::Ready);
 }
 
@@ -103,7 +153,6 @@ void Texture::instanceDeviceTexture(const Graphics::ITexturePtr& tex)
     assert(m_lazyStatus.isLoading());
     assert(m_isCubeTexture == tex->isCubeTexture());
     assert(isMultiTexture() == tex->isMultiTexture());
-    assert(m_dimension == tex->dimension());
     if (isMultiTexture())
     {
         assert(m_surfaceCount == std::dynamic_pointer_cast<IMultiTexture>(tex)->surfaceCount());
@@ -112,7 +161,39 @@ void Texture::instanceDeviceTexture(const Graphics::ITexturePtr& tex)
     {
         assert(m_surfaceCount == 1);
     }
+    unsigned mip_bias = 0;
+    while ((mip_bias < 16) && (tex->dimension().m_width < m_dimension.m_width >> mip_bias)) mip_bias++;
+    assert(tex->dimension() == (MathLib::Dimension<unsigned>{ std::max(1u, m_dimension.m_width >> mip_bias), std::max(1u, m_dimension.m_height >> mip_bias) }));
+    m_residentMipBias = mip_bias;
     m_texture = tex;
+    m_isEvicted = false;
     m_lazyStatus.changeStatus(LazyStatus::Status::Ready);
+    ++m_deviceTextureEpoch;
+}
+
+void Texture::evictDeviceTexture()
+{
+    assert(isEvictable());
+    m_texture = nullptr;
+    m_residentMipBias = 0;
+    m_isEvicted = true;
+    m_lazyStatus.changeStatus(LazyStatus::Status::Ghost);
+    ++m_deviceTextureEpoch;
+}
+
+size_t Texture::estimateResidentBytes() const
+{
+    if (!m_texture) return 0;
+    const unsigned mip_bias = m_residentMipBias;
+    const size_t width = std::max(1u, m_dimension.m_width >> mip_bias);
+    const size_t height = std::max(1u, m_dimension.m_height >> mip_bias);
+    const size_t faces = m_isCubeTexture ? 6 : m_surfaceCount;
+    // 加上 mip chain 約 1/3
+    return width * height * bytesPerPixel(m_format) * faces * 4 / 3;
+}
+
+bool Texture::isEvictable() const
+{
+    return (!m_filePaths.empty()) && (!m_isContentDirty);
 }
 
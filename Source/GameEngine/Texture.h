@@ -17,6 +17,8 @@
 #include "GenericDto.h"
 #include "Frameworks/EventSubscriber.h"
 #include <string>
+#include <atomic>
+#include <cstdint>
 
 namespace Enigma::Engine
 {
@@ -46,7 +48,28 @@ namespace Enigma::Engine
         FactoryDesc& factoryDesc() { return m_factoryDesc; }
 
         const Graphics::ITexturePtr& getDeviceTexture() { return m_texture; }
+        /** device texture 可以是 low mip 版本 (dimension >> mip bias) */
         void instanceDeviceTexture(const Graphics::ITexturePtr& tex);
+        /** drop device texture, back to ghost, can be hydrated again from file paths */
+        void evictDeviceTexture();
+
+        /** residency : frame stamp of last render use */
+        void markUsed(std::uint64_t frame_stamp) { m_lastUsedFrame = frame_stamp; }
+        std::uint64_t lastUsedFrame() const { return m_lastUsedFrame; }
+        /** residency : 0 = full resolution, n = dimension >> n */
+        unsigned residentMipBias() const { return m_residentMipBias; }
+        void residentMipBias(unsigned mip_bias) { m_residentMipBias = mip_bias; }
+        /** estimated device memory of resident mip (with mip chain) */
+        size_t estimateResidentBytes() const;
+        /** only textures loaded from files, and not edited at runtime, can be evicted & hydrated again */
+        bool isEvictable() const;
+        /** evict 之後還沒重新 hydrate */
+        bool isEvicted() const { return m_isEvicted; }
+        /** device texture 內容在 runtime 被改過 (image updater, 地形 splat 繪製...), 跟檔案不一樣了 */
+        void markContentDirty() { m_isContentDirty = true; }
+        bool isContentDirty() const { return m_isContentDirty; }
+        /** 這個 texture 換了 device texture 就會遞增, 讓 binding 的一方知道要重新 bind */
+        std::uint64_t deviceTextureEpoch() const { return m_deviceTextureEpoch; }
 
         const Graphics::GraphicFormat& format() const;
         const MathLib::Dimension<unsigned>& dimension() const;
@@ -65,6 +88,11 @@ namespace Enigma::Engine
         std::vector<std::string> m_filePaths;
         FactoryDesc m_factoryDesc;
         Graphics::ITexturePtr m_texture;
+        std::atomic<std::uint64_t> m_lastUsedFrame;
+        std::atomic<unsigned> m_residentMipBias;
+        std::atomic<std::uint64_t> m_deviceTextureEpoch;
+        std::atomic<bool> m_isEvicted;
+        std::atomic<bool> m_isContentDirty;
     };
 }
 
@@ -0,0 +1,75 @@
+﻿#include "TextureDecodingPipeline.h"
+#include "TextureEvents.h"
+#include "Frameworks/EventPublisher.h"
+#include <algorithm>
+
+using namespace Enigma::Engine;
+
+TextureDecodingPipeline::TextureDecodingPipeline(unsigned worker_count) : m_isStopping(false), m_decodedImageCount(0), m_decodedByteCount(0)
+{
+    if (worker_count == 0)
+    {
+        const unsigned hardware_count = std::thread::hardware_concurrency();
+        worker_count = hardware_count > 1 ? hardware_count - 1 : 1;
+    }
+    m_workers.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; i++)
+    {
+        m_workers.emplace_back([this]() { workerProcedure(); });
+    }
+}
+
+TextureDecodingPipeline::~TextureDecodingPipeline()
+{
+    {
+        std::lock_guard locker{ m_jobLock };
+        m_isStopping = true;
+    }
+    m_jobSignal.notify_all();
+    for (auto& worker : m_workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+}
+
+void TextureDecodingPipeline::submit(const TextureId& id, const std::string& filename, const std::string& path_id, unsigned mip_bias, std::uint64_t generation)
+{
+    {
+        std::lock_guard locker{ m_jobLock };
+        m_jobs.push({ id, filename, path_id, mip_bias, generation });
+    }
+    m_jobSignal.notify_one();
+}
+
+unsigned TextureDecodingPipeline::pendingJobCount()
+{
+    std::lock_guard locker{ m_jobLock };
+    return static_cast<unsigned>(m_jobs.size());
+}
+
+void TextureDecodingPipeline::workerProcedure()
+{
+    while (true)
+    {
+        DecodingJob job;
+        {
+            std::unique_lock locker{ m_jobLock };
+            m_jobSignal.wait(locker, [this]() { return m_isStopping || !m_jobs.empty(); });
+            if (m_isStopping) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        auto image = std::make_shared<DecodedTextureImage>();
+        const auto er = TextureImageDecoder::decodeFile(job.m_filename, job.m_pathId, *image);
+        if (er)
+        {
+            Frameworks::EventPublisher::post(std::make_shared<DecodeTextureImageFailed>(job.m_id, job.m_generation, er));
+            continue;
+        }
+        if (job.m_mipBias > 0) TextureImageDecoder::downsample(*image, job.m_mipBias);
+        m_decodedImageCount++;
+        m_decodedByteCount += image->m_pixels.size();
+        Frameworks::EventPublisher::post(std::make_shared<TextureImageDecoded>(job.m_id, job.m_generation, image));
+    }
+}
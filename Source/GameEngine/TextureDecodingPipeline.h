@@ -0,0 +1,69 @@
+﻿/*********************************************************************
+ * \file   TextureDecodingPipeline.h
+ * \brief  texture streaming stage, 在 worker threads 上讀檔 & 解碼,
+ *         解碼好的 raw pixel 才交給 device 去 upload
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_DECODING_PIPELINE_H
+#define TEXTURE_DECODING_PIPELINE_H
+
+#include "TextureId.h"
+#include "TextureImageDecoder.h"
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace Enigma::Engine
+{
+    class TextureDecodingPipeline
+    {
+    public:
+        /** worker_count == 0 : hardware concurrency - 1 (at least 1) */
+        TextureDecodingPipeline(unsigned worker_count);
+        TextureDecodingPipeline(const TextureDecodingPipeline&) = delete;
+        TextureDecodingPipeline(TextureDecodingPipeline&&) = delete;
+        ~TextureDecodingPipeline();
+        TextureDecodingPipeline& operator=(const TextureDecodingPipeline&) = delete;
+        TextureDecodingPipeline& operator=(TextureDecodingPipeline&&) = delete;
+
+        /** decode on worker thread, result is posted as event
+            @param mip_bias : decoded image 先縮到 dimension >> mip_bias
+            @param generation : 原樣帶在 decoded / failed event 裡, 給呼叫端分辨同一個 texture 的新舊 job */
+        void submit(const TextureId& id, const std::string& filename, const std::string& path_id, unsigned mip_bias, std::uint64_t generation);
+
+        unsigned workerCount() const { return static_cast<unsigned>(m_workers.size()); }
+        unsigned pendingJobCount();
+        std::uint64_t decodedImageCount() const { return m_decodedImageCount; }
+        std::uint64_t decodedByteCount() const { return m_decodedByteCount; }
+
+    protected:
+        struct DecodingJob
+        {
+            TextureId m_id;
+            std::string m_filename;
+            std::string m_pathId;
+            unsigned m_mipBias;
+            std::uint64_t m_generation;
+        };
+
+        void workerProcedure();
+
+    protected:
+        std::vector<std::thread> m_workers;
+        std::queue<DecodingJob> m_jobs;
+        std::mutex m_jobLock;
+        std::condition_variable m_jobSignal;
+        bool m_isStopping;
+
+        std::atomic<std::uint64_t> m_decodedImageCount;
+        std::atomic<std::uint64_t> m_decodedByteCount;
+    };
+}
+
+#endif // TEXTURE_DECODING_PIPELINE_H
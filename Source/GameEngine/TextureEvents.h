@@ -12,10 +12,12 @@
 #include "Frameworks/ExtentTypesDefine.h"
 #include "TextureId.h"
 #include <system_error>
+#include <cstdint>
 
 namespace Enigma::Engine
 {
     class Texture;
+    struct DecodedTextureImage;
 
     class TextureConstituted : public Frameworks::IEvent
     {
@@ -128,7 +130,46 @@ namespace Enigma::Engine
         TextureId m_id;
         std::error_code m_error;
     };
+    //---------------- Decoding Pipeline Events ----------------
+    class TextureImageDecoded : public Frameworks::IEvent
+    {
+    public:
+        TextureImageDecoded(const TextureId& id, std::uint64_t generation, const std::shared_ptr<DecodedTextureImage>& image) : m_id(id), m_generation(generation), m_image(image) {};
+
+        const TextureId& id() const { return m_id; }
+        /** submit 時給的 generation, 用來丟掉過期的 decode */
+        std::uint64_t generation() const { return m_generation; }
+        const std::shared_ptr<DecodedTextureImage>& image() const { return m_image; }
+    private:
+        TextureId m_id;
+        std::uint64_t m_generation;
+        std::shared_ptr<DecodedTextureImage> m_image;
+    };
+    class DecodeTextureImageFailed : public Frameworks::IEvent
+    {
+    public:
+        DecodeTextureImageFailed(const TextureId& id, std::uint64_t generation, std::error_code er) : m_id(id), m_generation(generation), m_error(er) {};
+
+        const TextureId& id() const { return m_id; }
+        std::uint64_t generation() const { return m_generation; }
+        std::error_code error() const { return m_error; }
+    private:
+        TextureId m_id;
+        std::uint64_t m_generation;
+        std::error_code m_error;
+    };
     //---------------- Repository Events ----------------
+    class TextureEvicted : public Frameworks::IEvent
+    {
+    public:
+        TextureEvicted(const TextureId& id, size_t evicted_bytes) : m_id(id), m_evictedBytes(evicted_bytes) {};
+
+        const TextureId& id() { return m_id; }
+        size_t evictedBytes() const { return m_evictedBytes; }
+    private:
+        TextureId m_id;
+        size_t m_evictedBytes;
+    };
     class RemoveTextureFailed : public Frameworks::IEvent
     {
     public:
@@ -5,6 +5,7 @@
 #include "TextureCommands.h"
 #include "Frameworks/EventPublisher.h"
 #include "TextureEvents.h"
+#include <cassert>
 
 using namespace Enigma::Engine;
 
@@ -12,7 +13,7 @@ using error = std::error_code;
 
 TextureFactory::TextureFactory()
 {
-    m_processor = menew TextureResourceProcessor();
+    m_processor = menew TextureResourceProcessor(TextureResourceProcessor::DefaultMaxHydratingCount, 0);
     registerHandlers();
 }
 
@@ -35,13 +36,33 @@ std::shared_ptr<Texture> TextureFactory::create(const TextureId& id)
     return std::make_shared<Texture>(id);
 }
 
-std::shared_ptr<Texture> TextureFactory::constitute(const TextureId& id, const GenericDto& dto, bool is_persisted)
+std::shared_ptr<Texture> TextureFactory::constitute(const TextureId& id, const GenericDto& dto, bool is_persisted, unsigned mip_bias)
 {
     auto texture = std::make_shared<Texture>(id, dto);
-    auto er = m_processor->enqueueHydratingDto(texture, dto);
+    auto er = m_processor->enqueueHydratingDto(texture, dto, mip_bias);
     if (er) return nullptr;
     er = m_processor->hydrateNextTextureResource();
     if (er) return nullptr;
     Frameworks::EventPublisher::post(std::make_shared<TextureConstituted>(id, texture, is_persisted));
     return texture;
 }
+
+error TextureFactory::hydrate(const std::shared_ptr<Texture>& texture, unsigned mip_bias)
+{
+    assert(texture);
+    auto er = m_processor->enqueueHydratingDto(texture, texture->serializeDto(), mip_bias);
+    if (er) return er;
+    return m_processor->hydrateNextTextureResource();
+}
+
+error TextureFactory::streamMip(const std::shared_ptr<Texture>& texture, unsigned mip_bias)
+{
+    assert(texture);
+    return m_processor->streamTextureMip(texture, mip_bias);
+}
+
+bool TextureFactory::isStreamable(const std::shared_ptr<Texture>& texture) const
+{
+    assert(texture);
+    return m_processor->isStreamable(texture);
+}
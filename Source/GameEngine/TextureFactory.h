@@ -12,6 +12,7 @@
 #include "GenericDto.h"
 #include "Frameworks/CommandSubscriber.h"
 #include <memory>
+#include <system_error>
 
 namespace Enigma::Engine
 {
@@ -28,7 +29,12 @@ namespace Enigma::Engine
         void unregisterHandlers();
 
         std::shared_ptr<Texture> create(const TextureId& id);
-        std::shared_ptr<Texture> constitute(const TextureId& id, const GenericDto& dto, bool is_persisted);
+        std::shared_ptr<Texture> constitute(const TextureId& id, const GenericDto& dto, bool is_persisted, unsigned mip_bias);
+        /** hydrate evicted (ghost) texture again */
+        std::error_code hydrate(const std::shared_ptr<Texture>& texture, unsigned mip_bias);
+        /** stream resident texture to higher mip */
+        std::error_code streamMip(const std::shared_ptr<Texture>& texture, unsigned mip_bias);
+        bool isStreamable(const std::shared_ptr<Texture>& texture) const;
 
     private:
         TextureResourceProcessor* m_processor;
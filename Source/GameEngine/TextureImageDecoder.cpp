@@ -0,0 +1,191 @@
+﻿#include "TextureImageDecoder.h"
+#include "EngineErrors.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/Filename.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cctype>
+#include "png.h"
+
+using namespace Enigma::Engine;
+
+namespace
+{
+    // DDS file layout : "DDS " + DDS_HEADER (124 bytes) + data
+    constexpr size_t DDS_MAGIC_SIZE = 4;
+    constexpr size_t DDS_HEADER_SIZE = 124;
+    constexpr size_t DDS_HEIGHT_OFFSET = 8;
+    constexpr size_t DDS_WIDTH_OFFSET = 12;
+    constexpr size_t DDS_MIP_COUNT_OFFSET = 24;
+    constexpr size_t DDS_PIXEL_FORMAT_OFFSET = 72;
+    constexpr size_t DDS_CAPS2_OFFSET = 108;
+    constexpr std::uint32_t DDPF_ALPHAPIXELS = 0x1;
+    constexpr std::uint32_t DDPF_FOURCC = 0x4;
+    constexpr std::uint32_t DDPF_RGB = 0x40;
+    constexpr std::uint32_t DDSCAPS2_CUBEMAP = 0x200;
+
+    std::uint32_t readUint32(const byte_buffer& buff, size_t offset)
+    {
+        std::uint32_t v;
+        memcpy(&v, &buff[offset], sizeof(v));
+        return v;
+    }
+
+    unsigned maskShift(std::uint32_t mask)
+    {
+        if (mask == 0) return 0;
+        unsigned shift = 0;
+        while ((mask & 0x1) == 0)
+        {
+            mask >>= 1;
+            shift++;
+        }
+        return shift;
+    }
+
+    std::string lowerExt(const std::string& filename)
+    {
+        const auto dot = filename.find_last_of('.');
+        if (dot == std::string::npos) return "";
+        std::string ext = filename.substr(dot);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext;
+    }
+}
+
+bool TextureImageDecoder::isDecodable(const std::string& filename)
+{
+    const std::string ext = lowerExt(filename);
+    return (ext == ".png") || (ext == ".dds");
+}
+
+std::error_code TextureImageDecoder::decodeFile(const std::string& filename, const std::string& path_id, DecodedTextureImage& image)
+{
+    FileSystem::Filename filename_at_path(filename, path_id);
+    FileSystem::IFilePtr file = FileSystem::FileSystem::instance()->openFile(filename_at_path.getSubPathFileName(), FileSystem::read | FileSystem::binary, filename_at_path.getMountPathId());
+    if (!file) return ErrorCode::fileIOError;
+    const size_t file_size = file->size();
+    if (file_size == 0)
+    {
+        FileSystem::FileSystem::instance()->closeFile(file);
+        return ErrorCode::fileIOError;
+    }
+    auto buff = file->read(0, file_size);
+    FileSystem::FileSystem::instance()->closeFile(file);
+    if ((!buff) || (buff.value().size() != file_size)) return ErrorCode::fileIOError;
+    return decodeMemory(buff.value(), image);
+}
+
+std::error_code TextureImageDecoder::decodeMemory(const byte_buffer& img_buff, DecodedTextureImage& image)
+{
+    if (img_buff.size() < 8) return ErrorCode::decodeTextureImageFail;
+    if ((img_buff[0] == 'D') && (img_buff[1] == 'D') && (img_buff[2] == 'S') && (img_buff[3] == ' '))
+    {
+        return decodeDds(img_buff, image);
+    }
+    return decodePng(img_buff, image);
+}
+
+void TextureImageDecoder::downsample(DecodedTextureImage& image, unsigned mip_bias)
+{
+    for (unsigned level = 0; level < mip_bias; level++)
+    {
+        const unsigned src_width = image.m_dimension.m_width;
+        const unsigned src_height = image.m_dimension.m_height;
+        if ((src_width <= 1) && (src_height <= 1)) return;
+        const unsigned dst_width = std::max(1u, src_width / 2);
+        const unsigned dst_height = std::max(1u, src_height / 2);
+        // dst 每個 texel 只讀 src 中在它後面的 texel, 可以就地寫回
+        unsigned char* pixels = &image.m_pixels[0];
+        for (unsigned y = 0; y < dst_height; y++)
+        {
+            const unsigned y0 = std::min(y * 2, src_height - 1);
+            const unsigned y1 = std::min(y * 2 + 1, src_height - 1);
+            for (unsigned x = 0; x < dst_width; x++)
+            {
+                const unsigned x0 = std::min(x * 2, src_width - 1);
+                const unsigned x1 = std::min(x * 2 + 1, src_width - 1);
+                const unsigned char* p00 = pixels + (static_cast<size_t>(y0) * src_width + x0) * 4;
+                const unsigned char* p01 = pixels + (static_cast<size_t>(y0) * src_width + x1) * 4;
+                const unsigned char* p10 = pixels + (static_cast<size_t>(y1) * src_width + x0) * 4;
+                const unsigned char* p11 = pixels + (static_cast<size_t>(y1) * src_width + x1) * 4;
+                unsigned char* dst = pixels + (static_cast<size_t>(y) * dst_width + x) * 4;
+                for (unsigned c = 0; c < 4; c++)
+                {
+                    dst[c] = static_cast<unsigned char>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+                }
+            }
+        }
+        image.m_dimension = { dst_width, dst_height };
+        image.m_pixels.resize(static_cast<size_t>(dst_width) * dst_height * 4);
+    }
+}
+
+std::error_code TextureImageDecoder::decodePng(const byte_buffer& img_buff, DecodedTextureImage& image)
+{
+    constexpr size_t PNG_SIGNATURE_SIZE = 8;
+    if ((img_buff.size() < PNG_SIGNATURE_SIZE) || (png_sig_cmp(&img_buff[0], 0, PNG_SIGNATURE_SIZE) != 0)) return ErrorCode::textureImageUnsupported;
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (png_image_begin_read_from_memory(&png, &img_buff[0], img_buff.size()) == 0) return ErrorCode::decodeTextureImageFail;
+    png.format = PNG_FORMAT_RGBA;
+    image.m_pixels.resize(PNG_IMAGE_SIZE(png));
+    if (png_image_finish_read(&png, nullptr, &image.m_pixels[0], 0, nullptr) == 0)
+    {
+        png_image_free(&png);
+        return ErrorCode::decodeTextureImageFail;
+    }
+    image.m_dimension = { png.width, png.height };
+    png_image_free(&png);
+    return ErrorCode::ok;
+}
+
+std::error_code TextureImageDecoder::decodeDds(const byte_buffer& img_buff, DecodedTextureImage& image)
+{
+    if (img_buff.size() < DDS_MAGIC_SIZE + DDS_HEADER_SIZE) return ErrorCode::decodeTextureImageFail;
+    const size_t header = DDS_MAGIC_SIZE;
+    const std::uint32_t height = readUint32(img_buff, header + DDS_HEIGHT_OFFSET);
+    const std::uint32_t width = readUint32(img_buff, header + DDS_WIDTH_OFFSET);
+    const std::uint32_t mip_count = readUint32(img_buff, header + DDS_MIP_COUNT_OFFSET);
+    const std::uint32_t caps2 = readUint32(img_buff, header + DDS_CAPS2_OFFSET);
+    const size_t pf = header + DDS_PIXEL_FORMAT_OFFSET;
+    const std::uint32_t pf_flags = readUint32(img_buff, pf + 4);
+    const std::uint32_t bit_count = readUint32(img_buff, pf + 12);
+    const std::uint32_t r_mask = readUint32(img_buff, pf + 16);
+    const std::uint32_t g_mask = readUint32(img_buff, pf + 20);
+    const std::uint32_t b_mask = readUint32(img_buff, pf + 24);
+    const std::uint32_t a_mask = readUint32(img_buff, pf + 28);
+
+    // 壓縮格式, cube map, mip chain 都交給 device 自己 load
+    if (pf_flags & DDPF_FOURCC) return ErrorCode::textureImageUnsupported;
+    if (!(pf_flags & DDPF_RGB) || (bit_count != 32)) return ErrorCode::textureImageUnsupported;
+    if (caps2 & DDSCAPS2_CUBEMAP) return ErrorCode::textureImageUnsupported;
+    if (mip_count > 1) return ErrorCode::textureImageUnsupported;
+    if ((width == 0) || (height == 0)) return ErrorCode::decodeTextureImageFail;
+
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    const size_t data_offset = DDS_MAGIC_SIZE + DDS_HEADER_SIZE;
+    if (img_buff.size() < data_offset + pixel_count * 4) return ErrorCode::decodeTextureImageFail;
+
+    const unsigned r_shift = maskShift(r_mask);
+    const unsigned g_shift = maskShift(g_mask);
+    const unsigned b_shift = maskShift(b_mask);
+    const unsigned a_shift = maskShift(a_mask);
+    const bool has_alpha = (pf_flags & DDPF_ALPHAPIXELS) && (a_mask != 0);
+    image.m_pixels.resize(pixel_count * 4);
+    const unsigned char* src = &img_buff[data_offset];
+    unsigned char* dst = &image.m_pixels[0];
+    for (size_t i = 0; i < pixel_count; i++, src += 4, dst += 4)
+    {
+        std::uint32_t texel;
+        memcpy(&texel, src, sizeof(texel));
+        dst[0] = static_cast<unsigned char>((texel & r_mask) >> r_shift);
+        dst[1] = static_cast<unsigned char>((texel & g_mask) >> g_shift);
+        dst[2] = static_cast<unsigned char>((texel & b_mask) >> b_shift);
+        dst[3] = has_alpha ? static_cast<unsigned char>((texel & a_mask) >> a_shift) : 0xff;
+    }
+    image.m_dimension = { width, height };
+    return ErrorCode::ok;
+}
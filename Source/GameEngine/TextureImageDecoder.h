@@ -0,0 +1,43 @@
+﻿/*********************************************************************
+ * \file   TextureImageDecoder.h
+ * \brief  decode texture image file into raw RGBA pixels on cpu,
+ *         thread safe, no device involved
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_IMAGE_DECODER_H
+#define TEXTURE_IMAGE_DECODER_H
+
+#include "Frameworks/ExtentTypesDefine.h"
+#include "MathLib/AlgebraBasicTypes.h"
+#include <string>
+#include <system_error>
+
+namespace Enigma::Engine
+{
+    struct DecodedTextureImage
+    {
+        MathLib::Dimension<unsigned> m_dimension{ 0, 0 };
+        byte_buffer m_pixels;  ///< RGBA8, row major, top row first
+    };
+
+    class TextureImageDecoder
+    {
+    public:
+        /** can this file be decoded on cpu? (by file extension) */
+        static bool isDecodable(const std::string& filename);
+
+        /** read file & decode, image 中 pixel buffer 的 capacity 會被重複利用
+            @return textureImageUnsupported : 格式不支援, 要改走 device 的 load 流程 */
+        static std::error_code decodeFile(const std::string& filename, const std::string& path_id, DecodedTextureImage& image);
+        static std::error_code decodeMemory(const byte_buffer& img_buff, DecodedTextureImage& image);
+        /** box filter down to mip level (dimension >> mip_bias), in place */
+        static void downsample(DecodedTextureImage& image, unsigned mip_bias);
+
+    protected:
+        static std::error_code decodePng(const byte_buffer& img_buff, DecodedTextureImage& image);
+        static std::error_code decodeDds(const byte_buffer& img_buff, DecodedTextureImage& image);
+    };
+}
+
+#endif // TEXTURE_IMAGE_DECODER_H
@@ -46,6 +46,8 @@ void TextureImageUpdater::updateTextureImage(const std::shared_ptr<Texture>& tar
     m_targetTextureRect = image_rect;
     if ((target_tex) && target_tex->getDeviceTexture())
     {
+        // 改過的內容只在 device texture 上, 不可以 evict 或從檔案重新 load
+        target_tex->markContentDirty();
         target_tex->getDeviceTexture()->update(m_targetTextureRect, image_buff);
     }
     else
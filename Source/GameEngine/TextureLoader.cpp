@@ -57,6 +57,7 @@ void TextureLoader::loadImage(const std::shared_ptr<Texture>& texture, const Tex
     assert(texture);
     m_contentingTexture = texture;
     m_textureDto = dto;
+    m_decodedImage = nullptr;
     if (m_contentingTexture->isMultiTexture())
     {
         CommandBus::post(std::make_shared<CreateDeviceMultiTexture>(m_contentingTexture->id().name()));
@@ -67,6 +68,17 @@ void TextureLoader::loadImage(const std::shared_ptr<Texture>& texture, const Tex
     }
 }
 
+void TextureLoader::loadDecodedImage(const std::shared_ptr<Texture>& texture, const TextureDto& dto, const std::shared_ptr<DecodedTextureImage>& image)
+{
+    assert(texture);
+    assert(image);
+    assert(!texture->isMultiTexture());
+    m_contentingTexture = texture;
+    m_textureDto = dto;
+    m_decodedImage = image;
+    CommandBus::post(std::make_shared<CreateDeviceTexture>(m_contentingTexture->id().name()));
+}
+
 void TextureLoader::loadResourceTextures(const std::shared_ptr<Graphics::ITexture>& dev_tex)
 {
     assert(m_contentingTexture);
@@ -122,7 +134,13 @@ void TextureLoader::onDeviceTextureCreated(const IEventPtr& e)
         failLoadingImage(ErrorCode::findStashedAssetFail);
         return;
     }
-    if (!m_textureDto.filePaths().empty())
+    if (m_decodedImage)
+    {
+        // decode 好的 pixel 直接 move 給 graphic thread 的 task, 不再複製一份
+        texture.value()->create(m_decodedImage->m_dimension, std::move(m_decodedImage->m_pixels));
+        m_decodedImage = nullptr;
+    }
+    else if (!m_textureDto.filePaths().empty())
     {
         loadResourceTextures(texture.value());
     }
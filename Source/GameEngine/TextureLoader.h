@@ -11,6 +11,7 @@
 #include "Frameworks/EventSubscriber.h"
 #include "Texture.h"
 #include "TextureDto.h"
+#include "TextureImageDecoder.h"
 #include <memory>
 
 namespace Enigma::Engine
@@ -50,6 +51,8 @@ namespace Enigma::Engine
         TextureLoader& operator=(TextureLoader&&) = delete;
 
         void loadImage(const std::shared_ptr<Texture>& texture, const TextureDto& dto);
+        /** upload cpu decoded image to device, no decoding in device texture */
+        void loadDecodedImage(const std::shared_ptr<Texture>& texture, const TextureDto& dto, const std::shared_ptr<DecodedTextureImage>& image);
 
     private:
         void onDeviceTextureCreated(const Enigma::Frameworks::IEventPtr& e);
@@ -65,6 +68,7 @@ namespace Enigma::Engine
     private:
         TextureDto m_textureDto;
         std::shared_ptr<Texture> m_contentingTexture;
+        std::shared_ptr<DecodedTextureImage> m_decodedImage;
 
         Enigma::Frameworks::EventSubscriberPtr m_onTextureCreated;
         Enigma::Frameworks::EventSubscriberPtr m_onMultiTextureCreated;
@@ -1,5 +1,6 @@
 ﻿#include "TextureRepository.h"
 #include "TextureFactory.h"
+#include "TextureResidencyManager.h"
 #include "TextureStoreMapper.h"
 #include "Platforms/MemoryMacro.h"
 #include "TextureCommands.h"
@@ -19,13 +20,17 @@ DEFINE_RTTI(Engine, TextureRepository, ISystemService);
 TextureRepository::TextureRepository(Frameworks::ServiceManager* srv_manager, const std::shared_ptr<TextureStoreMapper>& store_mapper) : ISystemService(srv_manager), m_storeMapper(store_mapper)
 {
     m_factory = menew TextureFactory();
-    m_needTick = false;
+    // 預設不限預算, 不先 load low mip, 行為跟原本一樣
+    m_residencyManager = menew TextureResidencyManager(TextureResidencyManager::UnlimitedBudget, 0, 2);
+    m_isResidencyIdle = false;
+    m_needTick = true;
     registerHandlers();
 }
 
 TextureRepository::~TextureRepository()
 {
     unregisterHandlers();
+    SAFE_DELETE(m_residencyManager);
     SAFE_DELETE(m_factory);
 }
 
@@ -37,6 +42,12 @@ Enigma::Frameworks::ServiceResult TextureRepository::onInit()
     return Frameworks::ServiceResult::Complete;
 }
 
+Enigma::Frameworks::ServiceResult TextureRepository::onTick()
+{
+    updateResidency();
+    return Frameworks::ServiceResult::Pendding;
+}
+
 Enigma::Frameworks::ServiceResult TextureRepository::onTerm()
 {
     assert(m_storeMapper);
@@ -91,7 +102,7 @@ std::shared_ptr<Texture> TextureRepository::queryTexture(const TextureId& id)
     assert(m_factory);
     const auto dto = m_storeMapper->queryTexture(id);
     assert(dto.has_value());
-    auto tex = m_factory->constitute(id, dto.value(), true);
+    auto tex = m_factory->constitute(id, dto.value(), true, m_residencyManager->initialMipBias());
     assert(tex);
     m_textures.insert_or_assign(id, tex);
     return tex;
@@ -158,7 +169,66 @@ void TextureRepository::requestTextureConstitution(const Frameworks::IQueryPtr&
         Frameworks::EventPublisher::post(std::make_shared<ConstituteTextureFailed>(request->id(), ErrorCode::textureAlreadyExists));
         return;
     }
-    auto tex = m_factory->constitute(request->id(), request->dto(), false);
+    auto tex = m_factory->constitute(request->id(), request->dto(), false, m_residencyManager->initialMipBias());
     request->setResult(tex);
     m_textures.insert_or_assign(request->id(), tex);
 }
+
+void TextureRepository::updateResidency()
+{
+    assert(m_residencyManager);
+    // 不限預算就不會 evict; 沒有 evicted 的要 hydrate, 新 load 的也都是 full resolution, 就沒事可做, 不用每個 frame 鎖住掃一遍
+    if ((m_isResidencyIdle) && (m_residencyManager->budgetBytes() == TextureResidencyManager::UnlimitedBudget)
+        && (m_residencyManager->initialMipBias() == 0))
+    {
+        m_residencyManager->advanceFrame();
+        return;
+    }
+    bool has_pending_textures = false;  // evicted 或還在 loading (可能是 low mip)
+    std::vector<std::shared_ptr<Texture>> resident_textures;
+    std::vector<std::shared_ptr<Texture>> streamable_textures;
+    std::vector<std::shared_ptr<Texture>> rehydrating_textures;
+    {
+        std::lock_guard locker{ m_textureMapLock };
+        for (auto& [id, tex] : m_textures)
+        {
+            if (!tex) continue;
+            if ((tex->lazyStatus().isReady()) && (tex->getDeviceTexture()))
+            {
+                resident_textures.emplace_back(tex);
+                if ((tex->residentMipBias() > 0) && (m_factory->isStreamable(tex))) streamable_textures.emplace_back(tex);
+            }
+            else if (m_residencyManager->isRehydrateNeeded(tex))
+            {
+                rehydrating_textures.emplace_back(tex);
+            }
+            if ((tex->isEvicted()) || (tex->lazyStatus().isLoading())) has_pending_textures = true;
+        }
+    }
+    for (auto& tex : m_residencyManager->selectEvictions(resident_textures))
+    {
+        evictTexture(tex);
+    }
+    for (auto& tex : rehydrating_textures)
+    {
+        error er = m_factory->hydrate(tex, m_residencyManager->initialMipBias());
+        if (er) Platforms::Debug::ErrorPrintf("hydrate evicted texture %s failed : %s\n", tex->id().name().c_str(), er.message().c_str());
+    }
+    const size_t resident_bytes = TextureResidencyManager::residentBytes(resident_textures);
+    for (auto& tex : m_residencyManager->selectMipUpgrades(streamable_textures, resident_bytes))
+    {
+        m_factory->streamMip(tex, 0);
+    }
+    m_isResidencyIdle = (m_residencyManager->budgetBytes() == TextureResidencyManager::UnlimitedBudget)
+        && (!has_pending_textures) && (streamable_textures.empty());
+    m_residencyManager->advanceFrame();
+}
+
+void TextureRepository::evictTexture(const std::shared_ptr<Texture>& texture)
+{
+    assert(texture);
+    const size_t bytes = texture->estimateResidentBytes();
+    texture->evictDeviceTexture();
+    m_residencyManager->recordEviction(bytes);
+    Frameworks::EventPublisher::post(std::make_shared<TextureEvicted>(texture->id(), bytes));
+}
@@ -24,6 +24,7 @@ namespace Enigma::Engine
     class TextureImageUpdater;
     class TextureStoreMapper;
     class TextureFactory;
+    class TextureResidencyManager;
 
     class TextureRepository : public Frameworks::ISystemService
     {
@@ -37,9 +38,15 @@ namespace Enigma::Engine
         TextureRepository& operator=(TextureRepository&&) = delete;
 
         virtual Frameworks::ServiceResult onInit() override;
+        virtual Frameworks::ServiceResult onTick() override;
         virtual Frameworks::ServiceResult onTerm() override;
 
         TextureFactory* factory() { return m_factory; }
+        TextureResidencyManager* residencyManager() { return m_residencyManager; }
+
+        /** evict over budget textures, hydrate evicted textures used again, stream up low mips;
+            不限預算又沒有 evicted / low mip texture 時不掃 texture map */
+        void updateResidency();
 
         bool hasTexture(const TextureId& id);
         std::shared_ptr<Texture> queryTexture(const TextureId& id);
@@ -55,9 +62,13 @@ namespace Enigma::Engine
         void queryTexture(const Frameworks::IQueryPtr& q);
         void requestTextureConstitution(const Frameworks::IQueryPtr& q);
 
+        void evictTexture(const std::shared_ptr<Texture>& texture);
+
     private:
         std::shared_ptr<TextureStoreMapper> m_storeMapper;
         TextureFactory* m_factory;
+        TextureResidencyManager* m_residencyManager;
+        bool m_isResidencyIdle;  ///< 上次掃描時不限預算, 也沒有 evicted 或 low mip texture
 
         Frameworks::CommandSubscriberPtr m_removeTexture;
         Frameworks::CommandSubscriberPtr m_putTexture;
@@ -0,0 +1,101 @@
+﻿#include "TextureResidencyManager.h"
+#include "Texture.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::Engine;
+
+std::atomic<std::uint64_t> TextureResidencyManager::m_frameStamp = 1;  // 0 留給從沒用過的 texture
+
+TextureResidencyManager::TextureResidencyManager(size_t budget_bytes, unsigned initial_mip_bias, unsigned grace_frames)
+    : m_budgetBytes(budget_bytes), m_initialMipBias(initial_mip_bias), m_graceFrames(grace_frames), m_evictedCount(0), m_evictedBytes(0)
+{
+}
+
+TextureResidencyManager::~TextureResidencyManager()
+{
+}
+
+void TextureResidencyManager::advanceFrame()
+{
+    ++m_frameStamp;
+}
+
+size_t TextureResidencyManager::residentBytes(const std::vector<std::shared_ptr<Texture>>& resident_textures)
+{
+    size_t bytes = 0;
+    for (const auto& tex : resident_textures)
+    {
+        if (tex) bytes += tex->estimateResidentBytes();
+    }
+    return bytes;
+}
+
+std::vector<std::shared_ptr<Texture>> TextureResidencyManager::selectEvictions(const std::vector<std::shared_ptr<Texture>>& resident_textures) const
+{
+    size_t resident_bytes = residentBytes(resident_textures);
+    if (resident_bytes <= m_budgetBytes) return {};
+
+    std::vector<std::shared_ptr<Texture>> candidates;
+    for (const auto& tex : resident_textures)
+    {
+        if ((!tex) || (!tex->isEvictable()) || (isRecentlyUsed(tex))) continue;
+        candidates.emplace_back(tex);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const auto& a, const auto& b) { return a->lastUsedFrame() < b->lastUsedFrame(); });
+
+    std::vector<std::shared_ptr<Texture>> evictions;
+    for (const auto& tex : candidates)
+    {
+        if (resident_bytes <= m_budgetBytes) break;
+        resident_bytes -= std::min(resident_bytes, tex->estimateResidentBytes());
+        evictions.emplace_back(tex);
+    }
+    return evictions;
+}
+
+bool TextureResidencyManager::isRehydrateNeeded(const std::shared_ptr<Texture>& texture) const
+{
+    assert(texture);
+    if (!texture->lazyStatus().isGhost()) return false;
+    if (!texture->isEvictable()) return false;
+    return isRecentlyUsed(texture);
+}
+
+std::vector<std::shared_ptr<Texture>> TextureResidencyManager::selectMipUpgrades(const std::vector<std::shared_ptr<Texture>>& streamable_textures, size_t resident_bytes) const
+{
+    std::vector<std::shared_ptr<Texture>> candidates;
+    for (const auto& tex : streamable_textures)
+    {
+        if ((!tex) || (tex->residentMipBias() == 0) || (!isRecentlyUsed(tex))) continue;
+        candidates.emplace_back(tex);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const auto& a, const auto& b) { return a->lastUsedFrame() > b->lastUsedFrame(); });
+
+    std::vector<std::shared_ptr<Texture>> upgrades;
+    for (const auto& tex : candidates)
+    {
+        // full resolution 約是目前 mip 的 4^bias 倍
+        const size_t current_bytes = tex->estimateResidentBytes();
+        const size_t full_bytes = current_bytes << (2 * tex->residentMipBias());
+        if (resident_bytes - current_bytes + full_bytes > m_budgetBytes) continue;
+        resident_bytes = resident_bytes - current_bytes + full_bytes;
+        upgrades.emplace_back(tex);
+    }
+    return upgrades;
+}
+
+void TextureResidencyManager::recordEviction(size_t bytes)
+{
+    m_evictedCount++;
+    m_evictedBytes += bytes;
+}
+
+bool TextureResidencyManager::isRecentlyUsed(const std::shared_ptr<Texture>& texture) const
+{
+    const std::uint64_t last_used = texture->lastUsedFrame();
+    if (last_used == 0) return false;
+    return last_used + m_graceFrames >= m_frameStamp;
+}
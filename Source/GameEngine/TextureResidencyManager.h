@@ -0,0 +1,75 @@
+﻿/*********************************************************************
+ * \file   TextureResidencyManager.h
+ * \brief  texture residency policy, 記憶體預算 & LRU eviction & mip streaming,
+ *         只做決策, 不碰 device, 由 TextureRepository 執行
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_RESIDENCY_MANAGER_H
+#define TEXTURE_RESIDENCY_MANAGER_H
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace Enigma::Engine
+{
+    class Texture;
+
+    class TextureResidencyManager
+    {
+    public:
+        static constexpr size_t UnlimitedBudget = std::numeric_limits<size_t>::max();
+    public:
+        /** @param budget_bytes : resident textures 的估計記憶體上限
+            @param initial_mip_bias : 第一次 hydrate 時先 load 的 low mip, 0 = full resolution
+            @param grace_frames : 最近幾個 frame 用過的 texture 不 evict */
+        TextureResidencyManager(size_t budget_bytes, unsigned initial_mip_bias, unsigned grace_frames);
+        TextureResidencyManager(const TextureResidencyManager&) = delete;
+        TextureResidencyManager(TextureResidencyManager&&) = delete;
+        ~TextureResidencyManager();
+        TextureResidencyManager& operator=(const TextureResidencyManager&) = delete;
+        TextureResidencyManager& operator=(TextureResidencyManager&&) = delete;
+
+        /** frame stamp for Texture::markUsed */
+        static std::uint64_t frameStamp() { return m_frameStamp; }
+        void advanceFrame();
+
+        size_t budgetBytes() const { return m_budgetBytes; }
+        void budgetBytes(size_t budget) { m_budgetBytes = budget; }
+        unsigned initialMipBias() const { return m_initialMipBias; }
+        void initialMipBias(unsigned mip_bias) { m_initialMipBias = mip_bias; }
+        unsigned graceFrames() const { return m_graceFrames; }
+        void graceFrames(unsigned frames) { m_graceFrames = frames; }
+
+        static size_t residentBytes(const std::vector<std::shared_ptr<Texture>>& resident_textures);
+
+        /** least recently used first, until resident bytes fit in budget */
+        std::vector<std::shared_ptr<Texture>> selectEvictions(const std::vector<std::shared_ptr<Texture>>& resident_textures) const;
+        /** ghost (evicted) texture used in last frames, should be hydrated again */
+        bool isRehydrateNeeded(const std::shared_ptr<Texture>& texture) const;
+        /** low mip textures used recently, most recently used first, while budget headroom remains */
+        std::vector<std::shared_ptr<Texture>> selectMipUpgrades(const std::vector<std::shared_ptr<Texture>>& streamable_textures, size_t resident_bytes) const;
+
+        void recordEviction(size_t bytes);
+        std::uint64_t evictedCount() const { return m_evictedCount; }
+        std::uint64_t evictedBytes() const { return m_evictedBytes; }
+
+    protected:
+        bool isRecentlyUsed(const std::shared_ptr<Texture>& texture) const;
+
+    protected:
+        static std::atomic<std::uint64_t> m_frameStamp;
+
+        size_t m_budgetBytes;
+        unsigned m_initialMipBias;
+        unsigned m_graceFrames;
+
+        std::uint64_t m_evictedCount;
+        std::uint64_t m_evictedBytes;
+    };
+}
+
+#endif // TEXTURE_RESIDENCY_MANAGER_H
@@ -1,5 +1,6 @@
 ﻿#include "TextureResourceProcessor.h"
 #include "TextureLoader.h"
+#include "TextureDecodingPipeline.h"
 #include "TextureSaver.h"
 #include "TextureImageUpdater.h"
 #include "Platforms/MemoryMacro.h"
@@ -10,12 +11,19 @@
 #include "TextureEvents.h"
 #include "TextureCommands.h"
 #include "Platforms/PlatformLayer.h"
+#include <algorithm>
 
 using namespace Enigma::Engine;
 
-TextureResourceProcessor::TextureResourceProcessor()
+TextureResourceProcessor::TextureResourceProcessor(unsigned max_hydrating_count, unsigned decoding_worker_count) : m_lastDecodeGeneration(0)
 {
-    m_loader = menew TextureLoader();
+    assert(max_hydrating_count > 0);
+    m_loaders.reserve(max_hydrating_count);
+    for (unsigned i = 0; i < max_hydrating_count; i++)
+    {
+        m_loaders.emplace_back(menew TextureLoader());
+    }
+    m_decodingPipeline = menew TextureDecodingPipeline(decoding_worker_count);
     m_saver = menew TextureSaver();
     m_imageUpdater = menew TextureImageUpdater();
     registerHandlers();
@@ -23,7 +31,12 @@ TextureResourceProcessor::TextureResourceProcessor()
 
 TextureResourceProcessor::~TextureResourceProcessor()
 {
-    SAFE_DELETE(m_loader);
+    SAFE_DELETE(m_decodingPipeline);
+    for (auto& loader : m_loaders)
+    {
+        SAFE_DELETE(loader);
+    }
+    m_loaders.clear();
     SAFE_DELETE(m_saver);
     SAFE_DELETE(m_imageUpdater);
     unregisterHandlers();
@@ -35,6 +48,10 @@ void TextureResourceProcessor::registerHandlers()
     Frameworks::EventPublisher::subscribe(typeid(TextureLoader::TextureLoaded), m_onLoaderTextureLoaded);
     m_onLoaderLoadTextureFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onLoaderLoadTextureFailed(e); });
     Frameworks::EventPublisher::subscribe(typeid(TextureLoader::LoadTextureFailed), m_onLoaderLoadTextureFailed);
+    m_onTextureImageDecoded = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onTextureImageDecoded(e); });
+    Frameworks::EventPublisher::subscribe(typeid(TextureImageDecoded), m_onTextureImageDecoded);
+    m_onDecodeTextureImageFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onDecodeTextureImageFailed(e); });
+    Frameworks::EventPublisher::subscribe(typeid(DecodeTextureImageFailed), m_onDecodeTextureImageFailed);
     m_onSaverTextureSaved = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onSaverTextureSaved(e); });
     Frameworks::EventPublisher::subscribe(typeid(TextureSaver::TextureSaved), m_onSaverTextureSaved);
     m_onSaverSaveTextureFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onSaverSaveTextureFailed(e); });
@@ -53,6 +70,10 @@ void TextureResourceProcessor::unregisterHandlers()
     m_onLoaderTextureLoaded = nullptr;
     Frameworks::EventPublisher::unsubscribe(typeid(TextureLoader::LoadTextureFailed), m_onLoaderLoadTextureFailed);
     m_onLoaderLoadTextureFailed = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(TextureImageDecoded), m_onTextureImageDecoded);
+    m_onTextureImageDecoded = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(DecodeTextureImageFailed), m_onDecodeTextureImageFailed);
+    m_onDecodeTextureImageFailed = nullptr;
     Frameworks::EventPublisher::unsubscribe(typeid(TextureSaver::TextureSaved), m_onSaverTextureSaved);
     m_onSaverTextureSaved = nullptr;
     Frameworks::EventPublisher::unsubscribe(typeid(TextureSaver::SaveTextureFailed), m_onSaverSaveTextureFailed);
@@ -65,34 +86,102 @@ void TextureResourceProcessor::unregisterHandlers()
     m_enqueueUpdatingImage = nullptr;
 }
 
-std::error_code TextureResourceProcessor::enqueueHydratingDto(const std::shared_ptr<Texture>& texture, const GenericDto& dto)
+std::error_code TextureResourceProcessor::enqueueHydratingDto(const std::shared_ptr<Texture>& texture, const GenericDto& dto, unsigned mip_bias)
 {
     assert(texture);
     if (!texture->lazyStatus().isGhost()) return ErrorCode::textureAlreadyLoaded;
     std::lock_guard locker{ m_hydratingQueueLock };
-    m_hydratingQueue.push({ texture, TextureDto::fromGenericDto(dto) });
+    m_hydratingQueue.push({ texture, TextureDto::fromGenericDto(dto), std::nullopt, mip_bias, 0 });
     texture->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::InQueue);
     return ErrorCode::ok;
 }
 
 std::error_code TextureResourceProcessor::hydrateNextTextureResource()
 {
-    if (m_currentHydratingTexture) return ErrorCode::ok;
-    assert(m_loader);
+    assert(m_decodingPipeline);
     std::lock_guard locker{ m_hydratingQueueLock };
-    if (m_hydratingQueue.empty())
+    while ((!m_hydratingQueue.empty()) && (m_hydratingTextures.size() < m_loaders.size()))
     {
-        m_currentHydratingTexture = nullptr;
-        return ErrorCode::ok;
+        auto hydrating = m_hydratingQueue.front();
+        m_hydratingQueue.pop();
+        auto& texture = hydrating.m_texture;
+        texture->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
+        // 之前還沒回來的 streaming decode 都作廢
+        m_streamingTextures.erase(texture->id());
+        if (isCpuDecodable(texture, hydrating.m_dto.filePaths()))
+        {
+            hydrating.m_decodeGeneration = ++m_lastDecodeGeneration;
+            m_hydratingTextures.insert_or_assign(texture->id(), hydrating);
+            m_decodingPipeline->submit(texture->id(), hydrating.m_dto.filePaths()[0], "", hydrating.m_mipBias, hydrating.m_decodeGeneration);
+        }
+        else
+        {
+            m_hydratingTextures.insert_or_assign(texture->id(), hydrating);
+            loadByDevice(texture->id());
+        }
     }
-    auto& [texture, dto] = m_hydratingQueue.front();
-    m_currentHydratingTexture = texture;
-    m_loader->loadImage(texture, dto);
-    texture->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
-    m_hydratingQueue.pop();
     return ErrorCode::ok;
 }
 
+std::error_code TextureResourceProcessor::streamTextureMip(const std::shared_ptr<Texture>& texture, unsigned mip_bias)
+{
+    assert(texture);
+    assert(m_decodingPipeline);
+    if (!texture->lazyStatus().isReady()) return ErrorCode::textureNotReady;
+    if (!isStreamable(texture)) return ErrorCode::textureImageUnsupported;
+    if (texture->residentMipBias() <= mip_bias) return ErrorCode::ok;
+    std::lock_guard locker{ m_hydratingQueueLock };
+    if (m_streamingTextures.find(texture->id()) != m_streamingTextures.end()) return ErrorCode::ok;
+    const std::uint64_t generation = ++m_lastDecodeGeneration;
+    m_streamingTextures.insert_or_assign(texture->id(), StreamingTexture{ texture, mip_bias, generation });
+    m_decodingPipeline->submit(texture->id(), texture->filePaths()[0], "", mip_bias, generation);
+    return ErrorCode::ok;
+}
+
+bool TextureResourceProcessor::isStreamable(const std::shared_ptr<Texture>& texture) const
+{
+    // streaming 會從檔案重新 load, runtime 改過的 texture 不行
+    return (texture->isEvictable()) && (isCpuDecodable(texture, texture->filePaths()));
+}
+
+bool TextureResourceProcessor::isCpuDecodable(const std::shared_ptr<Texture>& texture, const std::vector<std::string>& file_paths) const
+{
+    if (texture->isMultiTexture()) return false;
+    if (texture->isCubeTexture()) return false;
+    if (file_paths.size() != 1) return false;
+    return TextureImageDecoder::isDecodable(file_paths[0]);
+}
+
+void TextureResourceProcessor::loadByDevice(const TextureId& id)
+{
+    std::lock_guard locker{ m_hydratingQueueLock };
+    const auto it = m_hydratingTextures.find(id);
+    if (it == m_hydratingTextures.end()) return;
+    const auto loader_index = findIdleLoader();
+    assert(loader_index);  // loader count == max hydrating count
+    it->second.m_loaderIndex = loader_index;
+    m_loaders[loader_index.value()]->loadImage(it->second.m_texture, it->second.m_dto);
+}
+
+std::optional<unsigned> TextureResourceProcessor::findIdleLoader() const
+{
+    // loader 在 completeHydrating 之前都還算被佔用 (decoded image 要等那時回收)
+    for (unsigned i = 0; i < m_loaders.size(); i++)
+    {
+        if (std::none_of(m_hydratingTextures.begin(), m_hydratingTextures.end(),
+            [i](const auto& hydrating) { return hydrating.second.m_loaderIndex == i; })) return i;
+    }
+    return std::nullopt;
+}
+
+void TextureResourceProcessor::completeHydrating(const TextureId& id)
+{
+    std::lock_guard locker{ m_hydratingQueueLock };
+    const auto it = m_hydratingTextures.find(id);
+    if (it == m_hydratingTextures.end()) return;
+    m_hydratingTextures.erase(it);
+}
+
 std::error_code TextureResourceProcessor::enqueueSavingTexture(const std::shared_ptr<Texture>& texture, const std::shared_ptr<FileSystem::IFile>& file)
 {
     assert(texture);
@@ -172,26 +261,93 @@ std::error_code TextureResourceProcessor::processNextTextureResource()
 
 void TextureResourceProcessor::onLoaderTextureLoaded(const Frameworks::IEventPtr& e)
 {
-    assert(m_loader);
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<TextureLoader::TextureLoaded>(e);
     if (!ev) return;
-    if (ev->id() != m_currentHydratingTexture->id()) return;
+    {
+        std::lock_guard locker{ m_hydratingQueueLock };
+        if (m_hydratingTextures.find(ev->id()) == m_hydratingTextures.end()) return;
+    }
     Frameworks::EventPublisher::post(std::make_shared<TextureHydrated>(ev->id(), ev->texture()));
-    m_currentHydratingTexture = nullptr;
+    completeHydrating(ev->id());
     const auto er = hydrateNextTextureResource();
     assert(!er);
 }
 
 void TextureResourceProcessor::onLoaderLoadTextureFailed(const Frameworks::IEventPtr& e)
 {
-    assert(m_loader);
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<TextureLoader::LoadTextureFailed>(e);
     if (!ev) return;
+    {
+        std::lock_guard locker{ m_hydratingQueueLock };
+        if (m_hydratingTextures.find(ev->id()) == m_hydratingTextures.end()) return;
+    }
     Platforms::Debug::ErrorPrintf("texture %s load failed : %s\n", ev->id().name().c_str(), ev->error().message().c_str());
     Frameworks::EventPublisher::post(std::make_shared<HydrateTextureFailed>(ev->id(), ev->error()));
-    m_currentHydratingTexture = nullptr;
+    completeHydrating(ev->id());
+    const auto er = hydrateNextTextureResource();
+    assert(!er);
+}
+
+void TextureResourceProcessor::onTextureImageDecoded(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<TextureImageDecoded>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_hydratingQueueLock };
+    if (const auto it = m_hydratingTextures.find(ev->id());
+        (it != m_hydratingTextures.end()) && (it->second.m_decodeGeneration == ev->generation()))
+    {
+        const auto loader_index = findIdleLoader();
+        assert(loader_index);  // loader count == max hydrating count
+        it->second.m_loaderIndex = loader_index;
+        m_loaders[loader_index.value()]->loadDecodedImage(it->second.m_texture, it->second.m_dto, ev->image());
+        return;
+    }
+    if (const auto streaming = m_streamingTextures.find(ev->id());
+        (streaming != m_streamingTextures.end()) && (streaming->second.m_decodeGeneration == ev->generation()))
+    {
+        auto [texture, mip_bias, generation] = streaming->second;
+        m_streamingTextures.erase(streaming);
+        // 串流中被 evict 了, 就不用再 upload
+        if ((texture->lazyStatus().isReady()) && (texture->getDeviceTexture()))
+        {
+            // 同一個 device texture 物件重建內容, 已 bind 的 effect 不用更新
+            texture->getDeviceTexture()->create(ev->image()->m_dimension, std::move(ev->image()->m_pixels));
+            texture->residentMipBias(mip_bias);
+        }
+    }
+    // 其他的是過期的 decode (texture 之後又重新 hydrate 或 stream 過), pixel 隨 event 一起釋放
+}
+
+void TextureResourceProcessor::onDecodeTextureImageFailed(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<DecodeTextureImageFailed>(e);
+    if (!ev) return;
+    {
+        std::lock_guard locker{ m_hydratingQueueLock };
+        if (const auto streaming = m_streamingTextures.find(ev->id());
+            (streaming != m_streamingTextures.end()) && (streaming->second.m_decodeGeneration == ev->generation()))
+        {  // 串流失敗就留在原本的 mip
+            m_streamingTextures.erase(streaming);
+            Platforms::Debug::ErrorPrintf("texture %s stream mip failed : %s\n", ev->id().name().c_str(), ev->error().message().c_str());
+            return;
+        }
+        const auto it = m_hydratingTextures.find(ev->id());
+        if ((it == m_hydratingTextures.end()) || (it->second.m_decodeGeneration != ev->generation())) return;
+        // 改由 device load 或是失敗結束, 之後同一個 generation 不會再有 decode 結果
+        it->second.m_decodeGeneration = 0;
+    }
+    if (ev->error() == ErrorCode::textureImageUnsupported)
+    {  // cpu 不能解的格式, 交給 device 去 load
+        loadByDevice(ev->id());
+        return;
+    }
+    Platforms::Debug::ErrorPrintf("texture %s decode failed : %s\n", ev->id().name().c_str(), ev->error().message().c_str());
+    Frameworks::EventPublisher::post(std::make_shared<HydrateTextureFailed>(ev->id(), ev->error()));
+    completeHydrating(ev->id());
     const auto er = hydrateNextTextureResource();
     assert(!er);
 }
@@ -16,9 +16,13 @@
 #include "Frameworks/ExtentTypesDefine.h"
 #include "MathLib/Rect.h"
 #include <system_error>
+#include <optional>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
 
 namespace Enigma::Engine
 {
@@ -26,15 +30,24 @@ namespace Enigma::Engine
     class TextureLoader;
     class TextureSaver;
     class TextureImageUpdater;
+    class TextureDecodingPipeline;
 
     class TextureResourceProcessor
     {
     public:
-        TextureResourceProcessor();
+        static constexpr unsigned DefaultMaxHydratingCount = 4;
+    public:
+        /** @param max_hydrating_count : textures in flight (decoding + uploading)
+            @param decoding_worker_count : cpu decoding threads, 0 : hardware concurrency - 1 */
+        TextureResourceProcessor(unsigned max_hydrating_count, unsigned decoding_worker_count);
         ~TextureResourceProcessor();
 
-        std::error_code enqueueHydratingDto(const std::shared_ptr<Texture>& texture, const GenericDto& dto);
+        /** @param mip_bias : cpu 可解碼的 texture 先 load low mip (dimension >> mip_bias) */
+        std::error_code enqueueHydratingDto(const std::shared_ptr<Texture>& texture, const GenericDto& dto, unsigned mip_bias);
         std::error_code hydrateNextTextureResource();
+        /** stream a resident texture to a higher mip (smaller mip bias), device texture is re-created in place */
+        std::error_code streamTextureMip(const std::shared_ptr<Texture>& texture, unsigned mip_bias);
+        bool isStreamable(const std::shared_ptr<Texture>& texture) const;
 
         std::error_code enqueueSavingTexture(const std::shared_ptr<Texture>& texture, const std::shared_ptr<FileSystem::IFile>& file);
         std::error_code saveNextTextureResource();
@@ -47,8 +60,15 @@ namespace Enigma::Engine
         void registerHandlers();
         void unregisterHandlers();
 
+        bool isCpuDecodable(const std::shared_ptr<Texture>& texture, const std::vector<std::string>& file_paths) const;
+        void loadByDevice(const TextureId& id);
+        std::optional<unsigned> findIdleLoader() const;
+        void completeHydrating(const TextureId& id);
+
         void onLoaderTextureLoaded(const Frameworks::IEventPtr& e);
         void onLoaderLoadTextureFailed(const Frameworks::IEventPtr& e);
+        void onTextureImageDecoded(const Frameworks::IEventPtr& e);
+        void onDecodeTextureImageFailed(const Frameworks::IEventPtr& e);
         void onSaverTextureSaved(const Frameworks::IEventPtr& e);
         void onSaverSaveTextureFailed(const Frameworks::IEventPtr& e);
         void onUpdaterImageRetrieved(const Frameworks::IEventPtr& e);
@@ -60,12 +80,30 @@ namespace Enigma::Engine
         void enqueueRetrievingImage(const Frameworks::ICommandPtr& c);
         void enqueueUpdatingImage(const Frameworks::ICommandPtr& c);
     private:
-        TextureLoader* m_loader;
+        struct HydratingTexture
+        {
+            std::shared_ptr<Texture> m_texture;
+            TextureDto m_dto;
+            std::optional<unsigned> m_loaderIndex;
+            unsigned m_mipBias;
+            std::uint64_t m_decodeGeneration;  ///< 0 : 不走 cpu decode
+        };
+        struct StreamingTexture
+        {
+            std::shared_ptr<Texture> m_texture;
+            unsigned m_mipBias;
+            std::uint64_t m_decodeGeneration;
+        };
+        std::vector<TextureLoader*> m_loaders;  ///< one loader per texture in flight
+        TextureDecodingPipeline* m_decodingPipeline;
         TextureSaver* m_saver;
         TextureImageUpdater* m_imageUpdater;
-        std::queue<std::pair<std::shared_ptr<Texture>, TextureDto>> m_hydratingQueue;
+        std::queue<HydratingTexture> m_hydratingQueue;
         std::recursive_mutex m_hydratingQueueLock;
-        std::shared_ptr<Texture> m_currentHydratingTexture;
+        std::unordered_map<TextureId, HydratingTexture, TextureId::hash> m_hydratingTextures;
+        std::unordered_map<TextureId, StreamingTexture, TextureId::hash> m_streamingTextures;
+        /// 每次 submit decode 都換一個, 對不上目前 hydrating / streaming entry 的 decode 結果就是過期的
+        std::uint64_t m_lastDecodeGeneration;
 
         std::queue<std::pair<std::shared_ptr<Texture>, std::shared_ptr<FileSystem::IFile>>> m_savingQueue;
         std::recursive_mutex m_savingQueueLock;
@@ -79,6 +117,8 @@ namespace Enigma::Engine
 
         Frameworks::EventSubscriberPtr m_onLoaderTextureLoaded;
         Frameworks::EventSubscriberPtr m_onLoaderLoadTextureFailed;
+        Frameworks::EventSubscriberPtr m_onTextureImageDecoded;
+        Frameworks::EventSubscriberPtr m_onDecodeTextureImageFailed;
         Frameworks::EventSubscriberPtr m_onSaverTextureSaved;
         Frameworks::EventSubscriberPtr m_onSaverSaveTextureFailed;
         Frameworks::EventSubscriberPtr m_onUpdaterImageRetrieved;
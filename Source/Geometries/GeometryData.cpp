@@ -4,7 +4,10 @@
 #include "MathLib/ContainmentBox3.h"
 #include "GeometryDataQueries.h"
 #include "Frameworks/QueryDispatcher.h"
+#include "VertexAttributeCodec.h"
 #include <cassert>
+#include <algorithm>
+#include <cfloat>
 
 using namespace Enigma::Geometries;
 using namespace Enigma::Engine;
@@ -143,6 +146,12 @@ void GeometryData::deserializeGeometryDto(const GeometryDataDto& dto)
     m_topology = static_cast<PrimitiveTopology>(dto.topology());
     if (auto pos3 = dto.position3s())
     {
+        if ((m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float) && (!pos3.value().empty()))
+        {
+            Box3 box = ContainmentBox3::ComputeAlignedBox(&pos3.value()[0], static_cast<unsigned>(pos3.value().size()));
+            const Vector3 extent(box.Extent());
+            setPositionQuantizationRange(box.Center() - extent, box.Center() + extent);
+        }
         setPosition3Array(pos3.value());
     }
     if (auto pos4 = dto.position4s())
@@ -201,8 +210,26 @@ RenderBufferSignature GeometryData::makeRenderBufferSignature() const
     return RenderBufferSignature{ m_id.name() + ".rndbuf", m_topology, m_vtxCapacity, m_idxCapacity };
 }
 
+void GeometryData::setPositionQuantizationRange(const MathLib::Vector3& min, const MathLib::Vector3& max)
+{
+    m_positionRevision++;
+    m_positionQuantizationMin = min;
+    // 扁平的 geometry, 避免 extent 為 0
+    m_positionQuantizationExtent = Vector3(std::max(max.x() - min.x(), FLT_EPSILON),
+        std::max(max.y() - min.y(), FLT_EPSILON), std::max(max.z() - min.z(), FLT_EPSILON));
+}
+
+error GeometryData::convertVertexFormat(const std::string& vertex_format_string)
+{
+    GeometryDataDto dto = serializeGeometryDto();
+    dto.vertexFormat() = vertex_format_string;
+    deserializeGeometryDto(dto);
+    return ErrorCode::ok;
+}
+
 error GeometryData::createVertexCapacity(const std::string& vertex_format_string, unsigned vtx_capa, unsigned vtx_count, unsigned idx_capa, unsigned idx_count)
 {
+    m_topologyRevision++;
     m_vertexFormatCode.FromString(vertex_format_string);
     m_vertexDesc = m_vertexFormatCode.calculateVertexSize();
 
@@ -231,6 +258,7 @@ error GeometryData::createVertexCapacity(const std::string& vertex_format_string
 
 error GeometryData::resizeVertexMemoryCapacity(unsigned vtx_capa, unsigned idx_capa)
 {
+    m_topologyRevision++;
     if (vtx_capa)
     {
         m_vertexMemory.resize(static_cast<size_t>(vtx_capa) * m_vertexDesc.totalVertexSize());
@@ -247,6 +275,7 @@ error GeometryData::resizeVertexMemoryCapacity(unsigned vtx_capa, unsigned idx_c
 
 void GeometryData::setUsingVertexCount(unsigned vtx_count, unsigned idx_count)
 {
+    m_topologyRevision++;
     if (vtx_count <= m_vtxCapacity)
     {
         m_vtxUsedCount = vtx_count;
@@ -264,18 +293,37 @@ void GeometryData::setUsingVertexCount(unsigned vtx_count, unsigned idx_count)
     }
 }
 
-Vector3 GeometryData::getPosition3(unsigned vtxIndex)
+Vector3 GeometryData::getPosition3(unsigned vtxIndex) const
 {
-    Vector3 pos;
-    getVertexMemoryData(vtxIndex, m_vertexDesc.positionOffset(), m_vertexDesc.positionDimension(), 3, (float*)pos, true);
-    return pos;
+    if (FATAL_LOG_EXPR(vtxIndex >= m_vtxUsedCount)) return Vector3::ZERO;
+    if (m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float)
+    {
+        Vector3 pos = Vector3::ZERO;
+        getVertexMemoryData(vtxIndex, m_vertexDesc.positionOffset(), m_vertexDesc.positionDimension(), 3, pos, true, m_vertexDesc.positionFormat());
+        return pos;
+    }
+    auto view = positionView();
+    if (view.empty()) return Vector3::ZERO;
+    return view[vtxIndex];
 }
 
-Vector4 GeometryData::getPosition4(unsigned vtxIndex)
+Vector4 GeometryData::getPosition4(unsigned vtxIndex) const
 {
-    Vector4 pos;
-    getVertexMemoryData(vtxIndex, m_vertexDesc.positionOffset(), m_vertexDesc.positionDimension(), 4, (float*)pos, true);
-    return pos;
+    if (FATAL_LOG_EXPR(vtxIndex >= m_vtxUsedCount)) return Vector4::ZERO;
+    if (m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float)
+    {
+        Vector4 pos = Vector4::ZERO;
+        getVertexMemoryData(vtxIndex, m_vertexDesc.positionOffset(), m_vertexDesc.positionDimension(), 4, pos, true, m_vertexDesc.positionFormat());
+        return pos;
+    }
+    if (m_vertexDesc.positionDimension() == 4)
+    {
+        auto view = position4View();
+        if (!view.empty()) return view[vtxIndex];
+    }
+    auto view = positionView();
+    if (view.empty()) return Vector4::ZERO;
+    return Vector4(view[vtxIndex], 1.0f);
 }
 
 std::vector<Vector3> GeometryData::getPosition3Array(unsigned count) const
@@ -287,8 +335,14 @@ std::vector<Vector3> GeometryData::getPosition3Array(unsigned offset, unsigned c
 {
     std::vector<Vector3> positions;
     positions.resize(count);
-    getVertexMemoryDataArray(offset, m_vertexDesc.positionOffset(),
-        m_vertexDesc.positionDimension(), 3, reinterpret_cast<float*>(&positions[0]), count, true);
+    if (m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float)
+    {
+        if (count > 0) getVertexMemoryDataArray(offset, m_vertexDesc.positionOffset(), m_vertexDesc.positionDimension(), 3,
+            reinterpret_cast<float*>(&positions[0]), count, true, m_vertexDesc.positionFormat());
+        return positions;
+    }
+    auto view = positionView().subView(offset, count);
+    std::copy(view.begin(), view.end(), positions.begin());
     return positions;
 }
 
@@ -301,21 +355,37 @@ std::vector<Vector4> GeometryData::getPosition4Array(unsigned offset, unsigned c
 {
     std::vector<Vector4> positions;
     positions.resize(count);
-    getVertexMemoryDataArray(offset, m_vertexDesc.positionOffset(),
-        m_vertexDesc.positionDimension(), 4, reinterpret_cast<float*>(&positions[0]), count, true);
+    if (m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float)
+    {
+        if (count > 0) getVertexMemoryDataArray(offset, m_vertexDesc.positionOffset(), m_vertexDesc.positionDimension(), 4,
+            reinterpret_cast<float*>(&positions[0]), count, true, m_vertexDesc.positionFormat());
+        return positions;
+    }
+    if (m_vertexDesc.positionDimension() == 4)
+    {
+        auto view = position4View().subView(offset, count);
+        std::copy(view.begin(), view.end(), positions.begin());
+    }
+    else
+    {
+        auto view = positionView().subView(offset, count);
+        std::transform(view.begin(), view.end(), positions.begin(), [](const Vector3& pos) { return Vector4(pos, 1.0f); });
+    }
     return positions;
 }
 
 error GeometryData::setPosition3(unsigned vtxIndex, const MathLib::Vector3& position)
 {
+    m_positionRevision++;
     return setVertexMemoryData(vtxIndex, m_vertexDesc.positionOffset(),
-        m_vertexDesc.positionDimension(), 3, (const float*)position, true);
+        m_vertexDesc.positionDimension(), 3, (const float*)position, true, m_vertexDesc.positionFormat());
 }
 
 error GeometryData::setPosition4(unsigned vtxIndex, const MathLib::Vector4& position)
 {
+    m_positionRevision++;
     return setVertexMemoryData(vtxIndex, m_vertexDesc.positionOffset(),
-        m_vertexDesc.positionDimension(), 4, (const float*)position, true);
+        m_vertexDesc.positionDimension(), 4, (const float*)position, true, m_vertexDesc.positionFormat());
 }
 
 error GeometryData::setPosition3Array(const std::vector<MathLib::Vector3>& positions)
@@ -325,8 +395,9 @@ error GeometryData::setPosition3Array(const std::vector<MathLib::Vector3>& posit
 
 error GeometryData::setPosition3Array(unsigned offset, const std::vector<MathLib::Vector3>& positions)
 {
+    m_positionRevision++;
     return setVertexMemoryDataArray(offset, m_vertexDesc.positionOffset(),
-        m_vertexDesc.positionDimension(), 3, reinterpret_cast<const float*>(&positions[0]), static_cast<unsigned>(positions.size()), true);
+        m_vertexDesc.positionDimension(), 3, reinterpret_cast<const float*>(&positions[0]), static_cast<unsigned>(positions.size()), true, m_vertexDesc.positionFormat());
 }
 
 error GeometryData::setPosition4Array(const std::vector<MathLib::Vector4>& positions)
@@ -336,20 +407,90 @@ error GeometryData::setPosition4Array(const std::vector<MathLib::Vector4>& posit
 
 error GeometryData::setPosition4Array(unsigned offset, const std::vector<MathLib::Vector4>& positions)
 {
+    m_positionRevision++;
     return setVertexMemoryDataArray(offset, m_vertexDesc.positionOffset(),
-        m_vertexDesc.positionDimension(), 4, reinterpret_cast<const float*>(&positions[0]), static_cast<unsigned>(positions.size()), true);
+        m_vertexDesc.positionDimension(), 4, reinterpret_cast<const float*>(&positions[0]), static_cast<unsigned>(positions.size()), true, m_vertexDesc.positionFormat());
+}
+
+VertexAttributeView<const Vector3> GeometryData::positionView() const
+{
+    if ((m_vertexDesc.positionDimension() < 3) || (m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float)) return {};
+    return makeAttributeView<Vector3>(m_vertexDesc.positionOffset());
+}
+
+VertexAttributeView<Vector3> GeometryData::mutablePositionView()
+{
+    if ((m_vertexDesc.positionDimension() < 3) || (m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float)) return {};
+    return makeMutableAttributeView<Vector3>(m_vertexDesc.positionOffset(), &m_positionRevision);
+}
+
+VertexAttributeView<const Vector4> GeometryData::position4View() const
+{
+    if (m_vertexDesc.positionDimension() != 4) return {};
+    return makeAttributeView<Vector4>(m_vertexDesc.positionOffset());
+}
+
+VertexAttributeView<Vector4> GeometryData::mutablePosition4View()
+{
+    if (m_vertexDesc.positionDimension() != 4) return {};
+    return makeMutableAttributeView<Vector4>(m_vertexDesc.positionOffset(), &m_positionRevision);
+}
+
+VertexAttributeView<const Vector3> GeometryData::normalView() const
+{
+    if (m_vertexDesc.normalFormat() != VertexDescription::ElementFormat::Float) return {};
+    return makeAttributeView<Vector3>(m_vertexDesc.normalOffset());
+}
+
+VertexAttributeView<Vector3> GeometryData::mutableNormalView()
+{
+    if (m_vertexDesc.normalFormat() != VertexDescription::ElementFormat::Float) return {};
+    return makeMutableAttributeView<Vector3>(m_vertexDesc.normalOffset());
+}
+
+VertexAttributeView<const Vector2> GeometryData::texture2DCoordView(unsigned stage) const
+{
+    assert(stage < VertexFormatCode::MAX_TEX_COORD);
+    if ((m_vertexDesc.textureCoordSize(stage) < 2) || (m_vertexDesc.textureCoordFormat(stage) != VertexDescription::ElementFormat::Float)) return {};
+    return makeAttributeView<Vector2>(m_vertexDesc.textureCoordOffset(stage));
+}
+
+VertexAttributeView<Vector2> GeometryData::mutableTexture2DCoordView(unsigned stage)
+{
+    assert(stage < VertexFormatCode::MAX_TEX_COORD);
+    if ((m_vertexDesc.textureCoordSize(stage) < 2) || (m_vertexDesc.textureCoordFormat(stage) != VertexDescription::ElementFormat::Float)) return {};
+    return makeMutableAttributeView<Vector2>(m_vertexDesc.textureCoordOffset(stage));
+}
+
+VertexAttributeView<const Vector4> GeometryData::tangentView() const
+{
+    if ((m_vertexDesc.tangentDimension() != 4) || (m_vertexDesc.tangentFormat() != VertexDescription::ElementFormat::Float)) return {};
+    return makeAttributeView<Vector4>(m_vertexDesc.tangentOffset());
+}
+
+VertexAttributeView<Vector4> GeometryData::mutableTangentView()
+{
+    if ((m_vertexDesc.tangentDimension() != 4) || (m_vertexDesc.tangentFormat() != VertexDescription::ElementFormat::Float)) return {};
+    return makeMutableAttributeView<Vector4>(m_vertexDesc.tangentOffset());
 }
 
 Vector3 GeometryData::getVertexNormal(unsigned vtxIndex) const
 {
-    Vector3 nor;
-    getVertexMemoryData(vtxIndex, m_vertexDesc.normalOffset(), 3, 3, (float*)nor, false);
-    return nor;
+    if (FATAL_LOG_EXPR(vtxIndex >= m_vtxUsedCount)) return Vector3::ZERO;
+    if (m_vertexDesc.normalFormat() != VertexDescription::ElementFormat::Float)
+    {
+        Vector3 nor = Vector3::ZERO;
+        getVertexMemoryData(vtxIndex, m_vertexDesc.normalOffset(), 3, 3, nor, false, m_vertexDesc.normalFormat());
+        return nor;
+    }
+    auto view = normalView();
+    if (view.empty()) return Vector3::ZERO;
+    return view[vtxIndex];
 }
 
 error GeometryData::setVertexNormal(unsigned vtxIndex, const MathLib::Vector3& nor)
 {
-    return setVertexMemoryData(vtxIndex, m_vertexDesc.normalOffset(), 3, 3, (const float*)nor, false);
+    return setVertexMemoryData(vtxIndex, m_vertexDesc.normalOffset(), 3, 3, (const float*)nor, false, m_vertexDesc.normalFormat());
 }
 
 std::vector<Vector3> GeometryData::getVertexNormalArray(unsigned count) const
@@ -361,7 +502,14 @@ std::vector<Vector3> GeometryData::getVertexNormalArray(unsigned offset, unsigne
 {
     std::vector<Vector3> normals;
     normals.resize(count);
-    getVertexMemoryDataArray(offset, m_vertexDesc.normalOffset(), 3, 3, reinterpret_cast<float*>(&normals[0]), count, false);
+    if (m_vertexDesc.normalFormat() != VertexDescription::ElementFormat::Float)
+    {
+        if (count > 0) getVertexMemoryDataArray(offset, m_vertexDesc.normalOffset(), 3, 3,
+            reinterpret_cast<float*>(&normals[0]), count, false, m_vertexDesc.normalFormat());
+        return normals;
+    }
+    auto view = normalView().subView(offset, count);
+    std::copy(view.begin(), view.end(), normals.begin());
     return normals;
 }
 
@@ -373,7 +521,7 @@ error GeometryData::setVertexNormalArray(const std::vector<MathLib::Vector3>& no
 error GeometryData::setVertexNormalArray(unsigned offset, const std::vector<MathLib::Vector3>& normals)
 {
     return setVertexMemoryDataArray(offset, m_vertexDesc.normalOffset(), 3, 3, reinterpret_cast<const float*>(&normals[0]),
-        static_cast<unsigned>(normals.size()), false);
+        static_cast<unsigned>(normals.size()), false, m_vertexDesc.normalFormat());
 }
 
 error GeometryData::setDiffuseColorArray(const std::vector<MathLib::Vector4>& colors)
@@ -442,8 +590,17 @@ std::vector<Vector2> GeometryData::getTexture2DCoordArray(unsigned offset, unsig
     assert(stage < VertexFormatCode::MAX_TEX_COORD);
     std::vector<Vector2> uvs;
     uvs.resize(count);
-    getVertexMemoryDataArray(offset, m_vertexDesc.textureCoordOffset(stage),
-        m_vertexDesc.textureCoordSize(stage), 2, reinterpret_cast<float*>(&uvs[0]), count, false);
+    if ((m_vertexDesc.textureCoordSize(stage) >= 2) && (m_vertexDesc.textureCoordFormat(stage) == VertexDescription::ElementFormat::Float))
+    {
+        auto view = texture2DCoordView(stage).subView(offset, count);
+        std::copy(view.begin(), view.end(), uvs.begin());
+    }
+    else
+    {
+        // 1D 座標 v 補 0, 或是要解碼的 half float
+        getVertexMemoryDataArray(offset, m_vertexDesc.textureCoordOffset(stage),
+            m_vertexDesc.textureCoordSize(stage), 2, reinterpret_cast<float*>(&uvs[0]), count, false, m_vertexDesc.textureCoordFormat(stage));
+    }
     return uvs;
 }
 
@@ -456,7 +613,7 @@ error GeometryData::setTexture2DCoordArray(unsigned offset, unsigned stage, cons
 {
     assert(stage < VertexFormatCode::MAX_TEX_COORD);
     return setVertexMemoryDataArray(offset, m_vertexDesc.textureCoordOffset(stage),
-        m_vertexDesc.textureCoordSize(stage), 2, reinterpret_cast<const float*>(&uvs[0]), static_cast<unsigned>(uvs.size()), false);
+        m_vertexDesc.textureCoordSize(stage), 2, reinterpret_cast<const float*>(&uvs[0]), static_cast<unsigned>(uvs.size()), false, m_vertexDesc.textureCoordFormat(stage));
 }
 
 error GeometryData::setTexture2DCoordArray(unsigned stage, const std::vector<MathLib::Vector2>& uvs)
@@ -468,7 +625,7 @@ error GeometryData::setTexture1DCoordArray(unsigned stage, const std::vector<flo
 {
     assert(stage < VertexFormatCode::MAX_TEX_COORD);
     return setVertexMemoryDataArray(0, m_vertexDesc.textureCoordOffset(stage), m_vertexDesc.textureCoordSize(stage), 1,
-        (const float*)(&us[0]), static_cast<unsigned>(us.size()), false);
+        (const float*)(&us[0]), static_cast<unsigned>(us.size()), false, m_vertexDesc.textureCoordFormat(stage));
 }
 
 std::vector<float> GeometryData::getTexture1DCoordArray(unsigned offset, unsigned stage, unsigned count) const
@@ -477,7 +634,7 @@ std::vector<float> GeometryData::getTexture1DCoordArray(unsigned offset, unsigne
     std::vector<float> us;
     us.resize(count);
     getVertexMemoryDataArray(offset, m_vertexDesc.textureCoordOffset(stage),
-        m_vertexDesc.textureCoordSize(stage), 1, &us[0], count, false);
+        m_vertexDesc.textureCoordSize(stage), 1, &us[0], count, false, m_vertexDesc.textureCoordFormat(stage));
     return us;
 }
 
@@ -490,7 +647,7 @@ error GeometryData::setTexture3DCoordArray(unsigned stage, const std::vector<Mat
 {
     assert(stage < VertexFormatCode::MAX_TEX_COORD);
     return setVertexMemoryDataArray(0, m_vertexDesc.textureCoordOffset(stage), m_vertexDesc.textureCoordSize(stage), 3,
-        reinterpret_cast<const float*>(&uvws[0]), static_cast<unsigned>(uvws.size()), false);
+        reinterpret_cast<const float*>(&uvws[0]), static_cast<unsigned>(uvws.size()), false, m_vertexDesc.textureCoordFormat(stage));
 }
 
 std::vector<Vector3> GeometryData::getTexture3DCoordArray(unsigned stage, unsigned count) const
@@ -504,7 +661,7 @@ std::vector<Vector3> GeometryData::getTexture3DCoordArray(unsigned offset, unsig
     std::vector<Vector3> uvws;
     uvws.resize(count);
     getVertexMemoryDataArray(offset, m_vertexDesc.textureCoordOffset(stage),
-        m_vertexDesc.textureCoordSize(stage), 3, reinterpret_cast<float*>(&uvws[0]), count, false);
+        m_vertexDesc.textureCoordSize(stage), 3, reinterpret_cast<float*>(&uvws[0]), count, false, m_vertexDesc.textureCoordFormat(stage));
     return uvws;
 }
 
@@ -530,6 +687,19 @@ std::vector<unsigned> GeometryData::getPaletteIndexArray(unsigned offset, unsign
 
 error GeometryData::setSkinWeightArray(unsigned weight_idx, const std::vector<float>& weight_array)
 {
+    if (m_vertexDesc.blendWeightFormat() != VertexDescription::ElementFormat::Float)
+    {
+        // packed weights, 只能整組讀出來改再寫回去
+        const unsigned weight_count = static_cast<unsigned>(m_vertexDesc.blendWeightCount());
+        if ((weight_idx >= weight_count) || (weight_array.empty())) return ErrorCode::ok;
+        const unsigned vtx_count = std::min(static_cast<unsigned>(weight_array.size()), m_vtxUsedCount);
+        std::vector<float> weights = getTotalSkinWeightArray(vtx_count);
+        for (unsigned i = 0; i < vtx_count; i++)
+        {
+            weights[static_cast<size_t>(i) * weight_count + weight_idx] = weight_array[i];
+        }
+        return setTotalSkinWeightArray(weights);
+    }
     return setVertexMemoryDataArray(0, m_vertexDesc.weightOffset(weight_idx), 1, 1,
         &weight_array[0], static_cast<unsigned>(weight_array.size()), false);
 }
@@ -540,7 +710,7 @@ error GeometryData::setTotalSkinWeightArray(const std::vector<float>& weight_arr
     {
         return setVertexMemoryDataArray(0, m_vertexDesc.weightOffset(), m_vertexDesc.blendWeightCount(),
             m_vertexDesc.blendWeightCount(), &weight_array[0],
-            static_cast<unsigned>(weight_array.size()) / m_vertexDesc.blendWeightCount(), false);
+            static_cast<unsigned>(weight_array.size()) / m_vertexDesc.blendWeightCount(), false, m_vertexDesc.blendWeightFormat());
     }
     return ErrorCode::ok;
 }
@@ -555,14 +725,14 @@ std::vector<float> GeometryData::getTotalSkinWeightArray(unsigned offset, unsign
     std::vector<float> weights;
     weights.resize(static_cast<size_t>(vtx_count) * m_vertexDesc.blendWeightCount());
     getVertexMemoryDataArray(offset, m_vertexDesc.weightOffset(),
-        m_vertexDesc.blendWeightCount(), m_vertexDesc.blendWeightCount(), &weights[0], vtx_count, false);
+        m_vertexDesc.blendWeightCount(), m_vertexDesc.blendWeightCount(), &weights[0], vtx_count, false, m_vertexDesc.blendWeightFormat());
     return weights;
 }
 
 error GeometryData::setVertexTangentArray(const std::vector<MathLib::Vector4>& tangents)
 {
     return setVertexMemoryDataArray(0, m_vertexDesc.tangentOffset(), m_vertexDesc.tangentDimension(), 4,
-        reinterpret_cast<const float*>(&tangents[0]), static_cast<unsigned>(tangents.size()), false);
+        reinterpret_cast<const float*>(&tangents[0]), static_cast<unsigned>(tangents.size()), false, m_vertexDesc.tangentFormat());
 }
 
 std::vector<Vector4> GeometryData::getVertexTangentArray(unsigned count) const
@@ -574,14 +744,23 @@ std::vector<Vector4> GeometryData::getVertexTangentArray(unsigned offset, unsign
 {
     std::vector<Vector4> tangents;
     tangents.resize(count);
-    getVertexMemoryDataArray(offset, m_vertexDesc.tangentOffset(),
-        m_vertexDesc.tangentDimension(), 4, reinterpret_cast<float*>(&tangents[0]), count, true);
+    if ((m_vertexDesc.tangentDimension() == 4) && (m_vertexDesc.tangentFormat() == VertexDescription::ElementFormat::Float))
+    {
+        auto view = tangentView().subView(offset, count);
+        std::copy(view.begin(), view.end(), tangents.begin());
+    }
+    else
+    {
+        getVertexMemoryDataArray(offset, m_vertexDesc.tangentOffset(),
+            m_vertexDesc.tangentDimension(), 4, reinterpret_cast<float*>(&tangents[0]), count, true, m_vertexDesc.tangentFormat());
+    }
     return tangents;
 }
 
 error GeometryData::setIndexArray(const std::vector<unsigned>& idx_ary)
 {
     assert(idx_ary.size() > 0);
+    m_topologyRevision++;
 
     // 要設index array, 必須有index memory
     if (FATAL_LOG_EXPR(m_indexMemory.size() == 0)) return ErrorCode::nullMemoryBuffer;
@@ -591,6 +770,24 @@ error GeometryData::setIndexArray(const std::vector<unsigned>& idx_ary)
     return ErrorCode::ok;
 }
 
+error GeometryData::remapVertices(const std::vector<unsigned>& new_to_old)
+{
+    if (FATAL_LOG_EXPR(m_vertexMemory.size() == 0)) return ErrorCode::nullMemoryBuffer;
+    if (FATAL_LOG_EXPR(new_to_old.size() > m_vtxCapacity)) return ErrorCode::invalidArrayIndex;
+    const size_t vertex_size = m_vertexDesc.totalVertexSize();
+    byte_buffer remapped(m_vertexMemory.size(), 0);
+    for (size_t i = 0; i < new_to_old.size(); i++)
+    {
+        if (FATAL_LOG_EXPR(new_to_old[i] >= m_vtxUsedCount)) return ErrorCode::invalidArrayIndex;
+        memcpy(&remapped[i * vertex_size], &m_vertexMemory[new_to_old[i] * vertex_size], vertex_size);
+    }
+    m_vertexMemory = std::move(remapped);
+    m_vtxUsedCount = static_cast<unsigned>(new_to_old.size());
+    m_positionRevision++;
+    m_topologyRevision++;
+    return ErrorCode::ok;
+}
+
 IVertexBuffer::ranged_buffer GeometryData::getRangedVertexMemory(unsigned offset, unsigned count) const
 {
     unsigned int byte_offset = offset * m_vertexDesc.totalVertexSize();
@@ -610,7 +807,7 @@ IIndexBuffer::ranged_buffer GeometryData::getRangedIndexMemory(unsigned offset,
 }
 
 error GeometryData::getVertexMemoryData(unsigned vtxIndex, int elementOffset, int elementDimension,
-    int destDimension, float* dest, bool isPos) const
+    int destDimension, float* dest, bool isPos, VertexDescription::ElementFormat format) const
 {
     assert(dest);
 
@@ -620,6 +817,10 @@ error GeometryData::getVertexMemoryData(unsigned vtxIndex, int elementOffset, in
     if (FATAL_LOG_EXPR(m_vertexDesc.totalVertexSize() == 0)) return ErrorCode::zeroVertexSize;
 
     if (elementOffset < 0) return ErrorCode::ok;  // no need set
+    if (format != VertexDescription::ElementFormat::Float)
+    {
+        return getVertexMemoryDataArray(vtxIndex, elementOffset, elementDimension, destDimension, dest, 1, isPos, format);
+    }
 
     unsigned int step = m_vertexDesc.totalVertexSize() / sizeof(float);
     unsigned int base_idx = step * vtxIndex + elementOffset;
@@ -640,7 +841,7 @@ error GeometryData::getVertexMemoryData(unsigned vtxIndex, int elementOffset, in
 }
 
 error GeometryData::setVertexMemoryData(unsigned vtxIndex, int elementOffset, int elementDimension,
-    int srcDimension, const float* src, bool isPos)
+    int srcDimension, const float* src, bool isPos, VertexDescription::ElementFormat format)
 {
     assert(src);
 
@@ -650,6 +851,10 @@ error GeometryData::setVertexMemoryData(unsigned vtxIndex, int elementOffset, in
     if (FATAL_LOG_EXPR(m_vertexDesc.totalVertexSize() == 0)) return ErrorCode::zeroVertexSize;
 
     if (elementOffset < 0) return ErrorCode::ok;  // no need set
+    if (format != VertexDescription::ElementFormat::Float)
+    {
+        return setVertexMemoryDataArray(vtxIndex, elementOffset, elementDimension, srcDimension, src, 1, isPos, format);
+    }
 
     unsigned int step = m_vertexDesc.totalVertexSize() / sizeof(float);
     unsigned int base_idx = step * vtxIndex + elementOffset;
@@ -669,7 +874,7 @@ error GeometryData::setVertexMemoryData(unsigned vtxIndex, int elementOffset, in
 }
 
 error GeometryData::getVertexMemoryDataArray(unsigned start, int elementOffset, int elementDimension,
-    int destDimension, float* dest, unsigned count, bool isPos) const
+    int destDimension, float* dest, unsigned count, bool isPos, VertexDescription::ElementFormat format) const
 {
     assert(dest);
     assert(count > 0);
@@ -691,6 +896,19 @@ error GeometryData::getVertexMemoryDataArray(unsigned start, int elementOffset,
     if (cp_dimension > elementDimension) cp_dimension = elementDimension;
     bool set_vec4 = false;
     if ((isPos) && (destDimension == 4) && (elementDimension == 3)) set_vec4 = true;
+    if (format != VertexDescription::ElementFormat::Float)
+    {
+        const unsigned char* src_byte = reinterpret_cast<const unsigned char*>(src);
+        for (unsigned int i = 0; i < pos_count; i++)
+        {
+            float element[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            decodeElement(src_byte, format, elementDimension, element);
+            memcpy(&dest[static_cast<size_t>(i) * destDimension], element, cp_dimension * sizeof(float));
+            if (set_vec4) dest[i * destDimension + 3] = 1.0f;
+            src_byte += step * sizeof(float);
+        }
+        return ErrorCode::ok;
+    }
     for (unsigned int i = 0; i < pos_count; i++)
     {
         memcpy(&dest[static_cast<size_t>(i) * destDimension], src, cp_dimension * sizeof(float));
@@ -702,7 +920,7 @@ error GeometryData::getVertexMemoryDataArray(unsigned start, int elementOffset,
 }
 
 error GeometryData::setVertexMemoryDataArray(unsigned start, int elementOffset, int elementDimension,
-    int srcDimension, const float* src, unsigned count, bool isPos)
+    int srcDimension, const float* src, unsigned count, bool isPos, VertexDescription::ElementFormat format)
 {
     assert(src);
     assert(count > 0);
@@ -720,6 +938,18 @@ error GeometryData::setVertexMemoryDataArray(unsigned start, int elementOffset,
     if (cp_dimension > elementDimension) cp_dimension = elementDimension;
     bool get_vec4 = false;
     if ((isPos) && (srcDimension == 3) && (elementDimension == 4)) get_vec4 = true;
+    if (format != VertexDescription::ElementFormat::Float)
+    {
+        unsigned char* dst_byte = reinterpret_cast<unsigned char*>(dst);
+        for (unsigned int i = 0; i < pos_count; i++)
+        {
+            float element[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            memcpy(element, &src[static_cast<size_t>(i) * srcDimension], cp_dimension * sizeof(float));
+            encodeElement(element, format, elementDimension, dst_byte);
+            dst_byte += step * sizeof(float);
+        }
+        return ErrorCode::ok;
+    }
     for (unsigned int i = 0; i < pos_count; i++)
     {
         memcpy(dst, &src[static_cast<size_t>(i) * srcDimension], cp_dimension * sizeof(float));
@@ -730,6 +960,95 @@ error GeometryData::setVertexMemoryDataArray(unsigned start, int elementOffset,
     return ErrorCode::ok;
 }
 
+void GeometryData::decodeElement(const unsigned char* src, VertexDescription::ElementFormat format, int elementDimension, float* element) const
+{
+    switch (format)
+    {
+    case VertexDescription::ElementFormat::Half:
+        for (int d = 0; d < elementDimension; d++)
+        {
+            std::uint16_t half;
+            memcpy(&half, src + d * sizeof(half), sizeof(half));
+            element[d] = VertexAttributeCodec::halfToFloat(half);
+        }
+        break;
+    case VertexDescription::ElementFormat::OctSnorm16:
+    {
+        std::uint32_t packed;
+        memcpy(&packed, src, sizeof(packed));
+        if (elementDimension == 4)
+        {
+            VertexAttributeCodec::decodeOctahedralTangent(packed, element);
+        }
+        else
+        {
+            VertexAttributeCodec::decodeOctahedral(packed, element);
+        }
+        break;
+    }
+    case VertexDescription::ElementFormat::Unorm16:
+        // quantized position
+        for (int d = 0; d < 3; d++)
+        {
+            std::uint16_t quantized;
+            memcpy(&quantized, src + d * sizeof(quantized), sizeof(quantized));
+            element[d] = VertexAttributeCodec::dequantizeUnorm16(quantized, m_positionQuantizationMin[d], m_positionQuantizationExtent[d]);
+        }
+        break;
+    case VertexDescription::ElementFormat::Unorm8:
+        for (int d = 0; d < elementDimension; d++)
+        {
+            element[d] = VertexAttributeCodec::unorm8ToFloat(src[d]);
+        }
+        break;
+    default:
+        memcpy(element, src, elementDimension * sizeof(float));
+        break;
+    }
+}
+
+void GeometryData::encodeElement(const float* element, VertexDescription::ElementFormat format, int elementDimension, unsigned char* dst) const
+{
+    switch (format)
+    {
+    case VertexDescription::ElementFormat::Half:
+        for (int d = 0; d < elementDimension + (elementDimension & 1); d++)
+        {
+            // 奇數維度時補一個 0
+            const std::uint16_t half = d < elementDimension ? VertexAttributeCodec::floatToHalf(element[d]) : 0;
+            memcpy(dst + d * sizeof(half), &half, sizeof(half));
+        }
+        break;
+    case VertexDescription::ElementFormat::OctSnorm16:
+    {
+        const std::uint32_t packed = elementDimension == 4
+            ? VertexAttributeCodec::encodeOctahedralTangent(element) : VertexAttributeCodec::encodeOctahedral(element);
+        memcpy(dst, &packed, sizeof(packed));
+        break;
+    }
+    case VertexDescription::ElementFormat::Unorm16:
+    {
+        // 第 4 個 unorm 填 1, shader 讀到的 w 就是 1
+        std::uint16_t quantized[4] = { 0, 0, 0, 0xffff };
+        for (int d = 0; d < 3; d++)
+        {
+            quantized[d] = VertexAttributeCodec::quantizeUnorm16(element[d], m_positionQuantizationMin[d], m_positionQuantizationExtent[d]);
+        }
+        memcpy(dst, quantized, sizeof(quantized));
+        break;
+    }
+    case VertexDescription::ElementFormat::Unorm8:
+        for (int d = 0; d < 4; d++)
+        {
+            dst[d] = d < elementDimension ? VertexAttributeCodec::floatToUnorm8(element[d]) : 0;
+        }
+        break;
+    default:
+        memcpy(dst, element, elementDimension * sizeof(float));
+        break;
+    }
+}
+
 const GeometrySegment& GeometryData::getSegment(unsigned index) const
 {
     assert(index < m_geoSegmentVector.size());
@@ -749,6 +1068,15 @@ void GeometryData::calculateBoundingVolume(bool axis_align)
 {
     if (FATAL_LOG_EXPR(m_vertexMemory.size() == 0)) return;
 
+    if ((m_vertexDesc.positionFormat() != VertexDescription::ElementFormat::Float) && (m_vtxUsedCount > 0))
+    {
+        const auto positions = getPosition3Array(m_vtxUsedCount);
+        m_geometryBound = axis_align
+            ? BoundingVolume(ContainmentBox3::ComputeAlignedBox(&positions[0], m_vtxUsedCount))
+            : BoundingVolume(ContainmentBox3::ComputeOrientedBox(&positions[0], m_vtxUsedCount));
+        return;
+    }
+
     if (axis_align)
     {
         m_geometryBound = BoundingVolume(ContainmentBox3::ComputeAlignedBox(
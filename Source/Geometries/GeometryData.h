@@ -21,7 +21,15 @@
 #include "GeometryDataDto.h"
 #include "GameEngine/RenderBufferSignature.h"
 #include "GeometryId.h"
+#include "VertexAttributeView.h"
 #include <memory>
+#include <cstdint>
+#include <optional>
+
+namespace Enigma::MathLib
+{
+    class Ray3;
+}
 
 namespace Enigma::Geometries
 {
@@ -65,9 +73,9 @@ namespace Enigma::Geometries
         void setUsingVertexCount(unsigned int vtx_count, unsigned int idx_count = 0);
 
         /** get position */
-        MathLib::Vector3 getPosition3(unsigned int vtxIndex);
+        MathLib::Vector3 getPosition3(unsigned int vtxIndex) const;
         /** get position */
-        MathLib::Vector4 getPosition4(unsigned int vtxIndex);
+        MathLib::Vector4 getPosition4(unsigned int vtxIndex) const;
         /** get position array */
         std::vector<MathLib::Vector3> getPosition3Array(unsigned int count) const;
         std::vector<MathLib::Vector3> getPosition3Array(unsigned int offset, unsigned int count) const;
@@ -84,6 +92,28 @@ namespace Enigma::Geometries
         error setPosition4Array(const std::vector<MathLib::Vector4>& positions);
         error setPosition4Array(unsigned int offset, const std::vector<MathLib::Vector4>& positions);
 
+        /** quantized position ("qpos") 的量化範圍, 要在寫入 position 之前設定;
+            shader 以 min + unorm16 * extent 還原 position */
+        void setPositionQuantizationRange(const MathLib::Vector3& min, const MathLib::Vector3& max);
+        const MathLib::Vector3& positionQuantizationMin() const { return m_positionQuantizationMin; }
+        const MathLib::Vector3& positionQuantizationExtent() const { return m_positionQuantizationExtent; }
+
+        /** 用另一個 vertex format 重新編碼全部 vertex attributes (e.g. 轉成壓縮格式) */
+        error convertVertexFormat(const std::string& vertex_format_string);
+
+        /** zero-copy views over vertex memory, count = used vertex count,
+            沒有這個 attribute 或 attribute 是壓縮格式時回傳 empty view; 經由 mutable position view 寫入時 position revision 才會增加 */
+        VertexAttributeView<const MathLib::Vector3> positionView() const;  ///< xyz of position3 or position4
+        VertexAttributeView<MathLib::Vector3> mutablePositionView();
+        VertexAttributeView<const MathLib::Vector4> position4View() const;
+        VertexAttributeView<MathLib::Vector4> mutablePosition4View();
+        VertexAttributeView<const MathLib::Vector3> normalView() const;
+        VertexAttributeView<MathLib::Vector3> mutableNormalView();
+        VertexAttributeView<const MathLib::Vector2> texture2DCoordView(unsigned int stage) const;
+        VertexAttributeView<MathLib::Vector2> mutableTexture2DCoordView(unsigned int stage);
+        VertexAttributeView<const MathLib::Vector4> tangentView() const;
+        VertexAttributeView<MathLib::Vector4> mutableTangentView();
+
         /** get vertex normal */
         MathLib::Vector3 getVertexNormal(unsigned int vtxIndex) const;
         /** set vertex normal */
@@ -148,6 +178,8 @@ namespace Enigma::Geometries
 
         /** set index array */
         error setIndexArray(const std::vector<unsigned int>& idx_ary);
+        /** 重排 vertex, new vertex i = old vertex new_to_old[i], used vertex count 變成 new_to_old.size() */
+        error remapVertices(const std::vector<unsigned int>& new_to_old);
 
         /** get primitive type */
         Graphics::PrimitiveTopology getPrimitiveTopology() const { return m_topology; };
@@ -163,6 +195,8 @@ namespace Enigma::Geometries
         const uint_buffer& getIndexMemory() const { return m_indexMemory; };
         /** get ranged index memory */
         Graphics::IIndexBuffer::ranged_buffer getRangedIndexMemory(unsigned int offset, unsigned int count) const;
+        /** vertex & index memory 佔用的 bytes, repository cache 預算用 */
+        size_t estimatedByteSize() const { return m_vertexMemory.capacity() + m_indexMemory.capacity() * sizeof(unsigned int); }
 
         /** get vertex capacity */
         unsigned int getVertexCapacity() const { return m_vtxCapacity; };
@@ -176,6 +210,8 @@ namespace Enigma::Geometries
 
         /** size of vertex (in byte) */
         unsigned int sizeofVertex() const { return m_vertexDesc.totalVertexSize(); };
+        /** vertex element layout */
+        const Graphics::VertexDescription& vertexDescription() const { return m_vertexDesc; }
 
         /** get geometry segment */
         const GeometrySegment& getSegment(unsigned int index) const;
@@ -193,13 +229,42 @@ namespace Enigma::Geometries
         /** get bounding volume */
         const Engine::BoundingVolume& getBoundingVolume() const { return m_geometryBound; };
 
+        /** position 每次寫入都會加一, 讓 cache (e.g. triangle bvh) 判斷是否過期 */
+        std::uint64_t positionRevision() const { return m_positionRevision; }
+        /** index / vertex count 變動時加一 */
+        std::uint64_t topologyRevision() const { return m_topologyRevision; }
+
+        /** 有特化的 ray cast (e.g. height field) 時, intersection 不走一般的 triangle 流程 */
+        virtual bool canCastRay() const { return false; }
+        /** 最近交點的 ray t (model space), nullopt : 沒打到 */
+        virtual std::optional<float> castRay(const MathLib::Ray3&) const { return std::nullopt; }
+
     protected:
-        error getVertexMemoryData(unsigned int vtxIndex, int elementOffset, int elementDimension, int destDimension, float* dest, bool isPos) const;
-        error setVertexMemoryData(unsigned int vtxIndex, int elementOffset, int elementDimension, int srcDimension, const float* src, bool isPos);
+        template <class T> VertexAttributeView<const T> makeAttributeView(int element_offset) const
+        {
+            if ((element_offset < 0) || (m_vertexMemory.empty()) || (m_vertexDesc.totalVertexSize() == 0)) return {};
+            return { &m_vertexMemory[element_offset * sizeof(float)], static_cast<size_t>(m_vertexDesc.totalVertexSize()), m_vtxUsedCount };
+        }
+        template <class T> VertexAttributeView<T> makeMutableAttributeView(int element_offset, std::uint64_t* write_revision = nullptr)
+        {
+            if ((element_offset < 0) || (m_vertexMemory.empty()) || (m_vertexDesc.totalVertexSize() == 0)) return {};
+            return { &m_vertexMemory[element_offset * sizeof(float)], static_cast<size_t>(m_vertexDesc.totalVertexSize()), m_vtxUsedCount, write_revision };
+        }
+
+        /** format 不是 float 時, 讀寫會經過 decode / encode */
+        error getVertexMemoryData(unsigned int vtxIndex, int elementOffset, int elementDimension, int destDimension, float* dest, bool isPos,
+            Graphics::VertexDescription::ElementFormat format = Graphics::VertexDescription::ElementFormat::Float) const;
+        error setVertexMemoryData(unsigned int vtxIndex, int elementOffset, int elementDimension, int srcDimension, const float* src, bool isPos,
+            Graphics::VertexDescription::ElementFormat format = Graphics::VertexDescription::ElementFormat::Float);
         error getVertexMemoryDataArray(unsigned int start, int elementOffset, int elementDimension,
-            int destDimension, float* dest, unsigned int count, bool isPos) const;
+            int destDimension, float* dest, unsigned int count, bool isPos,
+            Graphics::VertexDescription::ElementFormat format = Graphics::VertexDescription::ElementFormat::Float) const;
         error setVertexMemoryDataArray(unsigned int start, int elementOffset, int elementDimension,
-            int srcDimension, const float* src, unsigned int count, bool isPos);
+            int srcDimension, const float* src, unsigned int count, bool isPos,
+            Graphics::VertexDescription::ElementFormat format = Graphics::VertexDescription::ElementFormat::Float);
+        /** element : 4 floats */
+        void decodeElement(const unsigned char* src, Graphics::VertexDescription::ElementFormat format, int elementDimension, float* element) const;
+        void encodeElement(const float* element, Graphics::VertexDescription::ElementFormat format, int elementDimension, unsigned char* dst) const;
 
         GeometryDataDto serializeGeometryDto() const;
         void deserializeGeometryDto(const GeometryDataDto& dto);
@@ -226,6 +291,12 @@ namespace Enigma::Geometries
         Graphics::PrimitiveTopology m_topology;
 
         Engine::BoundingVolume m_geometryBound;
+
+        std::uint64_t m_positionRevision = 0;
+        std::uint64_t m_topologyRevision = 0;
+
+        MathLib::Vector3 m_positionQuantizationMin = MathLib::Vector3(0.0f, 0.0f, 0.0f);
+        MathLib::Vector3 m_positionQuantizationExtent = MathLib::Vector3(1.0f, 1.0f, 1.0f);
     };
 
     using GeometryDataPtr = std::shared_ptr<GeometryData>;
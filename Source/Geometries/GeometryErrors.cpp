@@ -14,6 +14,7 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::invalidArrayIndex: return "Invalid array index";
     case ErrorCode::nullMemoryBuffer: return "Null memory buffer";
     case ErrorCode::zeroVertexSize: return "Zero vertex size";
+    case ErrorCode::unsupportedTopology: return "Unsupported primitive topology";
     }
     return "Unknown";
 }
@@ -22,6 +22,7 @@ namespace Enigma::Geometries
         invalidArrayIndex = 201,
         nullMemoryBuffer,
         zeroVertexSize,
+        unsupportedTopology,
     };
     class ErrorCategory : public std::error_category
     {
@@ -0,0 +1,434 @@
+﻿#include "GeometryOptimizer.h"
+#include "GeometryData.h"
+#include "GeometryErrors.h"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <string_view>
+#include <cmath>
+#include <cassert>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+/// Forsyth score 參數
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+constexpr unsigned MAX_VALENCE_SCORE = 32;
+constexpr unsigned INVALID_TRIANGLE = ~0u;
+
+namespace
+{
+    /// timestamp 方式的 FIFO cache, reset 只要把時間往前推
+    class FifoCacheSimulator
+    {
+    public:
+        FifoCacheSimulator(unsigned vertex_count, unsigned cache_size)
+            : m_timestamps(vertex_count, 0), m_cacheSize(cache_size), m_time(cache_size + 1) {}
+        /** @return true : cache miss */
+        bool access(unsigned vertex)
+        {
+            if (m_time - m_timestamps[vertex] > m_cacheSize)
+            {
+                m_timestamps[vertex] = m_time++;
+                return true;
+            }
+            return false;
+        }
+        unsigned accessTriangle(const unsigned* tri)
+        {
+            return static_cast<unsigned>(access(tri[0])) + static_cast<unsigned>(access(tri[1])) + static_cast<unsigned>(access(tri[2]));
+        }
+        void reset() { m_time += m_cacheSize + 1; }
+    private:
+        std::vector<unsigned> m_timestamps;
+        unsigned m_cacheSize;
+        unsigned m_time;
+    };
+
+    class ForsythScoreTable
+    {
+    public:
+        ForsythScoreTable()
+        {
+            for (unsigned i = 0; i < GeometryOptimizer::ForsythCacheSize; i++)
+            {
+                if (i < 3)
+                {
+                    m_cacheScores[i] = LAST_TRIANGLE_SCORE;
+                }
+                else
+                {
+                    const float scaler = 1.0f / static_cast<float>(GeometryOptimizer::ForsythCacheSize - 3);
+                    m_cacheScores[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, CACHE_DECAY_POWER);
+                }
+            }
+            m_valenceScores[0] = 0.0f;
+            for (unsigned i = 1; i < MAX_VALENCE_SCORE; i++)
+            {
+                m_valenceScores[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+            }
+        }
+        float vertexScore(int cache_position, unsigned remaining_valence) const
+        {
+            if (remaining_valence == 0) return -1.0f;
+            float score = cache_position >= 0 ? m_cacheScores[cache_position] : 0.0f;
+            score += remaining_valence < MAX_VALENCE_SCORE ? m_valenceScores[remaining_valence]
+                : VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_valence), -VALENCE_BOOST_POWER);
+            return score;
+        }
+    private:
+        float m_cacheScores[GeometryOptimizer::ForsythCacheSize];
+        float m_valenceScores[MAX_VALENCE_SCORE];
+    };
+}
+
+void GeometryOptimizer::VertexCacheStatistics::accumulate(const VertexCacheStatistics& other)
+{
+    m_triangleCount += other.m_triangleCount;
+    m_vertexCount += other.m_vertexCount;
+    m_cacheMissCount += other.m_cacheMissCount;
+}
+
+GeometryOptimizer::VertexCacheStatistics GeometryOptimizer::analyzeVertexCache(const uint_buffer& indices, unsigned vertex_count, unsigned cache_size)
+{
+    VertexCacheStatistics statistics;
+    statistics.m_triangleCount = static_cast<unsigned>(indices.size() / 3);
+    std::vector<bool> is_used(vertex_count, false);
+    FifoCacheSimulator cache(vertex_count, cache_size);
+    for (size_t i = 0; i < static_cast<size_t>(statistics.m_triangleCount) * 3; i++)
+    {
+        const unsigned v = indices[i];
+        if (!is_used[v])
+        {
+            is_used[v] = true;
+            statistics.m_vertexCount++;
+        }
+        if (cache.access(v)) statistics.m_cacheMissCount++;
+    }
+    return statistics;
+}
+
+uint_buffer GeometryOptimizer::optimizeVertexCache(const uint_buffer& indices, unsigned vertex_count)
+{
+    static const ForsythScoreTable score_table;
+    const unsigned triangle_count = static_cast<unsigned>(indices.size() / 3);
+    if (triangle_count == 0) return indices;
+
+    // vertex -> triangle adjacency, 每個 vertex 的前 remaining 個是還沒輸出的 triangle
+    std::vector<unsigned> remaining(vertex_count, 0);
+    for (size_t i = 0; i < static_cast<size_t>(triangle_count) * 3; i++) remaining[indices[i]]++;
+    std::vector<unsigned> adjacency_offsets(static_cast<size_t>(vertex_count) + 1, 0);
+    for (unsigned v = 0; v < vertex_count; v++) adjacency_offsets[v + 1] = adjacency_offsets[v] + remaining[v];
+    std::vector<unsigned> adjacency(adjacency_offsets[vertex_count]);
+    {
+        std::vector<unsigned> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (unsigned t = 0; t < triangle_count; t++)
+        {
+            for (unsigned k = 0; k < 3; k++) adjacency[fill[indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    std::vector<int> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (unsigned v = 0; v < vertex_count; v++) vertex_scores[v] = score_table.vertexScore(-1, remaining[v]);
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> is_emitted(triangle_count, false);
+    unsigned best_triangle = 0;
+    for (unsigned t = 0; t < triangle_count; t++)
+    {
+        triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+        if (triangle_scores[t] > triangle_scores[best_triangle]) best_triangle = t;
+    }
+
+    uint_buffer optimized;
+    optimized.reserve(static_cast<size_t>(triangle_count) * 3);
+    std::vector<unsigned> cache;
+    std::vector<unsigned> new_cache;
+    cache.reserve(ForsythCacheSize + 3);
+    new_cache.reserve(ForsythCacheSize + 3);
+    unsigned input_cursor = 0;
+    for (unsigned emitted = 0; emitted < triangle_count; emitted++)
+    {
+        if (best_triangle == INVALID_TRIANGLE)
+        {
+            // cache 裡沒有可用的 triangle, 依輸入順序找下一個
+            while (is_emitted[input_cursor]) input_cursor++;
+            best_triangle = input_cursor;
+        }
+        const unsigned* tri = &indices[static_cast<size_t>(best_triangle) * 3];
+        optimized.insert(optimized.end(), tri, tri + 3);
+        is_emitted[best_triangle] = true;
+        for (unsigned k = 0; k < 3; k++)
+        {
+            const unsigned v = tri[k];
+            unsigned* begin = &adjacency[adjacency_offsets[v]];
+            unsigned* end = begin + remaining[v];
+            unsigned* found = std::find(begin, end, best_triangle);
+            assert(found != end);
+            std::swap(*found, *(end - 1));
+            remaining[v]--;
+        }
+
+        new_cache.assign(tri, tri + 3);
+        for (unsigned v : cache)
+        {
+            if ((v != tri[0]) && (v != tri[1]) && (v != tri[2])) new_cache.push_back(v);
+        }
+        for (unsigned i = 0; i < new_cache.size(); i++)
+        {
+            const unsigned v = new_cache[i];
+            cache_positions[v] = i < ForsythCacheSize ? static_cast<int>(i) : -1;
+            vertex_scores[v] = score_table.vertexScore(cache_positions[v], remaining[v]);
+        }
+
+        best_triangle = INVALID_TRIANGLE;
+        float best_score = -1.0f;
+        for (unsigned v : new_cache)
+        {
+            for (unsigned a = adjacency_offsets[v]; a < adjacency_offsets[v] + remaining[v]; a++)
+            {
+                const unsigned t = adjacency[a];
+                triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+                if ((triangle_scores[t] > best_score) || ((triangle_scores[t] == best_score) && (t < best_triangle)))
+                {
+                    best_score = triangle_scores[t];
+                    best_triangle = t;
+                }
+            }
+        }
+        if (new_cache.size() > ForsythCacheSize) new_cache.resize(ForsythCacheSize);
+        std::swap(cache, new_cache);
+    }
+    return optimized;
+}
+
+uint_buffer GeometryOptimizer::optimizeOverdraw(const uint_buffer& indices, unsigned vertex_count,
+    const std::vector<Vector3>& positions, float threshold, unsigned cache_size)
+{
+    const unsigned triangle_count = static_cast<unsigned>(indices.size() / 3);
+    if ((triangle_count < 2) || (positions.size() < vertex_count)) return indices;
+
+    // hard boundary : 三個 vertex 都 miss 的 triangle, cache 等於重新開始
+    std::vector<unsigned> hard_starts;
+    {
+        FifoCacheSimulator cache(vertex_count, cache_size);
+        for (unsigned t = 0; t < triangle_count; t++)
+        {
+            if ((cache.accessTriangle(&indices[static_cast<size_t>(t) * 3]) == 3) || (t == 0)) hard_starts.push_back(t);
+        }
+    }
+    hard_starts.push_back(triangle_count);
+
+    // soft boundary : cluster 內累計 ACMR 不超過 threshold * 整個 hard cluster 的 ACMR 就切開
+    std::vector<unsigned> cluster_starts;
+    FifoCacheSimulator cache(vertex_count, cache_size);
+    for (size_t h = 0; h + 1 < hard_starts.size(); h++)
+    {
+        const unsigned start = hard_starts[h];
+        const unsigned end = hard_starts[h + 1];
+        cache.reset();
+        unsigned total_misses = 0;
+        for (unsigned t = start; t < end; t++) total_misses += cache.accessTriangle(&indices[static_cast<size_t>(t) * 3]);
+        const float target_acmr = static_cast<float>(total_misses) / static_cast<float>(end - start) * threshold;
+
+        cache.reset();
+        cluster_starts.push_back(start);
+        unsigned run_start = start;
+        unsigned run_misses = 0;
+        for (unsigned t = start; t < end; t++)
+        {
+            run_misses += cache.accessTriangle(&indices[static_cast<size_t>(t) * 3]);
+            const float run_acmr = static_cast<float>(run_misses) / static_cast<float>(t - run_start + 1);
+            if ((t + 1 < end) && (run_acmr <= target_acmr))
+            {
+                cluster_starts.push_back(t + 1);
+                run_start = t + 1;
+                run_misses = 0;
+                cache.reset();
+            }
+        }
+    }
+    cluster_starts.push_back(triangle_count);
+
+    // mesh centroid
+    Vector3 mesh_centroid = Vector3::ZERO;
+    for (unsigned v = 0; v < vertex_count; v++) mesh_centroid += positions[v];
+    mesh_centroid /= static_cast<float>(std::max(vertex_count, 1u));
+
+    // cluster 越朝外 (離中心遠且法向朝外) 越先畫, 擋住後面的 cluster
+    const size_t cluster_count = cluster_starts.size() - 1;
+    std::vector<float> cluster_keys(cluster_count, 0.0f);
+    for (size_t c = 0; c < cluster_count; c++)
+    {
+        Vector3 centroid = Vector3::ZERO;
+        Vector3 normal = Vector3::ZERO;
+        float area_sum = 0.0f;
+        for (unsigned t = cluster_starts[c]; t < cluster_starts[c + 1]; t++)
+        {
+            const Vector3& p0 = positions[indices[static_cast<size_t>(t) * 3]];
+            const Vector3& p1 = positions[indices[static_cast<size_t>(t) * 3 + 1]];
+            const Vector3& p2 = positions[indices[static_cast<size_t>(t) * 3 + 2]];
+            const Vector3 cross = (p1 - p0).cross(p2 - p0);
+            const float area = cross.length();
+            centroid += (p0 + p1 + p2) * (area / 3.0f);
+            normal += cross;
+            area_sum += area;
+        }
+        if (area_sum <= 0.0f) continue;
+        centroid /= area_sum;
+        const float normal_length = normal.length();
+        if (normal_length <= 0.0f) continue;
+        cluster_keys[c] = (centroid - mesh_centroid).dot(normal / normal_length);
+    }
+    std::vector<size_t> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), 0);
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&cluster_keys](size_t a, size_t b) { return cluster_keys[a] > cluster_keys[b]; });
+
+    uint_buffer sorted;
+    sorted.reserve(static_cast<size_t>(triangle_count) * 3);
+    for (size_t c : cluster_order)
+    {
+        sorted.insert(sorted.end(), indices.begin() + static_cast<size_t>(cluster_starts[c]) * 3, indices.begin() + static_cast<size_t>(cluster_starts[c + 1]) * 3);
+    }
+    return sorted;
+}
+
+std::vector<unsigned> GeometryOptimizer::findDuplicateVertices(const unsigned char* vertex_bytes, size_t vertex_stride, unsigned vertex_count)
+{
+    std::vector<unsigned> canonical(vertex_count);
+    std::iota(canonical.begin(), canonical.end(), 0);
+    if ((!vertex_bytes) || (vertex_stride == 0)) return canonical;
+    std::unordered_map<std::string_view, unsigned> first_vertices;
+    first_vertices.reserve(vertex_count);
+    for (unsigned v = 0; v < vertex_count; v++)
+    {
+        const std::string_view key(reinterpret_cast<const char*>(vertex_bytes + v * vertex_stride), vertex_stride);
+        canonical[v] = first_vertices.try_emplace(key, v).first->second;
+    }
+    return canonical;
+}
+
+std::vector<unsigned> GeometryOptimizer::compactVertices(uint_buffer& indices, unsigned vertex_count, bool first_use_order)
+{
+    constexpr unsigned unassigned = ~0u;
+    std::vector<unsigned> old_to_new(vertex_count, unassigned);
+    std::vector<unsigned> remap;
+    if (first_use_order)
+    {
+        for (unsigned& index : indices)
+        {
+            if (old_to_new[index] == unassigned)
+            {
+                old_to_new[index] = static_cast<unsigned>(remap.size());
+                remap.push_back(index);
+            }
+            index = old_to_new[index];
+        }
+        return remap;
+    }
+    for (unsigned index : indices) old_to_new[index] = 0;
+    for (unsigned v = 0; v < vertex_count; v++)
+    {
+        if (old_to_new[v] == unassigned) continue;
+        old_to_new[v] = static_cast<unsigned>(remap.size());
+        remap.push_back(v);
+    }
+    for (unsigned& index : indices) index = old_to_new[index];
+    return remap;
+}
+
+std::vector<unsigned> GeometryOptimizer::optimizeTriangleList(uint_buffer& indices, unsigned vertex_count,
+    const std::vector<Vector3>& positions, const unsigned char* vertex_bytes, size_t vertex_stride, const Options& options, Report& report)
+{
+    assert(indices.size() % 3 == 0);
+    report.m_originalVertexCount += vertex_count;
+    report.m_before.accumulate(analyzeVertexCache(indices, vertex_count, options.m_statisticsCacheSize));
+
+    if ((options.m_removeDuplicateVertices) && (vertex_bytes))
+    {
+        const auto canonical = findDuplicateVertices(vertex_bytes, vertex_stride, vertex_count);
+        for (unsigned& index : indices) index = canonical[index];
+    }
+    if (options.m_optimizeVertexCache) indices = optimizeVertexCache(indices, vertex_count);
+    if (options.m_optimizeOverdraw)
+    {
+        indices = optimizeOverdraw(indices, vertex_count, positions, options.m_overdrawThreshold, options.m_statisticsCacheSize);
+    }
+    auto remap = compactVertices(indices, vertex_count, options.m_optimizeVertexFetch);
+
+    report.m_optimizedVertexCount += static_cast<unsigned>(remap.size());
+    report.m_after.accumulate(analyzeVertexCache(indices, static_cast<unsigned>(remap.size()), options.m_statisticsCacheSize));
+    return remap;
+}
+
+std::error_code GeometryOptimizer::optimize(const std::shared_ptr<GeometryData>& geometry, const Options& options, Report& report)
+{
+    if (!geometry) return ErrorCode::nullMemoryBuffer;
+    if (geometry->getPrimitiveTopology() != Graphics::PrimitiveTopology::Topology_TriangleList) return ErrorCode::unsupportedTopology;
+    if (geometry->getIndexMemory().empty()) return ErrorCode::nullMemoryBuffer;
+
+    const unsigned vertex_size = geometry->sizeofVertex();
+    const byte_buffer& vertex_memory = geometry->getVertexMemory();
+    const uint_buffer& index_memory = geometry->getIndexMemory();
+    const GeometrySegmentVector segments = geometry->getSegmentVector();
+
+    // segment 間共用 vertex 時不能各自重排 vertex, 只重排 index
+    std::vector<std::pair<unsigned, unsigned>> vertex_ranges;
+    for (const auto& segment : segments) vertex_ranges.emplace_back(segment.m_startVtx, segment.m_startVtx + segment.m_vtxCount);
+    std::sort(vertex_ranges.begin(), vertex_ranges.end());
+    bool can_remap_vertices = true;
+    for (size_t i = 1; i < vertex_ranges.size(); i++)
+    {
+        if (vertex_ranges[i].first < vertex_ranges[i - 1].second) can_remap_vertices = false;
+    }
+    Options segment_options = options;
+    if (!can_remap_vertices) segment_options.m_removeDuplicateVertices = false;
+
+    uint_buffer new_indices(index_memory.begin(), index_memory.begin() + geometry->getUsedIndexCount());
+    std::vector<unsigned> vertex_remap;
+    GeometrySegmentVector new_segments;
+    for (const auto& segment : segments)
+    {
+        GeometrySegment new_segment = segment;
+        new_segment.m_startVtx = static_cast<unsigned>(vertex_remap.size());
+        if ((segment.m_idxCount < 3) || (segment.m_vtxCount == 0))
+        {
+            for (unsigned v = 0; v < segment.m_vtxCount; v++) vertex_remap.push_back(segment.m_startVtx + v);
+            new_segments.push_back(new_segment);
+            continue;
+        }
+        if (segment.m_startIdx + segment.m_idxCount > new_indices.size()) return ErrorCode::invalidArrayIndex;
+        if (segment.m_startVtx + segment.m_vtxCount > geometry->getUsedVertexCount()) return ErrorCode::invalidArrayIndex;
+        const unsigned triangle_index_count = segment.m_idxCount / 3 * 3;
+        uint_buffer segment_indices(new_indices.begin() + segment.m_startIdx, new_indices.begin() + segment.m_startIdx + triangle_index_count);
+        for (unsigned index : segment_indices)
+        {
+            if (index >= segment.m_vtxCount) return ErrorCode::invalidArrayIndex;
+        }
+        const auto positions = geometry->getPosition3Array(segment.m_startVtx, segment.m_vtxCount);
+        const auto remap = optimizeTriangleList(segment_indices, segment.m_vtxCount, positions,
+            &vertex_memory[static_cast<size_t>(segment.m_startVtx) * vertex_size], vertex_size, segment_options, report);
+        if (!can_remap_vertices)
+        {
+            for (unsigned& index : segment_indices) index = remap[index];
+            std::copy(segment_indices.begin(), segment_indices.end(), new_indices.begin() + segment.m_startIdx);
+            continue;
+        }
+        std::copy(segment_indices.begin(), segment_indices.end(), new_indices.begin() + segment.m_startIdx);
+        for (unsigned old_index : remap) vertex_remap.push_back(segment.m_startVtx + old_index);
+        new_segment.m_vtxCount = static_cast<unsigned>(remap.size());
+        new_segments.push_back(new_segment);
+    }
+
+    if (!can_remap_vertices) return geometry->setIndexArray(new_indices);
+    if (auto er = geometry->remapVertices(vertex_remap)) return er;
+    if (auto er = geometry->setIndexArray(new_indices)) return er;
+    for (unsigned i = 0; i < new_segments.size(); i++)
+    {
+        geometry->changeSegment(i, new_segments[i].m_startVtx, new_segments[i].m_vtxCount, new_segments[i].m_startIdx, new_segments[i].m_idxCount);
+    }
+    return ErrorCode::ok;
+}
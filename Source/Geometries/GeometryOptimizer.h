@@ -0,0 +1,97 @@
+﻿/*********************************************************************
+ * \file   GeometryOptimizer.h
+ * \brief  triangle list 最佳化 (asset build 用, headless & deterministic)
+ *         去除重複 vertex, vertex cache (Forsyth), overdraw (cluster sort),
+ *         vertex fetch (first use order)
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef GEOMETRY_OPTIMIZER_H
+#define GEOMETRY_OPTIMIZER_H
+
+#include "Frameworks/ExtentTypesDefine.h"
+#include "MathLib/Vector3.h"
+#include <memory>
+#include <vector>
+#include <system_error>
+
+namespace Enigma::Geometries
+{
+    class GeometryData;
+
+    class GeometryOptimizer
+    {
+    public:
+        /// 統計用的 FIFO post-transform cache 大小
+        static constexpr unsigned DefaultCacheSize = 16;
+        /// Forsyth score 用的 LRU cache 大小
+        static constexpr unsigned ForsythCacheSize = 32;
+
+        struct Options
+        {
+            bool m_removeDuplicateVertices = true;
+            bool m_optimizeVertexCache = true;
+            bool m_optimizeOverdraw = true;
+            /** overdraw 排序可以接受的 ACMR 變差比例 */
+            float m_overdrawThreshold = 1.05f;
+            bool m_optimizeVertexFetch = true;
+            unsigned m_statisticsCacheSize = DefaultCacheSize;
+        };
+        struct VertexCacheStatistics
+        {
+            unsigned m_triangleCount = 0;
+            unsigned m_vertexCount = 0;  ///< 被 index 參照到的 vertex 數
+            unsigned m_cacheMissCount = 0;
+
+            /** average cache miss ratio, cache miss / triangle, 最佳約 0.5 */
+            float acmr() const { return m_triangleCount ? static_cast<float>(m_cacheMissCount) / static_cast<float>(m_triangleCount) : 0.0f; }
+            /** average transformed vertex ratio, cache miss / vertex, 最佳 1.0 */
+            float atvr() const { return m_vertexCount ? static_cast<float>(m_cacheMissCount) / static_cast<float>(m_vertexCount) : 0.0f; }
+            void accumulate(const VertexCacheStatistics& other);
+        };
+        struct Report
+        {
+            VertexCacheStatistics m_before;
+            VertexCacheStatistics m_after;
+            unsigned m_originalVertexCount = 0;
+            unsigned m_optimizedVertexCount = 0;
+        };
+
+    public:
+        /** triangle list geometry, 每個 segment 分開最佳化, index 相對於 segment 的 start vertex */
+        static std::error_code optimize(const std::shared_ptr<GeometryData>& geometry, const Options& options, Report& report);
+
+        /** 最佳化一組 triangle list, index 範圍 0 ~ vertex_count - 1
+            @param vertex_bytes 用來比對重複 vertex 的資料 (vertex_count * vertex_stride), null : 不去除重複
+            @return new vertex i = old vertex remap[i], 沒被參照的 vertex 會被拿掉 */
+        static std::vector<unsigned> optimizeTriangleList(uint_buffer& indices, unsigned vertex_count,
+            const std::vector<MathLib::Vector3>& positions, const unsigned char* vertex_bytes, size_t vertex_stride,
+            const Options& options, Report& report);
+
+        static VertexCacheStatistics analyzeVertexCache(const uint_buffer& indices, unsigned vertex_count, unsigned cache_size);
+
+        /** Tom Forsyth, linear-speed vertex cache optimisation */
+        static uint_buffer optimizeVertexCache(const uint_buffer& indices, unsigned vertex_count);
+        /** 依 cache 的邊界切成 cluster, 再依 cluster 朝外的程度由外往內排序 (Sander et al.) */
+        static uint_buffer optimizeOverdraw(const uint_buffer& indices, unsigned vertex_count,
+            const std::vector<MathLib::Vector3>& positions, float threshold, unsigned cache_size);
+        /** @return canonical[i] : 與 vertex i 完全相同的第一個 vertex */
+        static std::vector<unsigned> findDuplicateVertices(const unsigned char* vertex_bytes, size_t vertex_stride, unsigned vertex_count);
+        /** 改寫 indices 成新的 vertex 順序, first_use_order : 依第一次被參照的順序, 否則維持原本順序
+            @return new vertex i = old vertex remap[i] */
+        static std::vector<unsigned> compactVertices(uint_buffer& indices, unsigned vertex_count, bool first_use_order);
+
+        template <class T> static std::vector<T> remapVertexArray(const std::vector<T>& vertices, const std::vector<unsigned>& remap)
+        {
+            std::vector<T> remapped;
+            remapped.reserve(remap.size());
+            for (unsigned old_index : remap)
+            {
+                remapped.push_back(vertices[old_index]);
+            }
+            return remapped;
+        }
+    };
+}
+
+#endif // GEOMETRY_OPTIMIZER_H
@@ -57,7 +57,11 @@ ServiceResult GeometryRepository::onInit()
 ServiceResult GeometryRepository::onTerm()
 {
     m_storeMapper->disconnect();
-    m_geometries.clear();
+    {
+        std::lock_guard locker{ m_geometryLock };
+        m_geometries.clear();
+        m_cachePolicy.clear();
+    }
 
     QueryDispatcher::unsubscribe(typeid(QueryGeometryData), m_queryGeometryData);
     m_queryGeometryData = nullptr;
@@ -88,16 +92,63 @@ std::shared_ptr<GeometryData> GeometryRepository::queryGeometryData(const Geomet
     if (!hasGeometryData(id)) return nullptr;
     std::lock_guard locker{ m_geometryLock };
     auto it = m_geometries.find(id);
-    if (it != m_geometries.end()) return it->second;
+    if (it != m_geometries.end())
+    {
+        m_cachePolicy.hit(id);
+        m_cachePolicy.track(id, it->second->estimatedByteSize());
+        return it->second;
+    }
     assert(m_factory);
+    m_cachePolicy.miss();
     const auto dto = m_storeMapper->queryGeometry(id);
     assert(dto.has_value());
     auto geometry = m_factory->constitute(id, dto.value(), true);
     assert(geometry);
     m_geometries.insert_or_assign(id, geometry);
+    m_cachePolicy.track(id, geometry->estimatedByteSize());
+    evictOverBudget();
     return geometry;
 }
 
+void GeometryRepository::cacheBudgetBytes(size_t bytes)
+{
+    std::lock_guard locker{ m_geometryLock };
+    m_cachePolicy.budgetBytes(bytes);
+}
+
+size_t GeometryRepository::cacheBudgetBytes()
+{
+    std::lock_guard locker{ m_geometryLock };
+    return m_cachePolicy.budgetBytes();
+}
+
+unsigned GeometryRepository::evictOverBudget()
+{
+    assert(m_storeMapper);
+    std::lock_guard locker{ m_geometryLock };
+    return m_cachePolicy.evictOverBudget(
+        [this](const GeometryId& id)
+        {
+            // 只 evict 可以從 store 重新載入, 而且外面沒有人在用的
+            auto it = m_geometries.find(id);
+            if (it == m_geometries.end()) return true;
+            return (it->second.use_count() == 1) && (m_storeMapper->hasGeometry(id));
+        },
+        [this](const GeometryId& id) { m_geometries.erase(id); });
+}
+
+RepositoryCacheStatistics GeometryRepository::cacheStatistics()
+{
+    std::lock_guard locker{ m_geometryLock };
+    return m_cachePolicy.statistics();
+}
+
+void GeometryRepository::resetCacheStatistics()
+{
+    std::lock_guard locker{ m_geometryLock };
+    m_cachePolicy.resetStatistics();
+}
+
 void GeometryRepository::queryGeometryData(const Frameworks::IQueryPtr& q)
 {
     if (!q) return;
@@ -122,6 +173,7 @@ void GeometryRepository::requestGeometryCreation(const IQueryPtr& r)
     {
         std::lock_guard locker{ m_geometryLock };
         m_geometries.insert_or_assign(request->id(), geometry);
+        m_cachePolicy.track(request->id(), geometry->estimatedByteSize());
     }
     else if (request->persistenceLevel() == PersistenceLevel::Store)
     {
@@ -145,6 +197,7 @@ void GeometryRepository::requestGeometryConstitution(const IQueryPtr& r)
     {
         std::lock_guard locker{ m_geometryLock };
         m_geometries.insert_or_assign(request->id(), geometry);
+        m_cachePolicy.track(request->id(), geometry->estimatedByteSize());
     }
     else if (request->persistenceLevel() == PersistenceLevel::Store)
     {
@@ -174,6 +227,7 @@ void GeometryRepository::removeGeometryData(const GeometryId& id)
     if (!hasGeometryData(id)) return;
     std::lock_guard locker{ m_geometryLock };
     m_geometries.erase(id);
+    m_cachePolicy.untrack(id);
     error er = m_storeMapper->removeGeometry(id);
     if (er)
     {
@@ -191,6 +245,7 @@ void GeometryRepository::putGeometryData(const GeometryId& id, const std::shared
     if (hasGeometryData(id)) return;
     std::lock_guard locker{ m_geometryLock };
     m_geometries.insert_or_assign(id, data);
+    m_cachePolicy.track(id, data->estimatedByteSize());
     error er = m_storeMapper->putGeometry(id, data->serializeDto());
     if (er)
     {
@@ -12,6 +12,7 @@
 #include "Frameworks/ServiceManager.h"
 #include "Frameworks/QuerySubscriber.h"
 #include "Frameworks/CommandSubscriber.h"
+#include "Frameworks/RepositoryCachePolicy.h"
 #include "GeometryId.h"
 #include <memory>
 #include <mutex>
@@ -48,6 +49,18 @@ namespace Enigma::Geometries
         void removeGeometryData(const GeometryId& id);
         void putGeometryData(const GeometryId& id, const std::shared_ptr<GeometryData>& data);
 
+        /** @name cache policy
+            超過預算時, 以 LRU 順序 evict 已存入 store 且沒有被 repository 以外參照的 geometry,
+            下次 query 時再從 store mapper 載入 */
+        //@{
+        /** 0 : no budget (default) */
+        void cacheBudgetBytes(size_t bytes);
+        size_t cacheBudgetBytes();
+        unsigned evictOverBudget();
+        Frameworks::RepositoryCacheStatistics cacheStatistics();
+        void resetCacheStatistics();
+        //@}
+
     protected:
         void queryGeometryData(const Frameworks::IQueryPtr& q);
         void requestGeometryCreation(const Frameworks::IQueryPtr& r);
@@ -61,6 +74,7 @@ namespace Enigma::Geometries
         GeometryDataFactory* m_factory;
         std::unordered_map<GeometryId, std::shared_ptr<GeometryData>, GeometryId::hash> m_geometries;
         std::recursive_mutex m_geometryLock;
+        Frameworks::RepositoryCachePolicy<GeometryId, GeometryId::hash> m_cachePolicy;
 
         Frameworks::QuerySubscriberPtr m_queryGeometryData;
         Frameworks::QuerySubscriberPtr m_requestGeometryCreation;
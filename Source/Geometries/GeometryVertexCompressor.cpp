@@ -0,0 +1,54 @@
+﻿#include "GeometryVertexCompressor.h"
+#include "GeometryData.h"
+#include "GeometryErrors.h"
+#include "GraphicKernel/VertexDescription.h"
+#include "GraphicKernel/IIndexBuffer.h"
+#include "Platforms/PlatformLayer.h"
+
+using namespace Enigma::Geometries;
+using namespace Enigma::Graphics;
+
+std::string GeometryVertexCompressor::compressedVertexFormat(const std::string& vertex_format, const Options& options)
+{
+    VertexFormatCode code;
+    code.FromString(vertex_format);
+    const VertexDescription desc = code.calculateVertexSize();
+    const unsigned pos_mask = code.m_fvfCode & VertexFormatCode::POSITION_MASK;
+    if ((options.m_halfTextureCoord) && (code.m_texCount > 0)) code.m_fvfCode |= VertexFormatCode::HALF_TEXCOORD;
+    if ((options.m_unorm8Weight) && (desc.blendWeightCount() > 0) && (desc.blendWeightCount() <= 4))
+    {
+        code.m_fvfCode |= VertexFormatCode::UNORM8_WEIGHT;
+    }
+    if ((options.m_octNormal) && (code.m_fvfCode & VertexFormatCode::NORMAL)) code.m_fvfCode |= VertexFormatCode::OCT_NORMAL;
+    // 有 binormal 時 tangent 只有 3 維, 沒有 handedness 可以放
+    if ((options.m_octTangent) && (code.m_fvfCode & VertexFormatCode::TANGENT) && (!(code.m_fvfCode & VertexFormatCode::BINORMAL)))
+    {
+        code.m_fvfCode |= VertexFormatCode::OCT_TANGENT;
+    }
+    if ((options.m_quantizedPosition) && (pos_mask != 0) && (pos_mask != VertexFormatCode::XYZRHW) && (pos_mask != VertexFormatCode::XYZW))
+    {
+        code.m_fvfCode |= VertexFormatCode::QUANTIZED_POSITION;
+    }
+    return code.ToString();
+}
+
+std::error_code GeometryVertexCompressor::compress(const std::shared_ptr<GeometryData>& geometry, const Options& options, Report& report)
+{
+    if (!geometry) return ErrorCode::nullMemoryBuffer;
+    report.m_originalFormat = geometry->getVertexFormatString();
+    report.m_originalVertexBytes = static_cast<size_t>(geometry->getVertexCapacity()) * geometry->sizeofVertex();
+    report.m_originalIndexBytes = static_cast<size_t>(geometry->getIndexCapacity()) * sizeof(unsigned int);
+
+    report.m_compressedFormat = compressedVertexFormat(report.m_originalFormat, options);
+    if (report.m_compressedFormat != report.m_originalFormat)
+    {
+        if (auto er = geometry->convertVertexFormat(report.m_compressedFormat)) return er;
+    }
+    report.m_compressedVertexBytes = static_cast<size_t>(geometry->getVertexCapacity()) * geometry->sizeofVertex();
+    report.m_compressedIndexBytes = IIndexBuffer::canUseShortIndex(geometry->getVertexCapacity())
+        ? static_cast<size_t>(geometry->getIndexCapacity()) * sizeof(std::uint16_t) : report.m_originalIndexBytes;
+
+    Platforms::Debug::Printf("geometry %s compressed %s -> %s, %zu -> %zu bytes\n", geometry->id().name().c_str(),
+        report.m_originalFormat.c_str(), report.m_compressedFormat.c_str(), report.originalBytes(), report.compressedBytes());
+    return ErrorCode::ok;
+}
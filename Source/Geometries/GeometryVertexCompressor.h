@@ -0,0 +1,53 @@
+﻿/*********************************************************************
+ * \file   GeometryVertexCompressor.h
+ * \brief  import 時把 geometry 的 vertex attributes 轉成壓縮格式,
+ *         並回報省下多少 bytes
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef GEOMETRY_VERTEX_COMPRESSOR_H
+#define GEOMETRY_VERTEX_COMPRESSOR_H
+
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace Enigma::Geometries
+{
+    class GeometryData;
+
+    class GeometryVertexCompressor
+    {
+    public:
+        /** half uv 與 unorm8 weights 對 shader 是透明的;
+            octahedral normal/tangent 與 quantized position 需要 shader 解碼, 預設不開 */
+        struct Options
+        {
+            bool m_halfTextureCoord = true;
+            bool m_unorm8Weight = true;
+            bool m_octNormal = false;
+            bool m_octTangent = false;
+            bool m_quantizedPosition = false;
+        };
+        struct Report
+        {
+            std::string m_originalFormat;
+            std::string m_compressedFormat;
+            size_t m_originalVertexBytes = 0;
+            size_t m_compressedVertexBytes = 0;
+            size_t m_originalIndexBytes = 0;
+            size_t m_compressedIndexBytes = 0;  ///< device 上的 index buffer size
+
+            size_t originalBytes() const { return m_originalVertexBytes + m_originalIndexBytes; }
+            size_t compressedBytes() const { return m_compressedVertexBytes + m_compressedIndexBytes; }
+            size_t savedBytes() const { return originalBytes() - compressedBytes(); }
+        };
+    public:
+        /** 在 vertex format string 上加上可用的壓縮 token */
+        static std::string compressedVertexFormat(const std::string& vertex_format, const Options& options);
+
+        static std::error_code compress(const std::shared_ptr<GeometryData>& geometry, const Options& options, Report& report);
+    };
+}
+
+#endif // GEOMETRY_VERTEX_COMPRESSOR_H
@@ -42,6 +42,10 @@ Intersector::Result IntrGeometryRay3::test(std::unique_ptr<IntersectorCache> las
         if (!res.m_hasIntersect) return { false, std::move(last_result) };
     }
 
+    if (m_geometry->canCastRay())
+    {
+        return { m_geometry->castRay(m_ray).has_value(), std::move(last_result) };
+    }
     // test for triangle list
     if (m_geometry->getPrimitiveTopology() == Graphics::PrimitiveTopology::Topology_TriangleList)
     {
@@ -66,6 +70,10 @@ Intersector::Result IntrGeometryRay3::find(std::unique_ptr<IntersectorCache> las
         if (!res.m_hasIntersect) return { false, std::move(last_result) };
     }
 
+    if (m_geometry->canCastRay())
+    {
+        return findForCastRay(std::move(last_result));
+    }
     // test for triangle list
     if (m_geometry->getPrimitiveTopology() == Graphics::PrimitiveTopology::Topology_TriangleList)
     {
@@ -114,37 +122,30 @@ Intersector::Result IntrGeometryRay3::testForTriangleList(std::unique_ptr<IntrGe
     unsigned int tri_count = tri_list->getTriangleCount();
     if (tri_count <= 0) return { false, std::move(geo_cache) };
 
-    unsigned int start_index = 0;
-    if (geo_cache) start_index = geo_cache->getElementCachedIndex();
-    unsigned int forward_count = tri_count - start_index;
-    unsigned int backward_count = start_index + 1;
-    unsigned int test_total = forward_count * 2;
-    if (backward_count > forward_count) test_total = backward_count * 2;
-
     Vector3 triangle[3];
-    for (unsigned int i = 1; i < test_total; i++) // 從1開始，加減0是一樣的
+    // 上次打到的 triangle 先測, 連續幾個 frame 的 ray 通常打在同一個地方
+    if ((geo_cache) && (geo_cache->getElementCachedIndex() < tri_count))
     {
-        int tri_index;
-        if (i & 0x01)
-        {
-            tri_index = start_index + (i >> 1);
-        }
-        else
-        {
-            tri_index = start_index - (i >> 1);
-        }
-        if ((tri_index < 0) || (tri_index >= (int)tri_count)) continue;
-
-        tri_list->fetchTrianglePos(tri_index, triangle);
-        if (!IntrRay3Triangle3(m_ray, triangle).test(nullptr).m_hasIntersect) continue;
-
-        // if we got here, we found intersection
-        if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
-        if (geo_cache) geo_cache->setElementCachedIndex(tri_index);
-        return { true, std::move(geo_cache) };
+        tri_list->fetchTrianglePos(geo_cache->getElementCachedIndex(), triangle);
+        if (IntrRay3Triangle3(m_ray, triangle).test(nullptr).m_hasIntersect) return { true, std::move(geo_cache) };
     }
 
-    return { false, std::move(geo_cache) };
+    bool has_intersect = false;
+    unsigned int hit_index = 0;
+    tri_list->triangleBvh()->traverse(m_ray, [&](unsigned int tri_index)
+        {
+            tri_list->fetchTrianglePos(tri_index, triangle);
+            if (!IntrRay3Triangle3(m_ray, triangle).test(nullptr).m_hasIntersect) return true;
+            has_intersect = true;
+            hit_index = tri_index;
+            return false;
+        });
+    if (!has_intersect) return { false, std::move(geo_cache) };
+
+    // if we got here, we found intersection
+    if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
+    if (geo_cache) geo_cache->setElementCachedIndex(hit_index);
+    return { true, std::move(geo_cache) };
 }
 
 Intersector::Result IntrGeometryRay3::findForTriangleList(std::unique_ptr<IntrGeometryCache> geo_cache)
@@ -158,45 +159,50 @@ Intersector::Result IntrGeometryRay3::findForTriangleList(std::unique_ptr<IntrGe
     unsigned int tri_count = tri_list->getTriangleCount();
     if (tri_count <= 0) return { false, std::move(geo_cache) };
 
-    unsigned int start_index = 0;
-    if (geo_cache) start_index = geo_cache->getElementCachedIndex();
-    unsigned int forward_count = tri_count - start_index;
-    unsigned int backward_count = start_index + 1;
-    unsigned int test_total = forward_count * 2;
-    if (backward_count > forward_count) test_total = backward_count * 2;
     unsigned int req_result_total = 0xffffffff;
     if ((geo_cache) && (geo_cache->getRequiredResultCount())) req_result_total = geo_cache->getRequiredResultCount();
-    unsigned int result_count = 0;
+    unsigned int hit_index = 0;
 
     Vector3 triangle[3];
-    for (unsigned int i = 1; i < test_total; i++) // 從1開始，加減0是一樣的
+    const auto bvh = tri_list->triangleBvh();
+    if (req_result_total == 1)
     {
-        int tri_index;
-        if (i & 0x01)
-        {
-            tri_index = start_index + (i >> 1);
-        }
-        else
+        // 只要一個結果時要最近的那個, 不是第一個走訪到的
+        const auto nearest = bvh->findNearest(m_ray, [&](unsigned int tri_index) -> std::optional<float>
+            {
+                tri_list->fetchTrianglePos(tri_index, triangle);
+                IntrRay3Triangle3 intr(m_ray, triangle);
+                if (!intr.find(nullptr).m_hasIntersect) return std::nullopt;
+                return intr.getRayT();
+            });
+        if (nearest)
         {
-            tri_index = start_index - (i >> 1);
+            m_tParams.emplace_back(nearest->m_t);
+            hit_index = nearest->m_triangleIndex;
         }
-        if ((tri_index < 0) || (tri_index >= (int)tri_count)) continue;
-
-        tri_list->fetchTrianglePos(tri_index, triangle);
-        IntrRay3Triangle3 intr(m_ray, triangle);
-        if (!intr.find(nullptr).m_hasIntersect) continue;
-        float t = intr.getRayT();
-        if (t < 0.0f) continue;
-
-        // if we got here, we found intersection
-        m_tParams.emplace_back(t);
-        if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
-        if (geo_cache) geo_cache->setElementCachedIndex(tri_index);
-        result_count++;
-        if (result_count >= req_result_total) break;
+    }
+    else
+    {
+        unsigned int result_count = 0;
+        bvh->traverse(m_ray, [&](unsigned int tri_index)
+            {
+                tri_list->fetchTrianglePos(tri_index, triangle);
+                IntrRay3Triangle3 intr(m_ray, triangle);
+                if (!intr.find(nullptr).m_hasIntersect) return true;
+                float t = intr.getRayT();
+                if (t < 0.0f) return true;
+
+                // if we got here, we found intersection
+                m_tParams.emplace_back(t);
+                hit_index = tri_index;
+                result_count++;
+                return result_count < req_result_total;
+            });
     }
 
     if (m_tParams.empty()) return { false, std::move(geo_cache) };
+    if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
+    if (geo_cache) geo_cache->setElementCachedIndex(hit_index);
     sort(m_tParams.begin(), m_tParams.end());
 
     m_points.resize(m_tParams.size());
@@ -207,3 +213,15 @@ Intersector::Result IntrGeometryRay3::findForTriangleList(std::unique_ptr<IntrGe
 
     return { true, std::move(geo_cache) };
 }
+
+Intersector::Result IntrGeometryRay3::findForCastRay(std::unique_ptr<IntersectorCache> last_result)
+{
+    m_tParams.clear();
+    m_points.clear();
+    // 特化的 ray cast 只給最近的交點
+    auto t = m_geometry->castRay(m_ray);
+    if (!t) return { false, std::move(last_result) };
+    m_tParams.emplace_back(t.value());
+    m_points.emplace_back(t.value() * m_ray.direction() + m_ray.origin());
+    return { true, std::move(last_result) };
+}
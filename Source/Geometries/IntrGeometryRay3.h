@@ -44,6 +44,7 @@ namespace Enigma::Geometries
     private:
         Result testForTriangleList(std::unique_ptr<IntrGeometryCache> geo_cache);
         Result findForTriangleList(std::unique_ptr<IntrGeometryCache> geo_cache);
+        Result findForCastRay(std::unique_ptr<MathLib::IntersectorCache> last_result);
 
     private:
         // the objects to intersect
@@ -5,6 +5,7 @@
 #include "MathLib/ContainmentBox3.h"
 #include "MathLib/MathGlobal.h"
 #include "GeometryDataQueries.h"
+#include <cmath>
 
 using namespace Enigma::Geometries;
 using namespace Enigma::Engine;
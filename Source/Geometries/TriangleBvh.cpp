@@ -0,0 +1,397 @@
+﻿#include "TriangleBvh.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cfloat>
+#include <cassert>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+/// build 的最大深度, traverse 的 stack 靠這個上限, 不用動態配置
+constexpr unsigned MAX_TREE_DEPTH = 60;
+constexpr unsigned TRAVERSE_STACK_SIZE = MAX_TREE_DEPTH + 4;
+/// 走訪一個 node 相對於測一個 triangle 的成本
+constexpr float NODE_TRAVERSAL_COST = 1.0f;
+
+void TriangleBvh::Aabb::reset()
+{
+    m_min[0] = m_min[1] = m_min[2] = FLT_MAX;
+    m_max[0] = m_max[1] = m_max[2] = -FLT_MAX;
+}
+
+void TriangleBvh::Aabb::grow(const float* p)
+{
+    for (unsigned i = 0; i < 3; i++)
+    {
+        m_min[i] = std::min(m_min[i], p[i]);
+        m_max[i] = std::max(m_max[i], p[i]);
+    }
+}
+
+void TriangleBvh::Aabb::grow(const Aabb& box)
+{
+    for (unsigned i = 0; i < 3; i++)
+    {
+        m_min[i] = std::min(m_min[i], box.m_min[i]);
+        m_max[i] = std::max(m_max[i], box.m_max[i]);
+    }
+}
+
+float TriangleBvh::Aabb::surfaceArea() const
+{
+    if (m_min[0] > m_max[0]) return 0.0f;
+    const float ex = m_max[0] - m_min[0];
+    const float ey = m_max[1] - m_min[1];
+    const float ez = m_max[2] - m_min[2];
+    return 2.0f * (ex * ey + ey * ez + ez * ex);
+}
+
+TriangleBvh::TriangleBvh() : m_builtSurfaceArea(0.0f), m_refitCount(0)
+{
+}
+
+TriangleBvh::~TriangleBvh()
+{
+    m_nodes.clear();
+    m_triangleIndices.clear();
+}
+
+void TriangleBvh::build(const std::vector<Vector3>& triangle_positions)
+{
+    m_nodes.clear();
+    m_triangleIndices.clear();
+    m_builtSurfaceArea = 0.0f;
+    m_refitCount = 0;
+    const unsigned tri_count = static_cast<unsigned>(triangle_positions.size() / 3);
+    if (tri_count == 0) return;
+
+    std::vector<Aabb> triangle_boxes(tri_count);
+    std::vector<Vector3> centroids(tri_count);
+    for (unsigned i = 0; i < tri_count; i++)
+    {
+        const Vector3* tri = &triangle_positions[static_cast<size_t>(i) * 3];
+        triangle_boxes[i].reset();
+        triangle_boxes[i].grow(tri[0]);
+        triangle_boxes[i].grow(tri[1]);
+        triangle_boxes[i].grow(tri[2]);
+        centroids[i] = (tri[0] + tri[1] + tri[2]) / 3.0f;
+    }
+    m_triangleIndices.resize(tri_count);
+    std::iota(m_triangleIndices.begin(), m_triangleIndices.end(), 0u);
+
+    m_nodes.reserve(static_cast<size_t>(tri_count) * 2);
+    m_nodes.push_back(Node{ { 0.0f, 0.0f, 0.0f }, 0, { 0.0f, 0.0f, 0.0f }, tri_count });
+    updateNodeBox(m_nodes[0], triangle_boxes);
+    m_builtSurfaceArea = nodeSurfaceArea(m_nodes[0]);
+
+    // 用 explicit stack, 大 mesh 不會遞迴太深
+    std::vector<std::pair<unsigned, unsigned>> pending{ { 0u, 0u } };
+    while (!pending.empty())
+    {
+        auto [node_index, depth] = pending.back();
+        pending.pop_back();
+        if (depth >= MAX_TREE_DEPTH) continue;
+        subdivide(node_index, triangle_boxes, centroids);
+        if (m_nodes[node_index].isLeaf()) continue;
+        const unsigned left = m_nodes[node_index].m_leftOrFirst;
+        pending.emplace_back(left, depth + 1);
+        pending.emplace_back(left + 1, depth + 1);
+    }
+    m_nodes.shrink_to_fit();
+}
+
+bool TriangleBvh::refit(const std::vector<Vector3>& triangle_positions)
+{
+    if (m_nodes.empty()) return false;
+    if (triangle_positions.size() / 3 != m_triangleIndices.size()) return false;
+
+    // children 一定排在 parent 後面, 倒著走就是由下往上
+    for (size_t n = m_nodes.size(); n-- > 0;)
+    {
+        Node& node = m_nodes[n];
+        Aabb box;
+        box.reset();
+        if (node.isLeaf())
+        {
+            for (unsigned i = node.m_leftOrFirst; i < node.m_leftOrFirst + node.m_triangleCount; i++)
+            {
+                const Vector3* tri = &triangle_positions[static_cast<size_t>(m_triangleIndices[i]) * 3];
+                box.grow(tri[0]);
+                box.grow(tri[1]);
+                box.grow(tri[2]);
+            }
+        }
+        else
+        {
+            const Node& left = m_nodes[node.m_leftOrFirst];
+            const Node& right = m_nodes[node.m_leftOrFirst + 1];
+            for (unsigned i = 0; i < 3; i++)
+            {
+                box.m_min[i] = std::min(left.m_boxMin[i], right.m_boxMin[i]);
+                box.m_max[i] = std::max(left.m_boxMax[i], right.m_boxMax[i]);
+            }
+        }
+        std::copy(box.m_min, box.m_min + 3, node.m_boxMin);
+        std::copy(box.m_max, box.m_max + 3, node.m_boxMax);
+    }
+    m_refitCount++;
+    return nodeSurfaceArea(m_nodes[0]) <= m_builtSurfaceArea * RebuildSurfaceAreaRatio;
+}
+
+void TriangleBvh::traverse(const Ray3& ray, const TriangleVisitor& visitor) const
+{
+    if (m_nodes.empty()) return;
+    const Vector3 origin = ray.origin();
+    const Vector3 inv_dir = inverseDirection(ray.direction());
+
+    float t_near;
+    if (!intersectNode(m_nodes[0], origin, inv_dir, t_near)) return;
+    unsigned stack[TRAVERSE_STACK_SIZE];
+    unsigned stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const Node& node = m_nodes[stack[--stack_size]];
+        if (node.isLeaf())
+        {
+            for (unsigned i = node.m_leftOrFirst; i < node.m_leftOrFirst + node.m_triangleCount; i++)
+            {
+                if (!visitor(m_triangleIndices[i])) return;
+            }
+            continue;
+        }
+        float t_left, t_right;
+        const bool hit_left = intersectNode(m_nodes[node.m_leftOrFirst], origin, inv_dir, t_left);
+        const bool hit_right = intersectNode(m_nodes[node.m_leftOrFirst + 1], origin, inv_dir, t_right);
+        assert(stack_size + 2 <= TRAVERSE_STACK_SIZE);
+        // 近的後 push, 先 pop 出來
+        if (hit_left && hit_right)
+        {
+            if (t_left <= t_right)
+            {
+                stack[stack_size++] = node.m_leftOrFirst + 1;
+                stack[stack_size++] = node.m_leftOrFirst;
+            }
+            else
+            {
+                stack[stack_size++] = node.m_leftOrFirst;
+                stack[stack_size++] = node.m_leftOrFirst + 1;
+            }
+        }
+        else if (hit_left)
+        {
+            stack[stack_size++] = node.m_leftOrFirst;
+        }
+        else if (hit_right)
+        {
+            stack[stack_size++] = node.m_leftOrFirst + 1;
+        }
+    }
+}
+
+std::optional<TriangleBvh::NearestHit> TriangleBvh::findNearest(const Ray3& ray, const TriangleHitTest& hit_test) const
+{
+    if (m_nodes.empty()) return std::nullopt;
+    const Vector3 origin = ray.origin();
+    const Vector3 inv_dir = inverseDirection(ray.direction());
+
+    float t_root;
+    if (!intersectNode(m_nodes[0], origin, inv_dir, t_root)) return std::nullopt;
+    std::optional<NearestHit> nearest;
+    // 存 push 時的 t_near, pop 出來時最近的 hit 可能已經更近, 就不用再走
+    std::pair<unsigned, float> stack[TRAVERSE_STACK_SIZE];
+    unsigned stack_size = 0;
+    stack[stack_size++] = { 0u, t_root };
+    while (stack_size > 0)
+    {
+        const auto [node_index, t_node] = stack[--stack_size];
+        if ((nearest) && (t_node > nearest->m_t)) continue;
+        const Node& node = m_nodes[node_index];
+        if (node.isLeaf())
+        {
+            for (unsigned i = node.m_leftOrFirst; i < node.m_leftOrFirst + node.m_triangleCount; i++)
+            {
+                const auto t = hit_test(m_triangleIndices[i]);
+                if ((!t) || (t.value() < 0.0f)) continue;
+                if ((!nearest) || (t.value() < nearest->m_t)) nearest = NearestHit{ m_triangleIndices[i], t.value() };
+            }
+            continue;
+        }
+        float t_left, t_right;
+        const bool hit_left = intersectNode(m_nodes[node.m_leftOrFirst], origin, inv_dir, t_left) && ((!nearest) || (t_left <= nearest->m_t));
+        const bool hit_right = intersectNode(m_nodes[node.m_leftOrFirst + 1], origin, inv_dir, t_right) && ((!nearest) || (t_right <= nearest->m_t));
+        assert(stack_size + 2 <= TRAVERSE_STACK_SIZE);
+        // 近的後 push, 先 pop 出來
+        if (hit_left && hit_right)
+        {
+            if (t_left <= t_right)
+            {
+                stack[stack_size++] = { node.m_leftOrFirst + 1, t_right };
+                stack[stack_size++] = { node.m_leftOrFirst, t_left };
+            }
+            else
+            {
+                stack[stack_size++] = { node.m_leftOrFirst, t_left };
+                stack[stack_size++] = { node.m_leftOrFirst + 1, t_right };
+            }
+        }
+        else if (hit_left)
+        {
+            stack[stack_size++] = { node.m_leftOrFirst, t_left };
+        }
+        else if (hit_right)
+        {
+            stack[stack_size++] = { node.m_leftOrFirst + 1, t_right };
+        }
+    }
+    return nearest;
+}
+
+void TriangleBvh::subdivide(unsigned node_index, const std::vector<Aabb>& triangle_boxes, const std::vector<Vector3>& centroids)
+{
+    const unsigned first = m_nodes[node_index].m_leftOrFirst;
+    const unsigned count = m_nodes[node_index].m_triangleCount;
+    if (count <= 2) return;
+
+    Aabb centroid_box;
+    centroid_box.reset();
+    for (unsigned i = first; i < first + count; i++)
+    {
+        centroid_box.grow(centroids[m_triangleIndices[i]]);
+    }
+
+    struct Bin
+    {
+        Aabb m_box;
+        unsigned m_count;
+    };
+    int best_axis = -1;
+    unsigned best_split = 0;
+    float best_cost = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float extent = centroid_box.m_max[axis] - centroid_box.m_min[axis];
+        if (extent <= FLT_EPSILON) continue;
+        const float scale = static_cast<float>(BinCount) / extent;
+        Bin bins[BinCount];
+        for (auto& bin : bins)
+        {
+            bin.m_box.reset();
+            bin.m_count = 0;
+        }
+        for (unsigned i = first; i < first + count; i++)
+        {
+            const unsigned tri = m_triangleIndices[i];
+            const unsigned b = std::min(BinCount - 1, static_cast<unsigned>((centroids[tri][axis] - centroid_box.m_min[axis]) * scale));
+            bins[b].m_box.grow(triangle_boxes[tri]);
+            bins[b].m_count++;
+        }
+        // 左右各掃一次, 累計每個切面兩側的 area & count
+        float left_area[BinCount - 1];
+        unsigned left_count[BinCount - 1];
+        Aabb sweep_box;
+        sweep_box.reset();
+        unsigned sweep_count = 0;
+        for (unsigned b = 0; b < BinCount - 1; b++)
+        {
+            sweep_box.grow(bins[b].m_box);
+            sweep_count += bins[b].m_count;
+            left_area[b] = sweep_box.surfaceArea();
+            left_count[b] = sweep_count;
+        }
+        sweep_box.reset();
+        sweep_count = 0;
+        for (unsigned b = BinCount - 1; b > 0; b--)
+        {
+            sweep_box.grow(bins[b].m_box);
+            sweep_count += bins[b].m_count;
+            if ((left_count[b - 1] == 0) || (sweep_count == 0)) continue;
+            const float cost = left_count[b - 1] * left_area[b - 1] + sweep_count * sweep_box.surfaceArea();
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    const float parent_area = nodeSurfaceArea(m_nodes[node_index]);
+    const float leaf_cost = static_cast<float>(count) * parent_area;
+    const float split_cost = NODE_TRAVERSAL_COST * parent_area + best_cost;
+    if ((count <= MaxLeafTriangleCount) && ((best_axis < 0) || (split_cost >= leaf_cost))) return;
+
+    unsigned left_count;
+    if (best_axis >= 0)
+    {
+        const float scale = static_cast<float>(BinCount) / (centroid_box.m_max[best_axis] - centroid_box.m_min[best_axis]);
+        const float min_c = centroid_box.m_min[best_axis];
+        auto middle = std::partition(m_triangleIndices.begin() + first, m_triangleIndices.begin() + first + count,
+            [&](unsigned tri)
+            {
+                return std::min(BinCount - 1, static_cast<unsigned>((centroids[tri][best_axis] - min_c) * scale)) < best_split;
+            });
+        left_count = static_cast<unsigned>(middle - (m_triangleIndices.begin() + first));
+    }
+    else
+    {
+        // centroid 全部重疊, 只能對半切
+        left_count = count / 2;
+    }
+    if ((left_count == 0) || (left_count == count)) left_count = count / 2;
+
+    const unsigned left = static_cast<unsigned>(m_nodes.size());
+    m_nodes.push_back(Node{ { 0.0f, 0.0f, 0.0f }, first, { 0.0f, 0.0f, 0.0f }, left_count });
+    m_nodes.push_back(Node{ { 0.0f, 0.0f, 0.0f }, first + left_count, { 0.0f, 0.0f, 0.0f }, count - left_count });
+    updateNodeBox(m_nodes[left], triangle_boxes);
+    updateNodeBox(m_nodes[left + 1], triangle_boxes);
+    m_nodes[node_index].m_leftOrFirst = left;
+    m_nodes[node_index].m_triangleCount = 0;
+}
+
+void TriangleBvh::updateNodeBox(Node& node, const std::vector<Aabb>& triangle_boxes) const
+{
+    Aabb box;
+    box.reset();
+    for (unsigned i = node.m_leftOrFirst; i < node.m_leftOrFirst + node.m_triangleCount; i++)
+    {
+        box.grow(triangle_boxes[m_triangleIndices[i]]);
+    }
+    std::copy(box.m_min, box.m_min + 3, node.m_boxMin);
+    std::copy(box.m_max, box.m_max + 3, node.m_boxMax);
+}
+
+float TriangleBvh::nodeSurfaceArea(const Node& node)
+{
+    const float ex = node.m_boxMax[0] - node.m_boxMin[0];
+    const float ey = node.m_boxMax[1] - node.m_boxMin[1];
+    const float ez = node.m_boxMax[2] - node.m_boxMin[2];
+    return 2.0f * (ex * ey + ey * ez + ez * ex);
+}
+
+bool TriangleBvh::intersectNode(const Node& node, const Vector3& origin, const Vector3& inv_dir, float& t_near)
+{
+    float t_min = 0.0f;
+    float t_max = FLT_MAX;
+    for (int i = 0; i < 3; i++)
+    {
+        const float t1 = (node.m_boxMin[i] - origin[i]) * inv_dir[i];
+        const float t2 = (node.m_boxMax[i] - origin[i]) * inv_dir[i];
+        t_min = std::max(t_min, std::min(t1, t2));
+        t_max = std::min(t_max, std::max(t1, t2));
+    }
+    t_near = t_min;
+    return t_max >= t_min;
+}
+
+Vector3 TriangleBvh::inverseDirection(const Vector3& dir)
+{
+    Vector3 inv_dir;
+    for (int i = 0; i < 3; i++)
+    {
+        // 避開 0 * inf 的 NaN
+        inv_dir[i] = std::fabs(dir[i]) > FLT_EPSILON ? 1.0f / dir[i] : std::copysign(1.0e30f, dir[i]);
+    }
+    return inv_dir;
+}
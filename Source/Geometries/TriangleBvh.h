@@ -0,0 +1,98 @@
+﻿/*********************************************************************
+ * \file   TriangleBvh.h
+ * \brief  bounding volume hierarchy of triangles, SAH binning build,
+ *         nodes 存在 flat array, 用在 triangle level 的 ray intersection
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "MathLib/Vector3.h"
+#include "MathLib/Ray3.h"
+#include <vector>
+#include <functional>
+#include <optional>
+
+namespace Enigma::Geometries
+{
+    class TriangleBvh
+    {
+    public:
+        /// SAH binning 的 bin 數
+        static constexpr unsigned BinCount = 16;
+        /// leaf 最多放幾個 triangle
+        static constexpr unsigned MaxLeafTriangleCount = 8;
+        /// refit 後 root 表面積超過 build 時的倍數就整個重建
+        static constexpr float RebuildSurfaceAreaRatio = 2.0f;
+
+        struct Node
+        {
+            float m_boxMin[3];
+            unsigned m_leftOrFirst;  ///< interior : left child index, right child = left + 1; leaf : first triangle slot
+            float m_boxMax[3];
+            unsigned m_triangleCount;  ///< 0 : interior node
+            bool isLeaf() const { return m_triangleCount > 0; }
+        };
+
+        /** return false to stop traversal */
+        using TriangleVisitor = std::function<bool(unsigned triangle_index)>;
+        /** ray 打到 triangle 時回傳 ray t, 沒打到回傳 nullopt */
+        using TriangleHitTest = std::function<std::optional<float>(unsigned triangle_index)>;
+
+        struct NearestHit
+        {
+            unsigned m_triangleIndex;
+            float m_t;
+        };
+
+    public:
+        TriangleBvh();
+        TriangleBvh(const TriangleBvh&) = default;
+        TriangleBvh(TriangleBvh&&) = default;
+        ~TriangleBvh();
+        TriangleBvh& operator=(const TriangleBvh&) = default;
+        TriangleBvh& operator=(TriangleBvh&&) = default;
+
+        /** build from triangle positions, 每 3 個 position 是一個 triangle */
+        void build(const std::vector<MathLib::Vector3>& triangle_positions);
+        /** triangle 數量不變, 只有 position 變動, 由下往上重算 node box
+            @return false : tree 品質太差, 需要重建 */
+        bool refit(const std::vector<MathLib::Vector3>& triangle_positions);
+
+        /** visit triangles whose leaf box is hit by ray, near node first */
+        void traverse(const MathLib::Ray3& ray, const TriangleVisitor& visitor) const;
+        /** ray 上最近的 triangle, near node first, node box 比目前最近的 hit 遠就略過 */
+        std::optional<NearestHit> findNearest(const MathLib::Ray3& ray, const TriangleHitTest& hit_test) const;
+
+        bool isEmpty() const { return m_nodes.empty(); }
+        unsigned triangleCount() const { return static_cast<unsigned>(m_triangleIndices.size()); }
+        const std::vector<Node>& nodes() const { return m_nodes; }
+        unsigned refitCount() const { return m_refitCount; }
+
+    protected:
+        struct Aabb
+        {
+            float m_min[3];
+            float m_max[3];
+            void reset();
+            void grow(const float* p);
+            void grow(const Aabb& box);
+            float surfaceArea() const;
+        };
+
+        void subdivide(unsigned node_index, const std::vector<Aabb>& triangle_boxes, const std::vector<MathLib::Vector3>& centroids);
+        void updateNodeBox(Node& node, const std::vector<Aabb>& triangle_boxes) const;
+        static float nodeSurfaceArea(const Node& node);
+        static bool intersectNode(const Node& node, const MathLib::Vector3& origin, const MathLib::Vector3& inv_dir, float& t_near);
+        static MathLib::Vector3 inverseDirection(const MathLib::Vector3& dir);
+
+    protected:
+        std::vector<Node> m_nodes;
+        std::vector<unsigned> m_triangleIndices;
+        float m_builtSurfaceArea;
+        unsigned m_refitCount;
+    };
+}
+
+#endif // TRIANGLE_BVH_H
@@ -58,10 +58,19 @@ void TriangleList::fetchTrianglePos(unsigned idx, MathLib::Vector3 tri[3])
 {
     unsigned int vtx_idx[3];
     fetchTriangleVertexIndex(idx, vtx_idx);
-    unsigned int vtx_pitch = sizeofVertex();
-    memcpy(&tri[0], &m_vertexMemory[vtx_idx[0] * vtx_pitch], sizeof(Vector3));
-    memcpy(&tri[1], &m_vertexMemory[vtx_idx[1] * vtx_pitch], sizeof(Vector3));
-    memcpy(&tri[2], &m_vertexMemory[vtx_idx[2] * vtx_pitch], sizeof(Vector3));
+    auto positions = positionView();
+    if (positions.empty())
+    {
+        // 壓縮格式, 要解碼
+        for (unsigned i = 0; i < 3; i++)
+        {
+            tri[i] = getPosition3(vtx_idx[i]);
+        }
+        return;
+    }
+    tri[0] = positions[vtx_idx[0]];
+    tri[1] = positions[vtx_idx[1]];
+    tri[2] = positions[vtx_idx[2]];
 }
 
 void TriangleList::fetchTriangleTextureCoord(unsigned idx, unsigned tex_channel, MathLib::Vector2 uv[3])
@@ -73,6 +82,15 @@ void TriangleList::fetchTriangleTextureCoord(unsigned idx, unsigned tex_channel,
     unsigned int vtx_idx[3];
     fetchTriangleVertexIndex(idx, vtx_idx);
 
+    if (m_vertexDesc.textureCoordFormat(tex_channel) != VertexDescription::ElementFormat::Float)
+    {
+        for (unsigned i = 0; i < 3; i++)
+        {
+            getVertexMemoryData(vtx_idx[i], m_vertexDesc.textureCoordOffset(tex_channel), m_vertexDesc.textureCoordSize(tex_channel),
+                2, reinterpret_cast<float*>(&uv[i]), false, m_vertexDesc.textureCoordFormat(tex_channel));
+        }
+        return;
+    }
     unsigned int vtx_pitch = sizeofVertex();
     unsigned int offset = m_vertexDesc.textureCoordOffset(tex_channel) * sizeof(float);
     memcpy(&uv[0], &m_vertexMemory[vtx_idx[0] * vtx_pitch + offset], sizeof(Vector2));
@@ -134,3 +152,63 @@ error TriangleList::calculateVertexTangentSpace(unsigned tex_channel)
 
     return ErrorCode::ok;
 }
+
+std::shared_ptr<const TriangleBvh> TriangleList::triangleBvh()
+{
+    std::lock_guard locker{ m_bvhLock };
+    if (!m_triangleBvh)
+    {
+        auto bvh = std::make_shared<TriangleBvh>();
+        bvh->build(fetchAllTrianglePos());
+        m_triangleBvh = bvh;
+    }
+    else if (m_bvhTopologyRevision != m_topologyRevision)
+    {
+        // 別的執行緒還拿著舊的 bvh 在走訪, 不可以就地修改
+        auto bvh = m_triangleBvh.use_count() > 1 ? std::make_shared<TriangleBvh>() : m_triangleBvh;
+        bvh->build(fetchAllTrianglePos());
+        m_triangleBvh = bvh;
+    }
+    else if (m_bvhPositionRevision != m_positionRevision)
+    {
+        // 只有 position 變動 (e.g. terrain 改高度), refit 就好, box 膨脹太多才重建; 舊的還有人用就在複本上 refit
+        auto bvh = m_triangleBvh.use_count() > 1 ? std::make_shared<TriangleBvh>(*m_triangleBvh) : m_triangleBvh;
+        auto positions = fetchAllTrianglePos();
+        if (!bvh->refit(positions)) bvh->build(positions);
+        m_triangleBvh = bvh;
+    }
+    m_bvhTopologyRevision = m_topologyRevision;
+    m_bvhPositionRevision = m_positionRevision;
+    return m_triangleBvh;
+}
+
+std::vector<Vector3> TriangleList::fetchAllTrianglePos()
+{
+    const unsigned tri_count = getTriangleCount();
+    std::vector<Vector3> positions(static_cast<size_t>(tri_count) * 3);
+    auto view = positionView();
+    unsigned int vtx_idx[3];
+    if (view.empty())
+    {
+        if (m_vertexDesc.positionOffset() < 0) return positions;
+        // 壓縮格式, 先整批解碼
+        const auto decoded = getPosition3Array(m_vtxUsedCount);
+        for (unsigned i = 0; i < tri_count; i++)
+        {
+            fetchTriangleVertexIndex(i, vtx_idx);
+            for (unsigned k = 0; k < 3; k++)
+            {
+                positions[static_cast<size_t>(i) * 3 + k] = decoded[vtx_idx[k]];
+            }
+        }
+        return positions;
+    }
+    for (unsigned i = 0; i < tri_count; i++)
+    {
+        fetchTriangleVertexIndex(i, vtx_idx);
+        positions[static_cast<size_t>(i) * 3] = view[vtx_idx[0]];
+        positions[static_cast<size_t>(i) * 3 + 1] = view[vtx_idx[1]];
+        positions[static_cast<size_t>(i) * 3 + 2] = view[vtx_idx[2]];
+    }
+    return positions;
+}
@@ -10,7 +10,9 @@
 
 #include "GeometryData.h"
 #include "GeometryDataDto.h"
+#include "TriangleBvh.h"
 #include <memory>
+#include <mutex>
 
 namespace Enigma::Geometries
 {
@@ -37,6 +39,19 @@ namespace Enigma::Geometries
 
         /** calculate tangent space */
         error calculateVertexTangentSpace(unsigned int tex_channel);
+
+        /** triangle bvh, 第一次取用時建立; position 變動時 refit, index 變動時重建;
+            可以多個執行緒同時 ray query, 每個拿到自己的 snapshot, 之後的 refit / rebuild 不會改到手上這份 */
+        std::shared_ptr<const TriangleBvh> triangleBvh();
+
+    protected:
+        std::vector<MathLib::Vector3> fetchAllTrianglePos();
+
+    protected:
+        std::mutex m_bvhLock;
+        std::shared_ptr<TriangleBvh> m_triangleBvh;
+        std::uint64_t m_bvhPositionRevision = 0;
+        std::uint64_t m_bvhTopologyRevision = 0;
     };
     using TriangleListPtr = std::shared_ptr<TriangleList>;
 
@@ -0,0 +1,176 @@
+﻿#include "VertexAttributeCodec.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace Enigma::Geometries;
+
+namespace
+{
+    std::int16_t floatToSnorm16(float v)
+    {
+        v = std::clamp(v, -1.0f, 1.0f);
+        return static_cast<std::int16_t>(std::lround(v * 32767.0f));
+    }
+    float snorm16ToFloat(std::int16_t v)
+    {
+        return std::max(static_cast<float>(v) / 32767.0f, -1.0f);
+    }
+    float signNotZero(float v)
+    {
+        return v >= 0.0f ? 1.0f : -1.0f;
+    }
+    /// unit vector -> octahedron [-1, 1]^2
+    void octWrap(const float* n, float& u, float& v)
+    {
+        const float l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+        if (l1 <= 0.0f)
+        {
+            u = 0.0f;
+            v = 0.0f;
+            return;
+        }
+        u = n[0] / l1;
+        v = n[1] / l1;
+        if (n[2] < 0.0f)
+        {
+            const float fu = (1.0f - std::fabs(v)) * signNotZero(u);
+            const float fv = (1.0f - std::fabs(u)) * signNotZero(v);
+            u = fu;
+            v = fv;
+        }
+    }
+    void octUnwrap(float u, float v, float* n)
+    {
+        float z = 1.0f - std::fabs(u) - std::fabs(v);
+        if (z < 0.0f)
+        {
+            const float fu = (1.0f - std::fabs(v)) * signNotZero(u);
+            const float fv = (1.0f - std::fabs(u)) * signNotZero(v);
+            u = fu;
+            v = fv;
+        }
+        const float len = std::sqrt(u * u + v * v + z * z);
+        n[0] = u / len;
+        n[1] = v / len;
+        n[2] = z / len;
+    }
+    std::uint32_t packSnorm16x2(std::int16_t x, std::int16_t y)
+    {
+        return static_cast<std::uint32_t>(static_cast<std::uint16_t>(x)) | (static_cast<std::uint32_t>(static_cast<std::uint16_t>(y)) << 16);
+    }
+}
+
+std::uint16_t VertexAttributeCodec::floatToHalf(float value)
+{
+    std::uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const std::uint32_t sign = (bits >> 16) & 0x8000;
+    const std::uint32_t abs_bits = bits & 0x7fffffff;
+    if (abs_bits >= 0x7f800000)  // inf or nan
+    {
+        return static_cast<std::uint16_t>(sign | 0x7c00 | ((abs_bits > 0x7f800000) ? 0x200 : 0));
+    }
+    if (abs_bits >= 0x477ff000) return static_cast<std::uint16_t>(sign | 0x7c00);  // overflow
+    if (abs_bits < 0x38800000)  // subnormal half or zero
+    {
+        if (abs_bits < 0x33000000) return static_cast<std::uint16_t>(sign);
+        const std::uint32_t exponent = abs_bits >> 23;
+        const std::uint32_t mantissa = (abs_bits & 0x7fffff) | 0x800000;
+        const std::uint32_t shift = 126 - exponent;
+        std::uint32_t half = mantissa >> shift;
+        const std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const std::uint32_t halfway = 1u << (shift - 1);
+        if ((remainder > halfway) || ((remainder == halfway) && (half & 1))) half++;
+        return static_cast<std::uint16_t>(sign | half);
+    }
+    // normal, round to nearest even
+    std::uint32_t half = ((abs_bits - 0x38000000) >> 13);
+    const std::uint32_t remainder = abs_bits & 0x1fff;
+    if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1))) half++;
+    return static_cast<std::uint16_t>(sign | half);
+}
+
+float VertexAttributeCodec::halfToFloat(std::uint16_t half)
+{
+    const std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000) << 16;
+    std::uint32_t exponent = (half >> 10) & 0x1f;
+    std::uint32_t mantissa = half & 0x3ff;
+    std::uint32_t bits;
+    if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // subnormal, normalize it
+            exponent = 113;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::uint32_t VertexAttributeCodec::encodeOctahedral(const float* normal)
+{
+    float u, v;
+    octWrap(normal, u, v);
+    return packSnorm16x2(floatToSnorm16(u), floatToSnorm16(v));
+}
+
+void VertexAttributeCodec::decodeOctahedral(std::uint32_t packed, float* normal)
+{
+    const float u = snorm16ToFloat(static_cast<std::int16_t>(packed & 0xffff));
+    const float v = snorm16ToFloat(static_cast<std::int16_t>(packed >> 16));
+    octUnwrap(u, v, normal);
+}
+
+std::uint32_t VertexAttributeCodec::encodeOctahedralTangent(const float* tangent)
+{
+    float u, v;
+    octWrap(tangent, u, v);
+    std::int16_t y = floatToSnorm16(v);
+    // y 最低位當作 handedness, 1 : w < 0
+    y = static_cast<std::int16_t>((y & ~1) | (tangent[3] < 0.0f ? 1 : 0));
+    return packSnorm16x2(floatToSnorm16(u), y);
+}
+
+void VertexAttributeCodec::decodeOctahedralTangent(std::uint32_t packed, float* tangent)
+{
+    decodeOctahedral(packed, tangent);
+    tangent[3] = (packed & 0x10000) ? -1.0f : 1.0f;
+}
+
+std::uint16_t VertexAttributeCodec::quantizeUnorm16(float value, float min, float extent)
+{
+    if (extent <= 0.0f) return 0;
+    const float t = std::clamp((value - min) / extent, 0.0f, 1.0f);
+    return static_cast<std::uint16_t>(std::lround(t * 65535.0f));
+}
+
+float VertexAttributeCodec::dequantizeUnorm16(std::uint16_t quantized, float min, float extent)
+{
+    return min + static_cast<float>(quantized) / 65535.0f * extent;
+}
+
+std::uint8_t VertexAttributeCodec::floatToUnorm8(float value)
+{
+    return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
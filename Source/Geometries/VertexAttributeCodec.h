@@ -0,0 +1,37 @@
+﻿/*********************************************************************
+ * \file   VertexAttributeCodec.h
+ * \brief  compressed vertex element encode / decode,
+ *         half float, octahedral normal, unorm16 / unorm8 quantization
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef VERTEX_ATTRIBUTE_CODEC_H
+#define VERTEX_ATTRIBUTE_CODEC_H
+
+#include <cstdint>
+
+namespace Enigma::Geometries
+{
+    class VertexAttributeCodec
+    {
+    public:
+        static std::uint16_t floatToHalf(float value);
+        static float halfToFloat(std::uint16_t half);
+
+        /** unit vector -> 2 x snorm16, x 在低 16 bits */
+        static std::uint32_t encodeOctahedral(const float* normal);
+        static void decodeOctahedral(std::uint32_t packed, float* normal);
+        /** tangent (xyz + handedness w), w 的符號放在 y 的最低位 */
+        static std::uint32_t encodeOctahedralTangent(const float* tangent);
+        static void decodeOctahedralTangent(std::uint32_t packed, float* tangent);
+
+        /** value 在 [min, min + extent] 間量化成 unorm16 */
+        static std::uint16_t quantizeUnorm16(float value, float min, float extent);
+        static float dequantizeUnorm16(std::uint16_t quantized, float min, float extent);
+
+        static std::uint8_t floatToUnorm8(float value);
+        static float unorm8ToFloat(std::uint8_t value) { return static_cast<float>(value) / 255.0f; }
+    };
+}
+
+#endif // VERTEX_ATTRIBUTE_CODEC_H
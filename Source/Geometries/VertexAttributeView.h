@@ -0,0 +1,163 @@
+﻿/*********************************************************************
+ * \file   VertexAttributeView.h
+ * \brief  typed strided view over interleaved vertex memory, 不複製資料
+ *         T 是 const type 時為 read-only view;
+ *         vertex memory 是 byte array, 元素都用 memcpy 讀寫, 不轉成 T* (strict aliasing)
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef VERTEX_ATTRIBUTE_VIEW_H
+#define VERTEX_ATTRIBUTE_VIEW_H
+
+#include <type_traits>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+namespace Enigma::Geometries
+{
+    template <class T> class VertexAttributeView
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "vertex attribute must be trivially copyable");
+    public:
+        using byte_type = std::conditional_t<std::is_const_v<T>, const unsigned char, unsigned char>;
+        using value_type = std::remove_const_t<T>;
+
+        /** mutable view 的元素, 讀出是複本, 寫入時 memcpy 回 vertex memory 並遞增 revision */
+        class element_reference
+        {
+        public:
+            element_reference(unsigned char* ptr, std::uint64_t* write_revision) : m_ptr(ptr), m_writeRevision(write_revision) {}
+            element_reference(const element_reference&) = default;
+
+            operator value_type() const { return load(m_ptr); }
+            element_reference& operator=(const value_type& value)
+            {
+                std::memcpy(m_ptr, &value, sizeof(value_type));
+                if (m_writeRevision) (*m_writeRevision)++;
+                return *this;
+            }
+            element_reference& operator=(const element_reference& other) { return *this = static_cast<value_type>(other); }
+
+        private:
+            unsigned char* m_ptr;
+            std::uint64_t* m_writeRevision;
+        };
+        using reference = std::conditional_t<std::is_const_v<T>, value_type, element_reference>;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::remove_const_t<T>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = VertexAttributeView::reference;
+
+            iterator() : m_ptr(nullptr), m_stride(0), m_writeRevision(nullptr) {}
+            iterator(byte_type* ptr, size_t stride, std::uint64_t* write_revision) : m_ptr(ptr), m_stride(stride), m_writeRevision(write_revision) {}
+
+            reference operator*() const { return makeReference(m_ptr, m_writeRevision); }
+            reference operator[](difference_type n) const { return makeReference(m_ptr + n * static_cast<difference_type>(m_stride), m_writeRevision); }
+            iterator& operator++() { m_ptr += m_stride; return *this; }
+            iterator operator++(int) { iterator it = *this; m_ptr += m_stride; return it; }
+            iterator& operator--() { m_ptr -= m_stride; return *this; }
+            iterator operator--(int) { iterator it = *this; m_ptr -= m_stride; return it; }
+            iterator& operator+=(difference_type n) { m_ptr += n * static_cast<difference_type>(m_stride); return *this; }
+            iterator& operator-=(difference_type n) { m_ptr -= n * static_cast<difference_type>(m_stride); return *this; }
+            iterator operator+(difference_type n) const { iterator it = *this; return it += n; }
+            iterator operator-(difference_type n) const { iterator it = *this; return it -= n; }
+            friend iterator operator+(difference_type n, const iterator& it) { return it + n; }
+            difference_type operator-(const iterator& other) const
+            {
+                return m_stride ? (m_ptr - other.m_ptr) / static_cast<difference_type>(m_stride) : 0;
+            }
+            bool operator==(const iterator& other) const { return m_ptr == other.m_ptr; }
+            bool operator!=(const iterator& other) const { return m_ptr != other.m_ptr; }
+            bool operator<(const iterator& other) const { return m_ptr < other.m_ptr; }
+            bool operator>(const iterator& other) const { return m_ptr > other.m_ptr; }
+            bool operator<=(const iterator& other) const { return m_ptr <= other.m_ptr; }
+            bool operator>=(const iterator& other) const { return m_ptr >= other.m_ptr; }
+
+        private:
+            byte_type* m_ptr;
+            size_t m_stride;
+            std::uint64_t* m_writeRevision;
+        };
+
+    public:
+        VertexAttributeView() : m_base(nullptr), m_stride(0), m_count(0), m_writeRevision(nullptr) {}
+        /** @param base : first element address, @param stride : in bytes (vertex size)
+            @param write_revision : 每次寫入元素時遞增, 可以是 nullptr */
+        VertexAttributeView(byte_type* base, size_t stride, unsigned count, std::uint64_t* write_revision = nullptr)
+            : m_base(base), m_stride(stride), m_count(count), m_writeRevision(write_revision) {}
+
+        /** mutable view 可以轉成 read-only view */
+        operator VertexAttributeView<const T>() const { return VertexAttributeView<const T>(m_base, m_stride, m_count); }
+
+        reference operator[](unsigned index) const
+        {
+            assert(index < m_count);
+            return makeReference(m_base + index * m_stride, m_writeRevision);
+        }
+        value_type get(unsigned index) const
+        {
+            assert(index < m_count);
+            return load(m_base + index * m_stride);
+        }
+        template <class U = T, std::enable_if_t<!std::is_const_v<U>, int> = 0>
+        void set(unsigned index, const value_type& value) const
+        {
+            assert(index < m_count);
+            std::memcpy(m_base + index * m_stride, &value, sizeof(value_type));
+            if (m_writeRevision) (*m_writeRevision)++;
+        }
+
+        iterator begin() const { return iterator(m_base, m_stride, m_writeRevision); }
+        iterator end() const { return iterator(m_base + m_count * m_stride, m_stride, m_writeRevision); }
+
+        bool empty() const { return m_count == 0; }
+        unsigned size() const { return m_count; }
+        /** byte distance between two elements, 給 SIMD kernel 用 */
+        size_t stride() const { return m_stride; }
+        /** 直接寫入這裡的 kernel 要自己遞增 revision (見 GeometryData 的 mutable view) */
+        byte_type* data() const { return m_base; }
+
+        /** sub range [offset, offset + count), 超出範圍的部分會被截掉 */
+        VertexAttributeView subView(unsigned offset, unsigned count) const
+        {
+            if (offset >= m_count) return VertexAttributeView();
+            if (count > m_count - offset) count = m_count - offset;
+            return VertexAttributeView(m_base + offset * m_stride, m_stride, count, m_writeRevision);
+        }
+
+    private:
+        static value_type load(const unsigned char* ptr)
+        {
+            value_type value;
+            std::memcpy(&value, ptr, sizeof(value_type));
+            return value;
+        }
+        static reference makeReference(byte_type* ptr, [[maybe_unused]] std::uint64_t* write_revision)
+        {
+            if constexpr (std::is_const_v<T>)
+            {
+                return load(ptr);
+            }
+            else
+            {
+                return element_reference(ptr, write_revision);
+            }
+        }
+
+    private:
+        byte_type* m_base;
+        size_t m_stride;
+        unsigned m_count;
+        std::uint64_t* m_writeRevision;
+    };
+}
+
+#endif // VERTEX_ATTRIBUTE_VIEW_H
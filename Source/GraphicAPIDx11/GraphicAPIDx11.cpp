@@ -339,10 +339,11 @@ error GraphicAPIDx11::CreateVertexBuffer(const std::string& buff_name, unsigned
     return ErrorCode::ok;
 }
 
-error GraphicAPIDx11::CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer)
+error GraphicAPIDx11::CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer, unsigned int vertex_count)
 {
     Platforms::Debug::Printf("create index buffer in thread %d\n", std::this_thread::get_id());
     Graphics::IIndexBufferPtr buff = Graphics::IIndexBufferPtr{ menew IndexBufferDx11{ buff_name } };
+    buff->setShortIndex(Graphics::IIndexBuffer::canUseShortIndex(vertex_count));
     buff->create(sizeBuffer);
     m_stash->Add(buff_name, buff);
 
@@ -522,7 +523,8 @@ error GraphicAPIDx11::BindIndexBuffer(const Graphics::IIndexBufferPtr& buffer)
     auto buffDx11 = std::dynamic_pointer_cast<IndexBufferDx11, Graphics::IIndexBuffer>(buffer);
     if (FATAL_LOG_EXPR(!buffDx11)) return ErrorCode::dynamicCastBuffer;
     if (FATAL_LOG_EXPR(!buffDx11->GetD3DBuffer())) return ErrorCode::nullIndexBuffer;
-    m_d3dDeviceContext->IASetIndexBuffer(buffDx11->GetD3DBuffer(), DXGI_FORMAT_R32_UINT, 0);
+    m_d3dDeviceContext->IASetIndexBuffer(buffDx11->GetD3DBuffer(),
+        buffDx11->IndexSize() == sizeof(std::uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
     m_boundIndexBuffer = buffer;
 
     return ErrorCode::ok;
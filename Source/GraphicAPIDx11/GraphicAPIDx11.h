@@ -70,7 +70,7 @@ namespace Enigma::Devices
         virtual error CreateVertexDeclaration(const std::string& name, const std::string& data_vertex_format,
             const Graphics::IVertexShaderPtr& shader) override;
         virtual error CreateVertexBuffer(const std::string& buff_name, unsigned int sizeofVertex, unsigned int sizeBuffer) override;
-        virtual error CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer) override;
+        virtual error CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer, unsigned int vertex_count) override;
         virtual error CreateSamplerState(const std::string& name, const Graphics::IDeviceSamplerState::SamplerStateData& data) override;
         virtual error CreateRasterizerState(const std::string& name, const Graphics::IDeviceRasterizerState::RasterizerStateData& data) override;
         virtual error CreateAlphaBlendState(const std::string& name, const Graphics::IDeviceAlphaBlendState::BlendStateData& data) override;
@@ -24,7 +24,7 @@ IndexBufferDx11::~IndexBufferDx11()
 error IndexBufferDx11::create(unsigned sizeBuffer)
 {
     assert(Graphics::IGraphicAPI::instance()->IsValidGraphicThread(std::this_thread::get_id()));
-    m_bufferSize = sizeBuffer;
+    m_bufferSize = m_isShortIndex ? sizeBuffer / 2 : sizeBuffer;
     assert(m_bufferSize > 0);
     GraphicAPIDx11* graphic = dynamic_cast<GraphicAPIDx11*>(Graphics::IGraphicAPI::instance());
     assert(graphic);
@@ -49,7 +49,7 @@ error IndexBufferDx11::UpdateBuffer(const uint_buffer& dataIndex)
 {
     assert(Graphics::IGraphicAPI::instance()->IsValidGraphicThread(std::this_thread::get_id()));
     assert(!dataIndex.empty());
-    unsigned int dataSize = static_cast<unsigned int>(dataIndex.size()) * sizeof(unsigned int);
+    unsigned int dataSize = static_cast<unsigned int>(dataIndex.size()) * IndexSize();
     if (FATAL_LOG_EXPR(dataSize > m_bufferSize))
     {
         Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferUpdateFailed>(m_name, ErrorCode::bufferSize));
@@ -65,7 +65,15 @@ error IndexBufferDx11::UpdateBuffer(const uint_buffer& dataIndex)
     }
 
     D3D11_BOX d3dBox = { 0, 0, 0, dataSize, 1, 1 };
-    graphic->GetD3DDeviceContext()->UpdateSubresource(m_d3dBuffer, 0, &d3dBox, &dataIndex[0], 0, 0);
+    if (m_isShortIndex)
+    {
+        auto narrowed = narrowIndices(dataIndex);
+        graphic->GetD3DDeviceContext()->UpdateSubresource(m_d3dBuffer, 0, &d3dBox, &narrowed[0], 0, 0);
+    }
+    else
+    {
+        graphic->GetD3DDeviceContext()->UpdateSubresource(m_d3dBuffer, 0, &d3dBox, &dataIndex[0], 0, 0);
+    }
 
     Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferResourceUpdated>(m_name));
     return ErrorCode::ok;
@@ -75,7 +83,7 @@ error IndexBufferDx11::RangedUpdateBuffer(const ranged_buffer& buffer)
 {
     assert(Graphics::IGraphicAPI::instance()->IsValidGraphicThread(std::this_thread::get_id()));
     assert(!buffer.data.empty());
-    unsigned int dataSize = static_cast<unsigned int>(buffer.data.size()) * sizeof(unsigned int);
+    unsigned int dataSize = static_cast<unsigned int>(buffer.data.size()) * IndexSize();
     if (FATAL_LOG_EXPR(dataSize > m_bufferSize))
     {
         Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferUpdateFailed>(m_name, ErrorCode::bufferSize));
@@ -90,15 +98,23 @@ error IndexBufferDx11::RangedUpdateBuffer(const ranged_buffer& buffer)
         return ErrorCode::d3dDeviceNullPointer;
     }
 
-    unsigned int byte_offset = buffer.idx_offset * sizeof(unsigned int);
-    unsigned int byte_length = buffer.idx_count * sizeof(unsigned int);
-    if (byte_length > static_cast<unsigned int>(buffer.data.size()) * sizeof(unsigned int))
+    unsigned int byte_offset = buffer.idx_offset * IndexSize();
+    unsigned int byte_length = buffer.idx_count * IndexSize();
+    if (byte_length > dataSize)
     {
-        byte_length = static_cast<unsigned int>(buffer.data.size()) * sizeof(unsigned int);
+        byte_length = dataSize;
     }
 
     D3D11_BOX d3dBox = { byte_offset, 0, 0, byte_offset + byte_length, 1, 1 };
-    graphic->GetD3DDeviceContext()->UpdateSubresource(m_d3dBuffer, 0, &d3dBox, &(buffer.data[0]), 0, 0);
+    if (m_isShortIndex)
+    {
+        auto narrowed = narrowIndices(buffer.data);
+        graphic->GetD3DDeviceContext()->UpdateSubresource(m_d3dBuffer, 0, &d3dBox, &narrowed[0], 0, 0);
+    }
+    else
+    {
+        graphic->GetD3DDeviceContext()->UpdateSubresource(m_d3dBuffer, 0, &d3dBox, &(buffer.data[0]), 0, 0);
+    }
 
     Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferResourceRangedUpdated>(
         m_name, buffer.idx_offset, buffer.idx_count));
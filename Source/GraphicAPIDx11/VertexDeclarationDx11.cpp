@@ -83,7 +83,9 @@ std::tuple<D3D11_INPUT_ELEMENT_DESC*, unsigned int> VertexDeclarationDx11::Creat
     if (vertex_desc.positionOffset() >= 0)
     {
         input_layout[element_idx].SemanticName = VertexDeclarationDx11::m_positionSemanticName.c_str();
-        input_layout[element_idx].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+        // quantized position : shader 要用 geometry 的量化範圍還原
+        input_layout[element_idx].Format = vertex_desc.positionFormat() == Graphics::VertexDescription::ElementFormat::Unorm16
+            ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
         input_layout[element_idx].InputSlot = 0;
         input_layout[element_idx].AlignedByteOffset = vertex_desc.positionOffset() * sizeof(float);
 
@@ -92,8 +94,11 @@ std::tuple<D3D11_INPUT_ELEMENT_DESC*, unsigned int> VertexDeclarationDx11::Creat
     if (vertex_desc.weightOffset() >= 0)
     {
         input_layout[element_idx].SemanticName = VertexDeclarationDx11::m_weightsSemanticName.c_str();
-        switch (vertex_desc.blendWeightCount())
+        switch (vertex_desc.blendWeightFormat() == Graphics::VertexDescription::ElementFormat::Unorm8 ? 0 : vertex_desc.blendWeightCount())
         {
+        case 0:
+            input_layout[element_idx].Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            break;
         case 1:
             input_layout[element_idx].Format = DXGI_FORMAT_R32_FLOAT;
             break;
@@ -126,7 +131,9 @@ std::tuple<D3D11_INPUT_ELEMENT_DESC*, unsigned int> VertexDeclarationDx11::Creat
     if (vertex_desc.normalOffset() >= 0)
     {
         input_layout[element_idx].SemanticName = VertexDeclarationDx11::m_normalSemanticName.c_str();
-        input_layout[element_idx].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+        // octahedral normal : shader 要自己解碼
+        input_layout[element_idx].Format = vertex_desc.normalFormat() == Graphics::VertexDescription::ElementFormat::OctSnorm16
+            ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
         input_layout[element_idx].InputSlot = 0;
         input_layout[element_idx].AlignedByteOffset = vertex_desc.normalOffset() * sizeof(float);
 
@@ -167,7 +174,11 @@ std::tuple<D3D11_INPUT_ELEMENT_DESC*, unsigned int> VertexDeclarationDx11::Creat
     if (vertex_desc.tangentOffset() >= 0)
     {
         input_layout[element_idx].SemanticName = VertexDeclarationDx11::m_tangentSemanticName.c_str();
-        if (vertex_desc.tangentDimension() == 3)
+        if (vertex_desc.tangentFormat() == Graphics::VertexDescription::ElementFormat::OctSnorm16)
+        {
+            input_layout[element_idx].Format = DXGI_FORMAT_R16G16_SNORM;
+        }
+        else if (vertex_desc.tangentDimension() == 3)
         {
             input_layout[element_idx].Format = DXGI_FORMAT_R32G32B32_FLOAT;
         }
@@ -195,7 +206,14 @@ std::tuple<D3D11_INPUT_ELEMENT_DESC*, unsigned int> VertexDeclarationDx11::Creat
         {
             input_layout[element_idx].SemanticName = VertexDeclarationDx11::m_texCoordSemanticName.c_str();
             input_layout[element_idx].SemanticIndex = ti;
-            switch (vertex_desc.textureCoordSize(ti))
+            if (vertex_desc.textureCoordFormat(ti) == Graphics::VertexDescription::ElementFormat::Half)
+            {
+                // 3 軸的 half 多讀一個補 0 的 pad
+                const int size = vertex_desc.textureCoordSize(ti);
+                input_layout[element_idx].Format = size == 1 ? DXGI_FORMAT_R16_FLOAT
+                    : size == 2 ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R16G16B16A16_FLOAT;
+            }
+            else switch (vertex_desc.textureCoordSize(ti))
             {
             case 1:
                 input_layout[element_idx].Format = DXGI_FORMAT_R32_FLOAT;
@@ -91,8 +91,10 @@ error GraphicAPIEgl::DrawPrimitive(unsigned vertexCount, unsigned vertexOffset)
 error GraphicAPIEgl::DrawIndexedPrimitive(unsigned indexCount, unsigned vertexCount, unsigned indexOffset, int baseVertexOffset)
 {
     // GLES 3.0 才有
+    const GLenum index_type = ((m_boundIndexBuffer) && (m_boundIndexBuffer->IndexSize() == sizeof(std::uint16_t)))
+        ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
     glDrawRangeElements(PrimitiveTopologyToGL(m_boundTopology), baseVertexOffset, baseVertexOffset + vertexCount - 1,
-        static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, nullptr);
+        static_cast<GLsizei>(indexCount), index_type, nullptr);
     return ErrorCode::ok;
 }
 
@@ -291,10 +293,11 @@ error GraphicAPIEgl::CreateVertexBuffer(const std::string& buff_name, unsigned i
     return ErrorCode::ok;
 }
 
-error GraphicAPIEgl::CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer)
+error GraphicAPIEgl::CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer, unsigned int vertex_count)
 {
     Debug::Printf("create index buffer in thread %d\n", std::this_thread::get_id());
     Graphics::IIndexBufferPtr buff = Graphics::IIndexBufferPtr{ menew IndexBufferEgl{ buff_name } };
+    buff->setShortIndex(Graphics::IIndexBuffer::canUseShortIndex(vertex_count));
     buff->create(sizeBuffer);
     m_stash->Add(buff_name, buff);
 
@@ -480,13 +483,13 @@ error GraphicAPIEgl::BindVertexDeclarationEgl(const std::shared_ptr<VertexDeclar
     for (unsigned int i = 0; i < num_elements; i++)
     {
         glEnableVertexAttribArray(i);
-        if (layouts[i].m_type == GL_FLOAT)
+        if (layouts[i].m_type == GL_UNSIGNED_INT)
         {
-            glVertexAttribPointer(i, layouts[i].m_size, layouts[i].m_type, GL_FALSE, vertex_size, reinterpret_cast<const GLvoid*>(layouts[i].m_position));
+            glVertexAttribIPointer(i, layouts[i].m_size, layouts[i].m_type, vertex_size, reinterpret_cast<const GLvoid*>(layouts[i].m_position));
         }
-        else if (layouts[i].m_type == GL_UNSIGNED_INT)
+        else
         {
-            glVertexAttribIPointer(i, layouts[i].m_size, layouts[i].m_type, vertex_size, reinterpret_cast<const GLvoid*>(layouts[i].m_position));
+            glVertexAttribPointer(i, layouts[i].m_size, layouts[i].m_type, layouts[i].m_normalized, vertex_size, reinterpret_cast<const GLvoid*>(layouts[i].m_position));
         }
     }
     return ErrorCode::ok;
@@ -25,7 +25,7 @@ IndexBufferEgl::~IndexBufferEgl()
 
 error IndexBufferEgl::create(unsigned sizeBuffer)
 {
-    m_bufferSize = sizeBuffer;
+    m_bufferSize = m_isShortIndex ? sizeBuffer / 2 : sizeBuffer;
     assert(m_bufferSize > 0);
     if (m_bufferHandle)
     {
@@ -50,7 +50,7 @@ error IndexBufferEgl::UpdateBuffer(const uint_buffer& dataIndex)
     assert(!dataIndex.empty());
     assert(m_bufferHandle != 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferHandle);
-    unsigned int dataSize = (unsigned int)dataIndex.size() * sizeof(unsigned int);
+    unsigned int dataSize = (unsigned int)dataIndex.size() * IndexSize();
     if (FATAL_LOG_EXPR(dataSize > m_bufferSize))
     {
         Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferUpdateFailed>(m_name, ErrorCode::bufferSize));
@@ -64,7 +64,14 @@ error IndexBufferEgl::UpdateBuffer(const uint_buffer& dataIndex)
         return ErrorCode::eglBufferMapping;
     }
 
-    memcpy(buff, &dataIndex[0], dataSize);
+    if (m_isShortIndex)
+    {
+        memcpy(buff, &narrowIndices(dataIndex)[0], dataSize);
+    }
+    else
+    {
+        memcpy(buff, &dataIndex[0], dataSize);
+    }
 
     glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -80,21 +87,28 @@ error IndexBufferEgl::RangedUpdateBuffer(const ranged_buffer& buffer)
     assert(!buffer.data.empty());
     assert(m_bufferHandle != 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferHandle);
-    unsigned int dataSize = (unsigned int)buffer.data.size() * sizeof(unsigned int);
+    unsigned int dataSize = (unsigned int)buffer.data.size() * IndexSize();
     if (FATAL_LOG_EXPR(dataSize > m_bufferSize))
     {
         Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferUpdateFailed>(m_name, ErrorCode::bufferSize));
         return ErrorCode::bufferSize;
     }
 
-    void* buff = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)(buffer.idx_offset * sizeof(unsigned int)), (GLsizeiptr)dataSize, GL_MAP_WRITE_BIT);
+    void* buff = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)(buffer.idx_offset * IndexSize()), (GLsizeiptr)dataSize, GL_MAP_WRITE_BIT);
     if (!buff)
     {
         Frameworks::EventPublisher::post(std::make_shared<Graphics::IndexBufferUpdateFailed>(m_name, ErrorCode::eglBufferMapping));
         return ErrorCode::eglBufferMapping;
     }
 
-    memcpy(buff, &buffer.data[0], dataSize);
+    if (m_isShortIndex)
+    {
+        memcpy(buff, &narrowIndices(buffer.data)[0], dataSize);
+    }
+    else
+    {
+        memcpy(buff, &buffer.data[0], dataSize);
+    }
 
     glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -40,15 +40,34 @@ void VertexDeclarationEgl::CreateVertexLayout(const Graphics::VertexDescription&
     if (vertex_desc.positionOffset() >= 0)
     {
         m_layouts[element_idx].m_position = static_cast<GLint>(vertex_desc.positionOffset() * sizeof(float));
-        m_layouts[element_idx].m_size = vertex_desc.positionDimension();
-        m_layouts[element_idx].m_type = GL_FLOAT;
+        if (vertex_desc.positionFormat() == Graphics::VertexDescription::ElementFormat::Unorm16)
+        {
+            // quantized position, w 讀到 1
+            m_layouts[element_idx].m_size = 4;
+            m_layouts[element_idx].m_type = GL_UNSIGNED_SHORT;
+            m_layouts[element_idx].m_normalized = GL_TRUE;
+        }
+        else
+        {
+            m_layouts[element_idx].m_size = vertex_desc.positionDimension();
+            m_layouts[element_idx].m_type = GL_FLOAT;
+        }
         element_idx++;
     }
     if (vertex_desc.weightOffset() >= 0)
     {
         m_layouts[element_idx].m_position = static_cast<GLint>(vertex_desc.weightOffset() * sizeof(float));
-        m_layouts[element_idx].m_size = vertex_desc.blendWeightCount();
-        m_layouts[element_idx].m_type = GL_FLOAT;
+        if (vertex_desc.blendWeightFormat() == Graphics::VertexDescription::ElementFormat::Unorm8)
+        {
+            m_layouts[element_idx].m_size = 4;
+            m_layouts[element_idx].m_type = GL_UNSIGNED_BYTE;
+            m_layouts[element_idx].m_normalized = GL_TRUE;
+        }
+        else
+        {
+            m_layouts[element_idx].m_size = vertex_desc.blendWeightCount();
+            m_layouts[element_idx].m_type = GL_FLOAT;
+        }
         element_idx++;
     }
     if (vertex_desc.paletteIndexOffset() >= 0)
@@ -61,8 +80,17 @@ void VertexDeclarationEgl::CreateVertexLayout(const Graphics::VertexDescription&
     if (vertex_desc.normalOffset() >= 0)
     {
         m_layouts[element_idx].m_position = static_cast<GLint>(vertex_desc.normalOffset() * sizeof(float));
-        m_layouts[element_idx].m_size = 3;
-        m_layouts[element_idx].m_type = GL_FLOAT;
+        if (vertex_desc.normalFormat() == Graphics::VertexDescription::ElementFormat::OctSnorm16)
+        {
+            m_layouts[element_idx].m_size = 2;
+            m_layouts[element_idx].m_type = GL_SHORT;
+            m_layouts[element_idx].m_normalized = GL_TRUE;
+        }
+        else
+        {
+            m_layouts[element_idx].m_size = 3;
+            m_layouts[element_idx].m_type = GL_FLOAT;
+        }
         element_idx++;
     }
     if (vertex_desc.diffuseColorOffset() >= 0)
@@ -98,8 +126,17 @@ void VertexDeclarationEgl::CreateVertexLayout(const Graphics::VertexDescription&
     if (vertex_desc.tangentOffset() >= 0)
     {
         m_layouts[element_idx].m_position = static_cast<GLint>(vertex_desc.tangentOffset() * sizeof(float));
-        m_layouts[element_idx].m_size = vertex_desc.tangentDimension();
-        m_layouts[element_idx].m_type = GL_FLOAT;
+        if (vertex_desc.tangentFormat() == Graphics::VertexDescription::ElementFormat::OctSnorm16)
+        {
+            m_layouts[element_idx].m_size = 2;
+            m_layouts[element_idx].m_type = GL_SHORT;
+            m_layouts[element_idx].m_normalized = GL_TRUE;
+        }
+        else
+        {
+            m_layouts[element_idx].m_size = vertex_desc.tangentDimension();
+            m_layouts[element_idx].m_type = GL_FLOAT;
+        }
         element_idx++;
     }
     if (vertex_desc.binormalOffset() >= 0)
@@ -115,7 +152,8 @@ void VertexDeclarationEgl::CreateVertexLayout(const Graphics::VertexDescription&
         {
             m_layouts[element_idx].m_position = static_cast<GLint>(vertex_desc.textureCoordOffset(ti) * sizeof(float));
             m_layouts[element_idx].m_size = vertex_desc.textureCoordSize(ti);
-            m_layouts[element_idx].m_type = GL_FLOAT;
+            m_layouts[element_idx].m_type = vertex_desc.textureCoordFormat(ti) == Graphics::VertexDescription::ElementFormat::Half
+                ? GL_HALF_FLOAT : GL_FLOAT;
             element_idx++;
         }
         else break;
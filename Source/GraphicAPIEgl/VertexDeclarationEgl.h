@@ -27,6 +27,7 @@ namespace Enigma::Devices
             GLint m_size;
             GLenum m_type;
             GLint m_position;
+            GLboolean m_normalized;  ///< 整數型別 (壓縮格式) 是否正規化成 [0,1] / [-1,1]
         };
     public:
         VertexDeclarationEgl(const std::string& name, const std::string& data_vertex_format);
@@ -242,13 +242,17 @@ namespace Enigma::Graphics
     class CreateIndexBuffer : public Frameworks::ICommand
     {
     public:
-        CreateIndexBuffer(const std::string& name, unsigned int sizeBuffer)
-            : m_name(name), m_sizeBuffer(sizeBuffer) {};
+        /** @param sizeBuffer : 32 bits index 的 byte size
+            @param vertexCount : index 參照的 vertex 數, < 65536 時 device 用 16 bits index, 0 : unknown */
+        CreateIndexBuffer(const std::string& name, unsigned int sizeBuffer, unsigned int vertexCount = 0)
+            : m_name(name), m_sizeBuffer(sizeBuffer), m_vertexCount(vertexCount) {};
         const std::string& getName() const { return m_name; }
         unsigned int GetSizeBuffer() const { return m_sizeBuffer; }
+        unsigned int GetVertexCount() const { return m_vertexCount; }
     private:
         std::string m_name;
         unsigned int m_sizeBuffer;
+        unsigned int m_vertexCount;
     };
     /** create device states */
     class CreateSamplerState : public Frameworks::ICommand
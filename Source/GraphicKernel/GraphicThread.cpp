@@ -1,5 +1,6 @@
 ﻿#include "GraphicThread.h"
 #include "Platforms/PlatformLayer.h"
+#include "Platforms/Profiler.h"
 #include <thread>
 #include <cassert>
 
@@ -53,6 +54,7 @@ void GraphicThread::Terminate()
 void GraphicThread::ThreadProcedure()
 {
     if (!m_self) return;
+    PROFILE_THREAD_NAME("GraphicThread");
     while (!m_isExisting)
     {
         // 每次執行一個 task的效率差不多
@@ -63,6 +65,7 @@ void GraphicThread::ThreadProcedure()
             t = std::move(m_self->m_tasks.front());
             m_self->m_tasks.pop_front();
         }
+        PROFILE_ZONE("GraphicThread::task");
         t();*/
         bool is_task_empty;
         {
@@ -586,11 +586,11 @@ void IGraphicAPI::DoCreatingIndexBuffer(const Frameworks::ICommandPtr& c)
     if (!cmd) return;
     if (UseAsync())
     {
-        AsyncCreateIndexBuffer(cmd->getName(), cmd->GetSizeBuffer());
+        AsyncCreateIndexBuffer(cmd->getName(), cmd->GetSizeBuffer(), cmd->GetVertexCount());
     }
     else
     {
-        CreateIndexBuffer(cmd->getName(), cmd->GetSizeBuffer());
+        CreateIndexBuffer(cmd->getName(), cmd->GetSizeBuffer(), cmd->GetVertexCount());
     }
 }
 
@@ -843,9 +843,9 @@ future_error IGraphicAPI::AsyncCreateVertexBuffer(const std::string& buff_name,
     return m_workerThread->PushTask([=]() -> error { return this->CreateVertexBuffer(buff_name, sizeofVertex, sizeBuffer); });
 }
 
-future_error IGraphicAPI::AsyncCreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer)
+future_error IGraphicAPI::AsyncCreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer, unsigned int vertex_count)
 {
-    return m_workerThread->PushTask([=]() -> error { return this->CreateIndexBuffer(buff_name, sizeBuffer); });
+    return m_workerThread->PushTask([=]() -> error { return this->CreateIndexBuffer(buff_name, sizeBuffer, vertex_count); });
 }
 
 future_error IGraphicAPI::AsyncCreateSamplerState(const std::string& name, const IDeviceSamplerState::SamplerStateData& data)
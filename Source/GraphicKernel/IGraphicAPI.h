@@ -272,8 +272,9 @@ namespace Enigma::Graphics
         virtual error CreateVertexBuffer(const std::string& buff_name, unsigned int sizeofVertex, unsigned int sizeBuffer) = 0;
         virtual future_error AsyncCreateVertexBuffer(const std::string& buff_name, unsigned int sizeofVertex, unsigned int sizeBuffer);
         /** create index buffer */
-        virtual error CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer) = 0;
-        virtual future_error AsyncCreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer);
+        /** vertex_count < 65536 : 16 bits index buffer, 0 : unknown (32 bits) */
+        virtual error CreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer, unsigned int vertex_count) = 0;
+        virtual future_error AsyncCreateIndexBuffer(const std::string& buff_name, unsigned int sizeBuffer, unsigned int vertex_count);
         //@}
 
         /** @name Device States */
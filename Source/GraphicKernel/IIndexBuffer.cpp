@@ -8,12 +8,23 @@ IIndexBuffer::IIndexBuffer(const std::string& name)
 {
     m_name = name;
     m_bufferSize = 0;
+    m_isShortIndex = false;
 }
 
 IIndexBuffer::~IIndexBuffer()
 {
 }
 
+std::vector<std::uint16_t> IIndexBuffer::narrowIndices(const uint_buffer& indices)
+{
+    std::vector<std::uint16_t> narrowed(indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        narrowed[i] = static_cast<std::uint16_t>(indices[i]);
+    }
+    return narrowed;
+}
+
 void IIndexBuffer::update(const uint_buffer& dataIndex)
 {
     if (IGraphicAPI::instance()->UseAsync())
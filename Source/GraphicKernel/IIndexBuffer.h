@@ -10,6 +10,8 @@
 
 #include "Frameworks/ExtentTypesDefine.h"
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 namespace Enigma::Graphics
 {
@@ -34,22 +36,32 @@ namespace Enigma::Graphics
 
         const std::string& getName() { return m_name; }
 
+        /** @param sizeBuffer : 32 bits index 的 byte size, short index 時 device buffer 只有一半 */
         virtual error create(unsigned int sizeBuffer) = 0;
         void update(const uint_buffer& dataIndex);
         void RangedUpdate(const ranged_buffer& buffer);
 
         // Buffer size
         virtual unsigned int BufferSize() { return m_bufferSize; };
-        virtual int IndexSize() { return sizeof(unsigned int); };
-        virtual unsigned int IndexCount() { return m_bufferSize / sizeof(unsigned int); };
+        virtual int IndexSize() { return m_isShortIndex ? sizeof(std::uint16_t) : sizeof(unsigned int); };
+        virtual unsigned int IndexCount() { return m_bufferSize / IndexSize(); };
+
+        /** device 上存成 16 bits index, 要在 create 之前設定; update 時仍然給 32 bits index */
+        void setShortIndex(bool is_short) { m_isShortIndex = is_short; }
+        bool isShortIndex() const { return m_isShortIndex; }
+        /** 0xffff 保留給 primitive restart, 最大 index 是 vertex_count - 1 */
+        static bool canUseShortIndex(unsigned int vertex_count) { return (vertex_count > 0) && (vertex_count <= 0xffff); }
 
     protected:
+        static std::vector<std::uint16_t> narrowIndices(const uint_buffer& indices);
+
         virtual error UpdateBuffer(const uint_buffer& dataIndex) = 0;
         virtual error RangedUpdateBuffer(const ranged_buffer& buffer) = 0;
 
     protected:
         std::string m_name;
         unsigned int m_bufferSize;
+        bool m_isShortIndex;
     };
     using IIndexBufferPtr = std::shared_ptr<IIndexBuffer>;
     using IIndexBufferWeak = std::weak_ptr<IIndexBuffer>;
@@ -33,6 +33,20 @@ void ITexture::create(const MathLib::Dimension<unsigned>& dimension, const byte_
     }
 }
 
+void ITexture::create(const MathLib::Dimension<unsigned>& dimension, byte_buffer&& buff)
+{
+    if (IGraphicAPI::instance()->UseAsync())
+    {
+        IGraphicAPI::instance()->GetGraphicThread()->
+            PushTask([lifetime = shared_from_this(), dimension, buff = std::move(buff), this]()
+                -> error { return createFromSystemMemory(dimension, buff); });
+    }
+    else
+    {
+        createFromSystemMemory(dimension, buff);
+    }
+}
+
 void ITexture::load(const byte_buffer& img_buff)
 {
     if (IGraphicAPI::instance()->UseAsync())
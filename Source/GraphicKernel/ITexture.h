@@ -50,6 +50,8 @@ namespace Enigma::Graphics
         virtual void save(const std::string& filename, const std::string& pathid);
 
         virtual void create(const MathLib::Dimension<unsigned>& dimension, const byte_buffer& buff);
+        /** buffer 直接 move 給 graphic thread, 不複製整張 image */
+        virtual void create(const MathLib::Dimension<unsigned>& dimension, byte_buffer&& buff);
 
         virtual void retrieve(const MathLib::Rect& rcSrc);
         virtual void update(const MathLib::Rect& rcDest, const byte_buffer& img_buff);
@@ -2,6 +2,7 @@
 #include "Frameworks/TokenVector.h"
 #include "Frameworks/StringFormat.h"
 #include <cassert>
+#include <cstring>
 
 using namespace Enigma::Graphics;
 
@@ -90,11 +91,15 @@ VertexDescription VertexFormatCode::calculateVertexSize()
     int offset = 0;
     int num_elements = 0;
     unsigned int pos_mask = m_fvfCode & POSITION_MASK;
+    // quantized position : 3 x unorm16 + pad, 佔 2 個 float 的空間
+    const bool is_quantized_pos = (m_fvfCode & QUANTIZED_POSITION) && (pos_mask != XYZRHW) && (pos_mask != XYZW);
+    const int pos_slots = is_quantized_pos ? 2 : 3;
+    if (is_quantized_pos) desc.m_positionFormat = VertexDescription::ElementFormat::Unorm16;
     switch (pos_mask)
     {
     case XYZ:
-        size += (3 * sizeof(float));
-        offset += 3;
+        size += (pos_slots * sizeof(float));
+        offset += pos_slots;
         desc.m_posVecDimension = 3;
         num_elements++;
         break;
@@ -111,92 +116,42 @@ VertexDescription VertexFormatCode::calculateVertexSize()
         num_elements++;
         break;
     case XYZB1:
-        size += (4 * sizeof(float));
-        offset += 4;
-        desc.m_posVecDimension = 3;
-        if (m_fvfCode & LASTBETA_UBYTE4)
-        {
-            desc.m_paletteIndexOffset = 3;
-        }
-        else
-        {
-            desc.m_weightOffset = 3;
-            desc.m_blendWeightCount = 1;
-        }
-        num_elements += 2;  // pos, (weight or index)
-        break;
     case XYZB2:
-        size += (5 * sizeof(float));
-        offset += 5;
-        desc.m_posVecDimension = 3;
-        desc.m_weightOffset = 3;
-        if (m_fvfCode & LASTBETA_UBYTE4)
-        {
-            desc.m_paletteIndexOffset = 4;
-            desc.m_blendWeightCount = 1;
-            num_elements += 3;  // pos, weight, index
-        }
-        else
-        {
-            desc.m_blendWeightCount = 2;
-            num_elements += 2;  // pos, weight
-        }
-        //num_elements += 3;
-        break;
     case XYZB3:
-        size += (6 * sizeof(float));
-        offset += 6;
-        desc.m_posVecDimension = 3;
-        desc.m_weightOffset = 3;
-        if (m_fvfCode & LASTBETA_UBYTE4)
-        {
-            desc.m_paletteIndexOffset = 5;
-            desc.m_blendWeightCount = 2;
-            num_elements += 3;
-        }
-        else
-        {
-            desc.m_blendWeightCount = 3;
-            num_elements += 2;
-        }
-        //num_elements += 4;
-        break;
     case XYZB4:
-        size += (7 * sizeof(float));
-        offset += 7;
-        desc.m_posVecDimension = 3;
-        desc.m_weightOffset = 3;
-        if (m_fvfCode & LASTBETA_UBYTE4)
-        {
-            desc.m_paletteIndexOffset = 6;
-            desc.m_blendWeightCount = 3;
-            num_elements += 3;
-        }
-        else
-        {
-            desc.m_blendWeightCount = 4;
-            num_elements += 2;
-        }
-        //num_elements += 5;
-        break;
     case XYZB5:
-        size += (8 * sizeof(float));
-        offset += 8;
+    {
+        // XYZBn : n 個 beta, 有 LASTBETA_UBYTE4 時最後一個 beta 是 palette index
+        const int beta_count = static_cast<int>(pos_mask - XYZB1) + 1;
+        const bool has_palette = (m_fvfCode & LASTBETA_UBYTE4) != 0;
+        const int weight_count = has_palette ? beta_count - 1 : beta_count;
         desc.m_posVecDimension = 3;
-        desc.m_weightOffset = 3;
-        if (m_fvfCode & LASTBETA_UBYTE4)
+        size += (pos_slots * sizeof(float));
+        offset += pos_slots;
+        num_elements++;
+        if (weight_count > 0)
         {
-            desc.m_paletteIndexOffset = 7;
-            desc.m_blendWeightCount = 4;
-            num_elements += 3;
+            int weight_slots = weight_count;
+            if ((m_fvfCode & UNORM8_WEIGHT) && (weight_count <= 4))
+            {
+                weight_slots = 1;
+                desc.m_weightFormat = VertexDescription::ElementFormat::Unorm8;
+            }
+            desc.m_weightOffset = offset;
+            desc.m_blendWeightCount = weight_count;
+            size += (weight_slots * sizeof(float));
+            offset += weight_slots;
+            num_elements++;
         }
-        else
+        if (has_palette)
         {
-            desc.m_blendWeightCount = 5;
-            num_elements += 2;
+            desc.m_paletteIndexOffset = offset;
+            size += sizeof(unsigned int);
+            offset += 1;
+            num_elements++;
         }
-        //num_elements += 6;
         break;
+    }
     default:
         break;
     }
@@ -204,8 +159,17 @@ VertexDescription VertexFormatCode::calculateVertexSize()
     if (m_fvfCode & NORMAL)
     {
         desc.m_normalOffset = offset;
-        size += (3 * sizeof(float));
-        offset += 3;
+        if (m_fvfCode & OCT_NORMAL)
+        {
+            desc.m_normalFormat = VertexDescription::ElementFormat::OctSnorm16;
+            size += sizeof(float);
+            offset += 1;
+        }
+        else
+        {
+            size += (3 * sizeof(float));
+            offset += 3;
+        }
         num_elements++;
     }
     /*if (m_fvfCode & PSIZE)
@@ -249,12 +213,15 @@ VertexDescription VertexFormatCode::calculateVertexSize()
     // texture coord. size
     if (m_texCount > 0)
     {
+        if (m_fvfCode & HALF_TEXCOORD) desc.m_texCoordFormat = VertexDescription::ElementFormat::Half;
         for (unsigned int stage = 0; stage < m_texCount; stage++)
         {
             desc.m_texCoordOffset[stage] = offset;
             desc.m_texCoordSize[stage] = m_texCoordSize[stage];
-            size += static_cast<int>(m_texCoordSize[stage] * sizeof(float));
-            offset += m_texCoordSize[stage];
+            // half float : 兩個軸佔一個 float 的空間
+            const int coord_slots = (m_fvfCode & HALF_TEXCOORD) ? (m_texCoordSize[stage] + 1) / 2 : m_texCoordSize[stage];
+            size += static_cast<int>(coord_slots * sizeof(float));
+            offset += coord_slots;
             if (m_texCoordSize[stage] > 0) num_elements++;
         }
     }
@@ -270,6 +237,15 @@ VertexDescription VertexFormatCode::calculateVertexSize()
             offset += 3;
             num_elements++;
         }
+        else if (m_fvfCode & OCT_TANGENT)
+        {
+            desc.m_tangentOffset = offset;
+            desc.m_tangentDimension = 4;
+            desc.m_tangentFormat = VertexDescription::ElementFormat::OctSnorm16;
+            size += sizeof(float);
+            offset += 1;
+            num_elements++;
+        }
         else
         {
             desc.m_tangentOffset = offset;
@@ -336,6 +312,10 @@ void VertexFormatCode::FromString(const std::string& fvf_string)
         {
             m_fvfCode |= NORMAL;
         }
+        else if (token == "octnor")
+        {
+            m_fvfCode |= NORMAL | OCT_NORMAL;
+        }
         else if (token == "psize")
         {
             m_fvfCode |= PSIZE;
@@ -360,6 +340,10 @@ void VertexFormatCode::FromString(const std::string& fvf_string)
         {
             m_fvfCode |= TANGENT;
         }
+        else if (token == "octtangent")
+        {
+            m_fvfCode |= TANGENT | OCT_TANGENT;
+        }
         else if (token == "binormal")
         {
             m_fvfCode |= BINORMAL;
@@ -372,6 +356,18 @@ void VertexFormatCode::FromString(const std::string& fvf_string)
         {
             m_fvfCode |= LASTBETA_COLOR;
         }
+        else if (token == "htex")
+        {
+            m_fvfCode |= HALF_TEXCOORD;
+        }
+        else if (token == "u8weight")
+        {
+            m_fvfCode |= UNORM8_WEIGHT;
+        }
+        else if (token == "qpos")
+        {
+            m_fvfCode |= QUANTIZED_POSITION;
+        }
         else
         {
             std::size_t pos = token.find_first_of("tex");
@@ -440,16 +436,19 @@ std::string VertexFormatCode::ToString() const
     default: assert("invalid position mask" == 0); // C1430
     }
 
-    if (m_fvfCode & NORMAL) ret += "_nor";
+    if (m_fvfCode & NORMAL) ret += (m_fvfCode & OCT_NORMAL) ? "_octnor" : "_nor";
     if (m_fvfCode & PSIZE) ret += "_psize";
     if (m_fvfCode & DIFFUSE) ret += "_diffuse";
     if (m_fvfCode & SPECULAR) ret += "_specular";
     if (m_fvfCode & F_DIFFUSE) ret += "_fdiffuse";
     if (m_fvfCode & F_SPECULAR) ret += "_fspecular";
-    if (m_fvfCode & TANGENT) ret += "_tangent";
+    if (m_fvfCode & TANGENT) ret += (m_fvfCode & OCT_TANGENT) ? "_octtangent" : "_tangent";
     if (m_fvfCode & BINORMAL) ret += "_binormal";
     if (m_fvfCode & LASTBETA_UBYTE4) ret += "_betabyte";
     if (m_fvfCode & LASTBETA_COLOR) ret += "_betacolor";
+    if (m_fvfCode & HALF_TEXCOORD) ret += "_htex";
+    if (m_fvfCode & UNORM8_WEIGHT) ret += "_u8weight";
+    if (m_fvfCode & QUANTIZED_POSITION) ret += "_qpos";
 
     if (m_texCount)
     {
@@ -500,6 +499,15 @@ void VertexDescription::initialize()
     m_texCoordSize[5] = 0;
     m_texCoordSize[6] = 0;
     m_texCoordSize[7] = 0;
+    m_posVecDimension = 0;
+    m_colorDimension = 0;
+    m_specularDimension = 0;
+    m_tangentDimension = 0;
+    m_positionFormat = ElementFormat::Float;
+    m_weightFormat = ElementFormat::Float;
+    m_normalFormat = ElementFormat::Float;
+    m_tangentFormat = ElementFormat::Float;
+    m_texCoordFormat = ElementFormat::Float;
 }
 
 int VertexDescription::weightOffset(unsigned weight_idx) const
@@ -546,3 +554,16 @@ bool VertexDescription::hasTextureCoord(unsigned stage, unsigned dimension) cons
     assert((dimension > 0) && (dimension <= 3));
     return (m_texCoordOffset[stage] >= 0) && (m_texCoordSize[stage] == static_cast<int>(dimension));
 }
+
+VertexDescription::ElementFormat VertexDescription::textureCoordFormat(unsigned stage) const
+{
+    assert(stage < VertexFormatCode::MAX_TEX_COORD);
+    return m_texCoordFormat;
+}
+
+bool VertexDescription::isCompressed() const
+{
+    return (m_positionFormat != ElementFormat::Float) || (m_weightFormat != ElementFormat::Float)
+        || (m_normalFormat != ElementFormat::Float) || (m_tangentFormat != ElementFormat::Float)
+        || (m_texCoordFormat != ElementFormat::Float);
+}
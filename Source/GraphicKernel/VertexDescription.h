@@ -45,6 +45,15 @@ namespace Enigma::Graphics
             F_SPECULAR = 0x800,
             LASTBETA_UBYTE4 = 0x1000,
             LASTBETA_COLOR = 0x8000,
+
+            // compressed element formats
+            HALF_TEXCOORD = 0x10000,  ///< 所有貼圖軸存成 half float
+            OCT_NORMAL = 0x20000,  ///< normal 存成 octahedral 2 x snorm16
+            OCT_TANGENT = 0x40000,  ///< tangent (4D) 存成 octahedral 2 x snorm16, 符號放在 y 的最低位
+            UNORM8_WEIGHT = 0x80000,  ///< blend weights 存成 4 x unorm8, 最多 4 個 weight
+            QUANTIZED_POSITION = 0x100000,  ///< xyz 存成 3 x unorm16 (+ pad), 相對於 geometry bound
+
+            COMPRESSION_MASK = 0x1f0000,
         };
 
         unsigned int m_fvfCode;  /**< 一般性的fvf */
@@ -71,7 +80,11 @@ namespace Enigma::Graphics
         "fdiffuse","fspecular" : diffuse/specular color (4 float) \n
         "tangent", "binormal" : tangent/binormal vector; T/B同時存在: 3 float; 只有tangent : tangent 4 float \n
         "betabyte", "betacolor" : last beta ubyte/last beta color \n
-        "texn(x,x,x)" : n表示有多少層貼圖(1~8),後面()裡為每層貼圖的貼圖軸數量
+        "texn(x,x,x)" : n表示有多少層貼圖(1~8),後面()裡為每層貼圖的貼圖軸數量 \n
+        "htex" : half float 貼圖軸 \n
+        "octnor", "octtangent" : octahedral encoded normal/tangent (取代 "nor", "tangent") \n
+        "u8weight" : unorm8 blend weights \n
+        "qpos" : quantized position
         */
         void FromString(const std::string& fvf_string);
         /** Make String From Code */
@@ -87,6 +100,15 @@ namespace Enigma::Graphics
             UInt,
             Float
         };
+        /** element 在 vertex memory 中的存放格式 */
+        enum class ElementFormat
+        {
+            Float,
+            Half,
+            OctSnorm16,  ///< octahedral encoded unit vector, 2 x snorm16
+            Unorm16,
+            Unorm8,
+        };
     public:
         VertexDescription();
         ~VertexDescription() = default;
@@ -119,6 +141,14 @@ namespace Enigma::Graphics
         int specularColorDimension() const { return m_specularDimension; }
         int tangentDimension() const { return m_tangentDimension; }
 
+        ElementFormat positionFormat() const { return m_positionFormat; }
+        ElementFormat blendWeightFormat() const { return m_weightFormat; }
+        ElementFormat normalFormat() const { return m_normalFormat; }
+        ElementFormat tangentFormat() const { return m_tangentFormat; }
+        ElementFormat textureCoordFormat(unsigned stage) const;
+        /** 有任何 element 不是 float */
+        bool isCompressed() const;
+
         bool hasPosition3() const { return (positionOffset() >= 0) && (positionDimension() == 3); }
         bool hasPosition4() const { return (positionOffset() >= 0) && (positionDimension() == 4); }
         bool hasNormal() const { return normalOffset() >= 0; }
@@ -153,6 +183,12 @@ namespace Enigma::Graphics
         int m_specularDimension;  // 1: dword, 4: 4 float
         int m_tangentDimension; // 3 or 4
         int m_numElements;
+
+        ElementFormat m_positionFormat;
+        ElementFormat m_weightFormat;
+        ElementFormat m_normalFormat;
+        ElementFormat m_tangentFormat;
+        ElementFormat m_texCoordFormat;
     };
 }
 
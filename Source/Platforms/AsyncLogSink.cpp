@@ -0,0 +1,163 @@
+﻿#include "AsyncLogSink.h"
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+using namespace Enigma::Platforms;
+
+AsyncLogSink::AsyncLogSink(const std::string& filepath) : m_enqueuePos(0), m_dequeuePos(0), m_isStopping(false), m_isWriterWaiting(false),
+    m_writtenCount(0), m_droppedCount(0)
+{
+    static_assert((SlotCount & (SlotCount - 1)) == 0, "slot count must be power of 2");
+    m_slots = std::make_unique<Slot[]>(SlotCount);
+    for (unsigned i = 0; i < SlotCount; i++)
+    {
+        m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+    m_logFile.open(filepath.c_str(), std::fstream::out | std::fstream::trunc);
+    m_writer = std::thread([this]() { writerProcedure(); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    {
+        std::lock_guard locker{ m_wakeLock };
+        m_isStopping = true;
+    }
+    m_wakeWriter.notify_one();
+    if (m_writer.joinable()) m_writer.join();
+    drain();
+    if (m_logFile.is_open()) m_logFile.close();
+}
+
+bool AsyncLogSink::push(Logger::Level lv, std::string_view msg, const char* filename, int line)
+{
+    // bounded MPMC queue (Vyukov), slot sequence 決定誰可以寫
+    Slot* slot;
+    std::uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        slot = &m_slots[pos & (SlotCount - 1)];
+        const std::uint64_t seq = slot->m_sequence.load(std::memory_order_acquire);
+        const std::int64_t diff = static_cast<std::int64_t>(seq) - static_cast<std::int64_t>(pos);
+        if (diff == 0)
+        {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if (diff < 0)
+        {
+            m_droppedCount++;
+            return false;
+        }
+        else
+        {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->m_level = lv;
+    slot->m_filename = filename;
+    slot->m_line = line;
+    slot->m_length = static_cast<unsigned>(std::min<size_t>(msg.size(), MaxMessageLength));
+    char* message = slot->m_message;
+    if (slot->m_length > InlineMessageLength)
+    {
+        slot->m_longMessage = std::make_unique<char[]>(slot->m_length);
+        message = slot->m_longMessage.get();
+    }
+    memcpy(message, msg.data(), slot->m_length);
+    slot->m_sequence.store(pos + 1, std::memory_order_release);
+
+    // 與 writer 的 m_isWriterWaiting store / slot 檢查配對, 不會兩邊都看不到對方
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_isWriterWaiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard locker{ m_wakeLock };
+        m_wakeWriter.notify_one();
+    }
+    return true;
+}
+
+void AsyncLogSink::write(Logger::Level lv, std::string_view msg, const char* filename, int line)
+{
+    flush();
+    std::lock_guard locker{ m_fileLock };
+    writeRecord(lv, msg, filename, line);
+    if (m_logFile) m_logFile.flush();
+}
+
+void AsyncLogSink::flush()
+{
+    const std::uint64_t target = m_enqueuePos.load(std::memory_order_acquire);
+    std::unique_lock locker{ m_wakeLock };
+    m_drained.wait(locker, [this, target]()
+        { return (m_dequeuePos.load(std::memory_order_acquire) >= target) || (!m_writer.joinable()) || (m_isStopping); });
+}
+
+void AsyncLogSink::writerProcedure()
+{
+    while (true)
+    {
+        if (drain())
+        {
+            std::lock_guard locker{ m_wakeLock };
+            m_drained.notify_all();
+            continue;
+        }
+        std::unique_lock locker{ m_wakeLock };
+        if (m_isStopping) break;
+        m_isWriterWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_wakeWriter.wait(locker, [this]() { return (m_isStopping) || (isNextSlotReady()); });
+        m_isWriterWaiting.store(false, std::memory_order_relaxed);
+    }
+    std::lock_guard locker{ m_wakeLock };
+    m_drained.notify_all();
+}
+
+bool AsyncLogSink::isNextSlotReady() const
+{
+    const std::uint64_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    return m_slots[pos & (SlotCount - 1)].m_sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+bool AsyncLogSink::drain()
+{
+    std::lock_guard locker{ m_fileLock };
+    bool has_written = false;
+    std::uint64_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot& slot = m_slots[pos & (SlotCount - 1)];
+        if (slot.m_sequence.load(std::memory_order_acquire) != pos + 1) break;
+        const char* message = slot.m_longMessage ? slot.m_longMessage.get() : slot.m_message;
+        writeRecord(slot.m_level, std::string_view{ message, slot.m_length }, slot.m_filename, slot.m_line);
+        slot.m_longMessage.reset();
+        slot.m_sequence.store(pos + SlotCount, std::memory_order_release);
+        pos++;
+        m_dequeuePos.store(pos, std::memory_order_release);
+        has_written = true;
+    }
+    if ((has_written) && (m_logFile)) m_logFile.flush();
+    return has_written;
+}
+
+void AsyncLogSink::writeRecord(Logger::Level lv, std::string_view msg, const char* filename, int line)
+{
+    char text[MaxMessageLength + 256];
+    int written;
+    if (filename)
+    {
+        written = snprintf(text, sizeof(text), "[%s] %.*s @ %s(%d)\n", Logger::LevelToken(lv),
+            static_cast<int>(msg.size()), msg.data(), filename, line);
+    }
+    else
+    {
+        written = snprintf(text, sizeof(text), "[%s] %.*s\n", Logger::LevelToken(lv),
+            static_cast<int>(msg.size()), msg.data());
+    }
+    if (written < 0) return;
+    const size_t length = std::min<size_t>(static_cast<size_t>(written), sizeof(text) - 1);
+    if (m_logFile) m_logFile.write(text, static_cast<std::streamsize>(length));
+    Debug::Printf("%s", text);
+    m_writtenCount++;
+}
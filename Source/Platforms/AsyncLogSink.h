@@ -0,0 +1,88 @@
+﻿/*********************************************************************
+ * \file   AsyncLogSink.h
+ * \brief  log sink, 呼叫端只把 record 放進 lock-free ring buffer,
+ *         背景 writer thread 再格式化 & 寫檔
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _ASYNC_LOG_SINK_H
+#define _ASYNC_LOG_SINK_H
+
+#include "PlatformLayer.h"
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+
+namespace Enigma::Platforms
+{
+    class AsyncLogSink
+    {
+    public:
+        /// ring buffer slot 數, 必須是 2 的次方
+        static constexpr unsigned SlotCount = 1024;
+        /// slot 內直接存放的訊息長度, 更長的訊息另外配置
+        static constexpr unsigned InlineMessageLength = 240;
+        /// 超過的訊息會被截斷 (與 Logger::Printf 相同)
+        static constexpr unsigned MaxMessageLength = 2048;
+
+    public:
+        AsyncLogSink(const std::string& filepath);
+        AsyncLogSink(const AsyncLogSink&) = delete;
+        AsyncLogSink(AsyncLogSink&&) = delete;
+        ~AsyncLogSink();
+        AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+        AsyncLogSink& operator=(AsyncLogSink&&) = delete;
+
+        /** multi-producer, never blocks
+            @param filename : must be static string (e.g. __FILE__), only pointer is kept
+            @return false : ring buffer full, record dropped */
+        bool push(Logger::Level lv, std::string_view msg, const char* filename, int line);
+        /** 先等 queue 裡的 record 寫完, 再直接寫入並 flush 檔案, 給 error / fatal 用 (之後可能就 crash 了) */
+        void write(Logger::Level lv, std::string_view msg, const char* filename, int line);
+        /** wait until writer thread drains all pushed records */
+        void flush();
+
+        std::uint64_t writtenCount() const { return m_writtenCount; }
+        std::uint64_t droppedCount() const { return m_droppedCount; }
+
+    protected:
+        struct Slot
+        {
+            std::atomic<std::uint64_t> m_sequence;
+            Logger::Level m_level;
+            const char* m_filename;
+            int m_line;
+            unsigned m_length;
+            std::unique_ptr<char[]> m_longMessage;  ///< 超過 InlineMessageLength 才配置, writer 寫完就釋放
+            char m_message[InlineMessageLength];
+        };
+
+        void writerProcedure();
+        bool drain();
+        bool isNextSlotReady() const;
+        void writeRecord(Logger::Level lv, std::string_view msg, const char* filename, int line);
+
+    protected:
+        std::unique_ptr<Slot[]> m_slots;
+        alignas(64) std::atomic<std::uint64_t> m_enqueuePos;
+        alignas(64) std::atomic<std::uint64_t> m_dequeuePos;  ///< only writer thread moves it
+        std::atomic<bool> m_isStopping;
+        std::atomic<bool> m_isWriterWaiting;  ///< producer 只在 writer 睡著時才 lock & notify
+        std::atomic<std::uint64_t> m_writtenCount;
+        std::atomic<std::uint64_t> m_droppedCount;
+        std::mutex m_wakeLock;
+        std::condition_variable m_wakeWriter;
+        std::condition_variable m_drained;
+        std::mutex m_fileLock;  ///< writer thread 與同步寫入共用檔案
+        std::ofstream m_logFile;
+        std::thread m_writer;
+    };
+}
+
+#endif // _ASYNC_LOG_SINK_H
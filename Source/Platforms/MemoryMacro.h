@@ -56,7 +56,7 @@
 #endif
 #define meInitMemoryCheck() (0L)
 #endif
-#elif TARGET_PLATFORM == PLATFORM_ANDROID
+#else  // android & others
 #ifndef memalloc
 #define memalloc(T, count)  ((T*)(malloc(sizeof(T)*count)))
 #define memalloc_p(s, filename, line) malloc(s)
@@ -1,38 +1,53 @@
 ﻿#include "PlatformLayer.h"
+#include "AsyncLogSink.h"
+#include "MemoryMacro.h"
 #include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 
 using namespace Enigma::Platforms;
-std::ofstream Logger::m_logFile;
-std::string levelToken[]{ "Info", "Debug", "Warnning", "Error", "Fatal" };
+AsyncLogSink* Logger::m_sink = nullptr;
+const char* levelToken[]{ "Info", "Debug", "Warnning", "Error", "Fatal" };
 
 void Logger::InitLoggerFile(const std::string& filepath)
 {
-    if (m_logFile.is_open())
-    {
-        m_logFile.close();
-    }
-    m_logFile.open(filepath.c_str(), std::fstream::out | std::fstream::trunc);
+    CloseLoggerFile();
+    m_sink = menew AsyncLogSink(filepath);
+    // 沒有呼叫 CloseLoggerFile 就結束時, 也要寫完剩下的 log 並停掉 writer thread
+    static const bool s_isExitHandlerRegistered = (std::atexit(CloseLoggerFile) == 0);
+    (void)s_isExitHandlerRegistered;
 }
 
 void Logger::CloseLoggerFile()
 {
-    if (m_logFile) m_logFile.close();
+    SAFE_DELETE(m_sink);
+}
+
+void Logger::Flush()
+{
+    if (m_sink) m_sink->flush();
 }
 
-bool Logger::LogIf(bool cond, Level lv, const std::string& msg, const char* filename, int line)
+bool Logger::LogIf(bool cond, Level lv, std::string_view msg, const char* filename, int line)
 {
     if (cond) LogInline(lv, msg, filename, line);
     return cond;
 }
 
-void Logger::LogInline(Level lv, const std::string& msg, const char* filename, int line)
+bool Logger::LogExpr(Level lv, const char* expr, const char* filename, int line)
 {
-    OutputLog(Printf("[%s] %s @ %s(%d)\n", levelToken[(int)lv].c_str(), msg.c_str(), filename, line));
+    OutputLog(lv, expr, filename, line);
+    return true;
 }
 
-void Logger::Log(Level lv, const std::string& msg)
+void Logger::LogInline(Level lv, std::string_view msg, const char* filename, int line)
 {
-    OutputLog(Printf("[%s] %s\n", levelToken[(int)lv].c_str(), msg.c_str()));
+    OutputLog(lv, msg, filename, line);
+}
+
+void Logger::Log(Level lv, std::string_view msg)
+{
+    OutputLog(lv, msg, nullptr, 0);
 }
 
 std::string Logger::Printf(const char* fmt, ...)
@@ -40,19 +55,41 @@ std::string Logger::Printf(const char* fmt, ...)
     va_list argList;
     va_start(argList, fmt);
     const unsigned int MAX_CHARS = 2048;
-    static char s_buffer[MAX_CHARS];
-    int written = vsnprintf(s_buffer, MAX_CHARS, fmt, argList);
-    s_buffer[MAX_CHARS - 1] = '\0';
+    char buffer[MAX_CHARS];
+    int written = vsnprintf(buffer, MAX_CHARS, fmt, argList);
+    buffer[MAX_CHARS - 1] = '\0';
     va_end(argList);
     if (written < 0) return "Logger Printf Error!!\n";
-    return s_buffer;
+    return buffer;
+}
+
+const char* Logger::LevelToken(Level lv)
+{
+    return levelToken[static_cast<int>(lv)];
+}
+
+std::uint64_t Logger::DroppedLogCount()
+{
+    if (!m_sink) return 0;
+    return m_sink->droppedCount();
 }
 
-void Logger::OutputLog(const std::string& msg)
+void Logger::OutputLog(Level lv, std::string_view msg, const char* filename, int line)
 {
-    if (m_logFile)
+    if ((m_sink) && (lv >= Level::Error))
+    {
+        // error / fatal 之後常常就 crash 了, 直接寫入並 flush
+        m_sink->write(lv, msg, filename, line);
+        return;
+    }
+    if ((m_sink) && (m_sink->push(lv, msg, filename, line))) return;
+    // 沒有 sink 或 ring buffer 滿了, 只輸出到 debug console
+    if (filename)
+    {
+        Debug::Printf("[%s] %.*s @ %s(%d)\n", LevelToken(lv), static_cast<int>(msg.size()), msg.data(), filename, line);
+    }
+    else
     {
-        m_logFile.write(msg.c_str(), msg.length()).flush();
+        Debug::Printf("[%s] %.*s\n", LevelToken(lv), static_cast<int>(msg.size()), msg.data());
     }
-    Debug::Printf(msg.c_str());
 }
@@ -9,7 +9,20 @@
 #define _PLATFORM_LAYER_H
 
 #include <string>
+#include <string_view>
 #include <fstream>
+#include <cstdint>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_COLD __attribute__((cold, noinline))
+#define LOGGER_UNLIKELY(expr) __builtin_expect(static_cast<bool>(expr), 0)
+#elif defined(_MSC_VER)
+#define LOGGER_COLD __declspec(noinline)
+#define LOGGER_UNLIKELY(expr) static_cast<bool>(expr)
+#else
+#define LOGGER_COLD
+#define LOGGER_UNLIKELY(expr) static_cast<bool>(expr)
+#endif
 
 namespace Enigma::Platforms
 {
@@ -20,6 +33,8 @@ namespace Enigma::Platforms
         static int ErrorPrintf(const char* format, ...);
     };
 
+    class AsyncLogSink;
+
     class Logger
     {
     public:
@@ -32,27 +47,37 @@ namespace Enigma::Platforms
             Fatal
         };
     public:
+        /** log 改由背景 thread 寫入 file, error / fatal 同步寫入; 程式結束時會自動 close */
         static void InitLoggerFile(const std::string& filepath);
+        /** drain 剩下的 log, 停掉背景 thread */
         static void CloseLoggerFile();
-        static bool LogIf(bool cond, Level lv, const std::string& msg, const char* filename, int line);
-        static void LogInline(Level lv, const std::string& msg, const char* filename, int line);
-        static void Log(Level lv, const std::string& msg);
+        /** wait until all queued log records are written */
+        static void Flush();
+        static bool LogIf(bool cond, Level lv, std::string_view msg, const char* filename, int line);
+        /** cold path of FATAL_LOG_EXPR / LOG_IF, always return true */
+        LOGGER_COLD static bool LogExpr(Level lv, const char* expr, const char* filename, int line);
+        static void LogInline(Level lv, std::string_view msg, const char* filename, int line);
+        static void Log(Level lv, std::string_view msg);
         static std::string Printf(const char* fmt, ...);
+        static const char* LevelToken(Level lv);
+        /** ring buffer 滿了被丟掉的 log 數 */
+        static std::uint64_t DroppedLogCount();
     protected:
-        static void OutputLog(const std::string& msg);
+        static void OutputLog(Level lv, std::string_view msg, const char* filename, int line);
 
     protected:
-        static std::ofstream m_logFile;
+        static AsyncLogSink* m_sink;
     };
 }
 
 #ifdef DISABLE_FATAL_LOGGER
 #define FATAL_LOG_EXPR(expr) (expr)
 #else
-#define FATAL_LOG_EXPR(expr) Enigma::Platforms::Logger::LogIf((expr), Enigma::Platforms::Logger::Level::Fatal, #expr, __FILE__, __LINE__)
+// check 通過時只有一個 branch, 沒有 string 建構, 格式化都在 cold path
+#define FATAL_LOG_EXPR(expr) (LOGGER_UNLIKELY(expr) ? Enigma::Platforms::Logger::LogExpr(Enigma::Platforms::Logger::Level::Fatal, #expr, __FILE__, __LINE__) : false)
 #endif
 #define LOG_INLINE(lv, msg) Enigma::Platforms::Logger::LogInline(Enigma::Platforms::Logger::Level::lv, (msg), __FILE__, __LINE__)
 #define LOG(lv, msg) Enigma::Platforms::Logger::Log(Enigma::Platforms::Logger::Level::lv, (msg))
-#define LOG_IF(lv, expr) Enigma::Platforms::Logger::LogIf((expr), Enigma::Platforms::Logger::Level::lv, #expr, __FILE__, __LINE__)
+#define LOG_IF(lv, expr) (LOGGER_UNLIKELY(expr) ? Enigma::Platforms::Logger::LogExpr(Enigma::Platforms::Logger::Level::lv, #expr, __FILE__, __LINE__) : false)
 
 #endif // !_PLATFORM_LAYER_H
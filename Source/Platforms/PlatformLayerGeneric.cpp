@@ -0,0 +1,27 @@
+﻿#include "PlatformLayerUtilities.h"
+// 不是 win32 / android (例如 linux 上的 unit tests & benchmarks), 直接輸出到 stdout / stderr
+#if TARGET_PLATFORM == PLATFORM_UNKNOWN
+#include <cstdarg>
+#include <cstdio>
+
+namespace Enigma::Platforms
+{
+    int Debug::Printf(const char* format, ...)
+    {
+        va_list argList;
+        va_start(argList, format);
+        int nWritten = vfprintf(stdout, format, argList);
+        va_end(argList);
+        return nWritten;
+    }
+    int Debug::ErrorPrintf(const char* format, ...)
+    {
+        va_list argList;
+        va_start(argList, format);
+        int nWritten = vfprintf(stderr, format, argList);
+        va_end(argList);
+        return nWritten;
+    }
+}
+
+#endif
@@ -0,0 +1,326 @@
+﻿#include "Profiler.h"
+
+#if defined(ENIGMA_PROFILER_ENABLED)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+using namespace Enigma::Platforms;
+
+namespace
+{
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Profiler::Record[]> m_records;
+        std::atomic<unsigned> m_count{ 0 };
+        std::atomic<std::uint32_t> m_generation{ 0 };
+        std::atomic<std::uint64_t> m_droppedCount{ 0 };
+        std::atomic<const char*> m_threadName{ nullptr };
+        unsigned m_threadIndex = 0;
+    };
+
+    // 執行緒結束後 buffer 還要留給 export 用, list 本身也不釋放, 避免 static 解構順序問題
+    std::mutex& threadBufferLock()
+    {
+        static std::mutex* lock = new std::mutex;
+        return *lock;
+    }
+    std::vector<ThreadBuffer*>& threadBuffers()
+    {
+        static std::vector<ThreadBuffer*>* buffers = new std::vector<ThreadBuffer*>;
+        return *buffers;
+    }
+
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    thread_local std::uint64_t t_allocationCount = 0;
+    thread_local std::uint64_t t_allocationBytes = 0;
+
+    ThreadBuffer* currentThreadBuffer()
+    {
+        if (t_buffer) return t_buffer;
+        ThreadBuffer* buffer = new ThreadBuffer;
+        std::lock_guard locker{ threadBufferLock() };
+        buffer->m_threadIndex = static_cast<unsigned>(threadBuffers().size());
+        threadBuffers().emplace_back(buffer);
+        t_buffer = buffer;
+        return buffer;
+    }
+
+    void writeEscapedString(std::ostream& os, const char* str)
+    {
+        os << '"';
+        for (const char* c = str ? str : ""; *c; c++)
+        {
+            if ((*c == '"') || (*c == '\\'))
+            {
+                os << '\\' << *c;
+            }
+            else if (static_cast<unsigned char>(*c) < 0x20)
+            {
+                os << ' ';
+            }
+            else
+            {
+                os << *c;
+            }
+        }
+        os << '"';
+    }
+
+    std::string readableTypeName(const std::type_info& type)
+    {
+#if defined(__GNUG__)
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+        if ((status != 0) || (!demangled)) return type.name();
+        std::string name{ demangled };
+        std::free(demangled);
+        return name;
+#else
+        // msvc 的 name 已經可讀, 去掉前面的 "class " / "struct "
+        std::string name{ type.name() };
+        for (const char* prefix : { "class ", "struct " })
+        {
+            const std::string prefix_str{ prefix };
+            if (name.compare(0, prefix_str.size(), prefix_str) == 0) return name.substr(prefix_str.size());
+        }
+        return name;
+#endif
+    }
+
+    void* allocateCounted(std::size_t size) noexcept
+    {
+        t_allocationCount++;
+        t_allocationBytes += size;
+        return std::malloc(size ? size : 1);
+    }
+}
+
+std::atomic<bool> Profiler::m_isCapturing{ false };
+std::atomic<std::uint32_t> Profiler::m_captureGeneration{ 0 };
+std::atomic<std::uint64_t> Profiler::m_captureStartTime{ 0 };
+
+void Profiler::beginCapture()
+{
+    // generation 換了, 各執行緒下一次記錄時自己把 buffer 歸零
+    m_captureStartTime.store(now(), std::memory_order_relaxed);
+    m_captureGeneration.fetch_add(1, std::memory_order_acq_rel);
+    m_isCapturing.store(true, std::memory_order_release);
+}
+
+void Profiler::endCapture()
+{
+    m_isCapturing.store(false, std::memory_order_release);
+}
+
+void Profiler::markFrame()
+{
+    if (!isCapturing()) return;
+    record(RecordType::FrameMark, "Frame", now(), 0, 0, 0);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    currentThreadBuffer()->m_threadName.store(name, std::memory_order_release);
+}
+
+void Profiler::exportChromeTrace(std::ostream& os)
+{
+    const std::uint32_t generation = m_captureGeneration.load(std::memory_order_acquire);
+    const std::uint64_t capture_start = m_captureStartTime.load(std::memory_order_relaxed);
+    char number[64];
+    bool is_first = true;
+    auto begin_event = [&os, &is_first]()
+    {
+        os << (is_first ? "\n" : ",\n");
+        is_first = false;
+    };
+    os << "{\"traceEvents\":[";
+    std::lock_guard locker{ threadBufferLock() };
+    for (auto buffer : threadBuffers())
+    {
+        if (const char* thread_name = buffer->m_threadName.load(std::memory_order_acquire))
+        {
+            begin_event();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_threadIndex << ",\"args\":{\"name\":";
+            writeEscapedString(os, thread_name);
+            os << "}}";
+        }
+        if (buffer->m_generation.load(std::memory_order_acquire) != generation) continue;
+        const unsigned count = buffer->m_count.load(std::memory_order_acquire);
+        for (unsigned i = 0; i < count; i++)
+        {
+            const Record& rec = buffer->m_records[i];
+            const double start_us = rec.m_startTime > capture_start ? static_cast<double>(rec.m_startTime - capture_start) / 1000.0 : 0.0;
+            begin_event();
+            os << "{\"name\":";
+            writeEscapedString(os, rec.m_name);
+            if (rec.m_type == RecordType::FrameMark)
+            {
+                snprintf(number, sizeof(number), "%.3f", start_us);
+                os << ",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":" << buffer->m_threadIndex << ",\"ts\":" << number << "}";
+                continue;
+            }
+            snprintf(number, sizeof(number), "%.3f", start_us);
+            os << ",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->m_threadIndex << ",\"ts\":" << number;
+            snprintf(number, sizeof(number), "%.3f", static_cast<double>(rec.m_duration) / 1000.0);
+            os << ",\"dur\":" << number << ",\"args\":{\"alloc_count\":" << rec.m_allocationCount
+                << ",\"alloc_bytes\":" << rec.m_allocationBytes << "}}";
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool Profiler::exportChromeTrace(const std::string& filepath)
+{
+    std::ofstream file(filepath.c_str(), std::fstream::out | std::fstream::trunc);
+    if (!file.is_open()) return false;
+    exportChromeTrace(file);
+    return file.good();
+}
+
+std::uint64_t Profiler::recordedCount()
+{
+    const std::uint32_t generation = m_captureGeneration.load(std::memory_order_acquire);
+    std::uint64_t count = 0;
+    std::lock_guard locker{ threadBufferLock() };
+    for (auto buffer : threadBuffers())
+    {
+        if (buffer->m_generation.load(std::memory_order_acquire) == generation) count += buffer->m_count.load(std::memory_order_acquire);
+    }
+    return count;
+}
+
+std::uint64_t Profiler::droppedCount()
+{
+    const std::uint32_t generation = m_captureGeneration.load(std::memory_order_acquire);
+    std::uint64_t count = 0;
+    std::lock_guard locker{ threadBufferLock() };
+    for (auto buffer : threadBuffers())
+    {
+        if (buffer->m_generation.load(std::memory_order_acquire) == generation) count += buffer->m_droppedCount.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+void Profiler::record(RecordType type, const char* name, std::uint64_t start_time, std::uint64_t duration,
+    std::uint32_t allocation_count, std::uint64_t allocation_bytes)
+{
+    ThreadBuffer* buffer = currentThreadBuffer();
+    const std::uint32_t generation = m_captureGeneration.load(std::memory_order_acquire);
+    if (buffer->m_generation.load(std::memory_order_relaxed) != generation)
+    {
+        buffer->m_count.store(0, std::memory_order_relaxed);
+        buffer->m_droppedCount.store(0, std::memory_order_relaxed);
+        if (!buffer->m_records) buffer->m_records = std::make_unique<Record[]>(RecordCapacityPerThread);
+        buffer->m_generation.store(generation, std::memory_order_release);
+    }
+    const unsigned index = buffer->m_count.load(std::memory_order_relaxed);
+    if (index >= RecordCapacityPerThread)
+    {
+        buffer->m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->m_records[index] = { name, start_time, duration, allocation_bytes, allocation_count, type };
+    // count 是 release, export 讀到的 records 一定是寫完的
+    buffer->m_count.store(index + 1, std::memory_order_release);
+}
+
+std::uint64_t Profiler::now()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* Profiler::typeName(const std::type_info& type)
+{
+    // 跟 thread buffer 一樣不釋放, trace export 時名稱還要有效
+    static std::mutex* lock = new std::mutex;
+    static auto* names = new std::unordered_map<std::type_index, std::string>;
+    std::lock_guard locker{ *lock };
+    auto it = names->find(std::type_index{ type });
+    if (it == names->end()) it = names->emplace(std::type_index{ type }, readableTypeName(type)).first;
+    return it->second.c_str();
+}
+
+std::uint64_t Profiler::threadAllocationCount()
+{
+    return t_allocationCount;
+}
+
+std::uint64_t Profiler::threadAllocationBytes()
+{
+    return t_allocationBytes;
+}
+
+// 取代 global operator new / delete, 計算每個執行緒的配置次數; aligned 版本沒有取代, 維持成對
+void* operator new(std::size_t size)
+{
+    void* p = allocateCounted(size);
+    if (!p)
+    {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateCounted(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateCounted(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+#endif // ENIGMA_PROFILER_ENABLED
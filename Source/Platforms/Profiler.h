@@ -0,0 +1,136 @@
+﻿/*********************************************************************
+ * \file   Profiler.h
+ * \brief  scoped zone frame profiler, 每個執行緒寫自己的 buffer (不用鎖),
+ *         capture 結束後輸出 chrome trace json (chrome://tracing, perfetto),
+ *         沒有定義 ENIGMA_PROFILER_ENABLED 時所有 macro 都是空的
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#if defined(ENIGMA_PROFILER_ENABLED)
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+namespace Enigma::Platforms
+{
+    class Profiler
+    {
+    public:
+        /// 每個執行緒一次 capture 最多記錄的 zone 數, 超過的丟掉並計數
+        static constexpr unsigned RecordCapacityPerThread = 1 << 16;
+
+        enum class RecordType : std::uint8_t
+        {
+            Zone,
+            FrameMark,
+        };
+        struct Record
+        {
+            const char* m_name;
+            std::uint64_t m_startTime;  ///< ns
+            std::uint64_t m_duration;  ///< ns
+            std::uint64_t m_allocationBytes;
+            std::uint32_t m_allocationCount;
+            RecordType m_type;
+        };
+
+    public:
+        /** 清掉上一次的 records, 開始記錄 */
+        static void beginCapture();
+        static void endCapture();
+        static bool isCapturing() { return m_isCapturing.load(std::memory_order_relaxed); }
+
+        /** frame 邊界 */
+        static void markFrame();
+        /** @param name : 字串常數, 只保留 pointer */
+        static void setThreadName(const char* name);
+
+        /** 在 endCapture 之後呼叫, 輸出 chrome trace event format */
+        static void exportChromeTrace(std::ostream& os);
+        static bool exportChromeTrace(const std::string& filepath);
+
+        static std::uint64_t recordedCount();
+        static std::uint64_t droppedCount();
+
+        /** zone 結束時呼叫, 只有 owner thread 會寫自己的 buffer
+            @param name : 字串常數 (rtti name, typeName), 只保留 pointer */
+        static void record(RecordType type, const char* name, std::uint64_t start_time, std::uint64_t duration,
+            std::uint32_t allocation_count, std::uint64_t allocation_bytes);
+        static std::uint64_t now();
+        /** 可讀的 type 名稱 (gcc / clang 的 mangled name 會 demangle), 同一個 type 只轉一次, 回傳的字串一直有效 */
+        static const char* typeName(const std::type_info& type);
+
+        /** 這個執行緒到目前為止經過 global operator new 的配置次數 & bytes
+            (msvc debug 的 menew 走 crt debug heap, 不會被算到) */
+        static std::uint64_t threadAllocationCount();
+        static std::uint64_t threadAllocationBytes();
+
+    protected:
+        static std::atomic<bool> m_isCapturing;
+        static std::atomic<std::uint32_t> m_captureGeneration;
+        static std::atomic<std::uint64_t> m_captureStartTime;
+    };
+
+    class ProfileZone
+    {
+    public:
+        explicit ProfileZone(const char* name) : m_name(name), m_isActive(Profiler::isCapturing())
+        {
+            if (!m_isActive) return;
+            m_allocationCount = Profiler::threadAllocationCount();
+            m_allocationBytes = Profiler::threadAllocationBytes();
+            m_startTime = Profiler::now();
+        }
+        /** 以 event / command 的 type 命名, 只在 capture 中才轉換名稱 */
+        explicit ProfileZone(const std::type_info& type) : m_name(nullptr), m_isActive(Profiler::isCapturing())
+        {
+            if (!m_isActive) return;
+            m_name = Profiler::typeName(type);
+            m_allocationCount = Profiler::threadAllocationCount();
+            m_allocationBytes = Profiler::threadAllocationBytes();
+            m_startTime = Profiler::now();
+        }
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone(ProfileZone&&) = delete;
+        ~ProfileZone()
+        {
+            if (!m_isActive) return;
+            const std::uint64_t end_time = Profiler::now();
+            Profiler::record(Profiler::RecordType::Zone, m_name, m_startTime, end_time - m_startTime,
+                static_cast<std::uint32_t>(Profiler::threadAllocationCount() - m_allocationCount),
+                Profiler::threadAllocationBytes() - m_allocationBytes);
+        }
+        ProfileZone& operator=(const ProfileZone&) = delete;
+        ProfileZone& operator=(ProfileZone&&) = delete;
+
+    protected:
+        const char* m_name;
+        bool m_isActive;
+        std::uint64_t m_startTime = 0;
+        std::uint64_t m_allocationCount = 0;
+        std::uint64_t m_allocationBytes = 0;
+    };
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) Enigma::Platforms::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__){ name }
+#define PROFILE_FRAME_MARK() Enigma::Platforms::Profiler::markFrame()
+#define PROFILE_THREAD_NAME(name) Enigma::Platforms::Profiler::setThreadName(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME_MARK() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif // ENIGMA_PROFILER_ENABLED
+
+#endif // _PROFILER_H
@@ -16,11 +16,15 @@ namespace Enigma::Prefabs
     class LoadPawnPrefab : public Frameworks::IRequestCommand
     {
     public:
-        LoadPawnPrefab(const Engine::GenericDto& pawn_dto) : m_pawnDto(pawn_dto) {}
+        LoadPawnPrefab(const Engine::GenericDto& pawn_dto) : m_pawnDto(pawn_dto), m_instanceCount(1) {}
+        /** stamp out instances in one command, pawn names are "name_0", "name_1", ... */
+        LoadPawnPrefab(const Engine::GenericDto& pawn_dto, unsigned instance_count) : m_pawnDto(pawn_dto), m_instanceCount(instance_count) {}
 
         const Engine::GenericDto& getPawnDto() const { return m_pawnDto; }
+        unsigned instanceCount() const { return m_instanceCount; }
     protected:
         Engine::GenericDto m_pawnDto;
+        unsigned m_instanceCount;
     };
 }
 
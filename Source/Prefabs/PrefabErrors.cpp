@@ -13,6 +13,7 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::nullDeserializer: return "Null deserializer";
     case ErrorCode::emptyPrefabs: return "Empty prefabs";
     case ErrorCode::invalidPrefab: return "Invalid prefab";
+    case ErrorCode::cloneTemplateFail: return "Clone prefab template fail";
     }
     return "Unknown";
 }
@@ -19,6 +19,7 @@ namespace Enigma::Prefabs
         nullDeserializer,
         emptyPrefabs,
         invalidPrefab,
+        cloneTemplateFail,
     };
     class ErrorCategory : public std::error_category
     {
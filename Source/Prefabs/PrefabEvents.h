@@ -10,6 +10,7 @@
 
 #include "Frameworks/Event.h"
 #include <system_error>
+#include <vector>
 
 namespace Enigma::Prefabs
 {
@@ -25,6 +26,18 @@ namespace Enigma::Prefabs
         std::string m_prefabAtPath;
         std::shared_ptr<SceneGraph::Pawn> m_pawn;
     };
+    class PawnPrefabInstancesLoaded : public Frameworks::IResponseEvent
+    {
+    public:
+        PawnPrefabInstancesLoaded(const Frameworks::Ruid& request_ruid, const std::string& prefab_at_path, const std::vector<std::shared_ptr<SceneGraph::Pawn>>& pawns) : IResponseEvent(request_ruid), m_prefabAtPath(prefab_at_path), m_pawns(pawns) {}
+
+        const std::string& getPrefabAtPath() const { return m_prefabAtPath; }
+        const std::vector<std::shared_ptr<SceneGraph::Pawn>>& getPawns() const { return m_pawns; }
+
+    private:
+        std::string m_prefabAtPath;
+        std::vector<std::shared_ptr<SceneGraph::Pawn>> m_pawns;
+    };
     class LoadPawnPrefabFailed : public Frameworks::IResponseEvent
     {
     public:
@@ -3,6 +3,7 @@
 #include "PrefabErrors.h"
 #include "PrefabEvents.h"
 #include "PawnPrefabDto.h"
+#include "PrefabTemplateCache.h"
 #include "Frameworks/CommandBus.h"
 #include "Frameworks/EventPublisher.h"
 #include "SceneGraph/SceneGraphCommands.h"
@@ -10,6 +11,7 @@
 #include "GameEngine/DtoEvents.h"
 #include "GameCommon/GameSceneCommands.h"
 #include <cassert>
+#include <algorithm>
 
 using namespace Enigma::Prefabs;
 using namespace Enigma::Frameworks;
@@ -21,14 +23,16 @@ DEFINE_RTTI(Prefabs, PrefabIOService, ISystemService);
 PrefabIOService::PrefabIOService(Frameworks::ServiceManager* srv_mngr, const std::shared_ptr<IDtoDeserializer>& dto_deserializer) : ISystemService(srv_mngr)
 {
     m_needTick = false;
+    m_loadingSerial = 0;
     m_dtoDeserializer = dto_deserializer;
+    m_templateCache = std::make_shared<PrefabTemplateCache>();
 }
 
 PrefabIOService::~PrefabIOService()
 {
-    m_currentCommand = nullptr;
-    m_loadedPawn = nullptr;
+    m_loadingPrefabs.clear();
     m_loadingCommands.clear();
+    m_templateCache = nullptr;
 }
 
 Enigma::Frameworks::ServiceResult PrefabIOService::onInit()
@@ -54,16 +58,15 @@ Enigma::Frameworks::ServiceResult PrefabIOService::onInit()
 
 ServiceResult PrefabIOService::onTick()
 {
-    if (m_currentCommand) return ServiceResult::Pendding;
     loadNextPrefab();
     return ServiceResult::Pendding;
 }
 
 Enigma::Frameworks::ServiceResult PrefabIOService::onTerm()
 {
-    m_currentCommand = nullptr;
-    m_loadedPawn = nullptr;
+    m_loadingPrefabs.clear();
     m_loadingCommands.clear();
+    m_templateCache->clear();
 
     EventPublisher::unsubscribe(typeid(GenericDtoDeserialized), m_onDtoDeserialized);
     m_onDtoDeserialized = nullptr;
@@ -86,117 +89,218 @@ Enigma::Frameworks::ServiceResult PrefabIOService::onTerm()
 
 void PrefabIOService::loadNextPrefab()
 {
-    if (m_currentCommand) return;
-    if (m_loadingCommands.empty())
+    // 不同 prefab 的 load 可以同時進行, 同一個 prefab 等第一次 build 完再 clone
+    while (!m_loadingCommands.empty())
     {
-        m_needTick = false;
+        auto cmd = m_loadingCommands.front();
+        m_loadingCommands.pop_front();
+        const std::string prefab_at_path = cmd->getPawnDto().getRtti().GetPrefab();
+        if (prefab_at_path.empty())
+        {
+            failPrefabLoading(cmd, ErrorCode::emptyPrefabPath);
+            continue;
+        }
+        if (const auto it = m_loadingPrefabs.find(prefab_at_path); it != m_loadingPrefabs.end())
+        {
+            it->second.m_waitingCommands.emplace_back(cmd);
+        }
+        else if (m_templateCache->hasTemplate(prefab_at_path))
+        {
+            instancePrefab(cmd, nullptr);
+        }
+        else
+        {
+            startPrefabLoading(prefab_at_path, cmd);
+        }
+    }
+    m_needTick = false;
+}
+
+void PrefabIOService::startPrefabLoading(const std::string& prefab_at_path, const std::shared_ptr<LoadPawnPrefab>& cmd)
+{
+    assert(cmd);
+    // scene graph id 不能用 pawn name, 不同 prefab 的 pawn 同名時, 會把別人 build 好的 scene graph 認成自己的
+    const std::string scene_graph_id = prefab_at_path + "#" + std::to_string(++m_loadingSerial);
+    LoadingPrefab loading{ cmd->getPawnDto().ruid(), scene_graph_id, nullptr, { cmd } };
+    m_loadingPrefabs.insert_or_assign(prefab_at_path, loading);
+    if (auto dtos = m_templateCache->queryPrefabDtos(prefab_at_path))
+    {  // 已經 parse 過, 不用再讀檔
+        CommandBus::post(std::make_shared<BuildSceneGraph>(loading.m_sceneGraphId, dtos.value()));
         return;
     }
-    m_currentCommand = m_loadingCommands.front();
-    m_loadingCommands.pop_front();
-    deserializePrefab(m_currentCommand->getPawnDto().ruid(), m_currentCommand->getPawnDto().getRtti().GetPrefab());
+    deserializePrefab(prefab_at_path, loading.m_dtoRuid);
 }
 
-void PrefabIOService::deserializePrefab(const Ruid& dto_ruid, const std::string& prefab_at_path)
+void PrefabIOService::deserializePrefab(const std::string& prefab_at_path, const Ruid& dto_ruid)
 {
-    if (prefab_at_path.empty()) return failPrefabLoading(ErrorCode::emptyPrefabPath);
-    if (!m_dtoDeserializer) return failPrefabLoading(ErrorCode::nullDeserializer);
+    if (!m_dtoDeserializer) return failPrefabLoading(prefab_at_path, ErrorCode::nullDeserializer);
 
     m_dtoDeserializer->invokeDeserialize(dto_ruid, prefab_at_path);
 }
 
-void PrefabIOService::completePawnPrefabLoading(const std::shared_ptr<SceneGraph::Pawn>& pawn)
+void PrefabIOService::completePawnPrefabLoading(const std::string& prefab_at_path, const std::shared_ptr<SceneGraph::Pawn>& pawn)
 {
     assert(pawn);
-    assert(m_currentCommand);
-    EventPublisher::post(std::make_shared<PawnPrefabLoaded>(m_currentCommand->getRuid(), m_currentCommand->getPawnDto().getRtti().GetPrefab(), pawn));
-    m_currentCommand = nullptr;
-    m_loadedPawn = nullptr;
+    const auto it = m_loadingPrefabs.find(prefab_at_path);
+    if (it == m_loadingPrefabs.end()) return;
+    const auto waiting_commands = it->second.m_waitingCommands;
+    m_loadingPrefabs.erase(it);
+    m_templateCache->putTemplate(prefab_at_path, pawn);
+    // 第一個 command 直接拿 build 出來的 pawn, 其他都從 template clone
+    std::shared_ptr<Pawn> built_pawn = pawn;
+    for (auto& cmd : waiting_commands)
+    {
+        instancePrefab(cmd, built_pawn);
+        built_pawn = nullptr;
+    }
     loadNextPrefab();
 }
 
-void PrefabIOService::failPrefabLoading(error er)
+void PrefabIOService::instancePrefab(const std::shared_ptr<LoadPawnPrefab>& cmd, const std::shared_ptr<SceneGraph::Pawn>& built_pawn)
 {
-    EventPublisher::post(std::make_shared<LoadPawnPrefabFailed>(m_currentCommand->getRuid(), er));
-    m_currentCommand = nullptr;
-    m_loadedPawn = nullptr;
+    assert(cmd);
+    const std::string prefab_at_path = cmd->getPawnDto().getRtti().GetPrefab();
+    const std::string pawn_name = cmd->getPawnDto().getName();
+    const unsigned instance_count = std::max(1u, cmd->instanceCount());
+    std::vector<std::shared_ptr<Pawn>> pawns;
+    pawns.reserve(instance_count);
+    for (unsigned i = 0; i < instance_count; i++)
+    {
+        if ((i == 0) && (built_pawn))
+        {
+            pawns.emplace_back(built_pawn);
+            continue;
+        }
+        auto pawn = m_templateCache->cloneTemplate(prefab_at_path, instance_count == 1 ? pawn_name : pawn_name + "_" + std::to_string(i));
+        if (!pawn) return failPrefabLoading(cmd, ErrorCode::cloneTemplateFail);
+        pawns.emplace_back(pawn);
+    }
+    if (cmd->instanceCount() > 1)
+    {
+        EventPublisher::post(std::make_shared<PawnPrefabInstancesLoaded>(cmd->getRuid(), prefab_at_path, pawns));
+    }
+    else
+    {
+        EventPublisher::post(std::make_shared<PawnPrefabLoaded>(cmd->getRuid(), prefab_at_path, pawns[0]));
+    }
+}
+
+void PrefabIOService::failPrefabLoading(const std::string& prefab_at_path, error er)
+{
+    const auto it = m_loadingPrefabs.find(prefab_at_path);
+    if (it == m_loadingPrefabs.end()) return;
+    const auto waiting_commands = it->second.m_waitingCommands;
+    m_loadingPrefabs.erase(it);
+    for (auto& cmd : waiting_commands)
+    {
+        failPrefabLoading(cmd, er);
+    }
     loadNextPrefab();
 }
 
+void PrefabIOService::failPrefabLoading(const std::shared_ptr<LoadPawnPrefab>& cmd, error er)
+{
+    assert(cmd);
+    EventPublisher::post(std::make_shared<LoadPawnPrefabFailed>(cmd->getRuid(), er));
+}
+
+std::optional<std::string> PrefabIOService::findLoadingPrefabByDtoRuid(const Ruid& ruid) const
+{
+    for (auto& [prefab_at_path, loading] : m_loadingPrefabs)
+    {
+        if (loading.m_dtoRuid == ruid) return prefab_at_path;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> PrefabIOService::findLoadingPrefabBySceneGraphId(const std::string& scene_graph_id) const
+{
+    for (auto& [prefab_at_path, loading] : m_loadingPrefabs)
+    {
+        if (loading.m_sceneGraphId == scene_graph_id) return prefab_at_path;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> PrefabIOService::findLoadingPrefabByPawn(const std::shared_ptr<SceneGraph::Pawn>& pawn) const
+{
+    if (!pawn) return std::nullopt;
+    for (auto& [prefab_at_path, loading] : m_loadingPrefabs)
+    {
+        if (loading.m_loadedPawn == pawn) return prefab_at_path;
+    }
+    return std::nullopt;
+}
+
 void PrefabIOService::onDtoDeserialized(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCommand) return;
     if (!e) return;
     const auto ev = std::dynamic_pointer_cast<GenericDtoDeserialized>(e);
     if (!ev) return;
-    if (ev->getRuid() != m_currentCommand->getPawnDto().ruid()) return;
-    CommandBus::post(std::make_shared<BuildSceneGraph>(m_currentCommand->getPawnDto().getName(), ev->GetDtos()));
+    const auto prefab_at_path = findLoadingPrefabByDtoRuid(ev->getRuid());
+    if (!prefab_at_path) return;
+    m_templateCache->putPrefabDtos(prefab_at_path.value(), ev->GetDtos());
+    CommandBus::post(std::make_shared<BuildSceneGraph>(m_loadingPrefabs[prefab_at_path.value()].m_sceneGraphId, ev->GetDtos()));
 }
 
 void PrefabIOService::onDeserializeDtoFailed(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCommand) return;
     if (!e) return;
     const auto ev = std::dynamic_pointer_cast<DeserializeDtoFailed>(e);
     if (!ev) return;
-    if (ev->getRuid() != m_currentCommand->getPawnDto().ruid()) return;
-    failPrefabLoading(ev->GetErrorCode());
+    const auto prefab_at_path = findLoadingPrefabByDtoRuid(ev->getRuid());
+    if (!prefab_at_path) return;
+    failPrefabLoading(prefab_at_path.value(), ev->GetErrorCode());
 }
 
 void PrefabIOService::onSceneGraphBuilt(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCommand) return;
     if (!e) return;
     const auto ev = std::dynamic_pointer_cast<FactorySceneGraphBuilt>(e);
     if (!ev) return;
-    if (ev->GetSceneGraphId() != m_currentCommand->getPawnDto().getName()) return;
-    if ((ev->GetTopLevelSpatial().empty()) || (!ev->GetTopLevelSpatial()[0])) return failPrefabLoading(ErrorCode::emptyPrefabs);
+    const auto prefab_at_path = findLoadingPrefabBySceneGraphId(ev->GetSceneGraphId());
+    if (!prefab_at_path) return;
+    if ((ev->GetTopLevelSpatial().empty()) || (!ev->GetTopLevelSpatial()[0])) return failPrefabLoading(prefab_at_path.value(), ErrorCode::emptyPrefabs);
     auto pawn = std::dynamic_pointer_cast<Pawn>(ev->GetTopLevelSpatial()[0]);
-    if (!pawn) return failPrefabLoading(ErrorCode::invalidPrefab);
+    if (!pawn) return failPrefabLoading(prefab_at_path.value(), ErrorCode::invalidPrefab);
     if (pawn->getPrimitive())
     {
-        completePawnPrefabLoading(pawn);
+        completePawnPrefabLoading(prefab_at_path.value(), pawn);
     }
     else
     {
-        m_loadedPawn = pawn;
+        m_loadingPrefabs[prefab_at_path.value()].m_loadedPawn = pawn;
     }
 }
 
 void PrefabIOService::onPawnPrimitiveBuilt(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCommand) return;
     if (!e) return;
     const auto ev = std::dynamic_pointer_cast<PawnPrimitiveBuilt>(e);
     if (!ev) return;
-    if (!m_loadedPawn) return; // no pending pawn
-    if (ev->pawn() == m_loadedPawn)
-    {
-        completePawnPrefabLoading(m_loadedPawn);
-    }
+    const auto prefab_at_path = findLoadingPrefabByPawn(ev->pawn());
+    if (!prefab_at_path) return; // no pending pawn
+    completePawnPrefabLoading(prefab_at_path.value(), ev->pawn());
 }
 
 void PrefabIOService::onBuildPawnPrimitiveFailed(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCommand) return;
     if (!e) return;
     const auto ev = std::dynamic_pointer_cast<BuildPawnPrimitiveFailed>(e);
     if (!ev) return;
-    if (!m_loadedPawn) return; // no pending pawn
-    if (ev->pawn() == m_loadedPawn)
-    {
-        failPrefabLoading(ev->error());
-    }
+    const auto prefab_at_path = findLoadingPrefabByPawn(ev->pawn());
+    if (!prefab_at_path) return; // no pending pawn
+    failPrefabLoading(prefab_at_path.value(), ev->error());
 }
 
 void PrefabIOService::onBuildSceneGraphFailed(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCommand) return;
     if (!e) return;
     const auto ev = std::dynamic_pointer_cast<BuildFactorySceneGraphFailed>(e);
     if (!ev) return;
-    if (ev->GetSceneGraphId() != m_currentCommand->getPawnDto().getName()) return;
-    failPrefabLoading(ev->GetErrorCode());
+    const auto prefab_at_path = findLoadingPrefabBySceneGraphId(ev->GetSceneGraphId());
+    if (!prefab_at_path) return;
+    failPrefabLoading(prefab_at_path.value(), ev->GetErrorCode());
 }
 
 void PrefabIOService::loadPawnPrefab(const Frameworks::ICommandPtr& c)
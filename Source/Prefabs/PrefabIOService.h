@@ -15,11 +15,16 @@
 #include "Frameworks/ruid.h"
 #include "SceneGraph/Pawn.h"
 #include <deque>
+#include <unordered_map>
+#include <vector>
 #include <system_error>
+#include <optional>
+#include <cstdint>
 
 namespace Enigma::Prefabs
 {
     class LoadPawnPrefab;
+    class PrefabTemplateCache;
     using error = std::error_code;
 
     class PrefabIOService : public Frameworks::ISystemService
@@ -37,12 +42,30 @@ namespace Enigma::Prefabs
         virtual Frameworks::ServiceResult onTick() override;
         virtual Frameworks::ServiceResult onTerm() override;
 
+        const std::shared_ptr<PrefabTemplateCache>& templateCache() const { return m_templateCache; }
+
     private:
+        /** prefab 還在 deserialize/build 中, 同一個 prefab 的 command 都等它完成 */
+        struct LoadingPrefab
+        {
+            Frameworks::Ruid m_dtoRuid;
+            std::string m_sceneGraphId;  ///< prefab path + 每次 load 的序號, 同時進行的 load 不會撞名
+            std::shared_ptr<SceneGraph::Pawn> m_loadedPawn;
+            std::vector<std::shared_ptr<LoadPawnPrefab>> m_waitingCommands;
+        };
+
         void loadNextPrefab();
-        void deserializePrefab(const Frameworks::Ruid& dto_ruid, const std::string& prefab_at_path);
-        void completePawnPrefabLoading(const std::shared_ptr<SceneGraph::Pawn>& pawn);
+        void startPrefabLoading(const std::string& prefab_at_path, const std::shared_ptr<LoadPawnPrefab>& cmd);
+        void deserializePrefab(const std::string& prefab_at_path, const Frameworks::Ruid& dto_ruid);
+        void completePawnPrefabLoading(const std::string& prefab_at_path, const std::shared_ptr<SceneGraph::Pawn>& pawn);
+        void instancePrefab(const std::shared_ptr<LoadPawnPrefab>& cmd, const std::shared_ptr<SceneGraph::Pawn>& built_pawn);
+
+        void failPrefabLoading(const std::string& prefab_at_path, error er);
+        void failPrefabLoading(const std::shared_ptr<LoadPawnPrefab>& cmd, error er);
 
-        void failPrefabLoading(error er);
+        std::optional<std::string> findLoadingPrefabByDtoRuid(const Frameworks::Ruid& ruid) const;
+        std::optional<std::string> findLoadingPrefabBySceneGraphId(const std::string& scene_graph_id) const;
+        std::optional<std::string> findLoadingPrefabByPawn(const std::shared_ptr<SceneGraph::Pawn>& pawn) const;
 
         void onDtoDeserialized(const Frameworks::IEventPtr& e);
         void onDeserializeDtoFailed(const Frameworks::IEventPtr& e);
@@ -66,8 +89,9 @@ namespace Enigma::Prefabs
         Frameworks::CommandSubscriberPtr m_loadPawnPrefab;
 
         std::deque<std::shared_ptr<LoadPawnPrefab>> m_loadingCommands;
-        std::shared_ptr<LoadPawnPrefab> m_currentCommand;
-        std::shared_ptr<SceneGraph::Pawn> m_loadedPawn;
+        std::unordered_map<std::string, LoadingPrefab> m_loadingPrefabs;  ///< key : prefab at path
+        std::uint64_t m_loadingSerial;
+        std::shared_ptr<PrefabTemplateCache> m_templateCache;
     };
 }
 
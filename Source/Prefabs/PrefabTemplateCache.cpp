@@ -0,0 +1,98 @@
+﻿#include "PrefabTemplateCache.h"
+#include "SceneGraph/Pawn.h"
+#include "SceneGraph/SceneGraphDtos.h"
+#include "SceneGraph/SceneGraphQueries.h"
+#include "SceneGraph/SceneGraphPersistenceLevel.h"
+#include "Primitives/Primitive.h"
+#include "Primitives/PrimitiveQueries.h"
+#include "Primitives/PrimitivePersistenceLevel.h"
+#include <cassert>
+
+using namespace Enigma::Prefabs;
+using namespace Enigma::Engine;
+using namespace Enigma::SceneGraph;
+
+PrefabTemplateCache::PrefabTemplateCache() : m_hitCount(0), m_missCount(0)
+{
+}
+
+PrefabTemplateCache::~PrefabTemplateCache()
+{
+    m_templates.clear();
+}
+
+void PrefabTemplateCache::putPrefabDtos(const std::string& prefab_at_path, const GenericDtoCollection& dtos)
+{
+    std::lock_guard locker{ m_templateLock };
+    m_templates[prefab_at_path].m_prefabDtos = dtos;
+}
+
+std::optional<GenericDtoCollection> PrefabTemplateCache::queryPrefabDtos(const std::string& prefab_at_path)
+{
+    std::lock_guard locker{ m_templateLock };
+    const auto it = m_templates.find(prefab_at_path);
+    if ((it == m_templates.end()) || (it->second.m_prefabDtos.empty())) return std::nullopt;
+    return it->second.m_prefabDtos;
+}
+
+void PrefabTemplateCache::putTemplate(const std::string& prefab_at_path, const std::shared_ptr<Pawn>& pawn)
+{
+    assert(pawn);
+    std::lock_guard locker{ m_templateLock };
+    auto& prefab_template = m_templates[prefab_at_path];
+    // 剛 build 好的狀態做 snapshot, 之後 instance 怎麼改都不影響 template
+    prefab_template.m_pawnDto = pawn->serializeDto();
+    prefab_template.m_primitivePrototype = pawn->getPrimitive();
+    prefab_template.m_primitiveDto = std::nullopt;
+    if (prefab_template.m_primitivePrototype) prefab_template.m_primitiveDto = prefab_template.m_primitivePrototype->serializeDto();
+}
+
+bool PrefabTemplateCache::hasTemplate(const std::string& prefab_at_path)
+{
+    std::lock_guard locker{ m_templateLock };
+    const auto it = m_templates.find(prefab_at_path);
+    const bool has_template = (it != m_templates.end()) && (it->second.m_pawnDto.has_value());
+    if (has_template)
+    {
+        m_hitCount++;
+    }
+    else
+    {
+        m_missCount++;
+    }
+    return has_template;
+}
+
+std::shared_ptr<Pawn> PrefabTemplateCache::cloneTemplate(const std::string& prefab_at_path, const std::string& pawn_name)
+{
+    std::lock_guard locker{ m_templateLock };
+    const auto it = m_templates.find(prefab_at_path);
+    if ((it == m_templates.end()) || (!it->second.m_pawnDto)) return nullptr;
+    const auto& prefab_template = it->second;
+
+    PawnDto pawn_dto{ prefab_template.m_pawnDto.value() };
+    pawn_dto.id() = SpatialId(pawn_name, pawn_dto.id().rtti());
+    pawn_dto.parentId() = std::nullopt;
+    pawn_dto.parentName() = "";
+    if ((prefab_template.m_primitivePrototype) && (prefab_template.m_primitiveDto))
+    {
+        // next sequence 的 primitive 跟 origin 共用 geometry, render buffer, animation asset
+        const auto primitive_id = prefab_template.m_primitivePrototype->id().origin().next();
+        const auto primitive = std::make_shared<Primitives::RequestPrimitiveConstitution>(primitive_id, prefab_template.m_primitiveDto.value(), Primitives::PersistenceLevel::Repository)->dispatch();
+        if (!primitive) return nullptr;
+        pawn_dto.primitiveId() = primitive->id();
+    }
+    return std::dynamic_pointer_cast<Pawn>(std::make_shared<RequestSpatialConstitution>(pawn_dto.id(), pawn_dto.toGenericDto(), PersistenceLevel::Repository)->dispatch());
+}
+
+void PrefabTemplateCache::removeTemplate(const std::string& prefab_at_path)
+{
+    std::lock_guard locker{ m_templateLock };
+    m_templates.erase(prefab_at_path);
+}
+
+void PrefabTemplateCache::clear()
+{
+    std::lock_guard locker{ m_templateLock };
+    m_templates.clear();
+}
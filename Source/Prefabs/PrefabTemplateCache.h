@@ -0,0 +1,77 @@
+﻿/*********************************************************************
+ * \file   PrefabTemplateCache.h
+ * \brief  prefab template cache, 同一個 prefab 只 deserialize & build 一次,
+ *         之後的 instance 由 template clone 出來, geometry, render buffer,
+ *         animation asset 都共用
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef PREFAB_TEMPLATE_CACHE_H
+#define PREFAB_TEMPLATE_CACHE_H
+
+#include "GameEngine/GenericDto.h"
+#include "SceneGraph/SpatialId.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+
+namespace Enigma::Primitives
+{
+    class Primitive;
+}
+
+namespace Enigma::SceneGraph
+{
+    class Pawn;
+}
+
+namespace Enigma::Prefabs
+{
+    class PrefabTemplateCache
+    {
+    public:
+        PrefabTemplateCache();
+        PrefabTemplateCache(const PrefabTemplateCache&) = delete;
+        PrefabTemplateCache(PrefabTemplateCache&&) = delete;
+        ~PrefabTemplateCache();
+        PrefabTemplateCache& operator=(const PrefabTemplateCache&) = delete;
+        PrefabTemplateCache& operator=(PrefabTemplateCache&&) = delete;
+
+        /** parsed prefab dtos, 還沒 build 完成前也可以先存 */
+        void putPrefabDtos(const std::string& prefab_at_path, const Engine::GenericDtoCollection& dtos);
+        std::optional<Engine::GenericDtoCollection> queryPrefabDtos(const std::string& prefab_at_path);
+
+        /** built pawn as template : pawn dto snapshot & primitive prototype */
+        void putTemplate(const std::string& prefab_at_path, const std::shared_ptr<SceneGraph::Pawn>& pawn);
+        bool hasTemplate(const std::string& prefab_at_path);
+
+        /** clone pawn from template with fresh spatial id, primitive cloned with next sequence id */
+        std::shared_ptr<SceneGraph::Pawn> cloneTemplate(const std::string& prefab_at_path, const std::string& pawn_name);
+
+        void removeTemplate(const std::string& prefab_at_path);
+        void clear();
+
+        std::uint64_t hitCount() const { return m_hitCount; }
+        std::uint64_t missCount() const { return m_missCount; }
+
+    protected:
+        struct PrefabTemplate
+        {
+            Engine::GenericDtoCollection m_prefabDtos;
+            std::optional<Engine::GenericDto> m_pawnDto;
+            std::shared_ptr<Primitives::Primitive> m_primitivePrototype;  ///< 保留著, 共用的 resource 才不會被釋放
+            std::optional<Engine::GenericDto> m_primitiveDto;
+        };
+
+    protected:
+        std::unordered_map<std::string, PrefabTemplate> m_templates;
+        std::recursive_mutex m_templateLock;
+        std::uint64_t m_hitCount;
+        std::uint64_t m_missCount;
+    };
+}
+
+#endif // PREFAB_TEMPLATE_CACHE_H
@@ -84,6 +84,9 @@ namespace Enigma::Primitives
         /** enum animator list deep, including geometry's animator */
         virtual void enumAnimatorListDeep(std::list<std::shared_ptr<Animators::Animator>>& resultList);
 
+        /** repository cache 預算用的大小估計, 有 geometry / texture 的 primitive 要加上它們的大小 */
+        virtual size_t estimatedByteSize() const { return sizeof(Primitive); }
+
         /** add primitive flag */
         void addPrimitiveFlag(PrimitiveFlags flag)
         {
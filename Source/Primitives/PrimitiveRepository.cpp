@@ -58,7 +58,11 @@ ServiceResult PrimitiveRepository::onTerm()
 {
     assert(m_storeMapper);
     m_storeMapper->disconnect();
-    m_primitives.clear();
+    {
+        std::lock_guard locker{ m_primitiveLock };
+        m_primitives.clear();
+        m_cachePolicy.clear();
+    }
 
     QueryDispatcher::unsubscribe(typeid(QueryPrimitive), m_queryPrimitive);
     m_queryPrimitive = nullptr;
@@ -91,21 +95,70 @@ std::shared_ptr<Primitive> PrimitiveRepository::queryPrimitive(const PrimitiveId
     if (!hasPrimitive(id)) return nullptr;
     std::lock_guard locker{ m_primitiveLock };
     auto it = m_primitives.find(id);
-    if (it != m_primitives.end()) return it->second;
+    if (it != m_primitives.end())
+    {
+        m_cachePolicy.hit(id);
+        // texture 在加入之後才載入, 大小要跟著更新
+        m_cachePolicy.track(id, it->second->estimatedByteSize());
+        return it->second;
+    }
     assert(m_factory);
+    m_cachePolicy.miss();
     const auto dto = m_storeMapper->queryPrimitive(id.origin());
     assert(dto.has_value());
     auto prim = m_factory->constitute(id, dto.value(), true);
     assert(prim);
     m_primitives.insert_or_assign(id, prim);
+    m_cachePolicy.track(id, prim->estimatedByteSize());
+    evictOverBudget();
     return prim;
 }
 
+void PrimitiveRepository::cacheBudgetBytes(size_t bytes)
+{
+    std::lock_guard locker{ m_primitiveLock };
+    m_cachePolicy.budgetBytes(bytes);
+}
+
+size_t PrimitiveRepository::cacheBudgetBytes()
+{
+    std::lock_guard locker{ m_primitiveLock };
+    return m_cachePolicy.budgetBytes();
+}
+
+unsigned PrimitiveRepository::evictOverBudget()
+{
+    assert(m_storeMapper);
+    std::lock_guard locker{ m_primitiveLock };
+    return m_cachePolicy.evictOverBudget(
+        [this](const PrimitiveId& id)
+        {
+            // 只 evict 可以從 store 重新 constitute, 而且外面沒有人在用的
+            auto it = m_primitives.find(id);
+            if (it == m_primitives.end()) return true;
+            return (it->second.use_count() == 1) && (m_storeMapper->hasPrimitive(id.origin()));
+        },
+        [this](const PrimitiveId& id) { m_primitives.erase(id); });
+}
+
+RepositoryCacheStatistics PrimitiveRepository::cacheStatistics()
+{
+    std::lock_guard locker{ m_primitiveLock };
+    return m_cachePolicy.statistics();
+}
+
+void PrimitiveRepository::resetCacheStatistics()
+{
+    std::lock_guard locker{ m_primitiveLock };
+    m_cachePolicy.resetStatistics();
+}
+
 void PrimitiveRepository::removePrimitive(const PrimitiveId& id)
 {
     if (!hasPrimitive(id)) return;
     std::lock_guard locker{ m_primitiveLock };
     m_primitives.erase(id);
+    m_cachePolicy.untrack(id);
     error er = m_storeMapper->removePrimitive(id.origin());
     if (er)
     {
@@ -119,6 +172,7 @@ void PrimitiveRepository::putPrimitive(const PrimitiveId& id, const std::shared_
     if (hasPrimitive(id)) return;
     std::lock_guard locker{ m_primitiveLock };
     m_primitives.insert_or_assign(id, primitive);
+    m_cachePolicy.track(id, primitive->estimatedByteSize());
     if (id != id.origin()) return;  // only put origin primitive to store
     error er = m_storeMapper->putPrimitive(id.origin(), primitive->serializeDto());
     if (er)
@@ -166,6 +220,7 @@ void PrimitiveRepository::requestPrimitiveCreation(const Frameworks::IQueryPtr&
     {
         std::lock_guard locker{ m_primitiveLock };
         m_primitives.insert_or_assign(request->id(), primitive);
+        m_cachePolicy.track(request->id(), primitive->estimatedByteSize());
     }
     else if (request->persistenceLevel() == PersistenceLevel::Store)
     {
@@ -189,6 +244,7 @@ void PrimitiveRepository::requestPrimitiveConstitution(const Frameworks::IQueryP
     {
         std::lock_guard locker{ m_primitiveLock };
         m_primitives.insert_or_assign(request->id(), primitive);
+        m_cachePolicy.track(request->id(), primitive->estimatedByteSize());
     }
     else if (request->persistenceLevel() == PersistenceLevel::Store)
     {
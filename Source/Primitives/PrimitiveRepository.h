@@ -11,6 +11,7 @@
 #include "Frameworks/SystemService.h"
 #include "Frameworks/QuerySubscriber.h"
 #include "Frameworks/CommandSubscriber.h"
+#include "Frameworks/RepositoryCachePolicy.h"
 #include "PrimitiveId.h"
 #include <mutex>
 
@@ -44,6 +45,17 @@ namespace Enigma::Primitives
         void removePrimitive(const PrimitiveId& id);
         void putPrimitive(const PrimitiveId& id, const std::shared_ptr<Primitive>& primitive);
 
+        /** @name cache policy
+            超過預算時, 以 LRU 順序 evict 原型存在 store 且沒有被 repository 以外參照的 primitive */
+        //@{
+        /** 0 : no budget (default) */
+        void cacheBudgetBytes(size_t bytes);
+        size_t cacheBudgetBytes();
+        unsigned evictOverBudget();
+        Frameworks::RepositoryCacheStatistics cacheStatistics();
+        void resetCacheStatistics();
+        //@}
+
     protected:
         void queryPrimitive(const Frameworks::IQueryPtr& q);
         void queryPrimitiveNextSequenceNumber(const Frameworks::IQueryPtr& q);
@@ -58,6 +70,7 @@ namespace Enigma::Primitives
 
         std::unordered_map<PrimitiveId, std::shared_ptr<Primitive>, PrimitiveId::hash> m_primitives;
         std::recursive_mutex m_primitiveLock;
+        Frameworks::RepositoryCachePolicy<PrimitiveId, PrimitiveId::hash> m_cachePolicy;
 
         Frameworks::QuerySubscriberPtr m_queryPrimitive;
         Frameworks::QuerySubscriberPtr m_queryPrimitiveNextSequenceNumber;
@@ -1,6 +1,8 @@
 ﻿#include "MeshNodeTree.h"
 #include "RenderablePrimitiveDtos.h"
 #include "MeshPrimitive.h"
+#include "SkeletonEvaluator.h"
+#include <algorithm>
 
 using namespace Enigma::Renderables;
 using namespace Enigma::Engine;
@@ -25,22 +27,26 @@ MeshNodeTree::MeshNodeTree(const Engine::GenericDto& dto) : m_factoryDesc(MeshNo
 MeshNodeTree::MeshNodeTree(const MeshNodeTree& tree) : m_factoryDesc(tree.factoryDesc())
 {
     m_meshNodes = tree.m_meshNodes;
+    m_index = tree.m_index;
 }
 
 MeshNodeTree::MeshNodeTree(MeshNodeTree&& tree) noexcept : m_factoryDesc(std::move(tree.m_factoryDesc))
 {
     m_meshNodes = std::move(tree.m_meshNodes);
+    m_index = std::move(tree.m_index);
 }
 
 MeshNodeTree::~MeshNodeTree()
 {
     m_meshNodes.clear();
+    m_index = nullptr;
 }
 
 MeshNodeTree& MeshNodeTree::operator=(const MeshNodeTree& tree)
 {
     m_factoryDesc = tree.m_factoryDesc;
     m_meshNodes = tree.m_meshNodes;
+    m_index = tree.m_index;
     return *this;
 }
 
@@ -48,6 +54,7 @@ MeshNodeTree& MeshNodeTree::operator=(MeshNodeTree&& tree) noexcept
 {
     m_factoryDesc = std::move(tree.m_factoryDesc);
     m_meshNodes = std::move(tree.m_meshNodes);
+    m_index = std::move(tree.m_index);
     return *this;
 }
 
@@ -65,28 +72,37 @@ GenericDto MeshNodeTree::serializeDto() const
 std::optional<unsigned> MeshNodeTree::findMeshNodeIndex(const std::string& node_name) const
 {
     if (m_meshNodes.empty()) return std::nullopt;
-    unsigned count = static_cast<unsigned>(m_meshNodes.size());
-    for (unsigned i = 0; i < count; i++)
-    {
-        if (m_meshNodes[i].getName() == node_name) return i;
-    }
-    return std::nullopt;
+    auto node_index = index()->findMeshNodeIndex(node_name);
+    if (!node_index) return std::nullopt;
+    if ((node_index.value() < m_meshNodes.size()) && (m_meshNodes[node_index.value()].getName() == node_name)) return node_index;
+    // 共用來的 index 與這棵 tree 對不上, 自己重建一份
+    m_index = std::make_shared<const MeshNodeTreeIndex>(m_meshNodes);
+    return m_index->findMeshNodeIndex(node_name);
 }
 
 std::optional<Enigma::Primitives::PrimitiveId> MeshNodeTree::findInstancedPrimitiveId(const Primitives::PrimitiveId& original_id) const
 {
     if (m_meshNodes.empty()) return std::nullopt;
-    unsigned count = static_cast<unsigned>(m_meshNodes.size());
-    for (const auto& node : m_meshNodes)
+    auto node_index = index()->findMeshNodeIndex(original_id);
+    if (!node_index) return std::nullopt;
+    auto is_matched = [&](unsigned idx)
+        {
+            return (idx < m_meshNodes.size()) && (m_meshNodes[idx].getMeshPrimitive())
+                && (m_meshNodes[idx].getMeshPrimitive()->id().origin() == original_id);
+        };
+    if (!is_matched(node_index.value()))
     {
-        if ((node.getMeshPrimitive()) && (node.getMeshPrimitive()->id().origin() == original_id)) return node.getMeshPrimitive()->id();
+        m_index = std::make_shared<const MeshNodeTreeIndex>(m_meshNodes);
+        node_index = m_index->findMeshNodeIndex(original_id);
+        if ((!node_index) || (!is_matched(node_index.value()))) return std::nullopt;
     }
-    return std::nullopt;
+    return m_meshNodes[node_index.value()].getMeshPrimitive()->id();
 }
 
 unsigned MeshNodeTree::addMeshNode(const MeshNode& node)
 {
     m_meshNodes.emplace_back(node);
+    m_index = nullptr;
     const unsigned idx = static_cast<unsigned>(m_meshNodes.size() - 1);
 
     if (const auto parent_index = node.getParentIndexInArray())  // has parent node
@@ -130,6 +146,20 @@ bool MeshNodeTree::isInSubTree(unsigned child_node_index, const std::string& par
     return false;
 }
 
+const std::shared_ptr<const MeshNodeTreeIndex>& MeshNodeTree::index() const
+{
+    if ((!m_index) || (m_index->meshNodeCount() != m_meshNodes.size()))
+    {
+        m_index = std::make_shared<const MeshNodeTreeIndex>(m_meshNodes);
+    }
+    return m_index;
+}
+
+void MeshNodeTree::shareIndexByModel(const Primitives::PrimitiveId& model_origin_id)
+{
+    m_index = MeshNodeTreeIndex::shareByModel(model_origin_id, m_meshNodes);
+}
+
 void MeshNodeTree::updateMeshNodeLocalTransform(const MathLib::Matrix4& mxModelRootWorld, unsigned index, const MathLib::Matrix4& mxLocal)
 {
     if (index >= m_meshNodes.size()) return;
@@ -154,3 +184,32 @@ void MeshNodeTree::updateMeshNodeLocalTransform(const MathLib::Matrix4& mxModelR
         }
     }
 }
+
+bool MeshNodeTree::buildSkeleton(SkeletonEvaluator& skeleton) const
+{
+    std::vector<std::uint32_t> parent_indices(m_meshNodes.size(), SkeletonEvaluator::NoParent);
+    for (unsigned i = 0; i < m_meshNodes.size(); i++)
+    {
+        if (const auto parent_index = m_meshNodes[i].getParentIndexInArray()) parent_indices[i] = parent_index.value();
+    }
+    if (!skeleton.build(parent_indices)) return false;
+    for (unsigned i = 0; i < m_meshNodes.size(); i++)
+    {
+        skeleton.setLocalTransform(i, m_meshNodes[i].getLocalTransform());
+    }
+    return true;
+}
+
+void MeshNodeTree::updateMeshNodeTransforms(const MathLib::Matrix4& mxModelRootWorld, const SkeletonEvaluator& skeleton)
+{
+    const unsigned count = std::min(static_cast<unsigned>(m_meshNodes.size()), skeleton.nodeCount());
+    for (unsigned i = 0; i < count; i++)
+    {
+        m_meshNodes[i].setLocalTransform(skeleton.localTransform(i).toMatrix());
+        m_meshNodes[i].setRootRefTransform(skeleton.modelTransform(i).toMatrix());
+        if (std::shared_ptr<MeshPrimitive> mesh_prim = m_meshNodes[i].getMeshPrimitive())
+        {
+            mesh_prim->updateWorldTransform(mxModelRootWorld * m_meshNodes[i].getRootRefTransform());
+        }
+    }
+}
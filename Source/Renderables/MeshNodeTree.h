@@ -10,6 +10,7 @@
 #define _MESH_NODE_TREE_H
 
 #include "MeshNode.h"
+#include "MeshNodeTreeIndex.h"
 #include "MathLib/Matrix4.h"
 #include "Frameworks/optional_ref.hpp"
 #include "GameEngine/GenericDto.h"
@@ -19,6 +20,8 @@
 
 namespace Enigma::Renderables
 {
+    class SkeletonEvaluator;
+
     class MeshNodeTree
     {
         DECLARE_EN_RTTI_NON_BASE;
@@ -36,6 +39,7 @@ namespace Enigma::Renderables
 
         Engine::GenericDto serializeDto() const;
 
+        /** name index 查表, 不再線性比對字串 */
         std::optional<unsigned> findMeshNodeIndex(const std::string& node_name) const;
         std::optional<Primitives::PrimitiveId> findInstancedPrimitiveId(const Primitives::PrimitiveId& original_id) const;
         /** add mesh node to tree
@@ -44,15 +48,27 @@ namespace Enigma::Renderables
         unsigned getMeshNodeCount() const { return static_cast<unsigned>(m_meshNodes.size()); };
         stdext::optional_ref<MeshNode> getMeshNode(unsigned index);
         stdext::optional_ref<const MeshNode> getMeshNode(unsigned index) const;
+        const std::vector<MeshNode>& getMeshNodeArray() const { return m_meshNodes; }
         std::shared_ptr<MeshPrimitive> getMeshPrimitiveInNode(unsigned index) const;
         /// is child node in sub-tree? (find parent mesh node from child mesh node)
         bool isInSubTree(unsigned child_node_index, const std::string& parent_node_name);
 
+        /** name / original primitive id index, tree 有變動後第一次用到時才建 */
+        const std::shared_ptr<const MeshNodeTreeIndex>& index() const;
+        /** 同一個 model origin 的 instance 共用 index */
+        void shareIndexByModel(const Primitives::PrimitiveId& model_origin_id);
+
         void updateMeshNodeLocalTransform(const MathLib::Matrix4& mxModelRootWorld, unsigned index, const MathLib::Matrix4& mxLocal);
+        /** 以 mesh node 的 parent index 建出 skeleton, local pose 用 mesh node 的 local transform
+            @return false : 有 node 的 parent 排在它後面, 不能單一 pass 求值 */
+        bool buildSkeleton(SkeletonEvaluator& skeleton) const;
+        /** 把 skeleton 算好的 local & root ref transform 寫回所有 mesh node, node index 與 skeleton 相同 */
+        void updateMeshNodeTransforms(const MathLib::Matrix4& mxModelRootWorld, const SkeletonEvaluator& skeleton);
 
     protected:
         Engine::FactoryDesc m_factoryDesc;
         std::vector<MeshNode> m_meshNodes;
+        mutable std::shared_ptr<const MeshNodeTreeIndex> m_index;
     };
 }
 
@@ -0,0 +1,70 @@
+﻿#include "MeshNodeTreeIndex.h"
+#include "MeshNode.h"
+#include "MeshPrimitive.h"
+
+using namespace Enigma::Renderables;
+using namespace Enigma::Primitives;
+
+std::unordered_map<PrimitiveId, std::weak_ptr<const MeshNodeTreeIndex>, PrimitiveId::hash> MeshNodeTreeIndex::m_sharedIndices;
+std::mutex MeshNodeTreeIndex::m_sharedIndicesLock;
+
+MeshNodeTreeIndex::MeshNodeTreeIndex(const std::vector<MeshNode>& mesh_nodes)
+{
+    m_meshNodeCount = static_cast<unsigned>(mesh_nodes.size());
+    m_nodeNameIndices.reserve(mesh_nodes.size());
+    for (unsigned i = 0; i < m_meshNodeCount; i++)
+    {
+        // emplace 不會蓋掉已有的 key, 同名時保留前面的 node
+        m_nodeNameIndices.emplace(mesh_nodes[i].getName(), i);
+        if (const auto& mesh_prim = mesh_nodes[i].getMeshPrimitive())
+        {
+            m_primitiveIndices.emplace(mesh_prim->id().origin(), i);
+        }
+    }
+}
+
+MeshNodeTreeIndex::~MeshNodeTreeIndex()
+{
+    m_nodeNameIndices.clear();
+    m_primitiveIndices.clear();
+}
+
+std::optional<unsigned> MeshNodeTreeIndex::findMeshNodeIndex(const std::string& node_name) const
+{
+    const auto it = m_nodeNameIndices.find(node_name);
+    if (it == m_nodeNameIndices.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<unsigned> MeshNodeTreeIndex::findMeshNodeIndex(const PrimitiveId& original_primitive_id) const
+{
+    const auto it = m_primitiveIndices.find(original_primitive_id);
+    if (it == m_primitiveIndices.end()) return std::nullopt;
+    return it->second;
+}
+
+std::shared_ptr<const MeshNodeTreeIndex> MeshNodeTreeIndex::shareByModel(const PrimitiveId& model_origin_id, const std::vector<MeshNode>& mesh_nodes)
+{
+    std::lock_guard locker{ m_sharedIndicesLock };
+    const auto it = m_sharedIndices.find(model_origin_id);
+    if (it != m_sharedIndices.end())
+    {
+        auto index = it->second.lock();
+        if ((index) && (index->meshNodeCount() == mesh_nodes.size())) return index;
+    }
+    // 順便清掉已經沒有 instance 在用的
+    for (auto iter = m_sharedIndices.begin(); iter != m_sharedIndices.end();)
+    {
+        if (iter->second.expired())
+        {
+            iter = m_sharedIndices.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+    auto index = std::make_shared<const MeshNodeTreeIndex>(mesh_nodes);
+    m_sharedIndices[model_origin_id] = index;
+    return index;
+}
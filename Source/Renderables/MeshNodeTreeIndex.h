@@ -0,0 +1,53 @@
+﻿/*********************************************************************
+ * \file   MeshNodeTreeIndex.h
+ * \brief  mesh node tree 的 hash index, value object, use shared_ptr
+ * node name -> node index, original primitive id -> node index,
+ * 建好後不再變動, 同一個 model (origin id 相同) 的 instance 共用一份
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _MESH_NODE_TREE_INDEX_H
+#define _MESH_NODE_TREE_INDEX_H
+
+#include "Primitives/PrimitiveId.h"
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+namespace Enigma::Renderables
+{
+    class MeshNode;
+
+    class MeshNodeTreeIndex
+    {
+    public:
+        MeshNodeTreeIndex(const std::vector<MeshNode>& mesh_nodes);
+        MeshNodeTreeIndex(const MeshNodeTreeIndex&) = delete;
+        MeshNodeTreeIndex(MeshNodeTreeIndex&&) = delete;
+        ~MeshNodeTreeIndex();
+        MeshNodeTreeIndex& operator=(const MeshNodeTreeIndex&) = delete;
+        MeshNodeTreeIndex& operator=(MeshNodeTreeIndex&&) = delete;
+
+        unsigned meshNodeCount() const { return m_meshNodeCount; }
+
+        /** 同名的 node 取排在前面的, 與線性搜尋的結果相同 */
+        std::optional<unsigned> findMeshNodeIndex(const std::string& node_name) const;
+        std::optional<unsigned> findMeshNodeIndex(const Primitives::PrimitiveId& original_primitive_id) const;
+
+        /** 同一個 model origin 的 instance 共用 index, 沒有(或 node 數不同)就用 mesh_nodes 建一份新的 */
+        static std::shared_ptr<const MeshNodeTreeIndex> shareByModel(const Primitives::PrimitiveId& model_origin_id, const std::vector<MeshNode>& mesh_nodes);
+
+    protected:
+        unsigned m_meshNodeCount;
+        std::unordered_map<std::string, unsigned> m_nodeNameIndices;
+        std::unordered_map<Primitives::PrimitiveId, unsigned, Primitives::PrimitiveId::hash> m_primitiveIndices;
+
+        static std::unordered_map<Primitives::PrimitiveId, std::weak_ptr<const MeshNodeTreeIndex>, Primitives::PrimitiveId::hash> m_sharedIndices;
+        static std::mutex m_sharedIndicesLock;
+    };
+}
+
+#endif // _MESH_NODE_TREE_INDEX_H
@@ -2,6 +2,7 @@
 #include "GameEngine/EffectMaterial.h"
 #include "GameEngine/EffectMaterialSource.h"
 #include "GameEngine/Texture.h"
+#include "GameEngine/TextureResidencyManager.h"
 #include "GraphicKernel/IShaderVariable.h"
 #include "GameEngine/RenderBuffer.h"
 #include "Geometries/GeometryData.h"
@@ -27,6 +28,7 @@ MeshPrimitive::MeshPrimitive(const Primitives::PrimitiveId& id) : Primitive(id)
     m_geometry = nullptr;
     m_renderBuffer = nullptr;
     m_renderListID = Renderer::Renderer::RenderListID::Scene;
+    m_boundTextureEpoch = 0;
     m_elements.clear();
     m_effects.clear();
     m_textures.clear();
@@ -54,6 +56,7 @@ MeshPrimitive::MeshPrimitive(const Primitives::PrimitiveId& id, const Engine::Ge
     m_lazyStatus.changeStatus(Frameworks::LazyStatus::Status::Ghost);
     m_renderBuffer = nullptr;
     m_renderListID = mesh_dto.renderListID();
+    m_boundTextureEpoch = 0;
     m_elements.clear();
     m_effects.clear();
     for (auto& eff_id : mesh_dto.effects())
@@ -130,6 +133,28 @@ unsigned MeshPrimitive::getTextureMapCount() const
     return static_cast<unsigned>(m_textures.size());
 }
 
+size_t MeshPrimitive::estimatedByteSize() const
+{
+    std::unordered_set<const void*> counted_resources;
+    return sizeof(MeshPrimitive) + estimatedResourceBytes(counted_resources);
+}
+
+size_t MeshPrimitive::estimatedResourceBytes(std::unordered_set<const void*>& counted_resources) const
+{
+    size_t bytes = 0;
+    if ((m_geometry) && (counted_resources.insert(m_geometry.get()).second)) bytes += m_geometry->estimatedByteSize();
+    for (const auto& tex_map : m_textures)
+    {
+        for (unsigned i = 0; i < tex_map.getCount(); i++)
+        {
+            // texture 還沒載入時 resident bytes 是 0
+            auto texture = tex_map.getTexture(i);
+            if ((texture) && (counted_resources.insert(texture.get()).second)) bytes += texture->estimateResidentBytes();
+        }
+    }
+    return bytes;
+}
+
 void MeshPrimitive::changeSemanticTexture(const Engine::EffectTextureMap::EffectSemanticTextureTuple& tuple)
 {
     if (m_textures.empty()) return;
@@ -196,6 +221,7 @@ error MeshPrimitive::insertToRendererWithTransformUpdating(const std::shared_ptr
 
     if (FATAL_LOG_EXPR(m_elements.empty())) return ErrorCode::emptyRenderElementList;
 
+    touchResidentTextures();
     error er = ErrorCode::ok;
     for (auto& ele : m_elements)
     {
@@ -308,6 +334,7 @@ void MeshPrimitive::bindPrimitiveEffectTexture()
 {
     if (m_effects.empty()) return;
     if (m_textures.empty()) return;
+    m_boundTextureEpoch = sumTextureEpochs();
     EffectMaterialList::iterator eff_iter;
     TextureMapList::iterator tex_iter;
     for (eff_iter = m_effects.begin(), tex_iter = m_textures.begin();
@@ -409,3 +436,36 @@ std::shared_ptr<Texture> MeshPrimitive::findTextureBySemantic(const std::string&
     }
     return nullptr;
 }
+
+void MeshPrimitive::touchResidentTextures()
+{
+    if (m_textures.empty()) return;
+    const std::uint64_t frame_stamp = TextureResidencyManager::frameStamp();
+    std::uint64_t epoch_sum = 0;
+    for (auto& tex_map : m_textures)
+    {
+        for (unsigned i = 0; i < tex_map.getCount(); i++)
+        {
+            if (auto& tex = std::get<std::shared_ptr<Texture>>(tex_map.getEffectSemanticTextureTuple(i)))
+            {
+                tex->markUsed(frame_stamp);
+                epoch_sum += tex->deviceTextureEpoch();
+            }
+        }
+    }
+    // effect 直接 bind device texture, 自己用的 texture 被 evict 或重新 hydrate 時要重新 bind
+    if (m_boundTextureEpoch != epoch_sum) bindPrimitiveEffectTexture();
+}
+
+std::uint64_t MeshPrimitive::sumTextureEpochs()
+{
+    std::uint64_t epoch_sum = 0;
+    for (auto& tex_map : m_textures)
+    {
+        for (unsigned i = 0; i < tex_map.getCount(); i++)
+        {
+            if (auto& tex = std::get<std::shared_ptr<Texture>>(tex_map.getEffectSemanticTextureTuple(i))) epoch_sum += tex->deviceTextureEpoch();
+        }
+    }
+    return epoch_sum;
+}
@@ -21,6 +21,8 @@
 #include <memory>
 #include <system_error>
 #include <vector>
+#include <unordered_set>
+#include <cstdint>
 
 namespace Enigma::Renderables
 {
@@ -57,6 +59,10 @@ namespace Enigma::Renderables
         const Engine::EffectTextureMap& getTextureMap(unsigned int index);
         /** get texture map size */
         unsigned getTextureMapCount() const;
+
+        virtual size_t estimatedByteSize() const override;
+        /** geometry 與 texture 的大小, 已經在 counted_resources 中 (共用) 的不重複計算 */
+        size_t estimatedResourceBytes(std::unordered_set<const void*>& counted_resources) const;
         /** change specify semantic texture */
         void changeSemanticTexture(const Engine::EffectTextureMap::EffectSemanticTextureTuple& tuple);
         /** bind specify semantic texture, append new if semantic not existed */
@@ -65,7 +71,7 @@ namespace Enigma::Renderables
         void bindSemanticTextures(const Engine::EffectTextureMap::SegmentEffectTextures& texture_tuples);
 
         /** update render buffer */
-        error updateRenderBuffer();
+        virtual error updateRenderBuffer();
         /** update render buffer */
         error rangedUpdateRenderBuffer(unsigned vtx_offset, unsigned vtx_count, std::optional<unsigned> idx_offset, std::optional<unsigned> idx_count);
 
@@ -122,6 +128,10 @@ namespace Enigma::Renderables
         void loosePrimitiveEffectTexture();
         /** un-bind segment effect texture */
         void looseSegmentEffectTexture(unsigned index);
+        /** texture residency : mark textures used this frame, re-bind if any of its device textures is evicted or hydrated */
+        void touchResidentTextures();
+        /** texture 的 device texture epoch 只會遞增, 總和改變就表示有 texture 換過 device texture */
+        std::uint64_t sumTextureEpochs();
 
     protected:
         using RenderElementList = std::vector<std::shared_ptr<Renderer::RenderElement>>;
@@ -132,6 +142,7 @@ namespace Enigma::Renderables
         EffectMaterialList m_effects;
         TextureMapList m_textures;
         Renderer::Renderer::RenderListID m_renderListID;  ///< default : render group scene
+        std::uint64_t m_boundTextureEpoch;  ///< bind 時的 sumTextureEpochs
     };
 }
 
@@ -3,7 +3,13 @@
 #include "Primitives/PrimitiveIntersectionFinderFactories.h"
 #include "Geometries/IntrGeometryRay3.h"
 #include "Geometries/IntrGeometryCache.h"
+#include "Geometries/TriangleList.h"
+#include "GameEngine/IntrBVRay3.h"
+#include "MathLib/IntrRay3Triangle3.h"
+#include "Frameworks/unique_ptr_dynamic_cast.hpp"
 #include "MeshPrimitive.h"
+#include "SkinMeshPrimitive.h"
+#include <algorithm>
 
 using namespace Enigma::Renderables;
 using namespace Enigma::Engine;
@@ -66,6 +72,10 @@ Intersector::Result MeshPrimitiveRay3IntersectionFinder::testMesh(const std::sha
     ray.origin() = inv_world.TransformCoord(ray.origin());
     std::tie(ray.direction(), std::ignore) = inv_world.TransformVectorNormalized(ray.direction());
 
+    if (auto skin_mesh = std::dynamic_pointer_cast<SkinMeshPrimitive>(mesh); (skin_mesh) && (skin_mesh->deformSkinnedVertices()))
+    {
+        return testSkinnedMesh(skin_mesh, ray, std::move(cache));
+    }
     IntrGeometryRay3 intr_geo(mesh->getGeometryData(), ray);
     return intr_geo.test(std::move(cache));
 }
@@ -80,6 +90,16 @@ std::tuple<std::vector<IntrPrimitiveRay3::ResultRecord>, Intersector::Result> Me
     std::tie(ray.direction(), dir_length) = inv_world.TransformVectorNormalized(ray.direction());
 
     std::vector<IntrPrimitiveRay3::ResultRecord> records;
+    if (auto skin_mesh = std::dynamic_pointer_cast<SkinMeshPrimitive>(mesh); (skin_mesh) && (skin_mesh->deformSkinnedVertices()))
+    {
+        auto [ts, skin_res] = findSkinnedMesh(skin_mesh, ray, std::move(cache));
+        for (float ray_t : ts)
+        {
+            float t = ray_t / dir_length;
+            records.emplace_back(IntrPrimitiveRay3::ResultRecord(t, t * point_ray.direction() + point_ray.origin(), mesh));
+        }
+        return { records, std::move(skin_res) };
+    }
     IntrGeometryRay3 intr_geo(mesh->getGeometryData(), ray);
     auto res = intr_geo.find(std::move(cache));
     if (res.m_hasIntersect)
@@ -92,3 +112,82 @@ std::tuple<std::vector<IntrPrimitiveRay3::ResultRecord>, Intersector::Result> Me
     }
     return { records, Intersector::Result(res.m_hasIntersect, std::move(res.m_cache)) };
 }
+
+Intersector::Result MeshPrimitiveRay3IntersectionFinder::testSkinnedMesh(const std::shared_ptr<SkinMeshPrimitive>& skin_mesh,
+    const Ray3& ray, std::unique_ptr<IntersectorCache> cache) const
+{
+    const BoundingVolume skinned_bound{ skin_mesh->getSkinnedBound() };
+    if (!IntrBVRay3(skinned_bound, ray).test(nullptr).m_hasIntersect) return { false, std::move(cache) };
+    auto tri_list = std::dynamic_pointer_cast<TriangleList>(skin_mesh->getGeometryData());
+    if (!tri_list) return { false, std::move(cache) };
+    const std::vector<Vector3>& positions = skin_mesh->getSkinnedPositions();
+    std::unique_ptr<IntrGeometryCache> geo_cache = nullptr;
+    if (cache) geo_cache = stdext::dynamic_pointer_cast<IntrGeometryCache>(std::move(cache));
+
+    // 變形後 triangle bvh 不能用, 逐一測試; 上次打到的先測
+    const unsigned tri_count = tri_list->getTriangleCount();
+    unsigned vtx_idx[3];
+    Vector3 triangle[3];
+    auto test_triangle = [&](unsigned tri_index)
+        {
+            tri_list->fetchTriangleVertexIndex(tri_index, vtx_idx);
+            if ((vtx_idx[0] >= positions.size()) || (vtx_idx[1] >= positions.size()) || (vtx_idx[2] >= positions.size())) return false;
+            triangle[0] = positions[vtx_idx[0]];
+            triangle[1] = positions[vtx_idx[1]];
+            triangle[2] = positions[vtx_idx[2]];
+            return IntrRay3Triangle3(ray, triangle).test(nullptr).m_hasIntersect;
+        };
+    if ((geo_cache) && (geo_cache->getElementCachedIndex() < tri_count) && (test_triangle(geo_cache->getElementCachedIndex())))
+    {
+        return { true, std::move(geo_cache) };
+    }
+    for (unsigned i = 0; i < tri_count; i++)
+    {
+        if (!test_triangle(i)) continue;
+        if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
+        geo_cache->setElementCachedIndex(i);
+        return { true, std::move(geo_cache) };
+    }
+    return { false, std::move(geo_cache) };
+}
+
+std::tuple<std::vector<float>, Intersector::Result> MeshPrimitiveRay3IntersectionFinder::findSkinnedMesh(
+    const std::shared_ptr<SkinMeshPrimitive>& skin_mesh, const Ray3& ray, std::unique_ptr<IntersectorCache> cache) const
+{
+    std::vector<float> ts;
+    const BoundingVolume skinned_bound{ skin_mesh->getSkinnedBound() };
+    if (!IntrBVRay3(skinned_bound, ray).test(nullptr).m_hasIntersect) return { ts, Intersector::Result(false, std::move(cache)) };
+    auto tri_list = std::dynamic_pointer_cast<TriangleList>(skin_mesh->getGeometryData());
+    if (!tri_list) return { ts, Intersector::Result(false, std::move(cache)) };
+    const std::vector<Vector3>& positions = skin_mesh->getSkinnedPositions();
+    std::unique_ptr<IntrGeometryCache> geo_cache = nullptr;
+    if (cache) geo_cache = stdext::dynamic_pointer_cast<IntrGeometryCache>(std::move(cache));
+
+    const unsigned tri_count = tri_list->getTriangleCount();
+    unsigned vtx_idx[3];
+    Vector3 triangle[3];
+    unsigned hit_index = 0;
+    for (unsigned i = 0; i < tri_count; i++)
+    {
+        tri_list->fetchTriangleVertexIndex(i, vtx_idx);
+        if ((vtx_idx[0] >= positions.size()) || (vtx_idx[1] >= positions.size()) || (vtx_idx[2] >= positions.size())) continue;
+        triangle[0] = positions[vtx_idx[0]];
+        triangle[1] = positions[vtx_idx[1]];
+        triangle[2] = positions[vtx_idx[2]];
+        IntrRay3Triangle3 intr(ray, triangle);
+        if (!intr.find(nullptr).m_hasIntersect) continue;
+        if (intr.getRayT() < 0.0f) continue;
+        ts.emplace_back(intr.getRayT());
+        hit_index = i;
+    }
+    if (ts.empty()) return { ts, Intersector::Result(false, std::move(geo_cache)) };
+    // 沒有 bvh 的由近到遠, 全部找完排序後再截掉
+    std::sort(ts.begin(), ts.end());
+    if ((geo_cache) && (geo_cache->getRequiredResultCount()) && (ts.size() > geo_cache->getRequiredResultCount()))
+    {
+        ts.resize(geo_cache->getRequiredResultCount());
+    }
+    if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
+    geo_cache->setElementCachedIndex(hit_index);
+    return { ts, Intersector::Result(true, std::move(geo_cache)) };
+}
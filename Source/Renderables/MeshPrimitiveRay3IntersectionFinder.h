@@ -16,6 +16,7 @@
 namespace Enigma::Renderables
 {
     class MeshPrimitive;
+    class SkinMeshPrimitive;
 
     class MeshPrimitiveRay3IntersectionFinder : public Primitives::PrimitiveRay3IntersectionFinder
     {
@@ -35,6 +36,10 @@ namespace Enigma::Renderables
         MathLib::Intersector::Result testMesh(const std::shared_ptr<MeshPrimitive>& mesh, const MathLib::Ray3& ray, std::unique_ptr<MathLib::IntersectorCache> cache) const;
         std::tuple<std::vector<Primitives::IntrPrimitiveRay3::ResultRecord>, MathLib::Intersector::Result>
             findMesh(const std::shared_ptr<MeshPrimitive>& mesh, const MathLib::Ray3& ray, std::unique_ptr<MathLib::IntersectorCache> cache) const;
+        /** 開了 cpu skinning 的 skin mesh, 對變形後的 triangle 做測試, ray 已轉到 mesh space */
+        MathLib::Intersector::Result testSkinnedMesh(const std::shared_ptr<SkinMeshPrimitive>& skin_mesh, const MathLib::Ray3& ray, std::unique_ptr<MathLib::IntersectorCache> cache) const;
+        std::tuple<std::vector<float>, MathLib::Intersector::Result>
+            findSkinnedMesh(const std::shared_ptr<SkinMeshPrimitive>& skin_mesh, const MathLib::Ray3& ray, std::unique_ptr<MathLib::IntersectorCache> cache) const;
     };
 }
 
@@ -1,5 +1,6 @@
 ﻿#include "ModelAnimationAsset.h"
 #include "ModelAnimationDtos.h"
+#include "MeshNode.h"
 
 using namespace Enigma::Renderables;
 using namespace Enigma::MathLib;
@@ -27,6 +28,8 @@ ModelAnimationAsset::ModelAnimationAsset(const AnimationAssetId& id, const Gener
 ModelAnimationAsset::~ModelAnimationAsset()
 {
     m_meshNodeKeyArray.clear();
+    m_meshNodeNameIndices.clear();
+    m_treeBindings.clear();
 }
 
 std::shared_ptr<AnimationAsset> ModelAnimationAsset::create(const Animators::AnimationAssetId& id)
@@ -59,11 +62,15 @@ GenericDto ModelAnimationAsset::serializeDto()
 void ModelAnimationAsset::reserveCapacity(unsigned mesh_node_count)
 {
     m_meshNodeKeyArray.reserve(mesh_node_count);
+    m_meshNodeNameIndices.reserve(mesh_node_count);
 }
 
 void ModelAnimationAsset::addMeshNodeTimeSRTData(const std::string& mesh_node_name, const AnimationTimeSRT& srt_data)
 {
     m_meshNodeKeyArray.emplace_back(MeshNodeTimeSRTData(mesh_node_name, srt_data));
+    m_meshNodeNameIndices.emplace(mesh_node_name, static_cast<unsigned>(m_meshNodeKeyArray.size() - 1));
+    std::lock_guard locker{ m_treeBindingLock };
+    m_treeBindings.clear();
 }
 
 Matrix4 ModelAnimationAsset::calculateTransformMatrix(unsigned ani_node_index, float off_time)
@@ -94,13 +101,33 @@ SRTValueTie ModelAnimationAsset::calculateFadedLerpedSRT(unsigned ani_node_index
 
 std::optional<unsigned> ModelAnimationAsset::findMeshNodeIndex(const std::string& node_name)
 {
-    if (m_meshNodeKeyArray.size() == 0) return std::nullopt;
-    unsigned int count = static_cast<unsigned int>(m_meshNodeKeyArray.size());
-    for (unsigned int m = 0; m < count; m++)
+    const auto it = m_meshNodeNameIndices.find(node_name);
+    if (it == m_meshNodeNameIndices.end()) return std::nullopt;
+    return it->second;
+}
+
+std::shared_ptr<const ModelAnimationAsset::MeshNodeChannelMapping> ModelAnimationAsset::bindMeshNodeTree(const std::shared_ptr<const MeshNodeTreeIndex>& tree_index, const std::vector<MeshNode>& mesh_nodes)
+{
+    std::lock_guard locker{ m_treeBindingLock };
+    for (auto iter = m_treeBindings.begin(); iter != m_treeBindings.end();)
+    {
+        const auto bound_index = iter->m_treeIndex.lock();
+        if (!bound_index)
+        {
+            iter = m_treeBindings.erase(iter);
+            continue;
+        }
+        if (bound_index == tree_index) return iter->m_mapping;
+        ++iter;
+    }
+    const unsigned node_count = static_cast<unsigned>(mesh_nodes.size());
+    auto mapping = std::make_shared<MeshNodeChannelMapping>(node_count);
+    for (unsigned m = 0; m < node_count; m++)
     {
-        if (m_meshNodeKeyArray[m].m_meshNodeName == node_name) return m;
+        (*mapping)[m] = findMeshNodeIndex(mesh_nodes[m].getName());
     }
-    return std::nullopt;
+    m_treeBindings.push_back({ tree_index, mapping });
+    return mapping;
 }
 
 float ModelAnimationAsset::getAnimationLengthInSecond()
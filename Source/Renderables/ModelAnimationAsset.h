@@ -13,10 +13,15 @@
 #include "Frameworks/Rtti.h"
 #include <vector>
 #include <optional>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
 
 namespace Enigma::Renderables
 {
     class ModelAnimationAssetDto;
+    class MeshNode;
+    class MeshNodeTreeIndex;
 
     class ModelAnimationAsset : public Animators::AnimationAsset
     {
@@ -31,6 +36,10 @@ namespace Enigma::Renderables
             std::string m_meshNodeName;
             AnimationTimeSRT m_timeSRTData;
         };
+    public:
+        /// index : mesh node index in tree, element : mesh node index in animation asset
+        using MeshNodeChannelMapping = std::vector<std::optional<unsigned>>;
+
     public:
         ModelAnimationAsset(const Animators::AnimationAssetId& id);
         ModelAnimationAsset(const Animators::AnimationAssetId& id, const Engine::GenericDto& dto);
@@ -67,6 +76,10 @@ namespace Enigma::Renderables
         /** find mesh node in data array, return array index */
         std::optional<unsigned> findMeshNodeIndex(const std::string& node_name);
 
+        /** 一個 pass 把 tree 的每個 mesh node 對到 animation 的 node,
+            結果依 tree 的 index 快取, 同一個 model 的 instance 共用 */
+        std::shared_ptr<const MeshNodeChannelMapping> bindMeshNodeTree(const std::shared_ptr<const MeshNodeTreeIndex>& tree_index, const std::vector<MeshNode>& mesh_nodes);
+
         unsigned int getMeshNodeDataCount() const { return static_cast<unsigned int>(m_meshNodeKeyArray.size()); };
 
         /** get animation length (in second) */
@@ -75,8 +88,19 @@ namespace Enigma::Renderables
         /** append Model Animation Asset from src */
         void appendModelAnimationAsset(float offset_time, const std::shared_ptr<ModelAnimationAsset>& src_asset);
 
+    protected:
+        struct MeshNodeTreeBinding
+        {
+            std::weak_ptr<const MeshNodeTreeIndex> m_treeIndex;
+            std::shared_ptr<const MeshNodeChannelMapping> m_mapping;
+        };
+
     protected:
         std::vector<MeshNodeTimeSRTData> m_meshNodeKeyArray;
+        std::unordered_map<std::string, unsigned> m_meshNodeNameIndices;  ///< 同名時保留前面的 node
+
+        std::vector<MeshNodeTreeBinding> m_treeBindings;
+        std::mutex m_treeBindingLock;
     };
 }
 
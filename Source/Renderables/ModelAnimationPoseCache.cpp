@@ -0,0 +1,134 @@
+﻿#include "ModelAnimationPoseCache.h"
+#include "ModelAnimationAsset.h"
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::Renderables;
+using namespace Enigma::MathLib;
+
+ModelAnimationPoseCache::ModelAnimationPoseCache(float time_quantum) : m_timeQuantum(time_quantum)
+{
+    m_frameStamp = -1.0f;
+    m_hitCount = 0;
+    m_missCount = 0;
+}
+
+ModelAnimationPoseCache::~ModelAnimationPoseCache()
+{
+    m_poses.clear();
+}
+
+void ModelAnimationPoseCache::timeQuantum(float quantum)
+{
+    std::lock_guard locker{ m_poseLock };
+    if (m_timeQuantum.load(std::memory_order_relaxed) == quantum) return;
+    m_timeQuantum.store(quantum, std::memory_order_relaxed);
+    m_poses.clear();
+}
+
+void ModelAnimationPoseCache::beginFrame(float frame_stamp)
+{
+    std::lock_guard locker{ m_poseLock };
+    if (m_frameStamp == frame_stamp) return;
+    m_frameStamp = frame_stamp;
+    m_poses.clear();
+}
+
+const ModelAnimationPoseCache::Pose& ModelAnimationPoseCache::queryPose(const std::shared_ptr<ModelAnimationAsset>& asset, float time_value)
+{
+    assert(asset);
+    const float quantum = timeQuantum();
+    assert(quantum > 0.0f);
+    const PoseKey key{ asset.get(), quantum, quantizeTime(time_value, quantum), 0, FadeWeightLevels };
+    return findOrSample(key, [&asset, quantized_time = static_cast<float>(key.m_timeTick) * quantum]()
+        {
+            const unsigned node_count = asset->getMeshNodeDataCount();
+            Pose pose;
+            pose.reserve(node_count);
+            for (unsigned i = 0; i < node_count; i++)
+            {
+                pose.emplace_back(asset->calculateTransformMatrix(i, quantized_time));
+            }
+            return pose;
+        });
+}
+
+const ModelAnimationPoseCache::Pose& ModelAnimationPoseCache::queryFadedPose(const std::shared_ptr<ModelAnimationAsset>& asset,
+    float time_value_a, float time_value_b, float weight_a)
+{
+    assert(asset);
+    const float quantum = timeQuantum();
+    assert(quantum > 0.0f);
+    const int weight_level = static_cast<int>(std::lround(std::clamp(weight_a, 0.0f, 1.0f) * static_cast<float>(FadeWeightLevels)));
+    const PoseKey key{ asset.get(), quantum, quantizeTime(time_value_a, quantum), quantizeTime(time_value_b, quantum), weight_level };
+    const float quantized_time_a = static_cast<float>(key.m_timeTick) * quantum;
+    const float quantized_time_b = static_cast<float>(key.m_fadeInTimeTick) * quantum;
+    const float quantized_weight = static_cast<float>(weight_level) / static_cast<float>(FadeWeightLevels);
+    return findOrSample(key, [&asset, quantized_time_a, quantized_time_b, quantized_weight]()
+        {
+            const unsigned node_count = asset->getMeshNodeDataCount();
+            Pose pose;
+            pose.reserve(node_count);
+            for (unsigned i = 0; i < node_count; i++)
+            {
+                pose.emplace_back(asset->calculateFadedTransformMatrix(i, quantized_time_a, quantized_time_b, quantized_weight));
+            }
+            return pose;
+        });
+}
+
+const ModelAnimationPoseCache::Pose& ModelAnimationPoseCache::findOrSample(const PoseKey& key, const std::function<Pose()>& sampler)
+{
+    {
+        std::lock_guard locker{ m_poseLock };
+        if (const auto it = m_poses.find(key); it != m_poses.end())
+        {
+            m_hitCount++;
+            return it->second;
+        }
+        m_missCount++;
+    }
+    Pose pose = sampler();
+    std::lock_guard locker{ m_poseLock };
+    // unordered_map 的 node 不會因為 rehash 搬動, reference 到下一次 clear 前都有效
+    return m_poses.try_emplace(key, std::move(pose)).first->second;
+}
+
+std::uint64_t ModelAnimationPoseCache::hitCount() const
+{
+    std::lock_guard locker{ m_poseLock };
+    return m_hitCount;
+}
+
+std::uint64_t ModelAnimationPoseCache::missCount() const
+{
+    std::lock_guard locker{ m_poseLock };
+    return m_missCount;
+}
+
+float ModelAnimationPoseCache::hitRate() const
+{
+    std::lock_guard locker{ m_poseLock };
+    const std::uint64_t total = m_hitCount + m_missCount;
+    if (total == 0) return 0.0f;
+    return static_cast<float>(static_cast<double>(m_hitCount) / static_cast<double>(total));
+}
+
+void ModelAnimationPoseCache::resetStatistics()
+{
+    std::lock_guard locker{ m_poseLock };
+    m_hitCount = 0;
+    m_missCount = 0;
+}
+
+unsigned ModelAnimationPoseCache::cachedPoseCount() const
+{
+    std::lock_guard locker{ m_poseLock };
+    return static_cast<unsigned>(m_poses.size());
+}
+
+std::int64_t ModelAnimationPoseCache::quantizeTime(float time_value, float quantum)
+{
+    return static_cast<std::int64_t>(std::llround(time_value / quantum));
+}
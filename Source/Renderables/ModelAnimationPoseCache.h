@@ -0,0 +1,103 @@
+﻿/*********************************************************************
+ * \file   ModelAnimationPoseCache.h
+ * \brief  shared pose cache, entity, use shared_ptr
+ * 同一個 animation asset 在同一個(量化後)時間點的 pose 只算一次,
+ * 後面要同樣 pose 的 animator 直接複製;
+ * animator 可能在不同的 worker thread 上 tick, 所有操作都要 lock
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _MODEL_ANIMATION_POSE_CACHE_H
+#define _MODEL_ANIMATION_POSE_CACHE_H
+
+#include "MathLib/Matrix4.h"
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <functional>
+
+namespace Enigma::Renderables
+{
+    class ModelAnimationAsset;
+
+    class ModelAnimationPoseCache
+    {
+    public:
+        /// local transforms, indexed by mesh node index in animation asset
+        using Pose = std::vector<MathLib::Matrix4>;
+
+        static constexpr int FadeWeightLevels = 64;
+
+    public:
+        ModelAnimationPoseCache(float time_quantum);
+        ModelAnimationPoseCache(const ModelAnimationPoseCache&) = delete;
+        ModelAnimationPoseCache(ModelAnimationPoseCache&&) = delete;
+        ~ModelAnimationPoseCache();
+        ModelAnimationPoseCache& operator=(const ModelAnimationPoseCache&) = delete;
+        ModelAnimationPoseCache& operator=(ModelAnimationPoseCache&&) = delete;
+
+        /** time quantum (in second), <= 0 : cache disabled */
+        float timeQuantum() const { return m_timeQuantum.load(std::memory_order_relaxed); }
+        void timeQuantum(float quantum);
+        bool isEnabled() const { return timeQuantum() > 0.0f; }
+
+        /** frame stamp 不同時清掉上一個 frame 的 pose, 同一個 frame 裡 query 回傳的 reference 都有效 */
+        void beginFrame(float frame_stamp);
+
+        /** sample pose of asset at quantized time */
+        const Pose& queryPose(const std::shared_ptr<ModelAnimationAsset>& asset, float time_value);
+        /** sample faded pose, time & weight are both quantized */
+        const Pose& queryFadedPose(const std::shared_ptr<ModelAnimationAsset>& asset, float time_value_a, float time_value_b, float weight_a);
+
+        std::uint64_t hitCount() const;
+        std::uint64_t missCount() const;
+        /** hit / (hit + miss), 0 if no query */
+        float hitRate() const;
+        void resetStatistics();
+
+        unsigned cachedPoseCount() const;
+
+    protected:
+        struct PoseKey
+        {
+            const ModelAnimationAsset* m_asset;
+            float m_timeQuantum;  ///< query 中途改 quantum 的話, 舊 quantum 的 tick 不會跟新的混在一起
+            std::int64_t m_timeTick;
+            std::int64_t m_fadeInTimeTick;  ///< no fading : 0
+            int m_fadeWeightLevel;  ///< no fading : FadeWeightLevels (weight a = 1)
+
+            bool operator==(const PoseKey& other) const
+            {
+                return m_asset == other.m_asset && m_timeQuantum == other.m_timeQuantum && m_timeTick == other.m_timeTick
+                    && m_fadeInTimeTick == other.m_fadeInTimeTick && m_fadeWeightLevel == other.m_fadeWeightLevel;
+            }
+            class hash
+            {
+            public:
+                size_t operator()(const PoseKey& key) const
+                {
+                    return std::hash<const void*>()(key.m_asset) ^ std::hash<float>()(key.m_timeQuantum) ^ (std::hash<std::int64_t>()(key.m_timeTick) << 1)
+                        ^ (std::hash<std::int64_t>()(key.m_fadeInTimeTick) << 2) ^ (std::hash<int>()(key.m_fadeWeightLevel) << 3);
+                }
+            };
+        };
+
+        static std::int64_t quantizeTime(float time_value, float quantum);
+        /** sample 不持有 lock, 同時算出同一個 key 的話留下先放進去的 */
+        const Pose& findOrSample(const PoseKey& key, const std::function<Pose()>& sampler);
+
+    protected:
+        mutable std::mutex m_poseLock;
+        /// 寫入在 lock 裡 (要跟清 pose 一起), query 不拿 lock 讀, 每次 query 只讀一次
+        std::atomic<float> m_timeQuantum;
+        float m_frameStamp;
+        std::unordered_map<PoseKey, Pose, PoseKey::hash> m_poses;
+        std::uint64_t m_hitCount;
+        std::uint64_t m_missCount;
+    };
+}
+
+#endif // _MODEL_ANIMATION_POSE_CACHE_H
@@ -8,6 +8,7 @@
 #include "ModelPrimitiveAnimator.h"
 #include "Frameworks/EventPublisher.h"
 #include <memory>
+#include <unordered_set>
 
 using namespace Enigma::Renderables;
 using namespace Enigma::Animators;
@@ -31,6 +32,7 @@ ModelPrimitive::ModelPrimitive(const PrimitiveId& id, const GenericDto& dto) : P
     ModelPrimitiveDto primDto(dto);
     m_factoryDesc = primDto.factoryDesc();
     m_nodeTree = MeshNodeTree(primDto.nodeTree());
+    m_nodeTree.shareIndexByModel(id.origin());
     if (primDto.animatorId())
     {
         ModelPrimitive::animatorId(primDto.animatorId().value());
@@ -140,6 +142,11 @@ void ModelPrimitive::updateMeshNodeLocalTransform(unsigned index, const Matrix4&
     m_nodeTree.updateMeshNodeLocalTransform(m_mxPrimitiveWorld, index, mxLocal);
 }
 
+void ModelPrimitive::updateMeshNodeTransforms(const SkeletonEvaluator& skeleton)
+{
+    m_nodeTree.updateMeshNodeTransforms(m_mxPrimitiveWorld, skeleton);
+}
+
 error ModelPrimitive::insertToRendererWithTransformUpdating(const std::shared_ptr<IRenderer>& renderer,
     const Matrix4& mxWorld, const RenderLightingState& lightingState)
 {
@@ -299,3 +306,16 @@ void ModelPrimitive::enumAnimatorListDeep(std::list<std::shared_ptr<Animator>>&
         }
     }
 }
+
+size_t ModelPrimitive::estimatedByteSize() const
+{
+    size_t bytes = sizeof(ModelPrimitive);
+    std::unordered_set<const void*> counted_resources;
+    for (unsigned i = 0; i < m_nodeTree.getMeshNodeCount(); i++)
+    {
+        const auto mesh_prim = m_nodeTree.getMeshPrimitiveInNode(i);
+        if (!mesh_prim) continue;
+        bytes += sizeof(MeshPrimitive) + mesh_prim->estimatedResourceBytes(counted_resources);
+    }
+    return bytes;
+}
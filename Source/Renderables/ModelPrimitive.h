@@ -58,6 +58,7 @@ namespace Enigma::Renderables
         stdext::optional_ref<MeshNode> getCachedMeshNode(unsigned int cached_index);
 
         void updateMeshNodeLocalTransform(unsigned int index, const MathLib::Matrix4& mxLocal);
+        void updateMeshNodeTransforms(const SkeletonEvaluator& skeleton);
 
         /** insert to renderer */
         virtual error insertToRendererWithTransformUpdating(const std::shared_ptr<Engine::IRenderer>& renderer,
@@ -79,6 +80,9 @@ namespace Enigma::Renderables
         /** enum animator list deep, including geometry's animator */
         virtual void enumAnimatorListDeep(std::list<std::shared_ptr<Animators::Animator>>& resultList) override;
 
+        /** 所有 mesh node 上 mesh primitive 的大小, 共用的 geometry / texture 只算一次 */
+        virtual size_t estimatedByteSize() const override;
+
     protected:
         /** sometimes we need re-cache */
         void cacheMeshPrimitive();
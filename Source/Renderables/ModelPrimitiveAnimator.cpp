@@ -4,9 +4,13 @@
 #include "Platforms/PlatformLayer.h"
 #include "Renderables/ModelPrimitive.h"
 #include "ModelAnimationAsset.h"
+#include "ModelAnimationPoseCache.h"
 #include "SkinAnimationOperator.h"
 #include "ModelAnimatorDtos.h"
+#include "RenderableEvents.h"
+#include "Frameworks/EventPublisher.h"
 #include <cassert>
+#include <algorithm>
 
 using namespace Enigma::Renderables;
 using namespace Enigma::Frameworks;
@@ -16,6 +20,8 @@ using namespace Enigma::Animators;
 
 DEFINE_RTTI(Renderables, ModelPrimitiveAnimator, Animator);
 
+std::shared_ptr<ModelAnimationPoseCache> ModelPrimitiveAnimator::m_poseCache = nullptr;
+
 ModelPrimitiveAnimator::ModelPrimitiveAnimator(const AnimatorId& id) : Animator(id)
 {
     m_factoryDesc = FactoryDesc(ModelPrimitiveAnimator::TYPE_RTTI.getName());
@@ -98,6 +104,8 @@ Animator::HasUpdated ModelPrimitiveAnimator::update(const std::unique_ptr<Timer>
     if (FATAL_LOG_EXPR(!timer)) return HasUpdated::False;
     if (!m_isOnPlay) return HasUpdated::False;
 
+    if ((m_poseCache) && (m_poseCache->isEnabled())) m_poseCache->beginFrame(timer->getTotalTime());
+
     const float elapse_time = timer->getElapseTime();
     auto next_to_stop = m_currentAnimClip.update(elapse_time);
 
@@ -126,6 +134,7 @@ void ModelPrimitiveAnimator::onAttachingMeshNodeTree(const Primitives::Primitive
 {
     m_controlledPrimitiveId = model_id;
     calculateMeshNodeMapping(mesh_node_tree);
+    mesh_node_tree.buildSkeleton(m_skeleton);
     for (auto& op : m_skinAnimOperators)
     {
         op.onAttachingMeshNodeTree(mesh_node_tree);
@@ -141,16 +150,13 @@ void ModelPrimitiveAnimator::calculateMeshNodeMapping(const MeshNodeTree& mesh_n
         return;
     }
 
+    std::shared_ptr<const ModelAnimationAsset::MeshNodeChannelMapping> channel_mapping;
+    if (m_animationAsset) channel_mapping = m_animationAsset->bindMeshNodeTree(mesh_node_tree.index(), mesh_node_tree.getMeshNodeArray());
     m_meshNodeMapping.resize(mesh_count);
     for (unsigned int m = 0; m < mesh_count; m++)
     {
         m_meshNodeMapping[m].m_nodeIndexInModel = m;
-        auto mesh_node = mesh_node_tree.getMeshNode(m);
-        if ((m_animationAsset) && (mesh_node))
-        {
-            m_meshNodeMapping[m].m_nodeIndexInAnimation =
-                m_animationAsset->findMeshNodeIndex(mesh_node.value().get().getName());
-        }
+        m_meshNodeMapping[m].m_nodeIndexInAnimation = channel_mapping ? (*channel_mapping)[m] : std::nullopt;
     }
 }
 
@@ -204,17 +210,22 @@ bool ModelPrimitiveAnimator::updateTimeValue()
     }
     const std::shared_ptr<ModelPrimitive> model = cacheControlledModel();
     if (!model) return false;
+    bool has_cpu_skinning = false;
     if (m_skinAnimOperators.size() == 1)
     {
-        m_skinAnimOperators[0].updateSkinMeshBoneMatrix(model->getMeshNodeTree());
+        m_skinAnimOperators[0].updateSkinMeshBoneMatrix(m_skeleton);
+        has_cpu_skinning = m_skinAnimOperators[0].isCpuSkinningEnabled();
     }
     else
     {
         for (auto& op : m_skinAnimOperators)
         {
-            op.updateSkinMeshBoneMatrix(model->getMeshNodeTree());
+            op.updateSkinMeshBoneMatrix(m_skeleton);
+            has_cpu_skinning |= op.isCpuSkinningEnabled();
         }
     }
+    // 變形本身是 lazy 的, 有人要 bound 或 ray 的時候才做
+    if (has_cpu_skinning) EventPublisher::post(std::make_shared<RenderablePrimitiveSkinPoseUpdated>(model->id()));
 
     return true;
 }
@@ -232,7 +243,13 @@ bool ModelPrimitiveAnimator::updateMeshNodeTransformWithFading()
     if (m_remainFadingTime <= 0.0f) fading_weight = 0.0f;
 
     float fadein_time_value = m_fadeInAnimClip.currentTimeValue();
-    const unsigned mesh_count = model->getMeshNodeTree().getMeshNodeCount();
+    const ModelAnimationPoseCache::Pose* cached_pose = nullptr;
+    if ((m_poseCache) && (m_poseCache->isEnabled()))
+    {
+        cached_pose = &m_poseCache->queryFadedPose(m_animationAsset, current_time_value, fadein_time_value, fading_weight);
+    }
+    if (!prepareSkeleton(model->getMeshNodeTree())) return false;
+    const unsigned mesh_count = std::min(model->getMeshNodeTree().getMeshNodeCount(), static_cast<unsigned>(m_meshNodeMapping.size()));
     for (unsigned m = 0; m < mesh_count; m++)
     {
         auto mesh_index = m_meshNodeMapping[m].m_nodeIndexInModel;
@@ -241,16 +258,25 @@ bool ModelPrimitiveAnimator::updateMeshNodeTransformWithFading()
         if (!mesh_node) continue;
         if (auto ani_index = m_meshNodeMapping[m].m_nodeIndexInAnimation)
         {
-            model->updateMeshNodeLocalTransform(mesh_index.value(),
-                m_animationAsset->calculateFadedTransformMatrix
-                (ani_index.value(), current_time_value, fadein_time_value, fading_weight));
+            if (cached_pose)
+            {
+                m_skeleton.setLocalTransform(mesh_index.value(), (*cached_pose)[ani_index.value()]);
+            }
+            else
+            {
+                m_skeleton.setLocalSRT(mesh_index.value(),
+                    m_animationAsset->calculateFadedLerpedSRT
+                    (ani_index.value(), current_time_value, fadein_time_value, fading_weight));
+            }
         }
         else
         {
             // 沒有這個node 的 animation, 用 mesh node 的原始local transform 更新
-            model->updateMeshNodeLocalTransform(mesh_index.value(), mesh_node.value().get().getLocalTransform());
+            m_skeleton.setLocalTransform(mesh_index.value(), mesh_node.value().get().getLocalTransform());
         }
     }
+    m_skeleton.evaluate();
+    model->updateMeshNodeTransforms(m_skeleton);
 
     if (m_remainFadingTime <= 0.0f)
     { // clear fading state
@@ -278,7 +304,13 @@ bool ModelPrimitiveAnimator::updateMeshNodeTransform()
     if (!m_animationAsset) return false;
 
     const float current_time_value = m_currentAnimClip.currentTimeValue();
-    const unsigned mesh_count = model->getMeshNodeTree().getMeshNodeCount();
+    const ModelAnimationPoseCache::Pose* cached_pose = nullptr;
+    if ((m_poseCache) && (m_poseCache->isEnabled()))
+    {
+        cached_pose = &m_poseCache->queryPose(m_animationAsset, current_time_value);
+    }
+    if (!prepareSkeleton(model->getMeshNodeTree())) return false;
+    const unsigned mesh_count = std::min(model->getMeshNodeTree().getMeshNodeCount(), static_cast<unsigned>(m_meshNodeMapping.size()));
     for (unsigned m = 0; m < mesh_count; m++)
     {
         auto mesh_index = m_meshNodeMapping[m].m_nodeIndexInModel;
@@ -287,14 +319,29 @@ bool ModelPrimitiveAnimator::updateMeshNodeTransform()
         if (!mesh_node) continue;
         if (auto ani_index = m_meshNodeMapping[m].m_nodeIndexInAnimation)
         {
-            model->updateMeshNodeLocalTransform(mesh_index.value(),
-                m_animationAsset->calculateTransformMatrix(ani_index.value(), current_time_value));
+            if (cached_pose)
+            {
+                m_skeleton.setLocalTransform(mesh_index.value(), (*cached_pose)[ani_index.value()]);
+            }
+            else
+            {
+                m_skeleton.setLocalSRT(mesh_index.value(), m_animationAsset->calculateLerpedSRT(ani_index.value(), current_time_value));
+            }
         }
         else
         {
             // 沒有這個node 的 animation, 用 mesh node 的原始local transform 更新
-            model->updateMeshNodeLocalTransform(mesh_index.value(), mesh_node.value().get().getLocalTransform());
+            m_skeleton.setLocalTransform(mesh_index.value(), mesh_node.value().get().getLocalTransform());
         }
     }
+    // 一個 pass 算完整棵樹的 root ref transform, 再一次寫回 mesh node
+    m_skeleton.evaluate();
+    model->updateMeshNodeTransforms(m_skeleton);
     return true;
 }
+
+bool ModelPrimitiveAnimator::prepareSkeleton(const MeshNodeTree& mesh_node_tree)
+{
+    if (m_skeleton.nodeCount() == mesh_node_tree.getMeshNodeCount()) return true;
+    return mesh_node_tree.buildSkeleton(m_skeleton);
+}
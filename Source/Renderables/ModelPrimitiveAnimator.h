@@ -14,6 +14,7 @@
 #include "ModelPrimitive.h"
 #include "SkinMeshPrimitive.h"
 #include "SkinAnimationOperator.h"
+#include "SkeletonEvaluator.h"
 #include "MeshNodeTree.h"
 #include <optional>
 #include <memory>
@@ -21,6 +22,7 @@
 namespace Enigma::Renderables
 {
     class ModelAnimationAsset;
+    class ModelAnimationPoseCache;
 
     class ModelPrimitiveAnimator : public Animators::Animator
     {
@@ -58,11 +60,17 @@ namespace Enigma::Renderables
         /** stop animation */
         virtual void stopAnimation();
 
+        /** shared pose cache, animators playing same asset at same quantized time share sampled pose, nullptr : no cache */
+        static void usePoseCache(const std::shared_ptr<ModelAnimationPoseCache>& cache) { m_poseCache = cache; }
+        static const std::shared_ptr<ModelAnimationPoseCache>& poseCache() { return m_poseCache; }
+
     protected:
         bool updateTimeValue();
 
         bool updateMeshNodeTransform();
         bool updateMeshNodeTransformWithFading();
+        /** skeleton 的 node 數與 mesh node tree 不同時重建 */
+        bool prepareSkeleton(const MeshNodeTree& mesh_node_tree);
 
         /** calculate mesh node mapping */
         void calculateMeshNodeMapping(const MeshNodeTree& mesh_node_tree);
@@ -82,6 +90,7 @@ namespace Enigma::Renderables
 
         std::shared_ptr<ModelAnimationAsset> m_animationAsset;
         MeshNodeMappingArray m_meshNodeMapping;
+        SkeletonEvaluator m_skeleton;  ///< node index 與 controlled model 的 mesh node 相同
 
         AnimationClip m_currentAnimClip;
         AnimationClip m_fadeInAnimClip;
@@ -94,6 +103,8 @@ namespace Enigma::Renderables
         bool m_isOnPlay;
 
         std::vector<SkinAnimationOperator> m_skinAnimOperators;
+
+        static std::shared_ptr<ModelAnimationPoseCache> m_poseCache;
     };
 }
 
@@ -37,6 +37,17 @@ namespace Enigma::Renderables
         Primitives::PrimitiveId m_id;
         std::error_code m_error;
     };
+    /** model 中開了 cpu skinning 的 skin mesh 有新的 bone matrix, 要 tight bound 的 pawn 可以重算 bound */
+    class RenderablePrimitiveSkinPoseUpdated : public Frameworks::IEvent
+    {
+    public:
+        RenderablePrimitiveSkinPoseUpdated(const Primitives::PrimitiveId& id)
+            : m_id(id) {};
+        const Primitives::PrimitiveId& id() const { return m_id; }
+
+    protected:
+        Primitives::PrimitiveId m_id;
+    };
 }
 
 #endif // RENDERABLE_EVENTS_H
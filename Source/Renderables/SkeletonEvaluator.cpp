@@ -0,0 +1,151 @@
+﻿#include "SkeletonEvaluator.h"
+#include <cstring>
+
+using namespace Enigma::Renderables;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /** Matrix4::FromSRT(scale, quaternion, translate) 的算式, rotate 是 (w, x, y, z) */
+    void composeSRT(const float* scale, const float* rotate, const float* translate, AffineTransform& t)
+    {
+        const float w = rotate[0];
+        const float x = rotate[1];
+        const float y = rotate[2];
+        const float z = rotate[3];
+        const float tx = 2.0f * x;
+        const float ty = 2.0f * y;
+        const float tz = 2.0f * z;
+        const float twx = tx * w;
+        const float twy = ty * w;
+        const float twz = tz * w;
+        const float txx = tx * x;
+        const float txy = ty * x;
+        const float txz = tz * x;
+        const float tyy = ty * y;
+        const float tyz = tz * y;
+        const float tzz = tz * z;
+
+        t.m[0][0] = scale[0] * (1.0f - (tyy + tzz));
+        t.m[0][1] = scale[1] * (txy - twz);
+        t.m[0][2] = scale[2] * (txz + twy);
+        t.m[0][3] = translate[0];
+        t.m[1][0] = scale[0] * (txy + twz);
+        t.m[1][1] = scale[1] * (1.0f - (txx + tzz));
+        t.m[1][2] = scale[2] * (tyz - twx);
+        t.m[1][3] = translate[1];
+        t.m[2][0] = scale[0] * (txz - twy);
+        t.m[2][1] = scale[1] * (tyz + twx);
+        t.m[2][2] = scale[2] * (1.0f - (txx + tyy));
+        t.m[2][3] = translate[2];
+    }
+}
+
+AffineTransform AffineTransform::fromMatrix(const Matrix4& mx)
+{
+    AffineTransform t;
+    const float* entry = mx;  // row major, 前三列
+    memcpy(t.m, entry, sizeof(t.m));
+    return t;
+}
+
+AffineTransform AffineTransform::fromSRT(const Vector3& scale, const Quaternion& rotate, const Vector3& translate)
+{
+    AffineTransform t;
+    composeSRT(scale, rotate, translate, t);
+    return t;
+}
+
+Matrix4 AffineTransform::toMatrix() const
+{
+    Matrix4 mx = Matrix4::IDENTITY;
+    float* entry = mx;  // row major, 第四列留 identity 的 (0, 0, 0, 1)
+    memcpy(entry, m, sizeof(m));
+    return mx;
+}
+
+bool AffineTransform::isIdentity() const
+{
+    for (unsigned r = 0; r < 3; r++)
+    {
+        for (unsigned c = 0; c < 4; c++)
+        {
+            if (m[r][c] != (r == c ? 1.0f : 0.0f)) return false;
+        }
+    }
+    return true;
+}
+
+void AffineTransform::multiply(const AffineTransform& a, const AffineTransform& b, AffineTransform& out)
+{
+    // 與 Matrix4 乘法同樣的算式與加總順序, 只是不算第四列; b 的第四列 (0, 0, 0, 1) 照樣乘進去,
+    // 每一列都是同樣的 4 個 lane, compiler 可以向量化
+    // b 先整個讀進來, a 的每一列也在寫入前讀完, out 可以是 a 或 b
+    constexpr float last_row[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float bm[3][4];
+    memcpy(bm, b.m, sizeof(bm));
+    for (unsigned r = 0; r < 3; r++)
+    {
+        float am[4];
+        memcpy(am, a.m[r], sizeof(am));
+        for (unsigned c = 0; c < 4; c++)
+        {
+            out.m[r][c] = am[0] * bm[0][c] + am[1] * bm[1][c] + am[2] * bm[2][c] + am[3] * last_row[c];
+        }
+    }
+}
+
+SkeletonEvaluator::SkeletonEvaluator()
+{
+}
+
+bool SkeletonEvaluator::build(const std::vector<std::uint32_t>& parent_indices)
+{
+    clear();
+    for (size_t i = 0; i < parent_indices.size(); i++)
+    {
+        if ((parent_indices[i] != NoParent) && (parent_indices[i] >= i)) return false;
+    }
+    m_parentIndices = parent_indices;
+    m_localTransforms.resize(parent_indices.size(), AffineTransform::fromMatrix(Matrix4::IDENTITY));
+    m_modelTransforms.resize(parent_indices.size());
+    return true;
+}
+
+void SkeletonEvaluator::clear()
+{
+    m_parentIndices.clear();
+    m_localTransforms.clear();
+    m_modelTransforms.clear();
+}
+
+void SkeletonEvaluator::setLocalSRT(unsigned index, const SRTValueTie& srt)
+{
+    if (index >= m_parentIndices.size()) return;
+    // Vector3, Quaternion 的 accessor 不是 inline, 直接拿 raw float 組成 affine
+    auto& [scale, rotate, translate] = srt;
+    composeSRT(scale, rotate, translate, m_localTransforms[index]);
+}
+
+void SkeletonEvaluator::setLocalTransform(unsigned index, const Matrix4& mx)
+{
+    if (index >= m_parentIndices.size()) return;
+    m_localTransforms[index] = AffineTransform::fromMatrix(mx);
+}
+
+void SkeletonEvaluator::evaluate()
+{
+    const size_t count = m_parentIndices.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        const std::uint32_t parent = m_parentIndices[i];
+        if (parent == NoParent)
+        {
+            m_modelTransforms[i] = m_localTransforms[i];
+        }
+        else
+        {
+            AffineTransform::multiply(m_modelTransforms[parent], m_localTransforms[i], m_modelTransforms[i]);
+        }
+    }
+}
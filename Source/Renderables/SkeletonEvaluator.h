@@ -0,0 +1,71 @@
+﻿/*********************************************************************
+ * \file   SkeletonEvaluator.h
+ * \brief  skeleton evaluation, value object, use instance
+ * mesh node tree 攤平成 parent index 陣列 (parent 一定排在 child 前面),
+ * local pose 由 SRT 直接組成 affine, 一個 linear pass 算出所有 node 的 model space (root ref) transform,
+ * 全部用 3x4 affine 運算, 乘法順序與 Matrix4 相同, 結果與逐 node 用 Matrix4 算的一致
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _SKELETON_EVALUATOR_H
+#define _SKELETON_EVALUATOR_H
+
+#include "AnimationTimeSRT.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/Vector3.h"
+#include "MathLib/Quaternion.h"
+#include <vector>
+#include <cstdint>
+
+namespace Enigma::Renderables
+{
+    /** 3x4 affine transform, row major, column vector, 第四列隱含為 (0, 0, 0, 1) */
+    struct AffineTransform
+    {
+        float m[3][4];
+
+        static AffineTransform fromMatrix(const MathLib::Matrix4& mx);
+        /** 與 Matrix4::FromSRT(scale, quaternion, translate) 同樣的算式 */
+        static AffineTransform fromSRT(const MathLib::Vector3& scale, const MathLib::Quaternion& rotate, const MathLib::Vector3& translate);
+        MathLib::Matrix4 toMatrix() const;
+        bool isIdentity() const;
+
+        /** out = a * b, out 可以是 a 或 b */
+        static void multiply(const AffineTransform& a, const AffineTransform& b, AffineTransform& out);
+    };
+
+    class SkeletonEvaluator
+    {
+    public:
+        static constexpr std::uint32_t NoParent = 0xffffffffu;
+
+    public:
+        SkeletonEvaluator();
+
+        /** 由 parent index 陣列建出 skeleton, local pose 先設為 identity; mesh node tree 用 MeshNodeTree::buildSkeleton
+            @return false : 有 node 的 parent 排在它後面, 不能單一 pass 求值 */
+        bool build(const std::vector<std::uint32_t>& parent_indices);
+        void clear();
+
+        unsigned nodeCount() const { return static_cast<unsigned>(m_parentIndices.size()); }
+        const std::vector<std::uint32_t>& parentIndices() const { return m_parentIndices; }
+
+        /** local pose 以 SRT 給進來, 直接組成 affine, 不經過 Matrix4 */
+        void setLocalSRT(unsigned index, const SRTValueTie& srt);
+        void setLocalTransform(unsigned index, const MathLib::Matrix4& mx);
+
+        /** model = parent model * local, 依 parent index 陣列的順序算一遍 */
+        void evaluate();
+
+        const AffineTransform& localTransform(unsigned index) const { return m_localTransforms[index]; }
+        /** transform reference : model root */
+        const AffineTransform& modelTransform(unsigned index) const { return m_modelTransforms[index]; }
+
+    protected:
+        std::vector<std::uint32_t> m_parentIndices;
+        std::vector<AffineTransform> m_localTransforms;
+        std::vector<AffineTransform> m_modelTransforms;
+    };
+}
+
+#endif // _SKELETON_EVALUATOR_H
@@ -2,6 +2,7 @@
 #include "Platforms/PlatformLayer.h"
 #include "Renderables/SkinMeshPrimitive.h"
 #include "ModelAnimatorDtos.h"
+#include <cstring>
 using namespace Enigma::Renderables;
 using namespace Enigma::MathLib;
 
@@ -9,10 +10,14 @@ DEFINE_RTTI_OF_BASE(Renderables, SkinAnimationOperator);
 
 SkinAnimationOperator::SkinAnimationOperator() : m_factoryDesc(SkinAnimationOperator::TYPE_RTTI.getName())
 {
+    m_hasInvOwnerRootRef = false;
+    m_isOwnerRootRefIdentity = false;
 }
 
 SkinAnimationOperator::SkinAnimationOperator(const Engine::GenericDto& dto) : m_factoryDesc(SkinAnimationOperator::TYPE_RTTI.getName())
 {
+    m_hasInvOwnerRootRef = false;
+    m_isOwnerRootRefIdentity = false;
     SkinOperatorDto skin_op_dto(dto);
     m_factoryDesc = skin_op_dto.factoryDesc();
     if (skin_op_dto.skinMeshId())
@@ -33,6 +38,9 @@ SkinAnimationOperator::SkinAnimationOperator(const SkinAnimationOperator& op) :
     m_nodeOffsets = op.m_nodeOffsets;
     m_t_posNodeOffsets = op.m_t_posNodeOffsets;
     m_skinNodeIndexMapping = op.m_skinNodeIndexMapping;
+    m_inverseBindTransforms = op.m_inverseBindTransforms;
+    m_hasInvOwnerRootRef = false;
+    m_isOwnerRootRefIdentity = false;
 }
 
 SkinAnimationOperator::SkinAnimationOperator(SkinAnimationOperator&& op) noexcept : m_factoryDesc(op.m_factoryDesc)
@@ -42,6 +50,9 @@ SkinAnimationOperator::SkinAnimationOperator(SkinAnimationOperator&& op) noexcep
     m_nodeOffsets = std::move(op.m_nodeOffsets);
     m_t_posNodeOffsets = std::move(op.m_t_posNodeOffsets);
     m_skinNodeIndexMapping = std::move(op.m_skinNodeIndexMapping);
+    m_inverseBindTransforms = std::move(op.m_inverseBindTransforms);
+    m_hasInvOwnerRootRef = false;
+    m_isOwnerRootRefIdentity = false;
 }
 
 SkinAnimationOperator::~SkinAnimationOperator()
@@ -57,6 +68,9 @@ SkinAnimationOperator& SkinAnimationOperator::operator=(const SkinAnimationOpera
     m_nodeOffsets = op.m_nodeOffsets;
     m_t_posNodeOffsets = op.m_t_posNodeOffsets;
     m_skinNodeIndexMapping = op.m_skinNodeIndexMapping;
+    m_inverseBindTransforms = op.m_inverseBindTransforms;
+    m_hasInvOwnerRootRef = false;
+    m_isOwnerRootRefIdentity = false;
     return *this;
 }
 
@@ -68,6 +82,9 @@ SkinAnimationOperator& SkinAnimationOperator::operator=(SkinAnimationOperator&&
     m_nodeOffsets = std::move(op.m_nodeOffsets);
     m_t_posNodeOffsets = std::move(op.m_t_posNodeOffsets);
     m_skinNodeIndexMapping = std::move(op.m_skinNodeIndexMapping);
+    m_inverseBindTransforms = std::move(op.m_inverseBindTransforms);
+    m_hasInvOwnerRootRef = false;
+    m_isOwnerRootRefIdentity = false;
     return *this;
 }
 
@@ -95,7 +112,7 @@ void SkinAnimationOperator::updateSkinMeshBoneMatrix(const MeshNodeTree& mesh_no
     if (FATAL_LOG_EXPR(!m_skinNodeIndexMapping.size())) return;
     // mesh prim 的頂點都是相對於 mesh node, but, skin mesh 的 bone, offset 計算都以 root ref 為基礎
     // 是以要將所有bone matrix 都再乘上 inv. ref., 這樣所有變形後的頂點,均是相對於 mesh node
-    Matrix4 mxInvRef = skin_mesh->getOwnerRootRefTransform().Inverse();
+    refreshInvOwnerRootRef(skin_mesh->getOwnerRootRefTransform());
 
     for (unsigned i = 0; i < m_skinNodeIndexMapping.size(); i++)
     {
@@ -103,8 +120,22 @@ void SkinAnimationOperator::updateSkinMeshBoneMatrix(const MeshNodeTree& mesh_no
         if (!node_index) continue;
         auto mesh_node = mesh_node_tree.getMeshNode(node_index.value());
         if (!mesh_node) continue;
-        Matrix4 mx = mxInvRef * mesh_node.value().get().getRootRefTransform() * m_nodeOffsets[i];
-        skin_mesh->updateBoneEffectMatrix(i, mx);
+        updateBoneEffectMatrix(skin_mesh, i, AffineTransform::fromMatrix(mesh_node.value().get().getRootRefTransform()));
+    }
+}
+
+void SkinAnimationOperator::updateSkinMeshBoneMatrix(const SkeletonEvaluator& skeleton)
+{
+    auto skin_mesh = cacheSkinMesh();
+    if (FATAL_LOG_EXPR(skin_mesh == nullptr)) return;
+    if (FATAL_LOG_EXPR(!m_skinNodeIndexMapping.size())) return;
+    refreshInvOwnerRootRef(skin_mesh->getOwnerRootRefTransform());
+
+    for (unsigned i = 0; i < m_skinNodeIndexMapping.size(); i++)
+    {
+        auto node_index = m_skinNodeIndexMapping[i];
+        if ((!node_index) || (node_index.value() >= skeleton.nodeCount())) continue;
+        updateBoneEffectMatrix(skin_mesh, i, skeleton.modelTransform(node_index.value()));
     }
 }
 
@@ -125,9 +156,22 @@ void SkinAnimationOperator::onAttachingMeshNodeTree(const MeshNodeTree& mesh_nod
         if (!node_idx) continue;
         m_nodeOffsets[i] = t_posNodeOffset(i, mesh_node_tree.getMeshNode(node_idx.value()));
     }
+    // node offset 若是 Inverse() 算出來的, 第四列會有誤差 (ex: w = 0.99999994), 轉成 affine 時直接當成 (0, 0, 0, 1)
+    m_inverseBindTransforms.resize(bone_count);
+    for (unsigned int i = 0; i < bone_count; i++)
+    {
+        m_inverseBindTransforms[i] = AffineTransform::fromMatrix(m_nodeOffsets[i]);
+    }
+    m_hasInvOwnerRootRef = false;
     if (cacheSkinMesh()) cacheSkinMesh()->createBoneMatrixArray(bone_count);
 }
 
+bool SkinAnimationOperator::isCpuSkinningEnabled()
+{
+    auto skin_mesh = cacheSkinMesh();
+    return (skin_mesh) && (skin_mesh->isCpuSkinningEnabled());
+}
+
 std::shared_ptr<SkinMeshPrimitive> SkinAnimationOperator::cacheSkinMesh()
 {
     if ((!m_cachedSkinMesh.expired()) && (m_cachedSkinMesh.lock()->id() == m_skinMeshId)) return m_cachedSkinMesh.lock();
@@ -148,3 +192,30 @@ Matrix4 SkinAnimationOperator::t_posNodeOffset(unsigned index, stdext::optional_
     return Matrix4::IDENTITY;
 }
 
+void SkinAnimationOperator::refreshInvOwnerRootRef(const Matrix4& owner_root_ref)
+{
+    const float* owner_entry = owner_root_ref;
+    const float* cached_entry = m_ownerRootRef;
+    if ((m_hasInvOwnerRootRef) && (memcmp(owner_entry, cached_entry, sizeof(float) * 16) == 0)) return;
+    m_ownerRootRef = owner_root_ref;
+    m_invOwnerRootRef = AffineTransform::fromMatrix(owner_root_ref.Inverse());
+    m_isOwnerRootRefIdentity = m_invOwnerRootRef.isIdentity();
+    m_hasInvOwnerRootRef = true;
+}
+
+void SkinAnimationOperator::updateBoneEffectMatrix(const std::shared_ptr<SkinMeshPrimitive>& skin_mesh, unsigned bone_index, const AffineTransform& root_ref)
+{
+    if (bone_index >= m_inverseBindTransforms.size()) return;
+    // bone = inv. owner ref * node root ref * node offset, 乘法順序不變; inv. ref 是 identity 時省掉一次
+    AffineTransform bone;
+    if (m_isOwnerRootRefIdentity)
+    {
+        AffineTransform::multiply(root_ref, m_inverseBindTransforms[bone_index], bone);
+    }
+    else
+    {
+        AffineTransform::multiply(m_invOwnerRootRef, root_ref, bone);
+        AffineTransform::multiply(bone, m_inverseBindTransforms[bone_index], bone);
+    }
+    skin_mesh->updateBoneEffectMatrix(bone_index, bone.toMatrix());
+}
@@ -10,6 +10,7 @@
 
 #include "SkinMeshPrimitive.h"
 #include "ModelPrimitive.h"
+#include "SkeletonEvaluator.h"
 #include "ModelAnimatorDtos.h"
 #include "GameEngine/FactoryDesc.h"
 
@@ -33,12 +34,20 @@ namespace Enigma::Renderables
         Engine::FactoryDesc& factoryDesc() { return m_factoryDesc; }
 
         void updateSkinMeshBoneMatrix(const Renderables::MeshNodeTree& mesh_node_tree);
+        /** skeleton 的 node index 與 mesh node tree 相同 */
+        void updateSkinMeshBoneMatrix(const SkeletonEvaluator& skeleton);
 
         void onAttachingMeshNodeTree(const MeshNodeTree& mesh_node_tree);
 
+        /** skin mesh 是否開了 cpu skinning */
+        bool isCpuSkinningEnabled();
+
     protected:
         std::shared_ptr<Renderables::SkinMeshPrimitive> cacheSkinMesh();
         MathLib::Matrix4 t_posNodeOffset(unsigned index, stdext::optional_ref<const MeshNode> mesh_node);
+        /** owner root ref 有變才重算 inverse */
+        void refreshInvOwnerRootRef(const MathLib::Matrix4& owner_root_ref);
+        void updateBoneEffectMatrix(const std::shared_ptr<SkinMeshPrimitive>& skin_mesh, unsigned bone_index, const AffineTransform& root_ref);
 
     protected:
         Engine::FactoryDesc m_factoryDesc;
@@ -48,6 +57,11 @@ namespace Enigma::Renderables
         std::vector<MathLib::Matrix4> m_nodeOffsets;
         std::vector<MathLib::Matrix4> m_t_posNodeOffsets;
         std::vector<std::optional<unsigned>> m_skinNodeIndexMapping;  ///< index : bone effect matrix index in skin mesh, element : node index in model primitive
+        std::vector<AffineTransform> m_inverseBindTransforms;  ///< node offsets in affine, attach 時算好
+        MathLib::Matrix4 m_ownerRootRef;
+        AffineTransform m_invOwnerRootRef;
+        bool m_hasInvOwnerRootRef;
+        bool m_isOwnerRootRefIdentity;
     };
 }
 
@@ -0,0 +1,285 @@
+﻿#include "SkinMeshDeformer.h"
+#include "MathLib/MathGlobal.h"
+#include <algorithm>
+#include <future>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SKINNING_SIMD_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SKINNING_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace Enigma::Renderables;
+using namespace Enigma::MathLib;
+using namespace Enigma::Geometries;
+
+namespace
+{
+    constexpr unsigned PALETTE_FLOATS_PER_BONE = 16;
+    constexpr unsigned UNUSED_BONE_INDEX = 0xff;
+
+    // 4 floats 的最小 SIMD 操作集合, kernel 只寫一份
+#if defined(SKINNING_SIMD_SSE)
+    using simd4 = __m128;
+    inline simd4 load4(const float* p) { return _mm_loadu_ps(p); }
+    inline simd4 scale4(simd4 v, float s) { return _mm_mul_ps(v, _mm_set1_ps(s)); }
+    inline simd4 madd4(simd4 acc, simd4 v, float s) { return _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(s))); }
+    inline simd4 min4(simd4 a, simd4 b) { return _mm_min_ps(a, b); }
+    inline simd4 max4(simd4 a, simd4 b) { return _mm_max_ps(a, b); }
+    inline simd4 splat4(float s) { return _mm_set1_ps(s); }
+    inline void store4(float* p, simd4 v) { _mm_storeu_ps(p, v); }
+#elif defined(SKINNING_SIMD_NEON)
+    using simd4 = float32x4_t;
+    inline simd4 load4(const float* p) { return vld1q_f32(p); }
+    inline simd4 scale4(simd4 v, float s) { return vmulq_n_f32(v, s); }
+    inline simd4 madd4(simd4 acc, simd4 v, float s) { return vmlaq_n_f32(acc, v, s); }
+    inline simd4 min4(simd4 a, simd4 b) { return vminq_f32(a, b); }
+    inline simd4 max4(simd4 a, simd4 b) { return vmaxq_f32(a, b); }
+    inline simd4 splat4(float s) { return vdupq_n_f32(s); }
+    inline void store4(float* p, simd4 v) { vst1q_f32(p, v); }
+#else
+    struct simd4 { float m_v[4]; };
+    inline simd4 load4(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+    inline simd4 scale4(simd4 v, float s) { return { { v.m_v[0] * s, v.m_v[1] * s, v.m_v[2] * s, v.m_v[3] * s } }; }
+    inline simd4 madd4(simd4 acc, simd4 v, float s)
+    {
+        return { { acc.m_v[0] + v.m_v[0] * s, acc.m_v[1] + v.m_v[1] * s, acc.m_v[2] + v.m_v[2] * s, acc.m_v[3] + v.m_v[3] * s } };
+    }
+    inline simd4 min4(simd4 a, simd4 b)
+    {
+        return { { std::min(a.m_v[0], b.m_v[0]), std::min(a.m_v[1], b.m_v[1]), std::min(a.m_v[2], b.m_v[2]), std::min(a.m_v[3], b.m_v[3]) } };
+    }
+    inline simd4 max4(simd4 a, simd4 b)
+    {
+        return { { std::max(a.m_v[0], b.m_v[0]), std::max(a.m_v[1], b.m_v[1]), std::max(a.m_v[2], b.m_v[2]), std::max(a.m_v[3], b.m_v[3]) } };
+    }
+    inline simd4 splat4(float s) { return { { s, s, s, s } }; }
+    inline void store4(float* p, simd4 v) { p[0] = v.m_v[0]; p[1] = v.m_v[1]; p[2] = v.m_v[2]; p[3] = v.m_v[3]; }
+#endif
+}
+
+SkinMeshDeformer::SkinMeshDeformer() : m_geometry(nullptr), m_positionRevision(0), m_topologyRevision(0), m_isDeformed(false), m_paletteBoneCount(0)
+{
+    m_bound = Box3::UNIT_BOX;
+}
+
+SkinMeshDeformer::~SkinMeshDeformer()
+{
+}
+
+bool SkinMeshDeformer::isSimdEnabled()
+{
+#if defined(SKINNING_SIMD_SSE) || defined(SKINNING_SIMD_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SkinMeshDeformer::bindGeometry(const GeometryDataPtr& geo)
+{
+    if (!geo)
+    {
+        unbindGeometry();
+        return false;
+    }
+    if ((m_geometry == geo.get()) && (m_positionRevision == geo->positionRevision()) && (m_topologyRevision == geo->topologyRevision()))
+    {
+        return isBound();
+    }
+    unbindGeometry();
+    m_geometry = geo.get();
+    m_positionRevision = geo->positionRevision();
+    m_topologyRevision = geo->topologyRevision();
+
+    const Graphics::VertexDescription& desc = geo->vertexDescription();
+    const unsigned vtx_count = geo->getUsedVertexCount();
+    if ((vtx_count == 0) || (!desc.hasBlendWeight()) || (!desc.hasPaletteIndex()) || (desc.positionOffset() < 0)) return false;
+
+    m_sourcePositions = geo->getPosition3Array(vtx_count);
+    if (desc.normalOffset() >= 0) m_sourceNormals = geo->getVertexNormalArray(vtx_count);
+
+    const unsigned weight_count = std::min(static_cast<unsigned>(desc.blendWeightCount()), MaxInfluenceCount);
+    const unsigned stored_weight_count = static_cast<unsigned>(desc.blendWeightCount());
+    // float weight 少於 4 個時, shader 讀到的缺少分量是 vertex fetch 的預設值 (0, 0, 0, 1)
+    const bool fetch_default_w = (desc.blendWeightFormat() == Graphics::VertexDescription::ElementFormat::Float) && (weight_count < MaxInfluenceCount);
+    const std::vector<float> weights = geo->getTotalSkinWeightArray(vtx_count);
+    const std::vector<unsigned> palette_indices = geo->getPaletteIndexArray(vtx_count);
+    m_weights.assign(static_cast<size_t>(vtx_count) * MaxInfluenceCount, 0.0f);
+    m_boneIndices.assign(static_cast<size_t>(vtx_count) * MaxInfluenceCount, 0);
+    for (unsigned i = 0; i < vtx_count; i++)
+    {
+        // palette index 是 4 個 byte 包成一個 uint, 與 shader 相同, 第 1 個以後的 0xff 表示沒有用到
+        for (unsigned j = 0; j < MaxInfluenceCount; j++)
+        {
+            const unsigned bone = (palette_indices[i] >> (j * 8)) & 0xff;
+            if ((j > 0) && (bone == UNUSED_BONE_INDEX)) continue;
+            float weight = 0.0f;
+            if (j < weight_count)
+            {
+                weight = weights[static_cast<size_t>(i) * stored_weight_count + j];
+            }
+            else if ((fetch_default_w) && (j == MaxInfluenceCount - 1))
+            {
+                weight = 1.0f;
+            }
+            m_weights[static_cast<size_t>(i) * MaxInfluenceCount + j] = weight;
+            m_boneIndices[static_cast<size_t>(i) * MaxInfluenceCount + j] = static_cast<std::uint8_t>(bone);
+        }
+    }
+    m_positions.resize(vtx_count);
+    m_normals.resize(m_sourceNormals.size());
+    return true;
+}
+
+void SkinMeshDeformer::unbindGeometry()
+{
+    m_geometry = nullptr;
+    m_positionRevision = 0;
+    m_topologyRevision = 0;
+    m_isDeformed = false;
+    m_sourcePositions.clear();
+    m_sourceNormals.clear();
+    m_weights.clear();
+    m_boneIndices.clear();
+    m_positions.clear();
+    m_normals.clear();
+    m_bound = Box3::UNIT_BOX;
+}
+
+void SkinMeshDeformer::deform(const std::vector<Matrix4>& bone_matrices)
+{
+    if ((!isBound()) || (bone_matrices.empty())) return;
+    preparePalette(bone_matrices);
+
+    const unsigned vtx_count = vertexCount();
+    unsigned job_count = 1;
+    if (vtx_count >= ParallelVertexThreshold)
+    {
+        const unsigned hardware_count = std::max(1u, std::thread::hardware_concurrency());
+        job_count = std::max(1u, std::min(hardware_count, vtx_count / MinVerticesPerJob));
+    }
+    std::vector<Vector3> min_pos(job_count, Vector3(Math::MAX_FLOAT, Math::MAX_FLOAT, Math::MAX_FLOAT));
+    std::vector<Vector3> max_pos(job_count, Vector3(-Math::MAX_FLOAT, -Math::MAX_FLOAT, -Math::MAX_FLOAT));
+    const unsigned vertices_per_job = (vtx_count + job_count - 1) / job_count;
+    std::vector<std::future<void>> jobs;
+    jobs.reserve(job_count - 1);
+    // 第 0 段在呼叫的 thread 上做
+    for (unsigned j = 1; j < job_count; j++)
+    {
+        const unsigned begin = std::min(vtx_count, j * vertices_per_job);
+        const unsigned end = std::min(vtx_count, begin + vertices_per_job);
+        jobs.emplace_back(std::async(std::launch::async, [this, begin, end, &min_pos, &max_pos, j]() { deformRange(begin, end, min_pos[j], max_pos[j]); }));
+    }
+    deformRange(0, std::min(vtx_count, vertices_per_job), min_pos[0], max_pos[0]);
+    for (auto& job : jobs)
+    {
+        job.wait();
+    }
+
+    Vector3 bound_min = min_pos[0];
+    Vector3 bound_max = max_pos[0];
+    for (unsigned j = 1; j < job_count; j++)
+    {
+        bound_min = Vector3(std::min(bound_min.x(), min_pos[j].x()), std::min(bound_min.y(), min_pos[j].y()), std::min(bound_min.z(), min_pos[j].z()));
+        bound_max = Vector3(std::max(bound_max.x(), max_pos[j].x()), std::max(bound_max.y(), max_pos[j].y()), std::max(bound_max.z(), max_pos[j].z()));
+    }
+    const Vector3 half = (bound_max - bound_min) * 0.5f;
+    m_bound = Box3(bound_min + half, Vector3::UNIT_X, Vector3::UNIT_Y, Vector3::UNIT_Z, half.x(), half.y(), half.z());
+    m_isDeformed = true;
+}
+
+void SkinMeshDeformer::preparePalette(const std::vector<Matrix4>& bone_matrices)
+{
+    // 轉成 column, vertex 變形變成 4 個 column 的線性組合, 不用 horizontal add;
+    // 第 4 個分量放 matrix 第 4 列, 與 shader 一樣最後除以 w
+    m_paletteBoneCount = static_cast<unsigned>(std::min(bone_matrices.size(), static_cast<size_t>(UNUSED_BONE_INDEX + 1)));
+    m_palette.resize(static_cast<size_t>(UNUSED_BONE_INDEX + 1) * PALETTE_FLOATS_PER_BONE);
+    for (unsigned b = 0; b < UNUSED_BONE_INDEX + 1; b++)
+    {
+        float* columns = &m_palette[static_cast<size_t>(b) * PALETTE_FLOATS_PER_BONE];
+        if (b >= m_paletteBoneCount)
+        {
+            // 超出 bone 數的 index 當成 zero matrix, 對結果沒有貢獻
+            std::fill(columns, columns + PALETTE_FLOATS_PER_BONE, 0.0f);
+            continue;
+        }
+        const Matrix4& mx = bone_matrices[b];
+        for (int c = 0; c < 4; c++)
+        {
+            columns[c * 4 + 0] = mx(0, c);
+            columns[c * 4 + 1] = mx(1, c);
+            columns[c * 4 + 2] = mx(2, c);
+            columns[c * 4 + 3] = mx(3, c);
+        }
+    }
+}
+
+void SkinMeshDeformer::deformRange(unsigned begin, unsigned end, Vector3& min_pos, Vector3& max_pos)
+{
+    if (begin >= end) return;
+    const float* palette = m_palette.data();
+    const float* weights = m_weights.data();
+    const std::uint8_t* bones = m_boneIndices.data();
+    // Vector3 就是 3 個 float, 直接走 float stream, 不經過 accessor
+    const float* src_positions = reinterpret_cast<const float*>(m_sourcePositions.data());
+    const float* src_normals = m_sourceNormals.empty() ? nullptr : reinterpret_cast<const float*>(m_sourceNormals.data());
+    float* dst_positions = reinterpret_cast<float*>(m_positions.data());
+    float* dst_normals = m_normals.empty() ? nullptr : reinterpret_cast<float*>(m_normals.data());
+    simd4 bound_min = splat4(Math::MAX_FLOAT);
+    simd4 bound_max = splat4(-Math::MAX_FLOAT);
+    alignas(16) float result[4];
+    for (unsigned i = begin; i < end; i++)
+    {
+        const float* w = weights + static_cast<size_t>(i) * MaxInfluenceCount;
+        const std::uint8_t* b = bones + static_cast<size_t>(i) * MaxInfluenceCount;
+        const float* m = palette + static_cast<size_t>(b[0]) * PALETTE_FLOATS_PER_BONE;
+        simd4 c0 = scale4(load4(m), w[0]);
+        simd4 c1 = scale4(load4(m + 4), w[0]);
+        simd4 c2 = scale4(load4(m + 8), w[0]);
+        simd4 c3 = scale4(load4(m + 12), w[0]);
+        for (unsigned j = 1; j < MaxInfluenceCount; j++)
+        {
+            if (w[j] == 0.0f) continue;
+            m = palette + static_cast<size_t>(b[j]) * PALETTE_FLOATS_PER_BONE;
+            c0 = madd4(c0, load4(m), w[j]);
+            c1 = madd4(c1, load4(m + 4), w[j]);
+            c2 = madd4(c2, load4(m + 8), w[j]);
+            c3 = madd4(c3, load4(m + 12), w[j]);
+        }
+        const float* src_pos = src_positions + static_cast<size_t>(i) * 3;
+        simd4 pos = madd4(madd4(madd4(c3, c0, src_pos[0]), c1, src_pos[1]), c2, src_pos[2]);
+        store4(result, pos);
+        // affine bone 且 weight 總和為 1 時 w = 1
+        if ((result[3] != 1.0f) && (result[3] != 0.0f))
+        {
+            const float inv_w = 1.0f / result[3];
+            pos = scale4(pos, inv_w);
+            result[0] *= inv_w;
+            result[1] *= inv_w;
+            result[2] *= inv_w;
+        }
+        bound_min = min4(bound_min, pos);
+        bound_max = max4(bound_max, pos);
+        float* dst_pos = dst_positions + static_cast<size_t>(i) * 3;
+        dst_pos[0] = result[0];
+        dst_pos[1] = result[1];
+        dst_pos[2] = result[2];
+        if (src_normals)
+        {
+            const float* src_nor = src_normals + static_cast<size_t>(i) * 3;
+            const simd4 nor = madd4(madd4(scale4(c0, src_nor[0]), c1, src_nor[1]), c2, src_nor[2]);
+            store4(result, nor);
+            float* dst_nor = dst_normals + static_cast<size_t>(i) * 3;
+            dst_nor[0] = result[0];
+            dst_nor[1] = result[1];
+            dst_nor[2] = result[2];
+        }
+    }
+    store4(result, bound_min);
+    min_pos = Vector3(result[0], result[1], result[2]);
+    store4(result, bound_max);
+    max_pos = Vector3(result[0], result[1], result[2]);
+}
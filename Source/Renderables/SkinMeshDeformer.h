@@ -0,0 +1,89 @@
+﻿/*********************************************************************
+ * \file   SkinMeshDeformer.h
+ * \brief  cpu skinning, 在 cpu 上把 bind pose 的 position / normal 依 bone matrix 變形,
+ *         給 picking, tight bound, server 端 hit 驗證用; 畫面上的 skinning 還是在 shader
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef SKIN_MESH_DEFORMER_H
+#define SKIN_MESH_DEFORMER_H
+
+#include "Geometries/GeometryData.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/Vector3.h"
+#include "MathLib/Box3.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace Enigma::Renderables
+{
+    static_assert(sizeof(MathLib::Vector3) == sizeof(float) * 3, "kernel reads Vector3 array as float stream");
+
+    class SkinMeshDeformer
+    {
+    public:
+        /// 與 shader 相同, 每個 vertex 最多 4 個 influence
+        static constexpr unsigned MaxInfluenceCount = 4;
+        /// vertex 數超過這個值才分給多個 thread
+        static constexpr unsigned ParallelVertexThreshold = 8192;
+        /// 每個 thread 至少分到的 vertex 數
+        static constexpr unsigned MinVerticesPerJob = 4096;
+
+    public:
+        SkinMeshDeformer();
+        SkinMeshDeformer(const SkinMeshDeformer&) = delete;
+        SkinMeshDeformer(SkinMeshDeformer&&) = delete;
+        ~SkinMeshDeformer();
+        SkinMeshDeformer& operator=(const SkinMeshDeformer&) = delete;
+        SkinMeshDeformer& operator=(SkinMeshDeformer&&) = delete;
+
+        /** decode bind pose position, normal, weight, palette index 成 kernel 用的格式,
+            geometry 沒有變動 (revision 相同) 時不重做
+            @return false : geometry 沒有 blend weight 或 palette index */
+        bool bindGeometry(const Geometries::GeometryDataPtr& geo);
+        bool isBound() const { return !m_sourcePositions.empty(); }
+        void unbindGeometry();
+
+        /** 用 bone matrix 變形到 scratch buffer, bone matrix 與送給 shader 的 BoneMatrix 相同 */
+        void deform(const std::vector<MathLib::Matrix4>& bone_matrices);
+        /** bind 之後是否 deform 過, scratch buffer 有沒有效 */
+        bool isDeformed() const { return m_isDeformed; }
+
+        unsigned vertexCount() const { return static_cast<unsigned>(m_sourcePositions.size()); }
+        /** deformed positions, 與 geometry bind pose 同一個空間 */
+        const std::vector<MathLib::Vector3>& positions() const { return m_positions; }
+        /** deformed normals (只用 bone matrix 的 3x3 部分, 不做 normalize); geometry 沒有 normal 時為 empty */
+        const std::vector<MathLib::Vector3>& normals() const { return m_normals; }
+        /** axis aligned bound of deformed positions */
+        const MathLib::Box3& bound() const { return m_bound; }
+
+        /** 是否有 SSE / NEON kernel */
+        static bool isSimdEnabled();
+
+    protected:
+        void preparePalette(const std::vector<MathLib::Matrix4>& bone_matrices);
+        /** deform [begin, end), 回傳這段的 min / max */
+        void deformRange(unsigned begin, unsigned end, MathLib::Vector3& min_pos, MathLib::Vector3& max_pos);
+
+    protected:
+        const Geometries::GeometryData* m_geometry;
+        std::uint64_t m_positionRevision;
+        std::uint64_t m_topologyRevision;
+        bool m_isDeformed;
+
+        std::vector<MathLib::Vector3> m_sourcePositions;
+        std::vector<MathLib::Vector3> m_sourceNormals;
+        std::vector<float> m_weights;  ///< MaxInfluenceCount per vertex, 沒用到的 influence weight = 0
+        std::vector<std::uint8_t> m_boneIndices;  ///< MaxInfluenceCount per vertex
+
+        std::vector<float> m_palette;  ///< 每個 bone 4 個 column (x, y, z, w), column 3 是 translate
+        unsigned m_paletteBoneCount;
+
+        std::vector<MathLib::Vector3> m_positions;
+        std::vector<MathLib::Vector3> m_normals;
+        MathLib::Box3 m_bound;
+    };
+}
+
+#endif // SKIN_MESH_DEFORMER_H
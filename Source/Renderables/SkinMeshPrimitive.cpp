@@ -1,4 +1,5 @@
 ﻿#include "SkinMeshPrimitive.h"
+#include "SkinMeshDeformer.h"
 #include "RenderablePrimitiveDtos.h"
 #include "GameEngine/EffectMaterial.h"
 
@@ -9,16 +10,17 @@ using namespace Enigma::Frameworks;
 using namespace Enigma::Primitives;
 
 const std::string SEMANTIC_BONE_MATRIX = "BoneMatrix";
+static const std::vector<Vector3> EMPTY_VERTICES;
 
 DEFINE_RTTI(Renderables, SkinMeshPrimitive, MeshPrimitive);
 
-SkinMeshPrimitive::SkinMeshPrimitive(const PrimitiveId& id) : MeshPrimitive(id)
+SkinMeshPrimitive::SkinMeshPrimitive(const PrimitiveId& id) : MeshPrimitive(id), m_boneMatrixRevision(0), m_deformedBoneRevision(0)
 {
     m_factoryDesc = FactoryDesc(SkinMeshPrimitive::TYPE_RTTI.getName());
     m_ownerNodeRootRefTransform = Matrix4::IDENTITY;
 }
 
-SkinMeshPrimitive::SkinMeshPrimitive(const PrimitiveId& id, const Engine::GenericDto& dto, const std::shared_ptr<Geometries::GeometryRepository>& geometry_repository) : MeshPrimitive(id, dto, geometry_repository)
+SkinMeshPrimitive::SkinMeshPrimitive(const PrimitiveId& id, const Engine::GenericDto& dto, const std::shared_ptr<Geometries::GeometryRepository>& geometry_repository) : MeshPrimitive(id, dto, geometry_repository), m_boneMatrixRevision(0), m_deformedBoneRevision(0)
 {
     m_factoryDesc = dto.getRtti();
     m_ownerNodeRootRefTransform = Matrix4::IDENTITY;
@@ -64,12 +66,66 @@ void SkinMeshPrimitive::changeEffectMaterialInSegment(unsigned index, const std:
 void SkinMeshPrimitive::createBoneMatrixArray(unsigned size)
 {
     m_boneEffectMatrix.resize(size, Matrix4::IDENTITY);
+    m_boneMatrixRevision++;
 }
 
 void SkinMeshPrimitive::updateBoneEffectMatrix(unsigned idx, const MathLib::Matrix4& ref_mx)
 {
     if (idx >= m_boneEffectMatrix.size()) return;
     m_boneEffectMatrix[idx] = ref_mx;
+    m_boneMatrixRevision++;
+}
+
+void SkinMeshPrimitive::enableCpuSkinning(bool enable)
+{
+    if (enable == isCpuSkinningEnabled()) return;
+    if (enable)
+    {
+        m_cpuSkinning = std::make_unique<SkinMeshDeformer>();
+    }
+    else
+    {
+        m_cpuSkinning = nullptr;
+    }
+}
+
+bool SkinMeshPrimitive::deformSkinnedVertices()
+{
+    if ((!m_cpuSkinning) || (m_boneEffectMatrix.empty())) return false;
+    if (!m_cpuSkinning->bindGeometry(m_geometry)) return false;
+    // geometry 重新 decode 過 (not deformed), 就算 bone 沒變也要重做
+    if ((m_cpuSkinning->isDeformed()) && (m_deformedBoneRevision == m_boneMatrixRevision)) return true;
+    m_cpuSkinning->deform(m_boneEffectMatrix);
+    m_deformedBoneRevision = m_boneMatrixRevision;
+    return true;
+}
+
+const std::vector<Vector3>& SkinMeshPrimitive::getSkinnedPositions() const
+{
+    if (!m_cpuSkinning) return EMPTY_VERTICES;
+    return m_cpuSkinning->positions();
+}
+
+const std::vector<Vector3>& SkinMeshPrimitive::getSkinnedNormals() const
+{
+    if (!m_cpuSkinning) return EMPTY_VERTICES;
+    return m_cpuSkinning->normals();
+}
+
+const Box3& SkinMeshPrimitive::getSkinnedBound() const
+{
+    if (!m_cpuSkinning) return Box3::UNIT_BOX;
+    return m_cpuSkinning->bound();
+}
+
+void SkinMeshPrimitive::calculateBoundingVolume(bool axis_align)
+{
+    if (!deformSkinnedVertices())
+    {
+        MeshPrimitive::calculateBoundingVolume(axis_align);
+        return;
+    }
+    m_bound = BoundingVolume{ m_cpuSkinning->bound() };
 }
 
 void SkinMeshPrimitive::bindPrimitiveBoneMatrix()
@@ -11,10 +11,15 @@
 #include "MeshPrimitive.h"
 #include "MeshNode.h"
 #include "GameEngine/EffectVariable.h"
+#include "MathLib/Box3.h"
 #include <vector>
+#include <memory>
+#include <cstdint>
 
 namespace Enigma::Renderables
 {
+    class SkinMeshDeformer;
+
     class SkinMeshPrimitive : public MeshPrimitive
     {
         DECLARE_EN_RTTI;
@@ -36,6 +41,22 @@ namespace Enigma::Renderables
 
         void createBoneMatrixArray(unsigned int size);
         void updateBoneEffectMatrix(unsigned int idx, const MathLib::Matrix4& ref_mx);
+        const std::vector<MathLib::Matrix4>& getBoneEffectMatrices() const { return m_boneEffectMatrix; }
+
+        /** cpu skinning (picking, tight bound, server 端 hit 驗證用), 預設關閉, 畫面上的 skinning 一律在 shader */
+        void enableCpuSkinning(bool enable);
+        bool isCpuSkinningEnabled() const { return m_cpuSkinning != nullptr; }
+        /** bone matrix 有變動才重新變形
+            @return false : 沒開 cpu skinning, 或 geometry 沒有 skin 資料 */
+        bool deformSkinnedVertices();
+        /** deformed positions, 與 geometry bind pose 同一個空間 (相對於 mesh node) */
+        const std::vector<MathLib::Vector3>& getSkinnedPositions() const;
+        const std::vector<MathLib::Vector3>& getSkinnedNormals() const;
+        /** axis aligned bound of deformed positions */
+        const MathLib::Box3& getSkinnedBound() const;
+
+        /** cpu skinning 開啟時用變形後的 vertex 算 bound (always axis aligned) */
+        virtual void calculateBoundingVolume(bool axis_align) override;
 
         /** bind primitive bone matrix */
         void bindPrimitiveBoneMatrix();
@@ -56,6 +77,10 @@ namespace Enigma::Renderables
             參考基準 node : skin mesh 的 vertex 資料的參考原點
         */
         std::vector<MathLib::Matrix4> m_boneEffectMatrix;
+        std::uint64_t m_boneMatrixRevision;
+
+        std::unique_ptr<SkinMeshDeformer> m_cpuSkinning;
+        std::uint64_t m_deformedBoneRevision;
 
         MathLib::Matrix4 m_ownerNodeRootRefTransform;
     };
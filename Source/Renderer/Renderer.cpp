@@ -3,6 +3,7 @@
 #include "RenderTarget.h"
 #include "SceneGraph/Camera.h"
 #include "GameEngine/MaterialVariableMap.h"
+#include "Platforms/Profiler.h"
 
 using namespace Enigma::Renderer;
 
@@ -130,6 +131,7 @@ error Renderer::prepareScene(const SceneGraph::VisibleSet& visible_set,
 
 error Renderer::drawScene()
 {
+    PROFILE_ZONE("Renderer::drawScene");
     for (size_t i = 0; i < m_renderPacksArray.size(); i++)
     {
         if (!m_renderPacksArray[i].hasElements()) continue;
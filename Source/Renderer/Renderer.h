@@ -94,6 +94,7 @@ namespace Enigma::Renderer
 
         /** associated camera */
         void setAssociatedCamera(const std::shared_ptr<SceneGraph::Camera>& camera);
+        std::shared_ptr<SceneGraph::Camera> associatedCamera() const { return m_associatedCamera.lock(); }
 
         /** we need change the sorting setting sometime */
         void enableSortBeforeDraw(RenderListID list_id, bool flag);
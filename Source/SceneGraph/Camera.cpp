@@ -11,6 +11,7 @@
 #include "Frameworks/QueryDispatcher.h"
 #include "MathLib/Quaternion.h"
 #include <cassert>
+#include <cmath>
 #include <memory>
 
 using namespace Enigma::SceneGraph;
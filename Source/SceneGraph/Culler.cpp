@@ -5,6 +5,7 @@
 #include "Spatial.h"
 #include "Platforms/PlatformLayer.h"
 #include <cassert>
+#include <cmath>
 
 using namespace Enigma::SceneGraph;
 
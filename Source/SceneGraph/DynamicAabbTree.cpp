@@ -0,0 +1,493 @@
+﻿#include "DynamicAabbTree.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+using namespace Enigma::SceneGraph;
+using namespace Enigma::MathLib;
+
+std::optional<DynamicAabbTree::Aabb> DynamicAabbTree::Aabb::fromBoundingVolume(const Engine::BoundingVolume& bv)
+{
+    if (bv.isEmpty()) return std::nullopt;
+    if (auto box = bv.BoundingBox3())
+    {
+        Aabb aabb{ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+        for (const auto& vertex : box->ComputeVertices())
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                aabb.m_min[axis] = std::min(aabb.m_min[axis], vertex[axis]);
+                aabb.m_max[axis] = std::max(aabb.m_max[axis], vertex[axis]);
+            }
+        }
+        return aabb;
+    }
+    if (auto sphere = bv.BoundingSphere3())
+    {
+        const Vector3 center = sphere->Center();
+        const float radius = sphere->Radius();
+        return Aabb{ { center[0] - radius, center[1] - radius, center[2] - radius }, { center[0] + radius, center[1] + radius, center[2] + radius } };
+    }
+    return std::nullopt;
+}
+
+bool DynamicAabbTree::Aabb::contains(const Aabb& other) const
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if ((other.m_min[axis] < m_min[axis]) || (other.m_max[axis] > m_max[axis])) return false;
+    }
+    return true;
+}
+
+bool DynamicAabbTree::Aabb::overlaps(const Aabb& other) const
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if ((other.m_max[axis] < m_min[axis]) || (other.m_min[axis] > m_max[axis])) return false;
+    }
+    return true;
+}
+
+DynamicAabbTree::Aabb DynamicAabbTree::Aabb::merge(const Aabb& other) const
+{
+    Aabb merged;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        merged.m_min[axis] = std::min(m_min[axis], other.m_min[axis]);
+        merged.m_max[axis] = std::max(m_max[axis], other.m_max[axis]);
+    }
+    return merged;
+}
+
+DynamicAabbTree::Aabb DynamicAabbTree::Aabb::expand(float margin) const
+{
+    Aabb expanded;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        expanded.m_min[axis] = m_min[axis] - margin;
+        expanded.m_max[axis] = m_max[axis] + margin;
+    }
+    return expanded;
+}
+
+float DynamicAabbTree::Aabb::surfaceArea() const
+{
+    const float dx = m_max[0] - m_min[0];
+    const float dy = m_max[1] - m_min[1];
+    const float dz = m_max[2] - m_min[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+std::optional<float> DynamicAabbTree::Aabb::rayEnter(const Ray3& ray, float max_t) const
+{
+    const Vector3 origin = ray.origin();
+    const Vector3 direction = ray.direction();
+    float t_enter = 0.0f;
+    float t_exit = max_t;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (std::fabs(direction[axis]) < FLT_EPSILON)
+        {
+            if ((origin[axis] < m_min[axis]) || (origin[axis] > m_max[axis])) return std::nullopt;
+            continue;
+        }
+        const float inv_dir = 1.0f / direction[axis];
+        float t_near = (m_min[axis] - origin[axis]) * inv_dir;
+        float t_far = (m_max[axis] - origin[axis]) * inv_dir;
+        if (t_near > t_far) std::swap(t_near, t_far);
+        t_enter = std::max(t_enter, t_near);
+        t_exit = std::min(t_exit, t_far);
+        if (t_enter > t_exit) return std::nullopt;
+    }
+    return t_enter;
+}
+
+float DynamicAabbTree::Aabb::squaredDistanceTo(const Vector3& point) const
+{
+    float distance = 0.0f;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float v = point[axis];
+        if (v < m_min[axis]) distance += (m_min[axis] - v) * (m_min[axis] - v);
+        else if (v > m_max[axis]) distance += (v - m_max[axis]) * (v - m_max[axis]);
+    }
+    return distance;
+}
+
+DynamicAabbTree::DynamicAabbTree(float fat_margin) : m_fatMargin(fat_margin), m_root(NullProxy), m_freeList(NullProxy), m_proxyCount(0)
+{
+}
+
+DynamicAabbTree::ProxyId DynamicAabbTree::createProxy(const Aabb& box, const SpatialId& id)
+{
+    const ProxyId proxy = allocateNode();
+    m_nodes[proxy].m_box = box.expand(m_fatMargin);
+    m_nodes[proxy].m_spatialId = id;
+    m_nodes[proxy].m_height = 0;
+    insertLeaf(proxy);
+    m_proxyCount++;
+    return proxy;
+}
+
+void DynamicAabbTree::destroyProxy(ProxyId proxy)
+{
+    assert((proxy >= 0) && (proxy < static_cast<ProxyId>(m_nodes.size())) && (m_nodes[proxy].isLeaf()));
+    removeLeaf(proxy);
+    freeNode(proxy);
+    m_proxyCount--;
+}
+
+bool DynamicAabbTree::moveProxy(ProxyId proxy, const Aabb& box)
+{
+    assert((proxy >= 0) && (proxy < static_cast<ProxyId>(m_nodes.size())) && (m_nodes[proxy].isLeaf()));
+    if (m_nodes[proxy].m_box.contains(box)) return false;
+    removeLeaf(proxy);
+    m_nodes[proxy].m_box = box.expand(m_fatMargin);
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::clear()
+{
+    m_nodes.clear();
+    m_root = NullProxy;
+    m_freeList = NullProxy;
+    m_proxyCount = 0;
+}
+
+const SpatialId& DynamicAabbTree::spatialId(ProxyId proxy) const
+{
+    assert((proxy >= 0) && (proxy < static_cast<ProxyId>(m_nodes.size())));
+    return m_nodes[proxy].m_spatialId;
+}
+
+const DynamicAabbTree::Aabb& DynamicAabbTree::fatBox(ProxyId proxy) const
+{
+    assert((proxy >= 0) && (proxy < static_cast<ProxyId>(m_nodes.size())));
+    return m_nodes[proxy].m_box;
+}
+
+int DynamicAabbTree::height() const
+{
+    if (m_root == NullProxy) return 0;
+    return m_nodes[m_root].m_height;
+}
+
+std::vector<DynamicAabbTree::Candidate> DynamicAabbTree::queryRay(const Ray3& ray, float max_distance) const
+{
+    std::vector<Candidate> candidates;
+    if (m_root == NullProxy) return candidates;
+    std::vector<ProxyId> stack{ m_root };
+    while (!stack.empty())
+    {
+        const ProxyId node = stack.back();
+        stack.pop_back();
+        const auto t_enter = m_nodes[node].m_box.rayEnter(ray, max_distance);
+        if (!t_enter) continue;
+        if (m_nodes[node].isLeaf())
+        {
+            candidates.push_back({ node, t_enter.value() });
+            continue;
+        }
+        stack.push_back(m_nodes[node].m_child1);
+        stack.push_back(m_nodes[node].m_child2);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.m_distance < b.m_distance; });
+    return candidates;
+}
+
+std::vector<DynamicAabbTree::ProxyId> DynamicAabbTree::queryPlanes(const std::vector<Plane3>& planes) const
+{
+    std::vector<ProxyId> proxies;
+    if (m_root == NullProxy) return proxies;
+    // 跟 culler 一樣, 整個在某個 plane 正面的 node, 子節點就不用再比對這個 plane
+    using PlaneMask = std::uint32_t;
+    assert(planes.size() <= 32);
+    const PlaneMask all_planes = planes.size() >= 32 ? ~PlaneMask(0) : ((PlaneMask(1) << planes.size()) - 1);
+    std::vector<std::pair<ProxyId, PlaneMask>> stack{ { m_root, all_planes } };
+    while (!stack.empty())
+    {
+        auto [node, active_planes] = stack.back();
+        stack.pop_back();
+        const Aabb& box = m_nodes[node].m_box;
+        bool is_outside = false;
+        for (unsigned i = 0; (i < planes.size()) && (active_planes); i++)
+        {
+            if (!(active_planes & (PlaneMask(1) << i))) continue;
+            const Vector3 normal = planes[i].Normal();
+            float max_distance = -planes[i].Constant();
+            float min_distance = -planes[i].Constant();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const float a = normal[axis] * box.m_min[axis];
+                const float b = normal[axis] * box.m_max[axis];
+                max_distance += std::max(a, b);
+                min_distance += std::min(a, b);
+            }
+            if (max_distance < 0.0f)
+            {
+                is_outside = true;
+                break;
+            }
+            if (min_distance >= 0.0f) active_planes &= ~(PlaneMask(1) << i);
+        }
+        if (is_outside) continue;
+        if (active_planes == 0)
+        {
+            collectLeaves(node, proxies);
+            continue;
+        }
+        if (m_nodes[node].isLeaf())
+        {
+            proxies.push_back(node);
+            continue;
+        }
+        stack.push_back({ m_nodes[node].m_child1, active_planes });
+        stack.push_back({ m_nodes[node].m_child2, active_planes });
+    }
+    return proxies;
+}
+
+std::vector<DynamicAabbTree::Candidate> DynamicAabbTree::querySphere(const Sphere3& sphere) const
+{
+    std::vector<Candidate> candidates;
+    if (m_root == NullProxy) return candidates;
+    const Vector3 center = sphere.Center();
+    const float squared_radius = sphere.Radius() * sphere.Radius();
+    std::vector<ProxyId> stack{ m_root };
+    while (!stack.empty())
+    {
+        const ProxyId node = stack.back();
+        stack.pop_back();
+        const float squared_distance = m_nodes[node].m_box.squaredDistanceTo(center);
+        if (squared_distance > squared_radius) continue;
+        if (m_nodes[node].isLeaf())
+        {
+            candidates.push_back({ node, std::sqrt(squared_distance) });
+            continue;
+        }
+        stack.push_back(m_nodes[node].m_child1);
+        stack.push_back(m_nodes[node].m_child2);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.m_distance < b.m_distance; });
+    return candidates;
+}
+
+std::vector<DynamicAabbTree::ProxyId> DynamicAabbTree::queryBox(const Aabb& box) const
+{
+    std::vector<ProxyId> proxies;
+    if (m_root == NullProxy) return proxies;
+    std::vector<ProxyId> stack{ m_root };
+    while (!stack.empty())
+    {
+        const ProxyId node = stack.back();
+        stack.pop_back();
+        if (!m_nodes[node].m_box.overlaps(box)) continue;
+        if (m_nodes[node].isLeaf())
+        {
+            proxies.push_back(node);
+            continue;
+        }
+        stack.push_back(m_nodes[node].m_child1);
+        stack.push_back(m_nodes[node].m_child2);
+    }
+    return proxies;
+}
+
+DynamicAabbTree::ProxyId DynamicAabbTree::allocateNode()
+{
+    if (m_freeList == NullProxy)
+    {
+        m_nodes.emplace_back();
+        m_freeList = static_cast<ProxyId>(m_nodes.size() - 1);
+        m_nodes[m_freeList].m_parent = NullProxy;
+    }
+    const ProxyId node = m_freeList;
+    m_freeList = m_nodes[node].m_parent;
+    m_nodes[node].m_parent = NullProxy;
+    m_nodes[node].m_child1 = NullProxy;
+    m_nodes[node].m_child2 = NullProxy;
+    m_nodes[node].m_height = 0;
+    m_nodes[node].m_spatialId = SpatialId();
+    return node;
+}
+
+void DynamicAabbTree::freeNode(ProxyId node)
+{
+    m_nodes[node].m_parent = m_freeList;
+    m_nodes[node].m_height = -1;
+    m_nodes[node].m_spatialId = SpatialId();
+    m_freeList = node;
+}
+
+void DynamicAabbTree::insertLeaf(ProxyId leaf)
+{
+    if (m_root == NullProxy)
+    {
+        m_root = leaf;
+        m_nodes[m_root].m_parent = NullProxy;
+        return;
+    }
+
+    // 找 sibling : 合併後的表面積 + 沿路祖先增加的表面積最小
+    const Aabb leaf_box = m_nodes[leaf].m_box;
+    ProxyId index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const ProxyId child1 = m_nodes[index].m_child1;
+        const ProxyId child2 = m_nodes[index].m_child2;
+        const float area = m_nodes[index].m_box.surfaceArea();
+        const float combined_area = m_nodes[index].m_box.merge(leaf_box).surfaceArea();
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - area);
+        auto child_cost = [&](ProxyId child)
+            {
+                const float merged_area = leaf_box.merge(m_nodes[child].m_box).surfaceArea();
+                if (m_nodes[child].isLeaf()) return merged_area + inheritance_cost;
+                return merged_area - m_nodes[child].m_box.surfaceArea() + inheritance_cost;
+            };
+        const float cost1 = child_cost(child1);
+        const float cost2 = child_cost(child2);
+        if ((cost < cost1) && (cost < cost2)) break;
+        index = cost1 < cost2 ? child1 : child2;
+    }
+    const ProxyId sibling = index;
+
+    const ProxyId old_parent = m_nodes[sibling].m_parent;
+    const ProxyId new_parent = allocateNode();
+    m_nodes[new_parent].m_parent = old_parent;
+    m_nodes[new_parent].m_box = leaf_box.merge(m_nodes[sibling].m_box);
+    m_nodes[new_parent].m_height = m_nodes[sibling].m_height + 1;
+    m_nodes[new_parent].m_child1 = sibling;
+    m_nodes[new_parent].m_child2 = leaf;
+    m_nodes[sibling].m_parent = new_parent;
+    m_nodes[leaf].m_parent = new_parent;
+    if (old_parent == NullProxy)
+    {
+        m_root = new_parent;
+    }
+    else if (m_nodes[old_parent].m_child1 == sibling)
+    {
+        m_nodes[old_parent].m_child1 = new_parent;
+    }
+    else
+    {
+        m_nodes[old_parent].m_child2 = new_parent;
+    }
+    refitAncestors(m_nodes[leaf].m_parent);
+}
+
+void DynamicAabbTree::removeLeaf(ProxyId leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NullProxy;
+        return;
+    }
+    const ProxyId parent = m_nodes[leaf].m_parent;
+    const ProxyId grand_parent = m_nodes[parent].m_parent;
+    const ProxyId sibling = m_nodes[parent].m_child1 == leaf ? m_nodes[parent].m_child2 : m_nodes[parent].m_child1;
+    if (grand_parent == NullProxy)
+    {
+        m_root = sibling;
+        m_nodes[sibling].m_parent = NullProxy;
+        freeNode(parent);
+        return;
+    }
+    if (m_nodes[grand_parent].m_child1 == parent)
+    {
+        m_nodes[grand_parent].m_child1 = sibling;
+    }
+    else
+    {
+        m_nodes[grand_parent].m_child2 = sibling;
+    }
+    m_nodes[sibling].m_parent = grand_parent;
+    freeNode(parent);
+    refitAncestors(grand_parent);
+}
+
+void DynamicAabbTree::refitAncestors(ProxyId node)
+{
+    while (node != NullProxy)
+    {
+        node = balance(node);
+        const ProxyId child1 = m_nodes[node].m_child1;
+        const ProxyId child2 = m_nodes[node].m_child2;
+        m_nodes[node].m_height = 1 + std::max(m_nodes[child1].m_height, m_nodes[child2].m_height);
+        m_nodes[node].m_box = m_nodes[child1].m_box.merge(m_nodes[child2].m_box);
+        node = m_nodes[node].m_parent;
+    }
+}
+
+DynamicAabbTree::ProxyId DynamicAabbTree::balance(ProxyId a)
+{
+    // 左右高度差超過 1 時, 把高的子節點轉上來
+    TreeNode& node_a = m_nodes[a];
+    if ((node_a.isLeaf()) || (node_a.m_height < 2)) return a;
+    const ProxyId b = node_a.m_child1;
+    const ProxyId c = node_a.m_child2;
+    const int height_diff = m_nodes[c].m_height - m_nodes[b].m_height;
+    if ((height_diff >= -1) && (height_diff <= 1)) return a;
+
+    const ProxyId up = height_diff > 1 ? c : b;  // 要轉上來的節點
+    const ProxyId stay = height_diff > 1 ? b : c;
+    const ProxyId f = m_nodes[up].m_child1;
+    const ProxyId g = m_nodes[up].m_child2;
+
+    // up 取代 a 的位置, a 變成 up 的子節點
+    m_nodes[up].m_child1 = a;
+    m_nodes[up].m_parent = m_nodes[a].m_parent;
+    m_nodes[a].m_parent = up;
+    if (m_nodes[up].m_parent == NullProxy)
+    {
+        m_root = up;
+    }
+    else if (m_nodes[m_nodes[up].m_parent].m_child1 == a)
+    {
+        m_nodes[m_nodes[up].m_parent].m_child1 = up;
+    }
+    else
+    {
+        m_nodes[m_nodes[up].m_parent].m_child2 = up;
+    }
+
+    // up 比較高的子節點留在 up 下, 另一個給 a
+    const ProxyId keep = m_nodes[f].m_height > m_nodes[g].m_height ? f : g;
+    const ProxyId give = keep == f ? g : f;
+    m_nodes[up].m_child2 = keep;
+    if (height_diff > 1)
+    {
+        m_nodes[a].m_child2 = give;
+    }
+    else
+    {
+        m_nodes[a].m_child1 = give;
+    }
+    m_nodes[give].m_parent = a;
+    m_nodes[a].m_box = m_nodes[stay].m_box.merge(m_nodes[give].m_box);
+    m_nodes[a].m_height = 1 + std::max(m_nodes[stay].m_height, m_nodes[give].m_height);
+    m_nodes[up].m_box = m_nodes[a].m_box.merge(m_nodes[keep].m_box);
+    m_nodes[up].m_height = 1 + std::max(m_nodes[a].m_height, m_nodes[keep].m_height);
+    return up;
+}
+
+void DynamicAabbTree::collectLeaves(ProxyId node, std::vector<ProxyId>& leaves) const
+{
+    std::vector<ProxyId> stack{ node };
+    while (!stack.empty())
+    {
+        const ProxyId index = stack.back();
+        stack.pop_back();
+        if (m_nodes[index].isLeaf())
+        {
+            leaves.push_back(index);
+            continue;
+        }
+        stack.push_back(m_nodes[index].m_child1);
+        stack.push_back(m_nodes[index].m_child2);
+    }
+}
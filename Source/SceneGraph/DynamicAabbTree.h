@@ -0,0 +1,112 @@
+﻿/*********************************************************************
+ * \file   DynamicAabbTree.h
+ * \brief  dynamic AABB tree, broadphase 用的 spatial index, value object
+ *         leaf 存放外擴過 (fat) 的 box, 小幅移動不用重建;
+ *         插入時以表面積成本挑 sibling, 並以旋轉保持平衡
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef DYNAMIC_AABB_TREE_H
+#define DYNAMIC_AABB_TREE_H
+
+#include "SpatialId.h"
+#include "MathLib/Ray3.h"
+#include "MathLib/Plane3.h"
+#include "MathLib/Sphere3.h"
+#include "GameEngine/BoundingVolume.h"
+#include <vector>
+#include <optional>
+
+namespace Enigma::SceneGraph
+{
+    class DynamicAabbTree
+    {
+    public:
+        using ProxyId = int;
+        static constexpr ProxyId NullProxy = -1;
+
+        struct Aabb
+        {
+            float m_min[3];
+            float m_max[3];
+
+            static std::optional<Aabb> fromBoundingVolume(const Engine::BoundingVolume& bv);
+            bool contains(const Aabb& other) const;
+            bool overlaps(const Aabb& other) const;
+            Aabb merge(const Aabb& other) const;
+            Aabb expand(float margin) const;
+            float surfaceArea() const;
+            /** ray 進入 box 的 t, 不相交或超過 max_t 回傳 nullopt */
+            std::optional<float> rayEnter(const MathLib::Ray3& ray, float max_t) const;
+            float squaredDistanceTo(const MathLib::Vector3& point) const;
+        };
+        struct Candidate
+        {
+            ProxyId m_proxy;
+            float m_distance;  ///< ray : 進入 fat box 的 t; sphere : 到 box 的距離
+        };
+
+    public:
+        /** @param fat_margin : leaf box 每邊外擴的距離 */
+        DynamicAabbTree(float fat_margin);
+        DynamicAabbTree(const DynamicAabbTree&) = default;
+        DynamicAabbTree(DynamicAabbTree&&) = default;
+        ~DynamicAabbTree() = default;
+        DynamicAabbTree& operator=(const DynamicAabbTree&) = default;
+        DynamicAabbTree& operator=(DynamicAabbTree&&) = default;
+
+        ProxyId createProxy(const Aabb& box, const SpatialId& id);
+        void destroyProxy(ProxyId proxy);
+        /** box 仍在 fat box 內就不動, 否則拔掉重新插入
+            @return true : 重新插入了 */
+        bool moveProxy(ProxyId proxy, const Aabb& box);
+        void clear();
+
+        const SpatialId& spatialId(ProxyId proxy) const;
+        const Aabb& fatBox(ProxyId proxy) const;
+        unsigned proxyCount() const { return m_proxyCount; }
+        /** leaf 的高度為 0, 空樹為 0 */
+        int height() const;
+
+        /** @name queries, 只比對 fat box */
+        //@{
+        /** 依進入距離由近到遠排序 */
+        std::vector<Candidate> queryRay(const MathLib::Ray3& ray, float max_distance) const;
+        /** 在所有 plane 的正面 (或跨越), 例如 culler 的 frustum planes */
+        std::vector<ProxyId> queryPlanes(const std::vector<MathLib::Plane3>& planes) const;
+        /** 依到球心的距離由近到遠排序 */
+        std::vector<Candidate> querySphere(const MathLib::Sphere3& sphere) const;
+        std::vector<ProxyId> queryBox(const Aabb& box) const;
+        //@}
+
+    protected:
+        struct TreeNode
+        {
+            Aabb m_box;
+            ProxyId m_parent;  ///< free node : 下一個 free node
+            ProxyId m_child1;
+            ProxyId m_child2;
+            int m_height;  ///< leaf : 0, free node : -1
+            SpatialId m_spatialId;
+
+            bool isLeaf() const { return m_child1 == NullProxy; }
+        };
+
+        ProxyId allocateNode();
+        void freeNode(ProxyId node);
+        void insertLeaf(ProxyId leaf);
+        void removeLeaf(ProxyId leaf);
+        ProxyId balance(ProxyId node);
+        void refitAncestors(ProxyId node);
+        void collectLeaves(ProxyId node, std::vector<ProxyId>& leaves) const;
+
+    protected:
+        float m_fatMargin;
+        std::vector<TreeNode> m_nodes;
+        ProxyId m_root;
+        ProxyId m_freeList;
+        unsigned m_proxyCount;
+    };
+}
+
+#endif // DYNAMIC_AABB_TREE_H
@@ -11,6 +11,7 @@
 #include "SceneGraph/SceneGraphQueries.h"
 #include "SceneGraph/SceneGraphCommands.h"
 #include "Frameworks/CommandBus.h"
+#include "Frameworks/menew_make_shared.hpp"
 
 using namespace Enigma::SceneGraph;
 
@@ -189,7 +190,7 @@ error Node::_updateLocalTransform(const MathLib::Matrix4& mxLocal)
 
     if (testNotifyFlag(Notify_Location))
     {
-        Frameworks::EventPublisher::post(std::make_shared<SpatialLocationChanged>(m_id));
+        Frameworks::EventPublisher::post(stdext::make_frame_shared<SpatialLocationChanged>(m_id));
     }
 
     // propagate up
@@ -240,7 +241,7 @@ error Node::_updateBoundData()
 
     if (testNotifyFlag(Notify_Bounding))
     {
-        Frameworks::EventPublisher::post(std::make_shared<SpatialBoundChanged>(m_id));
+        Frameworks::EventPublisher::post(stdext::make_frame_shared<SpatialBoundChanged>(m_id));
     }
 
     error er = ErrorCode::ok;
@@ -269,7 +270,7 @@ error Node::_updateSpatialRenderState()
     }
     if (testNotifyFlag(Notify_RenderState))
     {
-        Frameworks::EventPublisher::post(std::make_shared<SpatialRenderStateChanged>(m_id));
+        Frameworks::EventPublisher::post(stdext::make_frame_shared<SpatialRenderStateChanged>(m_id));
     }
     return er;
 }
@@ -4,6 +4,7 @@
 #include "SceneGraphFactory.h"
 #include "LazyNodeHydrationService.h"
 #include "LightInfoTraversal.h"
+#include "SpatialIndexService.h"
 #include "SceneGraphErrors.h"
 #include "Pawn.h"
 #include "Node.h"
@@ -32,6 +33,7 @@ error SceneGraphInstallingPolicy::install(Frameworks::ServiceManager* service_ma
     service_manager->registerSystemService(scene_graph_repository);
     service_manager->registerSystemService(std::make_shared<LazyNodeHydrationService>(service_manager, scene_graph_repository, timer));
     service_manager->registerSystemService(std::make_shared<LightInfoTraversal>(service_manager));
+    service_manager->registerSystemService(std::make_shared<SpatialIndexService>(service_manager, SpatialIndexService::DefaultFatMargin));
     return ErrorCode::ok;
 }
 
@@ -41,5 +43,6 @@ error SceneGraphInstallingPolicy::shutdown(Frameworks::ServiceManager* service_m
     service_manager->shutdownSystemService(SceneGraph::LazyNodeHydrationService::TYPE_RTTI);
     service_manager->shutdownSystemService(SceneGraph::SceneGraphRepository::TYPE_RTTI);
     service_manager->shutdownSystemService(SceneGraph::LightInfoTraversal::TYPE_RTTI);
+    service_manager->shutdownSystemService(SceneGraph::SpatialIndexService::TYPE_RTTI);
     return ErrorCode::ok;
 }
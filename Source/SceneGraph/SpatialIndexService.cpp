@@ -0,0 +1,331 @@
+﻿#include "SpatialIndexService.h"
+#include "Frameworks/EventPublisher.h"
+#include "SceneGraphEvents.h"
+#include "Spatial.h"
+#include "Node.h"
+#include "Pawn.h"
+
+using namespace Enigma::SceneGraph;
+using namespace Enigma::Frameworks;
+using namespace Enigma::MathLib;
+
+DEFINE_RTTI(SceneGraph, SpatialIndexService, ISystemService);
+
+SpatialIndexService::SpatialIndexService(Frameworks::ServiceManager* mngr, float fat_margin) : ISystemService(mngr), m_tree(fat_margin)
+{
+    m_needTick = false;
+    registerHandlers();
+}
+
+SpatialIndexService::~SpatialIndexService()
+{
+    unregisterHandlers();
+}
+
+ServiceResult SpatialIndexService::onInit()
+{
+    return ServiceResult::Complete;
+}
+
+ServiceResult SpatialIndexService::onTick()
+{
+    std::lock_guard locker{ m_indexLock };
+    flushDirtySpatials();
+    m_needTick = false;
+    return ServiceResult::Pendding;
+}
+
+ServiceResult SpatialIndexService::onTerm()
+{
+    std::lock_guard locker{ m_indexLock };
+    m_tree.clear();
+    m_pawns.clear();
+    m_unboundedPawns.clear();
+    m_dirtySpatials.clear();
+    m_expiredPawns.clear();
+    return ServiceResult::Complete;
+}
+
+void SpatialIndexService::registerHandlers()
+{
+    m_onSceneGraphChanged = std::make_shared<EventSubscriber>([=](auto e) { onSceneGraphChanged(e); });
+    EventPublisher::subscribe(typeid(SceneGraphChanged), m_onSceneGraphChanged);
+    m_onSpatialBoundChanged = std::make_shared<EventSubscriber>([=](auto e) { onSpatialBoundChanged(e); });
+    EventPublisher::subscribe(typeid(SpatialBoundChanged), m_onSpatialBoundChanged);
+    m_onSpatialLocationChanged = std::make_shared<EventSubscriber>([=](auto e) { onSpatialLocationChanged(e); });
+    EventPublisher::subscribe(typeid(SpatialLocationChanged), m_onSpatialLocationChanged);
+}
+
+void SpatialIndexService::unregisterHandlers()
+{
+    EventPublisher::unsubscribe(typeid(SceneGraphChanged), m_onSceneGraphChanged);
+    m_onSceneGraphChanged = nullptr;
+    EventPublisher::unsubscribe(typeid(SpatialBoundChanged), m_onSpatialBoundChanged);
+    m_onSpatialBoundChanged = nullptr;
+    EventPublisher::unsubscribe(typeid(SpatialLocationChanged), m_onSpatialLocationChanged);
+    m_onSpatialLocationChanged = nullptr;
+}
+
+void SpatialIndexService::indexSceneGraph(const std::shared_ptr<Spatial>& root)
+{
+    if (!root) return;
+    std::lock_guard locker{ m_indexLock };
+    insertSubtree(root);
+}
+
+void SpatialIndexService::unindexSceneGraph(const std::shared_ptr<Spatial>& root)
+{
+    if (!root) return;
+    std::lock_guard locker{ m_indexLock };
+    removeSubtree(root);
+}
+
+std::vector<SpatialIndexService::Candidate> SpatialIndexService::queryRay(const Ray3& ray, float max_distance)
+{
+    std::lock_guard locker{ m_indexLock };
+    flushDirtySpatials();
+    std::vector<Candidate> candidates;
+    for (const auto& proxy_candidate : m_tree.queryRay(ray, max_distance))
+    {
+        if (auto pawn = candidatePawn(proxy_candidate.m_proxy)) candidates.push_back({ pawn, proxy_candidate.m_distance });
+    }
+    removeExpiredPawns();
+    return candidates;
+}
+
+std::vector<std::shared_ptr<Pawn>> SpatialIndexService::queryFrustum(const std::vector<Plane3>& planes)
+{
+    std::lock_guard locker{ m_indexLock };
+    flushDirtySpatials();
+    std::vector<std::shared_ptr<Pawn>> pawns;
+    for (const auto proxy : m_tree.queryPlanes(planes))
+    {
+        if (auto pawn = candidatePawn(proxy)) pawns.push_back(pawn);
+    }
+    removeExpiredPawns();
+    return pawns;
+}
+
+std::vector<SpatialIndexService::Candidate> SpatialIndexService::querySphere(const Sphere3& sphere)
+{
+    std::lock_guard locker{ m_indexLock };
+    flushDirtySpatials();
+    std::vector<Candidate> candidates;
+    for (const auto& proxy_candidate : m_tree.querySphere(sphere))
+    {
+        if (auto pawn = candidatePawn(proxy_candidate.m_proxy)) candidates.push_back({ pawn, proxy_candidate.m_distance });
+    }
+    removeExpiredPawns();
+    return candidates;
+}
+
+std::vector<std::shared_ptr<Pawn>> SpatialIndexService::queryBox(const Box3& box)
+{
+    std::vector<std::shared_ptr<Pawn>> pawns;
+    const auto aabb = DynamicAabbTree::Aabb::fromBoundingVolume(Engine::BoundingVolume(box));
+    if (!aabb) return pawns;
+    std::lock_guard locker{ m_indexLock };
+    flushDirtySpatials();
+    for (const auto proxy : m_tree.queryBox(aabb.value()))
+    {
+        if (auto pawn = candidatePawn(proxy)) pawns.push_back(pawn);
+    }
+    removeExpiredPawns();
+    return pawns;
+}
+
+unsigned SpatialIndexService::indexedPawnCount()
+{
+    std::lock_guard locker{ m_indexLock };
+    return m_tree.proxyCount();
+}
+
+int SpatialIndexService::treeHeight()
+{
+    std::lock_guard locker{ m_indexLock };
+    return m_tree.height();
+}
+
+void SpatialIndexService::onSceneGraphChanged(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SceneGraphChanged, IEvent>(e);
+    if (!ev) return;
+    if (ev->childId().empty()) return;
+    std::lock_guard locker{ m_indexLock };
+    if (ev->notifyCode() == SceneGraphChanged::NotifyCode::AttachChild)
+    {
+        insertSubtree(Spatial::querySpatial(ev->childId()));
+    }
+    else if (ev->notifyCode() == SceneGraphChanged::NotifyCode::DetachChild)
+    {
+        // detach 後 child 可能已經不在 repository 中, 單一 pawn 直接以 id 移除
+        if (auto child = Spatial::querySpatial(ev->childId()))
+        {
+            removeSubtree(child);
+        }
+        else
+        {
+            removePawn(ev->childId());
+        }
+    }
+}
+
+void SpatialIndexService::onSpatialBoundChanged(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SpatialBoundChanged, IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_indexLock };
+    // node 的 bound 變化是子節點往上傳遞的, 只處理已在 index 中, 或是等 bound 才能加入的 pawn
+    if ((m_pawns.find(ev->id()) == m_pawns.end()) && (m_unboundedPawns.find(ev->id()) == m_unboundedPawns.end())) return;
+    m_dirtySpatials.insert(ev->id());
+    m_needTick = true;
+}
+
+void SpatialIndexService::onSpatialLocationChanged(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SpatialLocationChanged, IEvent>(e);
+    if (!ev) return;
+    // location changed 只由改變 local transform 的 spatial 發出, 子樹跟著移動
+    std::lock_guard locker{ m_indexLock };
+    m_dirtySpatials.insert(ev->id());
+    m_needTick = true;
+}
+
+void SpatialIndexService::insertSubtree(const std::shared_ptr<Spatial>& spatial)
+{
+    if (!spatial) return;
+    if (auto pawn = std::dynamic_pointer_cast<Pawn>(spatial))
+    {
+        if (m_pawns.find(pawn->id()) != m_pawns.end())
+        {
+            refitPawn(pawn);
+        }
+        else if (auto box = DynamicAabbTree::Aabb::fromBoundingVolume(pawn->getWorldBound()))
+        {
+            m_pawns.insert_or_assign(pawn->id(), IndexedPawn{ m_tree.createProxy(box.value(), pawn->id()), pawn });
+            m_unboundedPawns.erase(pawn->id());
+        }
+        else
+        {
+            m_unboundedPawns.insert_or_assign(pawn->id(), pawn);
+        }
+    }
+    if (auto node = std::dynamic_pointer_cast<Node>(spatial))
+    {
+        for (const auto& child : node->getChildList())
+        {
+            insertSubtree(child);
+        }
+    }
+}
+
+void SpatialIndexService::removeSubtree(const std::shared_ptr<Spatial>& spatial)
+{
+    if (!spatial) return;
+    removePawn(spatial->id());
+    if (auto node = std::dynamic_pointer_cast<Node>(spatial))
+    {
+        for (const auto& child : node->getChildList())
+        {
+            removeSubtree(child);
+        }
+    }
+}
+
+void SpatialIndexService::removePawn(const SpatialId& id)
+{
+    m_unboundedPawns.erase(id);
+    auto it = m_pawns.find(id);
+    if (it == m_pawns.end()) return;
+    m_tree.destroyProxy(it->second.m_proxy);
+    m_pawns.erase(it);
+}
+
+void SpatialIndexService::refitSubtree(const std::shared_ptr<Spatial>& spatial)
+{
+    if (!spatial) return;
+    if (auto pawn = std::dynamic_pointer_cast<Pawn>(spatial))
+    {
+        if (m_pawns.find(pawn->id()) != m_pawns.end()) refitPawn(pawn);
+    }
+    if (auto node = std::dynamic_pointer_cast<Node>(spatial))
+    {
+        for (const auto& child : node->getChildList())
+        {
+            refitSubtree(child);
+        }
+    }
+}
+
+void SpatialIndexService::refitPawn(const std::shared_ptr<Pawn>& pawn)
+{
+    auto it = m_pawns.find(pawn->id());
+    if (it == m_pawns.end()) return;
+    if (auto box = DynamicAabbTree::Aabb::fromBoundingVolume(pawn->getWorldBound()))
+    {
+        m_tree.moveProxy(it->second.m_proxy, box.value());
+        return;
+    }
+    // world bound 變成空的, 先移出 tree, 等 bound changed 之後再重新加入
+    m_tree.destroyProxy(it->second.m_proxy);
+    m_pawns.erase(it);
+    m_unboundedPawns.insert_or_assign(pawn->id(), pawn);
+}
+
+void SpatialIndexService::flushDirtySpatials()
+{
+    if (m_dirtySpatials.empty()) return;
+    for (const auto& id : m_dirtySpatials)
+    {
+        if (auto it = m_pawns.find(id); it != m_pawns.end())
+        {
+            if (auto pawn = it->second.m_pawn.lock())
+            {
+                refitPawn(pawn);
+            }
+            else
+            {
+                m_expiredPawns.push_back(id);
+            }
+            continue;
+        }
+        if (auto it = m_unboundedPawns.find(id); it != m_unboundedPawns.end())
+        {
+            if (auto pawn = it->second.lock())
+            {
+                insertSubtree(pawn);
+            }
+            else
+            {
+                m_unboundedPawns.erase(it);
+            }
+            continue;
+        }
+        if (!id.rtti().isDerived(Node::TYPE_RTTI)) continue;
+        refitSubtree(Spatial::querySpatial(id));
+    }
+    m_dirtySpatials.clear();
+    removeExpiredPawns();
+}
+
+std::shared_ptr<Pawn> SpatialIndexService::candidatePawn(DynamicAabbTree::ProxyId proxy)
+{
+    const SpatialId& id = m_tree.spatialId(proxy);
+    auto it = m_pawns.find(id);
+    if (it == m_pawns.end()) return nullptr;
+    auto pawn = it->second.m_pawn.lock();
+    if (!pawn) m_expiredPawns.push_back(id);
+    return pawn;
+}
+
+void SpatialIndexService::removeExpiredPawns()
+{
+    for (const auto& id : m_expiredPawns)
+    {
+        removePawn(id);
+    }
+    m_expiredPawns.clear();
+}
@@ -0,0 +1,108 @@
+﻿/*********************************************************************
+ * \file   SpatialIndexService.h
+ * \brief  scene 中 pawn 的 broadphase index (dynamic AABB tree),
+ *         picking 或 gameplay 的區域查詢先拿到少量候選 pawn, 再做細部測試
+ *         跟著 attach/detach, bound/location changed 事件同步
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef SPATIAL_INDEX_SERVICE_H
+#define SPATIAL_INDEX_SERVICE_H
+
+#include "Frameworks/SystemService.h"
+#include "Frameworks/EventSubscriber.h"
+#include "DynamicAabbTree.h"
+#include "SpatialId.h"
+#include "MathLib/Box3.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Enigma::SceneGraph
+{
+    class Spatial;
+    class Pawn;
+
+    class SpatialIndexService : public Frameworks::ISystemService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        struct Candidate
+        {
+            std::shared_ptr<Pawn> m_pawn;
+            float m_distance;  ///< ray : 進入 bound 的 t; sphere : 到 bound 的距離
+        };
+        static constexpr float DefaultFatMargin = 0.1f;
+
+    public:
+        SpatialIndexService(Frameworks::ServiceManager* mngr, float fat_margin);
+        SpatialIndexService(const SpatialIndexService&) = delete;
+        SpatialIndexService(SpatialIndexService&&) = delete;
+        virtual ~SpatialIndexService() override;
+        SpatialIndexService& operator=(const SpatialIndexService&) = delete;
+        SpatialIndexService& operator=(SpatialIndexService&&) = delete;
+
+        virtual Frameworks::ServiceResult onInit() override;
+        virtual Frameworks::ServiceResult onTick() override;
+        virtual Frameworks::ServiceResult onTerm() override;
+
+        /** 加入 root 子樹中的 pawn; attach 事件之前就組好的 scene graph 要先呼叫一次 */
+        void indexSceneGraph(const std::shared_ptr<Spatial>& root);
+        void unindexSceneGraph(const std::shared_ptr<Spatial>& root);
+
+        /** @name broadphase queries, 以 world bound 比對, 只回傳候選 pawn */
+        //@{
+        /** 依進入距離由近到遠排序 */
+        std::vector<Candidate> queryRay(const MathLib::Ray3& ray, float max_distance);
+        /** 在所有 plane 正面或跨越 plane 的 pawn, 例如 culler 的 clip planes */
+        std::vector<std::shared_ptr<Pawn>> queryFrustum(const std::vector<MathLib::Plane3>& planes);
+        /** 依到球心的距離由近到遠排序 */
+        std::vector<Candidate> querySphere(const MathLib::Sphere3& sphere);
+        std::vector<std::shared_ptr<Pawn>> queryBox(const MathLib::Box3& box);
+        //@}
+
+        unsigned indexedPawnCount();
+        int treeHeight();
+
+    private:
+        void registerHandlers();
+        void unregisterHandlers();
+
+        void onSceneGraphChanged(const Frameworks::IEventPtr& e);
+        void onSpatialBoundChanged(const Frameworks::IEventPtr& e);
+        void onSpatialLocationChanged(const Frameworks::IEventPtr& e);
+
+        void insertSubtree(const std::shared_ptr<Spatial>& spatial);
+        void removeSubtree(const std::shared_ptr<Spatial>& spatial);
+        void removePawn(const SpatialId& id);
+        void refitSubtree(const std::shared_ptr<Spatial>& spatial);
+        void refitPawn(const std::shared_ptr<Pawn>& pawn);
+        void flushDirtySpatials();
+        std::shared_ptr<Pawn> candidatePawn(DynamicAabbTree::ProxyId proxy);
+        void removeExpiredPawns();
+
+    private:
+        struct IndexedPawn
+        {
+            DynamicAabbTree::ProxyId m_proxy;
+            std::weak_ptr<Pawn> m_pawn;
+        };
+
+        DynamicAabbTree m_tree;
+        std::unordered_map<SpatialId, IndexedPawn, SpatialId::hash> m_pawns;
+        /// 加入時 world bound 還是空的 pawn, 等 bound changed 之後再放進 tree
+        std::unordered_map<SpatialId, std::weak_ptr<Pawn>, SpatialId::hash> m_unboundedPawns;
+        /// location 改變的 spatial, 整個子樹的 world bound 都要重新 fit
+        std::unordered_set<SpatialId, SpatialId::hash> m_dirtySpatials;
+        std::vector<SpatialId> m_expiredPawns;
+        std::recursive_mutex m_indexLock;
+
+        Frameworks::EventSubscriberPtr m_onSceneGraphChanged;
+        Frameworks::EventSubscriberPtr m_onSpatialBoundChanged;
+        Frameworks::EventSubscriberPtr m_onSpatialLocationChanged;
+    };
+}
+
+#endif // SPATIAL_INDEX_SERVICE_H
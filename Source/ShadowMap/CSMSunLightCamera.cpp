@@ -5,6 +5,8 @@
 #include "SceneGraph/Frustum.h"
 #include "MathLib/TrianglePlaneClipper.h"
 #include "Frameworks/StringFormat.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace Enigma::ShadowMap;
 using namespace Enigma::SceneGraph;
@@ -211,7 +213,7 @@ std::array<Vector3, 8> CSMSunLightCamera::calcViewerFrustumCorner(unsigned frust
     float viewerFar = m_adjustedViewerFarPlane;
 
     float frustaIDM = static_cast<float>(frustaIndex + 1) / static_cast<float>(m_partitionCount);
-    float frustaLog = viewerNear * std::powf(viewerFar / viewerNear, frustaIDM);
+    float frustaLog = viewerNear * std::pow(viewerFar / viewerNear, frustaIDM);
     float frustaUniform = viewerNear + (viewerFar - viewerNear) * frustaIDM;
 
     float frustaNear = viewerNear;
@@ -293,40 +295,78 @@ void CSMSunLightCamera::calcSceneCropMatrix(const Engine::BoundingVolume& sceneW
     // https://github.com/GKR/NvidiaCascadedShadowMapsGLM
     for (unsigned int frusta = 0; frusta < m_partitionCount; frusta++)
     {
-        Matrix4 mxLightViewProj = m_lightFrustums[frusta].projectionTransform() * m_mxLightViewTransforms[frusta];
-
-        BoundingVolume cropBound = Engine::BoundingVolume::CreateFromTransform(sceneWorldBound, mxLightViewProj);
-        auto cropBox = cropBound.BoundingBox3();
-        if (!cropBox) return;
-        const auto vecCropBox = cropBox->ComputeVertices();
-        assert(vecCropBox.size() == 8);
-        Vector3 vecMin = vecCropBox[0];
-        Vector3 vecMax = vecCropBox[0];
+        if (!calcFrustaCropMatrix(frusta, sceneWorldBound)) return;
+    }
+}
+
+bool CSMSunLightCamera::calcFrustaCropMatrix(unsigned frustaIndex, const Engine::BoundingVolume& cropWorldBound)
+{
+    assert(frustaIndex < m_partitionCount);
+    Matrix4 mxLightViewProj = m_lightFrustums[frustaIndex].projectionTransform() * m_mxLightViewTransforms[frustaIndex];
+
+    BoundingVolume cropBound = Engine::BoundingVolume::CreateFromTransform(cropWorldBound, mxLightViewProj);
+    auto cropBox = cropBound.BoundingBox3();
+    if (!cropBox) return false;
+    const auto vecCropBox = cropBox->ComputeVertices();
+    assert(vecCropBox.size() == 8);
+    Vector3 vecMin = vecCropBox[0];
+    Vector3 vecMax = vecCropBox[0];
+    for (unsigned int i = 1; i < 8; i++)
+    {
+        vecMin = Math::MinVectorComponent(vecMin, vecCropBox[i]);
+        vecMax = Math::MaxVectorComponent(vecMax, vecCropBox[i]);
+    }
+    //vecMin = Math::MaxVectorComponent(vecMin, Vector3(-1.0f, -1.0f, 0.0f));
+    //vecMax = Math::MinVectorComponent(vecMax, Vector3(1.0f, 1.0f, 1.0f));
+    //DebugPrintf("frusta %d, vecMin %f, %f, %f, vecMax %f, %f, %f\n", frusta, vecMin.x(), vecMin.y(), vecMin.z(),
+    //    vecMax.x(), vecMax.y(), vecMax.z());
+    //vecMin.z() = 0.0f;
+    float scaleX, scaleY; // , scaleZ;
+    float offsetX, offsetY; // , offsetZ;
+    scaleX = 2.0f / (vecMax.x() - vecMin.x());
+    scaleY = 2.0f / (vecMax.y() - vecMin.y());
+    //scaleZ = 1.0f / (vecMax.z() - vecMin.z());
+    offsetX = -0.5f * (vecMax.x() + vecMin.x()) * scaleX;
+    offsetY = -0.5f * (vecMax.y() + vecMin.y()) * scaleY;
+    //offsetZ = -vecMin.z() * scaleZ;
+    m_mxSceneCrops[frustaIndex] = Matrix4(scaleX, 0.0f, 0.0f, offsetX,
+        0.0f, scaleY, 0.0f, offsetY,
+        0.0f, 0.0f, 1.0f, 0.0f, //scaleZ, offsetZ,
+        0.0f, 0.0f, 0.0f, 1.0f);
+    m_mxProjSceneCrops[frustaIndex] = m_mxSceneCrops[frustaIndex] * m_lightFrustums[frustaIndex].projectionTransform();
+    m_mxLightViewProjs[frustaIndex] = m_mxProjSceneCrops[frustaIndex] * m_mxLightViewTransforms[frustaIndex];
+    return true;
+}
+
+void CSMSunLightCamera::fitLightFrustaToCasters(const std::vector<Engine::BoundingVolume>& caster_bounds)
+{
+    const std::array<Vector3, 3> vecLightFrustumAxis = calcLightCameraFrame();
+    const unsigned count = std::min(m_partitionCount, static_cast<unsigned>(caster_bounds.size()));
+    for (unsigned frusta = 0; frusta < count; frusta++)
+    {
+        if (caster_bounds[frusta].isEmpty()) continue;
+        // 在光源後方 (near plane 之前) 的 caster 也要畫進 shadow map, light camera 往後退
+        BoundingVolume boundInLight = Engine::BoundingVolume::CreateFromTransform(caster_bounds[frusta], m_mxLightViewTransforms[frusta]);
+        auto boxInLight = boundInLight.BoundingBox3();
+        if (!boxInLight) continue;
+        const auto vecBoxInLight = boxInLight->ComputeVertices();
+        float casterNearZ = vecBoxInLight[0].z();
         for (unsigned int i = 1; i < 8; i++)
         {
-            vecMin = Math::MinVectorComponent(vecMin, vecCropBox[i]);
-            vecMax = Math::MaxVectorComponent(vecMax, vecCropBox[i]);
+            casterNearZ = std::min(casterNearZ, vecBoxInLight[i].z());
         }
-        //vecMin = Math::MaxVectorComponent(vecMin, Vector3(-1.0f, -1.0f, 0.0f));
-        //vecMax = Math::MinVectorComponent(vecMax, Vector3(1.0f, 1.0f, 1.0f));
-        //DebugPrintf("frusta %d, vecMin %f, %f, %f, vecMax %f, %f, %f\n", frusta, vecMin.x(), vecMin.y(), vecMin.z(),
-        //    vecMax.x(), vecMax.y(), vecMax.z());
-        //vecMin.z() = 0.0f;
-        float scaleX, scaleY; // , scaleZ;
-        float offsetX, offsetY; // , offsetZ;
-        scaleX = 2.0f / (vecMax.x() - vecMin.x());
-        scaleY = 2.0f / (vecMax.y() - vecMin.y());
-        //scaleZ = 1.0f / (vecMax.z() - vecMin.z());
-        offsetX = -0.5f * (vecMax.x() + vecMin.x()) * scaleX;
-        offsetY = -0.5f * (vecMax.y() + vecMin.y()) * scaleY;
-        //offsetZ = -vecMin.z() * scaleZ;
-        m_mxSceneCrops[frusta] = Matrix4(scaleX, 0.0f, 0.0f, offsetX,
-            0.0f, scaleY, 0.0f, offsetY,
-            0.0f, 0.0f, 1.0f, 0.0f, //scaleZ, offsetZ,
-            0.0f, 0.0f, 0.0f, 1.0f);
-        m_mxProjSceneCrops[frusta] = m_mxSceneCrops[frusta] * m_lightFrustums[frusta].projectionTransform();
-        m_mxLightViewProjs[frusta] = m_mxProjSceneCrops[frusta] * m_mxLightViewTransforms[frusta];
+        const float nearZ = m_lightFrustums[frusta].nearPlaneZ();
+        if (casterNearZ < nearZ)
+        {
+            const float moveBack = nearZ - casterNearZ + 0.2f;  // add some bias
+            setLightCameraViewTransform(frusta, m_vecLightCameraLocations[frusta] - moveBack * vecLightFrustumAxis[2],
+                vecLightFrustumAxis[2], vecLightFrustumAxis[1], vecLightFrustumAxis[0]);
+            m_lightFrustums[frusta] = Frustum::fromOrtho(m_handSys, m_lightFrustums[frusta].nearWidth(), m_lightFrustums[frusta].nearHeight(),
+                nearZ, m_lightFrustums[frusta].farPlaneZ() + moveBack);
+        }
+        calcFrustaCropMatrix(frusta, caster_bounds[frusta]);
     }
+    refreshTextureCoordTransform();
 }
 
 const Matrix4& CSMSunLightCamera::getLightViewTransform(unsigned int index) const
@@ -347,6 +387,12 @@ const Vector3& CSMSunLightCamera::getLightCameraLocation(unsigned int index) con
     return m_vecLightCameraLocations[index];
 }
 
+const Frustum& CSMSunLightCamera::getLightFrustum(unsigned int index) const
+{
+    assert(index < m_partitionCount);
+    return m_lightFrustums[index];
+}
+
 Vector4 CSMSunLightCamera::lightFrustaDistanceToVector4() const
 {
     Vector4 vecLightFrustaDistance = Vector4::ZERO;
@@ -36,6 +36,15 @@ namespace Enigma::ShadowMap
         const MathLib::Matrix4& getLightViewTransform(unsigned int index) const;
         const MathLib::Matrix4& getLightProjectionTransform(unsigned int index) const;
         const MathLib::Vector3& getLightCameraLocation(unsigned int index) const;
+        /** 未做 crop 的 light frustum (ortho) */
+        const SceneGraph::Frustum& getLightFrustum(unsigned int index) const;
+        /** light camera 的座標軸 [right, up, dir], 所有 partition 共用 */
+        std::array<MathLib::Vector3, 3> calcLightCameraFrame() const;
+        const MathLib::Vector3& getSunLightDir() const { return m_sunLightDir; }
+
+        /** 依各 partition 的 caster bound (light space culling 的結果) 調整 light frustum,
+            光源往後退到包含所有 caster, 再以 caster bound 做 crop; empty bound 的 partition 不調整 */
+        void fitLightFrustaToCasters(const std::vector<Engine::BoundingVolume>& caster_bounds);
 
         const std::vector<MathLib::Matrix4>& getLightViewProjectionTransforms() const { return m_mxLightViewProjs; };
         const std::vector<float>& getLightFrustaDistances() const { return m_lightFrustaDistances; };
@@ -45,12 +54,12 @@ namespace Enigma::ShadowMap
     protected:
         void calcSceneBoundFrustumPlane(SceneGraph::Culler* sceneCuller, const Engine::BoundingVolume& sceneWorldBound);
         void calcLightCameraFrustum();
-        std::array<MathLib::Vector3, 3> calcLightCameraFrame() const;
         std::array<MathLib::Vector3, 8> calcViewerFrustumCorner(unsigned frustaIndex);
         void setLightCameraViewTransform(unsigned frustaIndex, const MathLib::Vector3& eye, const MathLib::Vector3& dir,
             const MathLib::Vector3& up, const MathLib::Vector3& right);
         void refreshTextureCoordTransform();
         void calcSceneCropMatrix(const Engine::BoundingVolume& sceneWorldBound);
+        bool calcFrustaCropMatrix(unsigned frustaIndex, const Engine::BoundingVolume& cropWorldBound);
 
     private:
         unsigned m_partitionCount;
@@ -4,13 +4,16 @@
 #include "CSMSunLightCamera.h"
 #include "GameEngine/MaterialVariableMap.h"
 #include "GraphicKernel/IGraphicAPI.h"
+#include "Renderer/RenderElement.h"
+#include "SceneGraph/Pawn.h"
+#include <algorithm>
 
 using namespace Enigma::ShadowMap;
 using namespace Enigma::Renderer;
 using namespace Enigma::Engine;
 using namespace Enigma::MathLib;
 
-CascadeShadowMapRenderer::CascadeShadowMapRenderer(const std::string& name) : Renderer(name)
+CascadeShadowMapRenderer::CascadeShadowMapRenderer(const std::string& name) : Renderer(name), m_insertingCascade(NoInsertingCascade)
 {
 }
 
@@ -18,6 +21,76 @@ CascadeShadowMapRenderer::~CascadeShadowMapRenderer()
 {
 }
 
+error CascadeShadowMapRenderer::insertRenderElement(const std::shared_ptr<RenderElement>& element, const MathLib::Matrix4& mxWorld,
+    const RenderLightingState& lighting, RenderListID list_id)
+{
+    if (m_insertingCascade == NoInsertingCascade) return Renderer::insertRenderElement(element, mxWorld, lighting, list_id);
+    assert(element);
+    assert(m_insertingCascade < m_cascadeRenderPacks.size());
+    // cascade list 每個 frame 重建, 不需要 renderer stamp 的 dated 機制
+    m_cascadeRenderPacks[m_insertingCascade][static_cast<size_t>(list_id)].emplace_back(element, mxWorld, lighting);
+    return ErrorCode::ok;
+}
+
+error CascadeShadowMapRenderer::removeRenderElement(const std::shared_ptr<RenderElement>& element, RenderListID list_id)
+{
+    for (auto& cascade_packs : m_cascadeRenderPacks)
+    {
+        auto& packs = cascade_packs[static_cast<size_t>(list_id)];
+        packs.erase(std::remove_if(packs.begin(), packs.end(),
+            [&](const RenderPack& p) -> bool { return p.getRenderElement() == element; }), packs.end());
+    }
+    return Renderer::removeRenderElement(element, list_id);
+}
+
+void CascadeShadowMapRenderer::clearCascadeCasters(unsigned cascade_count)
+{
+    if (m_cascadeRenderPacks.empty()) flushAll();  // 改用 cascade list 之前留在共用 list 中的 element 不會再畫
+    m_cascadeRenderPacks.resize(cascade_count);
+    for (auto& cascade_packs : m_cascadeRenderPacks)
+    {
+        for (auto& packs : cascade_packs)
+        {
+            packs.clear();
+        }
+    }
+}
+
+error CascadeShadowMapRenderer::insertCascadeCaster(unsigned cascade, const std::shared_ptr<SceneGraph::Pawn>& caster)
+{
+    assert(caster);
+    if (cascade >= m_cascadeRenderPacks.size()) return ErrorCode::ok;
+    m_insertingCascade = cascade;
+    const error er = caster->insertToRenderer(shared_from_this());
+    m_insertingCascade = NoInsertingCascade;
+    return er;
+}
+
+unsigned CascadeShadowMapRenderer::cascadeRenderPackCount(unsigned cascade) const
+{
+    if (cascade >= m_cascadeRenderPacks.size()) return 0;
+    size_t count = 0;
+    for (const auto& packs : m_cascadeRenderPacks[cascade])
+    {
+        count += packs.size();
+    }
+    return static_cast<unsigned>(count);
+}
+
+error CascadeShadowMapRenderer::drawCascadeCasters(unsigned cascade)
+{
+    if (cascade >= m_cascadeRenderPacks.size()) return ErrorCode::ok;
+    for (const auto& packs : m_cascadeRenderPacks[cascade])
+    {
+        for (const auto& pack : packs)
+        {
+            error er_draw = pack.getRenderElement()->draw(pack.getWorldTransform(), pack.getRenderLightingState(), m_rendererTechniqueName);
+            LOG_IF(Error, er_draw.value() != 0);
+        }
+    }
+    return ErrorCode::ok;
+}
+
 error CascadeShadowMapRenderer::drawScene()
 {
     if (LOG_IF(Warnning, ((m_targetViewPorts.empty()) || (m_sunLightCamera.expired())))) return ErrorCode::ok;
@@ -33,7 +106,11 @@ error CascadeShadowMapRenderer::drawScene()
         MaterialVariableMap::useCameraParameter(m_sunLightCamera.lock()->getLightCameraLocation(pipeline),
             m_sunLightCamera.lock()->getLightViewTransform(pipeline),
             m_sunLightCamera.lock()->getLightProjectionTransform(pipeline));
-        if (pipeline == 0) // first, remove dated element
+        if (hasCascadeCasterLists())
+        {
+            if (error er = drawCascadeCasters(pipeline)) return er;
+        }
+        else if (pipeline == 0) // first, remove dated element
         {
             for (unsigned int i = 0; i < m_renderPacksArray.size(); i++)
             {
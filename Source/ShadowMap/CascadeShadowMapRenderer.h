@@ -10,7 +10,14 @@
 
 #include "GraphicKernel/TargetViewPort.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/RenderPack.h"
+#include <vector>
+#include <limits>
 
+namespace Enigma::SceneGraph
+{
+    class Pawn;
+}
 namespace Enigma::ShadowMap
 {
     class CSMSunLightCamera;
@@ -30,11 +37,33 @@ namespace Enigma::ShadowMap
         void setRenderTargetViewPorts(const std::vector<Graphics::TargetViewPort>& view_ports);
         void setSunLightCamera(const std::shared_ptr<CSMSunLightCamera>& sun_light_camera);
 
+        virtual error insertRenderElement(const std::shared_ptr<Enigma::Renderer::RenderElement>& element, const MathLib::Matrix4& mxWorld,
+            const Engine::RenderLightingState& lighting, RenderListID list_id) override;
+        virtual error removeRenderElement(const std::shared_ptr<Enigma::Renderer::RenderElement>& element, RenderListID list_id) override;
+
+        /** @name per cascade caster list
+            light space culling 的結果, 每個 cascade 只畫自己的 caster, 每個 frame 重建 */
+        //@{
+        void clearCascadeCasters(unsigned cascade_count);
+        error insertCascadeCaster(unsigned cascade, const std::shared_ptr<SceneGraph::Pawn>& caster);
+        bool hasCascadeCasterLists() const { return !m_cascadeRenderPacks.empty(); }
+        unsigned cascadeRenderPackCount(unsigned cascade) const;
+        //@}
+
         virtual error drawScene() override;
 
     protected:
+        error drawCascadeCasters(unsigned cascade);
+
+    protected:
+        static constexpr unsigned NoInsertingCascade = std::numeric_limits<unsigned>::max();
+        using CascadeRenderPacks = std::array<std::vector<Enigma::Renderer::RenderPack>, static_cast<size_t>(RenderListID::Count)>;
+
         std::vector<Graphics::TargetViewPort> m_targetViewPorts;
         std::weak_ptr<CSMSunLightCamera> m_sunLightCamera;
+
+        std::vector<CascadeRenderPacks> m_cascadeRenderPacks;
+        unsigned m_insertingCascade;
     };
 }
 
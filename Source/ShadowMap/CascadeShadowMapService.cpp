@@ -4,6 +4,8 @@
 #include "GraphicKernel/GraphicCommands.h"
 #include "Frameworks/CommandBus.h"
 #include "SceneGraph/Light.h"
+#include "SceneGraph/SceneGraphEvents.h"
+#include "Frameworks/EventPublisher.h"
 #include "GameCommon/GameCameraService.h"
 #include "GameEngine/MaterialVariableMap.h"
 
@@ -33,6 +35,7 @@ CascadeShadowMapService::~CascadeShadowMapService()
 ServiceResult CascadeShadowMapService::onInit()
 {
     subscribeEvents();
+    subscribeCasterEvents();
     Engine::MaterialVariableMap::insertAutoVariableFunctionToMap(m_configuration->shadowMapDimensionSemantic(), assignShadowMapDimension);
     Engine::MaterialVariableMap::insertAutoVariableFunctionToMap(m_configuration->lightViewProjSemantic(), assignLightViewProjectionTransforms);
     Engine::MaterialVariableMap::insertAutoVariableFunctionToMap(m_configuration->cascadeDistanceSemantic(), assignCascadeDistances);
@@ -46,6 +49,9 @@ ServiceResult CascadeShadowMapService::onTick()
     if ((!m_sceneService.expired()) && (m_sunLightCamera))
     {
         m_sunLightCamera->calcLightCameraSystemMatrix(m_sceneService.lock()->getSceneCuller());
+        // caster 以 light frustum 另外 cull, 不限於 viewer 看得到的; 再依結果調整 light frustum
+        m_casterCuller.cullCasters(m_sceneService.lock()->getSceneRoot(), *m_sunLightCamera);
+        m_sunLightCamera->fitLightFrustaToCasters(m_casterCuller.cascadeCasterBounds());
         m_cascadeLightViewProjections = m_sunLightCamera->getLightViewProjectionTransforms();
         m_cascadeDistances = m_sunLightCamera->lightFrustaDistanceToVector4();
         m_cascadeTextureCoordTransforms = m_sunLightCamera->getTextureCoordTransforms();
@@ -56,10 +62,31 @@ ServiceResult CascadeShadowMapService::onTick()
 ServiceResult CascadeShadowMapService::onTerm()
 {
     m_sunLightCamera = nullptr;
+    m_casterCuller.clear();
+    unsubscribeCasterEvents();
     unsubscribeEvents();
     return ServiceResult::Complete;
 }
 
+void CascadeShadowMapService::prepareShadowScene()
+{
+    if (m_renderer.expired()) return;
+    const auto rendererCSM = std::dynamic_pointer_cast<CascadeShadowMapRenderer, Renderer::Renderer>(m_renderer.lock());
+    if (!rendererCSM)
+    {
+        ShadowMapService::prepareShadowScene();
+        return;
+    }
+    rendererCSM->clearCascadeCasters(m_casterCuller.cascadeCount());
+    for (unsigned cascade = 0; cascade < m_casterCuller.cascadeCount(); cascade++)
+    {
+        for (const auto& caster : m_casterCuller.cascadeCasters(cascade))
+        {
+            rendererCSM->insertCascadeCaster(cascade, caster);
+        }
+    }
+}
+
 void CascadeShadowMapService::createShadowRenderSystem(const std::string& renderer_name, const std::string& target_name)
 {
     assert(!m_rendererManager.expired());
@@ -110,6 +137,58 @@ void CascadeShadowMapService::destroyShadowRenderSystem(const std::string& rende
     m_rendererManager.lock()->destroyRenderer(renderer_name);
 }
 
+void CascadeShadowMapService::subscribeCasterEvents()
+{
+    m_onSceneGraphChanged = std::make_shared<EventSubscriber>([=](auto e) { onSceneGraphChanged(e); });
+    EventPublisher::subscribe(typeid(SceneGraph::SceneGraphChanged), m_onSceneGraphChanged);
+    m_onSpatialBoundChanged = std::make_shared<EventSubscriber>([=](auto e) { onSpatialBoundChanged(e); });
+    EventPublisher::subscribe(typeid(SceneGraph::SpatialBoundChanged), m_onSpatialBoundChanged);
+    m_onSpatialLocationChanged = std::make_shared<EventSubscriber>([=](auto e) { onSpatialLocationChanged(e); });
+    EventPublisher::subscribe(typeid(SceneGraph::SpatialLocationChanged), m_onSpatialLocationChanged);
+    m_onSpatialVisibilityChanged = std::make_shared<EventSubscriber>([=](auto e) { onSpatialVisibilityChanged(e); });
+    EventPublisher::subscribe(typeid(SceneGraph::SpatialVisibilityChanged), m_onSpatialVisibilityChanged);
+}
+
+void CascadeShadowMapService::unsubscribeCasterEvents()
+{
+    EventPublisher::unsubscribe(typeid(SceneGraph::SceneGraphChanged), m_onSceneGraphChanged);
+    m_onSceneGraphChanged = nullptr;
+    EventPublisher::unsubscribe(typeid(SceneGraph::SpatialBoundChanged), m_onSpatialBoundChanged);
+    m_onSpatialBoundChanged = nullptr;
+    EventPublisher::unsubscribe(typeid(SceneGraph::SpatialLocationChanged), m_onSpatialLocationChanged);
+    m_onSpatialLocationChanged = nullptr;
+    EventPublisher::unsubscribe(typeid(SceneGraph::SpatialVisibilityChanged), m_onSpatialVisibilityChanged);
+    m_onSpatialVisibilityChanged = nullptr;
+}
+
+void CascadeShadowMapService::onSceneGraphChanged(const IEventPtr& e)
+{
+    if (!e) return;
+    m_casterCuller.invalidateCasters();
+}
+
+void CascadeShadowMapService::onSpatialBoundChanged(const IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SceneGraph::SpatialBoundChanged, IEvent>(e);
+    if (!ev) return;
+    m_casterCuller.invalidateCasterBound(ev->id());
+}
+
+void CascadeShadowMapService::onSpatialLocationChanged(const IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SceneGraph::SpatialLocationChanged, IEvent>(e);
+    if (!ev) return;
+    m_casterCuller.invalidateCasterLocation(ev->id());
+}
+
+void CascadeShadowMapService::onSpatialVisibilityChanged(const IEventPtr& e)
+{
+    if (!e) return;
+    m_casterCuller.invalidateCasters();
+}
+
 void CascadeShadowMapService::createSunLightCamera(const std::shared_ptr<SceneGraph::Light>& lit)
 {
     assert(!m_cameraService.expired());
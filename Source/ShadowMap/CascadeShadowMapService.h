@@ -12,6 +12,7 @@
 #include "CascadeShadowMapServiceConfiguration.h"
 #include "GraphicKernel/IDeviceRasterizerState.h"
 #include "GameEngine/EffectVariable.h"
+#include "ShadowCasterCuller.h"
 
 namespace Enigma::ShadowMap
 {
@@ -38,7 +39,21 @@ namespace Enigma::ShadowMap
         virtual void createShadowRenderSystem(const std::string& renderer_name, const std::string& target_name) override;
         virtual void destroyShadowRenderSystem(const std::string& renderer_name, const std::string& target_name) override;
 
+        /** 以 light space culling 的結果, 每個 cascade 放入各自的 caster */
+        virtual void prepareShadowScene() override;
+
+        /** 上次 culling 中, 落在 cascade 中的 caster 數 */
+        unsigned cascadeCasterCount(unsigned cascade) const { return m_casterCuller.cascadeCasterCount(cascade); }
+        const ShadowCasterCuller& casterCuller() const { return m_casterCuller; }
+
     protected:
+        void subscribeCasterEvents();
+        void unsubscribeCasterEvents();
+        void onSceneGraphChanged(const Frameworks::IEventPtr& e);
+        void onSpatialBoundChanged(const Frameworks::IEventPtr& e);
+        void onSpatialLocationChanged(const Frameworks::IEventPtr& e);
+        void onSpatialVisibilityChanged(const Frameworks::IEventPtr& e);
+
         virtual void createSunLightCamera(const std::shared_ptr<SceneGraph::Light>& lit) override;
         virtual void deleteSunLightCamera() override;
         virtual void updateSunLightDirection(const MathLib::Vector3& dir) override;
@@ -54,6 +69,12 @@ namespace Enigma::ShadowMap
     private:
         std::shared_ptr<CascadeShadowMapServiceConfiguration> m_configuration;
         std::shared_ptr<CSMSunLightCamera> m_sunLightCamera;
+        ShadowCasterCuller m_casterCuller;
+
+        Frameworks::EventSubscriberPtr m_onSceneGraphChanged;
+        Frameworks::EventSubscriberPtr m_onSpatialBoundChanged;
+        Frameworks::EventSubscriberPtr m_onSpatialLocationChanged;
+        Frameworks::EventSubscriberPtr m_onSpatialVisibilityChanged;
         //todo: backface culling 是做什麼的??
         //std::shared_ptr<Graphics::IDeviceRasterizerState> m_backfaceCullingState;
         //bool m_isRenderBackFace;
@@ -0,0 +1,239 @@
+﻿#include "ShadowCasterCuller.h"
+#include "CSMSunLightCamera.h"
+#include "SpatialShadowFlags.h"
+#include "SceneGraph/Pawn.h"
+#include "SceneGraph/Node.h"
+#include "MathLib/Box3.h"
+#include "MathLib/Sphere3.h"
+#include "MathLib/MathGlobal.h"
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::ShadowMap;
+using namespace Enigma::SceneGraph;
+using namespace Enigma::MathLib;
+using namespace Enigma::Engine;
+
+ShadowCasterCuller::ShadowCasterCuller() : m_isCasterListDirty(true), m_isAllExtentDirty(true), m_refreshedCasterCount(0)
+{
+}
+
+ShadowCasterCuller::~ShadowCasterCuller()
+{
+    clear();
+}
+
+void ShadowCasterCuller::invalidateCasters()
+{
+    m_isCasterListDirty = true;
+}
+
+void ShadowCasterCuller::invalidateCasterBound(const SpatialId& id)
+{
+    if (const auto it = m_casterIndices.find(id); it != m_casterIndices.end())
+    {
+        m_casters[it->second].m_isDirty = true;
+    }
+}
+
+void ShadowCasterCuller::invalidateCasterLocation(const SpatialId& id)
+{
+    if (const auto it = m_casterIndices.find(id); it != m_casterIndices.end())
+    {
+        m_casters[it->second].m_isDirty = true;
+        return;
+    }
+    m_isAllExtentDirty = true;
+}
+
+void ShadowCasterCuller::clear()
+{
+    m_casters.clear();
+    m_casterIndices.clear();
+    m_cascadeCasters.clear();
+    m_cascadeCasterBounds.clear();
+    m_isCasterListDirty = true;
+    m_isAllExtentDirty = true;
+    m_refreshedCasterCount = 0;
+}
+
+void ShadowCasterCuller::cullCasters(const std::shared_ptr<Spatial>& scene_root, const CSMSunLightCamera& sun_light_camera)
+{
+    const unsigned cascade_count = sun_light_camera.getPartitionCount();
+    m_cascadeCasters.resize(cascade_count);
+    m_cascadeCasterBounds.resize(cascade_count);
+    for (unsigned cascade = 0; cascade < cascade_count; cascade++)
+    {
+        m_cascadeCasters[cascade].clear();
+        m_cascadeCasterBounds[cascade] = BoundingVolume{};
+    }
+    m_refreshedCasterCount = 0;
+    if (!scene_root) return;
+
+    if (m_isCasterListDirty)
+    {
+        // 重新收集時, 還在的 caster 保留 cache 的 extent
+        std::vector<CachedCaster> previous_casters = std::move(m_casters);
+        std::unordered_map<SpatialId, size_t, SpatialId::hash> previous_indices = std::move(m_casterIndices);
+        m_casters.clear();
+        m_casterIndices.clear();
+        collectCasters(scene_root);
+        for (auto& [id, index] : m_casterIndices)
+        {
+            const auto it = previous_indices.find(id);
+            if (it == previous_indices.end()) continue;
+            const CachedCaster& previous = previous_casters[it->second];
+            m_casters[index].m_lightMin = previous.m_lightMin;
+            m_casters[index].m_lightMax = previous.m_lightMax;
+            m_casters[index].m_hasExtent = previous.m_hasExtent;
+            m_casters[index].m_isDirty = previous.m_isDirty;
+        }
+        m_isCasterListDirty = false;
+    }
+    refreshLightFrame(sun_light_camera);
+    if (m_isAllExtentDirty)
+    {
+        for (auto& caster : m_casters)
+        {
+            caster.m_isDirty = true;
+        }
+        m_isAllExtentDirty = false;
+    }
+
+    // 每個 cascade 的 light box, 以 light frame 座標表示; near 端往光源方向無限延伸
+    std::vector<Vector3> cascade_mins(cascade_count);
+    std::vector<Vector3> cascade_maxs(cascade_count);
+    for (unsigned cascade = 0; cascade < cascade_count; cascade++)
+    {
+        const Vector3& eye = sun_light_camera.getLightCameraLocation(cascade);
+        const Frustum& frustum = sun_light_camera.getLightFrustum(cascade);
+        const Vector3 center(m_lightFrame[0].dot(eye), m_lightFrame[1].dot(eye), m_lightFrame[2].dot(eye));
+        const float half_width = frustum.nearWidth() * 0.5f;
+        const float half_height = frustum.nearHeight() * 0.5f;
+        cascade_mins[cascade] = Vector3(center.x() - half_width, center.y() - half_height, -Math::MAX_FLOAT);
+        cascade_maxs[cascade] = Vector3(center.x() + half_width, center.y() + half_height, center.z() + frustum.farPlaneZ());
+    }
+
+    std::vector<Vector3> bound_mins(cascade_count, Vector3(Math::MAX_FLOAT, Math::MAX_FLOAT, Math::MAX_FLOAT));
+    std::vector<Vector3> bound_maxs(cascade_count, Vector3(-Math::MAX_FLOAT, -Math::MAX_FLOAT, -Math::MAX_FLOAT));
+    for (auto& caster : m_casters)
+    {
+        auto pawn = caster.m_pawn.lock();
+        if (!pawn)
+        {
+            m_isCasterListDirty = true;
+            continue;
+        }
+        if ((!pawn->isRenderable()) || (pawn->testSpatialFlag(Spatial::Spatial_Hide))
+            || (!pawn->testSpatialFlag(SpatialShadowFlags::SpatialBit::Spatial_ShadowCaster))) continue;
+        if (caster.m_isDirty) refreshCasterExtent(caster, pawn);
+        if (!caster.m_hasExtent) continue;
+        for (unsigned cascade = 0; cascade < cascade_count; cascade++)
+        {
+            if ((caster.m_lightMax.x() < cascade_mins[cascade].x()) || (caster.m_lightMin.x() > cascade_maxs[cascade].x())) continue;
+            if ((caster.m_lightMax.y() < cascade_mins[cascade].y()) || (caster.m_lightMin.y() > cascade_maxs[cascade].y())) continue;
+            if (caster.m_lightMin.z() > cascade_maxs[cascade].z()) continue;
+            m_cascadeCasters[cascade].push_back(pawn);
+            bound_mins[cascade] = Math::MinVectorComponent(bound_mins[cascade], caster.m_lightMin);
+            bound_maxs[cascade] = Math::MaxVectorComponent(bound_maxs[cascade], caster.m_lightMax);
+        }
+    }
+
+    // merged bound 裁在 cascade 的 light box 內, 轉回 world space 的 box
+    for (unsigned cascade = 0; cascade < cascade_count; cascade++)
+    {
+        if (m_cascadeCasters[cascade].empty()) continue;
+        Vector3 vecMin = bound_mins[cascade];
+        Vector3 vecMax = Math::MinVectorComponent(bound_maxs[cascade], cascade_maxs[cascade]);
+        vecMin.x() = std::max(vecMin.x(), cascade_mins[cascade].x());
+        vecMin.y() = std::max(vecMin.y(), cascade_mins[cascade].y());
+        const Vector3 center = (vecMin + vecMax) * 0.5f;
+        const Vector3 extent = (vecMax - vecMin) * 0.5f;
+        Box3 box;
+        box.Center() = m_lightFrame[0] * center.x() + m_lightFrame[1] * center.y() + m_lightFrame[2] * center.z();
+        for (int i = 0; i < 3; i++)
+        {
+            box.Axis(i) = m_lightFrame[i];
+            box.Extent(i) = std::max(extent[i], 0.0f);
+        }
+        m_cascadeCasterBounds[cascade] = BoundingVolume{ box };
+    }
+}
+
+const std::vector<std::shared_ptr<Pawn>>& ShadowCasterCuller::cascadeCasters(unsigned cascade) const
+{
+    assert(cascade < m_cascadeCasters.size());
+    return m_cascadeCasters[cascade];
+}
+
+unsigned ShadowCasterCuller::cascadeCasterCount(unsigned cascade) const
+{
+    if (cascade >= m_cascadeCasters.size()) return 0;
+    return static_cast<unsigned>(m_cascadeCasters[cascade].size());
+}
+
+void ShadowCasterCuller::collectCasters(const std::shared_ptr<Spatial>& spatial)
+{
+    if (!spatial) return;
+    if (spatial->testSpatialFlag(Spatial::Spatial_Hide)) return;
+    if (auto pawn = std::dynamic_pointer_cast<Pawn, Spatial>(spatial))
+    {
+        if (pawn->testSpatialFlag(SpatialShadowFlags::SpatialBit::Spatial_ShadowCaster))
+        {
+            m_casterIndices.emplace(pawn->id(), m_casters.size());
+            m_casters.push_back({ pawn, Vector3::ZERO, Vector3::ZERO, false, true });
+        }
+    }
+    if (auto node = std::dynamic_pointer_cast<Node, Spatial>(spatial))
+    {
+        for (const auto& child : node->getChildList())
+        {
+            collectCasters(child);
+        }
+    }
+}
+
+void ShadowCasterCuller::refreshLightFrame(const CSMSunLightCamera& sun_light_camera)
+{
+    if ((!m_isAllExtentDirty) && (m_sunLightDir == sun_light_camera.getSunLightDir())) return;
+    m_sunLightDir = sun_light_camera.getSunLightDir();
+    m_lightFrame = sun_light_camera.calcLightCameraFrame();
+    m_isAllExtentDirty = true;
+}
+
+void ShadowCasterCuller::refreshCasterExtent(CachedCaster& caster, const std::shared_ptr<Pawn>& pawn)
+{
+    caster.m_isDirty = false;
+    caster.m_hasExtent = false;
+    m_refreshedCasterCount++;
+    const BoundingVolume& bound = pawn->getWorldBound();
+    if (bound.isEmpty()) return;
+    Vector3 center;
+    Vector3 extent;
+    if (auto box = bound.BoundingBox3())
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            center[i] = m_lightFrame[i].dot(box->Center());
+            extent[i] = std::fabs(m_lightFrame[i].dot(box->Axis(0))) * box->Extent(0)
+                + std::fabs(m_lightFrame[i].dot(box->Axis(1))) * box->Extent(1)
+                + std::fabs(m_lightFrame[i].dot(box->Axis(2))) * box->Extent(2);
+        }
+    }
+    else if (auto sphere = bound.BoundingSphere3())
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            center[i] = m_lightFrame[i].dot(sphere->Center());
+            extent[i] = sphere->Radius();
+        }
+    }
+    else
+    {
+        return;
+    }
+    caster.m_lightMin = center - extent;
+    caster.m_lightMax = center + extent;
+    caster.m_hasExtent = true;
+}
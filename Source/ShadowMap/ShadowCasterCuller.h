@@ -0,0 +1,91 @@
+﻿/*********************************************************************
+ * \file   ShadowCasterCuller.h
+ * \brief  shadow caster culling in light space, 每個 cascade 各自一份 caster list
+ *         cascade 的 light box 往光源方向延伸, view frustum 之外的 caster 也會被收進來
+ *         caster 的 light space extent 會 cache 住, caster 移動或光源方向改變才重算
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef SHADOW_CASTER_CULLER_H
+#define SHADOW_CASTER_CULLER_H
+
+#include "SceneGraph/SpatialId.h"
+#include "GameEngine/BoundingVolume.h"
+#include "MathLib/Vector3.h"
+#include <memory>
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+namespace Enigma::SceneGraph
+{
+    class Spatial;
+    class Pawn;
+}
+
+namespace Enigma::ShadowMap
+{
+    class CSMSunLightCamera;
+
+    class ShadowCasterCuller
+    {
+    public:
+        ShadowCasterCuller();
+        ShadowCasterCuller(const ShadowCasterCuller&) = delete;
+        ShadowCasterCuller(ShadowCasterCuller&&) = delete;
+        ~ShadowCasterCuller();
+        ShadowCasterCuller& operator=(const ShadowCasterCuller&) = delete;
+        ShadowCasterCuller& operator=(ShadowCasterCuller&&) = delete;
+
+        /** scene graph 結構或可見性改變, 下次 cull 重新收集 caster */
+        void invalidateCasters();
+        /** caster bound 改變, 只重算這個 caster 的 extent */
+        void invalidateCasterBound(const SceneGraph::SpatialId& id);
+        /** spatial 位置改變; 不是 caster 的話 (node), 整個子樹都可能移動, 所有 extent 重算 */
+        void invalidateCasterLocation(const SceneGraph::SpatialId& id);
+
+        /** 以 sun light camera 目前的 light frustum 做 culling, 結果依 cascade 存放 */
+        void cullCasters(const std::shared_ptr<SceneGraph::Spatial>& scene_root, const CSMSunLightCamera& sun_light_camera);
+        void clear();
+
+        unsigned cascadeCount() const { return static_cast<unsigned>(m_cascadeCasters.size()); }
+        const std::vector<std::shared_ptr<SceneGraph::Pawn>>& cascadeCasters(unsigned cascade) const;
+        unsigned cascadeCasterCount(unsigned cascade) const;
+        /** 每個 cascade 中 caster 的 merged bound (world space, 裁切在 cascade 的 light box 內), 沒有 caster 時是 empty */
+        const std::vector<Engine::BoundingVolume>& cascadeCasterBounds() const { return m_cascadeCasterBounds; }
+
+        /** 收集到的 caster 數 */
+        unsigned casterCount() const { return static_cast<unsigned>(m_casters.size()); }
+        /** 上次 cull 時重算 light space extent 的 caster 數, 其餘的都是 cache */
+        unsigned refreshedCasterCount() const { return m_refreshedCasterCount; }
+
+    protected:
+        struct CachedCaster
+        {
+            std::weak_ptr<SceneGraph::Pawn> m_pawn;
+            MathLib::Vector3 m_lightMin;  ///< light frame 座標 (right, up, dir) 下的 extent
+            MathLib::Vector3 m_lightMax;
+            bool m_hasExtent;
+            bool m_isDirty;
+        };
+
+        void collectCasters(const std::shared_ptr<SceneGraph::Spatial>& spatial);
+        void refreshLightFrame(const CSMSunLightCamera& sun_light_camera);
+        void refreshCasterExtent(CachedCaster& caster, const std::shared_ptr<SceneGraph::Pawn>& pawn);
+
+    protected:
+        std::vector<CachedCaster> m_casters;
+        std::unordered_map<SceneGraph::SpatialId, size_t, SceneGraph::SpatialId::hash> m_casterIndices;
+        bool m_isCasterListDirty;
+        bool m_isAllExtentDirty;
+
+        MathLib::Vector3 m_sunLightDir;
+        std::array<MathLib::Vector3, 3> m_lightFrame;
+
+        std::vector<std::vector<std::shared_ptr<SceneGraph::Pawn>>> m_cascadeCasters;
+        std::vector<Engine::BoundingVolume> m_cascadeCasterBounds;
+        unsigned m_refreshedCasterCount;
+    };
+}
+
+#endif // SHADOW_CASTER_CULLER_H
@@ -1,6 +1,12 @@
 ﻿#include "TerrainGeometry.h"
 #include "TerrainGeometryDto.h"
 #include "Platforms/PlatformLayer.h"
+#include "MathLib/ContainmentBox3.h"
+#include "Frameworks/JobSystem.h"
+#include <cfloat>
+#include <cmath>
+#include <array>
+#include <algorithm>
 
 using namespace Enigma::Terrain;
 using namespace Enigma::Engine;
@@ -8,9 +14,178 @@ using namespace Enigma::MathLib;
 
 DEFINE_RTTI(Terrain, TerrainGeometry, TriangleList);
 
+namespace
+{
+    struct GridVertex
+    {
+        unsigned m_x;
+        unsigned m_z;
+    };
+    using GridLine = std::vector<GridVertex>;
+
+    /** 沿 x 或 z 方向, 從 (x0, z0) 到 (x1, z1) 每 step 格一個 vertex */
+    GridLine makeGridLine(unsigned x0, unsigned z0, unsigned x1, unsigned z1, unsigned step)
+    {
+        GridLine line;
+        if (x0 == x1)
+        {
+            for (unsigned z = z0; z <= z1; z += step) line.push_back({ x0, z });
+        }
+        else
+        {
+            for (unsigned x = x0; x <= x1; x += step) line.push_back({ x, z0 });
+        }
+        return line;
+    }
+
+    /** 兩條平行的 line 之間, 依沿線位置交錯連成三角形 */
+    template <class Emit> void zipGridLines(const GridLine& outer, const GridLine& inner, bool along_x, Emit&& emit)
+    {
+        auto param = [along_x](const GridVertex& v) { return along_x ? v.m_x : v.m_z; };
+        size_t o = 0;
+        size_t i = 0;
+        while ((o + 1 < outer.size()) || (i + 1 < inner.size()))
+        {
+            const bool advance_outer = (i + 1 >= inner.size())
+                || ((o + 1 < outer.size()) && (param(outer[o + 1]) <= param(inner[i + 1])));
+            if (advance_outer)
+            {
+                emit(outer[o], outer[o + 1], inner[i]);
+                o++;
+            }
+            else
+            {
+                emit(outer[o], inner[i + 1], inner[i]);
+                i++;
+            }
+        }
+    }
+
+    /** 相鄰 6 個 vertex 的高度差, 跟算好的 normal, 都以 SoA 排列 */
+    struct NormalRowScratch
+    {
+        NormalRowScratch(unsigned width) : m_width(width)
+        {
+            for (auto& delta : m_deltas) delta.resize(width);
+            m_normalX.resize(width);
+            m_normalY.resize(width);
+            m_normalZ.resize(width);
+        }
+        unsigned m_width;
+        std::array<std::vector<float>, 6> m_deltas;
+        std::vector<float> m_normalX;
+        std::vector<float> m_normalY;
+        std::vector<float> m_normalZ;
+    };
+
+    inline void accumulateCross(float ax, float ay, float az, float bx, float by, float bz, float& sx, float& sy, float& sz)
+    {
+        sx += ay * bz - az * by;
+        sy += az * bx - ax * bz;
+        sz += ax * by - ay * bx;
+    }
+
+    /** 一列 vertex 的 normal : 相鄰 6 個 triangle 的 face normal 平均,
+     * 先取出高度差 (有邊界判斷), 後段的向量運算沒有分支, 可以讓編譯器向量化 */
+    void computeNormalRow(const float* height_map, unsigned num_cols, unsigned num_rows, unsigned z, unsigned min_x,
+        float cell_width, float cell_height, NormalRowScratch& scratch)
+    {
+        const unsigned stride = num_cols + 1;
+        const float* row = height_map + z * stride;
+        const float* prev_row = z > 0 ? row - stride : nullptr;
+        const float* next_row = z < num_rows ? row + stride : nullptr;
+        float* dh1 = scratch.m_deltas[0].data();
+        float* dh2 = scratch.m_deltas[1].data();
+        float* dh3 = scratch.m_deltas[2].data();
+        float* dh4 = scratch.m_deltas[3].data();
+        float* dh5 = scratch.m_deltas[4].data();
+        float* dh6 = scratch.m_deltas[5].data();
+        for (unsigned i = 0; i < scratch.m_width; i++)
+        {
+            const unsigned x = min_x + i;
+            const float h0 = row[x];
+            dh1[i] = x < num_cols ? row[x + 1] - h0 : 0.0f;
+            dh2[i] = prev_row ? prev_row[x] - h0 : 0.0f;
+            dh3[i] = x > 0 ? row[x - 1] - h0 : 0.0f;
+            dh4[i] = next_row ? next_row[x] - h0 : 0.0f;
+            dh5[i] = (next_row && (x < num_cols)) ? next_row[x + 1] - h0 : 0.0f;
+            dh6[i] = (prev_row && (x > 0)) ? prev_row[x - 1] - h0 : 0.0f;
+        }
+
+        const float w = cell_width;
+        const float d = cell_height;
+        const float w2 = w * w;
+        const float d2 = d * d;
+        float* out_x = scratch.m_normalX.data();
+        float* out_y = scratch.m_normalY.data();
+        float* out_z = scratch.m_normalZ.data();
+        for (unsigned i = 0; i < scratch.m_width; i++)
+        {
+            // 六個 edge : +x, -z, -x, +z, (+x,+z), (-x,-z), 正規化後相鄰兩兩外積
+            const float r1 = 1.0f / std::sqrt(w2 + dh1[i] * dh1[i]);
+            const float r2 = 1.0f / std::sqrt(d2 + dh2[i] * dh2[i]);
+            const float r3 = 1.0f / std::sqrt(w2 + dh3[i] * dh3[i]);
+            const float r4 = 1.0f / std::sqrt(d2 + dh4[i] * dh4[i]);
+            const float r5 = 1.0f / std::sqrt(w2 + d2 + dh5[i] * dh5[i]);
+            const float r6 = 1.0f / std::sqrt(w2 + d2 + dh6[i] * dh6[i]);
+            const float e1x = w * r1, e1y = dh1[i] * r1;
+            const float e2y = dh2[i] * r2, e2z = -d * r2;
+            const float e3x = -w * r3, e3y = dh3[i] * r3;
+            const float e4y = dh4[i] * r4, e4z = d * r4;
+            const float e5x = w * r5, e5y = dh5[i] * r5, e5z = d * r5;
+            const float e6x = -w * r6, e6y = dh6[i] * r6, e6z = -d * r6;
+            float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+            accumulateCross(e1x, e1y, 0.0f, 0.0f, e2y, e2z, nx, ny, nz);
+            accumulateCross(0.0f, e2y, e2z, e6x, e6y, e6z, nx, ny, nz);
+            accumulateCross(e6x, e6y, e6z, e3x, e3y, 0.0f, nx, ny, nz);
+            accumulateCross(e3x, e3y, 0.0f, 0.0f, e4y, e4z, nx, ny, nz);
+            accumulateCross(0.0f, e4y, e4z, e5x, e5y, e5z, nx, ny, nz);
+            accumulateCross(e5x, e5y, e5z, e1x, e1y, 0.0f, nx, ny, nz);
+            const float inv_length = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+            out_x[i] = nx * inv_length;
+            out_y[i] = ny * inv_length;
+            out_z[i] = nz * inv_length;
+        }
+    }
+
+    /** grid 邊界上的浮點誤差 (以格為單位) */
+    constexpr float GridEdgeTolerance = 1.0e-4f;
+
+    /** two sided Moller-Trumbore, t >= 0 */
+    std::optional<float> intersectRayTriangle(const Ray3& ray, const Vector3& v0, const Vector3& v1, const Vector3& v2)
+    {
+        const Vector3 edge1 = v1 - v0;
+        const Vector3 edge2 = v2 - v0;
+        const Vector3 p = ray.direction().cross(edge2);
+        const float det = edge1.dot(p);
+        if (std::fabs(det) < FLT_EPSILON) return std::nullopt;
+        const float inv_det = 1.0f / det;
+        const Vector3 s = ray.origin() - v0;
+        const float u = s.dot(p) * inv_det;
+        if ((u < 0.0f) || (u > 1.0f)) return std::nullopt;
+        const Vector3 q = s.cross(edge1);
+        const float v = ray.direction().dot(q) * inv_det;
+        if ((v < 0.0f) || (u + v > 1.0f)) return std::nullopt;
+        const float t = edge2.dot(q) * inv_det;
+        if (t < 0.0f) return std::nullopt;
+        return t;
+    }
+
+    /** 可以整除邊長的最大格距 */
+    unsigned edgeStep(unsigned step, unsigned edge_cell_count)
+    {
+        while ((step > 1) && (edge_cell_count % step != 0)) step >>= 1;
+        return step;
+    }
+}
+
 TerrainGeometry::TerrainGeometry(const Geometries::GeometryId& id) : TriangleList(id)
 {
     m_factoryDesc = Engine::FactoryDesc(TerrainGeometry::TYPE_RTTI.getName());
+    m_chunkCellCount = DefaultChunkCellCount;
+    m_chunkCountX = m_chunkCountZ = 0;
+    m_gridOriginX = m_gridOriginZ = 0.0f;
+    m_gridSpacingX = m_gridSpacingZ = 0.0f;
 }
 
 TerrainGeometry::TerrainGeometry(const Geometries::GeometryId& id, const GenericDto& o) : TriangleList(id, o)
@@ -22,6 +197,8 @@ TerrainGeometry::TerrainGeometry(const Geometries::GeometryId& id, const Generic
     m_maxPosition = dto.maxPosition();
     m_minTextureCoordinate = dto.minTextureCoordinate();
     m_maxTextureCoordinate = dto.maxTextureCoordinate();
+    m_chunkCellCount = dto.chunkCellCount();
+    m_chunkCountX = m_chunkCountZ = 0;
     if (dto.heightMap())
     {
         m_heightMap = dto.heightMap().value();
@@ -36,6 +213,9 @@ TerrainGeometry::TerrainGeometry(const Geometries::GeometryId& id, const Generic
         dto.convertGeometryVertices();
         GeometryData::deserializeGeometryDto(dto);
     }
+    buildChunks();
+    calculateGridMapping();
+    buildHeightBounds();
 }
 
 TerrainGeometry::~TerrainGeometry()
@@ -53,6 +233,7 @@ GenericDto TerrainGeometry::serializeDto() const
     dto.maxPosition() = m_maxPosition;
     dto.minTextureCoordinate() = m_minTextureCoordinate;
     dto.maxTextureCoordinate() = m_maxTextureCoordinate;
+    dto.chunkCellCount() = m_chunkCellCount;
     if (!m_heightMap.empty())
     {
         dto.heightMap() = m_heightMap;
@@ -69,13 +250,26 @@ void TerrainGeometry::rangedUpdateHeightMapToVertexMemory(unsigned offset, unsig
 {
     assert(m_numRows > 0 && m_numCols > 0);
     if (FATAL_LOG_EXPR(m_heightMap.empty())) return;
-    //todo : check performance later
-    for (unsigned i = offset; i < offset + count; i++)
+    auto positions = mutablePositionView().subView(offset, count);
+    if ((positions.empty()) && (count > 0))
     {
-        auto pos = getPosition3(i);
-        pos.y() = m_heightMap[i];
-        setPosition3(i, pos);
+        // quantized position 沒有 view, 解碼後改寫
+        auto decoded = getPosition3Array(offset, count);
+        for (unsigned i = 0; i < decoded.size(); i++)
+        {
+            decoded[i].y() = m_heightMap[offset + i];
+        }
+        setPosition3Array(offset, decoded);
+        updateChunkBounds(offset, count);
+        return;
     }
+    for (unsigned i = 0; i < positions.size(); i++)
+    {
+        Vector3 pos = positions.get(i);
+        pos.y() = m_heightMap[offset + i];
+        positions.set(i, pos);
+    }
+    updateChunkBounds(offset, count);
 }
 
 void TerrainGeometry::updateVertexNormals()
@@ -85,71 +279,96 @@ void TerrainGeometry::updateVertexNormals()
 
 void TerrainGeometry::rangedUpdateVertexNormals(unsigned offset, unsigned count)
 {
-    auto dimension = getCellDimension();
+    if (count == 0) return;
     auto [start_x, start_z] = revertVertexIndex(offset);
     auto [end_x, end_z] = revertVertexIndex(offset + count - 1);
-    if (start_x > 0) start_x--;
-    if (start_z > 0) start_z--;
-    if (end_x < m_numCols) end_x++;
-    if (end_z < m_numRows) end_z++;
+    if (start_z != end_z)
+    {
+        start_x = 0;
+        end_x = m_numCols;
+    }
+    rectUpdateVertexNormals(start_x, start_z, end_x, end_z);
+}
 
-    unsigned vtx_num_x = m_numCols + 1;
-    // calculate normal
-    for (unsigned ix = start_x; ix <= end_x; ix++)
+void TerrainGeometry::rectUpdateHeightMapToVertexMemory(unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z)
+{
+    assert(m_numRows > 0 && m_numCols > 0);
+    if (FATAL_LOG_EXPR(m_heightMap.empty())) return;
+    max_x = std::min(max_x, m_numCols);
+    max_z = std::min(max_z, m_numRows);
+    if ((min_x > max_x) || (min_z > max_z)) return;
+    const unsigned width = max_x - min_x + 1;
+    auto positions = mutablePositionView();
+    for (unsigned z = min_z; z <= max_z; z++)
     {
-        for (unsigned iz = start_z; iz <= end_z; iz++)
+        const unsigned offset = convertVertexIndex(min_x, z);
+        if (positions.empty())
         {
-            float h0 = m_heightMap[iz * vtx_num_x + ix];
-            float h1 = 0.0f;
-            if (ix < m_numCols)
-            {
-                h1 = m_heightMap[iz * vtx_num_x + ix + 1] - h0;
-            }
-            float h2 = 0.0f;
-            if (iz > 0)
-            {
-                h2 = m_heightMap[(iz - 1) * vtx_num_x + ix] - h0;
-            }
-            float h3 = 0.0f;
-            if (ix > 0)
-            {
-                h3 = m_heightMap[iz * vtx_num_x + ix - 1] - h0;
-            }
-            float h4 = 0.0f;
-            if (iz < m_numRows)
+            // quantized position 沒有 view, 解碼後改寫
+            auto decoded = getPosition3Array(offset, width);
+            for (unsigned i = 0; i < decoded.size(); i++)
             {
-                h4 = m_heightMap[(iz + 1) * vtx_num_x + ix] - h0;
+                decoded[i].y() = m_heightMap[offset + i];
             }
-            float h5 = 0.0f;
-            if ((iz < m_numRows) && (ix < m_numCols))
-            {
-                h5 = m_heightMap[(iz + 1) * vtx_num_x + ix + 1] - h0;
-            }
-            float h6 = 0.0f;
-            if ((iz > 0) && (ix > 0))
+            setPosition3Array(offset, decoded);
+            continue;
+        }
+        for (unsigned i = 0; i < width; i++)
+        {
+            Vector3 pos = positions.get(offset + i);
+            pos.y() = m_heightMap[offset + i];
+            positions.set(offset + i, pos);
+        }
+    }
+    updateChunkBounds(min_x, min_z, max_x, max_z);
+}
+
+void TerrainGeometry::rectUpdateVertexNormals(unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z)
+{
+    assert(m_numRows > 0 && m_numCols > 0);
+    if (FATAL_LOG_EXPR(m_heightMap.size() < (m_numRows + 1) * (m_numCols + 1))) return;
+    // 高度變動的 vertex, 相鄰 vertex 的 normal 也會變
+    if (min_x > 0) min_x--;
+    if (min_z > 0) min_z--;
+    max_x = std::min(max_x + 1, m_numCols);
+    max_z = std::min(max_z + 1, m_numRows);
+    if ((min_x > max_x) || (min_z > max_z)) return;
+
+    const auto dimension = getCellDimension();
+    const unsigned width = max_x - min_x + 1;
+    const unsigned row_count = max_z - min_z + 1;
+    auto normals = mutableNormalView();
+    auto update_rows = [&, this](unsigned z_begin, unsigned z_end)
+        {
+            NormalRowScratch scratch(width);
+            for (unsigned z = z_begin; z < z_end; z++)
             {
-                h6 = m_heightMap[(iz - 1) * vtx_num_x + ix - 1] - h0;
+                computeNormalRow(m_heightMap.data(), m_numCols, m_numRows, z, min_x, dimension.m_width, dimension.m_height, scratch);
+                const unsigned offset = convertVertexIndex(min_x, z);
+                if (normals.empty())
+                {
+                    // 壓縮過的 normal 沒有 view, 逐一編碼寫入
+                    for (unsigned i = 0; i < width; i++)
+                    {
+                        setVertexNormal(offset + i, Vector3(scratch.m_normalX[i], scratch.m_normalY[i], scratch.m_normalZ[i]));
+                    }
+                    continue;
+                }
+                for (unsigned i = 0; i < width; i++)
+                {
+                    normals[offset + i] = Vector3(scratch.m_normalX[i], scratch.m_normalY[i], scratch.m_normalZ[i]);
+                }
             }
-            Vector3 vecEdge1 = Vector3(dimension.m_width, h1, 0.0f).normalize();
-            Vector3 vecEdge2 = Vector3(0.0f, h2, -dimension.m_height).normalize();
-            Vector3 vecEdge3 = Vector3(-dimension.m_width, h3, 0.0f).normalize();
-            Vector3 vecEdge4 = Vector3(0.0f, h4, dimension.m_height).normalize();
-            Vector3 vecEdge5 = Vector3(dimension.m_width, h5, dimension.m_height).normalize();
-            Vector3 vecEdge6 = Vector3(-dimension.m_width, h6, -dimension.m_height).normalize();
-            Vector3 vecFace1 = vecEdge1.cross(vecEdge2);
-            Vector3 vecFace2 = vecEdge2.cross(vecEdge6);
-            Vector3 vecFace3 = vecEdge6.cross(vecEdge3);
-            Vector3 vecFace4 = vecEdge3.cross(vecEdge4);
-            Vector3 vecFace5 = vecEdge4.cross(vecEdge5);
-            Vector3 vecFace6 = vecEdge5.cross(vecEdge1);
-            Vector3 vecNor = vecFace1 + vecFace2 + vecFace3 + vecFace4 + vecFace5 + vecFace6;
-            vecNor.normalizeSelf();
+        };
 
-            // vtx idx
-            int vtxIdx = iz * vtx_num_x + ix;
-            setVertexNormal(vtxIdx, vecNor);
-        }
+    auto job_system = Frameworks::JobSystem::instance();
+    if ((!job_system) || (normals.empty()) || (width * row_count < ParallelNormalVertexCount))
+    {
+        update_rows(min_z, max_z + 1);
+        return;
     }
+    // 各 batch 寫不同列的 vertex, 不需要 lock
+    job_system->parallelFor("TerrainVertexNormals", row_count, [&](unsigned begin, unsigned end) { update_rows(min_z + begin, min_z + end); });
 }
 
 Enigma::MathLib::Dimension<float> TerrainGeometry::getCellDimension() const
@@ -174,13 +393,14 @@ void TerrainGeometry::changeHeight(unsigned x, unsigned z, float new_height)
     unsigned idx = convertVertexIndex(x, z);
     assert(idx < m_heightMap.size());
     m_heightMap[idx] = new_height;
+    refreshHeightBounds(x, z);
 }
 
 std::tuple<unsigned, unsigned> TerrainGeometry::locateCell(const MathLib::Vector3& position) const
 {
     auto dimension = getCellDimension();
-    unsigned cell_x = static_cast<unsigned>(std::floorf((position.x() - m_minPosition.x()) / dimension.m_width + 0.5f));
-    unsigned cell_z = static_cast<unsigned>(std::floorf((position.z() - m_minPosition.z()) / dimension.m_height + 0.5f));
+    unsigned cell_x = static_cast<unsigned>(std::floor((position.x() - m_minPosition.x()) / dimension.m_width + 0.5f));
+    unsigned cell_z = static_cast<unsigned>(std::floor((position.z() - m_minPosition.z()) / dimension.m_height + 0.5f));
     return std::make_tuple(cell_x, cell_z);
 }
 
@@ -199,3 +419,564 @@ std::tuple<unsigned, unsigned> TerrainGeometry::revertVertexIndex(unsigned idx)
     unsigned z = idx / (m_numCols + 1);
     return std::make_tuple(x, z);
 }
+
+std::optional<unsigned> TerrainGeometry::getNeighborChunk(unsigned chunk_index, ChunkEdge edge) const
+{
+    if (chunk_index >= m_chunks.size()) return std::nullopt;
+    const unsigned cx = chunk_index % m_chunkCountX;
+    const unsigned cz = chunk_index / m_chunkCountX;
+    switch (edge)
+    {
+    case ChunkEdge::Left: if (cx > 0) return chunk_index - 1; break;
+    case ChunkEdge::Right: if (cx + 1 < m_chunkCountX) return chunk_index + 1; break;
+    case ChunkEdge::Bottom: if (cz > 0) return chunk_index - m_chunkCountX; break;
+    case ChunkEdge::Top: if (cz + 1 < m_chunkCountZ) return chunk_index + m_chunkCountX; break;
+    default: break;
+    }
+    return std::nullopt;
+}
+
+uint_buffer TerrainGeometry::buildChunkIndices(unsigned chunk_index, unsigned lod, const ChunkEdgeLods& edge_lods) const
+{
+    assert(chunk_index < m_chunks.size());
+    const Chunk& chunk = m_chunks[chunk_index];
+    lod = std::min(lod, chunk.m_maxLod);
+    const unsigned step = 1u << lod;
+    const unsigned size_x = chunk.m_cellCountX;
+    const unsigned size_z = chunk.m_cellCountZ;
+    const unsigned quad_count_x = size_x / step;
+    const unsigned quad_count_z = size_z / step;
+    auto step_of_edge = [&](ChunkEdge edge, unsigned edge_cell_count)
+        {
+            const unsigned neighbor_lod = edge_lods[static_cast<size_t>(edge)];
+            return edgeStep(1u << std::min(std::max(lod, neighbor_lod), 31u), edge_cell_count);
+        };
+
+    uint_buffer indices;
+    indices.reserve(chunk.m_maxIdxCount);
+    auto emit = [&](GridVertex a, GridVertex b, GridVertex c)
+        {
+            const int cross = (static_cast<int>(b.m_x) - static_cast<int>(a.m_x)) * (static_cast<int>(c.m_z) - static_cast<int>(a.m_z))
+                - (static_cast<int>(b.m_z) - static_cast<int>(a.m_z)) * (static_cast<int>(c.m_x) - static_cast<int>(a.m_x));
+            if (cross == 0) return;
+            // winding 跟 full res grid 一致 (x-z 平面上 cross 為負)
+            if (cross > 0) std::swap(b, c);
+            indices.push_back(convertVertexIndex(chunk.m_startCellX + a.m_x, chunk.m_startCellZ + a.m_z));
+            indices.push_back(convertVertexIndex(chunk.m_startCellX + b.m_x, chunk.m_startCellZ + b.m_z));
+            indices.push_back(convertVertexIndex(chunk.m_startCellX + c.m_x, chunk.m_startCellZ + c.m_z));
+        };
+
+    const bool is_full_resolution = (step == 1)
+        && (step_of_edge(ChunkEdge::Bottom, size_x) == 1) && (step_of_edge(ChunkEdge::Top, size_x) == 1)
+        && (step_of_edge(ChunkEdge::Left, size_z) == 1) && (step_of_edge(ChunkEdge::Right, size_z) == 1);
+    if (is_full_resolution)
+    {
+        // 全解析度時保持原本 grid 的 triangle 切法, picking 跟 height field ray cast 才會一致
+        for (unsigned z = 0; z < size_z; z++)
+        {
+            for (unsigned x = 0; x < size_x; x++)
+            {
+                emit({ x, z }, { x, z + 1 }, { x + 1, z + 1 });
+                emit({ x, z }, { x + 1, z + 1 }, { x + 1, z });
+            }
+        }
+    }
+    else if ((quad_count_x >= 2) && (quad_count_z >= 2))
+    {
+        for (unsigned qz = 1; qz + 1 < quad_count_z; qz++)
+        {
+            for (unsigned qx = 1; qx + 1 < quad_count_x; qx++)
+            {
+                const GridVertex v00{ qx * step, qz * step };
+                const GridVertex v10{ (qx + 1) * step, qz * step };
+                const GridVertex v01{ qx * step, (qz + 1) * step };
+                const GridVertex v11{ (qx + 1) * step, (qz + 1) * step };
+                emit(v00, v01, v11);
+                emit(v00, v11, v10);
+            }
+        }
+        // 外圈分成四個梯形, 外側的邊用相鄰 chunk 的格距
+        zipGridLines(makeGridLine(0, 0, size_x, 0, step_of_edge(ChunkEdge::Bottom, size_x)),
+            makeGridLine(step, step, size_x - step, step, step), true, emit);
+        zipGridLines(makeGridLine(0, size_z, size_x, size_z, step_of_edge(ChunkEdge::Top, size_x)),
+            makeGridLine(step, size_z - step, size_x - step, size_z - step, step), true, emit);
+        zipGridLines(makeGridLine(0, 0, 0, size_z, step_of_edge(ChunkEdge::Left, size_z)),
+            makeGridLine(step, step, step, size_z - step, step), false, emit);
+        zipGridLines(makeGridLine(size_x, 0, size_x, size_z, step_of_edge(ChunkEdge::Right, size_z)),
+            makeGridLine(size_x - step, step, size_x - step, size_z - step, step), false, emit);
+    }
+    else if (quad_count_x == 1)
+    {
+        zipGridLines(makeGridLine(0, 0, 0, size_z, step_of_edge(ChunkEdge::Left, size_z)),
+            makeGridLine(size_x, 0, size_x, size_z, step_of_edge(ChunkEdge::Right, size_z)), false, emit);
+    }
+    else
+    {
+        zipGridLines(makeGridLine(0, 0, size_x, 0, step_of_edge(ChunkEdge::Bottom, size_x)),
+            makeGridLine(0, size_z, size_x, size_z, step_of_edge(ChunkEdge::Top, size_x)), true, emit);
+    }
+    assert(indices.size() <= chunk.m_maxIdxCount);
+    return indices;
+}
+
+void TerrainGeometry::buildChunks()
+{
+    m_chunks.clear();
+    m_chunkCountX = m_chunkCountZ = 0;
+    if ((m_numRows == 0) || (m_numCols == 0) || (m_chunkCellCount == 0)) return;
+    if (m_vtxUsedCount < (m_numRows + 1) * (m_numCols + 1)) return;
+    if (m_indexMemory.size() < m_numRows * m_numCols * 6) return;
+
+    m_chunkCountX = (m_numCols + m_chunkCellCount - 1) / m_chunkCellCount;
+    m_chunkCountZ = (m_numRows + m_chunkCellCount - 1) / m_chunkCellCount;
+    m_chunks.reserve(m_chunkCountX * m_chunkCountZ);
+    unsigned start_idx = 0;
+    for (unsigned cz = 0; cz < m_chunkCountZ; cz++)
+    {
+        for (unsigned cx = 0; cx < m_chunkCountX; cx++)
+        {
+            Chunk chunk;
+            chunk.m_startCellX = cx * m_chunkCellCount;
+            chunk.m_startCellZ = cz * m_chunkCellCount;
+            chunk.m_cellCountX = std::min(m_chunkCellCount, m_numCols - chunk.m_startCellX);
+            chunk.m_cellCountZ = std::min(m_chunkCellCount, m_numRows - chunk.m_startCellZ);
+            chunk.m_startIdx = start_idx;
+            chunk.m_maxIdxCount = chunk.m_cellCountX * chunk.m_cellCountZ * 6;
+            // 最粗的 lod 每邊至少兩格, 外圈才能縫合
+            chunk.m_maxLod = 0;
+            for (unsigned next_step = 2; (chunk.m_cellCountX % next_step == 0) && (chunk.m_cellCountZ % next_step == 0)
+                && (chunk.m_cellCountX / next_step >= 2) && (chunk.m_cellCountZ / next_step >= 2); next_step <<= 1)
+            {
+                chunk.m_maxLod++;
+            }
+            calculateChunkBound(chunk);
+            start_idx += chunk.m_maxIdxCount;
+            m_chunks.emplace_back(std::move(chunk));
+        }
+    }
+    const ChunkEdgeLods full_res_edges{ 0, 0, 0, 0 };
+    for (unsigned i = 0; i < m_chunks.size(); i++)
+    {
+        const uint_buffer indices = buildChunkIndices(i, 0, full_res_edges);
+        std::copy(indices.begin(), indices.end(), m_indexMemory.begin() + m_chunks[i].m_startIdx);
+    }
+    m_topologyRevision++;
+}
+
+void TerrainGeometry::updateChunkBounds(unsigned vtx_offset, unsigned vtx_count)
+{
+    if ((m_chunks.empty()) || (vtx_count == 0)) return;
+    auto [start_x, start_z] = revertVertexIndex(vtx_offset);
+    auto [end_x, end_z] = revertVertexIndex(std::min(vtx_offset + vtx_count, static_cast<unsigned>(m_heightMap.size())) - 1);
+    if (start_z != end_z)
+    {
+        start_x = 0;
+        end_x = m_numCols;
+    }
+    updateChunkBounds(start_x, start_z, end_x, end_z);
+}
+
+void TerrainGeometry::updateChunkBounds(unsigned start_x, unsigned start_z, unsigned end_x, unsigned end_z)
+{
+    if (m_chunks.empty()) return;
+    // chunk 邊界上的 vertex 同時屬於兩邊的 chunk
+    const unsigned chunk_start_x = (start_x > 0 ? start_x - 1 : 0) / m_chunkCellCount;
+    const unsigned chunk_start_z = (start_z > 0 ? start_z - 1 : 0) / m_chunkCellCount;
+    const unsigned chunk_end_x = std::min(end_x / m_chunkCellCount, m_chunkCountX - 1);
+    const unsigned chunk_end_z = std::min(end_z / m_chunkCellCount, m_chunkCountZ - 1);
+    for (unsigned cz = chunk_start_z; cz <= chunk_end_z; cz++)
+    {
+        for (unsigned cx = chunk_start_x; cx <= chunk_end_x; cx++)
+        {
+            calculateChunkBound(m_chunks[cz * m_chunkCountX + cx]);
+        }
+    }
+}
+
+void TerrainGeometry::calculateChunkBound(Chunk& chunk) const
+{
+    float min_corner[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float max_corner[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    auto expand = [&min_corner, &max_corner](const Vector3& pos)
+        {
+            const float* p = static_cast<const float*>(pos);
+            for (unsigned axis = 0; axis < 3; axis++)
+            {
+                min_corner[axis] = std::min(min_corner[axis], p[axis]);
+                max_corner[axis] = std::max(max_corner[axis], p[axis]);
+            }
+        };
+    const auto position_view = positionView();
+    for (unsigned z = chunk.m_startCellZ; z <= chunk.m_startCellZ + chunk.m_cellCountZ; z++)
+    {
+        const unsigned offset = convertVertexIndex(chunk.m_startCellX, z);
+        if (position_view.empty())
+        {
+            for (const auto& pos : getPosition3Array(offset, chunk.m_cellCountX + 1)) expand(pos);
+            continue;
+        }
+        for (unsigned i = 0; i <= chunk.m_cellCountX; i++) expand(position_view[offset + i]);
+    }
+    Vector3 corners[2] = { Vector3(min_corner[0], min_corner[1], min_corner[2]), Vector3(max_corner[0], max_corner[1], max_corner[2]) };
+    chunk.m_minPosition = corners[0];
+    chunk.m_maxPosition = corners[1];
+    chunk.m_bound = BoundingVolume{ ContainmentBox3::ComputeAlignedBox(corners, 2) };
+}
+
+bool TerrainGeometry::isInsideGrid(float grid_x, float grid_z) const
+{
+    return (grid_x >= -GridEdgeTolerance) && (grid_z >= -GridEdgeTolerance)
+        && (grid_x <= static_cast<float>(m_numCols) + GridEdgeTolerance) && (grid_z <= static_cast<float>(m_numRows) + GridEdgeTolerance);
+}
+
+std::optional<float> TerrainGeometry::heightAt(float x, float z) const
+{
+    if (m_heightBoundLevels.empty()) return std::nullopt;
+    const float gx = (x - m_gridOriginX) / m_gridSpacingX;
+    const float gz = (z - m_gridOriginZ) / m_gridSpacingZ;
+    if (!isInsideGrid(gx, gz)) return std::nullopt;
+    const unsigned ix = std::min(static_cast<unsigned>(std::max(gx, 0.0f)), m_numCols - 1);
+    const unsigned iz = std::min(static_cast<unsigned>(std::max(gz, 0.0f)), m_numRows - 1);
+    const float fx = gx - static_cast<float>(ix);
+    const float fz = gz - static_cast<float>(iz);
+    const unsigned stride = m_numCols + 1;
+    const float* h = &m_heightMap[iz * stride + ix];
+    const float h0 = h[0] + (h[1] - h[0]) * fx;
+    const float h1 = h[stride] + (h[stride + 1] - h[stride]) * fx;
+    return h0 + (h1 - h0) * fz;
+}
+
+std::optional<Vector3> TerrainGeometry::normalAt(float x, float z) const
+{
+    if (m_heightBoundLevels.empty()) return std::nullopt;
+    const float gx = (x - m_gridOriginX) / m_gridSpacingX;
+    const float gz = (z - m_gridOriginZ) / m_gridSpacingZ;
+    if (!isInsideGrid(gx, gz)) return std::nullopt;
+    const unsigned ix = std::min(static_cast<unsigned>(std::max(gx, 0.0f)), m_numCols - 1);
+    const unsigned iz = std::min(static_cast<unsigned>(std::max(gz, 0.0f)), m_numRows - 1);
+    const float fx = gx - static_cast<float>(ix);
+    const float fz = gz - static_cast<float>(iz);
+    const unsigned stride = m_numCols + 1;
+    const float* h = &m_heightMap[iz * stride + ix];
+    // bilinear 曲面的偏微分, 換回 model space 的斜率
+    const float dh_dgx = (h[1] - h[0]) * (1.0f - fz) + (h[stride + 1] - h[stride]) * fz;
+    const float dh_dgz = (h[stride] - h[0]) * (1.0f - fx) + (h[stride + 1] - h[1]) * fx;
+    return Vector3(-dh_dgx / m_gridSpacingX, 1.0f, -dh_dgz / m_gridSpacingZ).normalize();
+}
+
+std::vector<float> TerrainGeometry::heightsAt(const std::vector<Vector3>& positions, float out_of_range_height) const
+{
+    std::vector<float> heights(positions.size(), out_of_range_height);
+    if (m_heightBoundLevels.empty()) return heights;
+    const float inv_spacing_x = 1.0f / m_gridSpacingX;
+    const float inv_spacing_z = 1.0f / m_gridSpacingZ;
+    const float max_gx = static_cast<float>(m_numCols) + GridEdgeTolerance;
+    const float max_gz = static_cast<float>(m_numRows) + GridEdgeTolerance;
+    const unsigned stride = m_numCols + 1;
+    const float* height_map = m_heightMap.data();
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        const float gx = (positions[i].x() - m_gridOriginX) * inv_spacing_x;
+        const float gz = (positions[i].z() - m_gridOriginZ) * inv_spacing_z;
+        if ((gx < -GridEdgeTolerance) || (gz < -GridEdgeTolerance) || (gx > max_gx) || (gz > max_gz)) continue;
+        const unsigned ix = std::min(static_cast<unsigned>(std::max(gx, 0.0f)), m_numCols - 1);
+        const unsigned iz = std::min(static_cast<unsigned>(std::max(gz, 0.0f)), m_numRows - 1);
+        const float fx = gx - static_cast<float>(ix);
+        const float fz = gz - static_cast<float>(iz);
+        const float* h = height_map + iz * stride + ix;
+        const float h0 = h[0] + (h[1] - h[0]) * fx;
+        const float h1 = h[stride] + (h[stride + 1] - h[stride]) * fx;
+        heights[i] = h0 + (h1 - h0) * fz;
+    }
+    return heights;
+}
+
+std::optional<float> TerrainGeometry::castRay(const Ray3& ray) const
+{
+    if (m_heightBoundLevels.empty()) return std::nullopt;
+    float nearest_t = FLT_MAX;
+    castRayInNode(ray, static_cast<unsigned>(m_heightBoundLevels.size() - 1), 0, 0, nearest_t);
+    if (nearest_t == FLT_MAX) return std::nullopt;
+    return nearest_t;
+}
+
+void TerrainGeometry::castRayInNode(const Ray3& ray, unsigned level, unsigned node_x, unsigned node_z, float& nearest_t) const
+{
+    const unsigned node_cells = HeightBoundBlockCellCount << level;
+    const unsigned x0 = node_x * node_cells;
+    const unsigned z0 = node_z * node_cells;
+    const unsigned x1 = std::min(x0 + node_cells, m_numCols);
+    const unsigned z1 = std::min(z0 + node_cells, m_numRows);
+    const auto clipped = clipRayToBox(ray, x0, z0, x1, z1, m_heightBoundLevels[level][node_z * heightBoundLevelWidth(level) + node_x], nearest_t);
+    if (!clipped) return;
+    if (level == 0)
+    {
+        castRayInBlock(ray, x0, z0, x1, z1, clipped->first, clipped->second, nearest_t);
+        return;
+    }
+
+    // 子節點依 ray 進入的先後走訪, 比目前最近交點還遠的就不用看
+    const unsigned child_level = level - 1;
+    const unsigned child_cells = HeightBoundBlockCellCount << child_level;
+    const unsigned child_width = heightBoundLevelWidth(child_level);
+    const unsigned child_height = heightBoundLevelHeight(child_level);
+    std::array<std::pair<float, std::pair<unsigned, unsigned>>, 4> children;
+    unsigned child_count = 0;
+    for (unsigned cz = node_z * 2; cz < std::min(node_z * 2 + 2, child_height); cz++)
+    {
+        for (unsigned cx = node_x * 2; cx < std::min(node_x * 2 + 2, child_width); cx++)
+        {
+            const auto child_clipped = clipRayToBox(ray, cx * child_cells, cz * child_cells,
+                std::min((cx + 1) * child_cells, m_numCols), std::min((cz + 1) * child_cells, m_numRows),
+                m_heightBoundLevels[child_level][cz * child_width + cx], nearest_t);
+            if (child_clipped) children[child_count++] = { child_clipped->first, { cx, cz } };
+        }
+    }
+    // 最多 4 個, insertion sort 就好
+    for (unsigned i = 1; i < child_count; i++)
+    {
+        const auto child = children[i];
+        unsigned j = i;
+        for (; (j > 0) && (child.first < children[j - 1].first); j--) children[j] = children[j - 1];
+        children[j] = child;
+    }
+    for (unsigned i = 0; i < child_count; i++)
+    {
+        if (children[i].first >= nearest_t) break;
+        castRayInNode(ray, child_level, children[i].second.first, children[i].second.second, nearest_t);
+    }
+}
+
+void TerrainGeometry::castRayInBlock(const Ray3& ray, unsigned x0, unsigned z0, unsigned x1, unsigned z1,
+    float t_enter, float t_exit, float& nearest_t) const
+{
+    // grid space 中的 ray, 線性換算不改變 t
+    const float origin_gx = (ray.origin().x() - m_gridOriginX) / m_gridSpacingX;
+    const float origin_gz = (ray.origin().z() - m_gridOriginZ) / m_gridSpacingZ;
+    const float dir_gx = ray.direction().x() / m_gridSpacingX;
+    const float dir_gz = ray.direction().z() / m_gridSpacingZ;
+    int cell_x = std::clamp(static_cast<int>(std::floor(origin_gx + t_enter * dir_gx)), static_cast<int>(x0), static_cast<int>(x1) - 1);
+    int cell_z = std::clamp(static_cast<int>(std::floor(origin_gz + t_enter * dir_gz)), static_cast<int>(z0), static_cast<int>(z1) - 1);
+    const int step_x = dir_gx > 0.0f ? 1 : -1;
+    const int step_z = dir_gz > 0.0f ? 1 : -1;
+    float t_next_x = dir_gx != 0.0f ? (static_cast<float>(cell_x + (dir_gx > 0.0f ? 1 : 0)) - origin_gx) / dir_gx : FLT_MAX;
+    float t_next_z = dir_gz != 0.0f ? (static_cast<float>(cell_z + (dir_gz > 0.0f ? 1 : 0)) - origin_gz) / dir_gz : FLT_MAX;
+    const float t_delta_x = dir_gx != 0.0f ? std::fabs(1.0f / dir_gx) : FLT_MAX;
+    const float t_delta_z = dir_gz != 0.0f ? std::fabs(1.0f / dir_gz) : FLT_MAX;
+    const unsigned stride = m_numCols + 1;
+
+    float t = t_enter;
+    while (true)
+    {
+        const float t_cell_exit = std::min({ t_next_x, t_next_z, t_exit });
+        const unsigned x = static_cast<unsigned>(cell_x);
+        const unsigned z = static_cast<unsigned>(cell_z);
+        const float* h = &m_heightMap[z * stride + x];
+        const float cell_min = std::min({ h[0], h[1], h[stride], h[stride + 1] });
+        const float cell_max = std::max({ h[0], h[1], h[stride], h[stride + 1] });
+        const float y_enter = ray.origin().y() + t * ray.direction().y();
+        const float y_exit = ray.origin().y() + t_cell_exit * ray.direction().y();
+        if ((std::max(y_enter, y_exit) >= cell_min) && (std::min(y_enter, y_exit) <= cell_max))
+        {
+            const Vector3 v00 = gridVertexPosition(x, z);
+            const Vector3 v10 = gridVertexPosition(x + 1, z);
+            const Vector3 v01 = gridVertexPosition(x, z + 1);
+            const Vector3 v11 = gridVertexPosition(x + 1, z + 1);
+            // 跟 geometry 的 triangle 切法一致
+            auto hit = intersectRayTriangle(ray, v00, v01, v11);
+            if (auto hit2 = intersectRayTriangle(ray, v00, v11, v10); (hit2) && ((!hit) || (hit2.value() < hit.value()))) hit = hit2;
+            if ((hit) && (hit.value() < nearest_t))
+            {
+                // DDA 由近到遠, block 內第一個打到的就是最近的
+                nearest_t = hit.value();
+                return;
+            }
+        }
+        if (t_cell_exit >= t_exit) return;
+        if (t_next_x < t_next_z)
+        {
+            cell_x += step_x;
+            t = t_next_x;
+            t_next_x += t_delta_x;
+        }
+        else
+        {
+            cell_z += step_z;
+            t = t_next_z;
+            t_next_z += t_delta_z;
+        }
+        if ((cell_x < static_cast<int>(x0)) || (cell_x >= static_cast<int>(x1)) || (cell_z < static_cast<int>(z0)) || (cell_z >= static_cast<int>(z1))) return;
+    }
+}
+
+std::optional<std::pair<float, float>> TerrainGeometry::clipRayToBox(const Ray3& ray, unsigned x0, unsigned z0, unsigned x1, unsigned z1,
+    const HeightBound& bound, float t_max) const
+{
+    const float xa = m_gridOriginX + static_cast<float>(x0) * m_gridSpacingX;
+    const float xb = m_gridOriginX + static_cast<float>(x1) * m_gridSpacingX;
+    const float za = m_gridOriginZ + static_cast<float>(z0) * m_gridSpacingZ;
+    const float zb = m_gridOriginZ + static_cast<float>(z1) * m_gridSpacingZ;
+    const float box_min[3] = { std::min(xa, xb), bound.m_min, std::min(za, zb) };
+    const float box_max[3] = { std::max(xa, xb), bound.m_max, std::max(za, zb) };
+    const float origin[3] = { ray.origin().x(), ray.origin().y(), ray.origin().z() };
+    const float direction[3] = { ray.direction().x(), ray.direction().y(), ray.direction().z() };
+    float t0 = 0.0f;
+    float t1 = t_max;
+    for (unsigned axis = 0; axis < 3; axis++)
+    {
+        if (std::fabs(direction[axis]) < FLT_EPSILON)
+        {
+            if ((origin[axis] < box_min[axis]) || (origin[axis] > box_max[axis])) return std::nullopt;
+            continue;
+        }
+        const float inv_dir = 1.0f / direction[axis];
+        float t_near = (box_min[axis] - origin[axis]) * inv_dir;
+        float t_far = (box_max[axis] - origin[axis]) * inv_dir;
+        if (t_near > t_far) std::swap(t_near, t_far);
+        t0 = std::max(t0, t_near);
+        t1 = std::min(t1, t_far);
+        if (t0 > t1) return std::nullopt;
+    }
+    return std::make_pair(t0, t1);
+}
+
+Vector3 TerrainGeometry::gridVertexPosition(unsigned x, unsigned z) const
+{
+    return Vector3(m_gridOriginX + static_cast<float>(x) * m_gridSpacingX, m_heightMap[convertVertexIndex(x, z)],
+        m_gridOriginZ + static_cast<float>(z) * m_gridSpacingZ);
+}
+
+void TerrainGeometry::calculateGridMapping()
+{
+    m_gridOriginX = m_minPosition.x();
+    m_gridOriginZ = m_minPosition.z();
+    m_gridSpacingX = m_gridSpacingZ = 0.0f;
+    if ((m_numRows == 0) || (m_numCols == 0)) return;
+    const auto cell_dimension = getCellDimension();
+    m_gridSpacingX = cell_dimension.m_width;
+    m_gridSpacingZ = cell_dimension.m_height;
+    if (m_vtxUsedCount < (m_numRows + 1) * (m_numCols + 1)) return;
+    // 以 vertex 實際位置為準, 跟畫出來的 triangle 一致
+    const Vector3 origin = getPosition3Array(convertVertexIndex(0, 0), 1)[0];
+    const Vector3 corner_x = getPosition3Array(convertVertexIndex(m_numCols, 0), 1)[0];
+    const Vector3 corner_z = getPosition3Array(convertVertexIndex(0, m_numRows), 1)[0];
+    m_gridOriginX = origin.x();
+    m_gridOriginZ = origin.z();
+    m_gridSpacingX = (corner_x.x() - origin.x()) / static_cast<float>(m_numCols);
+    m_gridSpacingZ = (corner_z.z() - origin.z()) / static_cast<float>(m_numRows);
+}
+
+void TerrainGeometry::buildHeightBounds()
+{
+    m_heightBoundLevels.clear();
+    if ((m_numRows == 0) || (m_numCols == 0) || (m_heightMap.size() < (m_numRows + 1) * (m_numCols + 1))) return;
+    if ((m_gridSpacingX == 0.0f) || (m_gridSpacingZ == 0.0f)) return;
+
+    unsigned width = heightBoundLevelWidth(0);
+    unsigned height = heightBoundLevelHeight(0);
+    std::vector<HeightBound> leaves(width * height);
+    for (unsigned bz = 0; bz < height; bz++)
+    {
+        for (unsigned bx = 0; bx < width; bx++)
+        {
+            leaves[bz * width + bx] = calculateBlockHeightBound(bx, bz);
+        }
+    }
+    m_heightBoundLevels.emplace_back(std::move(leaves));
+    while ((width > 1) || (height > 1))
+    {
+        const unsigned parent_width = (width + 1) / 2;
+        const unsigned parent_height = (height + 1) / 2;
+        const auto& children = m_heightBoundLevels.back();
+        std::vector<HeightBound> parents(parent_width * parent_height, { FLT_MAX, -FLT_MAX });
+        for (unsigned cz = 0; cz < height; cz++)
+        {
+            for (unsigned cx = 0; cx < width; cx++)
+            {
+                auto& parent = parents[(cz / 2) * parent_width + cx / 2];
+                parent.m_min = std::min(parent.m_min, children[cz * width + cx].m_min);
+                parent.m_max = std::max(parent.m_max, children[cz * width + cx].m_max);
+            }
+        }
+        m_heightBoundLevels.emplace_back(std::move(parents));
+        width = parent_width;
+        height = parent_height;
+    }
+}
+
+void TerrainGeometry::refreshHeightBounds(unsigned x, unsigned z)
+{
+    if (m_heightBoundLevels.empty()) return;
+    // block 邊界上的 vertex 同時屬於兩邊的 block
+    std::vector<std::pair<unsigned, unsigned>> nodes;
+    const unsigned block_x = std::min(x / HeightBoundBlockCellCount, heightBoundLevelWidth(0) - 1);
+    const unsigned block_z = std::min(z / HeightBoundBlockCellCount, heightBoundLevelHeight(0) - 1);
+    const bool is_on_x_border = (x > 0) && (x % HeightBoundBlockCellCount == 0) && (block_x * HeightBoundBlockCellCount == x);
+    const bool is_on_z_border = (z > 0) && (z % HeightBoundBlockCellCount == 0) && (block_z * HeightBoundBlockCellCount == z);
+    for (unsigned bz = is_on_z_border ? block_z - 1 : block_z; bz <= block_z; bz++)
+    {
+        for (unsigned bx = is_on_x_border ? block_x - 1 : block_x; bx <= block_x; bx++)
+        {
+            nodes.emplace_back(bx, bz);
+            m_heightBoundLevels[0][bz * heightBoundLevelWidth(0) + bx] = calculateBlockHeightBound(bx, bz);
+        }
+    }
+    for (unsigned level = 1; level < m_heightBoundLevels.size(); level++)
+    {
+        for (auto& node : nodes)
+        {
+            node = { node.first / 2, node.second / 2 };
+        }
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        const unsigned width = heightBoundLevelWidth(level);
+        const unsigned child_width = heightBoundLevelWidth(level - 1);
+        const unsigned child_height = heightBoundLevelHeight(level - 1);
+        for (const auto& [nx, nz] : nodes)
+        {
+            HeightBound bound{ FLT_MAX, -FLT_MAX };
+            for (unsigned cz = nz * 2; cz < std::min(nz * 2 + 2, child_height); cz++)
+            {
+                for (unsigned cx = nx * 2; cx < std::min(nx * 2 + 2, child_width); cx++)
+                {
+                    bound.m_min = std::min(bound.m_min, m_heightBoundLevels[level - 1][cz * child_width + cx].m_min);
+                    bound.m_max = std::max(bound.m_max, m_heightBoundLevels[level - 1][cz * child_width + cx].m_max);
+                }
+            }
+            m_heightBoundLevels[level][nz * width + nx] = bound;
+        }
+    }
+}
+
+TerrainGeometry::HeightBound TerrainGeometry::calculateBlockHeightBound(unsigned block_x, unsigned block_z) const
+{
+    const unsigned x0 = block_x * HeightBoundBlockCellCount;
+    const unsigned z0 = block_z * HeightBoundBlockCellCount;
+    const unsigned x1 = std::min(x0 + HeightBoundBlockCellCount, m_numCols);
+    const unsigned z1 = std::min(z0 + HeightBoundBlockCellCount, m_numRows);
+    HeightBound bound{ FLT_MAX, -FLT_MAX };
+    for (unsigned z = z0; z <= z1; z++)
+    {
+        const float* row = &m_heightMap[z * (m_numCols + 1)];
+        for (unsigned x = x0; x <= x1; x++)
+        {
+            bound.m_min = std::min(bound.m_min, row[x]);
+            bound.m_max = std::max(bound.m_max, row[x]);
+        }
+    }
+    return bound;
+}
+
+unsigned TerrainGeometry::heightBoundLevelWidth(unsigned level) const
+{
+    unsigned width = (m_numCols + HeightBoundBlockCellCount - 1) / HeightBoundBlockCellCount;
+    for (unsigned l = 0; l < level; l++) width = (width + 1) / 2;
+    return width;
+}
+
+unsigned TerrainGeometry::heightBoundLevelHeight(unsigned level) const
+{
+    unsigned height = (m_numRows + HeightBoundBlockCellCount - 1) / HeightBoundBlockCellCount;
+    for (unsigned l = 0; l < level; l++) height = (height + 1) / 2;
+    return height;
+}
@@ -10,12 +10,47 @@
 
 #include "Geometries/TriangleList.h"
 #include "MathLib/AlgebraBasicTypes.h"
+#include "GameEngine/BoundingVolume.h"
+#include "MathLib/Ray3.h"
+#include <array>
+#include <optional>
+#include <vector>
 
 namespace Enigma::Terrain
 {
     class TerrainGeometry : public Geometries::TriangleList
     {
         DECLARE_EN_RTTI;
+    public:
+        static constexpr unsigned DefaultChunkCellCount = 32;
+        /// min/max height quadtree 的葉節點大小 (cells)
+        static constexpr unsigned HeightBoundBlockCellCount = 8;
+        /// 重算 normal 的 vertex 數超過這個值, 而且有 job system 時才分給 job system
+        static constexpr unsigned ParallelNormalVertexCount = 128 * 128;
+
+        enum class ChunkEdge
+        {
+            Left = 0,  ///< -x
+            Right,  ///< +x
+            Bottom,  ///< -z
+            Top,  ///< +z
+            Count,
+        };
+        using ChunkEdgeLods = std::array<unsigned, static_cast<size_t>(ChunkEdge::Count)>;
+        /** 固定大小的區塊, 共用整張 grid 的 vertex, index 在 index memory 中各自一段 */
+        struct Chunk
+        {
+            unsigned m_startCellX;
+            unsigned m_startCellZ;
+            unsigned m_cellCountX;
+            unsigned m_cellCountZ;
+            unsigned m_startIdx;  ///< index memory 中的起點, 存放 full res (lod 0) index
+            unsigned m_maxIdxCount;
+            unsigned m_maxLod;  ///< lod l 的格距為 2^l cells
+            MathLib::Vector3 m_minPosition;
+            MathLib::Vector3 m_maxPosition;
+            Engine::BoundingVolume m_bound;  ///< model space
+        };
     public:
         TerrainGeometry(const Geometries::GeometryId& id);
         TerrainGeometry(const Geometries::GeometryId& id, const Engine::GenericDto& o);
@@ -31,6 +66,12 @@ namespace Enigma::Terrain
         void rangedUpdateHeightMapToVertexMemory(unsigned offset, unsigned count);
         void updateVertexNormals();
         void rangedUpdateVertexNormals(unsigned offset, unsigned count);
+        /** @name 只更新 grid 上的矩形區域 (vertex x, z, 含邊界), 筆刷編輯用 */
+        //@{
+        void rectUpdateHeightMapToVertexMemory(unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z);
+        /** 範圍外擴一圈, 大範圍時分列給多個 thread 計算 */
+        void rectUpdateVertexNormals(unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z);
+        //@}
 
         MathLib::Dimension<float> getCellDimension() const;
         unsigned getNumRows() const { return m_numRows; }
@@ -46,6 +87,56 @@ namespace Enigma::Terrain
 
         std::tuple<unsigned, unsigned> locateCell(const MathLib::Vector3& position) const;
 
+        /** @name height field queries, model space, 超出 terrain 範圍回傳 nullopt */
+        //@{
+        /** bilinear height */
+        std::optional<float> heightAt(float x, float z) const;
+        /** bilinear height field 的法向 */
+        std::optional<MathLib::Vector3> normalAt(float x, float z) const;
+        /** 依 positions 的 x, z 查 height, 範圍外的填 out_of_range_height */
+        std::vector<float> heightsAt(const std::vector<MathLib::Vector3>& positions, float out_of_range_height) const;
+        //@}
+
+        virtual bool canCastRay() const override { return !m_heightBoundLevels.empty(); }
+        /** min/max quadtree 由近到遠跳過空的區域, 葉節點內以 2D DDA 逐格測 triangle */
+        virtual std::optional<float> castRay(const MathLib::Ray3& ray) const override;
+
+        unsigned getChunkCellCount() const { return m_chunkCellCount; }
+        unsigned getChunkCountX() const { return m_chunkCountX; }
+        unsigned getChunkCountZ() const { return m_chunkCountZ; }
+        const std::vector<Chunk>& getChunks() const { return m_chunks; }
+        std::optional<unsigned> getNeighborChunk(unsigned chunk_index, ChunkEdge edge) const;
+        /** geomipmapping index, edge_lods 為相鄰 chunk 的 lod, 較粗的邊縫合到相鄰 chunk 的 vertex 上, 不會有裂縫 */
+        uint_buffer buildChunkIndices(unsigned chunk_index, unsigned lod, const ChunkEdgeLods& edge_lods) const;
+
+    protected:
+        /** 切 chunk, index memory 改成依 chunk 排列 (lod 0) */
+        void buildChunks();
+        void updateChunkBounds(unsigned vtx_offset, unsigned vtx_count);
+        void updateChunkBounds(unsigned start_x, unsigned start_z, unsigned end_x, unsigned end_z);
+        void calculateChunkBound(Chunk& chunk) const;
+
+        struct HeightBound
+        {
+            float m_min;
+            float m_max;
+        };
+        /** vertex 的 x, z 由 grid index 線性換算 */
+        void calculateGridMapping();
+        bool isInsideGrid(float grid_x, float grid_z) const;
+        void buildHeightBounds();
+        void refreshHeightBounds(unsigned x, unsigned z);
+        HeightBound calculateBlockHeightBound(unsigned block_x, unsigned block_z) const;
+        unsigned heightBoundLevelWidth(unsigned level) const;
+        unsigned heightBoundLevelHeight(unsigned level) const;
+        void castRayInNode(const MathLib::Ray3& ray, unsigned level, unsigned node_x, unsigned node_z, float& nearest_t) const;
+        void castRayInBlock(const MathLib::Ray3& ray, unsigned x0, unsigned z0, unsigned x1, unsigned z1,
+            float t_enter, float t_exit, float& nearest_t) const;
+        /** ray 跟 node 的 box (grid x, z 範圍 + 高度範圍) 的交集 */
+        std::optional<std::pair<float, float>> clipRayToBox(const MathLib::Ray3& ray, unsigned x0, unsigned z0, unsigned x1, unsigned z1,
+            const HeightBound& bound, float t_max) const;
+        MathLib::Vector3 gridVertexPosition(unsigned x, unsigned z) const;
+
     protected:
         unsigned m_numRows;
         unsigned m_numCols;
@@ -54,6 +145,17 @@ namespace Enigma::Terrain
         MathLib::Vector2 m_minTextureCoordinate;
         MathLib::Vector2 m_maxTextureCoordinate;
         float_buffer m_heightMap;
+        unsigned m_chunkCellCount;
+        unsigned m_chunkCountX;
+        unsigned m_chunkCountZ;
+        std::vector<Chunk> m_chunks;
+
+        float m_gridOriginX;
+        float m_gridOriginZ;
+        float m_gridSpacingX;
+        float m_gridSpacingZ;
+        /// level 0 為葉節點 (block), 往上每層 2x2 合併, 最上層只有一個 node
+        std::vector<std::vector<HeightBound>> m_heightBoundLevels;
     };
 }
 
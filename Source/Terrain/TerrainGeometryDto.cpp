@@ -17,17 +17,20 @@ static std::string TOKEN_MAX_POSITION = "MaxPosition";
 static std::string TOKEN_MIN_TEXTURE_COORDINATE = "MinTextureCoordinate";
 static std::string TOKEN_MAX_TEXTURE_COORDINATE = "MaxTextureCoordinate";
 static std::string TOKEN_HEIGHT_MAP = "HeightMap";
+static std::string TOKEN_CHUNK_CELL_COUNT = "ChunkCellCount";
 
 TerrainGeometryDto::TerrainGeometryDto() : TriangleListDto()
 {
     m_factoryDesc = Engine::FactoryDesc(TerrainGeometry::TYPE_RTTI.getName());
     m_numRows = m_numCols = 1;
+    m_chunkCellCount = TerrainGeometry::DefaultChunkCellCount;
 }
 
 TerrainGeometryDto::TerrainGeometryDto(const TriangleListDto& triangle_dto) : TriangleListDto(triangle_dto)
 {
     assert(Frameworks::Rtti::isExactlyOrDerivedFrom(m_factoryDesc.GetRttiName(), TerrainGeometry::TYPE_RTTI.getName()));
     m_numRows = m_numCols = 1;
+    m_chunkCellCount = TerrainGeometry::DefaultChunkCellCount;
 }
 
 void TerrainGeometryDto::convertGeometryVertices()
@@ -126,6 +129,7 @@ TerrainGeometryDto TerrainGeometryDto::fromGenericDto(const Engine::GenericDto&
     if (auto v = dto.tryGetValue<Vector3>(TOKEN_MAX_POSITION)) terrain_dto.m_maxPosition = v.value();
     if (auto v = dto.tryGetValue<Vector2>(TOKEN_MIN_TEXTURE_COORDINATE)) terrain_dto.m_minTextureCoordinate = v.value();
     if (auto v = dto.tryGetValue<Vector2>(TOKEN_MAX_TEXTURE_COORDINATE)) terrain_dto.m_maxTextureCoordinate = v.value();
+    if (auto v = dto.tryGetValue<unsigned>(TOKEN_CHUNK_CELL_COUNT)) terrain_dto.m_chunkCellCount = v.value();
     if (auto v = dto.tryGetValue<float_buffer>(TOKEN_HEIGHT_MAP)) terrain_dto.m_heightMap = v.value();
     return terrain_dto;
 }
@@ -141,6 +145,7 @@ GenericDto TerrainGeometryDto::toGenericDto() const
     dto.addOrUpdate(TOKEN_MAX_POSITION, m_maxPosition);
     dto.addOrUpdate(TOKEN_MIN_TEXTURE_COORDINATE, m_minTextureCoordinate);
     dto.addOrUpdate(TOKEN_MAX_TEXTURE_COORDINATE, m_maxTextureCoordinate);
+    dto.addOrUpdate(TOKEN_CHUNK_CELL_COUNT, m_chunkCellCount);
     if (m_heightMap)
     {
         dto.addOrUpdate(TOKEN_HEIGHT_MAP, m_heightMap.value());
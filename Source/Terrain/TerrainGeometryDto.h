@@ -36,6 +36,9 @@ namespace Enigma::Terrain
         [[nodiscard]] MathLib::Vector2 maxTextureCoordinate() const { return m_maxTextureCoordinate; }
         MathLib::Vector2& maxTextureCoordinate() { return m_maxTextureCoordinate; }
 
+        [[nodiscard]] unsigned chunkCellCount() const { return m_chunkCellCount; }
+        unsigned& chunkCellCount() { return m_chunkCellCount; }
+
         [[nodiscard]] std::optional<float_buffer> heightMap() const { return m_heightMap; }
         std::optional<float_buffer>& heightMap() { return m_heightMap; }
 
@@ -53,6 +56,7 @@ namespace Enigma::Terrain
         MathLib::Vector3 m_maxPosition;
         MathLib::Vector2 m_minTextureCoordinate;
         MathLib::Vector2 m_maxTextureCoordinate;
+        unsigned m_chunkCellCount;
         std::optional<float_buffer> m_heightMap;
     };
 }
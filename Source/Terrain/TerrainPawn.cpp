@@ -1,5 +1,9 @@
 ﻿#include "TerrainPawn.h"
 #include "TerrainPawnDto.h"
+#include "TerrainPrimitive.h"
+#include "SceneGraph/Culler.h"
+#include "SceneGraph/Camera.h"
+#include "SceneGraph/SceneGraphErrors.h"
 
 using namespace Enigma::Terrain;
 using namespace Enigma::SceneGraph;
@@ -37,3 +41,28 @@ GenericDto TerrainPawn::serializeDto()
     TerrainPawnDto dto(SerializePawnDto());
     return dto.toGenericDto();
 }
+
+error TerrainPawn::onCullingVisible(Culler* culler, bool noCull)
+{
+    assert(culler);
+    const auto terrain_primitive = std::dynamic_pointer_cast<TerrainPrimitive>(m_primitive);
+    const auto terrain = terrain_primitive ? terrain_primitive->getTerrainGeometry() : nullptr;
+    if ((!terrain) || (terrain->getChunks().empty()) || (!culler->GetCamera())) return Pawn::onCullingVisible(culler, noCull);
+
+    const auto& chunks = terrain->getChunks();
+    std::vector<bool> chunk_visibility(chunks.size(), true);
+    if (!noCull)
+    {
+        // IsVisible 會關掉完全在內側的 plane, 每個 chunk 都要從同一組 plane 開始測
+        const auto plane_activations = culler->GetPlaneActivations();
+        for (unsigned i = 0; i < chunks.size(); i++)
+        {
+            chunk_visibility[i] = culler->IsVisible(BoundingVolume::CreateFromTransform(chunks[i].m_bound, m_mxWorldTransform));
+            culler->RestorePlaneBitFlags(plane_activations);
+        }
+    }
+    const MathLib::Vector3 camera_position = m_mxWorldTransform.Inverse().TransformCoord(culler->GetCamera()->location());
+    if (error er = terrain_primitive->selectChunks(culler->GetCamera(), chunk_visibility, camera_position)) return er;
+    if (terrain_primitive->visibleChunkCount(culler->GetCamera()) == 0) return SceneGraph::ErrorCode::ok;
+    return Pawn::onCullingVisible(culler, noCull);
+}
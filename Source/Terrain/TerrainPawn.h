@@ -12,6 +12,8 @@
 
 namespace Enigma::Terrain
 {
+    using error = std::error_code;
+
     class TerrainPawn : public SceneGraph::Pawn
     {
         DECLARE_EN_RTTI;
@@ -28,6 +30,9 @@ namespace Enigma::Terrain
         static std::shared_ptr<TerrainPawn> constitute(const SceneGraph::SpatialId& id, const Engine::GenericDto& o);
 
         virtual Engine::GenericDto serializeDto() override;
+
+        /** 逐 chunk 做 frustum culling, 並依 camera 距離選 chunk lod */
+        virtual error onCullingVisible(SceneGraph::Culler* culler, bool noCull) override;
     };
 }
 
@@ -1,17 +1,30 @@
 ﻿#include "TerrainPrimitive.h"
 #include "TerrainPrimitiveDto.h"
+#include "Renderables/RenderableErrors.h"
+#include "Renderer/Renderer.h"
+#include "SceneGraph/Camera.h"
+#include "Platforms/PlatformLayer.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
 using namespace Enigma::Terrain;
 using namespace Enigma::Renderer;
+using namespace Enigma::MathLib;
+
+/// 沒指定 lod distance 時, 以幾個 chunk 寬度為 lod 0 的範圍
+constexpr float DEFAULT_LOD_DISTANCE_IN_CHUNKS = 2.0f;
+/// cache 的 chunk run element 超過 chunk 數的這個倍數就清掉重來
+constexpr size_t MAX_RUN_ELEMENTS_PER_CHUNK = 4;
 
 DEFINE_RTTI(Terrain, TerrainPrimitive, MeshPrimitive);
 
-TerrainPrimitive::TerrainPrimitive(const Primitives::PrimitiveId& id) : MeshPrimitive(id)
+TerrainPrimitive::TerrainPrimitive(const Primitives::PrimitiveId& id) : MeshPrimitive(id), m_selectionSerial(0)
 {
     m_factoryDesc = Engine::FactoryDesc(TerrainPrimitive::TYPE_RTTI.getName()).ClaimAsInstanced(id.name() + ".terrain");
 }
 
-TerrainPrimitive::TerrainPrimitive(const Primitives::PrimitiveId& id, const Engine::GenericDto& dto, const std::shared_ptr<Geometries::GeometryRepository>& geometry_repository) : MeshPrimitive(id, dto, geometry_repository)
+TerrainPrimitive::TerrainPrimitive(const Primitives::PrimitiveId& id, const Engine::GenericDto& dto, const std::shared_ptr<Geometries::GeometryRepository>& geometry_repository) : MeshPrimitive(id, dto, geometry_repository), m_selectionSerial(0)
 {
 }
 
@@ -36,3 +49,224 @@ Enigma::Engine::GenericDto TerrainPrimitive::serializeDto() const
     return dto.toGenericDto();
 }
 
+
+error TerrainPrimitive::updateRenderBuffer()
+{
+    const error er = MeshPrimitive::updateRenderBuffer();
+    // index buffer 被換回 full res (lod 0), chunk 狀態重來
+    std::lock_guard locker{ m_chunkLock };
+    clearChunkStates();
+    return er;
+}
+
+error TerrainPrimitive::insertToRendererWithTransformUpdating(const std::shared_ptr<Engine::IRenderer>& renderer,
+    const MathLib::Matrix4& mxWorld, const Engine::RenderLightingState& lightingState)
+{
+    if (!m_lazyStatus.isReady()) return Renderables::ErrorCode::ok;
+    std::unique_lock locker{ m_chunkLock };
+    if (!ensureChunkStates())
+    {
+        locker.unlock();
+        return MeshPrimitive::insertToRendererWithTransformUpdating(renderer, mxWorld, lightingState);
+    }
+    const auto render = std::dynamic_pointer_cast<Renderer::Renderer, Engine::IRenderer>(renderer);
+    if (FATAL_LOG_EXPR(!render)) return Renderables::ErrorCode::nullRenderer;
+    m_mxPrimitiveWorld = mxWorld;
+    if (testPrimitiveFlag(Primitive_UnRenderable)) return Renderables::ErrorCode::ok;
+
+    touchResidentTextures();
+    const auto terrain = getTerrainGeometry();
+    const auto& chunks = terrain->getChunks();
+    const auto camera = render->associatedCamera();
+    const CameraChunkSelection* selection = camera ? findCameraSelection(camera.get()) : nullptr;
+    // 看得到, 且 index 接在前一個 chunk 後面的 chunk 併成一個 element
+    std::optional<unsigned> run_first;
+    for (unsigned i = 0; i <= chunks.size(); i++)
+    {
+        const bool is_visible = (i < chunks.size()) && ((!selection) || (selection->m_chunkVisibility[i]));
+        const bool is_continued = (is_visible) && (run_first) && (chunks[i].m_startIdx == chunks[i - 1].m_startIdx + chunks[i - 1].m_maxIdxCount);
+        if ((run_first) && (!is_continued))
+        {
+            if (error er = render->insertRenderElement(chunkRunElement(terrain, run_first.value(), i - 1), mxWorld, lightingState, m_renderListID)) return er;
+            run_first.reset();
+        }
+        if ((is_visible) && (!run_first)) run_first = i;
+    }
+    return Renderables::ErrorCode::ok;
+}
+
+error TerrainPrimitive::removeFromRenderer(const std::shared_ptr<Engine::IRenderer>& renderer)
+{
+    std::unique_lock locker{ m_chunkLock };
+    if (m_chunkStates.empty())
+    {
+        locker.unlock();
+        return MeshPrimitive::removeFromRenderer(renderer);
+    }
+    const auto render = std::dynamic_pointer_cast<Renderer::Renderer, Engine::IRenderer>(renderer);
+    if (FATAL_LOG_EXPR(!render)) return Renderables::ErrorCode::nullRenderer;
+    for (auto& [key, element] : m_chunkRunElements)
+    {
+        render->removeRenderElement(element, m_renderListID);
+    }
+    return Renderables::ErrorCode::ok;
+}
+
+float TerrainPrimitive::lodDistance() const
+{
+    if (m_lodDistance) return m_lodDistance.value();
+    const auto terrain = getTerrainGeometry();
+    if ((!terrain) || (terrain->getChunks().empty())) return 0.0f;
+    const auto cell_dimension = terrain->getCellDimension();
+    return std::max(cell_dimension.m_width, cell_dimension.m_height) * static_cast<float>(terrain->getChunkCellCount()) * DEFAULT_LOD_DISTANCE_IN_CHUNKS;
+}
+
+error TerrainPrimitive::selectChunks(const std::shared_ptr<SceneGraph::Camera>& camera, const std::vector<bool>& chunk_visibility, const MathLib::Vector3& camera_position)
+{
+    assert(camera);
+    std::lock_guard locker{ m_chunkLock };
+    if (!ensureChunkStates()) return Renderables::ErrorCode::ok;
+    const auto terrain = getTerrainGeometry();
+    const auto& chunks = terrain->getChunks();
+
+    const std::uint64_t serial = ++m_selectionSerial;
+    std::uint64_t previous_serial = 0;
+    auto selection = std::find_if(m_cameraSelections.begin(), m_cameraSelections.end(),
+        [&](const CameraChunkSelection& s) { return s.m_camera.lock() == camera; });
+    if (selection == m_cameraSelections.end())
+    {
+        selection = m_cameraSelections.insert(m_cameraSelections.end(), CameraChunkSelection{ camera, {}, camera_position, serial });
+    }
+    else
+    {
+        previous_serial = selection->m_serial;
+    }
+    selection->m_chunkVisibility.resize(chunks.size());
+    for (unsigned i = 0; i < chunks.size(); i++)
+    {
+        selection->m_chunkVisibility[i] = chunk_visibility.empty() || ((i < chunk_visibility.size()) && chunk_visibility[i]);
+    }
+    selection->m_cameraPosition = camera_position;
+    selection->m_serial = serial;
+    // 這個 camera 上次選到現在都沒再選的 camera, 已經不做 culling 了 (或已刪除)
+    m_cameraSelections.erase(std::remove_if(m_cameraSelections.begin(), m_cameraSelections.end(),
+        [=](const CameraChunkSelection& s) { return (s.m_camera.expired()) || (s.m_serial < previous_serial); }), m_cameraSelections.end());
+
+    std::vector<unsigned> lods(chunks.size());
+    for (unsigned i = 0; i < chunks.size(); i++)
+    {
+        unsigned lod = UINT_MAX;
+        for (const auto& s : m_cameraSelections)
+        {
+            if (s.m_chunkVisibility[i]) lod = std::min(lod, selectChunkLod(chunks[i], s.m_cameraPosition));
+        }
+        // 沒有 camera 看得到, 保留原本的 lod, 不用重傳
+        lods[i] = lod == UINT_MAX ? m_chunkStates[i].m_lod : lod;
+    }
+    for (unsigned i = 0; i < chunks.size(); i++)
+    {
+        TerrainGeometry::ChunkEdgeLods edge_lods{ 0, 0, 0, 0 };
+        for (unsigned e = 0; e < static_cast<unsigned>(TerrainGeometry::ChunkEdge::Count); e++)
+        {
+            if (auto neighbor = terrain->getNeighborChunk(i, static_cast<TerrainGeometry::ChunkEdge>(e))) edge_lods[e] = lods[neighbor.value()];
+        }
+        auto& state = m_chunkStates[i];
+        if ((state.m_lod == lods[i]) && (state.m_edgeLods == edge_lods)) continue;
+        state.m_lod = lods[i];
+        state.m_edgeLods = edge_lods;
+        if (error er = uploadChunkIndices(terrain, i)) return er;
+    }
+    return Renderables::ErrorCode::ok;
+}
+
+std::shared_ptr<TerrainGeometry> TerrainPrimitive::getTerrainGeometry() const
+{
+    return std::dynamic_pointer_cast<TerrainGeometry, Geometries::GeometryData>(m_geometry);
+}
+
+unsigned TerrainPrimitive::visibleChunkCount(const std::shared_ptr<SceneGraph::Camera>& camera) const
+{
+    std::lock_guard locker{ m_chunkLock };
+    const CameraChunkSelection* selection = camera ? findCameraSelection(camera.get()) : nullptr;
+    if (!selection) return static_cast<unsigned>(m_chunkStates.size());
+    return static_cast<unsigned>(std::count(selection->m_chunkVisibility.begin(), selection->m_chunkVisibility.end(), true));
+}
+
+std::optional<unsigned> TerrainPrimitive::chunkLod(unsigned chunk_index) const
+{
+    std::lock_guard locker{ m_chunkLock };
+    if (chunk_index >= m_chunkStates.size()) return std::nullopt;
+    return m_chunkStates[chunk_index].m_lod;
+}
+
+bool TerrainPrimitive::ensureChunkStates()
+{
+    const auto terrain = getTerrainGeometry();
+    if ((!terrain) || (!m_renderBuffer) || (m_effects.empty()) || (terrain->getChunks().empty()))
+    {
+        clearChunkStates();
+        return false;
+    }
+    const auto& chunks = terrain->getChunks();
+    if ((m_chunkStates.size() == chunks.size()) && (m_chunkEffect == m_effects[0])) return true;
+
+    // render buffer 裡的 index 跟 geometry 一樣, 是 full res
+    clearChunkStates();
+    m_chunkStates.resize(chunks.size(), ChunkState{ 0, { 0, 0, 0, 0 } });
+    m_chunkEffect = m_effects[0];
+    return true;
+}
+
+void TerrainPrimitive::clearChunkStates()
+{
+    m_chunkStates.clear();
+    m_cameraSelections.clear();
+    m_chunkRunElements.clear();
+    m_chunkEffect = nullptr;
+}
+
+unsigned TerrainPrimitive::selectChunkLod(const TerrainGeometry::Chunk& chunk, const MathLib::Vector3& camera_position) const
+{
+    const float lod_distance = lodDistance();
+    if (lod_distance <= 0.0f) return 0;
+    const Vector3 closest(std::clamp(camera_position.x(), chunk.m_minPosition.x(), chunk.m_maxPosition.x()),
+        std::clamp(camera_position.y(), chunk.m_minPosition.y(), chunk.m_maxPosition.y()),
+        std::clamp(camera_position.z(), chunk.m_minPosition.z(), chunk.m_maxPosition.z()));
+    const float distance = (closest - camera_position).length();
+    if (distance < lod_distance) return 0;
+    const unsigned lod = static_cast<unsigned>(std::log2(distance / lod_distance)) + 1;
+    return std::min(lod, chunk.m_maxLod);
+}
+
+error TerrainPrimitive::uploadChunkIndices(const std::shared_ptr<TerrainGeometry>& terrain, unsigned chunk_index)
+{
+    auto& state = m_chunkStates[chunk_index];
+    const auto& chunk = terrain->getChunks()[chunk_index];
+    uint_buffer indices = terrain->buildChunkIndices(chunk_index, state.m_lod, state.m_edgeLods);
+    assert(indices.size() <= chunk.m_maxIdxCount);
+    // 剩下的 index 補成退化三角形, chunk 的 index 範圍固定, 相鄰 chunk 可以一次畫完
+    indices.resize(chunk.m_maxIdxCount, indices.empty() ? 0 : indices[0]);
+    return m_renderBuffer->RangedUpdateIndex({ chunk.m_startIdx, chunk.m_maxIdxCount, std::move(indices) });
+}
+
+const TerrainPrimitive::CameraChunkSelection* TerrainPrimitive::findCameraSelection(const SceneGraph::Camera* camera) const
+{
+    for (const auto& selection : m_cameraSelections)
+    {
+        if (selection.m_camera.lock().get() == camera) return &selection;
+    }
+    return nullptr;
+}
+
+const std::shared_ptr<RenderElement>& TerrainPrimitive::chunkRunElement(const std::shared_ptr<TerrainGeometry>& terrain, unsigned first_chunk, unsigned last_chunk)
+{
+    const std::uint64_t key = (static_cast<std::uint64_t>(first_chunk) << 32) | last_chunk;
+    if (auto it = m_chunkRunElements.find(key); it != m_chunkRunElements.end()) return it->second;
+    // 不再放入 renderer 的 element 會被 renderer 移出, 這裡只要清 cache
+    if (m_chunkRunElements.size() >= m_chunkStates.size() * MAX_RUN_ELEMENTS_PER_CHUNK) m_chunkRunElements.clear();
+    const auto& chunks = terrain->getChunks();
+    const unsigned start_idx = chunks[first_chunk].m_startIdx;
+    const unsigned idx_count = chunks[last_chunk].m_startIdx + chunks[last_chunk].m_maxIdxCount - start_idx;
+    const Geometries::GeometrySegment segment(0, terrain->getUsedVertexCount(), start_idx, idx_count);
+    return m_chunkRunElements.emplace(key, std::make_shared<RenderElement>(m_renderBuffer, m_chunkEffect, segment)).first->second;
+}
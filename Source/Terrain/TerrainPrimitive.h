@@ -9,9 +9,21 @@
 #define TERRAIN_PRIMITIVE_H
 
 #include "Renderables/MeshPrimitive.h"
+#include "TerrainGeometry.h"
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
+namespace Enigma::SceneGraph
+{
+    class Camera;
+}
 namespace Enigma::Terrain
 {
+    using error = std::error_code;
+
     class TerrainPrimitive : public Renderables::MeshPrimitive
     {
         DECLARE_EN_RTTI;
@@ -27,6 +39,58 @@ namespace Enigma::Terrain
         static std::shared_ptr<Primitives::Primitive> create(const Primitives::PrimitiveId& id);
         static std::shared_ptr<Primitives::Primitive> constitute(const Primitives::PrimitiveId& id, const Engine::GenericDto& dto, const std::shared_ptr<Geometries::GeometryRepository>& geometry_repository);
         virtual Engine::GenericDto serializeDto() const override;
+
+        virtual error updateRenderBuffer() override;
+        /** 只放入 renderer 的 camera 看得到的 chunk, 相鄰的 chunk 合成一個 element;
+            camera 沒有選過 chunk 的 renderer (e.g. shadow caster) 放入全部 chunk; 沒有 chunk 時跟 mesh primitive 一樣整個放入 */
+        virtual error insertToRendererWithTransformUpdating(const std::shared_ptr<Engine::IRenderer>& renderer,
+            const MathLib::Matrix4& mxWorld, const Engine::RenderLightingState& lightingState) override;
+        virtual error removeFromRenderer(const std::shared_ptr<Engine::IRenderer>& renderer) override;
+
+        /** lod 0 的距離上限, 距離每加倍降一級 lod; 未指定時為 chunk 寬度的兩倍, <= 0 : 不做 lod */
+        float lodDistance() const;
+        void lodDistance(float distance) { m_lodDistance = distance; }
+
+        /** 記下這個 camera 的 chunk 可見性 & camera 位置 (model space), 不同 culler 的結果各自保留;
+            每個 chunk 的 lod 取看得到它的 camera 中最細的, lod 改變的 chunk 重建 index 並更新 index buffer
+            @param chunk_visibility 依 chunk index 排列, 空的 : 全部可見 */
+        error selectChunks(const std::shared_ptr<SceneGraph::Camera>& camera, const std::vector<bool>& chunk_visibility, const MathLib::Vector3& camera_position);
+        std::shared_ptr<TerrainGeometry> getTerrainGeometry() const;
+        /** camera 沒有選過時為全部 chunk 數 */
+        unsigned visibleChunkCount(const std::shared_ptr<SceneGraph::Camera>& camera) const;
+        std::optional<unsigned> chunkLod(unsigned chunk_index) const;
+
+    protected:
+        struct ChunkState
+        {
+            unsigned m_lod;
+            TerrainGeometry::ChunkEdgeLods m_edgeLods;
+        };
+        /** 一個 culler 的結果, 主畫面, cascade 等 culler 各有一份, 不會互相覆蓋 */
+        struct CameraChunkSelection
+        {
+            std::weak_ptr<SceneGraph::Camera> m_camera;
+            std::vector<bool> m_chunkVisibility;
+            MathLib::Vector3 m_cameraPosition;
+            std::uint64_t m_serial;  ///< 最後一次選的序號
+        };
+        /** @return false : 沒有 chunk 可用 */
+        bool ensureChunkStates();
+        void clearChunkStates();
+        unsigned selectChunkLod(const TerrainGeometry::Chunk& chunk, const MathLib::Vector3& camera_position) const;
+        error uploadChunkIndices(const std::shared_ptr<TerrainGeometry>& terrain, unsigned chunk_index);
+        const CameraChunkSelection* findCameraSelection(const SceneGraph::Camera* camera) const;
+        /** 涵蓋 first ~ last chunk 的 element, index 是連續的 (lod 用不到的部分補成退化三角形) */
+        const std::shared_ptr<Renderer::RenderElement>& chunkRunElement(const std::shared_ptr<TerrainGeometry>& terrain, unsigned first_chunk, unsigned last_chunk);
+
+    protected:
+        std::vector<ChunkState> m_chunkStates;
+        std::vector<CameraChunkSelection> m_cameraSelections;
+        std::uint64_t m_selectionSerial;
+        std::unordered_map<std::uint64_t, std::shared_ptr<Renderer::RenderElement>> m_chunkRunElements;  ///< key : first chunk << 32 | last chunk
+        std::shared_ptr<Engine::EffectMaterial> m_chunkEffect;
+        mutable std::mutex m_chunkLock;  ///< 不同 culler 可能在不同執行緒
+        std::optional<float> m_lodDistance;
     };
 }
 
@@ -0,0 +1,62 @@
+#include "Frameworks/FrameArena.h"
+#include "Frameworks/menew_make_shared.hpp"
+#include "Frameworks/Event.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    /** 跟 SpatialLocationChanged 差不多大的 event */
+    class BenchmarkEvent : public IEvent
+    {
+    public:
+        BenchmarkEvent(unsigned id) : m_id(id), m_payload{} {}
+        unsigned m_id;
+        float m_payload[6];
+    };
+
+    /// 一個 frame post 的 event 數
+    constexpr unsigned EVENTS_PER_FRAME = 2500;
+}
+
+/** post 的 event 留到下一個 frame 才處理 & 釋放; arg 0 = std::make_shared, 1 = frame arena */
+static void BM_FramePostedEvents(benchmark::State& state)
+{
+    const bool use_arena = state.range(0) != 0;
+    FrameArenaRing ring;
+    ring.advanceFrame();
+    std::vector<IEventPtr> queued_events;
+    queued_events.reserve(EVENTS_PER_FRAME);
+    for (auto _ : state)
+    {
+        for (unsigned i = 0; i < EVENTS_PER_FRAME; i++)
+        {
+            queued_events.emplace_back(use_arena ? stdext::make_frame_shared<BenchmarkEvent>(i) : std::make_shared<BenchmarkEvent>(i));
+        }
+        queued_events.clear();
+        ring.advanceFrame();
+    }
+    ring.deactivate();
+    state.SetItemsProcessed(state.iterations() * EVENTS_PER_FRAME);
+}
+BENCHMARK(BM_FramePostedEvents)->Arg(0)->Arg(1);
+
+/** 配置後馬上釋放 (dispatch 完就丟的 query 的樣子); arg 0 = std::make_shared, 1 = frame arena */
+static void BM_ImmediatelyReleasedMessages(benchmark::State& state)
+{
+    const bool use_arena = state.range(0) != 0;
+    FrameArenaRing ring;
+    ring.advanceFrame();
+    unsigned i = 0;
+    for (auto _ : state)
+    {
+        auto e = use_arena ? stdext::make_frame_shared<BenchmarkEvent>(i++) : std::make_shared<BenchmarkEvent>(i++);
+        benchmark::DoNotOptimize(e.get());
+    }
+    ring.deactivate();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImmediatelyReleasedMessages)->Arg(0)->Arg(1);
@@ -0,0 +1,62 @@
+#include "Frameworks/JobSystem.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    constexpr unsigned ITEM_COUNT = 1 << 16;
+
+    float heavyItem(unsigned i)
+    {
+        float v = static_cast<float>(i);
+        for (int k = 0; k < 64; k++) v = std::sqrt(v * v + 1.0f);
+        return v;
+    }
+}
+
+/** parallelFor 的 scaling, arg 是 worker 數 (0 = 只有呼叫的執行緒) */
+static void BM_JobSystemParallelFor(benchmark::State& state)
+{
+    const unsigned worker_count = static_cast<unsigned>(state.range(0));
+    std::vector<float> results(ITEM_COUNT);
+    auto body = [&results](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; i++) results[i] = heavyItem(i);
+    };
+    if (worker_count == 0)
+    {
+        for (auto _ : state)
+        {
+            body(0, ITEM_COUNT);
+            benchmark::DoNotOptimize(results.data());
+        }
+    }
+    else
+    {
+        JobSystem jobs(worker_count);
+        for (auto _ : state)
+        {
+            jobs.parallelFor("bench", ITEM_COUNT, body);
+            benchmark::DoNotOptimize(results.data());
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * ITEM_COUNT);
+}
+BENCHMARK(BM_JobSystemParallelFor)->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Arg(7)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/** 空 job 的排程成本 */
+static void BM_JobSystemEmptyJobs(benchmark::State& state)
+{
+    JobSystem jobs(static_cast<unsigned>(state.range(0)));
+    for (auto _ : state)
+    {
+        auto counter = std::make_shared<JobCounter>();
+        for (unsigned i = 0; i < 1024; i++) jobs.schedule(counter, "empty", []() {});
+        jobs.wait(counter);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 1024);
+}
+BENCHMARK(BM_JobSystemEmptyJobs)->Arg(1)->Arg(3)->UseRealTime()->Unit(benchmark::kMicrosecond);
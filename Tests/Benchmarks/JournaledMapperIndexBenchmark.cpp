@@ -0,0 +1,194 @@
+#include "FileStorage/JournaledMapperIndex.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/Filename.h"
+#include "FileSystem/StdMountPath.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Enigma::FileStorage;
+
+namespace
+{
+    constexpr const char* BENCHMARK_PATH_ID = "BENCHMARK_MAPPER_PATH";
+    constexpr const char* MAPPER_FILENAME = "texture_mapper.txt@BENCHMARK_MAPPER_PATH";
+    /// 每三個 put 之後 remove 掉其中一個
+    constexpr unsigned REMOVE_INTERVAL = 3;
+
+    std::filesystem::path mapperDirectory()
+    {
+        return std::filesystem::temp_directory_path() / "enigma_mapper_index_benchmark";
+    }
+
+    void prepareMapperDirectory()
+    {
+        static bool is_prepared = false;
+        if (is_prepared) return;
+        std::filesystem::create_directories(mapperDirectory());
+        Enigma::FileSystem::FileSystem::create();
+        Enigma::FileSystem::FileSystem::instance()->addMountPath(std::make_shared<Enigma::FileSystem::StdMountPath>(mapperDirectory().string(), BENCHMARK_PATH_ID));
+        is_prepared = true;
+    }
+
+    /** 每個 iteration 都從空的 mapper 開始 */
+    void removeMapperFiles()
+    {
+        std::error_code er;
+        for (const auto& entry : std::filesystem::directory_iterator(mapperDirectory(), er))
+        {
+            std::filesystem::remove(entry.path(), er);
+        }
+    }
+
+    std::string recordName(unsigned index)
+    {
+        return "texture_" + std::to_string(index);
+    }
+
+    std::string mapperRecord(const std::string& name, const std::string& filename)
+    {
+        return name + "," + filename;
+    }
+
+    /** 跟 file store mapper 的 serializeMapperFile 一樣, 一行一筆 */
+    std::string serializeMapper(const std::map<std::string, std::string>& filename_map)
+    {
+        std::string content;
+        for (const auto& [name, filename] : filename_map) content += mapperRecord(name, filename) + "\n";
+        return content;
+    }
+
+    /** 改版前的 serializeMapperFile: 整個 mapper 重寫一次 */
+    void rewriteMapperFile(const std::map<std::string, std::string>& filename_map)
+    {
+        const std::string content = serializeMapper(filename_map);
+        auto file = Enigma::FileSystem::FileSystem::instance()->openFile(Enigma::FileSystem::Filename(MAPPER_FILENAME), Enigma::FileSystem::write | Enigma::FileSystem::openAlways | Enigma::FileSystem::binary);
+        if (!file) return;
+        file->write(0, { content.begin(), content.end() });
+        Enigma::FileSystem::FileSystem::instance()->closeFile(file);
+    }
+}
+
+/** 改版前: 每次 put / remove 都重寫整個 mapper file, arg 0 = put 數; O(n^2), 只量到 5k */
+static void BM_MapperWholeFileRewrite(benchmark::State& state)
+{
+    prepareMapperDirectory();
+    const unsigned put_count = static_cast<unsigned>(state.range(0));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        removeMapperFiles();
+        std::map<std::string, std::string> filename_map;
+        state.ResumeTiming();
+        for (unsigned i = 0; i < put_count; i++)
+        {
+            filename_map.insert_or_assign(recordName(i), recordName(i) + ".tex@DataPath");
+            rewriteMapperFile(filename_map);
+            if (i % REMOVE_INTERVAL == REMOVE_INTERVAL - 1)
+            {
+                filename_map.erase(recordName(i - 1));
+                rewriteMapperFile(filename_map);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * put_count);
+}
+BENCHMARK(BM_MapperWholeFileRewrite)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** journal: put / remove 各 append 一行, 跟 mapper 一樣超過門檻就 background compaction, 最後 disconnect 時同步 compact */
+static void BM_MapperJournalPutRemove(benchmark::State& state)
+{
+    prepareMapperDirectory();
+    const unsigned put_count = static_cast<unsigned>(state.range(0));
+    unsigned compaction_count = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        removeMapperFiles();
+        std::map<std::string, std::string> filename_map;
+        JournaledMapperIndex index(MAPPER_FILENAME);
+        index.load([](const std::string&, bool) {});
+        state.ResumeTiming();
+        for (unsigned i = 0; i < put_count; i++)
+        {
+            const auto name = recordName(i);
+            const auto& filename = filename_map.insert_or_assign(name, name + ".tex@DataPath").first->second;
+            index.appendPut(mapperRecord(name, filename));
+            if (i % REMOVE_INTERVAL == REMOVE_INTERVAL - 1)
+            {
+                auto it = filename_map.find(recordName(i - 1));
+                index.appendRemove(mapperRecord(it->first, it->second));
+                filename_map.erase(it);
+            }
+            if (index.isCompactionNeeded(filename_map.size()))
+            {
+                index.compactAsync(serializeMapper(filename_map));
+                compaction_count++;
+            }
+        }
+        index.compact(serializeMapper(filename_map));
+        index.close();
+    }
+    state.SetItemsProcessed(state.iterations() * put_count);
+    state.counters["compactions"] = benchmark::Counter(static_cast<double>(compaction_count), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MapperJournalPutRemove)->Arg(5000)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** 同步 compaction: 重寫 snapshot, 清掉 journal, arg 0 = live record 數 */
+static void BM_MapperCompact(benchmark::State& state)
+{
+    prepareMapperDirectory();
+    const unsigned record_count = static_cast<unsigned>(state.range(0));
+    std::map<std::string, std::string> filename_map;
+    for (unsigned i = 0; i < record_count; i++) filename_map.insert_or_assign(recordName(i), recordName(i) + ".tex@DataPath");
+    const std::string snapshot = serializeMapper(filename_map);
+    removeMapperFiles();
+    JournaledMapperIndex index(MAPPER_FILENAME);
+    index.load([](const std::string&, bool) {});
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (unsigned i = 0; i < JournaledMapperIndex::DefaultCompactionRecordCount; i++) index.appendPut(mapperRecord(recordName(i), recordName(i) + ".tex@DataPath"));
+        state.ResumeTiming();
+        index.compact(snapshot);
+    }
+    index.close();
+    state.SetItemsProcessed(state.iterations() * record_count);
+    state.SetBytesProcessed(state.iterations() * snapshot.size());
+}
+BENCHMARK(BM_MapperCompact)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** connect 時讀 snapshot 再 replay journal */
+static void BM_MapperLoad(benchmark::State& state)
+{
+    prepareMapperDirectory();
+    const unsigned record_count = static_cast<unsigned>(state.range(0));
+    removeMapperFiles();
+    {
+        std::map<std::string, std::string> filename_map;
+        for (unsigned i = 0; i < record_count; i++) filename_map.insert_or_assign(recordName(i), recordName(i) + ".tex@DataPath");
+        JournaledMapperIndex index(MAPPER_FILENAME);
+        index.load([](const std::string&, bool) {});
+        index.compact(serializeMapper(filename_map));
+        for (unsigned i = 0; i < JournaledMapperIndex::DefaultCompactionRecordCount; i++) index.appendPut(mapperRecord(recordName(record_count + i), "journal.tex@DataPath"));
+        index.close();
+    }
+    for (auto _ : state)
+    {
+        std::map<std::string, std::string> filename_map;
+        JournaledMapperIndex index(MAPPER_FILENAME);
+        index.load([&](const std::string& record, bool is_removed)
+            {
+                const auto comma = record.find(',');
+                if (is_removed) filename_map.erase(record.substr(0, comma));
+                else filename_map.insert_or_assign(record.substr(0, comma), record.substr(comma + 1));
+            });
+        benchmark::DoNotOptimize(filename_map.size());
+        index.close();
+    }
+    state.SetItemsProcessed(state.iterations() * (record_count + JournaledMapperIndex::DefaultCompactionRecordCount));
+}
+BENCHMARK(BM_MapperLoad)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,106 @@
+#include "Platforms/PlatformLayer.h"
+#include "Platforms/AsyncLogSink.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace Enigma::Platforms;
+
+namespace
+{
+    constexpr unsigned CHECKS_PER_ITERATION = 1000;
+    constexpr unsigned RECORDS_PER_ITERATION = 256;
+
+    /** 改版前的 LogIf: 參數是 const std::string&, 每次檢查都要把字串化的 expression 建成 std::string */
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((noinline))
+#endif
+    bool legacyLogIf(bool cond, Logger::Level lv, const std::string& msg, const char* filename, int line)
+    {
+        if (cond) Logger::LogInline(lv, msg, filename, line);
+        return cond;
+    }
+#define LEGACY_FATAL_LOG_EXPR(expr) legacyLogIf((expr), Logger::Level::Fatal, #expr, __FILE__, __LINE__)
+
+    std::string benchmarkLogPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+/** check 通過 (不用 log) 的成本, arg 0 = 0 : 改版前的 macro, 1 : FATAL_LOG_EXPR */
+static void BM_FatalLogExprPassing(benchmark::State& state)
+{
+    const bool is_legacy = state.range(0) == 0;
+    std::vector<unsigned> vertex_indices(CHECKS_PER_ITERATION);
+    for (unsigned i = 0; i < CHECKS_PER_ITERATION; i++) vertex_indices[i] = i;
+    const unsigned used_vertex_count = CHECKS_PER_ITERATION;
+    const float* vertex_memory = reinterpret_cast<const float*>(vertex_indices.data());
+    for (auto _ : state)
+    {
+        unsigned failed = 0;
+        for (const unsigned vertex_index : vertex_indices)
+        {
+            benchmark::DoNotOptimize(vertex_index);
+            if (is_legacy)
+            {
+                if (LEGACY_FATAL_LOG_EXPR((vertex_index >= used_vertex_count) || (vertex_memory == nullptr))) failed++;
+            }
+            else
+            {
+                if (FATAL_LOG_EXPR((vertex_index >= used_vertex_count) || (vertex_memory == nullptr))) failed++;
+            }
+        }
+        benchmark::DoNotOptimize(failed);
+    }
+    state.SetItemsProcessed(state.iterations() * CHECKS_PER_ITERATION);
+}
+BENCHMARK(BM_FatalLogExprPassing)->Arg(0)->Arg(1);
+
+/** 改版前的寫法: 呼叫端 Printf 格式化, 直接寫入 ofstream 並 flush */
+static void BM_LogSynchronousFile(benchmark::State& state)
+{
+    std::ofstream file(benchmarkLogPath("enigma_logger_benchmark_sync.log"), std::fstream::out | std::fstream::trunc);
+    for (auto _ : state)
+    {
+        for (unsigned i = 0; i < RECORDS_PER_ITERATION; i++)
+        {
+            const std::string msg = Logger::Printf("[%s] %s %u @ %s(%d)\n", Logger::LevelToken(Logger::Level::Info),
+                "streaming texture hydrated", i, __FILE__, __LINE__);
+            file.write(msg.c_str(), static_cast<std::streamsize>(msg.length())).flush();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RECORDS_PER_ITERATION);
+}
+BENCHMARK(BM_LogSynchronousFile);
+
+/** async sink, arg 0 = 0 : 只算呼叫端 push, 1 : 連 writer 寫完 (flush) 一起算 */
+static void BM_LogAsyncSink(benchmark::State& state)
+{
+    const bool include_drain = state.range(0) != 0;
+    AsyncLogSink sink(benchmarkLogPath("enigma_logger_benchmark_async.log"));
+    const std::string msg = "streaming texture hydrated";
+    for (auto _ : state)
+    {
+        for (unsigned i = 0; i < RECORDS_PER_ITERATION; i++)
+        {
+            sink.push(Logger::Level::Info, msg, __FILE__, __LINE__);
+        }
+        if (include_drain)
+        {
+            sink.flush();
+        }
+        else
+        {
+            state.PauseTiming();
+            sink.flush();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RECORDS_PER_ITERATION);
+    state.counters["dropped"] = static_cast<double>(sink.droppedCount());
+}
+BENCHMARK(BM_LogAsyncSink)->Arg(0)->Arg(1);
@@ -0,0 +1,119 @@
+#include "Renderables/SkeletonEvaluator.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/Quaternion.h"
+#include "MathLib/Vector3.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+using namespace Enigma::Renderables;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    constexpr unsigned CHARACTER_COUNT = 100;
+    constexpr unsigned BONE_COUNT = 80;
+
+    /** 一隻角色的 skeleton 與一個 frame 的 sampled SRT */
+    struct Skeleton
+    {
+        std::vector<std::uint32_t> m_parents;
+        std::vector<SRTValueTie> m_srts;
+        std::vector<Matrix4> m_offsets;  ///< inverse bind matrices, 跟 asset 一樣由 Inverse() 算出
+    };
+
+    Quaternion randomRotation(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        Quaternion q(unit(rng), unit(rng), unit(rng), unit(rng));
+        q.normalize();
+        return q;
+    }
+
+    std::vector<Skeleton> makeSkeletons()
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<Skeleton> skeletons(CHARACTER_COUNT);
+        for (auto& skeleton : skeletons)
+        {
+            std::vector<Matrix4> bind_pose(BONE_COUNT);
+            for (unsigned i = 0; i < BONE_COUNT; i++)
+            {
+                const std::uint32_t parent = (i == 0) ? SkeletonEvaluator::NoParent : static_cast<std::uint32_t>(rng() % i);
+                skeleton.m_parents.emplace_back(parent);
+                const Matrix4 local = Matrix4::FromSRT(Vector3(1.0f, 1.0f, 1.0f), randomRotation(rng), Vector3(unit(rng), unit(rng), unit(rng)));
+                bind_pose[i] = (parent == SkeletonEvaluator::NoParent) ? local : bind_pose[parent] * local;
+                skeleton.m_offsets.emplace_back(bind_pose[i].Inverse());
+                skeleton.m_srts.emplace_back(Vector3(1.0f + 0.1f * unit(rng), 1.0f, 1.0f), randomRotation(rng), Vector3(unit(rng), unit(rng), unit(rng)));
+            }
+        }
+        return skeletons;
+    }
+
+    const Matrix4& ownerRootRefTransform()
+    {
+        static const Matrix4 owner = Matrix4::FromSRT(Vector3(1.0f, 1.0f, 1.0f), Quaternion(0.9238795f, 0.0f, 0.3826834f, 0.0f), Vector3(0.5f, 1.0f, 0.0f));
+        return owner;
+    }
+}
+
+/** 改版前: 逐 node 用 Matrix4 組 local 乘 parent, 每個 frame 都 Inverse() owner 的 root ref, bone = inv ref * root ref * offset */
+static void BM_SkeletonMatrix4Walk(benchmark::State& state)
+{
+    const auto skeletons = makeSkeletons();
+    std::vector<Matrix4> root_refs(BONE_COUNT);
+    std::vector<Matrix4> bone_matrices(BONE_COUNT);
+    for (auto _ : state)
+    {
+        for (const auto& skeleton : skeletons)
+        {
+            for (unsigned i = 0; i < BONE_COUNT; i++)
+            {
+                const auto& [scale, rotate, translate] = skeleton.m_srts[i];
+                const Matrix4 local = Matrix4::FromSRT(scale, rotate, translate);
+                root_refs[i] = (skeleton.m_parents[i] == SkeletonEvaluator::NoParent) ? local : root_refs[skeleton.m_parents[i]] * local;
+            }
+            const Matrix4 inv_ref = ownerRootRefTransform().Inverse();
+            for (unsigned i = 0; i < BONE_COUNT; i++)
+            {
+                bone_matrices[i] = inv_ref * root_refs[i] * skeleton.m_offsets[i];
+            }
+            benchmark::DoNotOptimize(bone_matrices.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * CHARACTER_COUNT * BONE_COUNT);
+}
+BENCHMARK(BM_SkeletonMatrix4Walk)->Unit(benchmark::kMicrosecond);
+
+/** SkeletonEvaluator: SRT 直接組 affine, 一個 pass 求值, inverse bind 與 owner inverse 事先轉好 */
+static void BM_SkeletonAffineEvaluate(benchmark::State& state)
+{
+    const auto skeletons = makeSkeletons();
+    std::vector<SkeletonEvaluator> evaluators(CHARACTER_COUNT);
+    std::vector<std::vector<AffineTransform>> offsets(CHARACTER_COUNT);
+    for (unsigned c = 0; c < CHARACTER_COUNT; c++)
+    {
+        evaluators[c].build(skeletons[c].m_parents);
+        for (const auto& offset : skeletons[c].m_offsets) offsets[c].emplace_back(AffineTransform::fromMatrix(offset));
+    }
+    const AffineTransform inv_ref = AffineTransform::fromMatrix(ownerRootRefTransform().Inverse());
+    std::vector<AffineTransform> bone_matrices(BONE_COUNT);
+    for (auto _ : state)
+    {
+        for (unsigned c = 0; c < CHARACTER_COUNT; c++)
+        {
+            auto& evaluator = evaluators[c];
+            for (unsigned i = 0; i < BONE_COUNT; i++) evaluator.setLocalSRT(i, skeletons[c].m_srts[i]);
+            evaluator.evaluate();
+            for (unsigned i = 0; i < BONE_COUNT; i++)
+            {
+                AffineTransform::multiply(inv_ref, evaluator.modelTransform(i), bone_matrices[i]);
+                AffineTransform::multiply(bone_matrices[i], offsets[c][i], bone_matrices[i]);
+            }
+            benchmark::DoNotOptimize(bone_matrices.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * CHARACTER_COUNT * BONE_COUNT);
+}
+BENCHMARK(BM_SkeletonAffineEvaluate)->Unit(benchmark::kMicrosecond);
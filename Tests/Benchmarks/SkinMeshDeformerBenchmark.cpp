@@ -0,0 +1,135 @@
+#include "Renderables/SkinMeshDeformer.h"
+#include "Geometries/TriangleList.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/Vector3.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Enigma::Renderables;
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    constexpr unsigned BONE_COUNT = 32;
+    /// 4 個 float weight + palette index, 跟 shader skinning 的 layout 一樣
+    constexpr const char* SKIN_VERTEX_FORMAT = "xyzb5_nor_betabyte";
+
+    /** 沿著 y 軸排的圓柱, 每個 vertex 綁最近的 4 根 bone */
+    std::shared_ptr<TriangleList> makeSkinMesh(unsigned vtx_count)
+    {
+        std::mt19937 rng(17);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<Vector3> positions;
+        std::vector<Vector3> normals;
+        std::vector<float> weights;
+        std::vector<unsigned int> palette;
+        for (unsigned i = 0; i < vtx_count; i++)
+        {
+            const float angle = unit(rng) * 6.2831853f;
+            const float height = unit(rng) * static_cast<float>(BONE_COUNT);
+            positions.emplace_back(std::cos(angle), height, std::sin(angle));
+            normals.emplace_back(std::cos(angle), 0.0f, std::sin(angle));
+            const unsigned base = std::min(static_cast<unsigned>(height), BONE_COUNT - 4);
+            const float w = unit(rng);
+            const float w0 = 0.55f * w + 0.3f;
+            const float w1 = 0.25f * (1.0f - w) + 0.1f;
+            weights.insert(weights.end(), { w0, w1, 0.1f, 1.0f - w0 - w1 - 0.1f });
+            palette.emplace_back(base | ((base + 1) << 8) | ((base + 2) << 16) | ((base + 3) << 24));
+        }
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("skin_deformer_benchmark"));
+        tri_list->createVertexCapacity(SKIN_VERTEX_FORMAT, vtx_count, vtx_count, 0, 0);
+        tri_list->setPosition3Array(positions);
+        tri_list->setVertexNormalArray(normals);
+        tri_list->setTotalSkinWeightArray(weights);
+        tri_list->setPaletteIndexArray(palette);
+        return tri_list;
+    }
+
+    const std::shared_ptr<TriangleList>& skinMesh(unsigned vtx_count)
+    {
+        static std::map<unsigned, std::shared_ptr<TriangleList>> meshes;
+        auto& mesh = meshes[vtx_count];
+        if (!mesh) mesh = makeSkinMesh(vtx_count);
+        return mesh;
+    }
+
+    /** 每根 bone 繞 x 軸彎一點, 再平移 */
+    std::vector<Matrix4> makeBoneMatrices()
+    {
+        std::vector<Matrix4> bones;
+        for (unsigned i = 0; i < BONE_COUNT; i++)
+        {
+            bones.emplace_back(Matrix4::MakeTranslateTransform(0.1f * static_cast<float>(i), 0.0f, 0.05f * static_cast<float>(i))
+                * Matrix4::MakeRotationXTransform(0.02f * static_cast<float>(i)));
+        }
+        return bones;
+    }
+}
+
+/** 改版前的寫法: 每個 vertex 把 Matrix4 依 weight 加起來, 再 TransformCoord / TransformVector */
+static void BM_SkinMatrix4BlendLoop(benchmark::State& state)
+{
+    const unsigned vtx_count = static_cast<unsigned>(state.range(0));
+    const auto& mesh = skinMesh(vtx_count);
+    const auto source_positions = mesh->getPosition3Array(vtx_count);
+    const auto source_normals = mesh->getVertexNormalArray(vtx_count);
+    const auto weights = mesh->getTotalSkinWeightArray(vtx_count);
+    const auto palette = mesh->getPaletteIndexArray(vtx_count);
+    const auto bones = makeBoneMatrices();
+    std::vector<Vector3> positions(vtx_count);
+    std::vector<Vector3> normals(vtx_count);
+    for (auto _ : state)
+    {
+        for (unsigned i = 0; i < vtx_count; i++)
+        {
+            Matrix4 blended = Matrix4::MakeZero();
+            for (unsigned j = 0; j < SkinMeshDeformer::MaxInfluenceCount; j++)
+            {
+                blended += bones[(palette[i] >> (j * 8)) & 0xff] * weights[static_cast<size_t>(i) * SkinMeshDeformer::MaxInfluenceCount + j];
+            }
+            positions[i] = blended.TransformCoord(source_positions[i]);
+            normals[i] = blended.TransformVector(source_normals[i]);
+        }
+        benchmark::DoNotOptimize(positions.data());
+        benchmark::DoNotOptimize(normals.data());
+    }
+    state.SetItemsProcessed(state.iterations() * vtx_count);
+}
+BENCHMARK(BM_SkinMatrix4BlendLoop)->Arg(10000)->Arg(60000)->Unit(benchmark::kMicrosecond);
+
+/** SkinMeshDeformer::deform, 超過 ParallelVertexThreshold 時分給多個 thread */
+static void BM_SkinMeshDeform(benchmark::State& state)
+{
+    const unsigned vtx_count = static_cast<unsigned>(state.range(0));
+    SkinMeshDeformer deformer;
+    deformer.bindGeometry(skinMesh(vtx_count));
+    const auto bones = makeBoneMatrices();
+    for (auto _ : state)
+    {
+        deformer.deform(bones);
+        benchmark::DoNotOptimize(deformer.positions().data());
+    }
+    state.SetItemsProcessed(state.iterations() * vtx_count);
+    state.counters["simd"] = SkinMeshDeformer::isSimdEnabled() ? 1.0 : 0.0;
+}
+BENCHMARK(BM_SkinMeshDeform)->Arg(10000)->Arg(60000)->Unit(benchmark::kMicrosecond);
+
+/** bind pose decode, geometry 沒變時只做一次 */
+static void BM_SkinMeshBindGeometry(benchmark::State& state)
+{
+    const unsigned vtx_count = static_cast<unsigned>(state.range(0));
+    const auto& mesh = skinMesh(vtx_count);
+    for (auto _ : state)
+    {
+        SkinMeshDeformer deformer;
+        benchmark::DoNotOptimize(deformer.bindGeometry(mesh));
+    }
+    state.SetItemsProcessed(state.iterations() * vtx_count);
+}
+BENCHMARK(BM_SkinMeshBindGeometry)->Arg(10000)->Arg(60000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,242 @@
+#include "Terrain/TerrainGeometry.h"
+#include "Terrain/TerrainGeometryDto.h"
+#include "Frameworks/JobSystem.h"
+#include "MathLib/IntrRay3Triangle3.h"
+#include "MathLib/Ray3.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /// 512 x 512 cells, 513 x 513 個 vertex, 2 * 512 * 512 = 524288 個 triangle
+    constexpr unsigned TERRAIN_CELLS = 512;
+    constexpr float TERRAIN_EXTENT = 1024.0f;
+    constexpr unsigned RAYS_PER_ITERATION = 64;
+    constexpr unsigned QUERIES_PER_ITERATION = 4096;
+    /// 刷地形時一次改動的範圍 (cells)
+    constexpr unsigned BRUSH_CELLS = 16;
+    constexpr unsigned BRUSHES_PER_ITERATION = 64;
+
+    /** 幾組 sin 疊起來的起伏地形 */
+    std::shared_ptr<TerrainGeometry> makeTerrain()
+    {
+        TerrainGeometryDto dto;
+        dto.numRows() = TERRAIN_CELLS;
+        dto.numCols() = TERRAIN_CELLS;
+        dto.minPosition() = Vector3(0.0f, -20.0f, 0.0f);
+        dto.maxPosition() = Vector3(TERRAIN_EXTENT, 20.0f, TERRAIN_EXTENT);
+        dto.minTextureCoordinate() = Vector2(0.0f, 0.0f);
+        dto.maxTextureCoordinate() = Vector2(1.0f, 1.0f);
+        dto.chunkCellCount() = TerrainGeometry::DefaultChunkCellCount;
+        std::vector<float> heights(static_cast<size_t>(TERRAIN_CELLS + 1) * (TERRAIN_CELLS + 1));
+        for (unsigned z = 0; z <= TERRAIN_CELLS; z++)
+        {
+            for (unsigned x = 0; x <= TERRAIN_CELLS; x++)
+            {
+                const float fx = static_cast<float>(x);
+                const float fz = static_cast<float>(z);
+                heights[static_cast<size_t>(z) * (TERRAIN_CELLS + 1) + x] = 12.0f * std::sin(fx * 0.02f) * std::cos(fz * 0.03f)
+                    + 3.0f * std::sin(fx * 0.17f + fz * 0.11f);
+            }
+        }
+        dto.heightMap() = heights;
+        return std::make_shared<TerrainGeometry>(Enigma::Geometries::GeometryId("terrain_benchmark"), dto.toGenericDto());
+    }
+
+    const std::shared_ptr<TerrainGeometry>& terrain()
+    {
+        static std::shared_ptr<TerrainGeometry> geo = makeTerrain();
+        return geo;
+    }
+
+    /** 從上方斜斜往下打的 picking ray */
+    std::vector<Ray3> makePickingRays(unsigned count)
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> coord(0.1f * TERRAIN_EXTENT, 0.9f * TERRAIN_EXTENT);
+        std::uniform_real_distribution<float> tilt(-0.6f, 0.6f);
+        std::vector<Ray3> rays;
+        rays.reserve(count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            Vector3 dir(tilt(rng), -1.0f, tilt(rng));
+            dir.normalizeSelf();
+            rays.emplace_back(Vector3(coord(rng), 60.0f, coord(rng)), dir);
+        }
+        return rays;
+    }
+
+    std::vector<Vector3> makeQueryPositions(unsigned count)
+    {
+        std::mt19937 rng(13);
+        std::uniform_real_distribution<float> coord(0.0f, TERRAIN_EXTENT * 0.99f);
+        std::vector<Vector3> positions;
+        positions.reserve(count);
+        for (unsigned i = 0; i < count; i++) positions.emplace_back(coord(rng), 0.0f, coord(rng));
+        return positions;
+    }
+
+    std::optional<float> hitTriangle(const std::shared_ptr<TerrainGeometry>& geo, const Ray3& ray, unsigned triangle_index)
+    {
+        Vector3 triangle[3];
+        geo->fetchTrianglePos(triangle_index, triangle);
+        IntrRay3Triangle3 intr(ray, triangle);
+        if ((!intr.find(nullptr).m_hasIntersect) || (intr.getRayT() < 0.0f)) return std::nullopt;
+        return intr.getRayT();
+    }
+}
+
+/** 改版前 terrain 走 findForTriangleList 的 brute force: 每個 triangle 都 fetch & 測一次 */
+static void BM_TerrainRayBruteForce(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    const auto rays = makePickingRays(RAYS_PER_ITERATION);
+    const unsigned tri_count = geo->getTriangleCount();
+    size_t hit_count = 0;
+    for (auto _ : state)
+    {
+        for (const auto& ray : rays)
+        {
+            std::optional<float> nearest_t;
+            for (unsigned i = 0; i < tri_count; i++)
+            {
+                auto t = hitTriangle(geo, ray, i);
+                if ((t) && ((!nearest_t) || (*t < *nearest_t))) nearest_t = t;
+            }
+            if (nearest_t) hit_count++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RAYS_PER_ITERATION);
+    state.counters["hit_ratio"] = static_cast<double>(hit_count) / static_cast<double>(state.iterations() * RAYS_PER_ITERATION);
+}
+BENCHMARK(BM_TerrainRayBruteForce)->Unit(benchmark::kMillisecond);
+
+/** 一般 mesh 的 triangle bvh, 只取最近的交點 (build 不算在裡面) */
+static void BM_TerrainRayTriangleBvh(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    const auto rays = makePickingRays(RAYS_PER_ITERATION);
+    const auto bvh = geo->triangleBvh();
+    size_t hit_count = 0;
+    for (auto _ : state)
+    {
+        for (const auto& ray : rays)
+        {
+            if (bvh->findNearest(ray, [&](unsigned i) { return hitTriangle(geo, ray, i); })) hit_count++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RAYS_PER_ITERATION);
+    state.counters["hit_ratio"] = static_cast<double>(hit_count) / static_cast<double>(state.iterations() * RAYS_PER_ITERATION);
+}
+BENCHMARK(BM_TerrainRayTriangleBvh)->Unit(benchmark::kMicrosecond);
+
+/** height field 的 min/max quadtree + 2D DDA */
+static void BM_TerrainRayHeightField(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    const auto rays = makePickingRays(RAYS_PER_ITERATION);
+    size_t hit_count = 0;
+    for (auto _ : state)
+    {
+        for (const auto& ray : rays)
+        {
+            if (geo->castRay(ray)) hit_count++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RAYS_PER_ITERATION);
+    state.counters["hit_ratio"] = static_cast<double>(hit_count) / static_cast<double>(state.iterations() * RAYS_PER_ITERATION);
+}
+BENCHMARK(BM_TerrainRayHeightField)->Unit(benchmark::kMicrosecond);
+
+/** 改版前貼地的寫法: 從上方垂直往下打 ray 取交點高度 */
+static void BM_TerrainHeightByVerticalRay(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    const auto positions = makeQueryPositions(QUERIES_PER_ITERATION);
+    const Vector3 down(0.0f, -1.0f, 0.0f);
+    for (auto _ : state)
+    {
+        float sum = 0.0f;
+        for (const auto& pos : positions)
+        {
+            const Ray3 ray(Vector3(pos.x(), geo->getMaxPosition().y() + 1.0f, pos.z()), down);
+            if (auto t = geo->castRay(ray)) sum += ray.origin().y() - *t;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * QUERIES_PER_ITERATION);
+}
+BENCHMARK(BM_TerrainHeightByVerticalRay)->Unit(benchmark::kMicrosecond);
+
+/** bilinear heightAt, 一次查一個 */
+static void BM_TerrainHeightAt(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    const auto positions = makeQueryPositions(QUERIES_PER_ITERATION);
+    for (auto _ : state)
+    {
+        float sum = 0.0f;
+        for (const auto& pos : positions)
+        {
+            if (auto h = geo->heightAt(pos.x(), pos.z())) sum += *h;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * QUERIES_PER_ITERATION);
+}
+BENCHMARK(BM_TerrainHeightAt)->Unit(benchmark::kMicrosecond);
+
+/** heightsAt 整批查詢 */
+static void BM_TerrainHeightsAtBatch(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    const auto positions = makeQueryPositions(QUERIES_PER_ITERATION);
+    for (auto _ : state)
+    {
+        auto heights = geo->heightsAt(positions, 0.0f);
+        benchmark::DoNotOptimize(heights.data());
+    }
+    state.SetItemsProcessed(state.iterations() * QUERIES_PER_ITERATION);
+}
+BENCHMARK(BM_TerrainHeightsAtBatch)->Unit(benchmark::kMicrosecond);
+
+/** 整個地形重算 normal, arg 0 = job system 的 worker 數, -1 : 沒有 job system, 直接在呼叫的 thread 上做 */
+static void BM_TerrainFullNormalUpdate(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    std::unique_ptr<Enigma::Frameworks::JobSystem> jobs;
+    if (state.range(0) >= 0) jobs = std::make_unique<Enigma::Frameworks::JobSystem>(static_cast<unsigned>(state.range(0)));
+    for (auto _ : state)
+    {
+        geo->updateVertexNormals();
+    }
+    state.SetItemsProcessed(state.iterations() * (TERRAIN_CELLS + 1) * (TERRAIN_CELLS + 1));
+}
+BENCHMARK(BM_TerrainFullNormalUpdate)->Arg(-1)->Arg(0)->Arg(3)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** 筆刷大小的範圍重算 normal, 低於 ParallelNormalVertexCount, 一律在呼叫的 thread 上做 */
+static void BM_TerrainBrushNormalUpdate(benchmark::State& state)
+{
+    const auto& geo = terrain();
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<unsigned> corner(0, TERRAIN_CELLS - BRUSH_CELLS);
+    std::vector<std::pair<unsigned, unsigned>> brushes;
+    for (unsigned i = 0; i < BRUSHES_PER_ITERATION; i++) brushes.emplace_back(corner(rng), corner(rng));
+    for (auto _ : state)
+    {
+        for (const auto& [x, z] : brushes)
+        {
+            geo->rectUpdateVertexNormals(x, z, x + BRUSH_CELLS, z + BRUSH_CELLS);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BRUSHES_PER_ITERATION * (BRUSH_CELLS + 1) * (BRUSH_CELLS + 1));
+}
+BENCHMARK(BM_TerrainBrushNormalUpdate)->Unit(benchmark::kMicrosecond);
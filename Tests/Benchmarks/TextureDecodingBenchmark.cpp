@@ -0,0 +1,142 @@
+#include "GameEngine/TextureDecodingPipeline.h"
+#include "GameEngine/TextureImageDecoder.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/StdMountPath.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "png.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Enigma::Engine;
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    constexpr unsigned IMAGE_COUNT = 16;
+    constexpr unsigned IMAGE_SIZE = 512;
+    constexpr const char* BENCHMARK_PATH_ID = "BENCHMARK_TEXTURE_PATH";
+
+    std::string imageFilename(unsigned index)
+    {
+        return "decode_" + std::to_string(index) + ".png";
+    }
+
+    /** 在暫存目錄寫一批 png, 掛到 file system 上; 漸層加雜訊, 壓縮率跟一般貼圖差不多 */
+    void prepareImageDirectory()
+    {
+        static bool is_prepared = false;
+        if (is_prepared) return;
+        const auto directory = std::filesystem::temp_directory_path() / "enigma_texture_decoding_benchmark";
+        std::filesystem::create_directories(directory);
+        std::mt19937 random(7);
+        std::vector<unsigned char> pixels(static_cast<size_t>(IMAGE_SIZE) * IMAGE_SIZE * 4);
+        for (unsigned i = 0; i < IMAGE_COUNT; i++)
+        {
+            for (unsigned y = 0; y < IMAGE_SIZE; y++)
+            {
+                for (unsigned x = 0; x < IMAGE_SIZE; x++)
+                {
+                    unsigned char* px = &pixels[(static_cast<size_t>(y) * IMAGE_SIZE + x) * 4];
+                    px[0] = static_cast<unsigned char>(x + i * 13 + (random() & 0x0f));
+                    px[1] = static_cast<unsigned char>(y + (random() & 0x0f));
+                    px[2] = static_cast<unsigned char>((x ^ y) + (random() & 0x07));
+                    px[3] = 0xff;
+                }
+            }
+            png_image png{};
+            png.version = PNG_IMAGE_VERSION;
+            png.width = IMAGE_SIZE;
+            png.height = IMAGE_SIZE;
+            png.format = PNG_FORMAT_RGBA;
+            png_image_write_to_file(&png, (directory / imageFilename(i)).string().c_str(), 0, pixels.data(), 0, nullptr);
+        }
+        Enigma::FileSystem::FileSystem::create();
+        Enigma::FileSystem::FileSystem::instance()->addMountPath(std::make_shared<Enigma::FileSystem::StdMountPath>(directory.string(), BENCHMARK_PATH_ID));
+        is_prepared = true;
+    }
+}
+
+/** 改版前: 一張一張在同一條 (device) thread 上讀檔 & decode */
+static void BM_DecodePngOnCallerThread(benchmark::State& state)
+{
+    prepareImageDirectory();
+    DecodedTextureImage image;
+    for (auto _ : state)
+    {
+        for (unsigned i = 0; i < IMAGE_COUNT; i++)
+        {
+            TextureImageDecoder::decodeFile(imageFilename(i), BENCHMARK_PATH_ID, image);
+            benchmark::DoNotOptimize(image.m_pixels.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * IMAGE_COUNT);
+    state.SetBytesProcessed(state.iterations() * IMAGE_COUNT * IMAGE_SIZE * IMAGE_SIZE * 4);
+}
+BENCHMARK(BM_DecodePngOnCallerThread)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** decoding pipeline, arg 0 = worker 數; decoded event 在 post hook 裡收下 */
+static void BM_DecodePngPipeline(benchmark::State& state)
+{
+    prepareImageDirectory();
+    ServiceManager service_manager;
+    auto event_publisher = std::make_shared<EventPublisher>(&service_manager);
+    std::atomic<unsigned> finished_count{ 0 };
+    TextureDecodingPipeline pipeline(static_cast<unsigned>(state.range(0)));
+    EventPublisher::setPostHook(std::make_shared<const EventHandler>([&](const IEventPtr&)
+        {
+            finished_count.fetch_add(1, std::memory_order_release);
+        }));
+    for (auto _ : state)
+    {
+        finished_count = 0;
+        for (unsigned i = 0; i < IMAGE_COUNT; i++)
+        {
+            pipeline.submit(TextureId{ imageFilename(i) }, imageFilename(i), BENCHMARK_PATH_ID, 0, i + 1);
+        }
+        while (finished_count.load(std::memory_order_acquire) < IMAGE_COUNT) std::this_thread::yield();
+        event_publisher->onTick();
+    }
+    EventPublisher::setPostHook(nullptr);
+    state.SetItemsProcessed(state.iterations() * IMAGE_COUNT);
+    state.SetBytesProcessed(state.iterations() * IMAGE_COUNT * IMAGE_SIZE * IMAGE_SIZE * 4);
+}
+BENCHMARK(BM_DecodePngPipeline)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** decode 好的 pixel 交給 graphic thread task, arg 0 = 0 : 複製 (改版前), 1 : move */
+static void BM_UploadTaskHandoff(benchmark::State& state)
+{
+    const bool is_moved = state.range(0) != 0;
+    std::vector<byte_buffer> decoded(IMAGE_COUNT);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (auto& pixels : decoded) pixels.assign(static_cast<size_t>(IMAGE_SIZE) * IMAGE_SIZE * 4, 0x7f);
+        state.ResumeTiming();
+        std::vector<std::function<size_t()>> tasks;
+        tasks.reserve(IMAGE_COUNT);
+        for (auto& pixels : decoded)
+        {
+            if (is_moved)
+            {
+                tasks.emplace_back([buff = std::move(pixels)]() { return buff.size(); });
+            }
+            else
+            {
+                tasks.emplace_back([buff = pixels]() { return buff.size(); });
+            }
+        }
+        size_t uploaded = 0;
+        for (auto& task : tasks) uploaded += task();
+        benchmark::DoNotOptimize(uploaded);
+    }
+    state.SetBytesProcessed(state.iterations() * IMAGE_COUNT * IMAGE_SIZE * IMAGE_SIZE * 4);
+}
+BENCHMARK(BM_UploadTaskHandoff)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,167 @@
+#include "Geometries/TriangleList.h"
+#include "Geometries/TriangleBvh.h"
+#include "Geometries/IntrGeometryRay3.h"
+#include "Geometries/IntrGeometryCache.h"
+#include "MathLib/IntrRay3Triangle3.h"
+#include "MathLib/Ray3.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /// 708 x 708 的 grid, 2 * 707 * 707 = 999698 個 triangle
+    constexpr unsigned GRID_SIZE = 708;
+    constexpr float GRID_SPACING = 1.0f;
+    constexpr unsigned RAYS_PER_ITERATION = 64;
+
+    /** 起伏的 height field mesh, 跟大塊地形或大 mesh 的 picking 差不多 */
+    std::shared_ptr<TriangleList> makeGridMesh()
+    {
+        std::vector<Vector3> positions;
+        positions.reserve(static_cast<size_t>(GRID_SIZE) * GRID_SIZE);
+        for (unsigned z = 0; z < GRID_SIZE; z++)
+        {
+            for (unsigned x = 0; x < GRID_SIZE; x++)
+            {
+                const float fx = static_cast<float>(x) * GRID_SPACING;
+                const float fz = static_cast<float>(z) * GRID_SPACING;
+                positions.emplace_back(fx, 4.0f * std::sin(fx * 0.05f) * std::cos(fz * 0.07f), fz);
+            }
+        }
+        std::vector<unsigned int> indices;
+        indices.reserve(static_cast<size_t>(GRID_SIZE - 1) * (GRID_SIZE - 1) * 6);
+        for (unsigned z = 0; z + 1 < GRID_SIZE; z++)
+        {
+            for (unsigned x = 0; x + 1 < GRID_SIZE; x++)
+            {
+                const unsigned i0 = z * GRID_SIZE + x;
+                indices.insert(indices.end(), { i0, i0 + GRID_SIZE, i0 + 1, i0 + 1, i0 + GRID_SIZE, i0 + GRID_SIZE + 1 });
+            }
+        }
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("bvh_benchmark_grid"));
+        const unsigned vtx_count = static_cast<unsigned>(positions.size());
+        const unsigned idx_count = static_cast<unsigned>(indices.size());
+        tri_list->createVertexCapacity("xyz", vtx_count, vtx_count, idx_count, idx_count);
+        tri_list->setPosition3Array(positions);
+        tri_list->setIndexArray(indices);
+        tri_list->calculateBoundingVolume(true);
+        return tri_list;
+    }
+
+    const std::shared_ptr<TriangleList>& gridMesh()
+    {
+        static std::shared_ptr<TriangleList> mesh = makeGridMesh();
+        return mesh;
+    }
+
+    /** 從上方斜斜往下打的 picking ray */
+    std::vector<Ray3> makePickingRays(unsigned count)
+    {
+        std::mt19937 rng(5);
+        const float extent = static_cast<float>(GRID_SIZE - 1) * GRID_SPACING;
+        std::uniform_real_distribution<float> coord(0.1f * extent, 0.9f * extent);
+        std::uniform_real_distribution<float> tilt(-0.3f, 0.3f);
+        std::vector<Ray3> rays;
+        rays.reserve(count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            Vector3 dir(tilt(rng), -1.0f, tilt(rng));
+            dir.normalizeSelf();
+            rays.emplace_back(Vector3(coord(rng), 50.0f, coord(rng)), dir);
+        }
+        return rays;
+    }
+}
+
+/** 改版前的 findForTriangleList: 每個 triangle 都 fetch & 測一次 */
+static void BM_RayFindBruteForce(benchmark::State& state)
+{
+    const auto& mesh = gridMesh();
+    const auto rays = makePickingRays(RAYS_PER_ITERATION);
+    const unsigned tri_count = mesh->getTriangleCount();
+    Vector3 triangle[3];
+    size_t hit_count = 0;
+    for (auto _ : state)
+    {
+        for (const auto& ray : rays)
+        {
+            float nearest_t = -1.0f;
+            for (unsigned i = 0; i < tri_count; i++)
+            {
+                mesh->fetchTrianglePos(i, triangle);
+                IntrRay3Triangle3 intr(ray, triangle);
+                if (!intr.find(nullptr).m_hasIntersect) continue;
+                if ((intr.getRayT() >= 0.0f) && ((nearest_t < 0.0f) || (intr.getRayT() < nearest_t))) nearest_t = intr.getRayT();
+            }
+            if (nearest_t >= 0.0f) hit_count++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RAYS_PER_ITERATION);
+    state.counters["hit_ratio"] = static_cast<double>(hit_count) / static_cast<double>(state.iterations() * RAYS_PER_ITERATION);
+}
+BENCHMARK(BM_RayFindBruteForce)->Unit(benchmark::kMillisecond);
+
+/** IntrGeometryRay3::find 走 bvh, 找出所有交點 */
+static void BM_RayFindBvh(benchmark::State& state)
+{
+    const auto& mesh = gridMesh();
+    const auto rays = makePickingRays(RAYS_PER_ITERATION);
+    mesh->triangleBvh();  // build 不算在裡面, 另外量
+    size_t hit_count = 0;
+    for (auto _ : state)
+    {
+        for (const auto& ray : rays)
+        {
+            IntrGeometryRay3 intr(mesh, ray);
+            if (intr.find(nullptr).m_hasIntersect) hit_count++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RAYS_PER_ITERATION);
+    state.counters["hit_ratio"] = static_cast<double>(hit_count) / static_cast<double>(state.iterations() * RAYS_PER_ITERATION);
+}
+BENCHMARK(BM_RayFindBvh)->Unit(benchmark::kMicrosecond);
+
+/** 只要最近的交點 (picking 的用法), bvh 依 t 剪掉較遠的 node */
+static void BM_RayFindNearestBvh(benchmark::State& state)
+{
+    const auto& mesh = gridMesh();
+    const auto rays = makePickingRays(RAYS_PER_ITERATION);
+    mesh->triangleBvh();
+    size_t hit_count = 0;
+    for (auto _ : state)
+    {
+        for (const auto& ray : rays)
+        {
+            auto cache = std::make_unique<IntrGeometryCache>();
+            cache->setRequiredResultCount(1);
+            IntrGeometryRay3 intr(mesh, ray);
+            if (intr.find(std::move(cache)).m_hasIntersect) hit_count++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RAYS_PER_ITERATION);
+    state.counters["hit_ratio"] = static_cast<double>(hit_count) / static_cast<double>(state.iterations() * RAYS_PER_ITERATION);
+}
+BENCHMARK(BM_RayFindNearestBvh)->Unit(benchmark::kMicrosecond);
+
+/** 第一次 query 時的 SAH build */
+static void BM_TriangleBvhBuild(benchmark::State& state)
+{
+    const auto& mesh = gridMesh();
+    const unsigned tri_count = mesh->getTriangleCount();
+    std::vector<Vector3> triangle_positions(static_cast<size_t>(tri_count) * 3);
+    for (unsigned i = 0; i < tri_count; i++) mesh->fetchTrianglePos(i, &triangle_positions[static_cast<size_t>(i) * 3]);
+    for (auto _ : state)
+    {
+        TriangleBvh bvh;
+        bvh.build(triangle_positions);
+        benchmark::DoNotOptimize(bvh.triangleCount());
+    }
+    state.SetItemsProcessed(state.iterations() * tri_count);
+}
+BENCHMARK(BM_TriangleBvhBuild)->Unit(benchmark::kMillisecond);
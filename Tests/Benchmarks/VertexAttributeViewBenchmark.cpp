@@ -0,0 +1,118 @@
+#include "Geometries/TriangleList.h"
+#include "Geometries/VertexAttributeView.h"
+#include "MathLib/Vector3.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /// 1M 個 interleaved vertex (position + normal + 2 組 uv), 跟一般 mesh 的 layout 一樣
+    constexpr unsigned VERTEX_COUNT = 1u << 20;
+
+    std::shared_ptr<TriangleList> makeMesh()
+    {
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("view_benchmark_mesh"));
+        tri_list->createVertexCapacity("xyz_nor_tex2(2,2)", VERTEX_COUNT, VERTEX_COUNT, 0, 0);
+        std::vector<Vector3> positions;
+        positions.reserve(VERTEX_COUNT);
+        for (unsigned i = 0; i < VERTEX_COUNT; i++)
+        {
+            positions.emplace_back(static_cast<float>(i % 1024), static_cast<float>((i * 7) % 113), static_cast<float>(i / 1024));
+        }
+        tri_list->setPosition3Array(positions);
+        return tri_list;
+    }
+
+    const std::shared_ptr<TriangleList>& mesh()
+    {
+        static std::shared_ptr<TriangleList> tri_list = makeMesh();
+        return tri_list;
+    }
+
+    struct Bound
+    {
+        Vector3 m_min{ 1.0e30f, 1.0e30f, 1.0e30f };
+        Vector3 m_max{ -1.0e30f, -1.0e30f, -1.0e30f };
+        void grow(const Vector3& v)
+        {
+            m_min = Vector3(std::min(m_min.x(), v.x()), std::min(m_min.y(), v.y()), std::min(m_min.z(), v.z()));
+            m_max = Vector3(std::max(m_max.x(), v.x()), std::max(m_max.y(), v.y()), std::max(m_max.z(), v.z()));
+        }
+    };
+}
+
+/** 改版前算 bound 的寫法: getPosition3Array 先配置 & 複製整份 position */
+static void BM_PositionBoundCopyArray(benchmark::State& state)
+{
+    const auto& geo = mesh();
+    for (auto _ : state)
+    {
+        Bound bound;
+        for (const auto& pos : geo->getPosition3Array(VERTEX_COUNT)) bound.grow(pos);
+        benchmark::DoNotOptimize(bound);
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+}
+BENCHMARK(BM_PositionBoundCopyArray)->Unit(benchmark::kMicrosecond);
+
+/** 一個一個 getPosition3 */
+static void BM_PositionBoundPerVertex(benchmark::State& state)
+{
+    const auto& geo = mesh();
+    for (auto _ : state)
+    {
+        Bound bound;
+        for (unsigned i = 0; i < VERTEX_COUNT; i++) bound.grow(geo->getPosition3(i));
+        benchmark::DoNotOptimize(bound);
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+}
+BENCHMARK(BM_PositionBoundPerVertex)->Unit(benchmark::kMicrosecond);
+
+/** 直接走 strided view, 不配置也不複製 */
+static void BM_PositionBoundView(benchmark::State& state)
+{
+    const auto& geo = mesh();
+    for (auto _ : state)
+    {
+        Bound bound;
+        for (const auto& pos : geo->positionView()) bound.grow(pos);
+        benchmark::DoNotOptimize(bound);
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+}
+BENCHMARK(BM_PositionBoundView)->Unit(benchmark::kMicrosecond);
+
+/** 改版前移動整個 mesh: 複製出來改完再 setPosition3Array 寫回 */
+static void BM_PositionTranslateCopyArray(benchmark::State& state)
+{
+    const auto& geo = mesh();
+    const Vector3 offset(0.5f, 0.0f, -0.5f);
+    for (auto _ : state)
+    {
+        auto positions = geo->getPosition3Array(VERTEX_COUNT);
+        for (auto& pos : positions) pos = pos + offset;
+        geo->setPosition3Array(positions);
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+}
+BENCHMARK(BM_PositionTranslateCopyArray)->Unit(benchmark::kMicrosecond);
+
+/** mutable view 就地修改 */
+static void BM_PositionTranslateView(benchmark::State& state)
+{
+    const auto& geo = mesh();
+    const Vector3 offset(0.5f, 0.0f, -0.5f);
+    for (auto _ : state)
+    {
+        auto positions = geo->mutablePositionView();
+        for (unsigned i = 0; i < positions.size(); i++) positions.set(i, positions.get(i) + offset);
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+}
+BENCHMARK(BM_PositionTranslateView)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,124 @@
+#include "Geometries/TriangleList.h"
+#include "Geometries/GeometryVertexCompressor.h"
+#include "MathLib/Vector2.h"
+#include "MathLib/Vector3.h"
+#include "MathLib/Vector4.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /// 240 x 240 = 57600 個 vertex, 還在 16-bit index 的範圍內
+    constexpr unsigned GRID_SIZE = 240;
+    constexpr unsigned VERTEX_COUNT = GRID_SIZE * GRID_SIZE;
+    /// 一般的 skin mesh: 4 個 weight + palette index, normal, tangent, 一組 uv
+    constexpr const char* SKIN_VERTEX_FORMAT = "xyzb5_nor_tangent_tex1(2)_betabyte";
+
+    std::shared_ptr<TriangleList> makeSkinMesh()
+    {
+        std::vector<Vector3> positions;
+        std::vector<Vector3> normals;
+        std::vector<Vector4> tangents;
+        std::vector<Vector2> uvs;
+        std::vector<float> weights;
+        std::vector<unsigned int> palette;
+        for (unsigned z = 0; z < GRID_SIZE; z++)
+        {
+            for (unsigned x = 0; x < GRID_SIZE; x++)
+            {
+                const float fx = static_cast<float>(x) * 0.05f;
+                const float fz = static_cast<float>(z) * 0.05f;
+                positions.emplace_back(fx, 0.3f * std::sin(fx) * std::cos(fz), fz);
+                Vector3 nor(-0.3f * std::cos(fx) * std::cos(fz), 1.0f, 0.3f * std::sin(fx) * std::sin(fz));
+                normals.emplace_back(nor.normalize());
+                tangents.emplace_back(1.0f, 0.0f, 0.0f, (x & 1) ? 1.0f : -1.0f);
+                uvs.emplace_back(static_cast<float>(x) / GRID_SIZE, static_cast<float>(z) / GRID_SIZE);
+                const float w = static_cast<float>(x % 10) / 10.0f;
+                weights.insert(weights.end(), { 1.0f - w, w * 0.5f, w * 0.3f, w * 0.2f });
+                palette.emplace_back((x % 60) | ((z % 60) << 8) | (((x + z) % 60) << 16) | (((x * z) % 60) << 24));
+            }
+        }
+        std::vector<unsigned int> indices;
+        for (unsigned z = 0; z + 1 < GRID_SIZE; z++)
+        {
+            for (unsigned x = 0; x + 1 < GRID_SIZE; x++)
+            {
+                const unsigned i0 = z * GRID_SIZE + x;
+                indices.insert(indices.end(), { i0, i0 + GRID_SIZE, i0 + 1, i0 + 1, i0 + GRID_SIZE, i0 + GRID_SIZE + 1 });
+            }
+        }
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("compression_benchmark_skin"));
+        const unsigned idx_count = static_cast<unsigned>(indices.size());
+        tri_list->createVertexCapacity(SKIN_VERTEX_FORMAT, VERTEX_COUNT, VERTEX_COUNT, idx_count, idx_count);
+        tri_list->setPosition3Array(positions);
+        tri_list->setVertexNormalArray(normals);
+        tri_list->setVertexTangentArray(tangents);
+        tri_list->setTexture2DCoordArray(0, uvs);
+        tri_list->setTotalSkinWeightArray(weights);
+        tri_list->setPaletteIndexArray(palette);
+        tri_list->setIndexArray(indices);
+        tri_list->calculateBoundingVolume(true);
+        return tri_list;
+    }
+
+    GeometryVertexCompressor::Options allCompressionOptions()
+    {
+        GeometryVertexCompressor::Options options;
+        options.m_octNormal = true;
+        options.m_octTangent = true;
+        options.m_quantizedPosition = true;
+        return options;
+    }
+
+    const std::shared_ptr<TriangleList>& skinMesh(bool is_compressed)
+    {
+        static std::shared_ptr<TriangleList> original = makeSkinMesh();
+        static std::shared_ptr<TriangleList> compressed = []()
+            {
+                auto mesh = makeSkinMesh();
+                GeometryVertexCompressor::Report report;
+                GeometryVertexCompressor::compress(mesh, allCompressionOptions(), report);
+                return mesh;
+            }();
+        return is_compressed ? compressed : original;
+    }
+}
+
+/** import 時的轉換成本與省下的大小 */
+static void BM_CompressSkinMesh(benchmark::State& state)
+{
+    GeometryVertexCompressor::Report report;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto mesh = makeSkinMesh();
+        state.ResumeTiming();
+        GeometryVertexCompressor::compress(mesh, allCompressionOptions(), report);
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+    state.counters["original_bytes"] = static_cast<double>(report.originalBytes());
+    state.counters["compressed_bytes"] = static_cast<double>(report.compressedBytes());
+}
+BENCHMARK(BM_CompressSkinMesh)->Unit(benchmark::kMillisecond);
+
+/** cpu 讀回所有 attribute (bound, picking, cpu skinning 的用法), arg 0 = 0 : 原本的 float 格式, 1 : 壓縮後 */
+static void BM_ReadSkinAttributes(benchmark::State& state)
+{
+    const auto& mesh = skinMesh(state.range(0) != 0);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mesh->getPosition3Array(VERTEX_COUNT).data());
+        benchmark::DoNotOptimize(mesh->getVertexNormalArray(VERTEX_COUNT).data());
+        benchmark::DoNotOptimize(mesh->getVertexTangentArray(VERTEX_COUNT).data());
+        benchmark::DoNotOptimize(mesh->getTexture2DCoordArray(0, VERTEX_COUNT).data());
+        benchmark::DoNotOptimize(mesh->getTotalSkinWeightArray(VERTEX_COUNT).data());
+    }
+    state.SetItemsProcessed(state.iterations() * VERTEX_COUNT);
+    state.counters["vertex_bytes"] = static_cast<double>(mesh->sizeofVertex());
+}
+BENCHMARK(BM_ReadSkinAttributes)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
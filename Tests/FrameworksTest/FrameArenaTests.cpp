@@ -0,0 +1,58 @@
+#include "Frameworks/FrameArena.h"
+#include "Frameworks/menew_make_shared.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    struct Message
+    {
+        Message(unsigned id) : m_id(id) {}
+        unsigned m_id;
+    };
+}
+
+TEST(FrameArenaTest, CountsAllocationsReleasedOnOtherThreads)
+{
+    FrameArena arena;
+    FrameArenaAllocator<Message> allocator(&arena);
+    std::vector<std::shared_ptr<Message>> messages;
+    for (unsigned i = 0; i < 100; i++) messages.emplace_back(std::allocate_shared<Message>(allocator, i));
+    EXPECT_EQ(arena.liveAllocationCount(), 100u);
+
+    std::thread releaser([&messages]() { messages.resize(40); });
+    releaser.join();
+    EXPECT_EQ(arena.liveAllocationCount(), 40u);
+    messages.clear();
+    EXPECT_EQ(arena.liveAllocationCount(), 0u);
+}
+
+TEST(FrameArenaTest, ResetReusesMemory)
+{
+    FrameArena arena;
+    void* first = arena.allocate(64);
+    arena.deallocate(first, 64);
+    arena.reset();
+    void* second = arena.allocate(64);
+    EXPECT_EQ(first, second);
+    arena.deallocate(second, 64);
+}
+
+TEST(FrameArenaTest, RingAllocatesFromCurrentArena)
+{
+    FrameArenaRing ring;
+    ring.advanceFrame();
+    {
+        auto message = stdext::make_frame_shared<Message>(1u);
+        EXPECT_EQ(ring.currentArena()->liveAllocationCount(), 1u);
+    }
+    ring.advanceFrame();
+    ring.advanceFrame();
+    EXPECT_EQ(ring.escapedArenaCount(), 0u);
+    ring.deactivate();
+    EXPECT_EQ(FrameArena::current(), nullptr);
+}
@@ -0,0 +1,127 @@
+#include "Frameworks/JobSystem.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    /** 不幫忙做 job 的等待, 確保 job 都是 worker 做的 */
+    void spinUntilDone(const JobCounterPtr& counter)
+    {
+        while (!counter->isDone()) std::this_thread::yield();
+    }
+
+    unsigned parallelFibonacci(JobSystem& jobs, unsigned n)
+    {
+        if (n < 2) return n;
+        unsigned a = 0;
+        unsigned b = 0;
+        auto counter = jobs.schedule("fib", [&jobs, &a, n]() { a = parallelFibonacci(jobs, n - 1); });
+        jobs.schedule(counter, "fib", [&jobs, &b, n]() { b = parallelFibonacci(jobs, n - 2); });
+        jobs.wait(counter);
+        return a + b;
+    }
+}
+
+TEST(JobSystemTest, WaitRunsAllScheduledJobs)
+{
+    JobSystem jobs(3);
+    std::atomic<unsigned> sum{ 0 };
+    auto counter = std::make_shared<JobCounter>();
+    for (unsigned i = 1; i <= 1000; i++)
+    {
+        jobs.schedule(counter, "add", [&sum, i]() { sum.fetch_add(i); });
+    }
+    jobs.wait(counter);
+    EXPECT_TRUE(counter->isDone());
+    EXPECT_EQ(sum.load(), 500500u);
+    EXPECT_EQ(jobs.executedJobCount(), 1000u);
+}
+
+TEST(JobSystemTest, IdleWorkersStealFromMainQueue)
+{
+    JobSystem jobs(2);
+    std::mutex thread_lock;
+    std::set<std::thread::id> threads;
+    auto counter = std::make_shared<JobCounter>();
+    for (unsigned i = 0; i < 64; i++)
+    {
+        jobs.schedule(counter, "record", [&]()
+            {
+                std::lock_guard locker{ thread_lock };
+                threads.insert(std::this_thread::get_id());
+            });
+    }
+    // main thread 不幫忙, job 都在 main queue, 只能被 worker 偷走
+    spinUntilDone(counter);
+    EXPECT_EQ(jobs.stolenJobCount(), 64u);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+}
+
+TEST(JobSystemTest, NestedJobsWaitInsideJobs)
+{
+    JobSystem jobs(3);
+    // 每層都在 job 裡 wait 子 job, worker 等的時候要幫忙做, 不然會 deadlock
+    unsigned result = 0;
+    jobs.wait(jobs.schedule("root", [&]() { result = parallelFibonacci(jobs, 16); }));
+    EXPECT_EQ(result, 987u);
+}
+
+TEST(JobSystemTest, DependenciesRunInOrder)
+{
+    JobSystem jobs(3);
+    std::mutex order_lock;
+    std::vector<int> order;
+    auto push = [&](int v) { std::lock_guard locker{ order_lock }; order.emplace_back(v); };
+    auto first = jobs.schedule("first", [&]() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); push(1); });
+    auto second = jobs.schedule("second", [&]() { push(2); }, { first });
+    auto third = jobs.schedule("third", [&]() { push(3); }, { first, second });
+    jobs.wait(third);
+    ASSERT_EQ(order.size(), 3u);
+    EXPECT_EQ(order, (std::vector<int>{ 1, 2, 3 }));
+}
+
+TEST(JobSystemTest, MainThreadAffinityRunsOnMainThread)
+{
+    JobSystem jobs(2);
+    std::thread::id run_thread;
+    auto counter = jobs.schedule("main", [&]() { run_thread = std::this_thread::get_id(); }, {}, JobSystem::JobAffinity::MainThread);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(counter->isDone());
+    EXPECT_EQ(jobs.runPendingJobs(), 1u);
+    EXPECT_TRUE(counter->isDone());
+    EXPECT_EQ(run_thread, std::this_thread::get_id());
+}
+
+TEST(JobSystemTest, ParallelForCoversEveryIndexOnce)
+{
+    JobSystem jobs(3);
+    std::vector<std::atomic<unsigned>> hits(10000);
+    jobs.parallelFor("cover", 10000, [&hits](unsigned begin, unsigned end)
+        {
+            for (unsigned i = begin; i < end; i++) hits[i].fetch_add(1);
+        });
+    for (auto& hit : hits)
+    {
+        ASSERT_EQ(hit.load(), 1u);
+    }
+}
+
+TEST(JobSystemTest, DeterministicModeRunsInScheduleOrder)
+{
+    JobSystem jobs(4, JobSystem::ExecutionMode::Deterministic);
+    EXPECT_EQ(jobs.workerCount(), 0u);
+    std::vector<int> order;
+    auto counter = std::make_shared<JobCounter>();
+    for (int i = 0; i < 8; i++)
+    {
+        jobs.schedule(counter, "ordered", [&order, i]() { order.emplace_back(i); });
+    }
+    jobs.wait(counter);
+    EXPECT_EQ(order, (std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7 }));
+}
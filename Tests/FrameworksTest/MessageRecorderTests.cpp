@@ -0,0 +1,69 @@
+#include "Frameworks/MessageRecorder.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    class RecordedEvent : public IEvent
+    {
+    };
+    class RecordedCommand : public ICommand
+    {
+    };
+}
+
+TEST(MessageRecorderTest, RecordsPostedMessages)
+{
+    ServiceManager manager;
+    auto publisher = std::make_shared<EventPublisher>(&manager);
+    auto bus = std::make_shared<CommandBus>(&manager);
+    MessageRecorder recorder(&manager);
+    recorder.start();
+    EventPublisher::post(std::make_shared<RecordedEvent>());
+    CommandBus::post(std::make_shared<RecordedCommand>());
+    EventPublisher::post(std::make_shared<RecordedEvent>());
+    recorder.stop();
+    EventPublisher::post(std::make_shared<RecordedEvent>());
+
+    ASSERT_EQ(recorder.recording().messages().size(), 3u);
+    EXPECT_EQ(recorder.recording().messages()[1].m_channel, MessageChannel::Command);
+}
+
+TEST(MessageRecorderTest, StopWhileOtherThreadPosts)
+{
+    ServiceManager manager;
+    auto publisher = std::make_shared<EventPublisher>(&manager);
+    auto bus = std::make_shared<CommandBus>(&manager);
+    std::atomic<bool> is_posting{ true };
+    std::thread poster([&is_posting]()
+        {
+            while (is_posting)
+            {
+                EventPublisher::post(std::make_shared<RecordedEvent>());
+                CommandBus::post(std::make_shared<RecordedCommand>());
+                std::this_thread::yield();
+            }
+        });
+    for (unsigned i = 0; i < 200; i++)
+    {
+        // recorder 在 stop 後立刻 destruct, hook 不可以還在用它
+        auto recorder = std::make_unique<MessageRecorder>(&manager);
+        recorder->start();
+        std::this_thread::yield();
+        recorder->stop();
+        const size_t count = recorder->recording().messages().size();
+        std::this_thread::yield();
+        EXPECT_EQ(recorder->recording().messages().size(), count);
+    }
+    is_posting = false;
+    poster.join();
+    publisher->cleanupAllEvents();
+    bus->cleanupAllCommands();
+}
@@ -0,0 +1,168 @@
+#include "Frameworks/MessageReplayer.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/SystemService.h"
+#include "Frameworks/EventPublisher.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+using namespace Enigma::Frameworks;
+
+namespace Enigma::FrameworksTest
+{
+    class AlphaEvent : public IEvent
+    {
+    };
+    class BetaEvent : public IEvent
+    {
+    };
+
+    /** 每個 tick 照著 script post event, 模擬 service 自己產生的結果 */
+    class ScriptedService : public ISystemService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using FrameScript = std::vector<std::vector<std::shared_ptr<IEvent>>>;
+
+        ScriptedService(ServiceManager* manager) : ISystemService(manager)
+        {
+            m_needTick = true;
+        }
+
+        virtual ServiceResult onTick() override
+        {
+            if (m_tickIndex < m_script.size())
+            {
+                for (const auto& e : m_script[m_tickIndex]) EventPublisher::post(e);
+            }
+            m_tickIndex++;
+            return ServiceResult::Pendding;
+        }
+
+        void resetScript(const FrameScript& script)
+        {
+            m_script = script;
+            m_tickIndex = 0;
+        }
+
+    protected:
+        FrameScript m_script;
+        size_t m_tickIndex = 0;
+    };
+}
+
+DEFINE_RTTI(FrameworksTest, ScriptedService, Enigma::Frameworks::ISystemService);
+
+using Enigma::FrameworksTest::AlphaEvent;
+using Enigma::FrameworksTest::BetaEvent;
+using Enigma::FrameworksTest::ScriptedService;
+
+namespace
+{
+    constexpr unsigned FRAME_COUNT = 4;
+
+    std::shared_ptr<IEvent> alpha() { return std::make_shared<AlphaEvent>(); }
+    std::shared_ptr<IEvent> beta() { return std::make_shared<BetaEvent>(); }
+
+    ScriptedService::FrameScript recordedScript()
+    {
+        return { { alpha() }, { alpha(), beta() }, {}, { beta() } };
+    }
+
+    class MessageReplayerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            m_publisher = std::make_shared<EventPublisher>(&m_manager);
+            m_service = std::make_shared<ScriptedService>(&m_manager);
+            m_manager.registerSystemService(m_service);
+            m_manager.runToState(ServiceManager::ServiceState::Running);
+
+            m_service->resetScript(recordedScript());
+            MessageRecorder recorder(&m_manager);
+            recorder.start();
+            for (unsigned i = 0; i < FRAME_COUNT; i++) m_manager.runOnce();
+            recorder.stop();
+            m_recording = recorder.recording();
+        }
+        void TearDown() override
+        {
+            m_publisher->cleanupAllEvents();
+        }
+
+        /** 用另一個 script 重播, 回傳有沒有 divergence */
+        bool replay(const ScriptedService::FrameScript& script)
+        {
+            m_service->resetScript(script);
+            m_replayer = std::make_unique<MessageReplayer>(&m_manager, m_recording);
+            return m_replayer->run();
+        }
+
+        ServiceManager m_manager;
+        std::shared_ptr<EventPublisher> m_publisher;
+        std::shared_ptr<ScriptedService> m_service;
+        MessageRecording m_recording;
+        std::unique_ptr<MessageReplayer> m_replayer;
+    };
+}
+
+TEST_F(MessageReplayerTest, SameMessagesHaveNoDivergence)
+{
+    ASSERT_EQ(m_recording.messages().size(), 4u);
+    ASSERT_EQ(m_recording.frameCount(), FRAME_COUNT);
+    EXPECT_TRUE(replay(recordedScript()));
+    EXPECT_FALSE(m_replayer->divergence().has_value());
+    EXPECT_EQ(m_replayer->replayedRecording().messages(), m_recording.messages());
+}
+
+TEST_F(MessageReplayerTest, ReportsExpectedAndActualType)
+{
+    EXPECT_FALSE(replay({ { alpha() }, { beta(), beta() }, {}, { beta() } }));
+    const auto& divergence = m_replayer->divergence();
+    ASSERT_TRUE(divergence.has_value());
+    EXPECT_EQ(divergence->m_index, 1u);
+    ASSERT_TRUE(divergence->m_expected.has_value());
+    ASSERT_TRUE(divergence->m_actual.has_value());
+    EXPECT_EQ(divergence->m_expected->m_typeName, typeid(AlphaEvent).name());
+    EXPECT_EQ(divergence->m_actual->m_typeName, typeid(BetaEvent).name());
+    EXPECT_EQ(divergence->m_expected->m_frame, divergence->m_actual->m_frame);
+    EXPECT_NE(divergence->toString().find(typeid(AlphaEvent).name()), std::string::npos);
+}
+
+TEST_F(MessageReplayerTest, ReportsMissingMessage)
+{
+    EXPECT_FALSE(replay({ { alpha() }, { alpha(), beta() }, {}, {} }));
+    const auto& divergence = m_replayer->divergence();
+    ASSERT_TRUE(divergence.has_value());
+    EXPECT_EQ(divergence->m_index, 3u);
+    ASSERT_TRUE(divergence->m_expected.has_value());
+    EXPECT_EQ(divergence->m_expected->m_typeName, typeid(BetaEvent).name());
+    EXPECT_FALSE(divergence->m_actual.has_value());
+    EXPECT_NE(divergence->toString().find("replayed nothing"), std::string::npos);
+}
+
+TEST_F(MessageReplayerTest, ReportsExtraMessage)
+{
+    EXPECT_FALSE(replay({ { alpha() }, { alpha(), beta() }, {}, { beta(), alpha() } }));
+    const auto& divergence = m_replayer->divergence();
+    ASSERT_TRUE(divergence.has_value());
+    EXPECT_EQ(divergence->m_index, 4u);
+    EXPECT_FALSE(divergence->m_expected.has_value());
+    ASSERT_TRUE(divergence->m_actual.has_value());
+    EXPECT_EQ(divergence->m_actual->m_typeName, typeid(AlphaEvent).name());
+    EXPECT_NE(divergence->toString().find("expected nothing"), std::string::npos);
+}
+
+TEST_F(MessageReplayerTest, ReportsMessageInWrongFrame)
+{
+    EXPECT_FALSE(replay({ { alpha() }, { alpha() }, { beta() }, { beta() } }));
+    const auto& divergence = m_replayer->divergence();
+    ASSERT_TRUE(divergence.has_value());
+    EXPECT_EQ(divergence->m_index, 2u);
+    ASSERT_TRUE(divergence->m_expected.has_value());
+    ASSERT_TRUE(divergence->m_actual.has_value());
+    EXPECT_EQ(divergence->m_expected->m_typeName, divergence->m_actual->m_typeName);
+    EXPECT_LT(divergence->m_expected->m_frame, divergence->m_actual->m_frame);
+}
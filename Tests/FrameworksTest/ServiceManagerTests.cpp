@@ -0,0 +1,274 @@
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/SystemService.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/JobSystem.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Enigma::Frameworks;
+
+namespace Enigma::FrameworksTest
+{
+    /** 宣告 tick 相依, running 時走 tick schedule */
+    class ScheduledService : public ISystemService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        ScheduledService(ServiceManager* manager) : ISystemService(manager)
+        {
+            m_needTick = true;
+            declareTickWrite("scheduled");
+            declareTickOnAnyThread();
+        }
+
+        virtual ServiceResult onTick() override
+        {
+            m_tickCount++;
+            return ServiceResult::Pendding;
+        }
+        virtual ServiceResult onTerm() override
+        {
+            m_termCount++;
+            return ServiceResult::Complete;
+        }
+
+        std::atomic<unsigned> m_tickCount{ 0 };
+        std::atomic<unsigned> m_termCount{ 0 };
+    };
+
+    /** tick 時把自己的名字記到共用的 log, 相依在註冊前由測試宣告 */
+    class OrderedService : public ISystemService
+    {
+    public:
+        struct TickLog
+        {
+            std::mutex m_lock;
+            std::vector<std::string> m_names;
+        };
+
+        OrderedService(ServiceManager* manager, TickLog* log, std::chrono::milliseconds tick_duration)
+            : ISystemService(manager), m_log(log), m_tickDuration(tick_duration)
+        {
+            m_needTick = true;
+            declareTickOnAnyThread();
+        }
+
+        void tickAfter(const Rtti& service_type) { declareTickAfter(service_type); }
+        void tickBefore(const Rtti& service_type) { declareTickBefore(service_type); }
+        void tickWrite(const std::string& resource) { declareTickWrite(resource); }
+
+        virtual ServiceResult onTick() override
+        {
+            if (m_tickDuration.count() > 0) std::this_thread::sleep_for(m_tickDuration);
+            std::lock_guard locker{ m_log->m_lock };
+            m_log->m_names.emplace_back(typeInfo().getName());
+            return ServiceResult::Pendding;
+        }
+
+    protected:
+        TickLog* m_log;
+        std::chrono::milliseconds m_tickDuration;
+    };
+    class InputService : public OrderedService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using OrderedService::OrderedService;
+    };
+    class PhysicsService : public OrderedService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using OrderedService::OrderedService;
+    };
+    class AudioService : public OrderedService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using OrderedService::OrderedService;
+    };
+    class RenderService : public OrderedService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using OrderedService::OrderedService;
+    };
+}
+
+DEFINE_RTTI(FrameworksTest, ScheduledService, Enigma::Frameworks::ISystemService);
+DEFINE_RTTI(FrameworksTest, InputService, Enigma::Frameworks::ISystemService);
+DEFINE_RTTI(FrameworksTest, PhysicsService, Enigma::Frameworks::ISystemService);
+DEFINE_RTTI(FrameworksTest, AudioService, Enigma::Frameworks::ISystemService);
+DEFINE_RTTI(FrameworksTest, RenderService, Enigma::Frameworks::ISystemService);
+
+using Enigma::FrameworksTest::ScheduledService;
+using Enigma::FrameworksTest::OrderedService;
+using Enigma::FrameworksTest::InputService;
+using Enigma::FrameworksTest::PhysicsService;
+using Enigma::FrameworksTest::AudioService;
+using Enigma::FrameworksTest::RenderService;
+
+namespace
+{
+    void checkUnregisterDuringScheduledTick(JobSystem* job_system)
+    {
+        ServiceManager manager;
+        manager.setJobSystem(job_system);
+        manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+        auto service = std::make_shared<ScheduledService>(&manager);
+        manager.registerSystemService(service);
+        manager.runToState(ServiceManager::ServiceState::Running);
+        for (unsigned i = 0; i < 3; i++) manager.runOnce();
+        ASSERT_GT(service->m_tickCount.load(), 0u);
+
+        manager.unregisterSystemService(ScheduledService::TYPE_RTTI);
+        const unsigned tick_count = service->m_tickCount.load();
+        for (unsigned i = 0; i < 8; i++) manager.runOnce();
+
+        EXPECT_EQ(service->m_tickCount.load(), tick_count);
+        EXPECT_EQ(service->m_termCount.load(), 1u);
+        EXPECT_EQ(manager.checkServiceState(ScheduledService::TYPE_RTTI), ServiceManager::ServiceState::Deleted);
+    }
+
+    size_t tickPosition(const std::vector<std::string>& names, const Enigma::Frameworks::Rtti& service_type)
+    {
+        return static_cast<size_t>(std::find(names.begin(), names.end(), service_type.getName()) - names.begin());
+    }
+
+    /** 註冊順序跟相依順序相反: render after physics, physics after input, audio before input */
+    void checkTickOrderFollowsDependencies(JobSystem* job_system)
+    {
+        OrderedService::TickLog log;
+        ServiceManager manager;
+        manager.setJobSystem(job_system);
+        manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+        auto render = std::make_shared<RenderService>(&manager, &log, std::chrono::milliseconds(0));
+        render->tickAfter(PhysicsService::TYPE_RTTI);
+        auto physics = std::make_shared<PhysicsService>(&manager, &log, std::chrono::milliseconds(0));
+        physics->tickAfter(InputService::TYPE_RTTI);
+        auto input = std::make_shared<InputService>(&manager, &log, std::chrono::milliseconds(0));
+        auto audio = std::make_shared<AudioService>(&manager, &log, std::chrono::milliseconds(0));
+        audio->tickBefore(InputService::TYPE_RTTI);
+        manager.registerSystemService(render);
+        manager.registerSystemService(physics);
+        manager.registerSystemService(input);
+        manager.registerSystemService(audio);
+        EXPECT_FALSE(manager.hasTickScheduleCycle());
+        EXPECT_TRUE(manager.tickScheduleDiagnostic().empty());
+        // event publisher 沒有宣告相依, 排在最前面; 之後是 audio -> input -> physics -> render
+        EXPECT_EQ(manager.criticalPathLength(), 5u);
+
+        manager.runToState(ServiceManager::ServiceState::Running);
+        for (unsigned frame = 0; frame < 5; frame++)
+        {
+            log.m_names.clear();
+            manager.runOnce();
+            ASSERT_EQ(log.m_names.size(), 4u);
+            EXPECT_LT(tickPosition(log.m_names, AudioService::TYPE_RTTI), tickPosition(log.m_names, InputService::TYPE_RTTI));
+            EXPECT_LT(tickPosition(log.m_names, InputService::TYPE_RTTI), tickPosition(log.m_names, PhysicsService::TYPE_RTTI));
+            EXPECT_LT(tickPosition(log.m_names, PhysicsService::TYPE_RTTI), tickPosition(log.m_names, RenderService::TYPE_RTTI));
+        }
+    }
+}
+
+TEST(ServiceManagerTest, UnregisterDuringSequentialScheduleRunsTerm)
+{
+    checkUnregisterDuringScheduledTick(nullptr);
+}
+
+TEST(ServiceManagerTest, UnregisterDuringParallelScheduleRunsTerm)
+{
+    JobSystem jobs(2);
+    checkUnregisterDuringScheduledTick(&jobs);
+}
+
+TEST(ServiceManagerTest, SequentialTickOrderFollowsDependencies)
+{
+    checkTickOrderFollowsDependencies(nullptr);
+}
+
+TEST(ServiceManagerTest, ParallelTickOrderFollowsDependencies)
+{
+    JobSystem jobs(2);
+    checkTickOrderFollowsDependencies(&jobs);
+}
+
+TEST(ServiceManagerTest, CycleFallsBackToRegistrationOrder)
+{
+    OrderedService::TickLog log;
+    ServiceManager manager;
+    JobSystem jobs(2);
+    manager.setJobSystem(&jobs);
+    manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+    // input -> physics -> render -> input
+    auto input = std::make_shared<InputService>(&manager, &log, std::chrono::milliseconds(0));
+    input->tickAfter(RenderService::TYPE_RTTI);
+    auto physics = std::make_shared<PhysicsService>(&manager, &log, std::chrono::milliseconds(0));
+    physics->tickAfter(InputService::TYPE_RTTI);
+    auto render = std::make_shared<RenderService>(&manager, &log, std::chrono::milliseconds(0));
+    render->tickAfter(PhysicsService::TYPE_RTTI);
+    manager.registerSystemService(input);
+    manager.registerSystemService(physics);
+    manager.registerSystemService(render);
+
+    ASSERT_TRUE(manager.hasTickScheduleCycle());
+    const std::string& diagnostic = manager.tickScheduleDiagnostic();
+    EXPECT_NE(diagnostic.find("cycle"), std::string::npos);
+    EXPECT_NE(diagnostic.find(InputService::TYPE_RTTI.getName()), std::string::npos);
+    EXPECT_NE(diagnostic.find(PhysicsService::TYPE_RTTI.getName()), std::string::npos);
+    EXPECT_NE(diagnostic.find(RenderService::TYPE_RTTI.getName()), std::string::npos);
+    EXPECT_NE(diagnostic.find("fall back to registration order"), std::string::npos);
+    // 整個退回成一條鏈
+    EXPECT_EQ(manager.criticalPathLength(), 4u);
+
+    manager.runToState(ServiceManager::ServiceState::Running);
+    log.m_names.clear();
+    manager.runOnce();
+    const std::vector<std::string> expected = { InputService::TYPE_RTTI.getName(), PhysicsService::TYPE_RTTI.getName(), RenderService::TYPE_RTTI.getName() };
+    EXPECT_EQ(log.m_names, expected);
+
+    // 拿掉一個之後 cycle 就解開了
+    manager.unregisterSystemService(RenderService::TYPE_RTTI);
+    for (unsigned i = 0; i < 4; i++) manager.runOnce();
+    manager.registerSystemService(std::make_shared<AudioService>(&manager, &log, std::chrono::milliseconds(0)));
+    EXPECT_FALSE(manager.hasTickScheduleCycle());
+    EXPECT_TRUE(manager.tickScheduleDiagnostic().empty());
+}
+
+TEST(ServiceManagerTest, CriticalPathReport)
+{
+    constexpr auto TICK_DURATION = std::chrono::milliseconds(5);
+    constexpr float TICK_SECONDS = 0.005f;
+    OrderedService::TickLog log;
+    ServiceManager manager;
+    JobSystem jobs(2);
+    manager.setJobSystem(&jobs);
+    manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+    // input, audio 互不相干, render 在兩個之後
+    auto input = std::make_shared<InputService>(&manager, &log, TICK_DURATION);
+    input->tickWrite("input");
+    auto audio = std::make_shared<AudioService>(&manager, &log, TICK_DURATION);
+    audio->tickWrite("audio");
+    auto render = std::make_shared<RenderService>(&manager, &log, TICK_DURATION);
+    render->tickAfter(InputService::TYPE_RTTI);
+    render->tickAfter(AudioService::TYPE_RTTI);
+    manager.registerSystemService(input);
+    manager.registerSystemService(audio);
+    manager.registerSystemService(render);
+    // publisher -> input / audio -> render
+    EXPECT_EQ(manager.criticalPathLength(), 3u);
+
+    manager.runToState(ServiceManager::ServiceState::Running);
+    manager.runOnce();
+    // critical path 是 max(input, audio) + render, total 是三個加起來, 兩者差 min(input, audio)
+    EXPECT_GE(manager.lastTotalTickTime(), 3.0f * TICK_SECONDS);
+    EXPECT_GE(manager.lastCriticalPathTime(), 2.0f * TICK_SECONDS);
+    EXPECT_GE(manager.lastTotalTickTime() - manager.lastCriticalPathTime(), TICK_SECONDS);
+}
@@ -0,0 +1,269 @@
+#include "GameEngine/EffectCompilingQueue.h"
+#include "GameEngine/EffectMaterial.h"
+#include "GameEngine/EffectMaterialSource.h"
+#include "GameEngine/EffectEvents.h"
+#include "GameEngine/ShaderCommands.h"
+#include "GameEngine/ShaderEvents.h"
+#include "GraphicKernel/GraphicCommands.h"
+#include "GraphicKernel/GraphicEvents.h"
+#include "GraphicKernel/IShaderProgram.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include <gtest/gtest.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Enigma::Engine;
+using namespace Enigma::Frameworks;
+using namespace Enigma::Graphics;
+
+namespace
+{
+    constexpr unsigned EFFECT_COUNT = 300;
+    constexpr unsigned PROGRAM_COUNT = 10;
+    /// 3 個 sampler, 1 個 blend, 1 個 depth, 2 個 rasterizer
+    constexpr unsigned STATE_COUNT = 7;
+    /// stub backend 的 command 在幾個 tick 之後完成
+    constexpr unsigned BACKEND_LATENCY_TICKS = 3;
+    constexpr unsigned MAX_TICKS = 10000;
+
+    class StubShaderProgram : public IShaderProgram
+    {
+    public:
+        StubShaderProgram(const std::string& name) : IShaderProgram(name, nullptr, nullptr, nullptr) {}
+        virtual IShaderVariablePtr GetVariableByName(const std::string&) override { return nullptr; }
+        virtual IShaderVariablePtr GetVariableBySemantic(const std::string&) override { return nullptr; }
+        virtual unsigned int GetVariableCount() override { return 0; }
+        virtual IShaderVariablePtr GetVariableByIndex(unsigned int) override { return nullptr; }
+        virtual error ApplyShaderVariables() override { return {}; }
+        virtual future_error AsyncApplyShaderVariables() override { return {}; }
+    };
+    template <class State> class StubDeviceState : public State
+    {
+    public:
+        StubDeviceState(const std::string& name) : State(name) {}
+        virtual error BindToDevice() override { return {}; }
+    };
+    class StubSamplerState : public IDeviceSamplerState
+    {
+    public:
+        StubSamplerState(const std::string& name) : IDeviceSamplerState(name) {}
+    };
+
+    /** 收下 program / state 的 command, 固定幾個 tick 之後才回 built event, 模擬非同步的 device */
+    class StubDeviceBackend
+    {
+    public:
+        StubDeviceBackend()
+        {
+            subscribe<BuildShaderProgram>([this](BuildShaderProgram& cmd)
+                {
+                    m_programCommandCount++;
+                    const std::string name = cmd.GetPolicy().m_programName;
+                    if (name == m_failingProgram) return complete([name]() { EventPublisher::post(std::make_shared<BuildShaderProgramFailed>(name, std::make_error_code(std::errc::io_error))); });
+                    complete([name]() { EventPublisher::post(std::make_shared<ShaderProgramBuilt>(name, std::make_shared<StubShaderProgram>(name))); });
+                });
+            subscribe<CreateSamplerState>([this](CreateSamplerState& cmd)
+                {
+                    complete([name = cmd.getName()]() { EventPublisher::post(std::make_shared<DeviceSamplerStateCreated>(name, std::make_shared<StubSamplerState>(name))); });
+                });
+            subscribe<CreateBlendState>([this](CreateBlendState& cmd)
+                {
+                    complete([name = cmd.getName()]() { EventPublisher::post(std::make_shared<DeviceAlphaBlendStateCreated>(name, std::make_shared<StubDeviceState<IDeviceAlphaBlendState>>(name))); });
+                });
+            subscribe<CreateDepthStencilState>([this](CreateDepthStencilState& cmd)
+                {
+                    complete([name = cmd.getName()]() { EventPublisher::post(std::make_shared<DeviceDepthStencilStateCreated>(name, std::make_shared<StubDeviceState<IDeviceDepthStencilState>>(name))); });
+                });
+            subscribe<CreateRasterizerState>([this](CreateRasterizerState& cmd)
+                {
+                    complete([name = cmd.getName()]() { EventPublisher::post(std::make_shared<DeviceRasterizerStateCreated>(name, std::make_shared<StubDeviceState<IDeviceRasterizerState>>(name))); });
+                });
+        }
+        ~StubDeviceBackend()
+        {
+            for (auto& [type, subscriber] : m_subscribers) CommandBus::unsubscribe(*type, subscriber);
+        }
+
+        void failProgram(const std::string& name) { m_failingProgram = name; }
+        unsigned programCommandCount() const { return m_programCommandCount; }
+        unsigned stateCommandCount() const { return m_commandCount - m_programCommandCount; }
+
+        /** 到期的 command 送出結果 */
+        void tick()
+        {
+            std::vector<std::function<void()>> due;
+            std::vector<std::pair<unsigned, std::function<void()>>> waiting;
+            for (auto& [ticks, fn] : m_pending)
+            {
+                if (--ticks == 0) due.emplace_back(std::move(fn));
+                else waiting.emplace_back(ticks, std::move(fn));
+            }
+            m_pending = std::move(waiting);
+            for (auto& fn : due) fn();
+        }
+
+    protected:
+        template <class Command> void subscribe(const std::function<void(Command&)>& handler)
+        {
+            auto subscriber = std::make_shared<CommandSubscriber>([this, handler](const ICommandPtr& c)
+                {
+                    auto cmd = std::dynamic_pointer_cast<Command, ICommand>(c);
+                    if (!cmd) return;
+                    m_commandCount++;
+                    handler(*cmd);
+                });
+            CommandBus::subscribe(typeid(Command), subscriber);
+            m_subscribers.emplace_back(&typeid(Command), subscriber);
+        }
+        void complete(std::function<void()>&& fn)
+        {
+            m_pending.emplace_back(BACKEND_LATENCY_TICKS, std::move(fn));
+        }
+
+    protected:
+        std::vector<std::pair<const std::type_info*, CommandSubscriberPtr>> m_subscribers;
+        std::vector<std::pair<unsigned, std::function<void()>>> m_pending;
+        std::string m_failingProgram;
+        unsigned m_commandCount = 0;
+        unsigned m_programCommandCount = 0;
+    };
+
+    /** 兩個 pass, program 與 device state 在 effect 之間大量重複 */
+    EffectCompilingProfile makeProfile(unsigned index)
+    {
+        EffectCompilingProfile profile;
+        profile.m_name = "fx_" + std::to_string(index);
+        EffectTechniqueProfile technique;
+        technique.m_name = "Default";
+        for (unsigned p = 0; p < 2; p++)
+        {
+            EffectPassProfile pass;
+            pass.m_name = "pass_" + std::to_string(p);
+            pass.m_program.m_programName = "program_" + std::to_string((index + p) % PROGRAM_COUNT);
+            pass.m_samplers.push_back({ "sampler_" + std::to_string(index % 3), {}, "DiffuseMap" });
+            pass.m_blend.m_name = "blend";
+            pass.m_depth.m_name = "depth";
+            pass.m_rasterizer.m_name = "rasterizer_" + std::to_string(p);
+            technique.m_passes.push_back(pass);
+        }
+        profile.m_techniques.push_back(technique);
+        return profile;
+    }
+
+    class EffectCompilingQueueTest : public testing::Test
+    {
+    protected:
+        virtual void SetUp() override
+        {
+            m_eventPublisher = std::make_shared<EventPublisher>(&m_serviceManager);
+            m_commandBus = std::make_shared<CommandBus>(&m_serviceManager);
+            m_serviceManager.registerSystemService(m_eventPublisher);
+            m_serviceManager.registerSystemService(m_commandBus);
+            m_backend = std::make_unique<StubDeviceBackend>();
+            m_onCompiled = std::make_shared<EventSubscriber>([this](const IEventPtr&) { m_compiledCount++; });
+            EventPublisher::subscribe(typeid(EffectMaterialSourceCompiled), m_onCompiled);
+            m_onFailed = std::make_shared<EventSubscriber>([this](const IEventPtr&) { m_failedCount++; });
+            EventPublisher::subscribe(typeid(CompileEffectMaterialSourceFailed), m_onFailed);
+        }
+        virtual void TearDown() override
+        {
+            EventPublisher::unsubscribe(typeid(EffectMaterialSourceCompiled), m_onCompiled);
+            EventPublisher::unsubscribe(typeid(CompileEffectMaterialSourceFailed), m_onFailed);
+            m_backend = nullptr;
+            m_sources.clear();
+        }
+
+        /** 所有 effect 一次 enqueue, 跑到全部編完, @return 經過的 tick 數 */
+        unsigned compileAll(EffectCompilingQueue& queue)
+        {
+            for (unsigned i = 0; i < EFFECT_COUNT; i++)
+            {
+                auto source = std::make_shared<EffectMaterialSource>(EffectMaterialId("fx_" + std::to_string(i)));
+                source->linkSourceSelf();
+                m_sources.push_back(source);
+                queue.enqueue(source->self(), makeProfile(i));
+            }
+            queue.compileNextEffect();
+            unsigned ticks = 0;
+            while ((m_compiledCount + m_failedCount < EFFECT_COUNT) && (ticks < MAX_TICKS))
+            {
+                ticks++;
+                m_serviceManager.runOnce();
+                m_backend->tick();
+            }
+            return ticks;
+        }
+
+        ServiceManager m_serviceManager;
+        std::shared_ptr<EventPublisher> m_eventPublisher;
+        std::shared_ptr<CommandBus> m_commandBus;
+        std::unique_ptr<StubDeviceBackend> m_backend;
+        EventSubscriberPtr m_onCompiled;
+        EventSubscriberPtr m_onFailed;
+        std::vector<std::shared_ptr<EffectMaterialSource>> m_sources;
+        unsigned m_compiledCount = 0;
+        unsigned m_failedCount = 0;
+    };
+}
+
+TEST_F(EffectCompilingQueueTest, SerialQueueCompilesEveryEffect)
+{
+    EffectCompilingQueue queue(1);
+    const unsigned ticks = compileAll(queue);
+    EXPECT_EQ(m_compiledCount, EFFECT_COUNT);
+    EXPECT_EQ(m_failedCount, 0u);
+    EXPECT_GE(ticks, EFFECT_COUNT);
+    EXPECT_EQ(queue.statistics().m_peakCompilingCount, 1u);
+    EXPECT_TRUE(m_sources.back()->self()->lazyStatus().isReady());
+}
+
+TEST_F(EffectCompilingQueueTest, ConcurrentCompilingTakesFewerTicks)
+{
+    unsigned serial_ticks = 0;
+    {
+        EffectCompilingQueue serial_queue(1);
+        serial_ticks = compileAll(serial_queue);
+        ASSERT_EQ(m_compiledCount, EFFECT_COUNT);
+    }
+    m_compiledCount = 0;
+    m_sources.clear();
+    EffectCompilingQueue queue(EffectCompilingQueue::DefaultMaxCompilingEffects);
+    const unsigned ticks = compileAll(queue);
+    const auto statistics = queue.statistics();
+    EXPECT_EQ(m_compiledCount, EFFECT_COUNT);
+    EXPECT_EQ(statistics.m_compiledEffectCount, EFFECT_COUNT);
+    EXPECT_EQ(statistics.m_peakCompilingCount, EffectCompilingQueue::DefaultMaxCompilingEffects);
+    EXPECT_LT(ticks * 4, serial_ticks);
+    EXPECT_TRUE(m_sources.back()->self()->lazyStatus().isReady());
+}
+
+TEST_F(EffectCompilingQueueTest, SameNamedObjectsAreIssuedOnce)
+{
+    EffectCompilingQueue queue(EffectCompilingQueue::DefaultMaxCompilingEffects);
+    compileAll(queue);
+    const auto statistics = queue.statistics();
+    EXPECT_EQ(m_compiledCount, EFFECT_COUNT);
+    EXPECT_EQ(m_backend->programCommandCount(), PROGRAM_COUNT);
+    EXPECT_EQ(m_backend->stateCommandCount(), STATE_COUNT);
+    EXPECT_EQ(statistics.m_issuedProgramCount, PROGRAM_COUNT);
+    EXPECT_EQ(statistics.m_issuedStateCount, STATE_COUNT);
+    EXPECT_GT(statistics.m_sharedRequestCount, 0u);
+}
+
+TEST_F(EffectCompilingQueueTest, FailedProgramFailsOnlyItsEffects)
+{
+    m_backend->failProgram("program_3");
+    EffectCompilingQueue queue(EffectCompilingQueue::DefaultMaxCompilingEffects);
+    compileAll(queue);
+    const auto statistics = queue.statistics();
+    EXPECT_EQ(m_compiledCount + m_failedCount, EFFECT_COUNT);
+    EXPECT_GT(m_failedCount, 0u);
+    EXPECT_GT(m_compiledCount, 0u);
+    EXPECT_EQ(statistics.m_failedEffectCount, m_failedCount);
+    EXPECT_EQ(statistics.m_compiledEffectCount, m_compiledCount);
+}
@@ -0,0 +1,179 @@
+#include "GameEngine/TextureRepository.h"
+#include "GameEngine/TextureResidencyManager.h"
+#include "GameEngine/TextureStoreMapper.h"
+#include "GameEngine/Texture.h"
+#include "GameEngine/TextureDto.h"
+#include "GraphicKernel/ITexture.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include "Frameworks/QueryDispatcher.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace Enigma::Engine;
+using namespace Enigma::Frameworks;
+using namespace Enigma::Graphics;
+
+namespace
+{
+    /** 不碰 device 的 texture, 只記著尺寸 */
+    class StubDeviceTexture : public ITexture
+    {
+    public:
+        StubDeviceTexture(const std::string& name, const Enigma::MathLib::Dimension<unsigned>& dimension) : ITexture(name)
+        {
+            m_isCubeTexture = false;
+            m_dimension = dimension;
+            m_format = GraphicFormat::FMT_A8R8G8B8;
+        }
+
+    protected:
+        virtual error loadTextureImage(const byte_buffer&) override { return {}; }
+        virtual error createFromSystemMemory(const Enigma::MathLib::Dimension<unsigned>&, const byte_buffer&) override { return {}; }
+        virtual error saveTextureImage(const Enigma::FileSystem::IFilePtr&) override { return {}; }
+        virtual error retrieveTextureImage(const Enigma::MathLib::Rect&) override { return {}; }
+        virtual error updateTextureImage(const Enigma::MathLib::Rect&, const byte_buffer&) override { return {}; }
+        virtual error useAsBackSurface(const IBackSurfacePtr&, const std::vector<RenderTextureUsage>&) override { return {}; }
+    };
+
+    class StubTextureStoreMapper : public TextureStoreMapper
+    {
+    public:
+        virtual std::error_code connect() override { return {}; }
+        virtual std::error_code disconnect() override { return {}; }
+        virtual bool hasTexture(const TextureId& id) override { return m_dtos.find(id.name()) != m_dtos.end(); }
+        virtual std::optional<GenericDto> queryTexture(const TextureId& id) override
+        {
+            auto it = m_dtos.find(id.name());
+            if (it == m_dtos.end()) return std::nullopt;
+            return it->second;
+        }
+        virtual std::error_code removeTexture(const TextureId& id) override { m_dtos.erase(id.name()); return {}; }
+        virtual std::error_code putTexture(const TextureId& id, const GenericDto& dto) override { m_dtos.insert_or_assign(id.name(), dto); return {}; }
+
+    protected:
+        std::unordered_map<std::string, GenericDto> m_dtos;
+    };
+
+    constexpr unsigned TEXTURE_SIZE = 64;
+
+    class TextureResidencyTest : public testing::Test
+    {
+    protected:
+        virtual void SetUp() override
+        {
+            m_eventPublisher = std::make_shared<EventPublisher>(&m_serviceManager);
+            m_commandBus = std::make_shared<CommandBus>(&m_serviceManager);
+            m_queryDispatcher = std::make_shared<QueryDispatcher>(&m_serviceManager);
+            m_repository = std::make_shared<TextureRepository>(&m_serviceManager, std::make_shared<StubTextureStoreMapper>());
+            // 用過的 frame stamp 要比 grace frames 舊
+            for (unsigned i = 0; i < 8; i++) m_repository->residencyManager()->advanceFrame();
+        }
+        virtual void TearDown() override
+        {
+            m_repository = nullptr;
+            m_queryDispatcher = nullptr;
+            m_commandBus = nullptr;
+            m_eventPublisher = nullptr;
+        }
+
+        /** 從檔案 load 的 texture, 已經 hydrate 到 stub device texture */
+        std::shared_ptr<Texture> putResidentTexture(const std::string& name)
+        {
+            TextureDto dto;
+            dto.format() = GraphicFormat::FMT_A8R8G8B8;
+            dto.dimension() = { TEXTURE_SIZE, TEXTURE_SIZE };
+            dto.surfaceCount() = 1;
+            dto.filePaths() = { name + ".png@APK_PATH" };
+            auto texture = std::make_shared<Texture>(TextureId{ name }, dto.toGenericDto());
+            texture->lazyStatus().changeStatus(LazyStatus::Status::Loading);
+            texture->instanceDeviceTexture(std::make_shared<StubDeviceTexture>(name, Enigma::MathLib::Dimension<unsigned>{ TEXTURE_SIZE, TEXTURE_SIZE }));
+            m_repository->putTexture(texture->id(), texture);
+            return texture;
+        }
+
+        ServiceManager m_serviceManager;
+        std::shared_ptr<EventPublisher> m_eventPublisher;
+        std::shared_ptr<CommandBus> m_commandBus;
+        std::shared_ptr<QueryDispatcher> m_queryDispatcher;
+        std::shared_ptr<TextureRepository> m_repository;
+    };
+}
+
+TEST_F(TextureResidencyTest, UnlimitedBudgetKeepsEveryTextureResident)
+{
+    auto textures = std::vector{ putResidentTexture("a"), putResidentTexture("b"), putResidentTexture("c") };
+    for (unsigned i = 0; i < 4; i++) m_repository->updateResidency();
+    for (auto& tex : textures)
+    {
+        EXPECT_TRUE(tex->lazyStatus().isReady());
+        EXPECT_TRUE(tex->getDeviceTexture());
+    }
+    EXPECT_EQ(m_repository->residencyManager()->evictedCount(), 0u);
+}
+
+TEST_F(TextureResidencyTest, OverBudgetEvictsLeastRecentlyUsedFirst)
+{
+    auto oldest = putResidentTexture("oldest");
+    auto older = putResidentTexture("older");
+    auto current = putResidentTexture("current");
+    const std::uint64_t stamp = TextureResidencyManager::frameStamp();
+    oldest->markUsed(stamp - 6);
+    older->markUsed(stamp - 5);
+    current->markUsed(stamp);
+    m_repository->residencyManager()->budgetBytes(current->estimateResidentBytes() * 2);
+
+    const std::uint64_t older_epoch = older->deviceTextureEpoch();
+    const std::uint64_t oldest_epoch = oldest->deviceTextureEpoch();
+    m_repository->updateResidency();
+
+    EXPECT_TRUE(oldest->lazyStatus().isGhost());
+    EXPECT_TRUE(oldest->isEvicted());
+    EXPECT_FALSE(oldest->getDeviceTexture());
+    EXPECT_TRUE(older->lazyStatus().isReady());
+    EXPECT_TRUE(current->lazyStatus().isReady());
+    EXPECT_EQ(m_repository->residencyManager()->evictedCount(), 1u);
+    // 只有換了 device texture 的 texture epoch 會變, 其他 primitive 不用重新 bind
+    EXPECT_NE(oldest->deviceTextureEpoch(), oldest_epoch);
+    EXPECT_EQ(older->deviceTextureEpoch(), older_epoch);
+}
+
+TEST_F(TextureResidencyTest, RuntimeEditedTextureIsNotEvicted)
+{
+    auto edited = putResidentTexture("edited");
+    auto older = putResidentTexture("older");
+    auto current = putResidentTexture("current");
+    const std::uint64_t stamp = TextureResidencyManager::frameStamp();
+    edited->markUsed(stamp - 6);
+    older->markUsed(stamp - 5);
+    current->markUsed(stamp);
+    edited->markContentDirty();
+    m_repository->residencyManager()->budgetBytes(current->estimateResidentBytes() * 2);
+
+    m_repository->updateResidency();
+
+    EXPECT_FALSE(edited->isEvictable());
+    EXPECT_TRUE(edited->lazyStatus().isReady());
+    EXPECT_TRUE(edited->getDeviceTexture());
+    EXPECT_TRUE(older->lazyStatus().isGhost());
+    EXPECT_TRUE(current->lazyStatus().isReady());
+}
+
+TEST_F(TextureResidencyTest, RecentlyUsedTexturesStayOverBudget)
+{
+    auto first = putResidentTexture("first");
+    auto second = putResidentTexture("second");
+    const std::uint64_t stamp = TextureResidencyManager::frameStamp();
+    first->markUsed(stamp);
+    second->markUsed(stamp);
+    m_repository->residencyManager()->budgetBytes(first->estimateResidentBytes());
+
+    m_repository->updateResidency();
+
+    EXPECT_TRUE(first->lazyStatus().isReady());
+    EXPECT_TRUE(second->lazyStatus().isReady());
+    EXPECT_EQ(m_repository->residencyManager()->evictedCount(), 0u);
+}
@@ -0,0 +1,179 @@
+#include "Geometries/GeometryOptimizer.h"
+#include "Geometries/TriangleList.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /// 24 x 24 cells, 每個 triangle 用自己的三個 vertex (還沒 weld)
+    constexpr unsigned GRID_CELLS = 24;
+
+    using TriangleKey = std::array<std::tuple<float, float, float>, 3>;
+
+    /** 起伏的 grid, triangle 順序打亂; 每個 triangle 的 vertex 各自一份, normal 由 position 算, 重複的 vertex 完全相同 */
+    std::shared_ptr<TriangleList> makeShuffledGrid(unsigned seed)
+    {
+        std::vector<std::array<Vector3, 3>> triangles;
+        auto grid_pos = [](unsigned x, unsigned z) { return Vector3(static_cast<float>(x), 0.1f * static_cast<float>((x * 7 + z * 3) % 5), static_cast<float>(z)); };
+        for (unsigned z = 0; z < GRID_CELLS; z++)
+        {
+            for (unsigned x = 0; x < GRID_CELLS; x++)
+            {
+                triangles.push_back({ grid_pos(x, z), grid_pos(x, z + 1), grid_pos(x + 1, z) });
+                triangles.push_back({ grid_pos(x + 1, z), grid_pos(x, z + 1), grid_pos(x + 1, z + 1) });
+            }
+        }
+        std::mt19937 rng(seed);
+        std::shuffle(triangles.begin(), triangles.end(), rng);
+        std::vector<Vector3> positions;
+        std::vector<Vector3> normals;
+        std::vector<unsigned> indices;
+        for (const auto& tri : triangles)
+        {
+            for (const auto& pos : tri)
+            {
+                indices.push_back(static_cast<unsigned>(positions.size()));
+                positions.push_back(pos);
+                normals.emplace_back(Vector3(pos.y(), 1.0f, -pos.y()).normalize());
+            }
+        }
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("optimizer_test_grid"));
+        const unsigned vtx_count = static_cast<unsigned>(positions.size());
+        const unsigned idx_count = static_cast<unsigned>(indices.size());
+        tri_list->createVertexCapacity("xyz_nor", vtx_count, vtx_count, idx_count, idx_count);
+        tri_list->setPosition3Array(positions);
+        tri_list->setVertexNormalArray(normals);
+        tri_list->setIndexArray(indices);
+        return tri_list;
+    }
+
+    /** 一個 segment 的 triangle, 以 position 表示; 轉到最小的 vertex 開頭, 保留 winding */
+    std::vector<TriangleKey> segmentTriangles(const std::shared_ptr<TriangleList>& geometry, unsigned segment_index)
+    {
+        const GeometrySegment& segment = geometry->getSegment(segment_index);
+        const auto positions = geometry->getPosition3Array(geometry->getUsedVertexCount());
+        const auto& indices = geometry->getIndexMemory();
+        std::vector<TriangleKey> keys;
+        for (unsigned i = 0; i + 2 < segment.m_idxCount; i += 3)
+        {
+            TriangleKey key;
+            for (unsigned v = 0; v < 3; v++)
+            {
+                const Vector3& pos = positions[segment.m_startVtx + indices[segment.m_startIdx + i + v]];
+                key[v] = { pos.x(), pos.y(), pos.z() };
+            }
+            std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+            keys.push_back(key);
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    std::vector<TriangleKey> allTriangles(const std::shared_ptr<TriangleList>& geometry)
+    {
+        std::vector<TriangleKey> keys;
+        for (unsigned s = 0; s < geometry->getSegmentCount(); s++)
+        {
+            const auto segment_keys = segmentTriangles(geometry, s);
+            keys.insert(keys.end(), segment_keys.begin(), segment_keys.end());
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+}
+
+TEST(GeometryOptimizerTest, TriangleSetIsPreserved)
+{
+    auto geometry = makeShuffledGrid(3);
+    const auto before = allTriangles(geometry);
+    GeometryOptimizer::Report report;
+    ASSERT_FALSE(GeometryOptimizer::optimize(geometry, GeometryOptimizer::Options{}, report));
+
+    EXPECT_EQ(allTriangles(geometry), before);
+    // grid 的 vertex 都 weld 起來了
+    EXPECT_EQ(report.m_originalVertexCount, GRID_CELLS * GRID_CELLS * 6);
+    EXPECT_EQ(report.m_optimizedVertexCount, (GRID_CELLS + 1) * (GRID_CELLS + 1));
+    EXPECT_EQ(geometry->getUsedVertexCount(), (GRID_CELLS + 1) * (GRID_CELLS + 1));
+    for (unsigned index : geometry->getIndexMemory())
+    {
+        EXPECT_LT(index, geometry->getUsedVertexCount());
+    }
+}
+
+TEST(GeometryOptimizerTest, AcmrIsNotWorse)
+{
+    GeometryOptimizer::Options options;
+    for (bool is_overdraw : { false, true })
+    {
+        options.m_optimizeOverdraw = is_overdraw;
+        auto geometry = makeShuffledGrid(5);
+        GeometryOptimizer::Report report;
+        ASSERT_FALSE(GeometryOptimizer::optimize(geometry, options, report));
+        EXPECT_EQ(report.m_after.m_triangleCount, report.m_before.m_triangleCount);
+        EXPECT_LE(report.m_after.acmr(), report.m_before.acmr());
+        // 重新量一次, 跟 report 的一樣
+        const auto measured = GeometryOptimizer::analyzeVertexCache(geometry->getIndexMemory(), geometry->getUsedVertexCount(), options.m_statisticsCacheSize);
+        EXPECT_EQ(measured.m_cacheMissCount, report.m_after.m_cacheMissCount);
+    }
+    // welded 之後已經最佳化過的結果, 再做一次不會變差
+    auto geometry = makeShuffledGrid(5);
+    GeometryOptimizer::Report first;
+    ASSERT_FALSE(GeometryOptimizer::optimize(geometry, options, first));
+    GeometryOptimizer::Report second;
+    ASSERT_FALSE(GeometryOptimizer::optimize(geometry, options, second));
+    EXPECT_LE(second.m_after.acmr(), second.m_before.acmr() * options.m_overdrawThreshold);
+}
+
+TEST(GeometryOptimizerTest, OutputIsDeterministic)
+{
+    auto first = makeShuffledGrid(9);
+    auto second = makeShuffledGrid(9);
+    GeometryOptimizer::Report first_report;
+    GeometryOptimizer::Report second_report;
+    ASSERT_FALSE(GeometryOptimizer::optimize(first, GeometryOptimizer::Options{}, first_report));
+    ASSERT_FALSE(GeometryOptimizer::optimize(second, GeometryOptimizer::Options{}, second_report));
+
+    EXPECT_EQ(first->getUsedVertexCount(), second->getUsedVertexCount());
+    EXPECT_EQ(first->getUsedIndexCount(), second->getUsedIndexCount());
+    EXPECT_EQ(first->getVertexMemory(), second->getVertexMemory());
+    EXPECT_EQ(first->getIndexMemory(), second->getIndexMemory());
+    EXPECT_EQ(first_report.m_after.m_cacheMissCount, second_report.m_after.m_cacheMissCount);
+}
+
+TEST(GeometryOptimizerTest, OverlappingSegmentsOnlyReorderIndices)
+{
+    auto geometry = makeShuffledGrid(11);
+    const unsigned vtx_count = geometry->getUsedVertexCount();
+    const unsigned idx_count = geometry->getUsedIndexCount();
+    const unsigned half_idx_count = idx_count / 6 * 3;
+    // 兩個 segment 共用全部的 vertex
+    geometry->resizeSegmentVector(2);
+    geometry->changeSegment(0, 0, vtx_count, 0, half_idx_count);
+    geometry->changeSegment(1, 0, vtx_count, half_idx_count, idx_count - half_idx_count);
+    const auto vertex_memory = geometry->getVertexMemory();
+    const auto segment0 = segmentTriangles(geometry, 0);
+    const auto segment1 = segmentTriangles(geometry, 1);
+
+    GeometryOptimizer::Report report;
+    ASSERT_FALSE(GeometryOptimizer::optimize(geometry, GeometryOptimizer::Options{}, report));
+
+    EXPECT_EQ(geometry->getUsedVertexCount(), vtx_count);
+    EXPECT_EQ(geometry->getVertexMemory(), vertex_memory);
+    ASSERT_EQ(geometry->getSegmentCount(), 2u);
+    EXPECT_EQ(geometry->getSegment(0).m_startIdx, 0u);
+    EXPECT_EQ(geometry->getSegment(0).m_idxCount, half_idx_count);
+    EXPECT_EQ(geometry->getSegment(1).m_startIdx, half_idx_count);
+    EXPECT_EQ(geometry->getSegment(1).m_vtxCount, vtx_count);
+    // triangle 不會跨 segment 搬動
+    EXPECT_EQ(segmentTriangles(geometry, 0), segment0);
+    EXPECT_EQ(segmentTriangles(geometry, 1), segment1);
+    EXPECT_LE(report.m_after.acmr(), report.m_before.acmr());
+}
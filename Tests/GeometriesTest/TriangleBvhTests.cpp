@@ -0,0 +1,125 @@
+#include "Geometries/TriangleBvh.h"
+#include "Geometries/TriangleList.h"
+#include "MathLib/IntrRay3Triangle3.h"
+#include "MathLib/Ray3.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cfloat>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    /** 疊在 ray 前面的一堆小 triangle, 每三個 position 一個 */
+    std::vector<Vector3> makeTriangleSoup(unsigned tri_count, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> center(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> offset(-1.5f, 1.5f);
+        std::vector<Vector3> positions;
+        positions.reserve(static_cast<size_t>(tri_count) * 3);
+        for (unsigned i = 0; i < tri_count; i++)
+        {
+            const Vector3 c(center(rng), center(rng), center(rng));
+            for (unsigned v = 0; v < 3; v++) positions.emplace_back(c + Vector3(offset(rng), offset(rng), offset(rng)));
+        }
+        return positions;
+    }
+
+    std::optional<float> hitTriangle(const Ray3& ray, const std::vector<Vector3>& positions, unsigned tri_index)
+    {
+        IntrRay3Triangle3 intr(ray, &positions[static_cast<size_t>(tri_index) * 3]);
+        if (!intr.find(nullptr).m_hasIntersect) return std::nullopt;
+        return intr.getRayT();
+    }
+
+    std::shared_ptr<TriangleList> makeTriangleList(const std::vector<Vector3>& positions)
+    {
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("bvh_test_triangles"));
+        const unsigned vtx_count = static_cast<unsigned>(positions.size());
+        tri_list->createVertexCapacity("xyz", vtx_count, vtx_count, 0, 0);
+        tri_list->setPosition3Array(positions);
+        return tri_list;
+    }
+}
+
+TEST(TriangleBvhTest, FindNearestMatchesBruteForce)
+{
+    std::mt19937 rng(7);
+    const auto positions = makeTriangleSoup(2000, rng);
+    TriangleBvh bvh;
+    bvh.build(positions);
+
+    std::uniform_real_distribution<float> coord(-8.0f, 8.0f);
+    unsigned hit_ray_count = 0;
+    for (unsigned r = 0; r < 200; r++)
+    {
+        Vector3 dir(coord(rng), coord(rng), coord(rng));
+        dir.normalizeSelf();
+        const Ray3 ray(Vector3(coord(rng), coord(rng), -30.0f), dir.z() < 0.0f ? -dir : dir);
+
+        std::optional<float> nearest_t;
+        const unsigned tri_count = static_cast<unsigned>(positions.size() / 3);
+        for (unsigned i = 0; i < tri_count; i++)
+        {
+            const auto t = hitTriangle(ray, positions, i);
+            if ((t) && (t.value() >= 0.0f) && ((!nearest_t) || (t.value() < nearest_t.value()))) nearest_t = t;
+        }
+        const auto found = bvh.findNearest(ray, [&](unsigned tri_index) { return hitTriangle(ray, positions, tri_index); });
+        ASSERT_EQ(nearest_t.has_value(), found.has_value());
+        if (!found) continue;
+        hit_ray_count++;
+        EXPECT_FLOAT_EQ(nearest_t.value(), found->m_t);
+        EXPECT_FLOAT_EQ(found->m_t, hitTriangle(ray, positions, found->m_triangleIndex).value());
+    }
+    EXPECT_GT(hit_ray_count, 0u);
+}
+
+TEST(TriangleBvhTest, ConcurrentFirstAccessBuildsOneBvh)
+{
+    std::mt19937 rng(11);
+    auto tri_list = makeTriangleList(makeTriangleSoup(500, rng));
+
+    constexpr unsigned thread_count = 4;
+    std::vector<std::shared_ptr<const TriangleBvh>> snapshots(thread_count);
+    std::atomic<unsigned> ready{ 0 };
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < thread_count; i++)
+    {
+        threads.emplace_back([&, i]
+            {
+                ready++;
+                while (ready.load() < thread_count) std::this_thread::yield();
+                snapshots[i] = tri_list->triangleBvh();
+            });
+    }
+    for (auto& t : threads) t.join();
+    for (auto& snapshot : snapshots)
+    {
+        ASSERT_NE(snapshot, nullptr);
+        EXPECT_EQ(snapshot, snapshots[0]);
+    }
+    EXPECT_EQ(snapshots[0]->triangleCount(), 500u);
+}
+
+TEST(TriangleBvhTest, RefitDoesNotTouchHeldSnapshot)
+{
+    std::mt19937 rng(13);
+    auto positions = makeTriangleSoup(100, rng);
+    auto tri_list = makeTriangleList(positions);
+
+    const auto held = tri_list->triangleBvh();
+    const float held_max_x = held->nodes()[0].m_boxMax[0];
+    for (auto& pos : positions) pos = pos + Vector3(100.0f, 0.0f, 0.0f);
+    tri_list->setPosition3Array(positions);
+
+    const auto refitted = tri_list->triangleBvh();
+    EXPECT_NE(refitted, held);
+    EXPECT_FLOAT_EQ(held->nodes()[0].m_boxMax[0], held_max_x);
+    EXPECT_GT(refitted->nodes()[0].m_boxMax[0], held_max_x + 50.0f);
+}
@@ -0,0 +1,161 @@
+#include "Geometries/VertexAttributeCodec.h"
+#include "GraphicKernel/IIndexBuffer.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace Enigma::Geometries;
+
+namespace
+{
+    /// 2 x snorm16 的 octahedral 量化, 角度誤差在 0.01 度以內
+    constexpr float OCT_MAX_ANGLE = 0.01f * 3.14159265f / 180.0f;
+
+    std::vector<std::array<float, 3>> makeUnitVectors()
+    {
+        std::vector<std::array<float, 3>> vectors = {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, { 0.7071068f, 0.0f, -0.7071068f }, { 0.0f, -0.7071068f, -0.7071068f },
+        };
+        std::mt19937 rng(23);
+        std::normal_distribution<float> gaussian(0.0f, 1.0f);
+        for (unsigned i = 0; i < 20000; i++)
+        {
+            float x = gaussian(rng);
+            float y = gaussian(rng);
+            float z = gaussian(rng);
+            const float len = std::sqrt(x * x + y * y + z * z);
+            if (len < 1e-4f) continue;
+            vectors.push_back({ x / len, y / len, z / len });
+        }
+        return vectors;
+    }
+
+    float angleBetween(const float* a, const float* b)
+    {
+        // 小角度時 acos 的 float 誤差太大, 用 atan2(|a x b|, a . b)
+        const float cx = a[1] * b[2] - a[2] * b[1];
+        const float cy = a[2] * b[0] - a[0] * b[2];
+        const float cz = a[0] * b[1] - a[1] * b[0];
+        return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+    }
+
+    float halfRoundTrip(float value)
+    {
+        return VertexAttributeCodec::halfToFloat(VertexAttributeCodec::floatToHalf(value));
+    }
+}
+
+TEST(VertexAttributeCodecTest, OctahedralNormalStaysWithinAngleBound)
+{
+    float max_angle = 0.0f;
+    for (const auto& normal : makeUnitVectors())
+    {
+        float decoded[3];
+        VertexAttributeCodec::decodeOctahedral(VertexAttributeCodec::encodeOctahedral(normal.data()), decoded);
+        EXPECT_NEAR(std::sqrt(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]), 1.0f, 1e-5f);
+        max_angle = std::max(max_angle, angleBetween(normal.data(), decoded));
+    }
+    EXPECT_LT(max_angle, OCT_MAX_ANGLE);
+}
+
+TEST(VertexAttributeCodecTest, OctahedralTangentKeepsHandedness)
+{
+    float max_angle = 0.0f;
+    for (const auto& dir : makeUnitVectors())
+    {
+        for (float w : { 1.0f, -1.0f })
+        {
+            const float tangent[4] = { dir[0], dir[1], dir[2], w };
+            float decoded[4];
+            VertexAttributeCodec::decodeOctahedralTangent(VertexAttributeCodec::encodeOctahedralTangent(tangent), decoded);
+            EXPECT_EQ(decoded[3], w);
+            max_angle = std::max(max_angle, angleBetween(tangent, decoded));
+        }
+    }
+    // handedness 佔掉 y 的最低位, 誤差比 normal 大一點, 但一樣在 bound 內
+    EXPECT_LT(max_angle, OCT_MAX_ANGLE);
+}
+
+TEST(VertexAttributeCodecTest, HalfFloatEdgeValues)
+{
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(0.0f), 0x0000);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(-0.0f), 0x8000);
+    EXPECT_TRUE(std::signbit(halfRoundTrip(-0.0f)));
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(1.0f), 0x3c00);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(-2.0f), 0xc000);
+    // 最大的 half, 超過一半 ulp 之後變成 inf
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(65504.0f), 0x7bff);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(65519.0f), 0x7bff);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(65520.0f), 0x7c00);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(-1.0e6f), 0xfc00);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(std::numeric_limits<float>::infinity()), 0x7c00);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(-std::numeric_limits<float>::infinity()), 0xfc00);
+    EXPECT_TRUE(std::isnan(halfRoundTrip(std::numeric_limits<float>::quiet_NaN())));
+    // 最小的 normal 與 subnormal
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(std::ldexp(1.0f, -14)), 0x0400);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(std::ldexp(1.0f, -24)), 0x0001);
+    EXPECT_EQ(halfRoundTrip(std::ldexp(1.0f, -24)), std::ldexp(1.0f, -24));
+    // 半個最小 subnormal: tie 到偶數 0, 再大一點就進位
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(std::ldexp(1.0f, -25)), 0x0000);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(std::ldexp(1.0f, -25) * 1.01f), 0x0001);
+    // round to nearest even
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+    EXPECT_EQ(VertexAttributeCodec::floatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)), 0x3c02);
+}
+
+TEST(VertexAttributeCodecTest, EveryHalfRoundTrips)
+{
+    for (unsigned bits = 0; bits <= 0xffff; bits++)
+    {
+        const auto half = static_cast<std::uint16_t>(bits);
+        const float value = VertexAttributeCodec::halfToFloat(half);
+        if (std::isnan(value))
+        {
+            EXPECT_EQ(half & 0x7c00, 0x7c00);
+            continue;
+        }
+        EXPECT_EQ(VertexAttributeCodec::floatToHalf(value), half) << "half bits " << bits;
+    }
+}
+
+TEST(VertexAttributeCodecTest, Unorm16Quantization)
+{
+    const float min = -3.0f;
+    const float extent = 10.0f;
+    EXPECT_EQ(VertexAttributeCodec::quantizeUnorm16(min, min, extent), 0);
+    EXPECT_EQ(VertexAttributeCodec::quantizeUnorm16(min + extent, min, extent), 0xffff);
+    EXPECT_EQ(VertexAttributeCodec::quantizeUnorm16(min - 1.0f, min, extent), 0);
+    EXPECT_EQ(VertexAttributeCodec::quantizeUnorm16(min + extent + 1.0f, min, extent), 0xffff);
+    for (float value = min; value <= min + extent; value += 0.0137f)
+    {
+        const float decoded = VertexAttributeCodec::dequantizeUnorm16(VertexAttributeCodec::quantizeUnorm16(value, min, extent), min, extent);
+        EXPECT_NEAR(decoded, value, extent / 65535.0f * 0.5f + 1e-5f);
+    }
+}
+
+TEST(VertexAttributeCodecTest, Unorm16WithZeroExtent)
+{
+    // 所有 position 在同一個平面上時, 那一軸的 extent 是 0
+    EXPECT_EQ(VertexAttributeCodec::quantizeUnorm16(2.5f, 2.5f, 0.0f), 0);
+    EXPECT_EQ(VertexAttributeCodec::quantizeUnorm16(7.0f, 2.5f, 0.0f), 0);
+    EXPECT_EQ(VertexAttributeCodec::dequantizeUnorm16(0, 2.5f, 0.0f), 2.5f);
+    EXPECT_EQ(VertexAttributeCodec::dequantizeUnorm16(0xffff, 2.5f, 0.0f), 2.5f);
+    EXPECT_FALSE(std::isnan(VertexAttributeCodec::dequantizeUnorm16(VertexAttributeCodec::quantizeUnorm16(2.5f, 2.5f, 0.0f), 2.5f, 0.0f)));
+}
+
+TEST(VertexAttributeCodecTest, CanUseShortIndexAtBoundary)
+{
+    using Enigma::Graphics::IIndexBuffer;
+    EXPECT_FALSE(IIndexBuffer::canUseShortIndex(0));
+    EXPECT_TRUE(IIndexBuffer::canUseShortIndex(1));
+    // 0xffff 個 vertex, 最大 index 是 0xfffe, 不會碰到 primitive restart 的 0xffff
+    EXPECT_TRUE(IIndexBuffer::canUseShortIndex(0xfffe));
+    EXPECT_TRUE(IIndexBuffer::canUseShortIndex(0xffff));
+    EXPECT_FALSE(IIndexBuffer::canUseShortIndex(0x10000));
+}
@@ -0,0 +1,58 @@
+#include "Geometries/TriangleList.h"
+#include "Geometries/VertexAttributeView.h"
+#include "MathLib/Vector3.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    std::shared_ptr<TriangleList> makeTriangle()
+    {
+        auto tri_list = std::make_shared<TriangleList>(GeometryId("view_test_triangle"));
+        tri_list->createVertexCapacity("xyz_nor", 3, 3, 0, 0);
+        tri_list->setPosition3Array({ Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f) });
+        return tri_list;
+    }
+}
+
+TEST(VertexAttributeViewTest, ReadsAndWritesThroughStride)
+{
+    // 7 個 float 一個 vertex, position 在 offset 1 個 float, 不對齊 Vector3
+    std::vector<unsigned char> memory(3 * 7 * sizeof(float), 0);
+    VertexAttributeView<Vector3> view(memory.data() + sizeof(float), 7 * sizeof(float), 3);
+    view[1] = Vector3(1.0f, 2.0f, 3.0f);
+    view.set(2, Vector3(4.0f, 5.0f, 6.0f));
+
+    const VertexAttributeView<const Vector3> read_view = view;
+    EXPECT_EQ(read_view[1], Vector3(1.0f, 2.0f, 3.0f));
+    EXPECT_EQ(static_cast<Vector3>(view[2]), Vector3(4.0f, 5.0f, 6.0f));
+    std::vector<Vector3> copied(read_view.begin(), read_view.end());
+    ASSERT_EQ(copied.size(), 3u);
+    EXPECT_EQ(copied[0], Vector3(0.0f, 0.0f, 0.0f));
+    EXPECT_EQ(copied[2], Vector3(4.0f, 5.0f, 6.0f));
+}
+
+TEST(VertexAttributeViewTest, PositionRevisionBumpsOnWriteNotOnView)
+{
+    auto tri_list = makeTriangle();
+    const auto revision = tri_list->positionRevision();
+
+    auto positions = tri_list->mutablePositionView();
+    ASSERT_EQ(positions.size(), 3u);
+    const Vector3 first = positions[0];
+    EXPECT_EQ(first, Vector3(0.0f, 0.0f, 0.0f));
+    EXPECT_EQ(tri_list->positionRevision(), revision);
+
+    positions.subView(1, 2).set(0, Vector3(2.0f, 0.0f, 0.0f));
+    EXPECT_GT(tri_list->positionRevision(), revision);
+    EXPECT_EQ(tri_list->getPosition3(1), Vector3(2.0f, 0.0f, 0.0f));
+
+    const auto written = tri_list->positionRevision();
+    auto normals = tri_list->mutableNormalView();
+    normals[0] = Vector3(0.0f, 1.0f, 0.0f);
+    EXPECT_EQ(tri_list->positionRevision(), written);
+}
@@ -0,0 +1,71 @@
+#include "Platforms/PlatformLayer.h"
+#include "Platforms/AsyncLogSink.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Enigma::Platforms;
+
+namespace
+{
+    std::string logFilePath(const char* name)
+    {
+        return testing::TempDir() + name;
+    }
+
+    std::string readFile(const std::string& filepath)
+    {
+        std::ifstream file(filepath.c_str());
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+}
+
+TEST(AsyncLogSinkTest, LongMessageIsNotTruncatedToInlineLength)
+{
+    const std::string filepath = logFilePath("long_message.log");
+    const std::string message(AsyncLogSink::InlineMessageLength * 4, 'x');
+    {
+        AsyncLogSink sink(filepath);
+        ASSERT_TRUE(sink.push(Logger::Level::Warnning, message, nullptr, 0));
+        sink.flush();
+        EXPECT_EQ(sink.writtenCount(), 1u);
+    }
+    EXPECT_NE(readFile(filepath).find(message), std::string::npos);
+}
+
+TEST(AsyncLogSinkTest, ErrorIsWrittenAfterQueuedRecords)
+{
+    const std::string filepath = logFilePath("sync_error.log");
+    AsyncLogSink sink(filepath);
+    ASSERT_TRUE(sink.push(Logger::Level::Info, "queued", nullptr, 0));
+    sink.write(Logger::Level::Error, "error", __FILE__, __LINE__);
+    // 不用 flush, write 回來時檔案裡就有了
+    const std::string content = readFile(filepath);
+    const size_t queued = content.find("[Info] queued");
+    const size_t error = content.find("[Error] error");
+    ASSERT_NE(queued, std::string::npos);
+    ASSERT_NE(error, std::string::npos);
+    EXPECT_LT(queued, error);
+}
+
+TEST(AsyncLogSinkTest, FlushWaitsForAllProducers)
+{
+    const std::string filepath = logFilePath("producers.log");
+    AsyncLogSink sink(filepath);
+    std::vector<std::thread> producers;
+    for (unsigned t = 0; t < 4; t++)
+    {
+        producers.emplace_back([&sink]()
+            {
+                for (unsigned i = 0; i < 200; i++) sink.push(Logger::Level::Debug, "record", __FILE__, __LINE__);
+            });
+    }
+    for (auto& producer : producers) producer.join();
+    sink.flush();
+    EXPECT_EQ(sink.writtenCount() + sink.droppedCount(), 800u);
+}
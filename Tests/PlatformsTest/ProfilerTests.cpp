@@ -0,0 +1,118 @@
+#include "Platforms/Profiler.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(ENIGMA_PROFILER_ENABLED)
+
+using namespace Enigma::Platforms;
+
+namespace Enigma::PlatformsTest
+{
+    class SampleEvent
+    {
+    };
+}
+
+namespace
+{
+    std::string exportTrace()
+    {
+        std::ostringstream os;
+        Profiler::exportChromeTrace(os);
+        return os.str();
+    }
+
+    bool contains(const std::string& text, const std::string& pattern)
+    {
+        return text.find(pattern) != std::string::npos;
+    }
+}
+
+TEST(ProfilerTest, CaptureExportsZonesFramesAndThreads)
+{
+    {
+        PROFILE_ZONE("ProfilerTest::beforeCapture");
+    }
+    Profiler::beginCapture();
+    PROFILE_FRAME_MARK();
+    {
+        PROFILE_ZONE("ProfilerTest::main");
+    }
+    std::thread worker([]()
+        {
+            PROFILE_THREAD_NAME("ProfilerTestWorker");
+            PROFILE_ZONE("ProfilerTest::worker");
+        });
+    worker.join();
+    Profiler::endCapture();
+    {
+        PROFILE_ZONE("ProfilerTest::afterCapture");
+    }
+
+    EXPECT_EQ(Profiler::recordedCount(), 3u);
+    EXPECT_EQ(Profiler::droppedCount(), 0u);
+    const std::string trace = exportTrace();
+    EXPECT_EQ(trace.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_TRUE(contains(trace, "\"name\":\"ProfilerTest::main\",\"cat\":\"zone\",\"ph\":\"X\""));
+    EXPECT_TRUE(contains(trace, "\"name\":\"ProfilerTest::worker\""));
+    EXPECT_TRUE(contains(trace, "\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"i\""));
+    EXPECT_TRUE(contains(trace, "\"args\":{\"name\":\"ProfilerTestWorker\"}"));
+    EXPECT_FALSE(contains(trace, "beforeCapture"));
+    EXPECT_FALSE(contains(trace, "afterCapture"));
+    EXPECT_TRUE(contains(trace, "\"displayTimeUnit\":\"ms\"}"));
+}
+
+TEST(ProfilerTest, TypeZoneUsesReadableName)
+{
+    const char* name = Profiler::typeName(typeid(Enigma::PlatformsTest::SampleEvent));
+    EXPECT_STREQ(name, "Enigma::PlatformsTest::SampleEvent");
+    EXPECT_EQ(Profiler::typeName(typeid(Enigma::PlatformsTest::SampleEvent)), name);
+
+    Profiler::beginCapture();
+    {
+        PROFILE_ZONE(typeid(Enigma::PlatformsTest::SampleEvent));
+    }
+    Profiler::endCapture();
+    EXPECT_TRUE(contains(exportTrace(), "\"name\":\"Enigma::PlatformsTest::SampleEvent\""));
+}
+
+TEST(ProfilerTest, ZoneCountsAllocations)
+{
+    Profiler::beginCapture();
+    {
+        PROFILE_ZONE("ProfilerTest::allocate");
+        auto buffer = std::make_unique<char[]>(1000);
+        // 讓 pointer 逃出去, 配置不會被最佳化掉
+        char* volatile escaped = buffer.get();
+        (void)escaped;
+    }
+    Profiler::endCapture();
+    const std::string trace = exportTrace();
+    EXPECT_TRUE(contains(trace, "\"alloc_count\":1,\"alloc_bytes\":1000"));
+}
+
+TEST(ProfilerTest, NewCaptureDropsOldRecordsAndCountsOverflow)
+{
+    Profiler::beginCapture();
+    for (unsigned i = 0; i < Profiler::RecordCapacityPerThread + 10; i++)
+    {
+        PROFILE_ZONE("ProfilerTest::overflow");
+    }
+    Profiler::endCapture();
+    EXPECT_EQ(Profiler::recordedCount(), Profiler::RecordCapacityPerThread);
+    EXPECT_EQ(Profiler::droppedCount(), 10u);
+
+    Profiler::beginCapture();
+    {
+        PROFILE_ZONE("ProfilerTest::next");
+    }
+    Profiler::endCapture();
+    EXPECT_EQ(Profiler::recordedCount(), 1u);
+    EXPECT_EQ(Profiler::droppedCount(), 0u);
+    EXPECT_FALSE(contains(exportTrace(), "ProfilerTest::overflow"));
+}
+
+#endif // ENIGMA_PROFILER_ENABLED
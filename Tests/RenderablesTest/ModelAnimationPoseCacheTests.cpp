@@ -0,0 +1,104 @@
+#include "Renderables/ModelAnimationPoseCache.h"
+#include "Renderables/ModelAnimationAsset.h"
+#include "Renderables/AnimationTimeSRT.h"
+#include "MathLib/Vector3.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+using namespace Enigma::Renderables;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    constexpr float TIME_QUANTUM = 0.1f;
+
+    /** 一個 node, 0 ~ 1 秒從 x = 0 平移到 x = 10, pose 的 x 就是 sample 的時間 * 10 */
+    std::shared_ptr<ModelAnimationAsset> makeSlidingAsset(const std::string& name)
+    {
+        AnimationTimeSRT srt;
+        srt.setScaleKeyVector({ AnimationTimeSRT::ScaleKey(0.0f, 1.0f, 1.0f, 1.0f) });
+        srt.setRotationKeyVector({ AnimationTimeSRT::RotationKey(0.0f, Quaternion::IDENTITY) });
+        srt.setTranslateKeyVector({ AnimationTimeSRT::TranslateKey(0.0f, 0.0f, 0.0f, 0.0f), AnimationTimeSRT::TranslateKey(1.0f, 10.0f, 0.0f, 0.0f) });
+        auto asset = std::make_shared<ModelAnimationAsset>(Enigma::Animators::AnimationAssetId(name));
+        asset->addMeshNodeTimeSRTData("node", srt);
+        return asset;
+    }
+
+    float poseX(const ModelAnimationPoseCache::Pose& pose)
+    {
+        return pose[0].UnMatrixTranslate().x();
+    }
+}
+
+TEST(ModelAnimationPoseCacheTest, QueriesInSameQuantumHit)
+{
+    ModelAnimationPoseCache cache(TIME_QUANTUM);
+    const auto asset = makeSlidingAsset("sliding");
+    cache.beginFrame(1.0f);
+
+    const auto& first = cache.queryPose(asset, 0.31f);
+    const auto& second = cache.queryPose(asset, 0.29f);
+    EXPECT_EQ(&first, &second);
+    EXPECT_EQ(cache.missCount(), 1u);
+    EXPECT_EQ(cache.hitCount(), 1u);
+    // sample 的是量化後的時間 0.3
+    ASSERT_EQ(first.size(), 1u);
+    EXPECT_NEAR(poseX(first), 3.0f, 1e-4f);
+
+    cache.queryPose(asset, 0.36f);
+    EXPECT_EQ(cache.missCount(), 2u);
+    EXPECT_EQ(cache.cachedPoseCount(), 2u);
+    EXPECT_FLOAT_EQ(cache.hitRate(), 1.0f / 3.0f);
+
+    // 不同的 asset 不共用 pose
+    cache.queryPose(makeSlidingAsset("other"), 0.3f);
+    EXPECT_EQ(cache.missCount(), 3u);
+
+    cache.resetStatistics();
+    EXPECT_EQ(cache.hitCount(), 0u);
+    EXPECT_EQ(cache.missCount(), 0u);
+    EXPECT_EQ(cache.hitRate(), 0.0f);
+}
+
+TEST(ModelAnimationPoseCacheTest, FadeWeightIsQuantized)
+{
+    ModelAnimationPoseCache cache(TIME_QUANTUM);
+    const auto asset = makeSlidingAsset("sliding");
+    cache.beginFrame(1.0f);
+
+    // 0.5 跟 0.505 落在同一個 weight level (1/64), 0.6 不是
+    const auto& faded = cache.queryFadedPose(asset, 0.2f, 0.6f, 0.5f);
+    EXPECT_EQ(&cache.queryFadedPose(asset, 0.21f, 0.59f, 0.505f), &faded);
+    EXPECT_EQ(cache.hitCount(), 1u);
+    cache.queryFadedPose(asset, 0.2f, 0.6f, 0.6f);
+    EXPECT_EQ(cache.missCount(), 2u);
+    EXPECT_NEAR(poseX(faded), 0.5f * 2.0f + 0.5f * 6.0f, 1e-4f);
+
+    // 沒有 fade 的 pose 跟 weight 1 的 faded pose 是不同的 key
+    cache.queryPose(asset, 0.2f);
+    EXPECT_EQ(cache.missCount(), 3u);
+}
+
+TEST(ModelAnimationPoseCacheTest, NewFrameAndQuantumClearPoses)
+{
+    ModelAnimationPoseCache cache(TIME_QUANTUM);
+    const auto asset = makeSlidingAsset("sliding");
+    cache.beginFrame(1.0f);
+    cache.queryPose(asset, 0.3f);
+    cache.beginFrame(1.0f);
+    EXPECT_EQ(cache.cachedPoseCount(), 1u);
+    cache.beginFrame(2.0f);
+    EXPECT_EQ(cache.cachedPoseCount(), 0u);
+
+    cache.queryPose(asset, 0.3f);
+    cache.timeQuantum(TIME_QUANTUM);
+    EXPECT_EQ(cache.cachedPoseCount(), 1u);
+    cache.timeQuantum(0.25f);
+    EXPECT_EQ(cache.cachedPoseCount(), 0u);
+    // 0.3 量化到 0.25
+    EXPECT_NEAR(poseX(cache.queryPose(asset, 0.3f)), 2.5f, 1e-4f);
+
+    EXPECT_TRUE(cache.isEnabled());
+    cache.timeQuantum(0.0f);
+    EXPECT_FALSE(cache.isEnabled());
+}
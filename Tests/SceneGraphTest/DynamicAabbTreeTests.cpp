@@ -0,0 +1,225 @@
+#include "SceneGraph/DynamicAabbTree.h"
+#include "MathLib/Plane3.h"
+#include "MathLib/Ray3.h"
+#include "MathLib/Sphere3.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace Enigma::SceneGraph;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    const Enigma::Frameworks::Rtti& testPawnRtti()
+    {
+        static const Enigma::Frameworks::Rtti rtti{ "En.SceneGraphTest.TestPawn" };
+        return rtti;
+    }
+
+    DynamicAabbTree::Aabb makeBox(const Vector3& center, float half_size)
+    {
+        return { { center.x() - half_size, center.y() - half_size, center.z() - half_size },
+            { center.x() + half_size, center.y() + half_size, center.z() + half_size } };
+    }
+
+    Vector3 randomPoint(std::mt19937& rng, float extent)
+    {
+        std::uniform_real_distribution<float> coord(-extent, extent);
+        return Vector3(coord(rng), coord(rng), coord(rng));
+    }
+
+    template <class T> std::vector<DynamicAabbTree::ProxyId> sortedProxies(const std::vector<T>& results)
+    {
+        std::vector<DynamicAabbTree::ProxyId> proxies;
+        for (const auto& result : results)
+        {
+            if constexpr (std::is_same_v<T, DynamicAabbTree::Candidate>) proxies.push_back(result.m_proxy);
+            else proxies.push_back(result);
+        }
+        std::sort(proxies.begin(), proxies.end());
+        return proxies;
+    }
+
+    /** 跟 tree 一樣只比對 fat box, 逐一測所有 proxy */
+    class BruteForceIndex
+    {
+    public:
+        explicit BruteForceIndex(const DynamicAabbTree& tree) : m_tree(tree) {}
+
+        void add(DynamicAabbTree::ProxyId proxy) { m_proxies.push_back(proxy); }
+        void remove(DynamicAabbTree::ProxyId proxy) { m_proxies.erase(std::find(m_proxies.begin(), m_proxies.end(), proxy)); }
+        const std::vector<DynamicAabbTree::ProxyId>& proxies() const { return m_proxies; }
+
+        std::vector<DynamicAabbTree::ProxyId> queryRay(const Ray3& ray, float max_distance) const
+        {
+            return select([&](const DynamicAabbTree::Aabb& box) { return box.rayEnter(ray, max_distance).has_value(); });
+        }
+        std::vector<DynamicAabbTree::ProxyId> querySphere(const Sphere3& sphere) const
+        {
+            return select([&](const DynamicAabbTree::Aabb& box) { return box.squaredDistanceTo(sphere.Center()) <= sphere.Radius() * sphere.Radius(); });
+        }
+        std::vector<DynamicAabbTree::ProxyId> queryBox(const DynamicAabbTree::Aabb& query) const
+        {
+            return select([&](const DynamicAabbTree::Aabb& box) { return box.overlaps(query); });
+        }
+        std::vector<DynamicAabbTree::ProxyId> queryPlanes(const std::vector<Plane3>& planes) const
+        {
+            return select([&](const DynamicAabbTree::Aabb& box)
+                {
+                    for (const auto& plane : planes)
+                    {
+                        float max_distance = -plane.Constant();
+                        for (int axis = 0; axis < 3; axis++)
+                        {
+                            max_distance += std::max(plane.Normal()[axis] * box.m_min[axis], plane.Normal()[axis] * box.m_max[axis]);
+                        }
+                        if (max_distance < 0.0f) return false;
+                    }
+                    return true;
+                });
+        }
+
+    private:
+        template <class Pred> std::vector<DynamicAabbTree::ProxyId> select(Pred pred) const
+        {
+            std::vector<DynamicAabbTree::ProxyId> selected;
+            for (const auto proxy : m_proxies)
+            {
+                if (pred(m_tree.fatBox(proxy))) selected.push_back(proxy);
+            }
+            std::sort(selected.begin(), selected.end());
+            return selected;
+        }
+
+        const DynamicAabbTree& m_tree;
+        std::vector<DynamicAabbTree::ProxyId> m_proxies;
+    };
+
+    void expectQueriesMatchBruteForce(const DynamicAabbTree& tree, const BruteForceIndex& brute_force, std::mt19937& rng)
+    {
+        for (unsigned i = 0; i < 8; i++)
+        {
+            Vector3 dir = randomPoint(rng, 1.0f);
+            dir.normalizeSelf();
+            const Ray3 ray(randomPoint(rng, 120.0f), dir);
+            EXPECT_EQ(sortedProxies(tree.queryRay(ray, 200.0f)), brute_force.queryRay(ray, 200.0f));
+
+            const Sphere3 sphere(randomPoint(rng, 100.0f), 15.0f);
+            EXPECT_EQ(sortedProxies(tree.querySphere(sphere)), brute_force.querySphere(sphere));
+
+            const auto box = makeBox(randomPoint(rng, 100.0f), 12.0f);
+            EXPECT_EQ(sortedProxies(tree.queryBox(box)), brute_force.queryBox(box));
+
+            std::vector<Plane3> planes;
+            for (unsigned p = 0; p < 4; p++)
+            {
+                Vector3 normal = randomPoint(rng, 1.0f);
+                normal.normalizeSelf();
+                planes.emplace_back(normal, randomPoint(rng, 60.0f));
+            }
+            EXPECT_EQ(sortedProxies(tree.queryPlanes(planes)), brute_force.queryPlanes(planes));
+        }
+    }
+}
+
+TEST(DynamicAabbTreeTest, RandomEditsMatchBruteForceQueries)
+{
+    std::mt19937 rng(38);
+    std::uniform_int_distribution<int> operation(0, 9);
+    std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+    DynamicAabbTree tree(0.5f);
+    BruteForceIndex brute_force(tree);
+    std::unordered_map<DynamicAabbTree::ProxyId, Vector3> centers;
+    for (unsigned i = 0; i < 3000; i++)
+    {
+        const Vector3 center = randomPoint(rng, 100.0f);
+        const auto proxy = tree.createProxy(makeBox(center, 1.0f), SpatialId("pawn_" + std::to_string(i), testPawnRtti()));
+        centers[proxy] = center;
+        brute_force.add(proxy);
+    }
+    unsigned name_serial = 3000;
+    for (unsigned i = 0; i < 20000; i++)
+    {
+        const int op = operation(rng);
+        const auto& proxies = brute_force.proxies();
+        const auto proxy = proxies[std::uniform_int_distribution<size_t>(0, proxies.size() - 1)(rng)];
+        if (op == 0)
+        {
+            tree.destroyProxy(proxy);
+            brute_force.remove(proxy);
+            centers.erase(proxy);
+        }
+        else if (op == 1)
+        {
+            const Vector3 center = randomPoint(rng, 100.0f);
+            const auto created = tree.createProxy(makeBox(center, 1.0f), SpatialId("pawn_" + std::to_string(name_serial++), testPawnRtti()));
+            centers[created] = center;
+            brute_force.add(created);
+        }
+        else
+        {
+            Vector3& center = centers[proxy];
+            center = center + Vector3(step(rng), step(rng), step(rng));
+            const auto box = makeBox(center, 1.0f);
+            tree.moveProxy(proxy, box);
+            ASSERT_TRUE(tree.fatBox(proxy).contains(box));
+        }
+        if (i % 2000 == 1999) expectQueriesMatchBruteForce(tree, brute_force, rng);
+    }
+    EXPECT_EQ(tree.proxyCount(), brute_force.proxies().size());
+    // 3000 個上下的 proxy, 平衡的樹高約 2 * log2(n)
+    EXPECT_LE(tree.height(), 24);
+    for (const auto proxy : brute_force.proxies())
+    {
+        EXPECT_EQ(tree.spatialId(proxy).rtti().getName(), testPawnRtti().getName());
+    }
+}
+
+TEST(DynamicAabbTreeTest, SmallMoveStaysInFatBox)
+{
+    DynamicAabbTree tree(0.5f);
+    const auto proxy = tree.createProxy(makeBox(Vector3(0.0f, 0.0f, 0.0f), 1.0f), SpatialId("pawn", testPawnRtti()));
+    EXPECT_FALSE(tree.moveProxy(proxy, makeBox(Vector3(0.3f, 0.0f, -0.3f), 1.0f)));
+    EXPECT_TRUE(tree.moveProxy(proxy, makeBox(Vector3(5.0f, 0.0f, 0.0f), 1.0f)));
+    EXPECT_TRUE(tree.fatBox(proxy).contains(makeBox(Vector3(5.0f, 0.0f, 0.0f), 1.0f)));
+    EXPECT_FALSE(tree.fatBox(proxy).overlaps(makeBox(Vector3(0.0f, 0.0f, 0.0f), 1.0f)));
+}
+
+TEST(DynamicAabbTreeTest, RayAndSphereCandidatesAreSortedByDistance)
+{
+    DynamicAabbTree tree(0.0f);
+    for (unsigned i = 0; i < 10; i++)
+    {
+        tree.createProxy(makeBox(Vector3(10.0f * static_cast<float>(9 - i), 0.0f, 0.0f), 1.0f), SpatialId("pawn_" + std::to_string(i), testPawnRtti()));
+    }
+    const auto ray_candidates = tree.queryRay(Ray3(Vector3(-5.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f)), 1000.0f);
+    ASSERT_EQ(ray_candidates.size(), 10u);
+    EXPECT_FLOAT_EQ(ray_candidates.front().m_distance, 4.0f);
+    EXPECT_EQ(tree.spatialId(ray_candidates.front().m_proxy).name(), "pawn_9");
+    EXPECT_TRUE(std::is_sorted(ray_candidates.begin(), ray_candidates.end(), [](const auto& a, const auto& b) { return a.m_distance < b.m_distance; }));
+
+    const auto sphere_candidates = tree.querySphere(Sphere3(Vector3(45.0f, 0.0f, 0.0f), 20.0f));
+    ASSERT_EQ(sphere_candidates.size(), 4u);
+    EXPECT_TRUE(std::is_sorted(sphere_candidates.begin(), sphere_candidates.end(), [](const auto& a, const auto& b) { return a.m_distance < b.m_distance; }));
+    EXPECT_FLOAT_EQ(sphere_candidates.front().m_distance, 4.0f);
+}
+
+TEST(DynamicAabbTreeTest, DestroyedProxiesLeaveNoCandidates)
+{
+    DynamicAabbTree tree(0.1f);
+    std::vector<DynamicAabbTree::ProxyId> proxies;
+    for (unsigned i = 0; i < 64; i++)
+    {
+        proxies.push_back(tree.createProxy(makeBox(Vector3(static_cast<float>(i), 0.0f, 0.0f), 0.4f), SpatialId("pawn_" + std::to_string(i), testPawnRtti())));
+    }
+    for (const auto proxy : proxies) tree.destroyProxy(proxy);
+    EXPECT_EQ(tree.proxyCount(), 0u);
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_TRUE(tree.queryBox(makeBox(Vector3(32.0f, 0.0f, 0.0f), 100.0f)).empty());
+}
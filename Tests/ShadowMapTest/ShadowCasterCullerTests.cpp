@@ -0,0 +1,202 @@
+#include "ShadowMap/ShadowCasterCuller.h"
+#include "ShadowMap/CSMSunLightCamera.h"
+#include "ShadowMap/SpatialShadowFlags.h"
+#include "SceneGraph/Camera.h"
+#include "SceneGraph/Culler.h"
+#include "SceneGraph/Frustum.h"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Pawn.h"
+#include "SceneGraph/SceneGraphQueries.h"
+#include "Primitives/Primitive.h"
+#include "MathLib/MathGlobal.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/Sphere3.h"
+#include "Frameworks/CommandBus.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/ServiceManager.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+using namespace Enigma::Frameworks;
+using namespace Enigma::ShadowMap;
+using namespace Enigma::SceneGraph;
+using namespace Enigma::Primitives;
+using namespace Enigma::MathLib;
+
+namespace
+{
+    constexpr unsigned CASCADE_COUNT = 3;
+    constexpr float CASTER_RADIUS = 1.0f;
+
+    /** 只有 bound 的 primitive, 讓 pawn 是 renderable */
+    class BoundOnlyPrimitive : public Primitive
+    {
+    public:
+        BoundOnlyPrimitive(const std::string& name) : Primitive(PrimitiveId(name, Primitive::TYPE_RTTI))
+        {
+            m_bound = Enigma::Engine::BoundingVolume{ Sphere3(Vector3::ZERO, CASTER_RADIUS) };
+        }
+        virtual Enigma::Engine::GenericDto serializeDto() const override { return Enigma::Engine::GenericDto{}; }
+        virtual error insertToRendererWithTransformUpdating(const std::shared_ptr<Enigma::Engine::IRenderer>&,
+            const Matrix4&, const Enigma::Engine::RenderLightingState&) override { return error{}; }
+        virtual error removeFromRenderer(const std::shared_ptr<Enigma::Engine::IRenderer>&) override { return error{}; }
+        virtual void calculateBoundingVolume(bool) override {}
+        virtual void updateWorldTransform(const Matrix4& mxWorld) override { m_mxPrimitiveWorld = mxWorld; }
+    };
+
+    /** viewer 在 (0,2,0) 看 +z, near 1 far 100; 太陽從 viewer 後上方照過來 (0,-1,1)
+     *  light frame 是 right (1,0,0), up (0,.707,.707), dir (0,-.707,.707), 三個 cascade 在 light frame 下大約是
+     *  cascade 0 : up [-3.5, 20.7], dir <= 17.7
+     *  cascade 1 : up [ 2.1, 45.7], dir <= 42.7
+     *  cascade 2 : up [ 3.4,101.4], dir <= 98.4 */
+    class ShadowCasterCullerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            // spatial 找 parent 是用 QuerySpatial, 這裡沒有 repository, 直接查測試場景
+            m_publisher = std::make_shared<EventPublisher>(&m_manager);
+            m_commandBus = std::make_shared<CommandBus>(&m_manager);
+            m_dispatcher = std::make_shared<QueryDispatcher>(&m_manager);
+            m_querySpatial = std::make_shared<QuerySubscriber>([this](const IQueryPtr& q)
+                {
+                    const auto query = std::dynamic_pointer_cast<QuerySpatial>(q);
+                    const auto it = m_spatials.find(query->id());
+                    if (it != m_spatials.end()) query->setResult(it->second);
+                });
+            QueryDispatcher::subscribe(typeid(QuerySpatial), m_querySpatial);
+            m_viewer = std::make_shared<Camera>(SpatialId("viewer", Camera::TYPE_RTTI), GraphicCoordSys::LeftHand);
+            m_viewer->changeCameraFrame(Vector3(0.0f, 2.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+            m_viewer->cullingFrustum(Frustum::fromPerspective(GraphicCoordSys::LeftHand, Math::PI / 4.0f, 1.0f, 1.0f, 100.0f));
+            m_sun = std::make_unique<CSMSunLightCamera>(SpatialId("sun", CSMSunLightCamera::TYPE_RTTI), CASCADE_COUNT);
+            m_sun->setSunLightDir(Vector3(0.0f, -1.0f, 1.0f));
+            m_sun->setViewerCamera(m_viewer);
+            Culler culler(m_viewer);
+            m_sun->calcLightCameraSystemMatrix(&culler);
+            m_root = std::make_shared<Node>(SpatialId("root", Node::TYPE_RTTI));
+            m_spatials.emplace(m_root->id(), m_root);
+        }
+
+        void TearDown() override
+        {
+            m_spatials.clear();
+            m_root = nullptr;
+            QueryDispatcher::unsubscribe(typeid(QuerySpatial), m_querySpatial);
+        }
+
+        std::shared_ptr<Pawn> addPawn(const std::string& name, const Vector3& position, bool is_caster = true)
+        {
+            auto pawn = std::make_shared<Pawn>(SpatialId(name, Pawn::TYPE_RTTI));
+            m_spatials.emplace(pawn->id(), pawn);
+            m_root->attachChild(pawn, Matrix4::MakeTranslateTransform(position));
+            pawn->SetPrimitive(std::make_shared<BoundOnlyPrimitive>(name));
+            if (is_caster) pawn->addSpatialFlag(SpatialShadowFlags::SpatialBit::Spatial_ShadowCaster);
+            return pawn;
+        }
+
+        bool isInCascade(const ShadowCasterCuller& culler, unsigned cascade, const std::shared_ptr<Pawn>& pawn) const
+        {
+            const auto& casters = culler.cascadeCasters(cascade);
+            return std::find(casters.begin(), casters.end(), pawn) != casters.end();
+        }
+
+        ServiceManager m_manager;
+        std::shared_ptr<EventPublisher> m_publisher;
+        std::shared_ptr<CommandBus> m_commandBus;
+        std::shared_ptr<QueryDispatcher> m_dispatcher;
+        QuerySubscriberPtr m_querySpatial;
+        std::unordered_map<SpatialId, std::shared_ptr<Spatial>, SpatialId::hash> m_spatials;
+        std::shared_ptr<Camera> m_viewer;
+        std::unique_ptr<CSMSunLightCamera> m_sun;
+        std::shared_ptr<Node> m_root;
+    };
+}
+
+TEST_F(ShadowCasterCullerTest, CastersAreAssignedToCascadesByDistance)
+{
+    const auto near_caster = addPawn("near", Vector3(0.0f, 0.0f, 1.0f));
+    const auto mid_caster = addPawn("mid", Vector3(0.0f, 0.0f, 32.0f));
+    const auto far_caster = addPawn("far", Vector3(0.0f, 0.0f, 80.0f));
+
+    ShadowCasterCuller culler;
+    culler.cullCasters(m_root, *m_sun);
+
+    ASSERT_EQ(culler.cascadeCount(), CASCADE_COUNT);
+    EXPECT_EQ(culler.cascadeCasterCount(0), 1u);
+    EXPECT_EQ(culler.cascadeCasterCount(1), 1u);
+    EXPECT_EQ(culler.cascadeCasterCount(2), 2u);
+    EXPECT_EQ(culler.cascadeCasterCount(CASCADE_COUNT), 0u);
+    EXPECT_TRUE(isInCascade(culler, 0, near_caster));
+    EXPECT_TRUE(isInCascade(culler, 1, mid_caster));
+    // 遠的 cascade 範圍把中間的也包進去了
+    EXPECT_TRUE(isInCascade(culler, 2, mid_caster));
+    EXPECT_TRUE(isInCascade(culler, 2, far_caster));
+    for (unsigned cascade = 0; cascade < CASCADE_COUNT; cascade++)
+    {
+        EXPECT_FALSE(culler.cascadeCasterBounds()[cascade].isEmpty());
+    }
+}
+
+TEST_F(ShadowCasterCullerTest, CasterBehindCameraInLightPathIsKept)
+{
+    // 在 viewer 後上方, 沿光的方向投影下來落在 cascade 0 的範圍
+    const auto behind_in_path = addPawn("behind_in_path", Vector3(0.0f, 30.0f, -29.0f));
+    // 一樣在 viewer 後面, 但影子落在 viewer 後方
+    addPawn("behind_on_ground", Vector3(0.0f, 0.0f, -29.0f));
+
+    ShadowCasterCuller culler;
+    culler.cullCasters(m_root, *m_sun);
+
+    EXPECT_EQ(culler.casterCount(), 2u);
+    EXPECT_EQ(culler.cascadeCasterCount(0), 1u);
+    EXPECT_EQ(culler.cascadeCasterCount(1), 0u);
+    EXPECT_EQ(culler.cascadeCasterCount(2), 0u);
+    EXPECT_TRUE(isInCascade(culler, 0, behind_in_path));
+}
+
+TEST_F(ShadowCasterCullerTest, CastersOutsideLightBoxesAreRejected)
+{
+    // 沿光的方向在 cascade 0 的 receiver 之後
+    addPawn("beyond_far", Vector3(0.0f, -60.0f, 61.0f));
+    addPawn("aside", Vector3(200.0f, 0.0f, 32.0f));
+    addPawn("not_caster", Vector3(0.0f, 0.0f, 1.0f), false);
+    const auto hidden = addPawn("hidden", Vector3(0.0f, 0.0f, 1.0f));
+    hidden->addSpatialFlag(Spatial::Spatial_Hide);
+
+    ShadowCasterCuller culler;
+    culler.cullCasters(m_root, *m_sun);
+
+    for (unsigned cascade = 0; cascade < CASCADE_COUNT; cascade++)
+    {
+        EXPECT_EQ(culler.cascadeCasterCount(cascade), 0u);
+        EXPECT_TRUE(culler.cascadeCasterBounds()[cascade].isEmpty());
+    }
+}
+
+TEST_F(ShadowCasterCullerTest, MovedCasterChangesCascade)
+{
+    addPawn("near", Vector3(0.0f, 0.0f, 1.0f));
+    const auto far_caster = addPawn("far", Vector3(0.0f, 0.0f, 80.0f));
+
+    ShadowCasterCuller culler;
+    culler.cullCasters(m_root, *m_sun);
+    EXPECT_EQ(culler.refreshedCasterCount(), 2u);
+    EXPECT_EQ(culler.cascadeCasterCount(0), 1u);
+    EXPECT_EQ(culler.cascadeCasterCount(2), 1u);
+
+    // extent 有 cache, 沒動的話不重算
+    culler.cullCasters(m_root, *m_sun);
+    EXPECT_EQ(culler.refreshedCasterCount(), 0u);
+
+    far_caster->setLocalTransform(Matrix4::MakeTranslateTransform(Vector3(0.0f, 0.0f, 2.0f)));
+    culler.invalidateCasterLocation(far_caster->id());
+    culler.cullCasters(m_root, *m_sun);
+    EXPECT_EQ(culler.refreshedCasterCount(), 1u);
+    EXPECT_EQ(culler.cascadeCasterCount(0), 2u);
+    EXPECT_EQ(culler.cascadeCasterCount(2), 0u);
+    EXPECT_TRUE(isInCascade(culler, 0, far_caster));
+}
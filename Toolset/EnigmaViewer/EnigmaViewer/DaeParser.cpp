@@ -11,6 +11,7 @@
 #include "ShadowMap/SpatialShadowFlags.h"
 #include "Geometries/TriangleList.h"
 #include "Geometries/GeometryDataStoreMapper.h"
+#include "Geometries/GeometryOptimizer.h"
 #include "Renderables/ModelPrimitiveAnimator.h"
 #include "Renderables/ModelAnimationAssembler.h"
 #include "Renderables/ModelAnimatorAssembler.h"
@@ -1098,6 +1099,23 @@ void DaeParser::collapseIndexArray(int pos_offset, bool is_split_vertex)
     }*/
 }
 
+void DaeParser::optimizeGeometry(const GeometryId& geo_id, TriangleListDto& geo_dto)
+{
+    auto geometry = std::make_shared<TriangleList>(geo_id, geo_dto.toGenericDto());
+    GeometryOptimizer::Report report;
+    if (auto er = GeometryOptimizer::optimize(geometry, GeometryOptimizer::Options{}, report))
+    {
+        outputLog(geo_id.name() + " optimize fail : " + er.message());
+        return;
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s optimized : vertex %u -> %u, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", geo_id.name().c_str(),
+        report.m_originalVertexCount, report.m_optimizedVertexCount,
+        report.m_before.acmr(), report.m_after.acmr(), report.m_before.atvr(), report.m_after.atvr());
+    outputLog(buf);
+    geo_dto = TriangleListDto::fromGenericDto(geometry->serializeDto());
+}
+
 void DaeParser::persistSingleGeometry(const GeometryId& geo_id, bool is_skin)
 {
     TriangleListDto geo_dto;
@@ -1125,6 +1143,7 @@ void DaeParser::persistSingleGeometry(const GeometryId& geo_id, bool is_skin)
     TextureCoordDto tex_dto;
     tex_dto.texture2DCoords() = m_splitedTexCoord[0];
     geo_dto.textureCoords().emplace_back(tex_dto.toGenericDto());
+    optimizeGeometry(geo_id, geo_dto);
     Box3 box = ContainmentBox3::ComputeAlignedBox(&m_splitedPositions[0], static_cast<unsigned>(m_splitedPositions.size()));
     BoundingVolume bounding = BoundingVolume{ box };
     geo_dto.geometryBound() = bounding.serializeDto().toGenericDto();
@@ -81,6 +81,8 @@ namespace EnigmaViewer
         void clearParsedData();
 
         void persistSingleGeometry(const Enigma::Geometries::GeometryId& geo_id, bool is_skin);
+        /** vertex cache / overdraw / fetch order 最佳化, 結果寫回 dto */
+        void optimizeGeometry(const Enigma::Geometries::GeometryId& geo_id, Enigma::Geometries::TriangleListDto& geo_dto);
         void persistMesh(const Enigma::Primitives::PrimitiveId& mesh_id, const Enigma::Geometries::GeometryId& geo_id, const Enigma::Engine::EffectMaterialId& effect_id, const std::optional<Enigma::Engine::TextureId>& texture_id, const std::optional<std::string>& tex_semantic);
         void persistSkinMesh(const Enigma::Primitives::PrimitiveId& mesh_id, const Enigma::Geometries::GeometryId& geo_id, const Enigma::Engine::EffectMaterialId& effect_id, const std::optional<Enigma::Engine::TextureId>& texture_id, const std::optional<std::string>& tex_semantic);
         void persistAnimator();